@@ -0,0 +1,39 @@
+#pragma once
+
+#include "VR.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Byte order conversion for element values (SSE2 on x86/x64, scalar elsewhere)
+		class ByteSwap
+		{
+		public:
+			/// Reverse the bytes of count 16/32/64-bit values in place
+			static void Swap16(uint8_t* data, size_t count);
+			static void Swap32(uint8_t* data, size_t count);
+			static void Swap64(uint8_t* data, size_t count);
+
+			/// Copy count values from source to destination with reversed byte order
+			/// (destination may equal source, but must not partially overlap it)
+			static void Copy16(uint8_t* destination, const uint8_t* source, size_t count);
+			static void Copy32(uint8_t* destination, const uint8_t* source, size_t count);
+			static void Copy64(uint8_t* destination, const uint8_t* source, size_t count);
+
+			/// Size of the unit that changes with byte order for a VR
+			/// (2 for US/SS/OW/AT, 4 for UL/SL/FL/OF/OL, 8 for FD/OD/SV/UV; 0 = byte data)
+			static size_t GetSwapUnit(VR vr);
+
+			/// Swap a value of the given VR in place; trailing partial units are left alone
+			static void SwapValue(VR vr, uint8_t* data, size_t length);
+
+			/// Copy a value of the given VR with swapped byte order
+			static void CopySwappedValue(VR vr, uint8_t* destination, const uint8_t* source, size_t length);
+		};
+
+	} // namespace dicom
+} // namespace medvision
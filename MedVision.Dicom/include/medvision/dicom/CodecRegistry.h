@@ -0,0 +1,135 @@
+#pragma once
+
+#include "TransferSyntax.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Capability flags reported by codecs
+		enum CodecCapability : uint32_t
+		{
+			CodecLossless = 0x01,             // Bit-exact round trip
+			CodecLossy = 0x02,                // May discard information
+			CodecMultiFrameParallel = 0x04,   // Frames may be decoded concurrently
+			CodecPartialDecode = 0x08         // Can decode a reduced resolution or region
+		};
+
+		/// Layout of one uncompressed frame
+		struct FrameInfo
+		{
+			uint16_t rows;
+			uint16_t columns;
+			uint16_t samplesPerPixel;
+			uint16_t bitsAllocated;
+			uint16_t bitsStored;
+			uint16_t pixelRepresentation;
+			uint16_t planarConfiguration;
+			std::string photometricInterpretation;
+
+			FrameInfo();
+
+			/// Bytes of one decoded frame
+			size_t GetFrameLength() const;
+
+			/// Layout at 1/2^reduction of the full size (dimensions rounded up)
+			FrameInfo Reduce(uint32_t reduction) const;
+		};
+
+		/// Decompresses frames of one (or more) transfer syntaxes
+		///
+		/// Decoders are shared and must be stateless (DecodeFrame may run on
+		/// several threads). Output is always little endian, with samples
+		/// interleaved per pixel (planar configuration 0).
+		class PixelDecoder
+		{
+		public:
+			virtual ~PixelDecoder() {}
+
+			virtual const char* GetName() const = 0;
+
+			/// Combination of CodecCapability flags
+			virtual uint32_t GetCapabilities() const = 0;
+
+			/// Decode one compressed frame into output (info.GetFrameLength() bytes)
+			virtual bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const = 0;
+
+			/// Decode at 1/2^reduction of the full size into output
+			/// (info.Reduce(reduction).GetFrameLength() bytes). Reductions above 0
+			/// need CodecPartialDecode.
+			virtual bool DecodeFrameReduced(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint32_t reduction, uint8_t* output, std::string& error) const
+			{
+				if (reduction != 0)
+				{
+					error = std::string(GetName()) + " cannot decode at reduced resolution";
+					return false;
+				}
+				return DecodeFrame(data, length, info, output, error);
+			}
+
+			/// Photometric interpretation of the decoded samples; differs from the
+			/// stored one when the codec converts color (e.g. YBR_FULL_422 to RGB)
+			virtual std::string GetDecodedPhotometricInterpretation(const FrameInfo& info) const
+			{
+				return info.photometricInterpretation;
+			}
+		};
+
+		/// Compresses frames into one transfer syntax (same threading rules as PixelDecoder)
+		class PixelEncoder
+		{
+		public:
+			virtual ~PixelEncoder() {}
+
+			virtual const char* GetName() const = 0;
+
+			/// Combination of CodecCapability flags
+			virtual uint32_t GetCapabilities() const = 0;
+
+			/// Encode one frame (info.GetFrameLength() bytes, layout as produced by decoders)
+			virtual bool EncodeFrame(const uint8_t* pixels, const FrameInfo& info,
+				std::vector<uint8_t>& output, std::string& error) const = 0;
+		};
+
+		/// Process-wide table of pixel codecs keyed by interned transfer syntax
+		class CodecRegistry
+		{
+		public:
+			/// The shared registry
+			static CodecRegistry& Instance();
+
+			/// Register (or replace) the codec for a transfer syntax UID
+			void RegisterDecoder(const std::string& transferSyntaxUID, std::shared_ptr<const PixelDecoder> decoder);
+			void RegisterEncoder(const std::string& transferSyntaxUID, std::shared_ptr<const PixelEncoder> encoder);
+
+			/// Codec for a transfer syntax, or null if none is registered
+			std::shared_ptr<const PixelDecoder> FindDecoder(TransferSyntaxId id) const;
+			std::shared_ptr<const PixelDecoder> FindDecoder(const std::string& transferSyntaxUID) const;
+			std::shared_ptr<const PixelEncoder> FindEncoder(TransferSyntaxId id) const;
+			std::shared_ptr<const PixelEncoder> FindEncoder(const std::string& transferSyntaxUID) const;
+
+			bool CanDecode(TransferSyntaxId id) const { return FindDecoder(id) != nullptr; }
+			bool CanEncode(TransferSyntaxId id) const { return FindEncoder(id) != nullptr; }
+
+		private:
+			CodecRegistry();
+			CodecRegistry(const CodecRegistry&) = delete;
+			CodecRegistry& operator=(const CodecRegistry&) = delete;
+
+		private:
+			mutable std::mutex mutex_;
+			std::vector<std::shared_ptr<const PixelDecoder>> decoders_;   // Indexed by TransferSyntaxId
+			std::vector<std::shared_ptr<const PixelEncoder>> encoders_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Conversion of 8-bit color pixel data to packed RGBA for display
+		///
+		/// Output is four bytes per pixel in R, G, B, A order with alpha 255.
+		/// YBR_FULL is converted with the full-range (JFIF) matrix in 14-bit
+		/// fixed point, the same arithmetic as the JPEG decoder. The SIMD
+		/// kernels (SSSE3, plus AVX2 for the YBR conversions) produce the same
+		/// bytes as the scalar code and are chosen once from CpuFeatures.
+		class ColorConvert
+		{
+		public:
+			/// Interleaved RGB triplets (PlanarConfiguration 0)
+			static void RgbToRgba(const uint8_t* rgb, size_t count, uint8_t* rgba);
+
+			/// Separate red, green and blue planes (PlanarConfiguration 1)
+			static void PlanarRgbToRgba(const uint8_t* red, const uint8_t* green, const uint8_t* blue,
+				size_t count, uint8_t* rgba);
+
+			/// Interleaved YBR_FULL triplets
+			static void YbrFullToRgba(const uint8_t* ybr, size_t count, uint8_t* rgba);
+
+			/// Separate Y, Cb and Cr planes of YBR_FULL
+			static void PlanarYbrFullToRgba(const uint8_t* luma, const uint8_t* blue, const uint8_t* red,
+				size_t count, uint8_t* rgba);
+
+			/// YBR_FULL_422: each pair of pixels is stored as Y0 Y1 Cb Cr. count
+			/// is in pixels; an odd final pixel reads the Y0 Cb Cr of its pair.
+			static void YbrFull422ToRgba(const uint8_t* ybr, size_t count, uint8_t* rgba);
+
+			/// Map indices through a palette of packed RGBA entries (see PackRgba)
+			/// covering every index value: 256 entries for 8-bit indices, 65536 for 16-bit
+			static void PaletteToRgba(const uint8_t* indices, size_t count, const uint32_t* palette, uint8_t* rgba);
+			static void PaletteToRgba(const uint16_t* indices, size_t count, const uint32_t* palette, uint8_t* rgba);
+
+			/// One palette entry whose bytes in memory are red, green, blue, 255
+			static uint32_t PackRgba(uint8_t red, uint8_t green, uint8_t blue);
+
+			/// Expand Segmented Palette Color LUT Data (discrete, linear and
+			/// indirect segments) into plain 16-bit LUT entries. Indirect offsets
+			/// are byte offsets from the start of data. False on malformed
+			/// segments or if the expansion exceeds maxEntries.
+			static bool ExpandSegmentedLut(const uint16_t* data, size_t words, size_t maxEntries,
+				std::vector<uint16_t>& entries);
+
+			/// Instruction set of the selected kernels: "AVX2", "SSSE3" or "Scalar"
+			static const char* GetKernelName();
+		};
+
+	} // namespace dicom
+} // namespace medvision
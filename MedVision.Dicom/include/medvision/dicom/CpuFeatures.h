@@ -0,0 +1,37 @@
+#pragma once
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Runtime CPU feature detection for SIMD kernel dispatch
+		///
+		/// SSE2 is the x64 baseline and may be used unconditionally there; newer
+		/// instruction sets must be checked here before calling a kernel built
+		/// with MEDVISION_TARGET. All queries are false on non-x86 targets.
+		class CpuFeatures
+		{
+		public:
+			static bool HasSSE2();
+			static bool HasSSSE3();
+			static bool HasSSE41();
+			static bool HasAVX2();   // Includes the OS check for saved YMM state
+			static bool HasF16C();   // Includes the OS check for saved YMM state
+			static bool HasAVX512F(); // Includes the OS check for saved ZMM state
+		};
+
+	} // namespace dicom
+} // namespace medvision
+
+// Lets GCC/Clang compile a single function for a newer instruction set
+// (MSVC always accepts the intrinsics); e.g. MEDVISION_TARGET("ssse3")
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MEDVISION_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MEDVISION_TARGET(isa)
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MEDVISION_X86 1
+#endif
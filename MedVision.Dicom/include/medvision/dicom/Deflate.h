@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Raw DEFLATE (RFC 1951) decompressor that pulls its input on demand
+		///
+		/// Output is produced in chunks into a sliding window that keeps the
+		/// 32 KB of history back-references need, so a stream of any size is
+		/// inflated in constant memory. A zlib (RFC 1950) header in front of the
+		/// data is tolerated, as some writers add one to deflated datasets.
+		class InflateStream
+		{
+		public:
+			/// Supplies up to capacity compressed bytes; returns 0 at the end of input
+			using Source = std::function<size_t(uint8_t* buffer, size_t capacity)>;
+
+			explicit InflateStream(Source source);
+
+			InflateStream(const InflateStream&) = delete;
+			InflateStream& operator=(const InflateStream&) = delete;
+
+			/// Decompress up to count bytes; fewer only at the end of the stream
+			/// or on malformed data (see GetLastError)
+			size_t Read(uint8_t* buffer, size_t count);
+
+			/// Discard up to count bytes of output; returns the number skipped
+			size_t Skip(size_t count);
+
+			/// True once the final block is decoded and all its output was read
+			/// (decodes ahead to find out)
+			bool AtEnd();
+
+			/// Empty unless the compressed data was malformed or truncated
+			const std::string& GetLastError() const { return error_; }
+
+		private:
+			/// Canonical Huffman code with a direct lookup for short codes
+			struct Table
+			{
+				static const int kFastBits = 10;
+				uint16_t fast[1 << kFastBits];   // (symbol << 4) | length, 0 = longer code
+				uint16_t counts[16];             // Codes of each length
+				uint16_t symbols[288];           // Ordered by code
+			};
+
+			bool Produce();
+			bool ReadHeader();
+			bool ReadDynamicTables();
+			bool CopyStored();
+			bool DecodeHuffman();
+
+			static bool BuildTable(Table& table, const uint8_t* lengths, int count);
+			int DecodeSymbol(const Table& table);
+
+			void Refill();
+			bool NeedBits(int count);
+			uint32_t GetBits(int count);
+			void Fail(const char* message);
+
+		private:
+			enum class State { Header, Stored, Huffman, Done };
+
+			Source source_;
+			std::vector<uint8_t> input_;
+			size_t inputPosition_;
+			size_t inputLength_;
+			bool inputDone_;
+			uint64_t bits_;          // LSB first
+			int bitCount_;
+
+			std::vector<uint8_t> window_;
+			size_t readPosition_;    // Next output byte to hand out
+			size_t writePosition_;   // End of decoded output
+
+			State state_;
+			bool finalBlock_;
+			bool headerChecked_;
+			size_t storedRemaining_;
+			Table literals_;
+			Table distances_;
+			std::string error_;
+		};
+
+		/// Raw DEFLATE (RFC 1951) compressor that pushes output to a sink
+		///
+		/// Input is compressed in blocks of 64 KB with hash-chain LZ77 matching
+		/// against the previous 32 KB; each block is emitted with dynamic or
+		/// fixed Huffman codes, or stored, whichever is smallest.
+		class DeflateStream
+		{
+		public:
+			/// Receives compressed bytes; returns false to abort
+			using Sink = std::function<bool(const uint8_t* data, size_t length)>;
+
+			explicit DeflateStream(Sink sink);
+
+			DeflateStream(const DeflateStream&) = delete;
+			DeflateStream& operator=(const DeflateStream&) = delete;
+
+			/// Compress length more bytes of input
+			bool Write(const uint8_t* data, size_t length);
+
+			/// Compress the remaining input as the final block and flush it
+			bool Finish();
+
+			/// Compressed bytes handed to the sink so far
+			uint64_t GetOutputLength() const { return outputLength_; }
+
+			/// Compress a whole buffer in one call
+			static void Compress(const uint8_t* data, size_t length, std::vector<uint8_t>& output);
+
+		private:
+			/// LZ77 output: a literal (distance 0) or a length/distance pair
+			struct Token
+			{
+				uint16_t value;      // Literal byte or match length
+				uint16_t distance;
+			};
+
+			bool CompressBlock(bool final);
+			void FindTokens(size_t begin, size_t end);
+			void WriteBlock(size_t begin, size_t end, bool final);
+			void WriteStored(size_t begin, size_t end, bool final);
+			void WriteTokens(const uint16_t* literalCodes, const uint8_t* literalLengths,
+				const uint16_t* distanceCodes, const uint8_t* distanceLengths);
+			void PutBits(uint32_t value, int count);
+			void AlignToByte();
+			bool Drain(bool all);
+
+		private:
+			Sink sink_;
+			std::vector<uint8_t> buffer_;   // History followed by pending input
+			size_t historyLength_;
+			size_t pendingLength_;
+			std::vector<int32_t> head_;     // Latest position of each hash
+			std::vector<int32_t> previous_; // Earlier position with the same hash
+			std::vector<Token> tokens_;
+
+			std::vector<uint8_t> output_;
+			uint64_t bitBuffer_;
+			int bitCount_;
+			uint64_t outputLength_;
+			bool finished_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
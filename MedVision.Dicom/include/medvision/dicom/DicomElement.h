@@ -56,10 +56,16 @@ namespace medvision
 			bool SetData(const uint8_t* data, uint32_t length);
 			bool SetData(const std::vector<uint8_t>& data);
 
+			/// Encapsulated (undefined length) values keep their raw item stream,
+			/// including the sequence delimiter, and are written back with length FFFFFFFFH
+			bool IsUndefinedLength() const { return undefinedLength_; }
+			void SetUndefinedLength(bool undefinedLength) { undefinedLength_ = undefinedLength; }
+
 		private:
 			DicomTag tag_;
 			VR vr_;
 			uint32_t length_;
+			bool undefinedLength_;
 			std::vector<uint8_t> data_;
 		};
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "DicomDataSet.h"
+#include "DicomElement.h"
+#include "FileHandle.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// How DicomPatcher applied the last set of edits
+		enum class PatchMode
+		{
+			None,      // Nothing written (no edits or failure)
+			InPlace,   // Values overwritten inside the existing file
+			Rewrite    // Header region rewritten, pixel data tail spliced
+		};
+
+		/// Edits header elements of an existing DICOM file without re-encoding it
+		///
+		/// Edited values that still fit the element's existing (padded) length are
+		/// overwritten in place. Anything else (longer values, new elements) writes
+		/// a new header region to "<filePath>.tmp", appends the untouched remainder
+		/// of the file from PixelData onwards with a kernel-side copy, and renames
+		/// it over the original. Pixel data is never read into memory.
+		class DicomPatcher
+		{
+		public:
+			DicomPatcher();
+			~DicomPatcher();
+
+			/// Apply every element of changes to the file. Only top-level elements
+			/// that precede PixelData can be edited; group lengths are maintained.
+			bool PatchFile(const std::string& filePath, const DicomDataSet& changes);
+
+			/// How the last successful PatchFile call wrote its changes
+			PatchMode GetLastMode() const { return lastMode_; }
+
+			/// Sync the patched file (and its directory after a rewrite) before returning
+			void SetSyncOnClose(bool sync) { syncOnClose_ = sync; }
+
+			/// Get last error message
+			const std::string& GetLastError() const { return lastError_; }
+
+		private:
+			/// A top-level element as found in the file
+			struct Location
+			{
+				uint32_t tag;
+				VR vr;
+				uint64_t offset;        // Start of the element header
+				uint64_t valueOffset;   // Start of the value
+				uint32_t valueLength;   // As declared (may be undefined)
+				uint64_t endOffset;     // One past the last byte of the element
+			};
+
+			/// One piece of a rewritten file: a source range or encoded bytes
+			struct Piece
+			{
+				bool fromSource;
+				uint64_t offset;        // Source offset, or offset into encoded_
+				uint64_t length;
+			};
+
+			bool ScanFile();
+			bool ScanElement(bool explicitVR, bool bigEndian, uint64_t& position, Location& location);
+			bool SkipUndefinedLength(bool explicitVR, bool bigEndian, uint64_t& position);
+			bool ReadBytes(uint64_t offset, uint8_t* data, size_t length);
+			uint16_t ToUInt16(const uint8_t* data, bool bigEndian) const;
+			uint32_t ToUInt32(const uint8_t* data, bool bigEndian) const;
+
+			const Location* FindLocation(uint32_t tag) const;
+			void EncodeValue(const DicomElement& element, bool bigEndian, std::vector<uint8_t>& value) const;
+			void EncodeElement(uint32_t tag, VR vr, const std::vector<uint8_t>& value,
+				bool explicitVR, bool bigEndian, std::vector<uint8_t>& output) const;
+			bool CanPatchInPlace(const Location& location, const DicomElement& element, size_t encodedLength) const;
+
+			bool ValidateChanges(const DicomDataSet& changes);
+			bool ApplyInPlace(const DicomDataSet& changes);
+			bool ApplyRewrite(const std::string& filePath, const DicomDataSet& changes);
+			void AddSourcePiece(uint64_t offset, uint64_t length);
+			void AddEncodedPiece(const std::vector<uint8_t>& bytes);
+
+			void SetError(const std::string& error) { lastError_ = error; }
+
+		private:
+			FileHandle file_;
+			uint64_t fileSize_;
+			std::vector<Location> locations_;
+			uint64_t tailOffset_;       // PixelData (or end of file)
+			bool explicitVR_;
+			bool bigEndian_;
+
+			// Read-ahead window used while scanning element headers
+			std::vector<uint8_t> window_;
+			uint64_t windowOffset_;
+
+			std::vector<Piece> pieces_;
+			std::vector<uint8_t> encoded_;
+
+			PatchMode lastMode_;
+			bool syncOnClose_;
+			std::string lastError_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -10,7 +10,12 @@ namespace medvision
 	namespace dicom
 	{
 
+		class InflateStream;
+
 		/// DICOM file reader
+		///
+		/// A Deflated Explicit VR Little Endian body is inflated as a stream
+		/// while it is parsed; the whole file is never decompressed at once.
 		class DicomReader
 		{
 		public:
@@ -42,10 +47,13 @@ namespace medvision
 			bool ReadVR(VR& vr);
 			bool ReadLength(uint32_t& length, VR vr);
 			bool ReadData(std::vector<uint8_t>& data, uint32_t length);
+			bool ReadEncapsulatedPixelData(DicomDataSet& dataSet, VR vr);
 
 			uint16_t ReadUInt16();
 			uint32_t ReadUInt32();
 			bool ReadBytes(uint8_t* buffer, size_t count);
+			bool SkipBytes(size_t count);
+			bool AtEndOfData();
 
 			void SetError(const std::string& error);
 			VR DetermineImplicitVR(const DicomTag& tag) const;
@@ -55,6 +63,7 @@ namespace medvision
 			const uint8_t* buffer_;
 			size_t bufferLength_;
 			size_t bufferPos_;
+			std::unique_ptr<InflateStream> inflater_;   // Set for a deflated body
 
 			bool isExplicitVR_;
 			bool isBigEndian_;
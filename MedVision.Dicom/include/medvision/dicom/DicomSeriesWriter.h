@@ -0,0 +1,87 @@
+#pragma once
+
+#include "DicomDataSet.h"
+#include "TransferSyntax.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		class ThreadPool;
+
+		/// One instance to be written by DicomSeriesWriter
+		struct SeriesWriteItem
+		{
+			std::string filePath;
+			const DicomDataSet* dataSet;
+		};
+
+		/// Outcome for one SeriesWriteItem (same order as the input)
+		struct SeriesWriteResult
+		{
+			std::string filePath;
+			bool success;
+			std::string error;
+		};
+
+		/// Writes a whole series concurrently with crash-safe commits
+		///
+		/// Each instance is encoded by its own DicomWriter on a worker pool into
+		/// "<filePath>.tmp", synced, and renamed over filePath only once the whole
+		/// batch has been written; each target directory is then synced once.
+		/// A crash therefore leaves either the previous file or the complete new
+		/// one, never a truncated file.
+		class DicomSeriesWriter
+		{
+		public:
+			/// Called after each instance is written (from worker threads, serialized)
+			using ProgressCallback = std::function<void(size_t completed, size_t total)>;
+
+			/// threadCount 0 = use the shared pool
+			explicit DicomSeriesWriter(size_t threadCount = 0);
+			~DicomSeriesWriter();
+
+			DicomSeriesWriter(const DicomSeriesWriter&) = delete;
+			DicomSeriesWriter& operator=(const DicomSeriesWriter&) = delete;
+
+			/// Transfer syntax used for every instance (default: keep each dataset's own)
+			void SetTransferSyntax(const std::string& transferSyntaxUID) { transferSyntax_ = transferSyntaxUID; }
+
+			/// Progress notifications
+			void SetProgressCallback(ProgressCallback callback) { progress_ = callback; }
+
+			/// Sync files and directories to stable storage (default: true)
+			void SetDurable(bool durable) { durable_ = durable; }
+
+			/// Write all items; returns true if every item succeeded
+			bool Write(const std::vector<SeriesWriteItem>& items);
+
+			/// Per-file results of the last Write call
+			const std::vector<SeriesWriteResult>& GetResults() const { return results_; }
+
+			/// Number of failed items in the last Write call
+			size_t GetFailureCount() const;
+
+			/// Temporary path used while an instance is being written
+			static std::string GetTemporaryPath(const std::string& filePath);
+
+		private:
+			void Commit();
+
+		private:
+			std::unique_ptr<ThreadPool> ownedPool_;
+			ThreadPool* pool_;
+			std::string transferSyntax_;
+			ProgressCallback progress_;
+			bool durable_;
+			std::vector<SeriesWriteResult> results_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -56,10 +56,28 @@ namespace medvision
 			static const DicomTag PixelRepresentation;               // (0028,0103)
 			static const DicomTag SamplesPerPixel;                   // (0028,0002)
 			static const DicomTag PhotometricInterpretation;         // (0028,0004)
+			static const DicomTag PlanarConfiguration;               // (0028,0006)
+			static const DicomTag NumberOfFrames;                    // (0028,0008)
+			static const DicomTag PixelPaddingValue;                 // (0028,0120)
+			static const DicomTag PixelPaddingRangeLimit;            // (0028,0121)
 			static const DicomTag WindowCenter;                      // (0028,1050)
 			static const DicomTag WindowWidth;                       // (0028,1051)
 			static const DicomTag RescaleIntercept;                  // (0028,1052)
 			static const DicomTag RescaleSlope;                      // (0028,1053)
+			static const DicomTag RedPaletteColorLookupTableDescriptor;       // (0028,1101)
+			static const DicomTag GreenPaletteColorLookupTableDescriptor;     // (0028,1102)
+			static const DicomTag BluePaletteColorLookupTableDescriptor;      // (0028,1103)
+			static const DicomTag RedPaletteColorLookupTableData;             // (0028,1201)
+			static const DicomTag GreenPaletteColorLookupTableData;           // (0028,1202)
+			static const DicomTag BluePaletteColorLookupTableData;            // (0028,1203)
+			static const DicomTag SegmentedRedPaletteColorLookupTableData;    // (0028,1221)
+			static const DicomTag SegmentedGreenPaletteColorLookupTableData;  // (0028,1222)
+			static const DicomTag SegmentedBluePaletteColorLookupTableData;   // (0028,1223)
+			static const DicomTag DoseGridScaling;                   // (3004,000E)
+			static const DicomTag ExtendedOffsetTable;               // (7FE0,0001)
+			static const DicomTag ExtendedOffsetTableLengths;        // (7FE0,0002)
+			static const DicomTag FloatPixelData;                    // (7FE0,0008)
+			static const DicomTag DoubleFloatPixelData;              // (7FE0,0009)
 			static const DicomTag PixelData;                         // (7FE0,0010)
 
 		private:
@@ -1,15 +1,28 @@
 #pragma once
 
 #include "DicomDataSet.h"
+#include "FileHandle.h"
+#include "PixelDataSource.h"
+#include <memory>
 #include <string>
-#include <fstream>
+#include <vector>
 
 namespace medvision
 {
 	namespace dicom
 	{
 
+		class DeflateStream;
+
 		/// DICOM file writer
+		///
+		/// Element headers are encoded into a compact staging buffer while values
+		/// are referenced in place; the resulting segment list is emitted with a
+		/// single gathered write per flush. Memory output runs a sizing pass
+		/// first and encodes straight into a buffer of exactly that size.
+		/// With Deflated Explicit VR Little Endian the flushed segments are
+		/// compressed on their way out instead; its size is known only after
+		/// compressing.
 		class DicomWriter
 		{
 		public:
@@ -19,39 +32,121 @@ namespace medvision
 			/// Write DICOM dataset to file
 			bool WriteFile(const std::string& filePath, const DicomDataSet& dataSet);
 
-			/// Write DICOM dataset to memory buffer
+			/// Streaming write: PixelData is pulled from pixelData instead of the
+			/// dataset (any PixelData element in dataSet is ignored), so memory use
+			/// stays constant regardless of the object size. The source is copied
+			/// as is, so word data must already be in the target byte order; a
+			/// write that would need swapping it fails.
+			bool WriteFile(const std::string& filePath, const DicomDataSet& dataSet, PixelDataSource& pixelData);
+
+			/// Streaming write of compressed frames: PixelData is written
+			/// encapsulated, one fragment per frame pulled from frames, behind an
+			/// Extended Offset Table (7FE0,0001/0002) that is filled in once all
+			/// frames are written, so the pixel data may exceed 4 GB. Requires an
+			/// encapsulated transfer syntax; PixelData and offset tables in dataSet
+			/// are ignored.
+			bool WriteFile(const std::string& filePath, const DicomDataSet& dataSet, EncapsulatedFrameSource& frames);
+
+			/// Write DICOM dataset to memory buffer (sized exactly, allocated once)
 			bool WriteBuffer(std::vector<uint8_t>& buffer, const DicomDataSet& dataSet);
 
-			/// Set transfer syntax for writing (default: ExplicitVRLittleEndian)
+			/// Write DICOM dataset into caller-provided memory, e.g. a shared-memory
+			/// segment or a network send buffer. Fails without writing anything if
+			/// capacity is smaller than GetEncodedSize(dataSet).
+			bool WriteBuffer(uint8_t* destination, size_t capacity, const DicomDataSet& dataSet, size_t& bytesWritten);
+
+			/// Exact number of bytes WriteFile/WriteBuffer produce for this dataset
+			/// (when compressing or deflating, this encodes the data to find out)
+			size_t GetEncodedSize(const DicomDataSet& dataSet) const;
+
+			/// Set transfer syntax for writing. By default the dataset's own
+			/// TransferSyntaxUID is kept (Explicit VR Little Endian if it has none).
+			/// Switching between the uncompressed syntaxes transcodes the values:
+			/// OW/OF/OL/OD/US/SS/... are byte swapped according to their VR.
+			/// Values are taken to be in the byte order of the dataset's own syntax,
+			/// as DicomReader stores them. Native PixelData written with a compressed
+			/// syntax is encoded by the CodecRegistry's encoder (frames in parallel)
+			/// and stored encapsulated.
 			void SetTransferSyntax(const std::string& transferSyntaxUID);
 
+			/// Flush file data to stable storage before WriteFile returns (default: off)
+			void SetSyncOnClose(bool sync) { syncOnClose_ = sync; }
+
 			/// Get last error message
 			const std::string& GetLastError() const { return lastError_; }
 
 		private:
+			/// Output segment: either a range of staging_ or an external value
+			struct Segment
+			{
+				const uint8_t* external;  // nullptr = staging_ range
+				size_t offset;
+				size_t length;
+			};
+
+			size_t GetElementEncodedSize(const DicomElement& element, bool explicitVR) const;
+			uint32_t ComputeMetaGroupLength(const DicomDataSet& dataSet, const std::string& targetSyntax) const;
+			void CollectMetaElements(const DicomDataSet& dataSet, const DicomElement& transferSyntax, std::vector<const DicomElement*>& elements) const;
+			std::string ResolveTransferSyntax(const DicomDataSet& dataSet) const;
+			size_t ComputeEncodedSize(const DicomDataSet& dataSet, const std::string& targetSyntax, const DicomElement* pixelData) const;
+			static std::string GetSourceSyntax(const DicomDataSet& dataSet);
+			static bool NeedsPixelEncoding(const DicomDataSet& dataSet, const std::string& targetSyntax);
+			bool EncodePixelData(const DicomDataSet& dataSet, const std::string& targetSyntax, DicomElement& encoded, std::string& error) const;
+			bool BeginWrite(const DicomDataSet& dataSet, bool usePixelData = true);
+			bool WriteDirect(uint8_t* destination, size_t capacity, const DicomDataSet& dataSet, size_t& bytesWritten);
+			bool WriteDeflated(std::vector<uint8_t>& buffer, const DicomDataSet& dataSet);
+			bool BeginDeflate();
+			bool EndDeflate();
+
 			bool WritePreamble();
 			bool WriteMetaInformation(const DicomDataSet& dataSet);
-			bool WriteDataSet(const DicomDataSet& dataSet);
+			bool WriteDataSet(const DicomDataSet& dataSet, uint32_t beginTag = 0, uint32_t endTag = 0xFFFFFFFF);
 			bool WriteDataElement(const DicomElement& element);
 
 			bool WriteTag(const DicomTag& tag);
 			bool WriteVR(VR vr);
 			bool WriteLength(uint32_t length, VR vr);
-			bool WriteData(const uint8_t* data, uint32_t length);
+			bool WriteData(const uint8_t* data, uint32_t length, VR vr);
+			bool WriteSwappedData(const uint8_t* data, uint32_t length, VR vr);
+			bool WriteItemHeader(uint16_t element, uint32_t length);
 
 			void WriteUInt16(uint16_t value);
 			void WriteUInt32(uint32_t value);
-			bool WriteBytes(const uint8_t* buffer, size_t count);
+			void WriteBytes(const uint8_t* buffer, size_t count);
+
+			bool Flush();
+			bool CloseFile(bool success);
+			void ResetOutput();
 
 			void SetError(const std::string& error);
 
 		private:
-			std::ofstream file_;
-			std::vector<uint8_t>* outputBuffer_;
+			FileHandle file_;
+
+			// Direct encoding target (WriteBuffer); bypasses staging
+			uint8_t* directOutput_;
+			size_t directCapacity_;
+			size_t directPosition_;
+
+			// Memory target of a deflated write (WriteBuffer)
+			std::vector<uint8_t>* bufferOutput_;
+
+			// Set while the dataset body is being deflated
+			std::unique_ptr<DeflateStream> deflater_;
+
+			std::vector<uint8_t> staging_;
+			std::vector<Segment> segments_;
+			std::vector<IoSegment> ioSegments_;
+			std::vector<uint8_t> swapBuffer_;
 
 			bool isExplicitVR_;
 			bool isBigEndian_;
-			std::string transferSyntax_;
+			bool syncOnClose_;
+			bool swapValues_;              // Source and target byte order differ
+			std::string transferSyntax_;   // Requested; empty = keep the dataset's
+			std::string activeSyntax_;     // Resolved for the current write
+			bool encodePixelData_;         // PixelData is replaced by encodedPixelData_
+			DicomElement encodedPixelData_;
 			std::string lastError_;
 		};
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Fragment and frame index over an encapsulated PixelData value
+		///
+		/// Works on the raw item stream as stored by DicomReader (Basic Offset
+		/// Table item, fragment items, sequence delimiter). Nothing is copied
+		/// unless a frame spans several fragments.
+		class EncapsulatedPixelData
+		{
+		public:
+			/// One fragment item's value inside the parsed buffer
+			struct Fragment
+			{
+				size_t offset;          // Value offset within the item stream
+				uint32_t length;
+			};
+
+			EncapsulatedPixelData();
+
+			/// Index the item stream; frameCount is NumberOfFrames (1 if absent)
+			bool Parse(const uint8_t* data, size_t length, uint32_t frameCount);
+
+			/// As above, with the Extended Offset Table (7FE0,0001) value of the
+			/// dataset (little endian 64-bit offsets); it locates the frames
+			/// when the Basic Offset Table is empty
+			bool Parse(const uint8_t* data, size_t length, uint32_t frameCount,
+				const uint8_t* extendedOffsetTable, size_t extendedOffsetTableLength);
+
+			size_t GetFragmentCount() const { return fragments_.size(); }
+			const Fragment& GetFragment(size_t index) const { return fragments_[index]; }
+
+			size_t GetFrameCount() const { return frameFirstFragment_.size(); }
+
+			/// Basic Offset Table entries (empty if the table was empty)
+			const std::vector<uint32_t>& GetBasicOffsetTable() const { return offsetTable_; }
+
+			/// Compressed bytes of one frame. Single-fragment frames point into the
+			/// parsed buffer; others are concatenated into storage.
+			bool GetFrame(size_t frameIndex, std::vector<uint8_t>& storage, const uint8_t*& frameData, size_t& frameLength) const;
+
+			/// Build an item stream with one fragment per frame (padded to even
+			/// length) behind a Basic Offset Table pointing at each frame
+			static void Build(const std::vector<std::vector<uint8_t>>& frames, std::vector<uint8_t>& stream);
+
+			/// Get last error message
+			const std::string& GetLastError() const { return lastError_; }
+
+		private:
+			bool AssignFramesFromOffsets(const std::vector<uint64_t>& offsets, const char* tableName);
+			void SetError(const std::string& error) { lastError_ = error; }
+
+		private:
+			const uint8_t* data_;
+			std::vector<uint32_t> offsetTable_;
+			std::vector<Fragment> fragments_;
+			std::vector<size_t> fragmentItemOffsets_;   // Offset of each fragment's item header after the table
+			std::vector<size_t> frameFirstFragment_;    // First fragment of each frame
+			std::string lastError_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
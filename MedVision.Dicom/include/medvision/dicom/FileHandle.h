@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// One contiguous piece of a gathered (vectored) write
+		struct IoSegment
+		{
+			const uint8_t* data;
+			size_t length;
+		};
+
+		/// Thin RAII wrapper around a platform file descriptor
+		/// Uses POSIX descriptors or the MSVC CRT equivalents (_sopen_s/_write)
+		class FileHandle
+		{
+		public:
+			FileHandle();
+			~FileHandle();
+
+			FileHandle(const FileHandle&) = delete;
+			FileHandle& operator=(const FileHandle&) = delete;
+
+			/// Create (or truncate) a file for writing
+			bool Create(const std::string& filePath);
+
+			/// Open an existing file for reading
+			bool OpenRead(const std::string& filePath);
+
+			/// Open an existing file for reading and in-place writes
+			bool OpenReadWrite(const std::string& filePath);
+
+			/// Close the descriptor if open
+			void Close();
+
+			bool IsOpen() const { return fd_ >= 0; }
+			int GetDescriptor() const { return fd_; }
+
+			/// Write a contiguous block, retrying on partial writes
+			bool Write(const uint8_t* data, size_t count);
+
+			/// Write several segments in order with as few system calls as possible
+			/// (writev on POSIX, sequential writes elsewhere)
+			bool WriteGather(const IoSegment* segments, size_t count);
+
+			/// Read exactly count bytes starting at an absolute file offset
+			bool ReadAt(uint8_t* buffer, size_t count, uint64_t offset) const;
+
+			/// Overwrite count bytes at an absolute file offset
+			bool WriteAt(const uint8_t* data, size_t count, uint64_t offset);
+
+			/// Current size of the open file in bytes
+			bool GetSize(uint64_t& size) const;
+
+			/// Append length bytes of another descriptor (starting at sourceOffset)
+			/// to this file. Uses copy_file_range/sendfile on Linux so the data
+			/// never passes through user space, else a fixed-size bounce buffer.
+			bool CopyFrom(int sourceDescriptor, uint64_t sourceOffset, uint64_t length);
+
+			/// Flush file data to stable storage (fsync / _commit)
+			bool Sync();
+
+			/// Atomically replace target with source (same volume)
+			static bool Rename(const std::string& sourcePath, const std::string& targetPath);
+
+			/// Delete a file; returns false if it could not be removed
+			static bool Remove(const std::string& filePath);
+
+			/// Directory part of a path ("." when there is none)
+			static std::string GetDirectory(const std::string& filePath);
+
+			/// Make directory entries (creates/renames) durable. No-op on Windows,
+			/// where MoveFileEx write-through already covers it.
+			static bool SyncDirectory(const std::string& directoryPath);
+
+		private:
+			int fd_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
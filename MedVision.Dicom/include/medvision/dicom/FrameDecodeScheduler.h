@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CodecRegistry.h"
+#include "EncapsulatedPixelData.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Decodes the frames of an encapsulated PixelData value concurrently,
+		/// each into its own preallocated slot of one output buffer
+		///
+		/// Pool workers claim frames in priority order: the focus frame first,
+		/// then its neighbors by increasing distance (the later one first on a
+		/// tie). Prioritize moves the focus while decoding is under way, e.g. when
+		/// the user scrolls. Waiting on a frame that no worker has claimed yet
+		/// decodes it on the calling thread instead of queueing behind others.
+		/// Decoders without CodecMultiFrameParallel run one frame at a time.
+		class FrameDecodeScheduler
+		{
+		public:
+			enum class FrameState { Pending, Decoding, Decoded, Failed };
+
+			/// frames (and the buffer it indexes) and output must outlive the
+			/// scheduler; output holds GetFrameCount() * GetFrameLength() bytes.
+			/// A nonzero reduction decodes at 1/2^reduction of the full size.
+			FrameDecodeScheduler(const EncapsulatedPixelData& frames, std::shared_ptr<const PixelDecoder> decoder,
+				const FrameInfo& info, uint32_t reduction, uint8_t* output, ThreadPool& pool = ThreadPool::Shared());
+
+			/// Cancels the remaining frames and waits for those being decoded
+			~FrameDecodeScheduler();
+
+			FrameDecodeScheduler(const FrameDecodeScheduler&) = delete;
+			FrameDecodeScheduler& operator=(const FrameDecodeScheduler&) = delete;
+
+			size_t GetFrameCount() const;
+
+			/// Bytes of one output slot
+			size_t GetFrameLength() const;
+
+			/// Begin decoding in the background, starting at focusFrame
+			void Start(size_t focusFrame = 0);
+
+			/// Decode focusFrame next, then its neighbors
+			void Prioritize(size_t focusFrame);
+
+			/// Block until frame is decoded; false if it failed
+			bool WaitForFrame(size_t frame);
+
+			/// Decode every remaining frame (helping on the calling thread);
+			/// false if any frame failed
+			bool WaitAll();
+
+			/// Stop claiming frames in the background; WaitForFrame and WaitAll
+			/// still decode on demand
+			void Cancel();
+
+			FrameState GetFrameState(size_t frame) const;
+
+			/// First decode failure ("Frame N: ..."), empty if none
+			std::string GetLastError() const;
+
+		private:
+			struct State;
+
+			std::shared_ptr<State> state_;
+			ThreadPool& pool_;
+			bool started_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
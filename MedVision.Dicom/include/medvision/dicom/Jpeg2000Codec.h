@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CodecRegistry.h"
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// JPEG 2000 (1.2.840.10008.1.2.4.90 / .91) decoder
+		///
+		/// Decodes Part 1 codestreams: any number of tiles and quality layers, all
+		/// five progression orders, precincts, every code-block style, RGN
+		/// max-shift, reversible 5/3 and irreversible 9/7 wavelets and both
+		/// component transforms (so three-component output with a multiple
+		/// component transform is RGB). Code blocks are entropy-decoded in
+		/// parallel on the shared ThreadPool. Reduced decoding stops the inverse
+		/// wavelet transform early and skips the code blocks of the discarded
+		/// resolution levels. Rejects HTJ2K (Part 15) block coding, progression
+		/// order changes (POC), packed packet headers (PPM/PPT) and subsampled
+		/// components.
+		class Jpeg2000Decoder : public PixelDecoder
+		{
+		public:
+			/// lossless selects the capabilities reported for the transfer syntax
+			explicit Jpeg2000Decoder(bool lossless) : lossless_(lossless) {}
+
+			const char* GetName() const override { return "JPEG 2000"; }
+			uint32_t GetCapabilities() const override
+			{
+				return (lossless_ ? CodecLossless : CodecLossy) | CodecMultiFrameParallel | CodecPartialDecode;
+			}
+
+			bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const override;
+
+			/// reduction up to the smallest number of decomposition levels
+			bool DecodeFrameReduced(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint32_t reduction, uint8_t* output, std::string& error) const override;
+
+			std::string GetDecodedPhotometricInterpretation(const FrameInfo& info) const override;
+
+		private:
+			bool lossless_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
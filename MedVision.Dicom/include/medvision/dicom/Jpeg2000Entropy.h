@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Subband orientation of a JPEG 2000 code block
+		enum Jpeg2000Orientation
+		{
+			Jpeg2000LL = 0,
+			Jpeg2000HL = 1,   // Horizontally high-pass
+			Jpeg2000LH = 2,   // Vertically high-pass
+			Jpeg2000HH = 3
+		};
+
+		/// Code-block style flags of the COD/COC segments (T.800 Table A.19)
+		enum Jpeg2000BlockStyle : uint32_t
+		{
+			Jpeg2000Bypass = 0x01,            // Selective arithmetic coding bypass
+			Jpeg2000ResetContexts = 0x02,     // Reset probabilities after every pass
+			Jpeg2000TerminateAll = 0x04,      // Terminate every pass
+			Jpeg2000VerticalCausal = 0x08,    // Stripes do not look at the stripe below
+			Jpeg2000Predictable = 0x10,       // Predictable termination (no decoder impact)
+			Jpeg2000Segmentation = 0x20,      // Segmentation symbol after each cleanup pass
+			Jpeg2000HighThroughput = 0x40     // HTJ2K block coder (Part 15)
+		};
+
+		/// Consecutive coding passes of a code block that were terminated together
+		struct Jpeg2000Segment
+		{
+			size_t offset;     // Into the code block's data
+			size_t length;
+			uint32_t passes;
+		};
+
+		/// MQ arithmetic decoder (T.800 Annex C)
+		///
+		/// Reads past the end of the segment as a marker, which feeds 1 bits as
+		/// the standard requires.
+		class MqDecoder
+		{
+		public:
+			static const int kContexts = 19;
+
+			MqDecoder();
+
+			/// Start decoding a terminated segment; context states are kept
+			void Start(const uint8_t* data, size_t length);
+
+			/// Restore the initial states of T.800 Table D.7
+			void ResetContexts();
+
+			int Decode(int context)
+			{
+				uint8_t& state = contexts_[context];
+				const State& entry = kStates[state];
+				uint32_t qe = entry.qe;
+				int bit;
+				a_ -= qe;
+				if ((c_ >> 16) < qe)
+				{
+					// LPS path, with conditional exchange
+					if (a_ < qe)
+					{
+						bit = state & 1;
+						state = entry.nextMps;
+					}
+					else
+					{
+						bit = (state & 1) ^ 1;
+						state = entry.nextLps;
+					}
+					a_ = qe;
+					Renormalize();
+				}
+				else
+				{
+					c_ -= qe << 16;
+					if ((a_ & 0x8000) != 0)
+					{
+						return state & 1;
+					}
+					if (a_ < qe)
+					{
+						bit = (state & 1) ^ 1;
+						state = entry.nextLps;
+					}
+					else
+					{
+						bit = state & 1;
+						state = entry.nextMps;
+					}
+					Renormalize();
+				}
+				return bit;
+			}
+
+		private:
+			/// Probability state; indices are (table entry << 1) | MPS
+			struct State
+			{
+				uint32_t qe;
+				uint8_t nextMps;
+				uint8_t nextLps;
+			};
+
+			static const State kStates[94];
+
+			uint8_t ReadByte(size_t position) const
+			{
+				return position < length_ ? data_[position] : 0xFF;
+			}
+
+			void ByteIn()
+			{
+				if (ReadByte(position_) == 0xFF)
+				{
+					if (ReadByte(position_ + 1) > 0x8F)
+					{
+						c_ += 0xFF00;   // Marker: stay put and feed ones
+						count_ = 8;
+					}
+					else
+					{
+						++position_;
+						c_ += static_cast<uint32_t>(ReadByte(position_)) << 9;
+						count_ = 7;
+					}
+				}
+				else
+				{
+					++position_;
+					c_ += static_cast<uint32_t>(ReadByte(position_)) << 8;
+					count_ = 8;
+				}
+			}
+
+			void Renormalize()
+			{
+				do
+				{
+					if (count_ == 0)
+					{
+						ByteIn();
+					}
+					a_ <<= 1;
+					c_ <<= 1;
+					--count_;
+				} while ((a_ & 0x8000) == 0);
+			}
+
+		private:
+			const uint8_t* data_;
+			size_t length_;
+			size_t position_;
+			uint32_t a_;
+			uint32_t c_;
+			int count_;
+			uint8_t contexts_[kContexts];
+		};
+
+		/// Tier-1 (EBCOT) decoder for one code block
+		///
+		/// Keeps its scratch state between calls, so use one instance per thread.
+		class Jpeg2000BlockDecoder
+		{
+		public:
+			/// Decode the passes of a width x height code block whose first cleanup
+			/// pass codes bit plane bitPlanes - 1. Writes signed coefficients with
+			/// one fractional bit (twice the magnitude, reconstructed halfway into
+			/// the undecoded bit planes) to output in row-major order.
+			bool Decode(const uint8_t* data, const Jpeg2000Segment* segments, size_t segmentCount,
+				uint32_t width, uint32_t height, Jpeg2000Orientation orientation, uint32_t style,
+				uint32_t bitPlanes, int32_t* output);
+
+		private:
+			void SignificancePass(int plane, bool raw);
+			void RefinementPass(int plane, bool raw);
+			void CleanupPass(int plane);
+
+			int DecodeBit(int context, bool raw);
+			void DecodeSignificant(size_t index, uint32_t flags, int32_t& magnitude, int plane, bool raw);
+			void SetSignificant(size_t index, bool negative);
+			int RawBit();
+
+		private:
+			MqDecoder mq_;
+			const uint8_t* rawData_;
+			size_t rawLength_;
+			size_t rawPosition_;
+			uint32_t rawByte_;
+			int rawCount_;
+
+			uint32_t width_;
+			uint32_t height_;
+			size_t stride_;                 // Flags row length (one border column each side)
+			const uint8_t* zeroContexts_;   // Zero-coding contexts of the block's orientation
+			bool verticalCausal_;
+			std::vector<uint16_t> flags_;
+			std::vector<int32_t> magnitudes_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
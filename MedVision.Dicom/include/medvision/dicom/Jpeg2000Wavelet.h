@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Inverse discrete wavelet transforms of JPEG 2000 (T.800 Annex F)
+		///
+		/// Each call reconstructs one resolution level in place: the width x height
+		/// region holds lowWidth low-pass columns followed by the high-pass ones,
+		/// and lowHeight low-pass rows followed by the high-pass rows. xOdd and
+		/// yOdd give the parity of the level's first column and row on the
+		/// reference grid. Rows are transformed first, then columns; both passes
+		/// run the lifting steps on whole vectors of samples and split large
+		/// regions across the shared ThreadPool.
+		class Jpeg2000Wavelet
+		{
+		public:
+			/// Reversible 5/3 integer transform
+			static void Inverse53(int32_t* data, size_t stride, uint32_t width, uint32_t height,
+				uint32_t lowWidth, uint32_t lowHeight, bool xOdd, bool yOdd);
+
+			/// Irreversible 9/7 transform
+			static void Inverse97(float* data, size_t stride, uint32_t width, uint32_t height,
+				uint32_t lowWidth, uint32_t lowHeight, bool xOdd, bool yOdd);
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CodecRegistry.h"
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// JPEG Baseline (Process 1, 1.2.840.10008.1.2.4.50) decoder
+		///
+		/// Decodes 8-bit sequential Huffman frames (SOF0/SOF1) with one or three
+		/// components, any sampling factors, restart intervals and interleaved
+		/// or per-component scans. The 8x8 inverse DCT is a vectorized AAN
+		/// transform; chroma upsampling is fused with YCbCr to RGB conversion,
+		/// so three-component output is always RGB. Reduced decoding (1/2, 1/4,
+		/// 1/8) runs a 4x4, 2x2 or DC-only inverse DCT per block.
+		class JpegBaselineDecoder : public PixelDecoder
+		{
+		public:
+			const char* GetName() const override { return "JPEG Baseline"; }
+			uint32_t GetCapabilities() const override { return CodecLossy | CodecMultiFrameParallel | CodecPartialDecode; }
+
+			bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const override;
+
+			/// reduction 0-3 (full size down to 1/8)
+			bool DecodeFrameReduced(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint32_t reduction, uint8_t* output, std::string& error) const override;
+
+			std::string GetDecodedPhotometricInterpretation(const FrameInfo& info) const override;
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Huffman table from a JPEG DHT segment
+		///
+		/// Codes of up to kLookupBits bits resolve with a single table lookup;
+		/// longer codes fall back to the canonical max-code search. For DC and
+		/// lossless tables (symbol = magnitude category) the lookup also caches
+		/// whole differences whose code and extra bits fit in kLookupBits.
+		class JpegHuffmanTable
+		{
+		public:
+			static const int kLookupBits = 9;
+
+			JpegHuffmanTable();
+
+			/// Build from the 16 code-length counts and the symbols that follow them
+			bool Build(const uint8_t counts[16], const uint8_t* symbols, size_t symbolCount);
+
+			bool IsValid() const { return valid_; }
+
+		private:
+			friend class JpegBitReader;
+
+			bool valid_;
+			uint16_t lookup_[1 << kLookupBits];      // (length << 8) | symbol, 0 = longer code
+			uint8_t diffLength_[1 << kLookupBits];   // Code + extra bits, 0 = not cached
+			int16_t diff_[1 << kLookupBits];
+			int32_t maxCode_[17];                    // Largest code of each length (-1 = none)
+			int32_t valueOffset_[17];                // Symbol index = code + valueOffset
+			uint8_t symbols_[256];
+		};
+
+		/// MSB-first reader over JPEG entropy-coded data
+		///
+		/// Removes 0xFF00 stuffing and stops at markers, feeding zero bits
+		/// instead; IsOverrun tells whether any of those were consumed.
+		class JpegBitReader
+		{
+		public:
+			JpegBitReader(const uint8_t* data, size_t length, size_t position)
+				: data_(data), length_(length), position_(position), bits_(0), count_(0), padding_(0), marker_(false)
+			{
+			}
+
+			/// Top up the bit buffer to at least 57 bits
+			void Fill()
+			{
+				while (count_ <= 56)
+				{
+					uint64_t byte = 0;
+					if (!marker_ && position_ < length_)
+					{
+						byte = data_[position_];
+						if (byte != 0xFF)
+						{
+							++position_;
+						}
+						else if (position_ + 1 < length_ && data_[position_ + 1] == 0x00)
+						{
+							position_ += 2;
+						}
+						else
+						{
+							marker_ = true;
+							byte = 0;
+							padding_ += 8;
+						}
+					}
+					else
+					{
+						marker_ = true;
+						padding_ += 8;
+					}
+					bits_ |= byte << (56 - count_);
+					count_ += 8;
+				}
+			}
+
+			uint32_t GetBits(int count)
+			{
+				if (count == 0)
+				{
+					return 0;
+				}
+				if (count_ < count)
+				{
+					Fill();
+				}
+				uint32_t value = static_cast<uint32_t>(bits_ >> (64 - count));
+				bits_ <<= count;
+				count_ -= count;
+				return value;
+			}
+
+			/// Next Huffman symbol, or -1 for a code not in the table
+			int DecodeSymbol(const JpegHuffmanTable& table)
+			{
+				if (count_ < 16)
+				{
+					Fill();
+				}
+				uint16_t entry = table.lookup_[bits_ >> (64 - JpegHuffmanTable::kLookupBits)];
+				if (entry != 0)
+				{
+					Consume(entry >> 8);
+					return entry & 0xFF;
+				}
+
+				uint32_t code = static_cast<uint32_t>(bits_ >> 48);
+				for (int length = JpegHuffmanTable::kLookupBits + 1; length <= 16; ++length)
+				{
+					int32_t prefix = static_cast<int32_t>(code >> (16 - length));
+					if (prefix <= table.maxCode_[length])
+					{
+						Consume(length);
+						return table.symbols_[prefix + table.valueOffset_[length]];
+					}
+				}
+				return -1;
+			}
+
+			/// Magnitude category followed by its extra bits, as a signed difference.
+			/// Category 16 (lossless only) is 32768 without extra bits.
+			bool DecodeDifference(const JpegHuffmanTable& table, int32_t& difference)
+			{
+				if (count_ < 32)
+				{
+					Fill();
+				}
+				size_t index = static_cast<size_t>(bits_ >> (64 - JpegHuffmanTable::kLookupBits));
+				if (table.diffLength_[index] != 0)
+				{
+					Consume(table.diffLength_[index]);
+					difference = table.diff_[index];
+					return true;
+				}
+
+				int category = DecodeSymbol(table);
+				if (category < 0 || category > 16)
+				{
+					return false;
+				}
+				difference = (category == 16) ? 32768 : Extend(GetBits(category), category);
+				return true;
+			}
+
+			static int32_t Extend(uint32_t value, int category)
+			{
+				return (category > 0 && value < (1u << (category - 1)))
+					? static_cast<int32_t>(value) - (1 << category) + 1
+					: static_cast<int32_t>(value);
+			}
+
+			/// Drop buffered bits and consume an RSTn marker if one is next
+			bool Restart()
+			{
+				bits_ = 0;
+				count_ = 0;
+				padding_ = 0;
+				marker_ = false;
+				if (position_ + 1 < length_ && data_[position_] == 0xFF &&
+					data_[position_ + 1] >= 0xD0 && data_[position_ + 1] <= 0xD7)
+				{
+					position_ += 2;
+					return true;
+				}
+				return false;
+			}
+
+			/// True once zero bits past a marker or the end of data were consumed
+			bool IsOverrun() const { return padding_ > count_; }
+
+			/// Byte position; at a marker once the entropy data ran out
+			size_t GetPosition() const { return position_; }
+
+		private:
+			void Consume(int count)
+			{
+				bits_ <<= count;
+				count_ -= count;
+			}
+
+		private:
+			const uint8_t* data_;
+			size_t length_;
+			size_t position_;
+			uint64_t bits_;       // Left aligned
+			int count_;
+			int padding_;         // Zero bits appended after the data ran out
+			bool marker_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CodecRegistry.h"
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// JPEG Lossless, Non-Hierarchical (Process 14) decoder
+		///
+		/// Handles the JPEG Lossless (1.2.840.10008.1.2.4.57) and First-Order
+		/// Prediction SV1 (1.2.840.10008.1.2.4.70) syntaxes: SOF3 frames of 2 to
+		/// 16-bit precision, predictors 1-7, point transform, restart intervals
+		/// and interleaved or per-component scans. Huffman codes are resolved
+		/// through JpegHuffmanTable lookups.
+		class JpegLosslessDecoder : public PixelDecoder
+		{
+		public:
+			const char* GetName() const override { return "JPEG Lossless"; }
+			uint32_t GetCapabilities() const override { return CodecLossless | CodecMultiFrameParallel; }
+
+			bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const override;
+		};
+
+	} // namespace dicom
+} // namespace medvision
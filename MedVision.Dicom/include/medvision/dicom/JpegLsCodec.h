@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CodecRegistry.h"
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// JPEG-LS (1.2.840.10008.1.2.4.80 / .81) decoder
+		///
+		/// Decodes ITU-T T.87 frames of 2 to 16-bit precision, lossless or
+		/// near-lossless (NEAR > 0), with any interleave mode (per component,
+		/// line or sample), preset coding parameters from LSE segments and
+		/// restart intervals. Gradients are quantized through a per-scan lookup
+		/// table into the 365 regular contexts; flat areas are decoded in run
+		/// mode. Rejects mapping tables (palettized streams), point transforms
+		/// and subsampled components.
+		class JpegLsDecoder : public PixelDecoder
+		{
+		public:
+			/// lossless selects the capabilities reported for the transfer syntax
+			explicit JpegLsDecoder(bool lossless) : lossless_(lossless) {}
+
+			const char* GetName() const override { return "JPEG-LS"; }
+			uint32_t GetCapabilities() const override
+			{
+				return (lossless_ ? CodecLossless : CodecLossy) | CodecMultiFrameParallel;
+			}
+
+			bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const override;
+
+		private:
+			bool lossless_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
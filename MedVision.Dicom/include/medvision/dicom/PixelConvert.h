@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Where the stored bits of a sample sit in its container
+		/// (BitsStored, HighBit and PixelRepresentation), plus pixel padding
+		struct SampleLayout
+		{
+			uint16_t bitsStored;    // 0 (or inconsistent with highBit): the whole container
+			uint16_t highBit;
+			bool isSigned;          // Two's complement in bitsStored bits
+			bool bigEndian;         // Most significant byte first (Explicit VR Big Endian)
+
+			// Stored values from paddingValue to paddingLimit (in either order,
+			// compared after unpacking) are written as paddingOutput
+			bool hasPadding;
+			int32_t paddingValue;
+			int32_t paddingLimit;
+			float paddingOutput;
+
+			SampleLayout();
+			SampleLayout(uint16_t bitsStoredValue, uint16_t highBitValue, bool isSignedValue);
+		};
+
+		/// IEEE 754 binary16 value, stored as its bit pattern
+		struct Half
+		{
+			uint16_t bits;
+		};
+
+		/// Conversion of stored pixel samples to rescaled float values
+		///
+		/// Each sample is unpacked (shifted down from highBit, masked to
+		/// bitsStored bits so overlay bits above are dropped, and sign
+		/// extended) and written as static_cast<float>(value * slope + intercept)
+		/// evaluated in double precision, bit for bit on every code path. The
+		/// kernel (AVX-512, AVX2, SSE2 or scalar) is chosen once from
+		/// CpuFeatures. A slope of 1 with an integral intercept runs in exact
+		/// integer arithmetic instead of double precision (8 and 16-bit samples).
+		/// FromFloat narrows converted values to compact storage types.
+		class PixelConvert
+		{
+		public:
+			static void ToFloat(const uint8_t* input, size_t count, const SampleLayout& layout,
+				double slope, double intercept, float* output);
+			static void ToFloat(const uint16_t* input, size_t count, const SampleLayout& layout,
+				double slope, double intercept, float* output);
+			static void ToFloat(const uint32_t* input, size_t count, const SampleLayout& layout,
+				double slope, double intercept, float* output);
+
+			/// Raw sample bytes with no alignment requirement: bitsAllocated is 8, 16 or 32
+			static void ToFloat(const uint8_t* bytes, size_t count, uint16_t bitsAllocated, const SampleLayout& layout,
+				double slope, double intercept, float* output);
+
+			/// Float and Double Float Pixel Data, rescaled the same way
+			static void ToFloat(const float* input, size_t count, double slope, double intercept, float* output);
+			static void ToFloat(const double* input, size_t count, double slope, double intercept, float* output);
+
+			/// Float (bitsAllocated 32) or Double Float (64) Pixel Data as raw bytes
+			/// with no alignment requirement
+			static void RealToFloat(const uint8_t* bytes, size_t count, uint16_t bitsAllocated,
+				double slope, double intercept, float* output);
+
+			/// Whole-container samples without padding
+			static void ToFloat(const uint8_t* input, size_t count, double slope, double intercept, float* output);
+			static void ToFloat(const uint16_t* input, size_t count, double slope, double intercept, float* output);
+			static void ToFloat(const int16_t* input, size_t count, double slope, double intercept, float* output);
+			static void ToFloat(const uint32_t* input, size_t count, double slope, double intercept, float* output);
+			static void ToFloat(const int32_t* input, size_t count, double slope, double intercept, float* output);
+
+			/// Narrow float values: integers are rounded to nearest (ties to even)
+			/// and saturated, NaN giving the lowest value; Half rounds to nearest
+			/// even, overflowing to infinity, exactly as F16C does
+			static void FromFloat(const float* input, size_t count, int16_t* output);
+			static void FromFloat(const float* input, size_t count, uint16_t* output);
+			static void FromFloat(const float* input, size_t count, Half* output);
+
+			/// Exact widening of a Half (NaNs come back quiet, as with F16C)
+			static float HalfToFloat(Half value);
+
+			/// Smallest and largest unpacked value of layout in a container of bitsAllocated bits
+			static void GetStoredRange(const SampleLayout& layout, uint16_t bitsAllocated, int64_t& minimum, int64_t& maximum);
+
+			/// Instruction set of the selected kernels: "AVX-512", "AVX2", "SSE2" or "Scalar"
+			static const char* GetKernelName();
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "FileHandle.h"
+#include "VR.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Supplies the PixelData (7FE0,0010) value to DicomWriter::WriteFile
+		/// without the payload being held in the DicomDataSet
+		class PixelDataSource
+		{
+		public:
+			virtual ~PixelDataSource() {}
+
+			/// Total value length in bytes (an odd length is padded by the writer)
+			virtual uint64_t GetLength() const = 0;
+
+			/// VR of the PixelData element (OW for >8 bit data, OB otherwise)
+			virtual VR GetVR() const = 0;
+
+			/// Append exactly GetLength() bytes to the output file
+			virtual bool WriteTo(FileHandle& output) = 0;
+
+			/// Error detail if WriteTo failed
+			const std::string& GetLastError() const { return lastError_; }
+
+		protected:
+			std::string lastError_;
+		};
+
+		/// Pulls pixel data frame by frame from a callback into one reusable frame buffer
+		class CallbackPixelDataSource : public PixelDataSource
+		{
+		public:
+			/// Fill buffer (frameLength bytes) with frame frameIndex; return false to abort
+			using FrameCallback = std::function<bool(uint32_t frameIndex, uint8_t* buffer, size_t frameLength)>;
+
+			CallbackPixelDataSource(uint32_t frameCount, size_t frameLength, FrameCallback callback, VR vr = VR::OW);
+
+			uint64_t GetLength() const override { return static_cast<uint64_t>(frameCount_) * frameLength_; }
+			VR GetVR() const override { return vr_; }
+			bool WriteTo(FileHandle& output) override;
+
+		private:
+			uint32_t frameCount_;
+			size_t frameLength_;
+			FrameCallback callback_;
+			VR vr_;
+			std::vector<uint8_t> frameBuffer_;
+		};
+
+		/// Copies pixel data from a byte range of another file
+		/// (copy_file_range/sendfile where the platform supports it)
+		class FilePixelDataSource : public PixelDataSource
+		{
+		public:
+			/// Open filePath and use length bytes starting at offset
+			FilePixelDataSource(const std::string& filePath, uint64_t offset, uint64_t length, VR vr = VR::OW);
+
+			/// Use an already open descriptor; the caller keeps ownership
+			FilePixelDataSource(int descriptor, uint64_t offset, uint64_t length, VR vr = VR::OW);
+
+			bool IsOpen() const { return descriptor_ >= 0; }
+
+			uint64_t GetLength() const override { return length_; }
+			VR GetVR() const override { return vr_; }
+			bool WriteTo(FileHandle& output) override;
+
+		private:
+			FileHandle ownedFile_;
+			int descriptor_;
+			uint64_t offset_;
+			uint64_t length_;
+			VR vr_;
+		};
+
+		/// Writes pixel data straight from a caller-owned memory region, such as a
+		/// memory-mapped file, without copying it
+		class MemoryPixelDataSource : public PixelDataSource
+		{
+		public:
+			MemoryPixelDataSource(const uint8_t* data, uint64_t length, VR vr = VR::OW);
+
+			uint64_t GetLength() const override { return length_; }
+			VR GetVR() const override { return vr_; }
+			bool WriteTo(FileHandle& output) override;
+
+		private:
+			const uint8_t* data_;
+			uint64_t length_;
+			VR vr_;
+		};
+
+		/// Supplies compressed frames for an encapsulated PixelData value written
+		/// by DicomWriter::WriteFile, one frame at a time and in order
+		class EncapsulatedFrameSource
+		{
+		public:
+			/// Replace frame with the compressed bytes of frame frameIndex; return false to abort
+			using FrameCallback = std::function<bool(uint32_t frameIndex, std::vector<uint8_t>& frame)>;
+
+			EncapsulatedFrameSource(uint32_t frameCount, FrameCallback callback)
+				: frameCount_(frameCount)
+				, callback_(std::move(callback))
+			{
+			}
+
+			uint32_t GetFrameCount() const { return frameCount_; }
+			bool GetFrame(uint32_t frameIndex, std::vector<uint8_t>& frame) { return callback_(frameIndex, frame); }
+
+		private:
+			uint32_t frameCount_;
+			FrameCallback callback_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CodecRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// RLE Lossless (PS3.5 Annex G) decoder
+		///
+		/// Each frame holds one PackBits segment per byte plane (most significant
+		/// byte first, one sample after another). Segments are expanded with bulk
+		/// copies/fills and interleaved back into little endian samples; the
+		/// 16-bit and 8-bit RGB cases use SSE2/SSSE3 shuffles.
+		class RleDecoder : public PixelDecoder
+		{
+		public:
+			const char* GetName() const override { return "RLE Lossless"; }
+			uint32_t GetCapabilities() const override { return CodecLossless | CodecMultiFrameParallel; }
+
+			bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const override;
+
+			/// Expand one PackBits segment into exactly outputLength bytes
+			/// (surplus decoded bytes, e.g. row padding, are ignored)
+			static bool DecodeSegment(const uint8_t* data, size_t length, uint8_t* output, size_t outputLength);
+		};
+
+		/// RLE Lossless (1.2.840.10008.1.2.5) encoder
+		///
+		/// Splits the frame into byte planes (SSE2 for 16-bit samples) and
+		/// PackBits-encodes each row, finding run boundaries 16 bytes at a time.
+		/// Accepts either planar configuration.
+		class RleEncoder : public PixelEncoder
+		{
+		public:
+			const char* GetName() const override { return "RLE Lossless"; }
+			uint32_t GetCapabilities() const override { return CodecLossless | CodecMultiFrameParallel; }
+
+			bool EncodeFrame(const uint8_t* pixels, const FrameInfo& info,
+				std::vector<uint8_t>& output, std::string& error) const override;
+
+			/// PackBits-encode length bytes (one row) at output; returns the bytes written,
+			/// at most length + (length + 127) / 128
+			static size_t EncodeRow(const uint8_t* data, size_t length, uint8_t* output);
+		};
+
+	} // namespace dicom
+} // namespace medvision
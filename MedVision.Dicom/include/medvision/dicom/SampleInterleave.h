@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Conversions between byte planes and interleaved samples used by the codecs
+		/// (SSE2, plus SSSE3 when the CPU has it; scalar elsewhere)
+		class SampleInterleave
+		{
+		public:
+			/// High and low byte planes into little endian 16-bit samples
+			static void Interleave16(const uint8_t* high, const uint8_t* low, uint8_t* output, size_t count);
+
+			/// Little endian 16-bit samples into high and low byte planes
+			static void Split16(const uint8_t* input, uint8_t* high, uint8_t* low, size_t count);
+
+			/// Three 8-bit planes into RGB triplets
+			static void InterleaveRgb(const uint8_t* red, const uint8_t* green, const uint8_t* blue, uint8_t* output, size_t count);
+		};
+
+	} // namespace dicom
+} // namespace medvision
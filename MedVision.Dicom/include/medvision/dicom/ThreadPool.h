@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Fixed-size worker pool shared by the batch writers and codecs
+		class ThreadPool
+		{
+		public:
+			/// threadCount 0 = one worker per hardware thread
+			explicit ThreadPool(size_t threadCount = 0);
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+			size_t GetThreadCount() const { return workers_.size(); }
+
+			/// Queue a task for execution on a worker thread
+			void Submit(std::function<void()> task);
+
+			/// Block until every task submitted so far has finished
+			void Wait();
+
+			/// Run fn(i) for every i in [0, count) on the workers and the calling
+			/// thread; returns once all calls have completed. Safe to nest: the
+			/// caller keeps claiming indices itself, so it never waits on a queue.
+			void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+			/// Process-wide pool sized to the hardware
+			static ThreadPool& Shared();
+
+		private:
+			void WorkerLoop();
+
+		private:
+			std::vector<std::thread> workers_;
+			std::deque<std::function<void()>> tasks_;
+			std::mutex mutex_;
+			std::condition_variable taskAvailable_;
+			std::condition_variable allDone_;
+			size_t activeTasks_;
+			bool stopping_;
+		};
+
+	} // namespace dicom
+} // namespace medvision
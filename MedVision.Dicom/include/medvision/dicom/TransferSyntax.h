@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace medvision
@@ -7,6 +8,9 @@ namespace medvision
 	namespace dicom
 	{
 
+		/// Interned transfer syntax UID; compare ids instead of UID strings
+		typedef uint32_t TransferSyntaxId;
+
 		/// DICOM Transfer Syntax identifiers and utilities
 		class TransferSyntax
 		{
@@ -17,11 +21,16 @@ namespace medvision
 			// Explicit VR
 			static const std::string ExplicitVRLittleEndian;  // 1.2.840.10008.1.2.1
 			static const std::string ExplicitVRBigEndian;     // 1.2.840.10008.1.2.2 (retired)
+			static const std::string DeflatedExplicitVRLittleEndian; // 1.2.840.10008.1.2.1.99
 
 			// Compressed (not implemented initially)
 			static const std::string JPEGBaseline;            // 1.2.840.10008.1.2.4.50
 			static const std::string JPEGLossless;            // 1.2.840.10008.1.2.4.57
+			static const std::string JPEGLosslessSV1;         // 1.2.840.10008.1.2.4.70
+			static const std::string JPEGLSLossless;          // 1.2.840.10008.1.2.4.80
+			static const std::string JPEGLSNearLossless;      // 1.2.840.10008.1.2.4.81
 			static const std::string JPEG2000Lossless;        // 1.2.840.10008.1.2.4.90
+			static const std::string JPEG2000;                // 1.2.840.10008.1.2.4.91
 			static const std::string RLELossless;             // 1.2.840.10008.1.2.5
 
 			/// Check if transfer syntax uses explicit VR
@@ -33,8 +42,22 @@ namespace medvision
 			/// Check if transfer syntax uses compression
 			static bool IsCompressed(const std::string& uid);
 
+			/// Check if the dataset after the meta information is deflated
+			/// (the pixel data itself stays native)
+			static bool IsDeflated(const std::string& uid);
+
 			/// Get human-readable name for transfer syntax
 			static std::string GetName(const std::string& uid);
+
+			/// Id 0 stands for "no transfer syntax" (empty UID)
+			static const TransferSyntaxId InvalidId = 0;
+
+			/// Map a UID to a small process-wide id (thread-safe). The same UID
+			/// always yields the same id, so hot paths can compare integers.
+			static TransferSyntaxId Intern(const std::string& uid);
+
+			/// UID for an id returned by Intern (empty for unknown ids)
+			static const std::string& GetUID(TransferSyntaxId id);
 		};
 
 	} // namespace dicom
@@ -39,6 +39,7 @@ namespace medvision
 			OD,  // Other Double
 			OF,  // Other Float
 			OL,  // Other Long
+			OV,  // Other Very Long
 			OW,  // Other Word
 			SL,  // Signed Long
 			SS,  // Signed Short
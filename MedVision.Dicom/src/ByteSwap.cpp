@@ -0,0 +1,176 @@
+#include "medvision/dicom/ByteSwap.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MEDVISION_BYTESWAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			inline uint16_t Reverse16(uint16_t value)
+			{
+				return static_cast<uint16_t>((value << 8) | (value >> 8));
+			}
+
+			inline uint32_t Reverse32(uint32_t value)
+			{
+				return ((value & 0x000000FFu) << 24) |
+					((value & 0x0000FF00u) << 8) |
+					((value & 0x00FF0000u) >> 8) |
+					((value & 0xFF000000u) >> 24);
+			}
+
+			inline uint64_t Reverse64(uint64_t value)
+			{
+				return (static_cast<uint64_t>(Reverse32(static_cast<uint32_t>(value))) << 32) |
+					Reverse32(static_cast<uint32_t>(value >> 32));
+			}
+
+			// Scalar tails; memcpy keeps unaligned access well defined
+			template <typename T, T (*Reverse)(T)>
+			void CopyScalar(uint8_t* destination, const uint8_t* source, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					T value;
+					std::memcpy(&value, source + i * sizeof(T), sizeof(T));
+					value = Reverse(value);
+					std::memcpy(destination + i * sizeof(T), &value, sizeof(T));
+				}
+			}
+
+#ifdef MEDVISION_BYTESWAP_SSE2
+			inline __m128i SwapBytesInWords(__m128i v)
+			{
+				return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			}
+
+			inline __m128i SwapDwords(__m128i v)
+			{
+				v = _mm_shufflelo_epi16(v, 0xB1);
+				v = _mm_shufflehi_epi16(v, 0xB1);
+				return SwapBytesInWords(v);
+			}
+
+			inline __m128i SwapQwords(__m128i v)
+			{
+				v = _mm_shufflelo_epi16(v, 0x1B);
+				v = _mm_shufflehi_epi16(v, 0x1B);
+				return SwapBytesInWords(v);
+			}
+
+			// Processes 32 bytes per iteration; returns the number of bytes handled
+			template <__m128i (*Kernel)(__m128i)>
+			size_t CopyVector(uint8_t* destination, const uint8_t* source, size_t bytes)
+			{
+				size_t offset = 0;
+				for (; offset + 32 <= bytes; offset += 32)
+				{
+					__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset));
+					__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset + 16));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset), Kernel(a));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset + 16), Kernel(b));
+				}
+				if (offset + 16 <= bytes)
+				{
+					__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset), Kernel(a));
+					offset += 16;
+				}
+				return offset;
+			}
+#endif
+		}
+
+		void ByteSwap::Swap16(uint8_t* data, size_t count)
+		{
+			Copy16(data, data, count);
+		}
+
+		void ByteSwap::Swap32(uint8_t* data, size_t count)
+		{
+			Copy32(data, data, count);
+		}
+
+		void ByteSwap::Swap64(uint8_t* data, size_t count)
+		{
+			Copy64(data, data, count);
+		}
+
+		// The copy kernels also serve the in-place swaps: each block is loaded
+		// before it is stored, so destination == source is safe
+		void ByteSwap::Copy16(uint8_t* destination, const uint8_t* source, size_t count)
+		{
+			size_t done = 0;
+#ifdef MEDVISION_BYTESWAP_SSE2
+			done = CopyVector<SwapBytesInWords>(destination, source, count * 2);
+#endif
+			CopyScalar<uint16_t, Reverse16>(destination + done, source + done, count - done / 2);
+		}
+
+		void ByteSwap::Copy32(uint8_t* destination, const uint8_t* source, size_t count)
+		{
+			size_t done = 0;
+#ifdef MEDVISION_BYTESWAP_SSE2
+			done = CopyVector<SwapDwords>(destination, source, count * 4);
+#endif
+			CopyScalar<uint32_t, Reverse32>(destination + done, source + done, count - done / 4);
+		}
+
+		void ByteSwap::Copy64(uint8_t* destination, const uint8_t* source, size_t count)
+		{
+			size_t done = 0;
+#ifdef MEDVISION_BYTESWAP_SSE2
+			done = CopyVector<SwapQwords>(destination, source, count * 8);
+#endif
+			CopyScalar<uint64_t, Reverse64>(destination + done, source + done, count - done / 8);
+		}
+
+		size_t ByteSwap::GetSwapUnit(VR vr)
+		{
+			switch (vr)
+			{
+			case VR::US: case VR::SS: case VR::OW: case VR::AT:
+				return 2;
+			case VR::UL: case VR::SL: case VR::FL: case VR::OF: case VR::OL:
+				return 4;
+			case VR::FD: case VR::OD: case VR::OV: case VR::SV: case VR::UV:
+				return 8;
+			default:
+				return 0;
+			}
+		}
+
+		void ByteSwap::SwapValue(VR vr, uint8_t* data, size_t length)
+		{
+			CopySwappedValue(vr, data, data, length);
+		}
+
+		void ByteSwap::CopySwappedValue(VR vr, uint8_t* destination, const uint8_t* source, size_t length)
+		{
+			size_t unit = GetSwapUnit(vr);
+			size_t swapped = (unit == 0) ? 0 : (length / unit) * unit;
+
+			switch (unit)
+			{
+			case 2: Copy16(destination, source, length / 2); break;
+			case 4: Copy32(destination, source, length / 4); break;
+			case 8: Copy64(destination, source, length / 8); break;
+			default: break;
+			}
+
+			// Byte data and any malformed trailing bytes are copied unchanged
+			if (destination != source && swapped < length)
+			{
+				std::memcpy(destination + swapped, source + swapped, length - swapped);
+			}
+		}
+
+	} // namespace dicom
+} // namespace medvision
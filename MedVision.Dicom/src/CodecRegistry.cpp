@@ -0,0 +1,109 @@
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/Jpeg2000Codec.h"
+#include "medvision/dicom/JpegBaselineCodec.h"
+#include "medvision/dicom/JpegLosslessCodec.h"
+#include "medvision/dicom/JpegLsCodec.h"
+#include "medvision/dicom/RleCodec.h"
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		FrameInfo::FrameInfo()
+			: rows(0)
+			, columns(0)
+			, samplesPerPixel(1)
+			, bitsAllocated(0)
+			, bitsStored(0)
+			, pixelRepresentation(0)
+			, planarConfiguration(0)
+		{
+		}
+
+		size_t FrameInfo::GetFrameLength() const
+		{
+			return static_cast<size_t>(rows) * columns * samplesPerPixel * ((bitsAllocated + 7) / 8);
+		}
+
+		FrameInfo FrameInfo::Reduce(uint32_t reduction) const
+		{
+			FrameInfo reduced(*this);
+			if (reduction > 16)
+			{
+				reduction = 16;
+			}
+			uint32_t scale = 1u << reduction;
+			reduced.rows = static_cast<uint16_t>((rows + scale - 1) >> reduction);
+			reduced.columns = static_cast<uint16_t>((columns + scale - 1) >> reduction);
+			return reduced;
+		}
+
+		CodecRegistry::CodecRegistry()
+		{
+			// Built-in codecs; applications may replace them with RegisterDecoder/RegisterEncoder
+			RegisterDecoder(TransferSyntax::RLELossless, std::make_shared<RleDecoder>());
+			RegisterEncoder(TransferSyntax::RLELossless, std::make_shared<RleEncoder>());
+
+			std::shared_ptr<const PixelDecoder> jpegLossless = std::make_shared<JpegLosslessDecoder>();
+			RegisterDecoder(TransferSyntax::JPEGLossless, jpegLossless);
+			RegisterDecoder(TransferSyntax::JPEGLosslessSV1, jpegLossless);
+			RegisterDecoder(TransferSyntax::JPEGBaseline, std::make_shared<JpegBaselineDecoder>());
+			RegisterDecoder(TransferSyntax::JPEG2000Lossless, std::make_shared<Jpeg2000Decoder>(true));
+			RegisterDecoder(TransferSyntax::JPEG2000, std::make_shared<Jpeg2000Decoder>(false));
+			RegisterDecoder(TransferSyntax::JPEGLSLossless, std::make_shared<JpegLsDecoder>(true));
+			RegisterDecoder(TransferSyntax::JPEGLSNearLossless, std::make_shared<JpegLsDecoder>(false));
+		}
+
+		CodecRegistry& CodecRegistry::Instance()
+		{
+			static CodecRegistry registry;
+			return registry;
+		}
+
+		void CodecRegistry::RegisterDecoder(const std::string& transferSyntaxUID, std::shared_ptr<const PixelDecoder> decoder)
+		{
+			TransferSyntaxId id = TransferSyntax::Intern(transferSyntaxUID);
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (decoders_.size() <= id)
+			{
+				decoders_.resize(id + 1);
+			}
+			decoders_[id] = decoder;
+		}
+
+		void CodecRegistry::RegisterEncoder(const std::string& transferSyntaxUID, std::shared_ptr<const PixelEncoder> encoder)
+		{
+			TransferSyntaxId id = TransferSyntax::Intern(transferSyntaxUID);
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (encoders_.size() <= id)
+			{
+				encoders_.resize(id + 1);
+			}
+			encoders_[id] = encoder;
+		}
+
+		std::shared_ptr<const PixelDecoder> CodecRegistry::FindDecoder(TransferSyntaxId id) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return id < decoders_.size() ? decoders_[id] : nullptr;
+		}
+
+		std::shared_ptr<const PixelDecoder> CodecRegistry::FindDecoder(const std::string& transferSyntaxUID) const
+		{
+			return FindDecoder(TransferSyntax::Intern(transferSyntaxUID));
+		}
+
+		std::shared_ptr<const PixelEncoder> CodecRegistry::FindEncoder(TransferSyntaxId id) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return id < encoders_.size() ? encoders_[id] : nullptr;
+		}
+
+		std::shared_ptr<const PixelEncoder> CodecRegistry::FindEncoder(const std::string& transferSyntaxUID) const
+		{
+			return FindEncoder(TransferSyntax::Intern(transferSyntaxUID));
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,543 @@
+#include "medvision/dicom/ColorConvert.h"
+#include "medvision/dicom/CpuFeatures.h"
+#include <cstring>
+
+#ifdef MEDVISION_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			// Full-range YCbCr to RGB in 14-bit fixed point (as in the JPEG decoder)
+			const int kCrToR = 22970;    // 1.402
+			const int kCbToG = -5638;    // -0.344136
+			const int kCrToG = -11700;   // -0.714136
+			const int kCbToB = 29032;    // 1.772
+
+			uint8_t Saturate(int value)
+			{
+				return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+			}
+
+			void StorePixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t* rgba)
+			{
+				rgba[0] = red;
+				rgba[1] = green;
+				rgba[2] = blue;
+				rgba[3] = 255;
+			}
+
+			void StoreYbrPixel(int luma, int blue, int red, uint8_t* rgba)
+			{
+				int blueDiff = blue - 128;
+				int redDiff = red - 128;
+				StorePixel(Saturate(luma + ((kCrToR * redDiff + (1 << 13)) >> 14)),
+					Saturate(luma + ((kCbToG * blueDiff + kCrToG * redDiff + (1 << 13)) >> 14)),
+					Saturate(luma + ((kCbToB * blueDiff + (1 << 13)) >> 14)),
+					rgba);
+			}
+
+			/// Kernels convert a multiple of their step and return the pixels done;
+			/// the scalar code finishes the rest
+			using InterleavedKernel = size_t(*)(const uint8_t*, size_t, uint8_t*);
+			using PlanarKernel = size_t(*)(const uint8_t*, const uint8_t*, const uint8_t*, size_t, uint8_t*);
+
+			size_t InterleavedNone(const uint8_t*, size_t, uint8_t*)
+			{
+				return 0;
+			}
+
+			size_t PlanarNone(const uint8_t*, const uint8_t*, const uint8_t*, size_t, uint8_t*)
+			{
+				return 0;
+			}
+
+#ifdef MEDVISION_X86
+			/// 16 pixels of 8-bit R, G and B into 64 bytes of RGBA
+			inline void StoreRgba16(__m128i red, __m128i green, __m128i blue, uint8_t* rgba)
+			{
+				const __m128i alpha = _mm_set1_epi8(-1);
+				__m128i redGreenLow = _mm_unpacklo_epi8(red, green);
+				__m128i redGreenHigh = _mm_unpackhi_epi8(red, green);
+				__m128i blueAlphaLow = _mm_unpacklo_epi8(blue, alpha);
+				__m128i blueAlphaHigh = _mm_unpackhi_epi8(blue, alpha);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(rgba), _mm_unpacklo_epi16(redGreenLow, blueAlphaLow));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + 16), _mm_unpackhi_epi16(redGreenLow, blueAlphaLow));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + 32), _mm_unpacklo_epi16(redGreenHigh, blueAlphaHigh));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + 48), _mm_unpackhi_epi16(redGreenHigh, blueAlphaHigh));
+			}
+
+			/// YBR_FULL to RGB for 16 pixels, rounding exactly as StoreYbrPixel
+			inline void YbrToRgb16(__m128i luma, __m128i blue, __m128i red, __m128i (&rgb)[3])
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i center = _mm_set1_epi16(128);
+				const __m128i round = _mm_set1_epi32(1 << 13);
+				const __m128i weights[3] = {
+					_mm_setr_epi16(0, kCrToR, 0, kCrToR, 0, kCrToR, 0, kCrToR),
+					_mm_setr_epi16(kCbToG, kCrToG, kCbToG, kCrToG, kCbToG, kCrToG, kCbToG, kCrToG),
+					_mm_setr_epi16(kCbToB, 0, kCbToB, 0, kCbToB, 0, kCbToB, 0),
+				};
+
+				__m128i lumaHalves[2] = { _mm_unpacklo_epi8(luma, zero), _mm_unpackhi_epi8(luma, zero) };
+				__m128i blueHalves[2] = { _mm_sub_epi16(_mm_unpacklo_epi8(blue, zero), center), _mm_sub_epi16(_mm_unpackhi_epi8(blue, zero), center) };
+				__m128i redHalves[2] = { _mm_sub_epi16(_mm_unpacklo_epi8(red, zero), center), _mm_sub_epi16(_mm_unpackhi_epi8(red, zero), center) };
+
+				__m128i values[3][2];
+				for (int half = 0; half < 2; ++half)
+				{
+					__m128i pairsLow = _mm_unpacklo_epi16(blueHalves[half], redHalves[half]);
+					__m128i pairsHigh = _mm_unpackhi_epi16(blueHalves[half], redHalves[half]);
+					for (int channel = 0; channel < 3; ++channel)
+					{
+						__m128i low = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(pairsLow, weights[channel]), round), 14);
+						__m128i high = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(pairsHigh, weights[channel]), round), 14);
+						values[channel][half] = _mm_add_epi16(lumaHalves[half], _mm_packs_epi32(low, high));
+					}
+				}
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					rgb[channel] = _mm_packus_epi16(values[channel][0], values[channel][1]);
+				}
+			}
+
+			/// 48 bytes of interleaved triplets into three planes of 16 bytes
+			MEDVISION_TARGET("ssse3")
+			inline void Deinterleave3(const uint8_t* input, __m128i (&planes)[3])
+			{
+				__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+				__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 16));
+				__m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 32));
+
+				planes[0] = _mm_or_si128(_mm_or_si128(
+					_mm_shuffle_epi8(in0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+					_mm_shuffle_epi8(in1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+					_mm_shuffle_epi8(in2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+				planes[1] = _mm_or_si128(_mm_or_si128(
+					_mm_shuffle_epi8(in0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+					_mm_shuffle_epi8(in1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+					_mm_shuffle_epi8(in2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+				planes[2] = _mm_or_si128(_mm_or_si128(
+					_mm_shuffle_epi8(in0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+					_mm_shuffle_epi8(in1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+					_mm_shuffle_epi8(in2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+			}
+
+			// RGB triplets widen in place: each 12 source bytes become 4 pixels
+			MEDVISION_TARGET("ssse3")
+			size_t RgbSsse3(const uint8_t* rgb, size_t count, uint8_t* rgba)
+			{
+				const __m128i widen = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+				const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					const uint8_t* source = rgb + i * 3;
+					__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+					__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16));
+					__m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32));
+
+					__m128i groups[4] = { in0, _mm_alignr_epi8(in1, in0, 12), _mm_alignr_epi8(in2, in1, 8), _mm_srli_si128(in2, 4) };
+					for (int group = 0; group < 4; ++group)
+					{
+						__m128i pixels = _mm_or_si128(_mm_shuffle_epi8(groups[group], widen), alpha);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4 + group * 16), pixels);
+					}
+				}
+				return i;
+			}
+
+			MEDVISION_TARGET("ssse3")
+			size_t PlanarRgbSsse3(const uint8_t* red, const uint8_t* green, const uint8_t* blue, size_t count, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					StoreRgba16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(red + i)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(green + i)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(blue + i)),
+						rgba + i * 4);
+				}
+				return i;
+			}
+
+			MEDVISION_TARGET("ssse3")
+			size_t YbrSsse3(const uint8_t* ybr, size_t count, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					__m128i planes[3];
+					__m128i rgb[3];
+					Deinterleave3(ybr + i * 3, planes);
+					YbrToRgb16(planes[0], planes[1], planes[2], rgb);
+					StoreRgba16(rgb[0], rgb[1], rgb[2], rgba + i * 4);
+				}
+				return i;
+			}
+
+			MEDVISION_TARGET("ssse3")
+			size_t PlanarYbrSsse3(const uint8_t* luma, const uint8_t* blue, const uint8_t* red, size_t count, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					__m128i rgb[3];
+					YbrToRgb16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(luma + i)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(blue + i)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(red + i)),
+						rgb);
+					StoreRgba16(rgb[0], rgb[1], rgb[2], rgba + i * 4);
+				}
+				return i;
+			}
+
+			/// 32 bytes of Y0 Y1 Cb Cr groups into 16 pixels of Y, Cb and Cr:
+			/// luma is gathered and chroma duplicated for both pixels of a pair
+			MEDVISION_TARGET("ssse3")
+			inline void Unpack422(const uint8_t* input, __m128i (&planes)[3])
+			{
+				const __m128i lumaBlue = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 2, 6, 6, 10, 10, 14, 14);
+				const __m128i red = _mm_setr_epi8(3, 3, 7, 7, 11, 11, 15, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+				__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+				__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 16));
+				__m128i first = _mm_shuffle_epi8(in0, lumaBlue);
+				__m128i second = _mm_shuffle_epi8(in1, lumaBlue);
+				planes[0] = _mm_unpacklo_epi64(first, second);
+				planes[1] = _mm_unpackhi_epi64(first, second);
+				planes[2] = _mm_unpacklo_epi64(_mm_shuffle_epi8(in0, red), _mm_shuffle_epi8(in1, red));
+			}
+
+			MEDVISION_TARGET("ssse3")
+			size_t Ybr422Ssse3(const uint8_t* ybr, size_t count, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					__m128i planes[3];
+					__m128i rgb[3];
+					Unpack422(ybr + i * 2, planes);
+					YbrToRgb16(planes[0], planes[1], planes[2], rgb);
+					StoreRgba16(rgb[0], rgb[1], rgb[2], rgba + i * 4);
+				}
+				return i;
+			}
+
+			/// AVX2 versions of YbrToRgb16 and StoreRgba16 for 32 pixels. Unpack and
+			/// pack work within 128-bit lanes, so the channels come out in input
+			/// order and only the RGBA stores need a cross-lane permute.
+			MEDVISION_TARGET("avx2")
+			inline void YbrToRgb32(__m256i luma, __m256i blue, __m256i red, __m256i (&rgb)[3])
+			{
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i center = _mm256_set1_epi16(128);
+				const __m256i round = _mm256_set1_epi32(1 << 13);
+				const __m256i weights[3] = {
+					_mm256_set1_epi32(static_cast<int32_t>(static_cast<uint32_t>(kCrToR) << 16)),
+					_mm256_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(kCrToG) << 16) | static_cast<uint16_t>(kCbToG))),
+					_mm256_set1_epi32(kCbToB),
+				};
+
+				__m256i lumaHalves[2] = { _mm256_unpacklo_epi8(luma, zero), _mm256_unpackhi_epi8(luma, zero) };
+				__m256i blueHalves[2] = { _mm256_sub_epi16(_mm256_unpacklo_epi8(blue, zero), center), _mm256_sub_epi16(_mm256_unpackhi_epi8(blue, zero), center) };
+				__m256i redHalves[2] = { _mm256_sub_epi16(_mm256_unpacklo_epi8(red, zero), center), _mm256_sub_epi16(_mm256_unpackhi_epi8(red, zero), center) };
+
+				__m256i values[3][2];
+				for (int half = 0; half < 2; ++half)
+				{
+					__m256i pairsLow = _mm256_unpacklo_epi16(blueHalves[half], redHalves[half]);
+					__m256i pairsHigh = _mm256_unpackhi_epi16(blueHalves[half], redHalves[half]);
+					for (int channel = 0; channel < 3; ++channel)
+					{
+						__m256i low = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(pairsLow, weights[channel]), round), 14);
+						__m256i high = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(pairsHigh, weights[channel]), round), 14);
+						values[channel][half] = _mm256_add_epi16(lumaHalves[half], _mm256_packs_epi32(low, high));
+					}
+				}
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					rgb[channel] = _mm256_packus_epi16(values[channel][0], values[channel][1]);
+				}
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline void StoreRgba32(const __m256i (&rgb)[3], uint8_t* rgba)
+			{
+				const __m256i alpha = _mm256_set1_epi8(-1);
+				__m256i redGreenLow = _mm256_unpacklo_epi8(rgb[0], rgb[1]);
+				__m256i redGreenHigh = _mm256_unpackhi_epi8(rgb[0], rgb[1]);
+				__m256i blueAlphaLow = _mm256_unpacklo_epi8(rgb[2], alpha);
+				__m256i blueAlphaHigh = _mm256_unpackhi_epi8(rgb[2], alpha);
+
+				// Pixels 0-3 | 16-19, 4-7 | 20-23, 8-11 | 24-27 and 12-15 | 28-31
+				__m256i first = _mm256_unpacklo_epi16(redGreenLow, blueAlphaLow);
+				__m256i second = _mm256_unpackhi_epi16(redGreenLow, blueAlphaLow);
+				__m256i third = _mm256_unpacklo_epi16(redGreenHigh, blueAlphaHigh);
+				__m256i fourth = _mm256_unpackhi_epi16(redGreenHigh, blueAlphaHigh);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba), _mm256_permute2x128_si256(first, second, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + 32), _mm256_permute2x128_si256(third, fourth, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + 64), _mm256_permute2x128_si256(first, second, 0x31));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + 96), _mm256_permute2x128_si256(third, fourth, 0x31));
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline __m256i Combine(__m128i low, __m128i high)
+			{
+				return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+			}
+
+			// The AVX2 kernels finish a remaining 16-pixel step with SSSE3
+			MEDVISION_TARGET("avx2")
+			size_t YbrAvx2(const uint8_t* ybr, size_t count, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 32 <= count; i += 32)
+				{
+					__m128i low[3];
+					__m128i high[3];
+					__m256i rgb[3];
+					Deinterleave3(ybr + i * 3, low);
+					Deinterleave3(ybr + i * 3 + 48, high);
+					YbrToRgb32(Combine(low[0], high[0]), Combine(low[1], high[1]), Combine(low[2], high[2]), rgb);
+					StoreRgba32(rgb, rgba + i * 4);
+				}
+				return i + YbrSsse3(ybr + i * 3, count - i, rgba + i * 4);
+			}
+
+			MEDVISION_TARGET("avx2")
+			size_t PlanarYbrAvx2(const uint8_t* luma, const uint8_t* blue, const uint8_t* red, size_t count, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 32 <= count; i += 32)
+				{
+					__m256i rgb[3];
+					YbrToRgb32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(luma + i)),
+						_mm256_loadu_si256(reinterpret_cast<const __m256i*>(blue + i)),
+						_mm256_loadu_si256(reinterpret_cast<const __m256i*>(red + i)),
+						rgb);
+					StoreRgba32(rgb, rgba + i * 4);
+				}
+				return i + PlanarYbrSsse3(luma + i, blue + i, red + i, count - i, rgba + i * 4);
+			}
+
+			MEDVISION_TARGET("avx2")
+			size_t Ybr422Avx2(const uint8_t* ybr, size_t count, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 32 <= count; i += 32)
+				{
+					__m128i low[3];
+					__m128i high[3];
+					__m256i rgb[3];
+					Unpack422(ybr + i * 2, low);
+					Unpack422(ybr + i * 2 + 32, high);
+					YbrToRgb32(Combine(low[0], high[0]), Combine(low[1], high[1]), Combine(low[2], high[2]), rgb);
+					StoreRgba32(rgb, rgba + i * 4);
+				}
+				return i + Ybr422Ssse3(ybr + i * 2, count - i, rgba + i * 4);
+			}
+#endif
+
+			struct KernelTable
+			{
+				const char* name;
+				InterleavedKernel rgb;
+				PlanarKernel planarRgb;
+				InterleavedKernel ybr;
+				PlanarKernel planarYbr;
+				InterleavedKernel ybr422;
+			};
+
+			KernelTable SelectKernels()
+			{
+#ifdef MEDVISION_X86
+				// RGB widening and palette lookup are bound by memory; only YBR gains from AVX2
+				if (CpuFeatures::HasAVX2())
+				{
+					return { "AVX2", &RgbSsse3, &PlanarRgbSsse3, &YbrAvx2, &PlanarYbrAvx2, &Ybr422Avx2 };
+				}
+				if (CpuFeatures::HasSSSE3())
+				{
+					return { "SSSE3", &RgbSsse3, &PlanarRgbSsse3, &YbrSsse3, &PlanarYbrSsse3, &Ybr422Ssse3 };
+				}
+#endif
+				return { "Scalar", &InterleavedNone, &PlanarNone, &InterleavedNone, &PlanarNone, &InterleavedNone };
+			}
+
+			const KernelTable& GetKernels()
+			{
+				static const KernelTable kernels = SelectKernels();
+				return kernels;
+			}
+
+			template <typename T>
+			void Lookup(const T* indices, size_t count, const uint32_t* palette, uint8_t* rgba)
+			{
+				size_t i = 0;
+				for (; i + 4 <= count; i += 4)
+				{
+					std::memcpy(rgba + i * 4, &palette[indices[i]], 4);
+					std::memcpy(rgba + i * 4 + 4, &palette[indices[i + 1]], 4);
+					std::memcpy(rgba + i * 4 + 8, &palette[indices[i + 2]], 4);
+					std::memcpy(rgba + i * 4 + 12, &palette[indices[i + 3]], 4);
+				}
+				for (; i < count; ++i)
+				{
+					std::memcpy(rgba + i * 4, &palette[indices[i]], 4);
+				}
+			}
+
+			/// Segments from word position on, at most segmentCount of them;
+			/// indirect segments may not nest
+			bool ExpandSegments(const uint16_t* data, size_t words, size_t position, size_t segmentCount,
+				bool allowIndirect, size_t maxEntries, std::vector<uint16_t>& entries)
+			{
+				for (size_t segment = 0; segment < segmentCount && position < words; ++segment)
+				{
+					uint16_t opcode = data[position];
+					if (position + 1 >= words)
+					{
+						return false;
+					}
+					size_t length = data[position + 1];
+
+					if (opcode == 0)
+					{
+						// Discrete: length entries follow
+						if (position + 2 + length > words || entries.size() + length > maxEntries)
+						{
+							return false;
+						}
+						entries.insert(entries.end(), data + position + 2, data + position + 2 + length);
+						position += 2 + length;
+					}
+					else if (opcode == 1)
+					{
+						// Linear: length entries ramping from the previous entry to the end value
+						if (position + 2 >= words || entries.empty() || entries.size() + length > maxEntries)
+						{
+							return false;
+						}
+						int64_t start = entries.back();
+						int64_t delta = static_cast<int64_t>(data[position + 2]) - start;
+						for (size_t step = 1; step <= length; ++step)
+						{
+							// Rounded to nearest, halves away from the start value
+							int64_t scaled = 2 * delta * static_cast<int64_t>(step);
+							int64_t offset = scaled >= 0 ? (scaled + static_cast<int64_t>(length)) / (2 * static_cast<int64_t>(length))
+								: -((-scaled + static_cast<int64_t>(length)) / (2 * static_cast<int64_t>(length)));
+							entries.push_back(static_cast<uint16_t>(start + offset));
+						}
+						position += 3;
+					}
+					else if (opcode == 2 && allowIndirect)
+					{
+						// Indirect: replay length segments found at a 32-bit byte offset
+						if (position + 3 >= words)
+						{
+							return false;
+						}
+						uint32_t offset = data[position + 2] | (static_cast<uint32_t>(data[position + 3]) << 16);
+						if (offset % 2 != 0 || offset / 2 >= words
+							|| !ExpandSegments(data, words, offset / 2, length, false, maxEntries, entries))
+						{
+							return false;
+						}
+						position += 4;
+					}
+					else
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+		}
+
+		void ColorConvert::RgbToRgba(const uint8_t* rgb, size_t count, uint8_t* rgba)
+		{
+			for (size_t i = GetKernels().rgb(rgb, count, rgba); i < count; ++i)
+			{
+				StorePixel(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], rgba + i * 4);
+			}
+		}
+
+		void ColorConvert::PlanarRgbToRgba(const uint8_t* red, const uint8_t* green, const uint8_t* blue,
+			size_t count, uint8_t* rgba)
+		{
+			for (size_t i = GetKernels().planarRgb(red, green, blue, count, rgba); i < count; ++i)
+			{
+				StorePixel(red[i], green[i], blue[i], rgba + i * 4);
+			}
+		}
+
+		void ColorConvert::YbrFullToRgba(const uint8_t* ybr, size_t count, uint8_t* rgba)
+		{
+			for (size_t i = GetKernels().ybr(ybr, count, rgba); i < count; ++i)
+			{
+				StoreYbrPixel(ybr[i * 3], ybr[i * 3 + 1], ybr[i * 3 + 2], rgba + i * 4);
+			}
+		}
+
+		void ColorConvert::PlanarYbrFullToRgba(const uint8_t* luma, const uint8_t* blue, const uint8_t* red,
+			size_t count, uint8_t* rgba)
+		{
+			for (size_t i = GetKernels().planarYbr(luma, blue, red, count, rgba); i < count; ++i)
+			{
+				StoreYbrPixel(luma[i], blue[i], red[i], rgba + i * 4);
+			}
+		}
+
+		void ColorConvert::YbrFull422ToRgba(const uint8_t* ybr, size_t count, uint8_t* rgba)
+		{
+			for (size_t i = GetKernels().ybr422(ybr, count, rgba); i < count; ++i)
+			{
+				const uint8_t* pair = ybr + (i / 2) * 4;
+				StoreYbrPixel(pair[i % 2], pair[2], pair[3], rgba + i * 4);
+			}
+		}
+
+		void ColorConvert::PaletteToRgba(const uint8_t* indices, size_t count, const uint32_t* palette, uint8_t* rgba)
+		{
+			Lookup(indices, count, palette, rgba);
+		}
+
+		void ColorConvert::PaletteToRgba(const uint16_t* indices, size_t count, const uint32_t* palette, uint8_t* rgba)
+		{
+			Lookup(indices, count, palette, rgba);
+		}
+
+		uint32_t ColorConvert::PackRgba(uint8_t red, uint8_t green, uint8_t blue)
+		{
+			const uint8_t bytes[4] = { red, green, blue, 255 };
+			uint32_t entry;
+			std::memcpy(&entry, bytes, sizeof(entry));
+			return entry;
+		}
+
+		bool ColorConvert::ExpandSegmentedLut(const uint16_t* data, size_t words, size_t maxEntries,
+			std::vector<uint16_t>& entries)
+		{
+			entries.clear();
+			if (!ExpandSegments(data, words, 0, words, true, maxEntries, entries) || entries.empty())
+			{
+				entries.clear();
+				return false;
+			}
+			return true;
+		}
+
+		const char* ColorConvert::GetKernelName()
+		{
+			return GetKernels().name;
+		}
+
+	} // namespace dicom
+} // namespace medvision
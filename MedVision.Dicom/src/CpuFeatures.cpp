@@ -0,0 +1,131 @@
+#include "medvision/dicom/CpuFeatures.h"
+
+#ifdef MEDVISION_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			struct FeatureSet
+			{
+				bool sse2;
+				bool ssse3;
+				bool sse41;
+				bool avx2;
+				bool f16c;
+				bool avx512f;
+
+				FeatureSet()
+					: sse2(false), ssse3(false), sse41(false), avx2(false), f16c(false), avx512f(false)
+				{
+#ifdef MEDVISION_X86
+					unsigned int leaf1[4] = { 0, 0, 0, 0 };
+					unsigned int leaf7[4] = { 0, 0, 0, 0 };
+					unsigned int maxLeaf = Query(0, leaf1);
+					Query(1, leaf1);
+					if (maxLeaf >= 7)
+					{
+						Query(7, leaf7);
+					}
+
+					sse2 = (leaf1[3] & (1u << 26)) != 0;
+					ssse3 = (leaf1[2] & (1u << 9)) != 0;
+					sse41 = (leaf1[2] & (1u << 19)) != 0;
+
+					// AVX2 and F16C also need the OS to preserve YMM registers (OSXSAVE + XCR0)
+					bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+					bool avx = (leaf1[2] & (1u << 28)) != 0;
+					unsigned long long xcr0 = (osxsave && avx) ? ReadXcr0() : 0;
+					if ((xcr0 & 0x6) == 0x6)
+					{
+						avx2 = (leaf7[1] & (1u << 5)) != 0;
+						f16c = (leaf1[2] & (1u << 29)) != 0;
+					}
+
+					// AVX-512 additionally needs the opmask and ZMM state enabled
+					if ((xcr0 & 0xE6) == 0xE6)
+					{
+						avx512f = (leaf7[1] & (1u << 16)) != 0;
+					}
+#endif
+				}
+
+#ifdef MEDVISION_X86
+				// Returns EAX; registers are stored as EAX, EBX, ECX, EDX
+				static unsigned int Query(unsigned int leaf, unsigned int registers[4])
+				{
+#ifdef _MSC_VER
+					int values[4];
+					__cpuidex(values, static_cast<int>(leaf), 0);
+					for (int i = 0; i < 4; ++i)
+					{
+						registers[i] = static_cast<unsigned int>(values[i]);
+					}
+#else
+					__cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+					return registers[0];
+				}
+
+				static unsigned long long ReadXcr0()
+				{
+#ifdef _MSC_VER
+					return _xgetbv(0);
+#else
+					unsigned int eax = 0;
+					unsigned int edx = 0;
+					__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+					return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+				}
+#endif
+			};
+
+			const FeatureSet& GetFeatures()
+			{
+				static FeatureSet features;
+				return features;
+			}
+		}
+
+		bool CpuFeatures::HasSSE2()
+		{
+			return GetFeatures().sse2;
+		}
+
+		bool CpuFeatures::HasSSSE3()
+		{
+			return GetFeatures().ssse3;
+		}
+
+		bool CpuFeatures::HasSSE41()
+		{
+			return GetFeatures().sse41;
+		}
+
+		bool CpuFeatures::HasAVX2()
+		{
+			return GetFeatures().avx2;
+		}
+
+		bool CpuFeatures::HasF16C()
+		{
+			return GetFeatures().f16c;
+		}
+
+		bool CpuFeatures::HasAVX512F()
+		{
+			return GetFeatures().avx512f;
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,1099 @@
+#include "medvision/dicom/Deflate.h"
+#include <algorithm>
+#include <cstring>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const size_t kWindowSize = 32768;        // Longest back-reference distance
+			const size_t kChunkSize = 64 * 1024;     // Output decoded per refill of the window
+			const size_t kInputSize = 64 * 1024;
+			const size_t kBlockSize = 64 * 1024;     // Input per compressed block
+			const size_t kMinMatch = 3;
+			const size_t kMaxMatch = 258;
+			const int kMaxChain = 64;                // Hash chain entries tried per position
+			const size_t kNiceMatch = 128;           // Stop searching at a match this long
+			const int kHashBits = 15;
+
+			const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+				35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+				3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			const uint16_t kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+				257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			const uint8_t kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+				7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+			// Order in which the code length code lengths are stored
+			const uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+			uint32_t ReverseBits(uint32_t code, int length)
+			{
+				uint32_t reversed = 0;
+				for (int i = 0; i < length; ++i)
+				{
+					reversed = (reversed << 1) | ((code >> i) & 1);
+				}
+				return reversed;
+			}
+
+			int FloorLog2(uint32_t value)
+			{
+				int log = 0;
+				while ((value >> (log + 1)) != 0)
+				{
+					++log;
+				}
+				return log;
+			}
+
+			int LengthCode(uint32_t length)
+			{
+				uint32_t x = length - 3;
+				if (x < 8)
+				{
+					return static_cast<int>(x);
+				}
+				if (x == 255)
+				{
+					return 28;
+				}
+				int bits = FloorLog2(x);
+				return 4 * (bits - 1) + static_cast<int>((x >> (bits - 2)) & 3);
+			}
+
+			int DistanceCode(uint32_t distance)
+			{
+				uint32_t x = distance - 1;
+				if (x < 4)
+				{
+					return static_cast<int>(x);
+				}
+				int bits = FloorLog2(x);
+				return 2 * bits + static_cast<int>((x >> (bits - 1)) & 1);
+			}
+
+			void FixedLengths(uint8_t* literalLengths, uint8_t* distanceLengths)
+			{
+				for (int i = 0; i < 288; ++i)
+				{
+					literalLengths[i] = i < 144 ? 8 : (i < 256 ? 9 : (i < 280 ? 7 : 8));
+				}
+				for (int i = 0; i < 30; ++i)
+				{
+					distanceLengths[i] = 5;
+				}
+			}
+
+			// Huffman code lengths of at most limit bits for the given frequencies.
+			// At least two symbols get a code, as inflaters expect of every tree.
+			void BuildLengths(const uint32_t* frequencies, int count, int limit, uint8_t* lengths)
+			{
+				struct Node
+				{
+					uint64_t weight;
+					int symbol;   // -1 for internal nodes
+				};
+
+				std::vector<Node> leaves;
+				for (int i = 0; i < count; ++i)
+				{
+					lengths[i] = 0;
+					if (frequencies[i] != 0)
+					{
+						leaves.push_back({ frequencies[i], i });
+					}
+				}
+				for (int i = 0; leaves.size() < 2; ++i)
+				{
+					if (frequencies[i] == 0)
+					{
+						leaves.push_back({ 1, i });
+					}
+				}
+				std::sort(leaves.begin(), leaves.end(), [](const Node& a, const Node& b) {
+					return a.weight != b.weight ? a.weight < b.weight : a.symbol < b.symbol;
+				});
+
+				// Two-queue construction: internal nodes are created in weight order
+				const size_t leafCount = leaves.size();
+				std::vector<Node> nodes(leaves);
+				std::vector<size_t> parent(2 * leafCount - 1, 0);
+				size_t nextLeaf = 0;
+				size_t nextInternal = leafCount;
+				auto takeSmallest = [&]() {
+					if (nextLeaf < leafCount && (nextInternal >= nodes.size() || nodes[nextLeaf].weight <= nodes[nextInternal].weight))
+					{
+						return nextLeaf++;
+					}
+					return nextInternal++;
+				};
+				while (nodes.size() < 2 * leafCount - 1)
+				{
+					size_t a = takeSmallest();
+					size_t b = takeSmallest();
+					parent[a] = nodes.size();
+					parent[b] = nodes.size();
+					nodes.push_back({ nodes[a].weight + nodes[b].weight, -1 });
+				}
+
+				// Depths from the root down; parents always follow their children
+				std::vector<int> depth(nodes.size(), 0);
+				std::vector<int> lengthCounts(leafCount + 1, 0);
+				int maxDepth = 0;
+				for (size_t i = nodes.size() - 1; i-- > 0;)
+				{
+					depth[i] = depth[parent[i]] + 1;
+					if (i < leafCount)
+					{
+						++lengthCounts[depth[i]];
+						maxDepth = std::max(maxDepth, depth[i]);
+					}
+				}
+
+				// Move leaves deeper than the limit up while keeping the code complete
+				// (the adjustment of ITU-T T.81 Annex K.3)
+				for (int i = maxDepth; i > limit; --i)
+				{
+					while (lengthCounts[i] > 0)
+					{
+						int j = i - 2;
+						while (lengthCounts[j] == 0)
+						{
+							--j;
+						}
+						lengthCounts[i] -= 2;
+						lengthCounts[i - 1] += 1;
+						lengthCounts[j + 1] += 2;
+						lengthCounts[j] -= 1;
+					}
+				}
+
+				// Most frequent symbols get the shortest codes
+				size_t leaf = leafCount;
+				for (int length = 1; length <= std::min(limit, maxDepth); ++length)
+				{
+					for (int n = 0; n < lengthCounts[length]; ++n)
+					{
+						lengths[nodes[--leaf].symbol] = static_cast<uint8_t>(length);
+					}
+				}
+			}
+
+			// Canonical codes, bit-reversed for LSB-first output
+			void AssignCodes(const uint8_t* lengths, int count, uint16_t* codes)
+			{
+				int lengthCounts[16] = { 0 };
+				for (int i = 0; i < count; ++i)
+				{
+					++lengthCounts[lengths[i]];
+				}
+				lengthCounts[0] = 0;
+				uint32_t next[16] = { 0 };
+				uint32_t code = 0;
+				for (int length = 1; length < 16; ++length)
+				{
+					code = (code + lengthCounts[length - 1]) << 1;
+					next[length] = code;
+				}
+				for (int i = 0; i < count; ++i)
+				{
+					codes[i] = lengths[i] != 0 ? static_cast<uint16_t>(ReverseBits(next[lengths[i]]++, lengths[i])) : 0;
+				}
+			}
+		}
+
+		InflateStream::InflateStream(Source source)
+			: source_(std::move(source))
+			, input_(kInputSize)
+			, inputPosition_(0)
+			, inputLength_(0)
+			, inputDone_(false)
+			, bits_(0)
+			, bitCount_(0)
+			, window_(kWindowSize + kChunkSize + kMaxMatch)
+			, readPosition_(0)
+			, writePosition_(0)
+			, state_(State::Header)
+			, finalBlock_(false)
+			, headerChecked_(false)
+			, storedRemaining_(0)
+		{
+		}
+
+		size_t InflateStream::Read(uint8_t* buffer, size_t count)
+		{
+			size_t total = 0;
+			while (total < count)
+			{
+				if (readPosition_ == writePosition_ && !Produce())
+				{
+					break;
+				}
+				size_t available = std::min(count - total, writePosition_ - readPosition_);
+				std::memcpy(buffer + total, window_.data() + readPosition_, available);
+				readPosition_ += available;
+				total += available;
+			}
+			return total;
+		}
+
+		size_t InflateStream::Skip(size_t count)
+		{
+			size_t total = 0;
+			while (total < count)
+			{
+				if (readPosition_ == writePosition_ && !Produce())
+				{
+					break;
+				}
+				size_t available = std::min(count - total, writePosition_ - readPosition_);
+				readPosition_ += available;
+				total += available;
+			}
+			return total;
+		}
+
+		bool InflateStream::AtEnd()
+		{
+			return readPosition_ == writePosition_ && !Produce();
+		}
+
+		bool InflateStream::Produce()
+		{
+			if (state_ == State::Done)
+			{
+				return false;
+			}
+
+			// Everything was handed out; keep only the history matches may refer to
+			if (writePosition_ >= kWindowSize + kChunkSize)
+			{
+				std::memmove(window_.data(), window_.data() + writePosition_ - kWindowSize, kWindowSize);
+				writePosition_ = kWindowSize;
+				readPosition_ = kWindowSize;
+			}
+
+			const size_t start = writePosition_;
+			while (writePosition_ < kWindowSize + kChunkSize && state_ != State::Done)
+			{
+				bool success = true;
+				switch (state_)
+				{
+				case State::Header: success = ReadHeader(); break;
+				case State::Stored: success = CopyStored(); break;
+				case State::Huffman: success = DecodeHuffman(); break;
+				case State::Done: break;
+				}
+				if (!success)
+				{
+					break;
+				}
+			}
+			return writePosition_ > start;
+		}
+
+		bool InflateStream::ReadHeader()
+		{
+			if (finalBlock_)
+			{
+				state_ = State::Done;
+				return true;
+			}
+
+			if (!headerChecked_)
+			{
+				// zlib header: deflate method, window <= 32K, no preset dictionary, FCHECK
+				headerChecked_ = true;
+				if (NeedBits(16))
+				{
+					uint32_t cmf = static_cast<uint32_t>(bits_ & 0xFF);
+					uint32_t flg = static_cast<uint32_t>((bits_ >> 8) & 0xFF);
+					if ((cmf & 0x0F) == 8 && (cmf >> 4) <= 7 && (flg & 0x20) == 0 && ((cmf << 8) | flg) % 31 == 0)
+					{
+						GetBits(16);
+					}
+				}
+			}
+
+			if (!NeedBits(3))
+			{
+				Fail("Deflate data is truncated");
+				return false;
+			}
+			finalBlock_ = GetBits(1) != 0;
+			uint32_t type = GetBits(2);
+			if (type == 0)
+			{
+				GetBits(bitCount_ % 8);
+				if (!NeedBits(32))
+				{
+					Fail("Deflate data is truncated");
+					return false;
+				}
+				uint32_t length = GetBits(16);
+				uint32_t complement = GetBits(16);
+				if (length != (~complement & 0xFFFF))
+				{
+					Fail("Invalid deflate stored block length");
+					return false;
+				}
+				storedRemaining_ = length;
+				state_ = State::Stored;
+				return true;
+			}
+			if (type == 1)
+			{
+				uint8_t lengths[288 + 30];
+				FixedLengths(lengths, lengths + 288);
+				BuildTable(literals_, lengths, 288);
+				BuildTable(distances_, lengths + 288, 30);
+				state_ = State::Huffman;
+				return true;
+			}
+			if (type == 2)
+			{
+				return ReadDynamicTables();
+			}
+			Fail("Invalid deflate block type");
+			return false;
+		}
+
+		bool InflateStream::ReadDynamicTables()
+		{
+			if (!NeedBits(14))
+			{
+				Fail("Deflate data is truncated");
+				return false;
+			}
+			const int literalCount = static_cast<int>(GetBits(5)) + 257;
+			const int distanceCount = static_cast<int>(GetBits(5)) + 1;
+			const int codeLengthCount = static_cast<int>(GetBits(4)) + 4;
+			if (literalCount > 286 || distanceCount > 30)
+			{
+				Fail("Invalid deflate code counts");
+				return false;
+			}
+
+			uint8_t lengths[286 + 30] = { 0 };
+			for (int i = 0; i < codeLengthCount; ++i)
+			{
+				if (!NeedBits(3))
+				{
+					Fail("Deflate data is truncated");
+					return false;
+				}
+				lengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(GetBits(3));
+			}
+			Table codeLengths;
+			if (!BuildTable(codeLengths, lengths, 19))
+			{
+				Fail("Invalid deflate code length code");
+				return false;
+			}
+
+			const int total = literalCount + distanceCount;
+			std::memset(lengths, 0, sizeof(lengths));
+			int index = 0;
+			while (index < total)
+			{
+				int symbol = DecodeSymbol(codeLengths);
+				if (symbol < 0)
+				{
+					Fail("Invalid or truncated deflate code lengths");
+					return false;
+				}
+				if (symbol < 16)
+				{
+					lengths[index++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+
+				uint8_t value = 0;
+				int repeat;
+				if (!NeedBits(7))
+				{
+					Fail("Deflate data is truncated");
+					return false;
+				}
+				if (symbol == 16)
+				{
+					if (index == 0)
+					{
+						Fail("Invalid deflate code lengths");
+						return false;
+					}
+					value = lengths[index - 1];
+					repeat = 3 + static_cast<int>(GetBits(2));
+				}
+				else if (symbol == 17)
+				{
+					repeat = 3 + static_cast<int>(GetBits(3));
+				}
+				else
+				{
+					repeat = 11 + static_cast<int>(GetBits(7));
+				}
+				if (index + repeat > total)
+				{
+					Fail("Invalid deflate code lengths");
+					return false;
+				}
+				std::memset(lengths + index, value, repeat);
+				index += repeat;
+			}
+
+			if (lengths[256] == 0 ||
+				!BuildTable(literals_, lengths, literalCount) ||
+				!BuildTable(distances_, lengths + literalCount, distanceCount))
+			{
+				Fail("Invalid deflate Huffman code");
+				return false;
+			}
+			state_ = State::Huffman;
+			return true;
+		}
+
+		bool InflateStream::CopyStored()
+		{
+			const size_t limit = kWindowSize + kChunkSize;
+			while (storedRemaining_ > 0 && writePosition_ < limit)
+			{
+				// Whole bytes still in the bit buffer come first
+				if (bitCount_ >= 8)
+				{
+					window_[writePosition_++] = static_cast<uint8_t>(bits_);
+					bits_ >>= 8;
+					bitCount_ -= 8;
+					--storedRemaining_;
+					continue;
+				}
+				if (inputPosition_ == inputLength_)
+				{
+					inputLength_ = inputDone_ ? 0 : source_(input_.data(), input_.size());
+					inputPosition_ = 0;
+					if (inputLength_ == 0)
+					{
+						inputDone_ = true;
+						Fail("Deflate data is truncated");
+						return false;
+					}
+				}
+				size_t count = std::min(std::min(storedRemaining_, inputLength_ - inputPosition_), limit - writePosition_);
+				std::memcpy(window_.data() + writePosition_, input_.data() + inputPosition_, count);
+				inputPosition_ += count;
+				writePosition_ += count;
+				storedRemaining_ -= count;
+			}
+			if (storedRemaining_ == 0)
+			{
+				state_ = State::Header;
+			}
+			return true;
+		}
+
+		bool InflateStream::DecodeHuffman()
+		{
+			const size_t limit = kWindowSize + kChunkSize;
+			uint8_t* window = window_.data();
+			while (writePosition_ < limit)
+			{
+				int symbol = DecodeSymbol(literals_);
+				if (symbol < 256)
+				{
+					if (symbol < 0)
+					{
+						Fail("Invalid or truncated deflate data");
+						return false;
+					}
+					window[writePosition_++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+				if (symbol == 256)
+				{
+					state_ = State::Header;
+					return true;
+				}
+
+				symbol -= 257;
+				if (symbol >= 29 || !NeedBits(kLengthExtra[symbol]))
+				{
+					Fail("Invalid or truncated deflate data");
+					return false;
+				}
+				size_t length = kLengthBase[symbol] + GetBits(kLengthExtra[symbol]);
+
+				int distanceSymbol = DecodeSymbol(distances_);
+				if (distanceSymbol < 0 || distanceSymbol >= 30 || !NeedBits(kDistanceExtra[distanceSymbol]))
+				{
+					Fail("Invalid or truncated deflate data");
+					return false;
+				}
+				size_t distance = kDistanceBase[distanceSymbol] + GetBits(kDistanceExtra[distanceSymbol]);
+				if (distance > writePosition_)
+				{
+					Fail("Invalid deflate distance");
+					return false;
+				}
+
+				uint8_t* target = window + writePosition_;
+				const uint8_t* source = target - distance;
+				if (distance >= length)
+				{
+					std::memcpy(target, source, length);
+				}
+				else
+				{
+					// Overlapping copy repeats the last distance bytes
+					for (size_t i = 0; i < length; ++i)
+					{
+						target[i] = source[i];
+					}
+				}
+				writePosition_ += length;
+			}
+			return true;
+		}
+
+		bool InflateStream::BuildTable(Table& table, const uint8_t* lengths, int count)
+		{
+			std::memset(table.fast, 0, sizeof(table.fast));
+			std::memset(table.counts, 0, sizeof(table.counts));
+			for (int i = 0; i < count; ++i)
+			{
+				++table.counts[lengths[i]];
+			}
+			table.counts[0] = 0;
+
+			// Over-subscribed codes are invalid; incomplete ones are allowed
+			int left = 1;
+			for (int length = 1; length < 16; ++length)
+			{
+				left = (left << 1) - table.counts[length];
+				if (left < 0)
+				{
+					return false;
+				}
+			}
+
+			uint16_t offsets[16];
+			offsets[1] = 0;
+			for (int length = 1; length < 15; ++length)
+			{
+				offsets[length + 1] = static_cast<uint16_t>(offsets[length] + table.counts[length]);
+			}
+			for (int i = 0; i < count; ++i)
+			{
+				if (lengths[i] != 0)
+				{
+					table.symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+				}
+			}
+
+			uint32_t next[16] = { 0 };
+			uint32_t code = 0;
+			for (int length = 1; length < 16; ++length)
+			{
+				code = (code + table.counts[length - 1]) << 1;
+				next[length] = code;
+			}
+			for (int i = 0; i < count; ++i)
+			{
+				int length = lengths[i];
+				if (length == 0)
+				{
+					continue;
+				}
+				uint32_t reversed = ReverseBits(next[length]++, length);
+				if (length <= Table::kFastBits)
+				{
+					for (uint32_t k = reversed; k < (1u << Table::kFastBits); k += 1u << length)
+					{
+						table.fast[k] = static_cast<uint16_t>((i << 4) | length);
+					}
+				}
+			}
+			return true;
+		}
+
+		int InflateStream::DecodeSymbol(const Table& table)
+		{
+			if (bitCount_ < 15)
+			{
+				Refill();
+			}
+			uint16_t entry = table.fast[bits_ & ((1u << Table::kFastBits) - 1)];
+			if (entry != 0)
+			{
+				int length = entry & 15;
+				if (length > bitCount_)
+				{
+					return -1;
+				}
+				bits_ >>= length;
+				bitCount_ -= length;
+				return entry >> 4;
+			}
+
+			// Longer codes: walk the canonical code one bit at a time
+			int code = 0;
+			int first = 0;
+			int index = 0;
+			uint64_t bits = bits_;
+			for (int length = 1; length < 16 && length <= bitCount_; ++length)
+			{
+				code |= static_cast<int>(bits & 1);
+				bits >>= 1;
+				int count = table.counts[length];
+				if (code - count < first)
+				{
+					bits_ >>= length;
+					bitCount_ -= length;
+					return table.symbols[index + (code - first)];
+				}
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+
+		void InflateStream::Refill()
+		{
+			while (bitCount_ <= 56)
+			{
+				if (inputPosition_ == inputLength_)
+				{
+					if (inputDone_)
+					{
+						return;
+					}
+					inputLength_ = source_(input_.data(), input_.size());
+					inputPosition_ = 0;
+					if (inputLength_ == 0)
+					{
+						inputDone_ = true;
+						return;
+					}
+				}
+				bits_ |= static_cast<uint64_t>(input_[inputPosition_++]) << bitCount_;
+				bitCount_ += 8;
+			}
+		}
+
+		bool InflateStream::NeedBits(int count)
+		{
+			if (bitCount_ < count)
+			{
+				Refill();
+			}
+			return bitCount_ >= count;
+		}
+
+		uint32_t InflateStream::GetBits(int count)
+		{
+			uint32_t value = static_cast<uint32_t>(bits_ & ((uint64_t(1) << count) - 1));
+			bits_ >>= count;
+			bitCount_ -= count;
+			return value;
+		}
+
+		void InflateStream::Fail(const char* message)
+		{
+			if (error_.empty())
+			{
+				error_ = message;
+			}
+			state_ = State::Done;
+		}
+
+		DeflateStream::DeflateStream(Sink sink)
+			: sink_(std::move(sink))
+			, buffer_(kWindowSize + kBlockSize)
+			, historyLength_(0)
+			, pendingLength_(0)
+			, head_(size_t(1) << kHashBits, -1)
+			, previous_(kWindowSize + kBlockSize, -1)
+			, bitBuffer_(0)
+			, bitCount_(0)
+			, outputLength_(0)
+			, finished_(false)
+		{
+		}
+
+		bool DeflateStream::Write(const uint8_t* data, size_t length)
+		{
+			while (length > 0)
+			{
+				size_t count = std::min(length, kBlockSize - pendingLength_);
+				std::memcpy(buffer_.data() + historyLength_ + pendingLength_, data, count);
+				pendingLength_ += count;
+				data += count;
+				length -= count;
+				if (pendingLength_ == kBlockSize && !CompressBlock(false))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool DeflateStream::Finish()
+		{
+			if (finished_)
+			{
+				return true;
+			}
+			finished_ = true;
+			return CompressBlock(true);
+		}
+
+		void DeflateStream::Compress(const uint8_t* data, size_t length, std::vector<uint8_t>& output)
+		{
+			output.clear();
+			DeflateStream stream([&output](const uint8_t* compressed, size_t count) {
+				output.insert(output.end(), compressed, compressed + count);
+				return true;
+			});
+			stream.Write(data, length);
+			stream.Finish();
+		}
+
+		bool DeflateStream::CompressBlock(bool final)
+		{
+			const size_t begin = historyLength_;
+			const size_t end = historyLength_ + pendingLength_;
+			FindTokens(begin, end);
+			WriteBlock(begin, end, final);
+
+			// Keep the last 32K as history and rebase the hash chains onto it
+			if (end > kWindowSize)
+			{
+				const int32_t shift = static_cast<int32_t>(end - kWindowSize);
+				std::memmove(buffer_.data(), buffer_.data() + shift, kWindowSize);
+				for (int32_t& position : head_)
+				{
+					position = position >= shift ? position - shift : -1;
+				}
+				for (size_t i = 0; i < kWindowSize; ++i)
+				{
+					int32_t position = previous_[i + shift];
+					previous_[i] = position >= shift ? position - shift : -1;
+				}
+				historyLength_ = kWindowSize;
+			}
+			else
+			{
+				historyLength_ = end;
+			}
+			pendingLength_ = 0;
+			return Drain(final);
+		}
+
+		void DeflateStream::FindTokens(size_t begin, size_t end)
+		{
+			const uint8_t* data = buffer_.data();
+			const uint32_t mask = (1u << kHashBits) - 1;
+			auto hash = [&](size_t p) {
+				return ((static_cast<uint32_t>(data[p]) << 10) ^ (static_cast<uint32_t>(data[p + 1]) << 5) ^ data[p + 2]) & mask;
+			};
+			auto insert = [&](size_t p) {
+				uint32_t h = hash(p);
+				int32_t candidate = head_[h];
+				previous_[p] = candidate;
+				head_[h] = static_cast<int32_t>(p);
+				return candidate;
+			};
+
+			tokens_.clear();
+			size_t p = begin;
+			while (p < end)
+			{
+				size_t bestLength = 0;
+				size_t bestDistance = 0;
+				if (p + kMinMatch <= end)
+				{
+					const size_t maxLength = std::min(kMaxMatch, end - p);
+					int32_t candidate = insert(p);
+					for (int chain = 0; candidate >= 0 && p - candidate <= kWindowSize && chain < kMaxChain; ++chain)
+					{
+						const uint8_t* match = data + candidate;
+						if (match[bestLength] == data[p + bestLength])
+						{
+							size_t length = 0;
+							while (length < maxLength && match[length] == data[p + length])
+							{
+								++length;
+							}
+							if (length > bestLength)
+							{
+								bestLength = length;
+								bestDistance = p - candidate;
+								if (length >= kNiceMatch || length == maxLength)
+								{
+									break;
+								}
+							}
+						}
+						candidate = previous_[candidate];
+					}
+				}
+
+				if (bestLength >= kMinMatch)
+				{
+					tokens_.push_back({ static_cast<uint16_t>(bestLength), static_cast<uint16_t>(bestDistance) });
+					for (size_t q = p + 1; q < p + bestLength && q + kMinMatch <= end; ++q)
+					{
+						insert(q);
+					}
+					p += bestLength;
+				}
+				else
+				{
+					tokens_.push_back({ data[p], 0 });
+					++p;
+				}
+			}
+		}
+
+		void DeflateStream::WriteBlock(size_t begin, size_t end, bool final)
+		{
+			uint32_t literalFrequencies[286] = { 0 };
+			uint32_t distanceFrequencies[30] = { 0 };
+			uint64_t extraBits = 0;
+			for (const Token& token : tokens_)
+			{
+				if (token.distance == 0)
+				{
+					++literalFrequencies[token.value];
+					continue;
+				}
+				int lengthCode = LengthCode(token.value);
+				int distanceCode = DistanceCode(token.distance);
+				++literalFrequencies[257 + lengthCode];
+				++distanceFrequencies[distanceCode];
+				extraBits += kLengthExtra[lengthCode] + kDistanceExtra[distanceCode];
+			}
+			literalFrequencies[256] = 1;
+
+			uint8_t literalLengths[288] = { 0 };
+			uint8_t distanceLengths[30] = { 0 };
+			BuildLengths(literalFrequencies, 286, 15, literalLengths);
+			BuildLengths(distanceFrequencies, 30, 15, distanceLengths);
+
+			int literalCount = 286;
+			while (literalCount > 257 && literalLengths[literalCount - 1] == 0)
+			{
+				--literalCount;
+			}
+			int distanceCount = 30;
+			while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0)
+			{
+				--distanceCount;
+			}
+
+			// Run-length code the code lengths: (symbol, extra bits, extra value)
+			uint8_t combined[286 + 30];
+			std::memcpy(combined, literalLengths, literalCount);
+			std::memcpy(combined + literalCount, distanceLengths, distanceCount);
+			const int combinedCount = literalCount + distanceCount;
+			struct RunSymbol
+			{
+				uint8_t symbol;
+				uint8_t extraBits;
+				uint8_t extra;
+			};
+			std::vector<RunSymbol> runs;
+			for (int i = 0; i < combinedCount;)
+			{
+				const uint8_t value = combined[i];
+				int run = 1;
+				while (i + run < combinedCount && combined[i + run] == value)
+				{
+					++run;
+				}
+				i += run;
+				if (value == 0)
+				{
+					while (run >= 11)
+					{
+						int count = std::min(run, 138);
+						runs.push_back({ 18, 7, static_cast<uint8_t>(count - 11) });
+						run -= count;
+					}
+					if (run >= 3)
+					{
+						runs.push_back({ 17, 3, static_cast<uint8_t>(run - 3) });
+						run = 0;
+					}
+				}
+				else
+				{
+					runs.push_back({ value, 0, 0 });
+					--run;
+					while (run >= 3)
+					{
+						int count = std::min(run, 6);
+						runs.push_back({ 16, 2, static_cast<uint8_t>(count - 3) });
+						run -= count;
+					}
+				}
+				for (; run > 0; --run)
+				{
+					runs.push_back({ value, 0, 0 });
+				}
+			}
+
+			uint32_t codeLengthFrequencies[19] = { 0 };
+			for (const RunSymbol& run : runs)
+			{
+				++codeLengthFrequencies[run.symbol];
+			}
+			uint8_t codeLengthLengths[19];
+			BuildLengths(codeLengthFrequencies, 19, 7, codeLengthLengths);
+			int codeLengthCount = 19;
+			while (codeLengthCount > 4 && codeLengthLengths[kCodeLengthOrder[codeLengthCount - 1]] == 0)
+			{
+				--codeLengthCount;
+			}
+
+			// Sizes of the three block encodings
+			uint8_t fixedLiteralLengths[288];
+			uint8_t fixedDistanceLengths[30];
+			FixedLengths(fixedLiteralLengths, fixedDistanceLengths);
+			uint64_t dynamicBits = 3 + 14 + 3 * static_cast<uint64_t>(codeLengthCount) + extraBits;
+			uint64_t fixedBits = 3 + extraBits;
+			for (const RunSymbol& run : runs)
+			{
+				dynamicBits += codeLengthLengths[run.symbol] + run.extraBits;
+			}
+			for (int i = 0; i < 286; ++i)
+			{
+				dynamicBits += static_cast<uint64_t>(literalFrequencies[i]) * literalLengths[i];
+				fixedBits += static_cast<uint64_t>(literalFrequencies[i]) * fixedLiteralLengths[i];
+			}
+			for (int i = 0; i < 30; ++i)
+			{
+				dynamicBits += static_cast<uint64_t>(distanceFrequencies[i]) * distanceLengths[i];
+				fixedBits += static_cast<uint64_t>(distanceFrequencies[i]) * 5;
+			}
+			const size_t storedBlocks = std::max<size_t>(1, (end - begin + 65534) / 65535);
+			uint64_t storedBits = 8 * static_cast<uint64_t>(end - begin) + 40 * storedBlocks;
+
+			if (storedBits < dynamicBits && storedBits < fixedBits)
+			{
+				WriteStored(begin, end, final);
+				return;
+			}
+
+			uint16_t literalCodes[288];
+			uint16_t distanceCodes[30];
+			PutBits(final ? 1 : 0, 1);
+			if (fixedBits <= dynamicBits)
+			{
+				PutBits(1, 2);
+				AssignCodes(fixedLiteralLengths, 288, literalCodes);
+				AssignCodes(fixedDistanceLengths, 30, distanceCodes);
+				WriteTokens(literalCodes, fixedLiteralLengths, distanceCodes, fixedDistanceLengths);
+				return;
+			}
+
+			PutBits(2, 2);
+			PutBits(static_cast<uint32_t>(literalCount - 257), 5);
+			PutBits(static_cast<uint32_t>(distanceCount - 1), 5);
+			PutBits(static_cast<uint32_t>(codeLengthCount - 4), 4);
+			for (int i = 0; i < codeLengthCount; ++i)
+			{
+				PutBits(codeLengthLengths[kCodeLengthOrder[i]], 3);
+			}
+			uint16_t codeLengthCodes[19];
+			AssignCodes(codeLengthLengths, 19, codeLengthCodes);
+			for (const RunSymbol& run : runs)
+			{
+				PutBits(codeLengthCodes[run.symbol], codeLengthLengths[run.symbol]);
+				PutBits(run.extra, run.extraBits);
+			}
+			AssignCodes(literalLengths, 286, literalCodes);
+			AssignCodes(distanceLengths, 30, distanceCodes);
+			WriteTokens(literalCodes, literalLengths, distanceCodes, distanceLengths);
+		}
+
+		void DeflateStream::WriteStored(size_t begin, size_t end, bool final)
+		{
+			size_t position = begin;
+			do
+			{
+				size_t count = std::min<size_t>(end - position, 65535);
+				bool last = final && position + count == end;
+				PutBits(last ? 1 : 0, 1);
+				PutBits(0, 2);
+				AlignToByte();
+				PutBits(static_cast<uint32_t>(count), 16);
+				PutBits(static_cast<uint32_t>(~count & 0xFFFF), 16);
+				output_.insert(output_.end(), buffer_.data() + position, buffer_.data() + position + count);
+				position += count;
+			} while (position < end);
+		}
+
+		void DeflateStream::WriteTokens(const uint16_t* literalCodes, const uint8_t* literalLengths,
+			const uint16_t* distanceCodes, const uint8_t* distanceLengths)
+		{
+			for (const Token& token : tokens_)
+			{
+				if (token.distance == 0)
+				{
+					PutBits(literalCodes[token.value], literalLengths[token.value]);
+					continue;
+				}
+				int lengthCode = LengthCode(token.value);
+				PutBits(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+				PutBits(token.value - kLengthBase[lengthCode], kLengthExtra[lengthCode]);
+				int distanceCode = DistanceCode(token.distance);
+				PutBits(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+				PutBits(token.distance - kDistanceBase[distanceCode], kDistanceExtra[distanceCode]);
+			}
+			PutBits(literalCodes[256], literalLengths[256]);
+		}
+
+		void DeflateStream::PutBits(uint32_t value, int count)
+		{
+			bitBuffer_ |= static_cast<uint64_t>(value) << bitCount_;
+			bitCount_ += count;
+			while (bitCount_ >= 8)
+			{
+				output_.push_back(static_cast<uint8_t>(bitBuffer_));
+				bitBuffer_ >>= 8;
+				bitCount_ -= 8;
+			}
+		}
+
+		void DeflateStream::AlignToByte()
+		{
+			if (bitCount_ > 0)
+			{
+				PutBits(0, 8 - bitCount_);
+			}
+		}
+
+		bool DeflateStream::Drain(bool all)
+		{
+			if (all)
+			{
+				AlignToByte();
+			}
+			if (output_.empty())
+			{
+				return true;
+			}
+			bool success = sink_(output_.data(), output_.size());
+			outputLength_ += output_.size();
+			output_.clear();
+			return success;
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -62,6 +62,8 @@ namespace medvision
 			// Image Module
 			entries[0x00280002] = { VR::US, "Samples per Pixel", "SamplesPerPixel" };
 			entries[0x00280004] = { VR::CS, "Photometric Interpretation", "PhotometricInterpretation" };
+			entries[0x00280006] = { VR::US, "Planar Configuration", "PlanarConfiguration" };
+			entries[0x00280008] = { VR::IS, "Number of Frames", "NumberOfFrames" };
 			entries[0x00280010] = { VR::US, "Rows", "Rows" };
 			entries[0x00280011] = { VR::US, "Columns", "Columns" };
 			entries[0x00280030] = { VR::DS, "Pixel Spacing", "PixelSpacing" };
@@ -69,12 +71,30 @@ namespace medvision
 			entries[0x00280101] = { VR::US, "Bits Stored", "BitsStored" };
 			entries[0x00280102] = { VR::US, "High Bit", "HighBit" };
 			entries[0x00280103] = { VR::US, "Pixel Representation", "PixelRepresentation" };
+			entries[0x00280120] = { VR::US, "Pixel Padding Value", "PixelPaddingValue" };
+			entries[0x00280121] = { VR::US, "Pixel Padding Range Limit", "PixelPaddingRangeLimit" };
 			entries[0x00281050] = { VR::DS, "Window Center", "WindowCenter" };
 			entries[0x00281051] = { VR::DS, "Window Width", "WindowWidth" };
 			entries[0x00281052] = { VR::DS, "Rescale Intercept", "RescaleIntercept" };
 			entries[0x00281053] = { VR::DS, "Rescale Slope", "RescaleSlope" };
+			entries[0x00281101] = { VR::US, "Red Palette Color Lookup Table Descriptor", "RedPaletteColorLookupTableDescriptor" };
+			entries[0x00281102] = { VR::US, "Green Palette Color Lookup Table Descriptor", "GreenPaletteColorLookupTableDescriptor" };
+			entries[0x00281103] = { VR::US, "Blue Palette Color Lookup Table Descriptor", "BluePaletteColorLookupTableDescriptor" };
+			entries[0x00281201] = { VR::OW, "Red Palette Color Lookup Table Data", "RedPaletteColorLookupTableData" };
+			entries[0x00281202] = { VR::OW, "Green Palette Color Lookup Table Data", "GreenPaletteColorLookupTableData" };
+			entries[0x00281203] = { VR::OW, "Blue Palette Color Lookup Table Data", "BluePaletteColorLookupTableData" };
+			entries[0x00281221] = { VR::OW, "Segmented Red Palette Color Lookup Table Data", "SegmentedRedPaletteColorLookupTableData" };
+			entries[0x00281222] = { VR::OW, "Segmented Green Palette Color Lookup Table Data", "SegmentedGreenPaletteColorLookupTableData" };
+			entries[0x00281223] = { VR::OW, "Segmented Blue Palette Color Lookup Table Data", "SegmentedBluePaletteColorLookupTableData" };
+
+			// RT Dose
+			entries[0x3004000E] = { VR::DS, "Dose Grid Scaling", "DoseGridScaling" };
 
 			// Pixel Data
+			entries[0x7FE00001] = { VR::OV, "Extended Offset Table", "ExtendedOffsetTable" };
+			entries[0x7FE00002] = { VR::OV, "Extended Offset Table Lengths", "ExtendedOffsetTableLengths" };
+			entries[0x7FE00008] = { VR::OF, "Float Pixel Data", "FloatPixelData" };
+			entries[0x7FE00009] = { VR::OD, "Double Float Pixel Data", "DoubleFloatPixelData" };
 			entries[0x7FE00010] = { VR::OW, "Pixel Data", "PixelData" };
 		}
 
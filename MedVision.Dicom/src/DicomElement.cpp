@@ -8,12 +8,12 @@ namespace medvision
 	{
 
 		DicomElement::DicomElement()
-			: tag_(0, 0), vr_(VR::UNKNOWN), length_(0)
+			: tag_(0, 0), vr_(VR::UNKNOWN), length_(0), undefinedLength_(false)
 		{
 		}
 
 		DicomElement::DicomElement(const DicomTag& tag, VR vr)
-			: tag_(tag), vr_(vr), length_(0)
+			: tag_(tag), vr_(vr), length_(0), undefinedLength_(false)
 		{
 		}
 
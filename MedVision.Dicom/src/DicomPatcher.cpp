@@ -0,0 +1,661 @@
+#include "medvision/dicom/DicomPatcher.h"
+#include "medvision/dicom/ByteSwap.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const uint32_t kUndefinedLength = 0xFFFFFFFF;
+			const uint32_t kPixelDataTag = 0x7FE00010;
+			const uint32_t kTransferSyntaxTag = 0x00020010;
+			const uint32_t kItemTag = 0xFFFEE000;
+			const uint32_t kItemDelimitationTag = 0xFFFEE00D;
+			const uint32_t kSequenceDelimitationTag = 0xFFFEE0DD;
+
+			// Read-ahead while scanning; element headers are small and dense
+			const size_t kWindowSize = 64 * 1024;
+
+			bool IsMetaTag(uint32_t tag)
+			{
+				return (tag >> 16) == 0x0002;
+			}
+		}
+
+		DicomPatcher::DicomPatcher()
+			: fileSize_(0)
+			, tailOffset_(0)
+			, explicitVR_(true)
+			, bigEndian_(false)
+			, windowOffset_(0)
+			, lastMode_(PatchMode::None)
+			, syncOnClose_(false)
+		{
+		}
+
+		DicomPatcher::~DicomPatcher()
+		{
+		}
+
+		bool DicomPatcher::PatchFile(const std::string& filePath, const DicomDataSet& changes)
+		{
+			lastMode_ = PatchMode::None;
+			lastError_.clear();
+			locations_.clear();
+			pieces_.clear();
+			encoded_.clear();
+			window_.clear();
+
+			if (!file_.OpenRead(filePath))
+			{
+				SetError("Cannot open file: " + filePath);
+				return false;
+			}
+
+			bool success = ScanFile() && ValidateChanges(changes);
+			if (success && changes.GetElementCount() > 0)
+			{
+				// Everything must fit for the in-place path; one misfit rewrites the header
+				bool inPlace = true;
+				for (const auto& pair : changes)
+				{
+					const Location* location = FindLocation(pair.first);
+					std::vector<uint8_t> value;
+					EncodeValue(pair.second, bigEndian_ && !IsMetaTag(pair.first), value);
+					if (location == nullptr || !CanPatchInPlace(*location, pair.second, value.size()))
+					{
+						inPlace = false;
+						break;
+					}
+				}
+
+				if (inPlace)
+				{
+					success = file_.OpenReadWrite(filePath) && ApplyInPlace(changes);
+					if (!success && lastError_.empty())
+					{
+						SetError("Cannot open file for writing: " + filePath);
+					}
+				}
+				else
+				{
+					success = ApplyRewrite(filePath, changes);
+				}
+			}
+
+			file_.Close();
+			std::vector<uint8_t>().swap(window_);
+			std::vector<uint8_t>().swap(encoded_);
+			return success;
+		}
+
+		bool DicomPatcher::ScanFile()
+		{
+			if (!file_.GetSize(fileSize_))
+			{
+				SetError("Cannot determine file size");
+				return false;
+			}
+
+			uint64_t position = 0;
+			uint8_t prefix[4];
+			if (fileSize_ >= 132 && ReadBytes(128, prefix, 4) && std::memcmp(prefix, "DICM", 4) == 0)
+			{
+				position = 132;
+			}
+
+			// Meta information is always Explicit VR Little Endian
+			std::string transferSyntax;
+			while (position + 8 <= fileSize_)
+			{
+				uint8_t tag[4];
+				if (!ReadBytes(position, tag, 4) || ToUInt16(tag, false) != 0x0002)
+				{
+					break;
+				}
+
+				Location location;
+				if (!ScanElement(true, false, position, location))
+				{
+					return false;
+				}
+				locations_.push_back(location);
+
+				if (location.tag == kTransferSyntaxTag && location.valueLength <= 64)
+				{
+					char uid[64];
+					if (!ReadBytes(location.valueOffset, reinterpret_cast<uint8_t*>(uid), location.valueLength))
+					{
+						return false;
+					}
+					transferSyntax.assign(uid, location.valueLength);
+					while (!transferSyntax.empty() && (transferSyntax.back() == ' ' || transferSyntax.back() == '\0'))
+					{
+						transferSyntax.pop_back();
+					}
+				}
+			}
+
+			if (TransferSyntax::IsDeflated(transferSyntax))
+			{
+				SetError("Deflated datasets cannot be patched");
+				return false;
+			}
+
+			// Like DicomReader, a file without meta information is taken as Explicit VR Little Endian
+			explicitVR_ = transferSyntax.empty() || TransferSyntax::IsExplicitVR(transferSyntax);
+			bigEndian_ = TransferSyntax::IsBigEndian(transferSyntax);
+
+			// Everything from PixelData onwards is the untouched tail
+			while (position < fileSize_)
+			{
+				uint8_t tag[4];
+				if (position + 8 > fileSize_ || !ReadBytes(position, tag, 4))
+				{
+					SetError("Truncated element header");
+					return false;
+				}
+				uint32_t tagValue = (static_cast<uint32_t>(ToUInt16(tag, bigEndian_)) << 16) | ToUInt16(tag + 2, bigEndian_);
+				if (tagValue >= kPixelDataTag)
+				{
+					break;
+				}
+
+				Location location;
+				if (!ScanElement(explicitVR_, bigEndian_, position, location))
+				{
+					return false;
+				}
+				locations_.push_back(location);
+			}
+			tailOffset_ = position;
+
+			return true;
+		}
+
+		bool DicomPatcher::ScanElement(bool explicitVR, bool bigEndian, uint64_t& position, Location& location)
+		{
+			uint8_t header[12];
+			size_t available = static_cast<size_t>(std::min<uint64_t>(12, fileSize_ - position));
+			if (available < 8 || !ReadBytes(position, header, available))
+			{
+				SetError("Truncated element header");
+				return false;
+			}
+
+			location.tag = (static_cast<uint32_t>(ToUInt16(header, bigEndian)) << 16) | ToUInt16(header + 2, bigEndian);
+			location.offset = position;
+
+			uint32_t headerLength = 8;
+			if (explicitVR)
+			{
+				location.vr = VRUtils::FromString(std::string(reinterpret_cast<const char*>(header + 4), 2));
+				if (VRUtils::HasExplicitLength(location.vr))
+				{
+					if (available < 12)
+					{
+						SetError("Truncated element header");
+						return false;
+					}
+					location.valueLength = ToUInt32(header + 8, bigEndian);
+					headerLength = 12;
+				}
+				else
+				{
+					location.valueLength = ToUInt16(header + 6, bigEndian);
+				}
+			}
+			else
+			{
+				location.vr = VR::UN;
+				location.valueLength = ToUInt32(header + 4, bigEndian);
+			}
+
+			location.valueOffset = position + headerLength;
+			position = location.valueOffset;
+
+			if (location.valueLength == kUndefinedLength)
+			{
+				// UN with undefined length holds an implicit VR sequence
+				bool nestedExplicit = explicitVR && location.vr != VR::UN;
+				if (!SkipUndefinedLength(nestedExplicit, bigEndian, position))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				if (location.valueLength > fileSize_ - position)
+				{
+					SetError("Element value runs past end of file");
+					return false;
+				}
+				position += location.valueLength;
+			}
+
+			location.endOffset = position;
+			return true;
+		}
+
+		bool DicomPatcher::SkipUndefinedLength(bool explicitVR, bool bigEndian, uint64_t& position)
+		{
+			// Items and delimiters carry no VR in either encoding
+			while (true)
+			{
+				uint8_t header[8];
+				if (position + 8 > fileSize_ || !ReadBytes(position, header, 8))
+				{
+					SetError("Unterminated sequence");
+					return false;
+				}
+
+				uint32_t tag = (static_cast<uint32_t>(ToUInt16(header, bigEndian)) << 16) | ToUInt16(header + 2, bigEndian);
+				uint32_t length = ToUInt32(header + 4, bigEndian);
+				position += 8;
+
+				if (tag == kSequenceDelimitationTag)
+				{
+					return true;
+				}
+				if (tag != kItemTag)
+				{
+					SetError("Malformed sequence item");
+					return false;
+				}
+
+				if (length != kUndefinedLength)
+				{
+					if (length > fileSize_ - position)
+					{
+						SetError("Sequence item runs past end of file");
+						return false;
+					}
+					position += length;
+					continue;
+				}
+
+				// Undefined-length item: walk its elements up to the item delimiter
+				while (true)
+				{
+					uint8_t itemTag[4];
+					if (position + 8 > fileSize_ || !ReadBytes(position, itemTag, 4))
+					{
+						SetError("Unterminated sequence item");
+						return false;
+					}
+					uint32_t nestedTag = (static_cast<uint32_t>(ToUInt16(itemTag, bigEndian)) << 16) | ToUInt16(itemTag + 2, bigEndian);
+					if (nestedTag == kItemDelimitationTag)
+					{
+						position += 8;
+						break;
+					}
+
+					Location nested;
+					if (!ScanElement(explicitVR, bigEndian, position, nested))
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		bool DicomPatcher::ReadBytes(uint64_t offset, uint8_t* data, size_t length)
+		{
+			if (offset < windowOffset_ || offset + length > windowOffset_ + window_.size())
+			{
+				if (offset + length > fileSize_)
+				{
+					return false;
+				}
+				size_t windowLength = static_cast<size_t>(std::min<uint64_t>(std::max(kWindowSize, length), fileSize_ - offset));
+				window_.resize(windowLength);
+				windowOffset_ = offset;
+				if (!file_.ReadAt(window_.data(), windowLength, offset))
+				{
+					window_.clear();
+					SetError("Read error");
+					return false;
+				}
+			}
+
+			std::memcpy(data, window_.data() + (offset - windowOffset_), length);
+			return true;
+		}
+
+		uint16_t DicomPatcher::ToUInt16(const uint8_t* data, bool bigEndian) const
+		{
+			return bigEndian
+				? static_cast<uint16_t>((data[0] << 8) | data[1])
+				: static_cast<uint16_t>(data[0] | (data[1] << 8));
+		}
+
+		uint32_t DicomPatcher::ToUInt32(const uint8_t* data, bool bigEndian) const
+		{
+			return bigEndian
+				? (static_cast<uint32_t>(ToUInt16(data, true)) << 16) | ToUInt16(data + 2, true)
+				: ToUInt16(data, false) | (static_cast<uint32_t>(ToUInt16(data + 2, false)) << 16);
+		}
+
+		const DicomPatcher::Location* DicomPatcher::FindLocation(uint32_t tag) const
+		{
+			for (const Location& location : locations_)
+			{
+				if (location.tag == tag)
+				{
+					return &location;
+				}
+			}
+			return nullptr;
+		}
+
+		void DicomPatcher::EncodeValue(const DicomElement& element, bool bigEndian, std::vector<uint8_t>& value) const
+		{
+			value.assign(element.GetData(), element.GetData() + element.GetLength());
+
+			// Values are always even length; UI pads with NUL, other text with space
+			if (value.size() % 2 != 0)
+			{
+				bool spacePadded = VRUtils::IsStringVR(element.GetVR()) && element.GetVR() != VR::UI;
+				value.push_back(spacePadded ? ' ' : '\0');
+			}
+
+			// Edits are built in native (little endian) order
+			if (bigEndian)
+			{
+				ByteSwap::SwapValue(element.GetVR(), value.data(), value.size());
+			}
+		}
+
+		void DicomPatcher::EncodeElement(uint32_t tag, VR vr, const std::vector<uint8_t>& value,
+			bool explicitVR, bool bigEndian, std::vector<uint8_t>& output) const
+		{
+			auto put16 = [&output, bigEndian](uint16_t v)
+			{
+				output.push_back(static_cast<uint8_t>(bigEndian ? (v >> 8) : v));
+				output.push_back(static_cast<uint8_t>(bigEndian ? v : (v >> 8)));
+			};
+			auto put32 = [&put16, bigEndian](uint32_t v)
+			{
+				put16(static_cast<uint16_t>(bigEndian ? (v >> 16) : v));
+				put16(static_cast<uint16_t>(bigEndian ? v : (v >> 16)));
+			};
+
+			uint32_t length = static_cast<uint32_t>(value.size());
+			put16(static_cast<uint16_t>(tag >> 16));
+			put16(static_cast<uint16_t>(tag));
+
+			if (explicitVR)
+			{
+				std::string vrString = VRUtils::ToString(vr);
+				output.insert(output.end(), vrString.begin(), vrString.begin() + 2);
+				if (VRUtils::HasExplicitLength(vr))
+				{
+					put16(0);
+					put32(length);
+				}
+				else
+				{
+					put16(static_cast<uint16_t>(length));
+				}
+			}
+			else
+			{
+				put32(length);
+			}
+
+			output.insert(output.end(), value.begin(), value.end());
+		}
+
+		bool DicomPatcher::CanPatchInPlace(const Location& location, const DicomElement& element, size_t encodedLength) const
+		{
+			if (location.valueLength == kUndefinedLength)
+			{
+				return false;
+			}
+
+			// Explicit VR headers carry the VR, which cannot change in place
+			bool explicitVR = explicitVR_ || IsMetaTag(location.tag);
+			if (explicitVR && location.vr != element.GetVR())
+			{
+				return false;
+			}
+
+			if (encodedLength == location.valueLength)
+			{
+				return true;
+			}
+
+			// Shorter text fits by padding with trailing spaces, which are not significant
+			VR vr = element.GetVR();
+			return encodedLength < location.valueLength && VRUtils::IsStringVR(vr) && vr != VR::UI;
+		}
+
+		bool DicomPatcher::ValidateChanges(const DicomDataSet& changes)
+		{
+			bool hasMetaGroupLength = FindLocation(0x00020000) != nullptr;
+
+			for (const auto& pair : changes)
+			{
+				uint32_t tag = pair.first;
+				const DicomElement& element = pair.second;
+
+				if ((tag & 0xFFFF) == 0x0000)
+				{
+					SetError("Group length elements are maintained automatically");
+					return false;
+				}
+				if (tag == kTransferSyntaxTag)
+				{
+					SetError("Transfer syntax cannot be patched; use DicomWriter to transcode");
+					return false;
+				}
+				if (tag >= kPixelDataTag)
+				{
+					SetError("Only elements before PixelData can be patched");
+					return false;
+				}
+				if (IsMetaTag(tag) && !hasMetaGroupLength && FindLocation(tag) == nullptr)
+				{
+					SetError("Cannot add meta information to a file without a meta group");
+					return false;
+				}
+
+				bool explicitVR = explicitVR_ || IsMetaTag(tag);
+				if (explicitVR && !VRUtils::HasExplicitLength(element.GetVR()) && element.GetLength() > 0xFFFE)
+				{
+					SetError("Value too long for VR " + VRUtils::ToString(element.GetVR()));
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool DicomPatcher::ApplyInPlace(const DicomDataSet& changes)
+		{
+			std::vector<uint8_t> value;
+			for (const auto& pair : changes)
+			{
+				const Location* location = FindLocation(pair.first);
+				EncodeValue(pair.second, bigEndian_ && !IsMetaTag(pair.first), value);
+				value.resize(location->valueLength, ' ');
+
+				if (!file_.WriteAt(value.data(), value.size(), location->valueOffset))
+				{
+					SetError("Write error");
+					return false;
+				}
+			}
+
+			if (syncOnClose_ && !file_.Sync())
+			{
+				SetError("Cannot sync file");
+				return false;
+			}
+
+			lastMode_ = PatchMode::InPlace;
+			return true;
+		}
+
+		bool DicomPatcher::ApplyRewrite(const std::string& filePath, const DicomDataSet& changes)
+		{
+			// Encode every edit up front so the size change of each group is known
+			std::map<uint32_t, std::vector<uint8_t>> encodedEdits;
+			std::map<uint16_t, int64_t> groupDelta;
+			std::vector<uint8_t> value;
+			for (const auto& pair : changes)
+			{
+				bool meta = IsMetaTag(pair.first);
+				std::vector<uint8_t>& bytes = encodedEdits[pair.first];
+				EncodeValue(pair.second, bigEndian_ && !meta, value);
+				EncodeElement(pair.first, pair.second.GetVR(), value, explicitVR_ || meta, bigEndian_ && !meta, bytes);
+
+				const Location* location = FindLocation(pair.first);
+				int64_t oldSize = location ? static_cast<int64_t>(location->endOffset - location->offset) : 0;
+				groupDelta[static_cast<uint16_t>(pair.first >> 16)] += static_cast<int64_t>(bytes.size()) - oldSize;
+			}
+
+			// Preamble and prefix, then the elements interleaved with edits in tag order
+			AddSourcePiece(0, locations_.empty() ? tailOffset_ : locations_.front().offset);
+
+			auto edit = encodedEdits.begin();
+			for (const Location& location : locations_)
+			{
+				for (; edit != encodedEdits.end() && edit->first < location.tag; ++edit)
+				{
+					if (FindLocation(edit->first) == nullptr)
+					{
+						AddEncodedPiece(edit->second);
+					}
+				}
+
+				if (edit != encodedEdits.end() && edit->first == location.tag)
+				{
+					AddEncodedPiece(edit->second);
+					++edit;
+					continue;
+				}
+
+				uint16_t group = static_cast<uint16_t>(location.tag >> 16);
+				bool meta = IsMetaTag(location.tag);
+				if ((location.tag & 0xFFFF) == 0x0000 && location.valueLength == 4 && groupDelta[group] != 0)
+				{
+					uint8_t raw[4];
+					if (!ReadBytes(location.valueOffset, raw, 4))
+					{
+						return false;
+					}
+					uint32_t groupLength = static_cast<uint32_t>(ToUInt32(raw, bigEndian_ && !meta) + groupDelta[group]);
+
+					DicomElement lengthElement(DicomTag(location.tag), VR::UL);
+					lengthElement.SetUInt32(groupLength);
+					std::vector<uint8_t> bytes;
+					EncodeValue(lengthElement, bigEndian_ && !meta, value);
+					EncodeElement(location.tag, VR::UL, value, explicitVR_ || meta, bigEndian_ && !meta, bytes);
+					AddEncodedPiece(bytes);
+					continue;
+				}
+
+				AddSourcePiece(location.offset, location.endOffset - location.offset);
+			}
+			for (; edit != encodedEdits.end(); ++edit)
+			{
+				if (FindLocation(edit->first) == nullptr)
+				{
+					AddEncodedPiece(edit->second);
+				}
+			}
+
+			AddSourcePiece(tailOffset_, fileSize_ - tailOffset_);
+
+			// Write the new file next to the original, then swap it in
+			std::string temporaryPath = filePath + ".tmp";
+			FileHandle output;
+			if (!output.Create(temporaryPath))
+			{
+				SetError("Cannot create file: " + temporaryPath);
+				return false;
+			}
+
+			bool success = true;
+			for (const Piece& piece : pieces_)
+			{
+				success = piece.fromSource
+					? output.CopyFrom(file_.GetDescriptor(), piece.offset, piece.length)
+					: output.Write(encoded_.data() + piece.offset, static_cast<size_t>(piece.length));
+				if (!success)
+				{
+					SetError("Write error");
+					break;
+				}
+			}
+
+			if (success && syncOnClose_ && !output.Sync())
+			{
+				SetError("Cannot sync file");
+				success = false;
+			}
+			output.Close();
+			file_.Close();
+
+			if (success && !FileHandle::Rename(temporaryPath, filePath))
+			{
+				SetError("Cannot replace " + filePath);
+				success = false;
+			}
+			if (!success)
+			{
+				FileHandle::Remove(temporaryPath);
+				return false;
+			}
+
+			if (syncOnClose_ && !FileHandle::SyncDirectory(FileHandle::GetDirectory(filePath)))
+			{
+				SetError("Cannot sync directory");
+				return false;
+			}
+
+			lastMode_ = PatchMode::Rewrite;
+			return true;
+		}
+
+		void DicomPatcher::AddSourcePiece(uint64_t offset, uint64_t length)
+		{
+			if (length == 0)
+			{
+				return;
+			}
+
+			// Adjacent untouched ranges become a single copy
+			if (!pieces_.empty() && pieces_.back().fromSource &&
+				pieces_.back().offset + pieces_.back().length == offset)
+			{
+				pieces_.back().length += length;
+				return;
+			}
+
+			Piece piece = { true, offset, length };
+			pieces_.push_back(piece);
+		}
+
+		void DicomPatcher::AddEncodedPiece(const std::vector<uint8_t>& bytes)
+		{
+			if (!pieces_.empty() && !pieces_.back().fromSource)
+			{
+				pieces_.back().length += bytes.size();
+			}
+			else
+			{
+				Piece piece = { false, encoded_.size(), bytes.size() };
+				pieces_.push_back(piece);
+			}
+			encoded_.insert(encoded_.end(), bytes.begin(), bytes.end());
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -1,6 +1,8 @@
 #include "medvision/dicom/DicomReader.h"
 #include "medvision/dicom/DicomDictionary.h"
 #include "medvision/dicom/TransferSyntax.h"
+#include "medvision/dicom/Deflate.h"
+#include <algorithm>
 #include <fstream>
 #include <cstring>
 
@@ -29,6 +31,7 @@ namespace medvision
 
 		bool DicomReader::ReadFile(const std::string& filePath, DicomDataSet& dataSet)
 		{
+			inflater_.reset();
 			file_.open(filePath, std::ios::binary);
 			if (!file_.is_open())
 			{
@@ -59,6 +62,7 @@ namespace medvision
 
 		bool DicomReader::ReadBuffer(const uint8_t* buffer, size_t length, DicomDataSet& dataSet)
 		{
+			inflater_.reset();
 			buffer_ = buffer;
 			bufferLength_ = length;
 			bufferPos_ = 0;
@@ -118,6 +122,8 @@ namespace medvision
 			isExplicitVR_ = true;
 			isBigEndian_ = false;
 
+			std::string tsUID;
+
 			// Read meta information elements (group 0x0002)
 			while (true)
 			{
@@ -167,37 +173,42 @@ namespace medvision
 				// Extract transfer syntax
 				if (tag == DicomTag::TransferSyntaxUID)
 				{
-					std::string tsUID;
 					element.GetString(tsUID);
 					transferSyntax_ = tsUID;
-					isExplicitVR_ = TransferSyntax::IsExplicitVR(tsUID);
-					isBigEndian_ = TransferSyntax::IsBigEndian(tsUID);
 				}
 			}
 
+			// The rest of group 0002 is little endian too; switch only for the body
+			if (!tsUID.empty())
+			{
+				isExplicitVR_ = TransferSyntax::IsExplicitVR(tsUID);
+				isBigEndian_ = TransferSyntax::IsBigEndian(tsUID);
+			}
+
+			// Everything after the meta information is one raw deflate stream
+			if (TransferSyntax::IsDeflated(tsUID))
+			{
+				inflater_.reset(new InflateStream([this](uint8_t* buffer, size_t capacity) -> size_t {
+					if (file_.is_open())
+					{
+						file_.read(reinterpret_cast<char*>(buffer), capacity);
+						return static_cast<size_t>(file_.gcount());
+					}
+					size_t count = std::min(capacity, bufferLength_ - bufferPos_);
+					std::memcpy(buffer, buffer_ + bufferPos_, count);
+					bufferPos_ += count;
+					return count;
+				}));
+			}
+
 			return true;
 		}
 
 		bool DicomReader::ReadDataSet(DicomDataSet& dataSet)
 		{
 			// Read until end of file/buffer
-			while (true)
+			while (!AtEndOfData())
 			{
-				if (file_.is_open())
-				{
-					if (file_.eof() || file_.peek() == EOF)
-					{
-						break;
-					}
-				}
-				else
-				{
-					if (bufferPos_ >= bufferLength_)
-					{
-						break;
-					}
-				}
-
 				if (!ReadDataElement(dataSet))
 				{
 					// May reach end of data naturally
@@ -205,9 +216,29 @@ namespace medvision
 				}
 			}
 
+			// Unlike a short file, a corrupt deflate stream is always an error
+			if (inflater_ && !inflater_->GetLastError().empty())
+			{
+				SetError("Cannot inflate dataset: " + inflater_->GetLastError());
+				return false;
+			}
+
 			return true;
 		}
 
+		bool DicomReader::AtEndOfData()
+		{
+			if (inflater_)
+			{
+				return inflater_->AtEnd();
+			}
+			if (file_.is_open())
+			{
+				return file_.eof() || file_.peek() == EOF;
+			}
+			return bufferPos_ >= bufferLength_;
+		}
+
 		bool DicomReader::ReadDataElement(DicomDataSet& dataSet)
 		{
 			DicomTag tag;
@@ -237,8 +268,14 @@ namespace medvision
 				return false;
 			}
 
-			// Skip pixel data and sequences for now (basic implementation)
-			if (tag == DicomTag::PixelData || vr == VR::SQ)
+			// Encapsulated (compressed) pixel data: keep the raw fragment stream
+			if (tag == DicomTag::PixelData && length == 0xFFFFFFFF)
+			{
+				return ReadEncapsulatedPixelData(dataSet, vr);
+			}
+
+			// Skip sequences for now (basic implementation)
+			if (vr == VR::SQ)
 			{
 				if (length == 0xFFFFFFFF)
 				{
@@ -248,15 +285,7 @@ namespace medvision
 				}
 
 				// Skip the data
-				if (file_.is_open())
-				{
-					file_.seekg(length, std::ios::cur);
-				}
-				else
-				{
-					bufferPos_ += length;
-				}
-				return true;
+				return SkipBytes(length);
 			}
 
 			std::vector<uint8_t> data;
@@ -272,6 +301,53 @@ namespace medvision
 			return true;
 		}
 
+		bool DicomReader::ReadEncapsulatedPixelData(DicomDataSet& dataSet, VR vr)
+		{
+			// Items are stored exactly as in the file (little endian headers),
+			// up to and including the sequence delimiter
+			std::vector<uint8_t> data;
+			while (true)
+			{
+				DicomTag itemTag;
+				if (!ReadTag(itemTag))
+				{
+					return false;
+				}
+				uint32_t itemLength = ReadUInt32();
+
+				const uint8_t header[8] = {
+					static_cast<uint8_t>(itemTag.GetGroup()), static_cast<uint8_t>(itemTag.GetGroup() >> 8),
+					static_cast<uint8_t>(itemTag.GetElement()), static_cast<uint8_t>(itemTag.GetElement() >> 8),
+					static_cast<uint8_t>(itemLength), static_cast<uint8_t>(itemLength >> 8),
+					static_cast<uint8_t>(itemLength >> 16), static_cast<uint8_t>(itemLength >> 24) };
+				data.insert(data.end(), header, header + 8);
+
+				if (itemTag.GetTag() == 0xFFFEE0DD)
+				{
+					break;
+				}
+				if (itemTag.GetTag() != 0xFFFEE000 || itemLength == 0xFFFFFFFF)
+				{
+					SetError("Malformed encapsulated pixel data");
+					return false;
+				}
+
+				size_t offset = data.size();
+				data.resize(offset + itemLength);
+				if (itemLength > 0 && !ReadBytes(data.data() + offset, itemLength))
+				{
+					SetError("Truncated encapsulated pixel data");
+					return false;
+				}
+			}
+
+			DicomElement element(DicomTag::PixelData, vr);
+			element.SetData(data);
+			element.SetUndefinedLength(true);
+			dataSet.AddElement(element);
+			return true;
+		}
+
 		bool DicomReader::ReadTag(DicomTag& tag)
 		{
 			uint16_t group = ReadUInt16();
@@ -365,6 +441,10 @@ namespace medvision
 
 		bool DicomReader::ReadBytes(uint8_t* buffer, size_t count)
 		{
+			if (inflater_)
+			{
+				return inflater_->Read(buffer, count) == count;
+			}
 			if (file_.is_open())
 			{
 				file_.read(reinterpret_cast<char*>(buffer), count);
@@ -382,6 +462,23 @@ namespace medvision
 			}
 		}
 
+		bool DicomReader::SkipBytes(size_t count)
+		{
+			if (inflater_)
+			{
+				return inflater_->Skip(count) == count;
+			}
+			if (file_.is_open())
+			{
+				file_.seekg(count, std::ios::cur);
+			}
+			else
+			{
+				bufferPos_ += count;
+			}
+			return true;
+		}
+
 		void DicomReader::SetError(const std::string& error)
 		{
 			lastError_ = error;
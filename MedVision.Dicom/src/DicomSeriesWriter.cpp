@@ -0,0 +1,144 @@
+#include "medvision/dicom/DicomSeriesWriter.h"
+#include "medvision/dicom/DicomWriter.h"
+#include "medvision/dicom/FileHandle.h"
+#include "medvision/dicom/ThreadPool.h"
+#include <map>
+#include <mutex>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		DicomSeriesWriter::DicomSeriesWriter(size_t threadCount)
+			: pool_(nullptr)
+			, durable_(true)
+		{
+			if (threadCount == 0)
+			{
+				pool_ = &ThreadPool::Shared();
+			}
+			else
+			{
+				ownedPool_.reset(new ThreadPool(threadCount));
+				pool_ = ownedPool_.get();
+			}
+		}
+
+		DicomSeriesWriter::~DicomSeriesWriter()
+		{
+		}
+
+		std::string DicomSeriesWriter::GetTemporaryPath(const std::string& filePath)
+		{
+			return filePath + ".tmp";
+		}
+
+		size_t DicomSeriesWriter::GetFailureCount() const
+		{
+			size_t failures = 0;
+			for (const SeriesWriteResult& result : results_)
+			{
+				if (!result.success)
+				{
+					++failures;
+				}
+			}
+			return failures;
+		}
+
+		bool DicomSeriesWriter::Write(const std::vector<SeriesWriteItem>& items)
+		{
+			results_.assign(items.size(), SeriesWriteResult());
+
+			std::mutex progressMutex;
+			size_t completed = 0;
+
+			// Phase 1: encode and write every instance to its temporary file
+			pool_->ParallelFor(items.size(), [&](size_t index)
+			{
+				const SeriesWriteItem& item = items[index];
+				SeriesWriteResult& result = results_[index];
+				result.filePath = item.filePath;
+				result.success = false;
+
+				if (item.dataSet == nullptr)
+				{
+					result.error = "No dataset";
+				}
+				else
+				{
+					DicomWriter writer;
+					if (!transferSyntax_.empty())
+					{
+						writer.SetTransferSyntax(transferSyntax_);
+					}
+					writer.SetSyncOnClose(durable_);
+
+					std::string temporaryPath = GetTemporaryPath(item.filePath);
+					if (writer.WriteFile(temporaryPath, *item.dataSet))
+					{
+						result.success = true;
+					}
+					else
+					{
+						result.error = writer.GetLastError();
+						FileHandle::Remove(temporaryPath);
+					}
+				}
+
+				std::lock_guard<std::mutex> lock(progressMutex);
+				++completed;
+				if (progress_)
+				{
+					progress_(completed, items.size());
+				}
+			});
+
+			// Phase 2: rename into place and sync each directory once
+			Commit();
+
+			return GetFailureCount() == 0;
+		}
+
+		void DicomSeriesWriter::Commit()
+		{
+			std::map<std::string, std::vector<size_t>> byDirectory;
+			for (size_t i = 0; i < results_.size(); ++i)
+			{
+				if (results_[i].success)
+				{
+					byDirectory[FileHandle::GetDirectory(results_[i].filePath)].push_back(i);
+				}
+			}
+
+			for (const auto& directory : byDirectory)
+			{
+				for (size_t index : directory.second)
+				{
+					SeriesWriteResult& result = results_[index];
+					std::string temporaryPath = GetTemporaryPath(result.filePath);
+					if (!FileHandle::Rename(temporaryPath, result.filePath))
+					{
+						result.success = false;
+						result.error = "Cannot rename " + temporaryPath + " to " + result.filePath;
+						FileHandle::Remove(temporaryPath);
+					}
+				}
+
+				if (durable_ && !FileHandle::SyncDirectory(directory.first))
+				{
+					for (size_t index : directory.second)
+					{
+						if (results_[index].success)
+						{
+							results_[index].success = false;
+							results_[index].error = "Cannot sync directory " + directory.first;
+						}
+					}
+				}
+			}
+		}
+
+	} // namespace dicom
+} // namespace medvision
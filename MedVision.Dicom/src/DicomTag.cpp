@@ -37,10 +37,28 @@ namespace medvision
 		const DicomTag DicomTag::PixelRepresentation(0x0028, 0x0103);
 		const DicomTag DicomTag::SamplesPerPixel(0x0028, 0x0002);
 		const DicomTag DicomTag::PhotometricInterpretation(0x0028, 0x0004);
+		const DicomTag DicomTag::PlanarConfiguration(0x0028, 0x0006);
+		const DicomTag DicomTag::NumberOfFrames(0x0028, 0x0008);
+		const DicomTag DicomTag::PixelPaddingValue(0x0028, 0x0120);
+		const DicomTag DicomTag::PixelPaddingRangeLimit(0x0028, 0x0121);
 		const DicomTag DicomTag::WindowCenter(0x0028, 0x1050);
 		const DicomTag DicomTag::WindowWidth(0x0028, 0x1051);
 		const DicomTag DicomTag::RescaleIntercept(0x0028, 0x1052);
 		const DicomTag DicomTag::RescaleSlope(0x0028, 0x1053);
+		const DicomTag DicomTag::RedPaletteColorLookupTableDescriptor(0x0028, 0x1101);
+		const DicomTag DicomTag::GreenPaletteColorLookupTableDescriptor(0x0028, 0x1102);
+		const DicomTag DicomTag::BluePaletteColorLookupTableDescriptor(0x0028, 0x1103);
+		const DicomTag DicomTag::RedPaletteColorLookupTableData(0x0028, 0x1201);
+		const DicomTag DicomTag::GreenPaletteColorLookupTableData(0x0028, 0x1202);
+		const DicomTag DicomTag::BluePaletteColorLookupTableData(0x0028, 0x1203);
+		const DicomTag DicomTag::SegmentedRedPaletteColorLookupTableData(0x0028, 0x1221);
+		const DicomTag DicomTag::SegmentedGreenPaletteColorLookupTableData(0x0028, 0x1222);
+		const DicomTag DicomTag::SegmentedBluePaletteColorLookupTableData(0x0028, 0x1223);
+		const DicomTag DicomTag::DoseGridScaling(0x3004, 0x000E);
+		const DicomTag DicomTag::ExtendedOffsetTable(0x7FE0, 0x0001);
+		const DicomTag DicomTag::ExtendedOffsetTableLengths(0x7FE0, 0x0002);
+		const DicomTag DicomTag::FloatPixelData(0x7FE0, 0x0008);
+		const DicomTag DicomTag::DoubleFloatPixelData(0x7FE0, 0x0009);
 		const DicomTag DicomTag::PixelData(0x7FE0, 0x0010);
 
 		DicomTag::DicomTag() : group_(0), element_(0)
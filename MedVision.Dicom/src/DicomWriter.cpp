@@ -1,105 +1,752 @@
 #include "medvision/dicom/DicomWriter.h"
 #include "medvision/dicom/TransferSyntax.h"
+#include "medvision/dicom/ByteSwap.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/Deflate.h"
+#include "medvision/dicom/EncapsulatedPixelData.h"
+#include "medvision/dicom/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
 #include <cstring>
+#include <string>
 
 namespace medvision
 {
 	namespace dicom
 	{
 
+		namespace
+		{
+			// Values up to this size are copied next to their header instead of
+			// becoming a separate segment (cheaper than an extra iovec entry)
+			const size_t kInlineValueLimit = 256;
+
+			// Flush pending segments once this much header data is staged
+			const size_t kStagingFlushThreshold = 256 * 1024;
+
+			// Scratch size for byte-swapping large values during transcoding
+			const size_t kSwapChunkSize = 1024 * 1024;
+		}
+
 		DicomWriter::DicomWriter()
-			: outputBuffer_(nullptr)
+			: directOutput_(nullptr)
+			, directCapacity_(0)
+			, directPosition_(0)
+			, bufferOutput_(nullptr)
 			, isExplicitVR_(true)
 			, isBigEndian_(false)
-			, transferSyntax_(TransferSyntax::ExplicitVRLittleEndian)
+			, syncOnClose_(false)
+			, swapValues_(false)
+			, encodePixelData_(false)
 		{
 		}
 
 		DicomWriter::~DicomWriter()
 		{
-			if (file_.is_open())
+			file_.Close();
+		}
+
+		bool DicomWriter::WriteFile(const std::string& filePath, const DicomDataSet& dataSet)
+		{
+			ResetOutput();
+
+			if (!BeginWrite(dataSet))
+			{
+				return false;
+			}
+
+			if (!file_.Create(filePath))
 			{
-				file_.close();
+				SetError("Cannot create file: " + filePath);
+				ResetOutput();
+				return false;
 			}
+
+			bool success = WritePreamble()
+				&& WriteMetaInformation(dataSet)
+				&& BeginDeflate()
+				&& WriteDataSet(dataSet)
+				&& Flush()
+				&& EndDeflate();
+
+			success = CloseFile(success);
+			ResetOutput();
+			return success;
 		}
 
-		bool DicomWriter::WriteFile(const std::string& filePath, const DicomDataSet& dataSet)
+		bool DicomWriter::WriteFile(const std::string& filePath, const DicomDataSet& dataSet, PixelDataSource& pixelData)
 		{
-			file_.open(filePath, std::ios::binary);
-			if (!file_.is_open())
+			const uint32_t pixelDataTag = DicomTag::PixelData.GetTag();
+
+			// Defined-length element; values are padded to even length
+			uint64_t valueLength = pixelData.GetLength();
+			uint64_t paddedLength = valueLength + (valueLength & 1);
+			if (paddedLength > 0xFFFFFFFEull)
+			{
+				SetError("PixelData too large for a defined-length element");
+				return false;
+			}
+
+			ResetOutput();
+
+			// The dataset's own PixelData is ignored, so it is never encoded here
+			if (!BeginWrite(dataSet, false))
+			{
+				return false;
+			}
+
+			if (TransferSyntax::IsCompressed(activeSyntax_) || TransferSyntax::IsDeflated(activeSyntax_))
+			{
+				SetError("Streamed pixel data cannot be written with " + TransferSyntax::GetName(activeSyntax_));
+				ResetOutput();
+				return false;
+			}
+
+			// The source writes straight into the file, so its words cannot be swapped on the way
+			if (swapValues_ && ByteSwap::GetSwapUnit(pixelData.GetVR()) > 1)
+			{
+				SetError("Streamed " + VRUtils::ToString(pixelData.GetVR()) + " pixel data cannot be byte swapped to " +
+					TransferSyntax::GetName(activeSyntax_));
+				ResetOutput();
+				return false;
+			}
+
+			if (!file_.Create(filePath))
 			{
 				SetError("Cannot create file: " + filePath);
+				ResetOutput();
+				return false;
+			}
+
+			bool success = WritePreamble()
+				&& WriteMetaInformation(dataSet)
+				&& WriteDataSet(dataSet, 0, pixelDataTag)
+				&& WriteTag(DicomTag::PixelData)
+				&& (!isExplicitVR_ || WriteVR(pixelData.GetVR()))
+				&& WriteLength(static_cast<uint32_t>(paddedLength), pixelData.GetVR())
+				&& Flush();
+
+			// The value goes straight from the source to the file
+			if (success && !pixelData.WriteTo(file_))
+			{
+				SetError("Failed to stream pixel data: " + pixelData.GetLastError());
+				success = false;
+			}
+
+			if (success && paddedLength != valueLength)
+			{
+				const uint8_t pad = 0;
+				WriteBytes(&pad, 1);
+			}
+
+			success = success
+				&& WriteDataSet(dataSet, pixelDataTag + 1)
+				&& Flush();
+
+			success = CloseFile(success);
+			ResetOutput();
+			return success;
+		}
+
+		bool DicomWriter::WriteFile(const std::string& filePath, const DicomDataSet& dataSet, EncapsulatedFrameSource& frames)
+		{
+			const uint32_t pixelDataTag = DicomTag::PixelData.GetTag();
+			const uint32_t frameCount = frames.GetFrameCount();
+			const uint64_t tableLength = static_cast<uint64_t>(frameCount) * 8;
+			if (frameCount == 0 || tableLength > 0xFFFFFFFEull)
+			{
+				SetError("Invalid frame count for an Extended Offset Table");
 				return false;
 			}
 
-			if (!WritePreamble())
+			ResetOutput();
+
+			if (!BeginWrite(dataSet, false))
 			{
-				file_.close();
 				return false;
 			}
 
-			if (!WriteMetaInformation(dataSet))
+			if (!TransferSyntax::IsCompressed(activeSyntax_))
 			{
-				file_.close();
+				SetError("Encapsulated pixel data cannot be written with " + TransferSyntax::GetName(activeSyntax_));
+				ResetOutput();
 				return false;
 			}
 
-			if (!WriteDataSet(dataSet))
+			if (!file_.Create(filePath))
 			{
-				file_.close();
+				SetError("Cannot create file: " + filePath);
+				ResetOutput();
 				return false;
 			}
 
-			file_.close();
-			return true;
+			// Both tables are written as zeros and patched once the frame sizes are known
+			std::vector<uint8_t> table(static_cast<size_t>(tableLength), 0);
+			uint64_t tablePosition = 0;
+			bool success = WritePreamble()
+				&& WriteMetaInformation(dataSet)
+				&& WriteDataSet(dataSet, 0, DicomTag::ExtendedOffsetTable.GetTag())
+				&& WriteTag(DicomTag::ExtendedOffsetTable)
+				&& WriteVR(VR::OV)
+				&& WriteLength(static_cast<uint32_t>(tableLength), VR::OV)
+				&& Flush()
+				&& file_.GetSize(tablePosition)
+				&& WriteData(table.data(), static_cast<uint32_t>(tableLength), VR::OB)
+				&& WriteTag(DicomTag::ExtendedOffsetTableLengths)
+				&& WriteVR(VR::OV)
+				&& WriteLength(static_cast<uint32_t>(tableLength), VR::OV)
+				&& WriteData(table.data(), static_cast<uint32_t>(tableLength), VR::OB)
+				&& WriteDataSet(dataSet, DicomTag::ExtendedOffsetTableLengths.GetTag() + 1, pixelDataTag)
+				&& WriteTag(DicomTag::PixelData)
+				&& WriteVR(VR::OB)
+				&& WriteLength(0xFFFFFFFF, VR::OB)
+				&& WriteItemHeader(0xE000, 0)   // The Basic Offset Table stays empty
+				&& Flush();
+
+			// One fragment per frame; offsets count from the first fragment item
+			std::vector<uint64_t> offsets;
+			std::vector<uint64_t> lengths;
+			std::vector<uint8_t> frame;
+			uint64_t offset = 0;
+			for (uint32_t i = 0; success && i < frameCount; ++i)
+			{
+				frame.clear();
+				if (!frames.GetFrame(i, frame))
+				{
+					SetError("Failed to get frame " + std::to_string(i));
+					success = false;
+					break;
+				}
+
+				uint64_t itemLength = frame.size() + (frame.size() & 1);
+				if (itemLength > 0xFFFFFFFEull)
+				{
+					SetError("Frame " + std::to_string(i) + " is too large for one fragment");
+					success = false;
+					break;
+				}
+
+				offsets.push_back(offset);
+				lengths.push_back(itemLength);
+				offset += 8 + itemLength;
+
+				success = WriteItemHeader(0xE000, static_cast<uint32_t>(itemLength))
+					&& WriteData(frame.data(), static_cast<uint32_t>(frame.size()), VR::OB);
+				if (success && itemLength != frame.size())
+				{
+					const uint8_t pad = 0;
+					WriteBytes(&pad, 1);
+				}
+				success = success && Flush();
+			}
+
+			success = success
+				&& WriteItemHeader(0xE0DD, 0)
+				&& WriteDataSet(dataSet, pixelDataTag + 1)
+				&& Flush();
+
+			if (success)
+			{
+				// Lengths follow the offsets after their own 12-byte element header
+				const std::vector<uint64_t>* values[2] = { &offsets, &lengths };
+				for (int t = 0; t < 2 && success; ++t)
+				{
+					for (uint32_t i = 0; i < frameCount; ++i)
+					{
+						for (int b = 0; b < 8; ++b)
+						{
+							table[i * 8 + b] = static_cast<uint8_t>((*values[t])[i] >> (8 * b));
+						}
+					}
+					success = file_.WriteAt(table.data(), table.size(), tablePosition + t * (tableLength + 12));
+				}
+				if (!success)
+				{
+					SetError("Failed to write the Extended Offset Table");
+				}
+			}
+
+			success = CloseFile(success);
+			ResetOutput();
+			return success;
 		}
 
 		bool DicomWriter::WriteBuffer(std::vector<uint8_t>& buffer, const DicomDataSet& dataSet)
 		{
-			outputBuffer_ = &buffer;
+			ResetOutput();
+			if (!BeginWrite(dataSet))
+			{
+				buffer.clear();
+				return false;
+			}
+
+			if (TransferSyntax::IsDeflated(activeSyntax_))
+			{
+				return WriteDeflated(buffer, dataSet);
+			}
+
+			// Sizing pass first so the output is allocated exactly once
+			buffer.resize(ComputeEncodedSize(dataSet, activeSyntax_, encodePixelData_ ? &encodedPixelData_ : nullptr));
+
+			size_t bytesWritten = 0;
+			bool success = WriteDirect(buffer.data(), buffer.size(), dataSet, bytesWritten);
+			ResetOutput();
+			if (!success)
+			{
+				buffer.clear();
+				return false;
+			}
+
+			buffer.resize(bytesWritten);
+			return true;
+		}
+
+		bool DicomWriter::WriteBuffer(uint8_t* destination, size_t capacity, const DicomDataSet& dataSet, size_t& bytesWritten)
+		{
+			bytesWritten = 0;
+
+			ResetOutput();
+			if (!BeginWrite(dataSet))
+			{
+				return false;
+			}
+
+			// The deflated size is unknown up front; compress, then copy if it fits
+			if (TransferSyntax::IsDeflated(activeSyntax_))
+			{
+				std::vector<uint8_t> deflated;
+				if (!WriteDeflated(deflated, dataSet))
+				{
+					return false;
+				}
+				if (destination == nullptr || capacity < deflated.size())
+				{
+					SetError("Output buffer too small: " + std::to_string(deflated.size()) + " bytes required");
+					return false;
+				}
+				std::memcpy(destination, deflated.data(), deflated.size());
+				bytesWritten = deflated.size();
+				return true;
+			}
+
+			size_t requiredSize = ComputeEncodedSize(dataSet, activeSyntax_, encodePixelData_ ? &encodedPixelData_ : nullptr);
+			if (destination == nullptr || capacity < requiredSize)
+			{
+				SetError("Output buffer too small: " + std::to_string(requiredSize) + " bytes required");
+				ResetOutput();
+				return false;
+			}
+
+			bool success = WriteDirect(destination, capacity, dataSet, bytesWritten);
+			ResetOutput();
+			return success;
+		}
+
+		bool DicomWriter::WriteDirect(uint8_t* destination, size_t capacity, const DicomDataSet& dataSet, size_t& bytesWritten)
+		{
+			directOutput_ = destination;
+			directCapacity_ = capacity;
+			directPosition_ = 0;
+
+			bool success = WritePreamble()
+				&& WriteMetaInformation(dataSet)
+				&& WriteDataSet(dataSet);
+
+			bytesWritten = directPosition_;
+			directOutput_ = nullptr;
+			directCapacity_ = 0;
+			directPosition_ = 0;
+			return success;
+		}
+
+		bool DicomWriter::WriteDeflated(std::vector<uint8_t>& buffer, const DicomDataSet& dataSet)
+		{
 			buffer.clear();
+			bufferOutput_ = &buffer;
+
+			bool success = WritePreamble()
+				&& WriteMetaInformation(dataSet)
+				&& BeginDeflate()
+				&& WriteDataSet(dataSet)
+				&& Flush()
+				&& EndDeflate();
+
+			bufferOutput_ = nullptr;
+			ResetOutput();
+			if (!success)
+			{
+				buffer.clear();
+			}
+			return success;
+		}
 
-			if (!WritePreamble())
+		bool DicomWriter::BeginDeflate()
+		{
+			if (!TransferSyntax::IsDeflated(activeSyntax_))
+			{
+				return true;
+			}
+
+			// The meta information stays uncompressed
+			if (!Flush())
 			{
 				return false;
 			}
 
-			if (!WriteMetaInformation(dataSet))
+			deflater_.reset(new DeflateStream([this](const uint8_t* data, size_t length) {
+				if (bufferOutput_ != nullptr)
+				{
+					bufferOutput_->insert(bufferOutput_->end(), data, data + length);
+					return true;
+				}
+				return file_.Write(data, length);
+			}));
+			return true;
+		}
+
+		bool DicomWriter::EndDeflate()
+		{
+			if (!deflater_)
+			{
+				return true;
+			}
+
+			bool success = deflater_->Finish();
+
+			// The deflated stream is padded to even length like any value
+			bool pad = (deflater_->GetOutputLength() & 1) != 0;
+			deflater_.reset();
+			if (success && pad)
+			{
+				const uint8_t zero = 0;
+				WriteBytes(&zero, 1);
+				success = Flush();
+			}
+			if (!success)
 			{
+				SetError("Failed to write deflated data");
+			}
+			return success;
+		}
+
+		size_t DicomWriter::GetEncodedSize(const DicomDataSet& dataSet) const
+		{
+			std::string targetSyntax = ResolveTransferSyntax(dataSet);
+
+			// Only compressing tells how small the body gets
+			if (TransferSyntax::IsDeflated(targetSyntax))
+			{
+				DicomWriter writer;
+				writer.SetTransferSyntax(targetSyntax);
+				std::vector<uint8_t> buffer;
+				return writer.WriteBuffer(buffer, dataSet) ? buffer.size() : 0;
+			}
+
+			// The compressed size is only known after encoding
+			DicomElement encoded;
+			std::string error;
+			if (NeedsPixelEncoding(dataSet, targetSyntax) &&
+				EncodePixelData(dataSet, targetSyntax, encoded, error))
+			{
+				return ComputeEncodedSize(dataSet, targetSyntax, &encoded);
+			}
+			return ComputeEncodedSize(dataSet, targetSyntax, nullptr);
+		}
+
+		size_t DicomWriter::ComputeEncodedSize(const DicomDataSet& dataSet, const std::string& targetSyntax, const DicomElement* pixelData) const
+		{
+			// Preamble + DICM prefix
+			size_t size = 132;
+
+			bool explicitVR = TransferSyntax::IsExplicitVR(targetSyntax);
+
+			uint32_t metaLength = ComputeMetaGroupLength(dataSet, targetSyntax);
+			if (metaLength > 0)
+			{
+				// Group length element (UL) + the rest of the meta group
+				size += 12 + metaLength;
+			}
+
+			for (const auto& pair : dataSet)
+			{
+				const DicomElement& element = pair.second;
+				if (pixelData != nullptr && pair.first == DicomTag::PixelData.GetTag())
+				{
+					size += GetElementEncodedSize(*pixelData, explicitVR);
+				}
+				else if (element.GetTag().GetGroup() != 0x0002)
+				{
+					size += GetElementEncodedSize(element, explicitVR);
+				}
+			}
+
+			return size;
+		}
+
+		size_t DicomWriter::GetElementEncodedSize(const DicomElement& element, bool explicitVR) const
+		{
+			size_t headerSize = 8;
+			if (explicitVR && VRUtils::HasExplicitLength(element.GetVR()))
+			{
+				headerSize = 12;
+			}
+			return headerSize + element.GetLength();
+		}
+
+		uint32_t DicomWriter::ComputeMetaGroupLength(const DicomDataSet& dataSet, const std::string& targetSyntax) const
+		{
+			DicomElement transferSyntax(DicomTag::TransferSyntaxUID, VR::UI);
+			transferSyntax.SetString(targetSyntax);
+
+			std::vector<const DicomElement*> metaElements;
+			CollectMetaElements(dataSet, transferSyntax, metaElements);
+
+			// Everything in group 0002 after the group length element itself;
+			// meta information is always Explicit VR Little Endian
+			size_t length = 0;
+			for (const DicomElement* element : metaElements)
+			{
+				length += GetElementEncodedSize(*element, true);
+			}
+			return static_cast<uint32_t>(length);
+		}
+
+		void DicomWriter::CollectMetaElements(const DicomDataSet& dataSet, const DicomElement& transferSyntax, std::vector<const DicomElement*>& elements) const
+		{
+			const uint32_t transferSyntaxTag = DicomTag::TransferSyntaxUID.GetTag();
+			bool hasMeta = false;
+			bool transferSyntaxWritten = false;
+
+			elements.clear();
+			for (const auto& pair : dataSet)
+			{
+				const DicomElement& element = pair.second;
+				if (element.GetTag().GetGroup() != 0x0002)
+				{
+					continue;
+				}
+				hasMeta = true;
+
+				if (element.GetTag() == DicomTag::FileMetaInformationGroupLength)
+				{
+					continue;
+				}
+
+				// The written transfer syntax always describes the written body
+				if (!transferSyntaxWritten && pair.first >= transferSyntaxTag)
+				{
+					elements.push_back(&transferSyntax);
+					transferSyntaxWritten = true;
+					if (pair.first == transferSyntaxTag)
+					{
+						continue;
+					}
+				}
+				elements.push_back(&element);
+			}
+
+			if (hasMeta && !transferSyntaxWritten)
+			{
+				elements.push_back(&transferSyntax);
+			}
+		}
+
+		std::string DicomWriter::ResolveTransferSyntax(const DicomDataSet& dataSet) const
+		{
+			if (!transferSyntax_.empty())
+			{
+				return transferSyntax_;
+			}
+
+			std::string sourceSyntax;
+			if (dataSet.GetString(DicomTag::TransferSyntaxUID, sourceSyntax) && !sourceSyntax.empty())
+			{
+				return sourceSyntax;
+			}
+			return TransferSyntax::ExplicitVRLittleEndian;
+		}
+
+		std::string DicomWriter::GetSourceSyntax(const DicomDataSet& dataSet)
+		{
+			std::string sourceSyntax;
+			if (!dataSet.GetString(DicomTag::TransferSyntaxUID, sourceSyntax) || sourceSyntax.empty())
+			{
+				// Values built in memory are in the library's native (little endian) order
+				sourceSyntax = TransferSyntax::ExplicitVRLittleEndian;
+			}
+			return sourceSyntax;
+		}
+
+		bool DicomWriter::NeedsPixelEncoding(const DicomDataSet& dataSet, const std::string& targetSyntax)
+		{
+			const DicomElement* pixelData = dataSet.GetElement(DicomTag::PixelData);
+			return TransferSyntax::IsCompressed(targetSyntax)
+				&& !TransferSyntax::IsCompressed(GetSourceSyntax(dataSet))
+				&& pixelData != nullptr && !pixelData->IsUndefinedLength();
+		}
+
+		bool DicomWriter::EncodePixelData(const DicomDataSet& dataSet, const std::string& targetSyntax, DicomElement& encoded, std::string& error) const
+		{
+			std::shared_ptr<const PixelEncoder> encoder = CodecRegistry::Instance().FindEncoder(targetSyntax);
+			if (!encoder)
+			{
+				error = "No encoder registered for " + TransferSyntax::GetName(targetSyntax);
 				return false;
 			}
 
-			if (!WriteDataSet(dataSet))
+			FrameInfo info;
+			dataSet.GetUInt16(DicomTag::Rows, info.rows);
+			dataSet.GetUInt16(DicomTag::Columns, info.columns);
+			dataSet.GetUInt16(DicomTag::SamplesPerPixel, info.samplesPerPixel);
+			dataSet.GetUInt16(DicomTag::BitsAllocated, info.bitsAllocated);
+			dataSet.GetUInt16(DicomTag::BitsStored, info.bitsStored);
+			dataSet.GetUInt16(DicomTag::PixelRepresentation, info.pixelRepresentation);
+			dataSet.GetUInt16(DicomTag::PlanarConfiguration, info.planarConfiguration);
+			dataSet.GetString(DicomTag::PhotometricInterpretation, info.photometricInterpretation);
+
+			// US values are stored in the source byte order like everything else
+			const bool sourceBigEndian = TransferSyntax::IsBigEndian(GetSourceSyntax(dataSet));
+			if (sourceBigEndian)
+			{
+				uint16_t* fields[] = { &info.rows, &info.columns, &info.samplesPerPixel, &info.bitsAllocated,
+					&info.bitsStored, &info.pixelRepresentation, &info.planarConfiguration };
+				for (uint16_t* field : fields)
+				{
+					*field = static_cast<uint16_t>((*field << 8) | (*field >> 8));
+				}
+			}
+
+			// A missing, malformed or zero NumberOfFrames means a single frame
+			size_t frameCount = 1;
+			std::string framesStr;
+			if (dataSet.GetString(DicomTag::NumberOfFrames, framesStr) && !framesStr.empty())
+			{
+				char* end = nullptr;
+				unsigned long frames = std::strtoul(framesStr.c_str(), &end, 10);
+				while (end != nullptr && *end == ' ')
+				{
+					++end;
+				}
+				if (end != framesStr.c_str() && end != nullptr && *end == '\0' && frames > 0)
+				{
+					frameCount = static_cast<size_t>(frames);
+				}
+			}
+
+			const DicomElement* pixelData = dataSet.GetElement(DicomTag::PixelData);
+			size_t frameLength = info.GetFrameLength();
+			if (frameLength == 0 || frameCount == 0 || pixelData->GetLength() / frameLength < frameCount)
 			{
+				error = "PixelData does not match the image attributes";
 				return false;
 			}
 
-			outputBuffer_ = nullptr;
+			// Encoders take little endian samples
+			const uint8_t* pixels = pixelData->GetData();
+			std::vector<uint8_t> littleEndian;
+			if (sourceBigEndian)
+			{
+				littleEndian.resize(pixelData->GetLength());
+				ByteSwap::CopySwappedValue(pixelData->GetVR(), littleEndian.data(), pixels, littleEndian.size());
+				pixels = littleEndian.data();
+			}
+
+			std::vector<std::vector<uint8_t>> fragments(frameCount);
+			std::atomic<bool> failed(false);
+			std::mutex errorMutex;
+			auto encodeFrame = [&](size_t frame)
+			{
+				std::string frameError;
+				if (failed || encoder->EncodeFrame(pixels + frame * frameLength, info, fragments[frame], frameError))
+				{
+					return;
+				}
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!failed.exchange(true))
+				{
+					error = "Frame " + std::to_string(frame) + ": " + frameError;
+				}
+			};
+
+			if ((encoder->GetCapabilities() & CodecMultiFrameParallel) && frameCount > 1)
+			{
+				ThreadPool::Shared().ParallelFor(frameCount, encodeFrame);
+			}
+			else
+			{
+				for (size_t frame = 0; frame < frameCount && !failed; ++frame)
+				{
+					encodeFrame(frame);
+				}
+			}
+			if (failed)
+			{
+				return false;
+			}
+
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData::Build(fragments, stream);
+
+			encoded = DicomElement(DicomTag::PixelData, VR::OB);
+			encoded.SetData(stream);
+			encoded.SetUndefinedLength(true);
+			return true;
+		}
+
+		bool DicomWriter::BeginWrite(const DicomDataSet& dataSet, bool usePixelData)
+		{
+			std::string sourceSyntax = GetSourceSyntax(dataSet);
+
+			activeSyntax_ = ResolveTransferSyntax(dataSet);
+			isExplicitVR_ = TransferSyntax::IsExplicitVR(activeSyntax_);
+			isBigEndian_ = TransferSyntax::IsBigEndian(activeSyntax_);
+
+			encodePixelData_ = false;
+			if (usePixelData && activeSyntax_ != sourceSyntax &&
+				(TransferSyntax::IsCompressed(activeSyntax_) || TransferSyntax::IsCompressed(sourceSyntax)))
+			{
+				// Native pixel data can be compressed through the CodecRegistry;
+				// decompressing or recompressing goes through DicomImage instead
+				if (TransferSyntax::IsCompressed(sourceSyntax))
+				{
+					SetError("Cannot transcode between " + TransferSyntax::GetName(sourceSyntax) +
+						" and " + TransferSyntax::GetName(activeSyntax_));
+					return false;
+				}
+
+				if (NeedsPixelEncoding(dataSet, activeSyntax_))
+				{
+					std::string error;
+					if (!EncodePixelData(dataSet, activeSyntax_, encodedPixelData_, error))
+					{
+						SetError(error);
+						return false;
+					}
+					encodePixelData_ = true;
+				}
+			}
+
+			// Values are stored as read; only the byte order may need converting
+			swapValues_ = TransferSyntax::IsBigEndian(sourceSyntax) != isBigEndian_;
 			return true;
 		}
 
 		void DicomWriter::SetTransferSyntax(const std::string& transferSyntaxUID)
 		{
 			transferSyntax_ = transferSyntaxUID;
-			isExplicitVR_ = TransferSyntax::IsExplicitVR(transferSyntaxUID);
-			isBigEndian_ = TransferSyntax::IsBigEndian(transferSyntaxUID);
 		}
 
 		bool DicomWriter::WritePreamble()
 		{
 			// Write 128-byte preamble (all zeros)
 			uint8_t preamble[128] = { 0 };
-			if (!WriteBytes(preamble, 128))
-			{
-				return false;
-			}
+			WriteBytes(preamble, 128);
 
 			// Write DICM prefix
 			const char dicm[4] = { 'D', 'I', 'C', 'M' };
-			if (!WriteBytes(reinterpret_cast<const uint8_t*>(dicm), 4))
-			{
-				return false;
-			}
+			WriteBytes(reinterpret_cast<const uint8_t*>(dicm), 4);
 
 			return true;
 		}
@@ -113,33 +760,53 @@ namespace medvision
 			isExplicitVR_ = true;
 			isBigEndian_ = false;
 
-			// Write meta information elements (group 0x0002)
-			for (const auto& pair : dataSet)
+			bool savedSwapValues = swapValues_;
+			swapValues_ = false;
+
+			DicomElement transferSyntax(DicomTag::TransferSyntaxUID, VR::UI);
+			transferSyntax.SetString(activeSyntax_);
+
+			std::vector<const DicomElement*> metaElements;
+			CollectMetaElements(dataSet, transferSyntax, metaElements);
+
+			bool success = true;
+
+			// Group length is always recomputed from the sizing pass
+			if (!metaElements.empty())
 			{
-				const DicomElement& element = pair.second;
-				if (element.GetTag().GetGroup() == 0x0002)
+				size_t metaLength = 0;
+				for (const DicomElement* element : metaElements)
 				{
-					if (!WriteDataElement(element))
-					{
-						return false;
-					}
+					metaLength += GetElementEncodedSize(*element, true);
 				}
+
+				DicomElement groupLength(DicomTag::FileMetaInformationGroupLength, VR::UL);
+				groupLength.SetUInt32(static_cast<uint32_t>(metaLength));
+				success = WriteDataElement(groupLength);
+			}
+
+			// Write meta information elements (group 0x0002)
+			for (size_t i = 0; success && i < metaElements.size(); ++i)
+			{
+				success = WriteDataElement(*metaElements[i]);
 			}
 
 			// Restore transfer syntax settings
 			isExplicitVR_ = savedExplicitVR;
 			isBigEndian_ = savedBigEndian;
+			swapValues_ = savedSwapValues;
 
-			return true;
+			return success;
 		}
 
-		bool DicomWriter::WriteDataSet(const DicomDataSet& dataSet)
+		bool DicomWriter::WriteDataSet(const DicomDataSet& dataSet, uint32_t beginTag, uint32_t endTag)
 		{
-			// Write all non-meta information elements
-			for (const auto& pair : dataSet)
+			// Write all non-meta information elements in [beginTag, endTag)
+			for (auto it = dataSet.begin(); it != dataSet.end() && it->first < endTag; ++it)
 			{
-				const DicomElement& element = pair.second;
-				if (element.GetTag().GetGroup() != 0x0002)
+				const DicomElement& element = (encodePixelData_ && it->first == DicomTag::PixelData.GetTag())
+					? encodedPixelData_ : it->second;
+				if (it->first >= beginTag && element.GetTag().GetGroup() != 0x0002)
 				{
 					if (!WriteDataElement(element))
 					{
@@ -166,16 +833,23 @@ namespace medvision
 				}
 			}
 
-			if (!WriteLength(element.GetLength(), element.GetVR()))
+			if (!WriteLength(element.IsUndefinedLength() ? 0xFFFFFFFF : element.GetLength(), element.GetVR()))
 			{
 				return false;
 			}
 
-			if (!WriteData(element.GetData(), element.GetLength()))
+			// Encapsulated fragments are opaque byte streams, never swapped
+			VR dataVR = element.IsUndefinedLength() ? VR::OB : element.GetVR();
+			if (!WriteData(element.GetData(), element.GetLength(), dataVR))
 			{
 				return false;
 			}
 
+			if (staging_.size() >= kStagingFlushThreshold)
+			{
+				return Flush();
+			}
+
 			return true;
 		}
 
@@ -189,7 +863,8 @@ namespace medvision
 		bool DicomWriter::WriteVR(VR vr)
 		{
 			std::string vrStr = VRUtils::ToString(vr);
-			return WriteBytes(reinterpret_cast<const uint8_t*>(vrStr.c_str()), 2);
+			WriteBytes(reinterpret_cast<const uint8_t*>(vrStr.c_str()), 2);
+			return true;
 		}
 
 		bool DicomWriter::WriteLength(uint32_t length, VR vr)
@@ -216,13 +891,77 @@ namespace medvision
 			return true;
 		}
 
-		bool DicomWriter::WriteData(const uint8_t* data, uint32_t length)
+		bool DicomWriter::WriteData(const uint8_t* data, uint32_t length, VR vr)
 		{
 			if (length == 0)
 			{
 				return true;
 			}
-			return WriteBytes(data, length);
+
+			if (swapValues_ && ByteSwap::GetSwapUnit(vr) > 0)
+			{
+				return WriteSwappedData(data, length, vr);
+			}
+
+			if (length <= kInlineValueLimit || directOutput_ != nullptr)
+			{
+				WriteBytes(data, length);
+				return true;
+			}
+
+			// Reference the element value in place; it outlives the flush
+			Segment segment = { data, 0, length };
+			segments_.push_back(segment);
+			return true;
+		}
+
+		bool DicomWriter::WriteSwappedData(const uint8_t* data, uint32_t length, VR vr)
+		{
+			if (directOutput_ != nullptr)
+			{
+				// Swap while copying straight into the destination
+				ByteSwap::CopySwappedValue(vr, directOutput_ + directPosition_, data, length);
+				directPosition_ += length;
+				return true;
+			}
+
+			if (length <= kInlineValueLimit)
+			{
+				size_t offset = staging_.size();
+				WriteBytes(data, length);
+				ByteSwap::SwapValue(vr, staging_.data() + offset, length);
+				return true;
+			}
+
+			// Large values are swapped into scratch memory in bounded chunks
+			// that are written out before the scratch buffer is reused
+			const size_t chunkSize = kSwapChunkSize - (kSwapChunkSize % 8);
+			swapBuffer_.resize(std::min<size_t>(length, chunkSize));
+
+			for (size_t offset = 0; offset < length; offset += chunkSize)
+			{
+				size_t chunk = std::min<size_t>(length - offset, chunkSize);
+				ByteSwap::CopySwappedValue(vr, swapBuffer_.data(), data + offset, chunk);
+
+				Segment segment = { swapBuffer_.data(), 0, chunk };
+				segments_.push_back(segment);
+				if (!Flush())
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool DicomWriter::WriteItemHeader(uint16_t element, uint32_t length)
+		{
+			// Item and delimiter headers of encapsulated data are always little endian
+			const uint8_t header[8] = { 0xFE, 0xFF,
+				static_cast<uint8_t>(element), static_cast<uint8_t>(element >> 8),
+				static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+				static_cast<uint8_t>(length >> 16), static_cast<uint8_t>(length >> 24) };
+			WriteBytes(header, 8);
+			return true;
 		}
 
 		void DicomWriter::WriteUInt16(uint16_t value)
@@ -265,19 +1004,112 @@ namespace medvision
 			WriteBytes(bytes, 4);
 		}
 
-		bool DicomWriter::WriteBytes(const uint8_t* buffer, size_t count)
+		void DicomWriter::WriteBytes(const uint8_t* buffer, size_t count)
 		{
-			if (file_.is_open())
+			if (directOutput_ != nullptr)
+			{
+				// Capacity was validated against the sizing pass up front
+				std::memcpy(directOutput_ + directPosition_, buffer, count);
+				directPosition_ += count;
+				return;
+			}
+
+			size_t offset = staging_.size();
+			staging_.insert(staging_.end(), buffer, buffer + count);
+
+			// Extend the trailing staging segment when contiguous
+			if (!segments_.empty())
 			{
-				file_.write(reinterpret_cast<const char*>(buffer), count);
-				return file_.good();
+				Segment& last = segments_.back();
+				if (last.external == nullptr && last.offset + last.length == offset)
+				{
+					last.length += count;
+					return;
+				}
 			}
-			else if (outputBuffer_ != nullptr)
+
+			Segment segment = { nullptr, offset, count };
+			segments_.push_back(segment);
+		}
+
+		bool DicomWriter::Flush()
+		{
+			if (segments_.empty())
 			{
-				outputBuffer_->insert(outputBuffer_->end(), buffer, buffer + count);
 				return true;
 			}
-			return false;
+
+			// Resolve staging offsets now that staging_ no longer grows
+			ioSegments_.clear();
+			for (const Segment& segment : segments_)
+			{
+				IoSegment io;
+				io.data = (segment.external != nullptr) ? segment.external : staging_.data() + segment.offset;
+				io.length = segment.length;
+				ioSegments_.push_back(io);
+			}
+
+			bool success = true;
+			if (deflater_)
+			{
+				for (size_t i = 0; success && i < ioSegments_.size(); ++i)
+				{
+					success = deflater_->Write(ioSegments_[i].data, ioSegments_[i].length);
+				}
+				if (!success)
+				{
+					SetError("Failed to write deflated data");
+				}
+			}
+			else if (file_.IsOpen())
+			{
+				success = file_.WriteGather(ioSegments_.data(), ioSegments_.size());
+				if (!success)
+				{
+					SetError("Failed to write to file");
+				}
+			}
+			else if (bufferOutput_ != nullptr)
+			{
+				for (const IoSegment& io : ioSegments_)
+				{
+					bufferOutput_->insert(bufferOutput_->end(), io.data, io.data + io.length);
+				}
+			}
+			else
+			{
+				SetError("No output target");
+				success = false;
+			}
+
+			staging_.clear();
+			segments_.clear();
+			return success;
+		}
+
+		bool DicomWriter::CloseFile(bool success)
+		{
+			if (success && syncOnClose_ && !file_.Sync())
+			{
+				SetError("Failed to sync file to disk");
+				success = false;
+			}
+			file_.Close();
+			return success;
+		}
+
+		void DicomWriter::ResetOutput()
+		{
+			deflater_.reset();
+			std::vector<uint8_t>().swap(swapBuffer_);
+			if (encodePixelData_)
+			{
+				encodedPixelData_ = DicomElement();
+				encodePixelData_ = false;
+			}
+			staging_.clear();
+			segments_.clear();
+			ioSegments_.clear();
 		}
 
 		void DicomWriter::SetError(const std::string& error)
@@ -0,0 +1,241 @@
+#include "medvision/dicom/EncapsulatedPixelData.h"
+#include <cstring>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const uint32_t kItemTag = 0xFFFEE000;
+			const uint32_t kSequenceDelimitationTag = 0xFFFEE0DD;
+
+			// Encapsulated syntaxes are always little endian
+			uint32_t ReadUInt32LE(const uint8_t* data)
+			{
+				return static_cast<uint32_t>(data[0]) |
+					(static_cast<uint32_t>(data[1]) << 8) |
+					(static_cast<uint32_t>(data[2]) << 16) |
+					(static_cast<uint32_t>(data[3]) << 24);
+			}
+
+			uint32_t ReadTag(const uint8_t* data)
+			{
+				return (static_cast<uint32_t>(data[0] | (data[1] << 8)) << 16) | static_cast<uint32_t>(data[2] | (data[3] << 8));
+			}
+
+			void AppendItemHeader(std::vector<uint8_t>& stream, uint32_t tag, uint32_t length)
+			{
+				const uint8_t header[8] = {
+					static_cast<uint8_t>(tag >> 16), static_cast<uint8_t>(tag >> 24),
+					static_cast<uint8_t>(tag), static_cast<uint8_t>(tag >> 8),
+					static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+					static_cast<uint8_t>(length >> 16), static_cast<uint8_t>(length >> 24) };
+				stream.insert(stream.end(), header, header + 8);
+			}
+		}
+
+		EncapsulatedPixelData::EncapsulatedPixelData()
+			: data_(nullptr)
+		{
+		}
+
+		bool EncapsulatedPixelData::Parse(const uint8_t* data, size_t length, uint32_t frameCount)
+		{
+			return Parse(data, length, frameCount, nullptr, 0);
+		}
+
+		bool EncapsulatedPixelData::Parse(const uint8_t* data, size_t length, uint32_t frameCount,
+			const uint8_t* extendedOffsetTable, size_t extendedOffsetTableLength)
+		{
+			data_ = data;
+			offsetTable_.clear();
+			fragments_.clear();
+			fragmentItemOffsets_.clear();
+			frameFirstFragment_.clear();
+			lastError_.clear();
+
+			if (frameCount == 0)
+			{
+				frameCount = 1;
+			}
+
+			size_t position = 0;
+			size_t firstFragmentItem = 0;
+			bool first = true;
+			while (true)
+			{
+				if (position + 8 > length)
+				{
+					SetError("Encapsulated pixel data is not terminated");
+					return false;
+				}
+
+				uint32_t tag = ReadTag(data + position);
+				uint32_t itemLength = ReadUInt32LE(data + position + 4);
+				if (tag == kSequenceDelimitationTag)
+				{
+					break;
+				}
+				if (tag != kItemTag || itemLength > length - position - 8)
+				{
+					SetError("Malformed encapsulated pixel data item");
+					return false;
+				}
+
+				size_t valueOffset = position + 8;
+				if (first)
+				{
+					// The first item is always the Basic Offset Table
+					for (uint32_t i = 0; i + 4 <= itemLength; i += 4)
+					{
+						offsetTable_.push_back(ReadUInt32LE(data + valueOffset + i));
+					}
+					firstFragmentItem = valueOffset + itemLength;
+					first = false;
+				}
+				else
+				{
+					Fragment fragment = { valueOffset, itemLength };
+					fragments_.push_back(fragment);
+					fragmentItemOffsets_.push_back(position - firstFragmentItem);
+				}
+				position = valueOffset + itemLength;
+			}
+
+			if (fragments_.empty())
+			{
+				SetError("Encapsulated pixel data has no fragments");
+				return false;
+			}
+
+			// Frame boundaries: an offset table, else one frame per fragment, else everything is one frame
+			if (!offsetTable_.empty())
+			{
+				return AssignFramesFromOffsets(std::vector<uint64_t>(offsetTable_.begin(), offsetTable_.end()), "Basic Offset Table");
+			}
+			if (extendedOffsetTable != nullptr && extendedOffsetTableLength >= 8)
+			{
+				std::vector<uint64_t> offsets(extendedOffsetTableLength / 8);
+				for (size_t i = 0; i < offsets.size(); ++i)
+				{
+					offsets[i] = static_cast<uint64_t>(ReadUInt32LE(extendedOffsetTable + i * 8)) |
+						(static_cast<uint64_t>(ReadUInt32LE(extendedOffsetTable + i * 8 + 4)) << 32);
+				}
+				return AssignFramesFromOffsets(offsets, "Extended Offset Table");
+			}
+			if (frameCount == 1)
+			{
+				frameFirstFragment_.push_back(0);
+				return true;
+			}
+			if (fragments_.size() == frameCount)
+			{
+				for (size_t i = 0; i < fragments_.size(); ++i)
+				{
+					frameFirstFragment_.push_back(i);
+				}
+				return true;
+			}
+
+			SetError("Cannot locate frames without a Basic Offset Table");
+			return false;
+		}
+
+		bool EncapsulatedPixelData::AssignFramesFromOffsets(const std::vector<uint64_t>& offsets, const char* tableName)
+		{
+			// Offsets are relative to the first fragment item header
+			size_t fragment = 0;
+			for (uint64_t offset : offsets)
+			{
+				while (fragment < fragmentItemOffsets_.size() && fragmentItemOffsets_[fragment] < offset)
+				{
+					++fragment;
+				}
+				if (fragment == fragmentItemOffsets_.size() || fragmentItemOffsets_[fragment] != offset ||
+					(!frameFirstFragment_.empty() && frameFirstFragment_.back() == fragment))
+				{
+					SetError(std::string(tableName) + " does not match the fragments");
+					frameFirstFragment_.clear();
+					return false;
+				}
+				frameFirstFragment_.push_back(fragment);
+			}
+			return true;
+		}
+
+		void EncapsulatedPixelData::Build(const std::vector<std::vector<uint8_t>>& frames, std::vector<uint8_t>& stream)
+		{
+			// Offsets count from the first fragment item; they have to fit in 32 bits
+			std::vector<uint32_t> offsets;
+			uint64_t offset = 0;
+			for (const std::vector<uint8_t>& frame : frames)
+			{
+				offsets.push_back(static_cast<uint32_t>(offset));
+				offset += 8 + frame.size() + (frame.size() % 2);
+			}
+			if (!frames.empty() && offset - 8 - frames.back().size() - (frames.back().size() % 2) > 0xFFFFFFFFull)
+			{
+				offsets.clear();
+			}
+
+			stream.clear();
+			stream.reserve(static_cast<size_t>(16 + offsets.size() * 4 + offset));
+			AppendItemHeader(stream, kItemTag, static_cast<uint32_t>(offsets.size() * 4));
+			for (uint32_t frameOffset : offsets)
+			{
+				const uint8_t bytes[4] = { static_cast<uint8_t>(frameOffset), static_cast<uint8_t>(frameOffset >> 8),
+					static_cast<uint8_t>(frameOffset >> 16), static_cast<uint8_t>(frameOffset >> 24) };
+				stream.insert(stream.end(), bytes, bytes + 4);
+			}
+			for (const std::vector<uint8_t>& frame : frames)
+			{
+				AppendItemHeader(stream, kItemTag, static_cast<uint32_t>(frame.size() + (frame.size() % 2)));
+				stream.insert(stream.end(), frame.begin(), frame.end());
+				if (frame.size() % 2 != 0)
+				{
+					stream.push_back(0);
+				}
+			}
+			AppendItemHeader(stream, kSequenceDelimitationTag, 0);
+		}
+
+		bool EncapsulatedPixelData::GetFrame(size_t frameIndex, std::vector<uint8_t>& storage, const uint8_t*& frameData, size_t& frameLength) const
+		{
+			if (frameIndex >= frameFirstFragment_.size())
+			{
+				return false;
+			}
+
+			size_t begin = frameFirstFragment_[frameIndex];
+			size_t end = (frameIndex + 1 < frameFirstFragment_.size()) ? frameFirstFragment_[frameIndex + 1] : fragments_.size();
+
+			if (end - begin == 1)
+			{
+				frameData = data_ + fragments_[begin].offset;
+				frameLength = fragments_[begin].length;
+				return true;
+			}
+
+			size_t total = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				total += fragments_[i].length;
+			}
+
+			storage.resize(total);
+			size_t position = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				std::memcpy(storage.data() + position, data_ + fragments_[i].offset, fragments_[i].length);
+				position += fragments_[i].length;
+			}
+
+			frameData = storage.data();
+			frameLength = total;
+			return true;
+		}
+
+	} // namespace dicom
+} // namespace medvision
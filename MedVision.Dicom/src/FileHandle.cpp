@@ -0,0 +1,454 @@
+#include "medvision/dicom/FileHandle.h"
+#include <climits>
+#include <cerrno>
+#include <algorithm>
+#include <vector>
+
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+#ifdef _WIN32
+			// _write takes an unsigned int count
+			const size_t kMaxWriteChunk = static_cast<size_t>(INT_MAX);
+#else
+			const size_t kMaxWriteChunk = static_cast<size_t>(SSIZE_MAX);
+
+#ifdef IOV_MAX
+			const int kMaxIoVectors = IOV_MAX;
+#else
+			const int kMaxIoVectors = 1024;
+#endif
+#endif
+
+			// Bounce buffer used when the kernel cannot copy file-to-file
+			const size_t kCopyChunkSize = 1024 * 1024;
+
+#ifdef __linux__
+			// Returns bytes copied, 0 at end of input, -1 if unsupported/failed
+			long long KernelCopy(int outFd, int inFd, uint64_t& inOffset, size_t count)
+			{
+#ifdef SYS_copy_file_range
+				loff_t offIn = static_cast<loff_t>(inOffset);
+				long copied = syscall(SYS_copy_file_range, inFd, &offIn, outFd, nullptr, count, 0u);
+				if (copied >= 0)
+				{
+					inOffset = static_cast<uint64_t>(offIn);
+					return copied;
+				}
+				if (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP && errno != EBADF)
+				{
+					return -1;
+				}
+#endif
+				off_t sendOffset = static_cast<off_t>(inOffset);
+				ssize_t sent = ::sendfile(outFd, inFd, &sendOffset, count);
+				if (sent >= 0)
+				{
+					inOffset = static_cast<uint64_t>(sendOffset);
+					return sent;
+				}
+				return -1;
+			}
+#endif
+		}
+
+		FileHandle::FileHandle()
+			: fd_(-1)
+		{
+		}
+
+		FileHandle::~FileHandle()
+		{
+			Close();
+		}
+
+		bool FileHandle::Create(const std::string& filePath)
+		{
+			Close();
+
+#ifdef _WIN32
+			int fd = -1;
+			errno_t result = _sopen_s(&fd, filePath.c_str(),
+				_O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+				_SH_DENYWR, _S_IREAD | _S_IWRITE);
+			fd_ = (result == 0) ? fd : -1;
+#else
+			fd_ = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+			return fd_ >= 0;
+		}
+
+		bool FileHandle::OpenRead(const std::string& filePath)
+		{
+			Close();
+
+#ifdef _WIN32
+			int fd = -1;
+			errno_t result = _sopen_s(&fd, filePath.c_str(), _O_RDONLY | _O_BINARY, _SH_DENYNO, 0);
+			fd_ = (result == 0) ? fd : -1;
+#else
+			fd_ = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+			return fd_ >= 0;
+		}
+
+		bool FileHandle::OpenReadWrite(const std::string& filePath)
+		{
+			Close();
+
+#ifdef _WIN32
+			int fd = -1;
+			errno_t result = _sopen_s(&fd, filePath.c_str(), _O_RDWR | _O_BINARY, _SH_DENYWR, 0);
+			fd_ = (result == 0) ? fd : -1;
+#else
+			fd_ = ::open(filePath.c_str(), O_RDWR | O_CLOEXEC);
+#endif
+			return fd_ >= 0;
+		}
+
+		void FileHandle::Close()
+		{
+			if (fd_ >= 0)
+			{
+#ifdef _WIN32
+				_close(fd_);
+#else
+				::close(fd_);
+#endif
+				fd_ = -1;
+			}
+		}
+
+		bool FileHandle::Write(const uint8_t* data, size_t count)
+		{
+			if (fd_ < 0)
+			{
+				return false;
+			}
+
+			while (count > 0)
+			{
+				size_t chunk = std::min(count, kMaxWriteChunk);
+#ifdef _WIN32
+				int written = _write(fd_, data, static_cast<unsigned int>(chunk));
+#else
+				ssize_t written = ::write(fd_, data, chunk);
+				if (written < 0 && errno == EINTR)
+				{
+					continue;
+				}
+#endif
+				if (written <= 0)
+				{
+					return false;
+				}
+				data += written;
+				count -= static_cast<size_t>(written);
+			}
+			return true;
+		}
+
+		bool FileHandle::WriteGather(const IoSegment* segments, size_t count)
+		{
+			if (fd_ < 0)
+			{
+				return false;
+			}
+
+#ifdef _WIN32
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (!Write(segments[i].data, segments[i].length))
+				{
+					return false;
+				}
+			}
+			return true;
+#else
+			struct iovec vectors[64];
+			const int batchLimit = std::min(kMaxIoVectors, 64);
+
+			size_t index = 0;
+			size_t consumed = 0;  // Bytes of segments[index] already written
+
+			while (index < count)
+			{
+				// Fill the iovec batch, resuming inside a partially written segment
+				int batch = 0;
+				for (size_t i = index; i < count && batch < batchLimit; ++i)
+				{
+					size_t skip = (i == index) ? consumed : 0;
+					if (segments[i].length == skip)
+					{
+						continue;
+					}
+					vectors[batch].iov_base = const_cast<uint8_t*>(segments[i].data + skip);
+					vectors[batch].iov_len = segments[i].length - skip;
+					++batch;
+				}
+
+				if (batch == 0)
+				{
+					break;
+				}
+
+				ssize_t written = ::writev(fd_, vectors, batch);
+				if (written < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				if (written <= 0)
+				{
+					return false;
+				}
+
+				// Advance past fully written segments
+				size_t remaining = static_cast<size_t>(written);
+				while (index < count && remaining >= segments[index].length - consumed)
+				{
+					remaining -= segments[index].length - consumed;
+					consumed = 0;
+					++index;
+				}
+				consumed += remaining;
+			}
+			return true;
+#endif
+		}
+
+		bool FileHandle::ReadAt(uint8_t* buffer, size_t count, uint64_t offset) const
+		{
+			if (fd_ < 0)
+			{
+				return false;
+			}
+
+#ifdef _WIN32
+			if (_lseeki64(fd_, static_cast<__int64>(offset), SEEK_SET) < 0)
+			{
+				return false;
+			}
+#endif
+			while (count > 0)
+			{
+				size_t chunk = std::min(count, kMaxWriteChunk);
+#ifdef _WIN32
+				int bytesRead = _read(fd_, buffer, static_cast<unsigned int>(chunk));
+#else
+				ssize_t bytesRead = ::pread(fd_, buffer, chunk, static_cast<off_t>(offset));
+				if (bytesRead < 0 && errno == EINTR)
+				{
+					continue;
+				}
+#endif
+				if (bytesRead <= 0)
+				{
+					return false;
+				}
+				buffer += bytesRead;
+				count -= static_cast<size_t>(bytesRead);
+				offset += static_cast<uint64_t>(bytesRead);
+			}
+			return true;
+		}
+
+		bool FileHandle::WriteAt(const uint8_t* data, size_t count, uint64_t offset)
+		{
+			if (fd_ < 0)
+			{
+				return false;
+			}
+
+#ifdef _WIN32
+			if (_lseeki64(fd_, static_cast<__int64>(offset), SEEK_SET) < 0)
+			{
+				return false;
+			}
+			return Write(data, count);
+#else
+			while (count > 0)
+			{
+				size_t chunk = std::min(count, kMaxWriteChunk);
+				ssize_t written = ::pwrite(fd_, data, chunk, static_cast<off_t>(offset));
+				if (written < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				if (written <= 0)
+				{
+					return false;
+				}
+				data += written;
+				count -= static_cast<size_t>(written);
+				offset += static_cast<uint64_t>(written);
+			}
+			return true;
+#endif
+		}
+
+		bool FileHandle::GetSize(uint64_t& size) const
+		{
+			if (fd_ < 0)
+			{
+				return false;
+			}
+
+#ifdef _WIN32
+			__int64 length = _filelengthi64(fd_);
+			if (length < 0)
+			{
+				return false;
+			}
+			size = static_cast<uint64_t>(length);
+#else
+			struct stat info;
+			if (::fstat(fd_, &info) != 0)
+			{
+				return false;
+			}
+			size = static_cast<uint64_t>(info.st_size);
+#endif
+			return true;
+		}
+
+		bool FileHandle::CopyFrom(int sourceDescriptor, uint64_t sourceOffset, uint64_t length)
+		{
+			if (fd_ < 0 || sourceDescriptor < 0)
+			{
+				return false;
+			}
+
+#ifdef __linux__
+			while (length > 0)
+			{
+				size_t chunk = static_cast<size_t>(std::min<uint64_t>(length, 0x40000000ull));
+				long long copied = KernelCopy(fd_, sourceDescriptor, sourceOffset, chunk);
+				if (copied < 0)
+				{
+					break;  // Fall back to the bounce buffer for the remainder
+				}
+				if (copied == 0)
+				{
+					return false;  // Source ended early
+				}
+				length -= static_cast<uint64_t>(copied);
+			}
+			if (length == 0)
+			{
+				return true;
+			}
+#endif
+
+			// Portable path: constant-size bounce buffer
+			FileHandle source;
+			source.fd_ = sourceDescriptor;
+
+			std::vector<uint8_t> bounce(static_cast<size_t>(std::min<uint64_t>(length, kCopyChunkSize)));
+			bool success = true;
+			while (length > 0)
+			{
+				size_t chunk = static_cast<size_t>(std::min<uint64_t>(length, bounce.size()));
+				if (!source.ReadAt(bounce.data(), chunk, sourceOffset) || !Write(bounce.data(), chunk))
+				{
+					success = false;
+					break;
+				}
+				sourceOffset += chunk;
+				length -= chunk;
+			}
+
+			source.fd_ = -1;  // Borrowed descriptor; do not close
+			return success;
+		}
+
+		bool FileHandle::Sync()
+		{
+			if (fd_ < 0)
+			{
+				return false;
+			}
+#ifdef _WIN32
+			return _commit(fd_) == 0;
+#else
+			return ::fsync(fd_) == 0;
+#endif
+		}
+
+		bool FileHandle::Rename(const std::string& sourcePath, const std::string& targetPath)
+		{
+#ifdef _WIN32
+			return MoveFileExA(sourcePath.c_str(), targetPath.c_str(),
+				MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+			return ::rename(sourcePath.c_str(), targetPath.c_str()) == 0;
+#endif
+		}
+
+		bool FileHandle::Remove(const std::string& filePath)
+		{
+			return std::remove(filePath.c_str()) == 0;
+		}
+
+		std::string FileHandle::GetDirectory(const std::string& filePath)
+		{
+			size_t separator = filePath.find_last_of("/\\");
+			if (separator == std::string::npos)
+			{
+				return ".";
+			}
+			if (separator == 0)
+			{
+				return filePath.substr(0, 1);
+			}
+			return filePath.substr(0, separator);
+		}
+
+		bool FileHandle::SyncDirectory(const std::string& directoryPath)
+		{
+#ifdef _WIN32
+			(void)directoryPath;
+			return true;
+#else
+			int fd = ::open(directoryPath.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				return false;
+			}
+			bool success = ::fsync(fd) == 0;
+			::close(fd);
+			return success;
+#endif
+		}
+
+	} // namespace dicom
+} // namespace medvision
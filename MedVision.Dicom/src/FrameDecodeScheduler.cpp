@@ -0,0 +1,276 @@
+#include "medvision/dicom/FrameDecodeScheduler.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		/// Shared with the pool tasks, which may still be queued after the
+		/// scheduler is gone; once cancelled they exit without touching the
+		/// frames or the output
+		struct FrameDecodeScheduler::State
+		{
+			const EncapsulatedPixelData* frames;
+			std::shared_ptr<const PixelDecoder> decoder;
+			FrameInfo info;
+			uint32_t reduction;
+			uint8_t* output;
+			size_t frameLength;
+			bool parallel;
+
+			mutable std::mutex mutex;
+			std::condition_variable changed;
+			std::vector<FrameState> states;
+			std::vector<size_t> order;      // Frames by priority
+			size_t cursor;                  // Entries of order before this are claimed
+			size_t decoding;
+			bool cancelled;
+			std::string error;
+			std::mutex serialDecode;        // Held while decoding if the decoder is not parallel
+
+			void SetFocus(size_t focus)
+			{
+				const size_t count = states.size();
+				focus = std::min(focus, count - 1);
+				order.clear();
+				order.push_back(focus);
+				for (size_t distance = 1; order.size() < count; ++distance)
+				{
+					if (focus + distance < count)
+					{
+						order.push_back(focus + distance);
+					}
+					if (distance <= focus)
+					{
+						order.push_back(focus - distance);
+					}
+				}
+				cursor = 0;
+			}
+
+			/// Next pending frame by priority (caller holds mutex)
+			bool Claim(size_t& frame)
+			{
+				while (cursor < order.size() && states[order[cursor]] != FrameState::Pending)
+				{
+					++cursor;
+				}
+				if (cursor == order.size())
+				{
+					return false;
+				}
+				frame = order[cursor++];
+				states[frame] = FrameState::Decoding;
+				++decoding;
+				return true;
+			}
+
+			void Decode(size_t frame)
+			{
+				std::vector<uint8_t> storage;
+				const uint8_t* data = nullptr;
+				size_t length = 0;
+				std::string frameError;
+				bool success;
+				{
+					std::unique_lock<std::mutex> serial(serialDecode, std::defer_lock);
+					if (!parallel)
+					{
+						serial.lock();
+					}
+
+					// A throwing decoder fails its frame; letting the exception escape
+					// would leave the frame Decoding and the destructor waiting forever
+					uint8_t* slot = output + frame * frameLength;
+					try
+					{
+						if (!frames->GetFrame(frame, storage, data, length))
+						{
+							frameError = "Missing frame";
+							success = false;
+						}
+						else
+						{
+							success = reduction != 0
+								? decoder->DecodeFrameReduced(data, length, info, reduction, slot, frameError)
+								: decoder->DecodeFrame(data, length, info, slot, frameError);
+						}
+					}
+					catch (const std::exception& e)
+					{
+						frameError = e.what();
+						success = false;
+					}
+					catch (...)
+					{
+						frameError = "Unknown exception";
+						success = false;
+					}
+				}
+
+				std::lock_guard<std::mutex> lock(mutex);
+				states[frame] = success ? FrameState::Decoded : FrameState::Failed;
+				if (!success && error.empty())
+				{
+					error = "Frame " + std::to_string(frame) + ": " + frameError;
+				}
+				--decoding;
+				changed.notify_all();
+			}
+
+			/// Pool task: decode frames until none is left or the scheduler is cancelled
+			static void Work(const std::shared_ptr<State>& state)
+			{
+				while (true)
+				{
+					size_t frame;
+					{
+						std::lock_guard<std::mutex> lock(state->mutex);
+						if (state->cancelled || !state->Claim(frame))
+						{
+							return;
+						}
+					}
+					state->Decode(frame);
+				}
+			}
+		};
+
+		FrameDecodeScheduler::FrameDecodeScheduler(const EncapsulatedPixelData& frames, std::shared_ptr<const PixelDecoder> decoder,
+			const FrameInfo& info, uint32_t reduction, uint8_t* output, ThreadPool& pool)
+			: state_(std::make_shared<State>())
+			, pool_(pool)
+			, started_(false)
+		{
+			state_->frames = &frames;
+			state_->decoder = std::move(decoder);
+			state_->info = info;
+			state_->reduction = reduction;
+			state_->output = output;
+			state_->frameLength = reduction != 0 ? info.Reduce(reduction).GetFrameLength() : info.GetFrameLength();
+			state_->parallel = (state_->decoder->GetCapabilities() & CodecMultiFrameParallel) != 0;
+			state_->states.assign(frames.GetFrameCount(), FrameState::Pending);
+			state_->cursor = 0;
+			state_->decoding = 0;
+			state_->cancelled = false;
+			if (!state_->states.empty())
+			{
+				state_->SetFocus(0);
+			}
+		}
+
+		FrameDecodeScheduler::~FrameDecodeScheduler()
+		{
+			std::unique_lock<std::mutex> lock(state_->mutex);
+			state_->cancelled = true;
+			state_->changed.wait(lock, [this] { return state_->decoding == 0; });
+		}
+
+		size_t FrameDecodeScheduler::GetFrameCount() const
+		{
+			return state_->states.size();
+		}
+
+		size_t FrameDecodeScheduler::GetFrameLength() const
+		{
+			return state_->frameLength;
+		}
+
+		void FrameDecodeScheduler::Start(size_t focusFrame)
+		{
+			size_t workers;
+			{
+				std::lock_guard<std::mutex> lock(state_->mutex);
+				if (started_ || state_->states.empty())
+				{
+					return;
+				}
+				started_ = true;
+				state_->SetFocus(focusFrame);
+				workers = state_->parallel ? std::min(pool_.GetThreadCount(), state_->states.size()) : 1;
+			}
+
+			std::shared_ptr<State> state = state_;
+			for (size_t i = 0; i < workers; ++i)
+			{
+				pool_.Submit([state] { State::Work(state); });
+			}
+		}
+
+		void FrameDecodeScheduler::Prioritize(size_t focusFrame)
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			if (!state_->states.empty())
+			{
+				state_->SetFocus(focusFrame);
+			}
+		}
+
+		bool FrameDecodeScheduler::WaitForFrame(size_t frame)
+		{
+			std::unique_lock<std::mutex> lock(state_->mutex);
+			if (frame >= state_->states.size())
+			{
+				return false;
+			}
+
+			if (state_->states[frame] == FrameState::Pending)
+			{
+				// Not claimed yet: decode it here rather than wait for a worker
+				state_->states[frame] = FrameState::Decoding;
+				++state_->decoding;
+				lock.unlock();
+				state_->Decode(frame);
+				lock.lock();
+			}
+
+			state_->changed.wait(lock, [this, frame] { return state_->states[frame] != FrameState::Decoding; });
+			return state_->states[frame] == FrameState::Decoded;
+		}
+
+		bool FrameDecodeScheduler::WaitAll()
+		{
+			// Help with the remaining frames so a busy (or nested) pool cannot stall us
+			while (true)
+			{
+				size_t frame;
+				{
+					std::lock_guard<std::mutex> lock(state_->mutex);
+					if (!state_->Claim(frame))
+					{
+						break;
+					}
+				}
+				state_->Decode(frame);
+			}
+
+			std::unique_lock<std::mutex> lock(state_->mutex);
+			state_->changed.wait(lock, [this] { return state_->decoding == 0; });
+			return std::find(state_->states.begin(), state_->states.end(), FrameState::Failed) == state_->states.end();
+		}
+
+		void FrameDecodeScheduler::Cancel()
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			state_->cancelled = true;
+		}
+
+		FrameDecodeScheduler::FrameState FrameDecodeScheduler::GetFrameState(size_t frame) const
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			return frame < state_->states.size() ? state_->states[frame] : FrameState::Failed;
+		}
+
+		std::string FrameDecodeScheduler::GetLastError() const
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			return state_->error;
+		}
+
+	} // namespace dicom
+} // namespace medvision
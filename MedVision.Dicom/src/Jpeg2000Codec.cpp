@@ -0,0 +1,1661 @@
+#include "medvision/dicom/Jpeg2000Codec.h"
+#include "medvision/dicom/Jpeg2000Entropy.h"
+#include "medvision/dicom/Jpeg2000Wavelet.h"
+#include "medvision/dicom/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const uint16_t kSOC = 0xFF4F;
+			const uint16_t kCAP = 0xFF50;
+			const uint16_t kSIZ = 0xFF51;
+			const uint16_t kCOD = 0xFF52;
+			const uint16_t kCOC = 0xFF53;
+			const uint16_t kQCD = 0xFF5C;
+			const uint16_t kQCC = 0xFF5D;
+			const uint16_t kRGN = 0xFF5E;
+			const uint16_t kPOC = 0xFF5F;
+			const uint16_t kPPM = 0xFF60;
+			const uint16_t kPPT = 0xFF61;
+			const uint16_t kSOT = 0xFF90;
+			const uint16_t kSOP = 0xFF91;
+			const uint16_t kEPH = 0xFF92;
+			const uint16_t kSOD = 0xFF93;
+			const uint16_t kEOC = 0xFFD9;
+
+			// Progression orders (T.800 Table A.16)
+			const uint32_t kLRCP = 0;
+			const uint32_t kRLCP = 1;
+			const uint32_t kRPCL = 2;
+			const uint32_t kPCRL = 3;
+			const uint32_t kCPRL = 4;
+
+			const uint32_t kHighThroughputProfile = 0x4000;   // Rsiz bit of Part 15 codestreams
+			const uint32_t kJp2Signature = 0x6A502020;         // 'jP  '
+			const uint32_t kJp2Codestream = 0x6A703263;        // 'jp2c'
+
+			uint16_t ReadUInt16BE(const uint8_t* data)
+			{
+				return static_cast<uint16_t>((data[0] << 8) | data[1]);
+			}
+
+			uint32_t ReadUInt32BE(const uint8_t* data)
+			{
+				return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+					(static_cast<uint32_t>(data[2]) << 8) | data[3];
+			}
+
+			// ceil(value / 2^shift), also for negative values
+			int64_t CeilShift(int64_t value, uint32_t shift)
+			{
+				return -((-value) >> shift);
+			}
+
+			uint32_t FloorLog2(uint32_t value)
+			{
+				uint32_t log = 0;
+				while (value >>= 1)
+				{
+					++log;
+				}
+				return log;
+			}
+
+			struct CodingStyle
+			{
+				uint32_t levels;          // Decomposition levels
+				uint32_t blockWidth;      // log2 of the nominal code-block size
+				uint32_t blockHeight;
+				uint32_t blockStyle;      // Jpeg2000BlockStyle flags
+				bool reversible;          // 5/3 rather than 9/7 wavelet
+				uint8_t precincts[33];    // log2 precinct width | height << 4, per resolution
+			};
+
+			struct QuantizationStyle
+			{
+				uint32_t style;                // 0 none, 1 scalar derived, 2 scalar expounded
+				uint32_t guardBits;
+				std::vector<uint16_t> steps;   // exponent << 11 | mantissa, per subband
+			};
+
+			struct ComponentParameters
+			{
+				CodingStyle coding;
+				QuantizationStyle quantization;
+				uint32_t roiShift;
+				bool codingFromCoc;            // Set by a COC of the current header
+				bool quantizationFromQcc;
+			};
+
+			/// Coding parameters of the main header, or of one tile
+			struct Parameters
+			{
+				bool sop;
+				bool eph;
+				uint32_t progression;
+				uint32_t layers;
+				bool mct;
+				std::vector<ComponentParameters> components;
+			};
+
+			bool ParseCodingStyle(const uint8_t* data, size_t length, bool precinctsDefined, CodingStyle& style)
+			{
+				if (length < 5)
+				{
+					return false;
+				}
+				style.levels = data[0];
+				style.blockWidth = data[1] + 2u;
+				style.blockHeight = data[2] + 2u;
+				style.blockStyle = data[3];
+				if (style.levels > 32 || style.blockWidth > 10 || style.blockHeight > 10 ||
+					style.blockWidth + style.blockHeight > 12 || data[4] > 1)
+				{
+					return false;
+				}
+				style.reversible = data[4] == 1;
+
+				if (precinctsDefined && length < 5 + style.levels + 1)
+				{
+					return false;
+				}
+				for (uint32_t r = 0; r <= style.levels; ++r)
+				{
+					style.precincts[r] = precinctsDefined ? data[5 + r] : 0xFF;
+				}
+				return true;
+			}
+
+			bool ParseQuantization(const uint8_t* data, size_t length, QuantizationStyle& quantization)
+			{
+				if (length < 1)
+				{
+					return false;
+				}
+				quantization.style = data[0] & 0x1F;
+				quantization.guardBits = data[0] >> 5;
+				quantization.steps.clear();
+				if (quantization.style == 0)
+				{
+					for (size_t i = 1; i < length; ++i)
+					{
+						quantization.steps.push_back(static_cast<uint16_t>((data[i] >> 3) << 11));
+					}
+				}
+				else if (quantization.style == 1 || quantization.style == 2)
+				{
+					for (size_t i = 1; i + 1 < length; i += 2)
+					{
+						quantization.steps.push_back(ReadUInt16BE(data + i));
+					}
+				}
+				else
+				{
+					return false;
+				}
+				return !quantization.steps.empty();
+			}
+
+			/// Reads packet header bits; a byte after 0xFF carries only 7 bits
+			class PacketHeaderReader
+			{
+			public:
+				PacketHeaderReader(const uint8_t* data, size_t length, size_t position)
+					: data_(data)
+					, length_(length)
+					, position_(position)
+					, byte_(0)
+					, count_(0)
+					, overrun_(false)
+				{
+				}
+
+				int Bit()
+				{
+					if (count_ == 0)
+					{
+						if (position_ >= length_)
+						{
+							overrun_ = true;
+							return 0;
+						}
+						count_ = byte_ == 0xFF ? 7 : 8;
+						byte_ = data_[position_++];
+					}
+					--count_;
+					return static_cast<int>((byte_ >> count_) & 1);
+				}
+
+				uint32_t Bits(uint32_t count)
+				{
+					uint32_t value = 0;
+					while (count-- > 0)
+					{
+						value = (value << 1) | static_cast<uint32_t>(Bit());
+					}
+					return value;
+				}
+
+				/// Position of the packet body; skips the stuffed byte after a final 0xFF
+				size_t Finish()
+				{
+					if (byte_ == 0xFF)
+					{
+						if (position_ >= length_)
+						{
+							overrun_ = true;
+						}
+						++position_;
+					}
+					return position_;
+				}
+
+				bool Overrun() const { return overrun_; }
+
+			private:
+				const uint8_t* data_;
+				size_t length_;
+				size_t position_;
+				uint32_t byte_;
+				int count_;
+				bool overrun_;
+			};
+
+			/// Tag tree of T.800 B.10.2, decoded incrementally across packets
+			class TagTree
+			{
+			public:
+				TagTree() : width_(0) {}
+
+				void Reset(uint32_t width, uint32_t height)
+				{
+					width_ = width;
+					offsets_.clear();
+					widths_.clear();
+					size_t total = 0;
+					while (width > 0 && height > 0)
+					{
+						offsets_.push_back(total);
+						widths_.push_back(width);
+						total += static_cast<size_t>(width) * height;
+						if (width == 1 && height == 1)
+						{
+							break;
+						}
+						width = (width + 1) / 2;
+						height = (height + 1) / 2;
+					}
+					nodes_.assign(total, Node());
+				}
+
+				/// Whether the leaf's value is below threshold, reading just enough bits to tell
+				bool Decode(PacketHeaderReader& reader, uint32_t leaf, uint32_t threshold)
+				{
+					size_t path[34];
+					size_t depth = 0;
+					uint32_t x = leaf % width_;
+					uint32_t y = leaf / width_;
+					for (size_t level = 0; level < offsets_.size(); ++level, x >>= 1, y >>= 1)
+					{
+						path[depth++] = offsets_[level] + static_cast<size_t>(y) * widths_[level] + x;
+					}
+
+					uint32_t low = 0;
+					while (depth-- > 0)
+					{
+						Node& node = nodes_[path[depth]];
+						if (low > node.low)
+						{
+							node.low = low;
+						}
+						else
+						{
+							low = node.low;
+						}
+						while (low < threshold && low < node.value)
+						{
+							if (reader.Bit())
+							{
+								node.value = low;
+							}
+							else
+							{
+								++low;
+							}
+						}
+						node.low = low;
+					}
+					return nodes_[path[0]].value < threshold;
+				}
+
+				uint32_t Value(uint32_t leaf) const
+				{
+					return nodes_[leaf].value;
+				}
+
+			private:
+				struct Node
+				{
+					uint32_t value;
+					uint32_t low;
+
+					Node() : value(0xFFFFFFFF), low(0) {}
+				};
+
+				uint32_t width_;
+				std::vector<size_t> offsets_;
+				std::vector<uint32_t> widths_;
+				std::vector<Node> nodes_;
+			};
+
+			struct CodeBlock
+			{
+				int64_t x0;                             // Band coordinates
+				int64_t y0;
+				int64_t x1;
+				int64_t y1;
+				uint32_t lengthBits;                    // Lblock
+				uint32_t zeroBitPlanes;
+				bool included;
+				std::vector<uint8_t> data;              // Codeword segments, concatenated
+				std::vector<Jpeg2000Segment> segments;
+			};
+
+			/// The code blocks of one band that fall into one precinct
+			struct PrecinctBand
+			{
+				uint32_t blocksWide;
+				uint32_t blocksHigh;
+				std::vector<CodeBlock> blocks;
+				TagTree inclusion;
+				TagTree zeroPlanes;
+			};
+
+			struct Precinct
+			{
+				PrecinctBand bands[3];
+			};
+
+			struct Band
+			{
+				Jpeg2000Orientation orientation;
+				int64_t x0;
+				int64_t y0;
+				int64_t x1;
+				int64_t y1;
+				size_t offsetX;            // Position in the tile-component buffer
+				size_t offsetY;
+				uint32_t magnitudeBits;    // Mb of T.800 E.1
+				float step;                // Quantization step (irreversible only)
+			};
+
+			struct Resolution
+			{
+				int64_t x0;
+				int64_t y0;
+				int64_t x1;
+				int64_t y1;
+				uint32_t precinctWidth;    // log2
+				uint32_t precinctHeight;
+				uint32_t precinctsWide;
+				uint32_t precinctsHigh;
+				int64_t firstPrecinctX;    // Absolute index of the first precinct
+				int64_t firstPrecinctY;
+				uint32_t bandCount;
+				Band bands[3];
+				std::vector<Precinct> precincts;
+			};
+
+			struct TileComponent
+			{
+				const ComponentParameters* parameters;
+				uint32_t decodedLevel;             // Highest resolution reconstructed
+				std::vector<Resolution> resolutions;
+				size_t stride;                     // Buffer row length (width at decodedLevel)
+				size_t height;
+				std::vector<int32_t> integers;     // Reversible coefficients and samples
+				std::vector<float> reals;          // Irreversible ones
+			};
+
+			struct PacketId
+			{
+				uint32_t layer;
+				uint32_t resolution;
+				uint32_t component;
+				uint32_t precinct;
+			};
+
+			struct PrecinctPosition
+			{
+				uint32_t resolution;
+				uint32_t component;
+				uint32_t precinct;
+				int64_t x;      // Reference grid position that starts the precinct
+				int64_t y;
+			};
+
+			struct TileData
+			{
+				bool seen;
+				Parameters parameters;
+				std::vector<std::pair<size_t, size_t>> parts;   // Offset and length of each tile-part's data
+
+				TileData() : seen(false) {}
+			};
+
+			/// Maximum passes of a codeword segment (T.800 D.4 and Table D.9)
+			uint32_t SegmentPasses(uint32_t blockStyle, size_t segment)
+			{
+				if (blockStyle & Jpeg2000TerminateAll)
+				{
+					return 1;
+				}
+				if (blockStyle & Jpeg2000Bypass)
+				{
+					// Ten MQ passes, then raw significance + refinement and MQ cleanup in turn
+					return segment == 0 ? 10 : (segment % 2 == 1 ? 2 : 1);
+				}
+				return 0xFFFFFFFF;
+			}
+
+			uint32_t ReadPassCount(PacketHeaderReader& reader)
+			{
+				if (!reader.Bit())
+				{
+					return 1;
+				}
+				if (!reader.Bit())
+				{
+					return 2;
+				}
+				uint32_t value = reader.Bits(2);
+				if (value < 3)
+				{
+					return 3 + value;
+				}
+				value = reader.Bits(5);
+				if (value < 31)
+				{
+					return 6 + value;
+				}
+				return 37 + reader.Bits(7);
+			}
+
+			class CodestreamDecoder
+			{
+			public:
+				CodestreamDecoder(const FrameInfo& info, uint32_t reduction)
+					: info_(info)
+					, reduction_(reduction)
+					, x0_(0)
+					, y0_(0)
+					, x1_(0)
+					, y1_(0)
+					, tileWidth_(0)
+					, tileHeight_(0)
+					, tileX0_(0)
+					, tileY0_(0)
+					, tilesWide_(0)
+					, tilesHigh_(0)
+					, outputX0_(0)
+					, outputY0_(0)
+				{
+				}
+
+				bool Decode(const uint8_t* data, size_t length, uint8_t* output, std::string& error)
+				{
+					UnwrapJp2(data, length);
+
+					size_t position = 0;
+					if (!ReadMainHeader(data, length, position, error) || !CheckFrame(error) ||
+						!ReadTileParts(data, length, position, error))
+					{
+						return false;
+					}
+
+					std::vector<uint8_t> joined;
+					for (size_t t = 0; t < tiles_.size(); ++t)
+					{
+						TileData& tile = tiles_[t];
+						if (!tile.seen)
+						{
+							tile.parameters = main_;
+						}
+
+						// Tile-parts are decoded as one stream
+						const uint8_t* tileData = nullptr;
+						size_t tileLength = 0;
+						if (tile.parts.size() == 1)
+						{
+							tileData = data + tile.parts[0].first;
+							tileLength = tile.parts[0].second;
+						}
+						else if (tile.parts.size() > 1)
+						{
+							joined.clear();
+							for (const auto& part : tile.parts)
+							{
+								joined.insert(joined.end(), data + part.first, data + part.first + part.second);
+							}
+							tileData = joined.data();
+							tileLength = joined.size();
+						}
+
+						if (!DecodeTile(static_cast<uint32_t>(t), tile.parameters, tileData, tileLength, output, error))
+						{
+							return false;
+						}
+					}
+					return true;
+				}
+
+			private:
+				// Some writers store a JP2 file rather than a bare codestream
+				static void UnwrapJp2(const uint8_t*& data, size_t& length)
+				{
+					if (length < 12 || ReadUInt32BE(data) != 12 || ReadUInt32BE(data + 4) != kJp2Signature)
+					{
+						return;
+					}
+					size_t position = 0;
+					while (position + 8 <= length)
+					{
+						uint64_t boxLength = ReadUInt32BE(data + position);
+						uint32_t type = ReadUInt32BE(data + position + 4);
+						size_t header = 8;
+						if (boxLength == 1)
+						{
+							if (position + 16 > length)
+							{
+								return;
+							}
+							boxLength = (static_cast<uint64_t>(ReadUInt32BE(data + position + 8)) << 32) | ReadUInt32BE(data + position + 12);
+							header = 16;
+						}
+						else if (boxLength == 0)
+						{
+							boxLength = length - position;
+						}
+						if (boxLength < header || boxLength > length - position)
+						{
+							return;
+						}
+						if (type == kJp2Codestream)
+						{
+							data += position + header;
+							length = static_cast<size_t>(boxLength) - header;
+							return;
+						}
+						position += static_cast<size_t>(boxLength);
+					}
+				}
+
+				bool ReadMainHeader(const uint8_t* data, size_t length, size_t& position, std::string& error)
+				{
+					if (length < 2 || ReadUInt16BE(data) != kSOC)
+					{
+						error = "Missing JPEG 2000 SOC marker";
+						return false;
+					}
+
+					position = 2;
+					bool haveSize = false;
+					bool haveCoding = false;
+					bool haveQuantization = false;
+					for (;;)
+					{
+						if (position + 4 > length)
+						{
+							error = "JPEG 2000 main header is truncated";
+							return false;
+						}
+						uint16_t marker = ReadUInt16BE(data + position);
+						if (marker == kSOT)
+						{
+							break;
+						}
+						size_t segmentLength = ReadUInt16BE(data + position + 2);
+						if ((marker >> 8) != 0xFF || segmentLength < 2 || position + 2 + segmentLength > length)
+						{
+							error = "Malformed JPEG 2000 marker segment";
+							return false;
+						}
+						const uint8_t* segment = data + position + 4;
+						size_t bodyLength = segmentLength - 2;
+						position += 2 + segmentLength;
+
+						if (!haveSize && marker != kSIZ)
+						{
+							error = "JPEG 2000 codestream does not start with SIZ";
+							return false;
+						}
+						if (marker == kSIZ)
+						{
+							if (haveSize || !ReadSize(segment, bodyLength, error))
+							{
+								if (error.empty())
+								{
+									error = "Duplicate JPEG 2000 SIZ segment";
+								}
+								return false;
+							}
+							haveSize = true;
+						}
+						else if (marker == kPPM)
+						{
+							error = "JPEG 2000 packed packet headers (PPM/PPT) are not supported";
+							return false;
+						}
+						else if (!ReadParameters(marker, segment, bodyLength, main_, error))
+						{
+							return false;
+						}
+						haveCoding = haveCoding || marker == kCOD;
+						haveQuantization = haveQuantization || marker == kQCD;
+					}
+
+					if (!haveSize || !haveCoding || !haveQuantization)
+					{
+						error = "JPEG 2000 main header lacks SIZ, COD or QCD";
+						return false;
+					}
+					for (const ComponentParameters& component : main_.components)
+					{
+						if (component.quantization.steps.empty())
+						{
+							error = "JPEG 2000 main header lacks SIZ, COD or QCD";
+							return false;
+						}
+					}
+					return true;
+				}
+
+				bool ReadSize(const uint8_t* segment, size_t length, std::string& error)
+				{
+					if (length < 36)
+					{
+						error = "Malformed JPEG 2000 SIZ segment";
+						return false;
+					}
+					uint32_t capabilities = ReadUInt16BE(segment);
+					if (capabilities & kHighThroughputProfile)
+					{
+						error = "HTJ2K (JPEG 2000 Part 15) codestreams are not supported";
+						return false;
+					}
+					x1_ = ReadUInt32BE(segment + 2);
+					y1_ = ReadUInt32BE(segment + 6);
+					x0_ = ReadUInt32BE(segment + 10);
+					y0_ = ReadUInt32BE(segment + 14);
+					tileWidth_ = ReadUInt32BE(segment + 18);
+					tileHeight_ = ReadUInt32BE(segment + 22);
+					tileX0_ = ReadUInt32BE(segment + 26);
+					tileY0_ = ReadUInt32BE(segment + 30);
+					size_t count = ReadUInt16BE(segment + 34);
+					if (x1_ <= x0_ || y1_ <= y0_ || tileWidth_ == 0 || tileHeight_ == 0 ||
+						tileX0_ > x0_ || tileY0_ > y0_ || tileX0_ + tileWidth_ <= x0_ || tileY0_ + tileHeight_ <= y0_ ||
+						count == 0 || length < 36 + 3 * count)
+					{
+						error = "Malformed JPEG 2000 SIZ segment";
+						return false;
+					}
+
+					precision_.resize(count);
+					signed_.resize(count);
+					for (size_t c = 0; c < count; ++c)
+					{
+						const uint8_t* entry = segment + 36 + 3 * c;
+						precision_[c] = (entry[0] & 0x7Fu) + 1;
+						signed_[c] = (entry[0] & 0x80) != 0;
+						if (entry[1] != 1 || entry[2] != 1)
+						{
+							error = "Subsampled JPEG 2000 components are not supported";
+							return false;
+						}
+					}
+
+					tilesWide_ = static_cast<uint32_t>((x1_ - tileX0_ + tileWidth_ - 1) / tileWidth_);
+					tilesHigh_ = static_cast<uint32_t>((y1_ - tileY0_ + tileHeight_ - 1) / tileHeight_);
+					if (static_cast<uint64_t>(tilesWide_) * tilesHigh_ > 65535)
+					{
+						error = "Malformed JPEG 2000 SIZ segment";
+						return false;
+					}
+
+					ComponentParameters defaults;
+					std::memset(&defaults.coding, 0, sizeof(defaults.coding));
+					defaults.quantization.style = 0;
+					defaults.quantization.guardBits = 0;
+					defaults.roiShift = 0;
+					defaults.codingFromCoc = false;
+					defaults.quantizationFromQcc = false;
+					main_.sop = false;
+					main_.eph = false;
+					main_.progression = kLRCP;
+					main_.layers = 1;
+					main_.mct = false;
+					main_.components.assign(count, defaults);
+					return true;
+				}
+
+				/// COD, COC, QCD, QCC and RGN of a main or tile-part header; other markers are skipped
+				bool ReadParameters(uint16_t marker, const uint8_t* segment, size_t length, Parameters& parameters, std::string& error)
+				{
+					size_t componentBytes = parameters.components.size() < 257 ? 1 : 2;
+					size_t component = 0;
+					if (marker == kCOC || marker == kQCC || marker == kRGN)
+					{
+						if (length < componentBytes)
+						{
+							error = "Malformed JPEG 2000 marker segment";
+							return false;
+						}
+						component = componentBytes == 1 ? segment[0] : ReadUInt16BE(segment);
+						if (component >= parameters.components.size())
+						{
+							error = "JPEG 2000 marker segment references an unknown component";
+							return false;
+						}
+					}
+
+					switch (marker)
+					{
+					case kCOD:
+					{
+						CodingStyle style;
+						if (length < 5 || segment[1] > kCPRL || ReadUInt16BE(segment + 2) == 0 ||
+							!ParseCodingStyle(segment + 5, length - 5, (segment[0] & 1) != 0, style))
+						{
+							error = "Malformed JPEG 2000 COD segment";
+							return false;
+						}
+						parameters.sop = (segment[0] & 2) != 0;
+						parameters.eph = (segment[0] & 4) != 0;
+						parameters.progression = segment[1];
+						parameters.layers = ReadUInt16BE(segment + 2);
+						parameters.mct = segment[4] != 0;
+						for (ComponentParameters& entry : parameters.components)
+						{
+							if (!entry.codingFromCoc)
+							{
+								entry.coding = style;
+							}
+						}
+						return true;
+					}
+					case kCOC:
+					{
+						ComponentParameters& entry = parameters.components[component];
+						if (length < componentBytes + 1 ||
+							!ParseCodingStyle(segment + componentBytes + 1, length - componentBytes - 1, (segment[componentBytes] & 1) != 0, entry.coding))
+						{
+							error = "Malformed JPEG 2000 COC segment";
+							return false;
+						}
+						entry.codingFromCoc = true;
+						return true;
+					}
+					case kQCD:
+					{
+						QuantizationStyle quantization;
+						if (!ParseQuantization(segment, length, quantization))
+						{
+							error = "Malformed JPEG 2000 QCD segment";
+							return false;
+						}
+						for (ComponentParameters& entry : parameters.components)
+						{
+							if (!entry.quantizationFromQcc)
+							{
+								entry.quantization = quantization;
+							}
+						}
+						return true;
+					}
+					case kQCC:
+					{
+						ComponentParameters& entry = parameters.components[component];
+						if (!ParseQuantization(segment + componentBytes, length - componentBytes, entry.quantization))
+						{
+							error = "Malformed JPEG 2000 QCC segment";
+							return false;
+						}
+						entry.quantizationFromQcc = true;
+						return true;
+					}
+					case kRGN:
+						if (length < componentBytes + 2 || segment[componentBytes] != 0 || segment[componentBytes + 1] > 31)
+						{
+							error = "Unsupported JPEG 2000 RGN segment";
+							return false;
+						}
+						parameters.components[component].roiShift = segment[componentBytes + 1];
+						return true;
+					case kCAP:
+						error = "HTJ2K (JPEG 2000 Part 15) codestreams are not supported";
+						return false;
+					case kPOC:
+						error = "JPEG 2000 progression order changes (POC) are not supported";
+						return false;
+					case kPPT:
+						error = "JPEG 2000 packed packet headers (PPM/PPT) are not supported";
+						return false;
+					default:
+						return true;   // TLM, PLM, PLT, CRG, COM: nothing the decoder needs
+					}
+				}
+
+				bool CheckFrame(std::string& error)
+				{
+					if (x1_ - x0_ != info_.columns || y1_ - y0_ != info_.rows)
+					{
+						error = "JPEG 2000 dimensions do not match the image";
+						return false;
+					}
+					if (precision_.size() != info_.samplesPerPixel)
+					{
+						error = "JPEG 2000 component count does not match the image";
+						return false;
+					}
+					if (info_.bitsAllocated != 8 && info_.bitsAllocated != 16)
+					{
+						error = "JPEG 2000 output must be 8 or 16 bits allocated";
+						return false;
+					}
+					for (uint32_t precision : precision_)
+					{
+						if (precision > info_.bitsAllocated)
+						{
+							error = "JPEG 2000 sample precision exceeds the bits allocated";
+							return false;
+						}
+					}
+
+					FrameInfo reduced = info_.Reduce(reduction_);
+					outputX0_ = CeilShift(x0_, reduction_);
+					outputY0_ = CeilShift(y0_, reduction_);
+					if (CeilShift(x1_, reduction_) - outputX0_ != reduced.columns ||
+						CeilShift(y1_, reduction_) - outputY0_ != reduced.rows)
+					{
+						error = "JPEG 2000 image origin does not allow this reduction";
+						return false;
+					}
+					return true;
+				}
+
+				bool ReadTileParts(const uint8_t* data, size_t length, size_t position, std::string& error)
+				{
+					tiles_.resize(static_cast<size_t>(tilesWide_) * tilesHigh_);
+					while (position + 2 <= length)
+					{
+						uint16_t marker = ReadUInt16BE(data + position);
+						if (marker == kEOC)
+						{
+							break;
+						}
+						if (marker != kSOT || position + 12 > length || ReadUInt16BE(data + position + 2) != 10)
+						{
+							error = "Malformed JPEG 2000 tile-part header";
+							return false;
+						}
+						uint32_t tileIndex = ReadUInt16BE(data + position + 4);
+						uint32_t partLength = ReadUInt32BE(data + position + 6);
+						if (tileIndex >= tiles_.size() || (partLength != 0 && partLength < 14))
+						{
+							error = "Malformed JPEG 2000 tile-part header";
+							return false;
+						}
+
+						// Psot 0: the last tile-part, running up to EOC
+						size_t end = length;
+						if (partLength != 0)
+						{
+							end = std::min(length, position + partLength);
+						}
+						else
+						{
+							for (size_t tail = length; tail >= position + 2 && tail + 4 > length; --tail)
+							{
+								if (ReadUInt16BE(data + tail - 2) == kEOC)
+								{
+									end = tail - 2;
+									break;
+								}
+							}
+						}
+
+						TileData& tile = tiles_[tileIndex];
+						bool firstPart = !tile.seen;
+						if (firstPart)
+						{
+							tile.seen = true;
+							tile.parameters = main_;
+							for (ComponentParameters& component : tile.parameters.components)
+							{
+								component.codingFromCoc = false;
+								component.quantizationFromQcc = false;
+							}
+						}
+
+						position += 12;
+						for (;;)
+						{
+							if (position + 2 > end)
+							{
+								error = "JPEG 2000 tile-part header is truncated";
+								return false;
+							}
+							marker = ReadUInt16BE(data + position);
+							if (marker == kSOD)
+							{
+								position += 2;
+								break;
+							}
+							if (position + 4 > end)
+							{
+								error = "JPEG 2000 tile-part header is truncated";
+								return false;
+							}
+							size_t segmentLength = ReadUInt16BE(data + position + 2);
+							if ((marker >> 8) != 0xFF || segmentLength < 2 || position + 2 + segmentLength > end)
+							{
+								error = "Malformed JPEG 2000 marker segment";
+								return false;
+							}
+							const uint8_t* segment = data + position + 4;
+							position += 2 + segmentLength;
+
+							// Coding parameters may only change in a tile's first tile-part
+							bool parameter = marker == kCOD || marker == kCOC || marker == kQCD || marker == kQCC || marker == kRGN;
+							if ((firstPart || !parameter) && !ReadParameters(marker, segment, segmentLength - 2, tile.parameters, error))
+							{
+								return false;
+							}
+						}
+
+						if (end > position)
+						{
+							tile.parts.push_back(std::make_pair(position, end - position));
+						}
+						position = end;
+					}
+					return true;
+				}
+
+				bool BuildComponent(TileComponent& component, const ComponentParameters& parameters, uint32_t precision,
+					int64_t tx0, int64_t ty0, int64_t tx1, int64_t ty1, std::string& error)
+				{
+					const CodingStyle& coding = parameters.coding;
+					const QuantizationStyle& quantization = parameters.quantization;
+					if (coding.blockStyle & Jpeg2000HighThroughput)
+					{
+						error = "HTJ2K (JPEG 2000 Part 15) code blocks are not supported";
+						return false;
+					}
+					if (reduction_ > coding.levels)
+					{
+						error = "JPEG 2000 image has fewer decomposition levels than the requested reduction";
+						return false;
+					}
+					uint32_t levels = coding.levels;
+					if (quantization.style != 1 && quantization.steps.size() < 3 * levels + 1)
+					{
+						error = "JPEG 2000 quantization does not cover every subband";
+						return false;
+					}
+
+					component.parameters = &parameters;
+					component.decodedLevel = levels - reduction_;
+					component.resolutions.resize(levels + 1);
+					for (uint32_t r = 0; r <= levels; ++r)
+					{
+						Resolution& resolution = component.resolutions[r];
+						uint32_t shift = levels - r;
+						resolution.x0 = CeilShift(tx0, shift);
+						resolution.y0 = CeilShift(ty0, shift);
+						resolution.x1 = CeilShift(tx1, shift);
+						resolution.y1 = CeilShift(ty1, shift);
+						resolution.precinctWidth = coding.precincts[r] & 0x0Fu;
+						resolution.precinctHeight = coding.precincts[r] >> 4;
+						if (r > 0 && (resolution.precinctWidth == 0 || resolution.precinctHeight == 0))
+						{
+							error = "Invalid JPEG 2000 precinct size";
+							return false;
+						}
+
+						resolution.precinctsWide = 0;
+						resolution.precinctsHigh = 0;
+						resolution.firstPrecinctX = resolution.x0 >> resolution.precinctWidth;
+						resolution.firstPrecinctY = resolution.y0 >> resolution.precinctHeight;
+						if (resolution.x1 > resolution.x0 && resolution.y1 > resolution.y0)
+						{
+							resolution.precinctsWide = static_cast<uint32_t>(CeilShift(resolution.x1, resolution.precinctWidth) - resolution.firstPrecinctX);
+							resolution.precinctsHigh = static_cast<uint32_t>(CeilShift(resolution.y1, resolution.precinctHeight) - resolution.firstPrecinctY);
+						}
+
+						resolution.bandCount = r == 0 ? 1 : 3;
+						for (uint32_t b = 0; b < resolution.bandCount; ++b)
+						{
+							Band& band = resolution.bands[b];
+							band.orientation = static_cast<Jpeg2000Orientation>(r == 0 ? 0u : b + 1);
+							uint32_t xob = band.orientation & 1;
+							uint32_t yob = band.orientation >> 1;
+							uint32_t bandLevel = r == 0 ? levels : levels - r + 1;
+							int64_t half = bandLevel > 0 ? int64_t(1) << (bandLevel - 1) : 0;
+							band.x0 = CeilShift(tx0 - half * xob, bandLevel);
+							band.y0 = CeilShift(ty0 - half * yob, bandLevel);
+							band.x1 = CeilShift(tx1 - half * xob, bandLevel);
+							band.y1 = CeilShift(ty1 - half * yob, bandLevel);
+							band.offsetX = xob ? static_cast<size_t>(component.resolutions[r - 1].x1 - component.resolutions[r - 1].x0) : 0;
+							band.offsetY = yob ? static_cast<size_t>(component.resolutions[r - 1].y1 - component.resolutions[r - 1].y0) : 0;
+
+							// Exponent and mantissa of the step size (T.800 E.1)
+							uint32_t index = r == 0 ? 0 : 3 * (r - 1) + band.orientation;
+							int32_t exponent;
+							uint32_t mantissa;
+							if (quantization.style == 1)
+							{
+								exponent = static_cast<int32_t>(quantization.steps[0] >> 11) - static_cast<int32_t>(levels - bandLevel);
+								mantissa = quantization.steps[0] & 0x7FFu;
+							}
+							else
+							{
+								exponent = quantization.steps[index] >> 11;
+								mantissa = quantization.steps[index] & 0x7FFu;
+							}
+							int32_t magnitudeBits = static_cast<int32_t>(quantization.guardBits) + exponent - 1;
+							if (exponent < 0 || magnitudeBits > 37)
+							{
+								error = "Invalid JPEG 2000 quantization step";
+								return false;
+							}
+							band.magnitudeBits = static_cast<uint32_t>(std::max(0, magnitudeBits));
+							int gain = band.orientation == Jpeg2000LL ? 0 : (band.orientation == Jpeg2000HH ? 2 : 1);
+							band.step = static_cast<float>(std::ldexp(1.0 + mantissa / 2048.0,
+								static_cast<int>(precision) + gain - exponent));
+						}
+
+						// Precincts partition each band into groups of code blocks
+						uint32_t bandPrecinctWidth = r == 0 ? resolution.precinctWidth : resolution.precinctWidth - 1;
+						uint32_t bandPrecinctHeight = r == 0 ? resolution.precinctHeight : resolution.precinctHeight - 1;
+						uint32_t blockWidth = std::min(coding.blockWidth, bandPrecinctWidth);
+						uint32_t blockHeight = std::min(coding.blockHeight, bandPrecinctHeight);
+						resolution.precincts.resize(static_cast<size_t>(resolution.precinctsWide) * resolution.precinctsHigh);
+						for (size_t p = 0; p < resolution.precincts.size(); ++p)
+						{
+							int64_t kx = resolution.firstPrecinctX + static_cast<int64_t>(p % resolution.precinctsWide);
+							int64_t ky = resolution.firstPrecinctY + static_cast<int64_t>(p / resolution.precinctsWide);
+							for (uint32_t b = 0; b < resolution.bandCount; ++b)
+							{
+								const Band& band = resolution.bands[b];
+								PrecinctBand& group = resolution.precincts[p].bands[b];
+								int64_t px0 = std::max(band.x0, kx << bandPrecinctWidth);
+								int64_t py0 = std::max(band.y0, ky << bandPrecinctHeight);
+								int64_t px1 = std::min(band.x1, (kx + 1) << bandPrecinctWidth);
+								int64_t py1 = std::min(band.y1, (ky + 1) << bandPrecinctHeight);
+								group.blocksWide = 0;
+								group.blocksHigh = 0;
+								if (px1 > px0 && py1 > py0)
+								{
+									int64_t bx0 = px0 >> blockWidth;
+									int64_t by0 = py0 >> blockHeight;
+									group.blocksWide = static_cast<uint32_t>(CeilShift(px1, blockWidth) - bx0);
+									group.blocksHigh = static_cast<uint32_t>(CeilShift(py1, blockHeight) - by0);
+									group.blocks.resize(static_cast<size_t>(group.blocksWide) * group.blocksHigh);
+									for (uint32_t by = 0; by < group.blocksHigh; ++by)
+									{
+										for (uint32_t bx = 0; bx < group.blocksWide; ++bx)
+										{
+											CodeBlock& block = group.blocks[by * group.blocksWide + bx];
+											block.x0 = std::max(px0, (bx0 + bx) << blockWidth);
+											block.y0 = std::max(py0, (by0 + by) << blockHeight);
+											block.x1 = std::min(px1, (bx0 + bx + 1) << blockWidth);
+											block.y1 = std::min(py1, (by0 + by + 1) << blockHeight);
+											block.lengthBits = 3;
+											block.zeroBitPlanes = 0;
+											block.included = false;
+										}
+									}
+								}
+								group.inclusion.Reset(group.blocksWide, group.blocksHigh);
+								group.zeroPlanes.Reset(group.blocksWide, group.blocksHigh);
+							}
+						}
+					}
+
+					const Resolution& top = component.resolutions[component.decodedLevel];
+					component.stride = static_cast<size_t>(top.x1 - top.x0);
+					component.height = static_cast<size_t>(top.y1 - top.y0);
+					if (coding.reversible)
+					{
+						component.integers.assign(component.stride * component.height, 0);
+					}
+					else
+					{
+						component.reals.assign(component.stride * component.height, 0.0f);
+					}
+					return true;
+				}
+
+				/// Packet order of the tile; resolution-major orders stop at the last decoded level
+				void BuildProgression(const Parameters& parameters, const std::vector<TileComponent>& components,
+					int64_t tx0, int64_t ty0, std::vector<PacketId>& packets) const
+				{
+					uint32_t maxLevel = 0;
+					uint32_t maxDecoded = 0;
+					for (const TileComponent& component : components)
+					{
+						maxLevel = std::max(maxLevel, static_cast<uint32_t>(component.resolutions.size() - 1));
+						maxDecoded = std::max(maxDecoded, component.decodedLevel);
+					}
+					uint32_t layers = parameters.layers;
+					uint32_t count = static_cast<uint32_t>(components.size());
+					packets.clear();
+
+					auto addPrecincts = [&](uint32_t layer, uint32_t r, uint32_t c)
+					{
+						const std::vector<Resolution>& resolutions = components[c].resolutions;
+						if (r < resolutions.size())
+						{
+							for (uint32_t p = 0; p < resolutions[r].precincts.size(); ++p)
+							{
+								packets.push_back({ layer, r, c, p });
+							}
+						}
+					};
+
+					if (parameters.progression == kLRCP)
+					{
+						for (uint32_t layer = 0; layer < layers; ++layer)
+							for (uint32_t r = 0; r <= maxLevel; ++r)
+								for (uint32_t c = 0; c < count; ++c)
+									addPrecincts(layer, r, c);
+						return;
+					}
+					if (parameters.progression == kRLCP)
+					{
+						for (uint32_t r = 0; r <= maxDecoded; ++r)
+							for (uint32_t layer = 0; layer < layers; ++layer)
+								for (uint32_t c = 0; c < count; ++c)
+									addPrecincts(layer, r, c);
+						return;
+					}
+
+					// Position orders visit precincts where they start on the reference
+					// grid; a precinct clipped by the tile edge starts at the tile origin
+					std::vector<PrecinctPosition> positions;
+					for (uint32_t c = 0; c < count; ++c)
+					{
+						const std::vector<Resolution>& resolutions = components[c].resolutions;
+						uint32_t levels = static_cast<uint32_t>(resolutions.size() - 1);
+						for (uint32_t r = 0; r <= levels; ++r)
+						{
+							if (parameters.progression == kRPCL && r > maxDecoded)
+							{
+								break;
+							}
+							const Resolution& resolution = resolutions[r];
+							for (uint32_t p = 0; p < resolution.precincts.size(); ++p)
+							{
+								int64_t px = (resolution.firstPrecinctX + p % resolution.precinctsWide) << resolution.precinctWidth;
+								int64_t py = (resolution.firstPrecinctY + p / resolution.precinctsWide) << resolution.precinctHeight;
+								PrecinctPosition position;
+								position.resolution = r;
+								position.component = c;
+								position.precinct = p;
+								position.x = px < resolution.x0 ? tx0 : px << (levels - r);
+								position.y = py < resolution.y0 ? ty0 : py << (levels - r);
+								positions.push_back(position);
+							}
+						}
+					}
+
+					uint32_t order = parameters.progression;
+					std::sort(positions.begin(), positions.end(), [order](const PrecinctPosition& a, const PrecinctPosition& b)
+					{
+						if (order == kRPCL)
+						{
+							if (a.resolution != b.resolution) return a.resolution < b.resolution;
+							if (a.y != b.y) return a.y < b.y;
+							if (a.x != b.x) return a.x < b.x;
+							return a.component < b.component;
+						}
+						if (order == kCPRL && a.component != b.component)
+						{
+							return a.component < b.component;
+						}
+						if (a.y != b.y) return a.y < b.y;
+						if (a.x != b.x) return a.x < b.x;
+						if (a.component != b.component) return a.component < b.component;
+						return a.resolution < b.resolution;
+					});
+
+					for (const PrecinctPosition& position : positions)
+					{
+						for (uint32_t layer = 0; layer < layers; ++layer)
+						{
+							packets.push_back({ layer, position.resolution, position.component, position.precinct });
+						}
+					}
+				}
+
+				/// Read one packet (T.800 B.9 and B.10), appending its data to the code blocks
+				bool ReadPacket(const uint8_t* data, size_t length, size_t& position, const Parameters& parameters,
+					uint32_t blockStyle, uint32_t layer, Resolution& resolution, Precinct& precinct, bool store, std::string& error)
+				{
+					if (parameters.sop && position + 6 <= length && ReadUInt16BE(data + position) == kSOP)
+					{
+						position += 6;
+					}
+
+					pending_.clear();
+					PacketHeaderReader reader(data, length, position);
+					if (reader.Bit())
+					{
+						for (uint32_t b = 0; b < resolution.bandCount; ++b)
+						{
+							PrecinctBand& group = precinct.bands[b];
+							for (uint32_t i = 0; i < group.blocks.size(); ++i)
+							{
+								CodeBlock& block = group.blocks[i];
+								bool included = block.included ? reader.Bit() != 0 : group.inclusion.Decode(reader, i, layer + 1);
+								if (!included)
+								{
+									continue;
+								}
+								if (!block.included)
+								{
+									uint32_t threshold = 1;
+									while (!group.zeroPlanes.Decode(reader, i, threshold))
+									{
+										if (++threshold > 64 || reader.Overrun())
+										{
+											error = "Malformed JPEG 2000 packet header";
+											return false;
+										}
+									}
+									block.zeroBitPlanes = group.zeroPlanes.Value(i);
+									block.included = true;
+								}
+
+								uint32_t passes = ReadPassCount(reader);
+								while (reader.Bit())
+								{
+									if (++block.lengthBits > 32)
+									{
+										error = "Malformed JPEG 2000 packet header";
+										return false;
+									}
+								}
+
+								// One length per codeword segment the new passes reach into
+								while (passes > 0)
+								{
+									uint32_t limit = SegmentPasses(blockStyle, block.segments.empty() ? 0 : block.segments.size() - 1);
+									if (block.segments.empty() || block.segments.back().passes >= limit)
+									{
+										limit = SegmentPasses(blockStyle, block.segments.size());
+										block.segments.push_back({ 0, 0, 0 });
+									}
+									Jpeg2000Segment& segment = block.segments.back();
+									uint32_t added = std::min(passes, limit - segment.passes);
+									uint32_t bits = block.lengthBits + FloorLog2(added);
+									if (bits > 32)
+									{
+										error = "Malformed JPEG 2000 packet header";
+										return false;
+									}
+									pending_.push_back({ &block, block.segments.size() - 1, reader.Bits(bits) });
+									segment.passes += added;
+									passes -= added;
+								}
+							}
+						}
+					}
+
+					position = reader.Finish();
+					if (reader.Overrun())
+					{
+						error = "JPEG 2000 packet header runs past the tile data";
+						return false;
+					}
+					if (parameters.eph && position + 2 <= length && ReadUInt16BE(data + position) == kEPH)
+					{
+						position += 2;
+					}
+
+					for (const PendingData& entry : pending_)
+					{
+						if (entry.length > length - position)
+						{
+							error = "JPEG 2000 tile data is truncated";
+							return false;
+						}
+						if (store)
+						{
+							entry.block->data.insert(entry.block->data.end(), data + position, data + position + entry.length);
+							entry.block->segments[entry.segment].length += entry.length;
+						}
+						position += entry.length;
+					}
+					return true;
+				}
+
+				bool DecodeTile(uint32_t tileIndex, const Parameters& parameters, const uint8_t* data, size_t length,
+					uint8_t* output, std::string& error)
+				{
+					uint32_t p = tileIndex % tilesWide_;
+					uint32_t q = tileIndex / tilesWide_;
+					int64_t tx0 = std::max<int64_t>(tileX0_ + static_cast<int64_t>(p) * tileWidth_, x0_);
+					int64_t ty0 = std::max<int64_t>(tileY0_ + static_cast<int64_t>(q) * tileHeight_, y0_);
+					int64_t tx1 = std::min<int64_t>(tileX0_ + static_cast<int64_t>(p + 1) * tileWidth_, x1_);
+					int64_t ty1 = std::min<int64_t>(tileY0_ + static_cast<int64_t>(q + 1) * tileHeight_, y1_);
+
+					std::vector<TileComponent> components(parameters.components.size());
+					for (size_t c = 0; c < components.size(); ++c)
+					{
+						if (!BuildComponent(components[c], parameters.components[c], precision_[c], tx0, ty0, tx1, ty1, error))
+						{
+							return false;
+						}
+					}
+
+					// Tier-2: packet headers, in progression order
+					std::vector<PacketId> packets;
+					BuildProgression(parameters, components, tx0, ty0, packets);
+					size_t position = 0;
+					for (const PacketId& packet : packets)
+					{
+						if (position >= length)
+						{
+							break;   // Later layers were truncated away
+						}
+						TileComponent& component = components[packet.component];
+						Resolution& resolution = component.resolutions[packet.resolution];
+						if (!ReadPacket(data, length, position, parameters, component.parameters->coding.blockStyle, packet.layer,
+							resolution, resolution.precincts[packet.precinct], packet.resolution <= component.decodedLevel, error))
+						{
+							return false;
+						}
+					}
+
+					if (!DecodeBlocks(components, error))
+					{
+						return false;
+					}
+
+					for (TileComponent& component : components)
+					{
+						for (uint32_t r = 1; r <= component.decodedLevel; ++r)
+						{
+							const Resolution& low = component.resolutions[r - 1];
+							const Resolution& current = component.resolutions[r];
+							uint32_t width = static_cast<uint32_t>(current.x1 - current.x0);
+							uint32_t height = static_cast<uint32_t>(current.y1 - current.y0);
+							uint32_t lowWidth = static_cast<uint32_t>(low.x1 - low.x0);
+							uint32_t lowHeight = static_cast<uint32_t>(low.y1 - low.y0);
+							bool xOdd = (current.x0 & 1) != 0;
+							bool yOdd = (current.y0 & 1) != 0;
+							if (component.parameters->coding.reversible)
+							{
+								Jpeg2000Wavelet::Inverse53(component.integers.data(), component.stride, width, height, lowWidth, lowHeight, xOdd, yOdd);
+							}
+							else
+							{
+								Jpeg2000Wavelet::Inverse97(component.reals.data(), component.stride, width, height, lowWidth, lowHeight, xOdd, yOdd);
+							}
+						}
+					}
+
+					if (parameters.mct && components.size() >= 3 && !InverseComponentTransform(components, error))
+					{
+						return false;
+					}
+					WriteTile(components, output);
+					return true;
+				}
+
+				/// Tier-1: entropy-decode every stored code block on the thread pool and dequantize it
+				bool DecodeBlocks(std::vector<TileComponent>& components, std::string& error)
+				{
+					struct BlockJob
+					{
+						CodeBlock* block;
+						const Band* band;
+						TileComponent* component;
+					};
+					std::vector<BlockJob> jobs;
+					for (TileComponent& component : components)
+					{
+						for (uint32_t r = 0; r <= component.decodedLevel; ++r)
+						{
+							Resolution& resolution = component.resolutions[r];
+							for (Precinct& precinct : resolution.precincts)
+							{
+								for (uint32_t b = 0; b < resolution.bandCount; ++b)
+								{
+									for (CodeBlock& block : precinct.bands[b].blocks)
+									{
+										if (!block.segments.empty())
+										{
+											jobs.push_back({ &block, &resolution.bands[b], &component });
+										}
+									}
+								}
+							}
+						}
+					}
+
+					std::atomic<bool> failed(false);
+					ThreadPool::Shared().ParallelFor(jobs.size(), [&](size_t index)
+					{
+						static thread_local Jpeg2000BlockDecoder decoder;
+						static thread_local std::vector<int32_t> coefficients;
+						const BlockJob& job = jobs[index];
+						CodeBlock& block = *job.block;
+						const Band& band = *job.band;
+						const ComponentParameters& parameters = *job.component->parameters;
+
+						uint32_t roiShift = parameters.roiShift;
+						int32_t planes = static_cast<int32_t>(band.magnitudeBits + roiShift) - static_cast<int32_t>(block.zeroBitPlanes);
+						if (planes <= 0)
+						{
+							return;
+						}
+
+						size_t offset = 0;
+						for (Jpeg2000Segment& segment : block.segments)
+						{
+							segment.offset = offset;
+							offset += segment.length;
+						}
+						uint32_t width = static_cast<uint32_t>(block.x1 - block.x0);
+						uint32_t height = static_cast<uint32_t>(block.y1 - block.y0);
+						coefficients.resize(static_cast<size_t>(width) * height);
+						if (!decoder.Decode(block.data.data(), block.segments.data(), block.segments.size(), width, height,
+							band.orientation, parameters.coding.blockStyle, static_cast<uint32_t>(planes), coefficients.data()))
+						{
+							failed = true;
+							return;
+						}
+
+						// Max-shift ROI: region coefficients were scaled above every background one
+						if (roiShift != 0)
+						{
+							int32_t threshold = 2 << roiShift;
+							for (int32_t& value : coefficients)
+							{
+								int32_t magnitude = value < 0 ? -value : value;
+								if (magnitude >= threshold)
+								{
+									magnitude >>= roiShift;
+									value = value < 0 ? -magnitude : magnitude;
+								}
+							}
+						}
+
+						TileComponent& component = *job.component;
+						size_t x = band.offsetX + static_cast<size_t>(block.x0 - band.x0);
+						size_t y = band.offsetY + static_cast<size_t>(block.y0 - band.y0);
+						const int32_t* source = coefficients.data();
+						if (parameters.coding.reversible)
+						{
+							for (uint32_t row = 0; row < height; ++row, source += width)
+							{
+								int32_t* destination = component.integers.data() + (y + row) * component.stride + x;
+								for (uint32_t column = 0; column < width; ++column)
+								{
+									destination[column] = source[column] / 2;
+								}
+							}
+						}
+						else
+						{
+							float scale = band.step * 0.5f;
+							for (uint32_t row = 0; row < height; ++row, source += width)
+							{
+								float* destination = component.reals.data() + (y + row) * component.stride + x;
+								for (uint32_t column = 0; column < width; ++column)
+								{
+									destination[column] = static_cast<float>(source[column]) * scale;
+								}
+							}
+						}
+					});
+
+					if (failed)
+					{
+						error = "Invalid JPEG 2000 code block";
+						return false;
+					}
+					return true;
+				}
+
+				bool InverseComponentTransform(std::vector<TileComponent>& components, std::string& error)
+				{
+					bool reversible = components[0].parameters->coding.reversible;
+					for (int c = 1; c < 3; ++c)
+					{
+						if (components[c].parameters->coding.reversible != reversible ||
+							components[c].stride != components[0].stride || components[c].height != components[0].height)
+						{
+							error = "JPEG 2000 component transform needs three matching components";
+							return false;
+						}
+					}
+
+					size_t count = components[0].stride * components[0].height;
+					if (reversible)
+					{
+						int32_t* y = components[0].integers.data();
+						int32_t* cb = components[1].integers.data();
+						int32_t* cr = components[2].integers.data();
+						for (size_t i = 0; i < count; ++i)
+						{
+							int32_t g = y[i] - ((cb[i] + cr[i]) >> 2);
+							int32_t r = cr[i] + g;
+							int32_t b = cb[i] + g;
+							y[i] = r;
+							cb[i] = g;
+							cr[i] = b;
+						}
+					}
+					else
+					{
+						float* y = components[0].reals.data();
+						float* cb = components[1].reals.data();
+						float* cr = components[2].reals.data();
+						for (size_t i = 0; i < count; ++i)
+						{
+							float r = y[i] + 1.402f * cr[i];
+							float g = y[i] - 0.34413f * cb[i] - 0.71414f * cr[i];
+							float b = y[i] + 1.772f * cb[i];
+							y[i] = r;
+							cb[i] = g;
+							cr[i] = b;
+						}
+					}
+					return true;
+				}
+
+				/// DC level shift, clamp and store the tile's samples interleaved
+				void WriteTile(const std::vector<TileComponent>& components, uint8_t* output) const
+				{
+					FrameInfo reduced = info_.Reduce(reduction_);
+					size_t samples = components.size();
+					size_t bytes = info_.bitsAllocated / 8;
+					static thread_local std::vector<int32_t> row;
+
+					for (size_t c = 0; c < samples; ++c)
+					{
+						const TileComponent& component = components[c];
+						const Resolution& resolution = component.resolutions[component.decodedLevel];
+						size_t width = component.stride;
+						size_t outputX = static_cast<size_t>(resolution.x0 - outputX0_);
+						size_t outputY = static_cast<size_t>(resolution.y0 - outputY0_);
+						int32_t precision = static_cast<int32_t>(precision_[c]);
+						int32_t shift = signed_[c] ? 0 : 1 << (precision - 1);
+						int32_t minimum = signed_[c] ? -(1 << (precision - 1)) : 0;
+						int32_t maximum = signed_[c] ? (1 << (precision - 1)) - 1 : (1 << precision) - 1;
+						bool reversible = component.parameters->coding.reversible;
+						row.resize(width);
+
+						for (size_t y = 0; y < component.height; ++y)
+						{
+							if (reversible)
+							{
+								std::memcpy(row.data(), component.integers.data() + y * width, width * sizeof(int32_t));
+							}
+							else
+							{
+								const float* source = component.reals.data() + y * width;
+								for (size_t x = 0; x < width; ++x)
+								{
+									row[x] = static_cast<int32_t>(std::lrint(source[x]));
+								}
+							}
+
+							uint8_t* destination = output + (((outputY + y) * reduced.columns + outputX) * samples + c) * bytes;
+							size_t step = samples * bytes;
+							for (size_t x = 0; x < width; ++x, destination += step)
+							{
+								int32_t value = std::max(minimum, std::min(maximum, row[x] + shift));
+								destination[0] = static_cast<uint8_t>(value);
+								if (bytes == 2)
+								{
+									destination[1] = static_cast<uint8_t>(value >> 8);
+								}
+							}
+						}
+					}
+				}
+
+			private:
+				struct PendingData
+				{
+					CodeBlock* block;
+					size_t segment;
+					uint32_t length;
+				};
+
+				const FrameInfo& info_;
+				uint32_t reduction_;
+				int64_t x0_;
+				int64_t y0_;
+				int64_t x1_;
+				int64_t y1_;
+				int64_t tileWidth_;
+				int64_t tileHeight_;
+				int64_t tileX0_;
+				int64_t tileY0_;
+				uint32_t tilesWide_;
+				uint32_t tilesHigh_;
+				int64_t outputX0_;      // Image origin at the decoded resolution
+				int64_t outputY0_;
+				std::vector<uint32_t> precision_;
+				std::vector<bool> signed_;
+				Parameters main_;
+				std::vector<TileData> tiles_;
+				std::vector<PendingData> pending_;
+			};
+		}
+
+		bool Jpeg2000Decoder::DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+			uint8_t* output, std::string& error) const
+		{
+			return DecodeFrameReduced(data, length, info, 0, output, error);
+		}
+
+		bool Jpeg2000Decoder::DecodeFrameReduced(const uint8_t* data, size_t length, const FrameInfo& info,
+			uint32_t reduction, uint8_t* output, std::string& error) const
+		{
+			if (reduction > 32)
+			{
+				error = "JPEG 2000 image has fewer decomposition levels than the requested reduction";
+				return false;
+			}
+			CodestreamDecoder decoder(info, reduction);
+			return decoder.Decode(data, length, output, error);
+		}
+
+		std::string Jpeg2000Decoder::GetDecodedPhotometricInterpretation(const FrameInfo& info) const
+		{
+			// The inverse component transform is part of decoding
+			if (info.photometricInterpretation == "YBR_RCT" || info.photometricInterpretation == "YBR_ICT")
+			{
+				return "RGB";
+			}
+			return info.photometricInterpretation;
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,484 @@
+#include "medvision/dicom/Jpeg2000Entropy.h"
+#include <algorithm>
+#include <cstring>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			// Qe, next index after MPS, next index after LPS, MPS switch (T.800 Table C.2)
+			const uint32_t kQeTable[47][4] = {
+				{ 0x5601, 1, 1, 1 }, { 0x3401, 2, 6, 0 }, { 0x1801, 3, 9, 0 }, { 0x0AC1, 4, 12, 0 },
+				{ 0x0521, 5, 29, 0 }, { 0x0221, 38, 33, 0 }, { 0x5601, 7, 6, 1 }, { 0x5401, 8, 14, 0 },
+				{ 0x4801, 9, 14, 0 }, { 0x3801, 10, 14, 0 }, { 0x3001, 11, 17, 0 }, { 0x2401, 12, 18, 0 },
+				{ 0x1C01, 13, 20, 0 }, { 0x1601, 29, 21, 0 }, { 0x5601, 15, 14, 1 }, { 0x5401, 16, 14, 0 },
+				{ 0x5101, 17, 15, 0 }, { 0x4801, 18, 16, 0 }, { 0x3801, 19, 17, 0 }, { 0x3401, 20, 18, 0 },
+				{ 0x3001, 21, 19, 0 }, { 0x2801, 22, 19, 0 }, { 0x2401, 23, 20, 0 }, { 0x2201, 24, 21, 0 },
+				{ 0x1C01, 25, 22, 0 }, { 0x1801, 26, 23, 0 }, { 0x1601, 27, 24, 0 }, { 0x1401, 28, 25, 0 },
+				{ 0x1201, 29, 26, 0 }, { 0x1101, 30, 27, 0 }, { 0x0AC1, 31, 28, 0 }, { 0x09C1, 32, 29, 0 },
+				{ 0x08A1, 33, 30, 0 }, { 0x0521, 34, 31, 0 }, { 0x0441, 35, 32, 0 }, { 0x02A1, 36, 33, 0 },
+				{ 0x0221, 37, 34, 0 }, { 0x0141, 38, 35, 0 }, { 0x0111, 39, 36, 0 }, { 0x0085, 40, 37, 0 },
+				{ 0x0049, 41, 38, 0 }, { 0x0025, 42, 39, 0 }, { 0x0015, 43, 40, 0 }, { 0x0009, 44, 41, 0 },
+				{ 0x0005, 45, 42, 0 }, { 0x0001, 45, 43, 0 }, { 0x5601, 46, 46, 0 } };
+
+			// Contexts (T.800 Table D.7): 0-8 zero coding, 9-13 sign, 14-16 refinement
+			const int kRunContext = 17;
+			const int kUniformContext = 18;
+
+			// Per-sample flags. The low byte holds neighbour significance and is the
+			// zero-coding table index; the sign table index is bits 0-3 and 8-11.
+			const uint16_t kSigN = 0x0001;
+			const uint16_t kSigS = 0x0002;
+			const uint16_t kSigW = 0x0004;
+			const uint16_t kSigE = 0x0008;
+			const uint16_t kSigNW = 0x0010;
+			const uint16_t kSigNE = 0x0020;
+			const uint16_t kSigSW = 0x0040;
+			const uint16_t kSigSE = 0x0080;
+			const uint16_t kNegN = 0x0100;
+			const uint16_t kNegS = 0x0200;
+			const uint16_t kNegW = 0x0400;
+			const uint16_t kNegE = 0x0800;
+			const uint16_t kSignificant = 0x1000;
+			const uint16_t kVisited = 0x2000;   // Coded in this bit plane's significance pass
+			const uint16_t kRefined = 0x4000;
+			const uint16_t kNeighbours = 0x00FF;
+
+			// Neighbours in the next stripe, hidden from a stripe's last row in vertically causal mode
+			const uint16_t kCausalMask = static_cast<uint16_t>(~(kSigS | kSigSW | kSigSE | kNegS));
+
+			struct ContextTables
+			{
+				uint8_t zero[4][256];   // By orientation and neighbour significance
+				uint8_t sign[256];      // (context << 1) | XOR bit
+
+				ContextTables()
+				{
+					for (int neighbours = 0; neighbours < 256; ++neighbours)
+					{
+						int h = ((neighbours & kSigW) != 0) + ((neighbours & kSigE) != 0);
+						int v = ((neighbours & kSigN) != 0) + ((neighbours & kSigS) != 0);
+						int d = ((neighbours & kSigNW) != 0) + ((neighbours & kSigNE) != 0) +
+							((neighbours & kSigSW) != 0) + ((neighbours & kSigSE) != 0);
+
+						zero[Jpeg2000LL][neighbours] = zero[Jpeg2000LH][neighbours] = static_cast<uint8_t>(ZeroContext(h, v, d));
+						zero[Jpeg2000HL][neighbours] = static_cast<uint8_t>(ZeroContext(v, h, d));
+						zero[Jpeg2000HH][neighbours] = static_cast<uint8_t>(DiagonalContext(h + v, d));
+					}
+
+					for (int index = 0; index < 256; ++index)
+					{
+						// index bits 0-3: N, S, W, E significant; bits 4-7: the same neighbours negative
+						int vertical = Contribution(index, 0) + Contribution(index, 1);
+						int horizontal = Contribution(index, 2) + Contribution(index, 3);
+						vertical = std::max(-1, std::min(1, vertical));
+						horizontal = std::max(-1, std::min(1, horizontal));
+
+						int context;
+						int flip = 0;
+						if (horizontal == 0)
+						{
+							context = vertical == 0 ? 9 : 10;
+							flip = vertical < 0;
+						}
+						else
+						{
+							context = vertical == 0 ? 12 : (vertical == horizontal ? 13 : 11);
+							flip = horizontal < 0;
+						}
+						sign[index] = static_cast<uint8_t>((context << 1) | flip);
+					}
+				}
+
+				static int ZeroContext(int h, int v, int d)
+				{
+					if (h == 2)
+					{
+						return 8;
+					}
+					if (h == 1)
+					{
+						return v >= 1 ? 7 : (d >= 1 ? 6 : 5);
+					}
+					if (v >= 1)
+					{
+						return v == 2 ? 4 : 3;
+					}
+					return d >= 2 ? 2 : d;
+				}
+
+				static int DiagonalContext(int hv, int d)
+				{
+					if (d >= 3)
+					{
+						return 8;
+					}
+					if (d == 2)
+					{
+						return hv >= 1 ? 7 : 6;
+					}
+					if (d == 1)
+					{
+						return hv >= 2 ? 5 : 3 + hv;
+					}
+					return hv >= 2 ? 2 : hv;
+				}
+
+				static int Contribution(int index, int neighbour)
+				{
+					if ((index & (1 << neighbour)) == 0)
+					{
+						return 0;
+					}
+					return (index & (16 << neighbour)) != 0 ? -1 : 1;
+				}
+			};
+
+			const ContextTables& GetContextTables()
+			{
+				static const ContextTables tables;
+				return tables;
+			}
+
+			inline int SignIndex(uint32_t flags)
+			{
+				return static_cast<int>((flags & 0x0F) | ((flags >> 4) & 0xF0));
+			}
+		}
+
+		const MqDecoder::State MqDecoder::kStates[94] = {
+#define MEDVISION_MQ_STATE(i) \
+			{ kQeTable[i][0], static_cast<uint8_t>(kQeTable[i][1] << 1), static_cast<uint8_t>((kQeTable[i][2] << 1) | kQeTable[i][3]) }, \
+			{ kQeTable[i][0], static_cast<uint8_t>((kQeTable[i][1] << 1) | 1), static_cast<uint8_t>((kQeTable[i][2] << 1) | (1 ^ kQeTable[i][3])) }
+			MEDVISION_MQ_STATE(0), MEDVISION_MQ_STATE(1), MEDVISION_MQ_STATE(2), MEDVISION_MQ_STATE(3),
+			MEDVISION_MQ_STATE(4), MEDVISION_MQ_STATE(5), MEDVISION_MQ_STATE(6), MEDVISION_MQ_STATE(7),
+			MEDVISION_MQ_STATE(8), MEDVISION_MQ_STATE(9), MEDVISION_MQ_STATE(10), MEDVISION_MQ_STATE(11),
+			MEDVISION_MQ_STATE(12), MEDVISION_MQ_STATE(13), MEDVISION_MQ_STATE(14), MEDVISION_MQ_STATE(15),
+			MEDVISION_MQ_STATE(16), MEDVISION_MQ_STATE(17), MEDVISION_MQ_STATE(18), MEDVISION_MQ_STATE(19),
+			MEDVISION_MQ_STATE(20), MEDVISION_MQ_STATE(21), MEDVISION_MQ_STATE(22), MEDVISION_MQ_STATE(23),
+			MEDVISION_MQ_STATE(24), MEDVISION_MQ_STATE(25), MEDVISION_MQ_STATE(26), MEDVISION_MQ_STATE(27),
+			MEDVISION_MQ_STATE(28), MEDVISION_MQ_STATE(29), MEDVISION_MQ_STATE(30), MEDVISION_MQ_STATE(31),
+			MEDVISION_MQ_STATE(32), MEDVISION_MQ_STATE(33), MEDVISION_MQ_STATE(34), MEDVISION_MQ_STATE(35),
+			MEDVISION_MQ_STATE(36), MEDVISION_MQ_STATE(37), MEDVISION_MQ_STATE(38), MEDVISION_MQ_STATE(39),
+			MEDVISION_MQ_STATE(40), MEDVISION_MQ_STATE(41), MEDVISION_MQ_STATE(42), MEDVISION_MQ_STATE(43),
+			MEDVISION_MQ_STATE(44), MEDVISION_MQ_STATE(45), MEDVISION_MQ_STATE(46)
+#undef MEDVISION_MQ_STATE
+		};
+
+		MqDecoder::MqDecoder()
+			: data_(nullptr)
+			, length_(0)
+			, position_(0)
+			, a_(0)
+			, c_(0)
+			, count_(0)
+		{
+			ResetContexts();
+		}
+
+		void MqDecoder::Start(const uint8_t* data, size_t length)
+		{
+			data_ = data;
+			length_ = length;
+			position_ = 0;
+			c_ = static_cast<uint32_t>(ReadByte(0)) << 16;
+			ByteIn();
+			c_ <<= 7;
+			count_ -= 7;
+			a_ = 0x8000;
+		}
+
+		void MqDecoder::ResetContexts()
+		{
+			std::memset(contexts_, 0, sizeof(contexts_));
+			contexts_[0] = 4 << 1;
+			contexts_[kRunContext] = 3 << 1;
+			contexts_[kUniformContext] = 46 << 1;
+		}
+
+		int Jpeg2000BlockDecoder::RawBit()
+		{
+			// Raw segments are bit stuffed: a byte after 0xFF carries only 7 bits
+			if (rawCount_ == 0)
+			{
+				uint32_t next = rawPosition_ < rawLength_ ? rawData_[rawPosition_] : 0xFF;
+				if (rawByte_ == 0xFF)
+				{
+					if (next > 0x8F)
+					{
+						rawByte_ = 0xFF;
+						rawCount_ = 8;
+					}
+					else
+					{
+						rawByte_ = next;
+						++rawPosition_;
+						rawCount_ = 7;
+					}
+				}
+				else
+				{
+					rawByte_ = next;
+					++rawPosition_;
+					rawCount_ = 8;
+				}
+			}
+			--rawCount_;
+			return static_cast<int>((rawByte_ >> rawCount_) & 1);
+		}
+
+		inline int Jpeg2000BlockDecoder::DecodeBit(int context, bool raw)
+		{
+			return raw ? RawBit() : mq_.Decode(context);
+		}
+
+		inline void Jpeg2000BlockDecoder::SetSignificant(size_t index, bool negative)
+		{
+			uint16_t* flags = flags_.data();
+			flags[index] |= kSignificant;
+			flags[index - stride_ - 1] |= kSigSE;
+			flags[index - stride_] |= static_cast<uint16_t>(kSigS | (negative ? kNegS : 0));
+			flags[index - stride_ + 1] |= kSigSW;
+			flags[index - 1] |= static_cast<uint16_t>(kSigE | (negative ? kNegE : 0));
+			flags[index + 1] |= static_cast<uint16_t>(kSigW | (negative ? kNegW : 0));
+			flags[index + stride_ - 1] |= kSigNE;
+			flags[index + stride_] |= static_cast<uint16_t>(kSigN | (negative ? kNegN : 0));
+			flags[index + stride_ + 1] |= kSigNW;
+		}
+
+		// Sign of a sample that just became significant; flags are already masked
+		inline void Jpeg2000BlockDecoder::DecodeSignificant(size_t index, uint32_t flags, int32_t& magnitude, int plane, bool raw)
+		{
+			bool negative;
+			if (raw)
+			{
+				negative = RawBit() != 0;
+			}
+			else
+			{
+				int entry = GetContextTables().sign[SignIndex(flags)];
+				negative = (mq_.Decode(entry >> 1) ^ (entry & 1)) != 0;
+			}
+
+			magnitude = 3 << plane;   // One and a half times the plane value, in half units
+			if (negative)
+			{
+				magnitude = -magnitude;
+			}
+			SetSignificant(index, negative);
+		}
+
+		void Jpeg2000BlockDecoder::SignificancePass(int plane, bool raw)
+		{
+			const uint8_t* zero = zeroContexts_;
+			uint16_t* flags = flags_.data();
+			for (uint32_t stripe = 0; stripe < height_; stripe += 4)
+			{
+				uint32_t rows = std::min<uint32_t>(4, height_ - stripe);
+				for (uint32_t x = 0; x < width_; ++x)
+				{
+					size_t index = (stripe + 1) * stride_ + x + 1;
+					for (uint32_t y = 0; y < rows; ++y, index += stride_)
+					{
+						uint32_t state = flags[index];
+						if (verticalCausal_ && y == 3)
+						{
+							state &= kCausalMask;
+						}
+						if ((state & (kSignificant | kVisited)) != 0 || (state & kNeighbours) == 0)
+						{
+							continue;
+						}
+						if (DecodeBit(zero[state & kNeighbours], raw))
+						{
+							DecodeSignificant(index, state, magnitudes_[(stripe + y) * width_ + x], plane, raw);
+						}
+						flags[index] |= kVisited;
+					}
+				}
+			}
+		}
+
+		void Jpeg2000BlockDecoder::RefinementPass(int plane, bool raw)
+		{
+			uint16_t* flags = flags_.data();
+			int32_t half = 1 << plane;
+			for (uint32_t stripe = 0; stripe < height_; stripe += 4)
+			{
+				uint32_t rows = std::min<uint32_t>(4, height_ - stripe);
+				for (uint32_t x = 0; x < width_; ++x)
+				{
+					size_t index = (stripe + 1) * stride_ + x + 1;
+					for (uint32_t y = 0; y < rows; ++y, index += stride_)
+					{
+						uint32_t state = flags[index];
+						if ((state & (kSignificant | kVisited)) != kSignificant)
+						{
+							continue;
+						}
+						if (verticalCausal_ && y == 3)
+						{
+							state &= kCausalMask;
+						}
+
+						int context = (state & kRefined) != 0 ? 16 : ((state & kNeighbours) != 0 ? 15 : 14);
+						int32_t& magnitude = magnitudes_[(stripe + y) * width_ + x];
+						// Move from the middle of the interval to the middle of its chosen half
+						int32_t step = DecodeBit(context, raw) ? half : -half;
+						magnitude += magnitude < 0 ? -step : step;
+						flags[index] |= kRefined;
+					}
+				}
+			}
+		}
+
+		void Jpeg2000BlockDecoder::CleanupPass(int plane)
+		{
+			const uint8_t* zero = zeroContexts_;
+			uint16_t* flags = flags_.data();
+			for (uint32_t stripe = 0; stripe < height_; stripe += 4)
+			{
+				uint32_t rows = std::min<uint32_t>(4, height_ - stripe);
+				for (uint32_t x = 0; x < width_; ++x)
+				{
+					size_t top = (stripe + 1) * stride_ + x + 1;
+					uint32_t y = 0;
+
+					// Run mode: a full column of four with nothing significant around it
+					if (rows == 4)
+					{
+						uint32_t last = flags[top + 3 * stride_];
+						if (verticalCausal_)
+						{
+							last &= kCausalMask;
+						}
+						if (((flags[top] | flags[top + stride_] | flags[top + 2 * stride_] | last) &
+							(kSignificant | kVisited | kNeighbours)) == 0)
+						{
+							if (!mq_.Decode(kRunContext))
+							{
+								continue;
+							}
+							y = static_cast<uint32_t>(mq_.Decode(kUniformContext)) << 1;
+							y |= static_cast<uint32_t>(mq_.Decode(kUniformContext));
+
+							uint32_t state = flags[top + y * stride_];
+							if (verticalCausal_ && y == 3)
+							{
+								state &= kCausalMask;
+							}
+							DecodeSignificant(top + y * stride_, state, magnitudes_[(stripe + y) * width_ + x], plane, false);
+							++y;
+						}
+					}
+
+					for (size_t index = top + y * stride_; y < rows; ++y, index += stride_)
+					{
+						uint32_t state = flags[index];
+						if (verticalCausal_ && y == 3)
+						{
+							state &= kCausalMask;
+						}
+						if ((state & (kSignificant | kVisited)) == 0 && mq_.Decode(zero[state & kNeighbours]))
+						{
+							DecodeSignificant(index, state, magnitudes_[(stripe + y) * width_ + x], plane, false);
+						}
+					}
+
+					for (uint32_t row = 0; row < rows; ++row)
+					{
+						flags[top + row * stride_] &= static_cast<uint16_t>(~kVisited);
+					}
+				}
+			}
+		}
+
+		bool Jpeg2000BlockDecoder::Decode(const uint8_t* data, const Jpeg2000Segment* segments, size_t segmentCount,
+			uint32_t width, uint32_t height, Jpeg2000Orientation orientation, uint32_t style,
+			uint32_t bitPlanes, int32_t* output)
+		{
+			if (bitPlanes > 30)
+			{
+				return false;
+			}
+
+			width_ = width;
+			height_ = height;
+			stride_ = width + 2;
+			zeroContexts_ = GetContextTables().zero[orientation];
+			verticalCausal_ = (style & Jpeg2000VerticalCausal) != 0;
+			flags_.assign(stride_ * (height + 2), 0);
+			magnitudes_.assign(static_cast<size_t>(width) * height, 0);
+			mq_.ResetContexts();
+
+			// Passes run cleanup, then significance, refinement, cleanup per lower bit plane
+			int plane = static_cast<int>(bitPlanes) - 1;
+			int passType = 2;
+			uint32_t pass = 0;
+			for (size_t s = 0; s < segmentCount && plane >= 0; ++s)
+			{
+				const Jpeg2000Segment& segment = segments[s];
+
+				// In bypass mode, significance and refinement passes after the
+				// first ten are stored raw
+				bool raw = (style & Jpeg2000Bypass) != 0 && pass >= 10 && passType != 2;
+				if (raw)
+				{
+					rawData_ = data + segment.offset;
+					rawLength_ = segment.length;
+					rawPosition_ = 0;
+					rawByte_ = 0;
+					rawCount_ = 0;
+				}
+				else
+				{
+					mq_.Start(data + segment.offset, segment.length);
+				}
+
+				for (uint32_t i = 0; i < segment.passes && plane >= 0; ++i, ++pass)
+				{
+					switch (passType)
+					{
+					case 0:
+						SignificancePass(plane, raw);
+						break;
+					case 1:
+						RefinementPass(plane, raw);
+						break;
+					default:
+						CleanupPass(plane);
+						if (style & Jpeg2000Segmentation)
+						{
+							for (int bit = 0; bit < 4; ++bit)
+							{
+								mq_.Decode(kUniformContext);
+							}
+						}
+						break;
+					}
+
+					if (style & Jpeg2000ResetContexts)
+					{
+						mq_.ResetContexts();
+					}
+					if (passType == 2)
+					{
+						--plane;
+						passType = 0;
+					}
+					else
+					{
+						++passType;
+					}
+				}
+			}
+
+			std::memcpy(output, magnitudes_.data(), magnitudes_.size() * sizeof(int32_t));
+			return true;
+		}
+
+	} // namespace dicom
+} // namespace medvision
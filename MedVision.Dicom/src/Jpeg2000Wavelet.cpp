@@ -0,0 +1,378 @@
+#include "medvision/dicom/Jpeg2000Wavelet.h"
+#include "medvision/dicom/CpuFeatures.h"
+#include "medvision/dicom/ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef MEDVISION_X86
+#include <emmintrin.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			// Regions smaller than this are transformed on the calling thread
+			const size_t kParallelArea = 256 * 256;
+			const uint32_t kRowsPerTask = 32;
+			const uint32_t kColumnsPerStrip = 64;
+
+			// Lifting steps over whole rows: target[i] updated from a[i] + b[i]
+
+			void Lift53Low(int32_t* target, const int32_t* a, const int32_t* b, size_t count)
+			{
+				size_t i = 0;
+#ifdef MEDVISION_X86
+				const __m128i two = _mm_set1_epi32(2);
+				for (; i + 4 <= count; i += 4)
+				{
+					__m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))), two);
+					__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_sub_epi32(value, _mm_srai_epi32(sum, 2)));
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					target[i] -= (a[i] + b[i] + 2) >> 2;
+				}
+			}
+
+			void Lift53High(int32_t* target, const int32_t* a, const int32_t* b, size_t count)
+			{
+				size_t i = 0;
+#ifdef MEDVISION_X86
+				for (; i + 4 <= count; i += 4)
+				{
+					__m128i sum = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+					__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_add_epi32(value, _mm_srai_epi32(sum, 1)));
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					target[i] += (a[i] + b[i]) >> 1;
+				}
+			}
+
+			void Lift97(float* target, const float* a, const float* b, size_t count, float factor)
+			{
+				size_t i = 0;
+#ifdef MEDVISION_X86
+				const __m128 weight = _mm_set1_ps(factor);
+				for (; i + 4 <= count; i += 4)
+				{
+					__m128 sum = _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+					_mm_storeu_ps(target + i, _mm_add_ps(_mm_loadu_ps(target + i), _mm_mul_ps(sum, weight)));
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					target[i] += (a[i] + b[i]) * factor;
+				}
+			}
+
+			void Scale97(float* samples, size_t count, float factor)
+			{
+				size_t i = 0;
+#ifdef MEDVISION_X86
+				const __m128 weight = _mm_set1_ps(factor);
+				for (; i + 4 <= count; i += 4)
+				{
+					_mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), weight));
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					samples[i] *= factor;
+				}
+			}
+
+			// Lifting schemes: even steps update the low-pass samples, odd steps the high-pass ones
+
+			struct Reversible53
+			{
+				typedef int32_t Sample;
+				static const int kSteps = 2;
+
+				static void Scale(Sample*, size_t, Sample*, size_t)
+				{
+				}
+
+				static void Step(int step, Sample* target, const Sample* a, const Sample* b, size_t count)
+				{
+					if (step == 0)
+					{
+						Lift53Low(target, a, b, count);
+					}
+					else
+					{
+						Lift53High(target, a, b, count);
+					}
+				}
+
+				// A lone sample at an odd position is a high-pass coefficient
+				static void Single(Sample* samples, size_t count)
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						samples[i] /= 2;
+					}
+				}
+			};
+
+			struct Irreversible97
+			{
+				typedef float Sample;
+				static const int kSteps = 4;
+
+				static void Scale(Sample* low, size_t lowCount, Sample* high, size_t highCount)
+				{
+					const float k = 1.230174104914001f;
+					Scale97(low, lowCount, k);
+					Scale97(high, highCount, 1.0f / k);
+				}
+
+				static void Step(int step, Sample* target, const Sample* a, const Sample* b, size_t count)
+				{
+					// -delta, -gamma, -beta, -alpha
+					static const float kFactors[4] = { -0.443506852043971f, -0.882911075530934f,
+						0.052980118572961f, 1.586134342059924f };
+					Lift97(target, a, b, count, kFactors[step]);
+				}
+
+				static void Single(Sample* samples, size_t count)
+				{
+					Scale97(samples, count, 0.5f);
+				}
+			};
+
+			// out[2j] = first[j], out[2j + 1] = second[j]
+			void Interleave(const int32_t* first, const int32_t* second, size_t pairs, int32_t* out)
+			{
+				size_t j = 0;
+#ifdef MEDVISION_X86
+				for (; j + 4 <= pairs; j += 4)
+				{
+					__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + j));
+					__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + j));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * j), _mm_unpacklo_epi32(a, b));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * j + 4), _mm_unpackhi_epi32(a, b));
+				}
+#endif
+				for (; j < pairs; ++j)
+				{
+					out[2 * j] = first[j];
+					out[2 * j + 1] = second[j];
+				}
+			}
+
+			void Interleave(const float* first, const float* second, size_t pairs, float* out)
+			{
+				size_t j = 0;
+#ifdef MEDVISION_X86
+				for (; j + 4 <= pairs; j += 4)
+				{
+					__m128 a = _mm_loadu_ps(first + j);
+					__m128 b = _mm_loadu_ps(second + j);
+					_mm_storeu_ps(out + 2 * j, _mm_unpacklo_ps(a, b));
+					_mm_storeu_ps(out + 2 * j + 4, _mm_unpackhi_ps(a, b));
+				}
+#endif
+				for (; j < pairs; ++j)
+				{
+					out[2 * j] = first[j];
+					out[2 * j + 1] = second[j];
+				}
+			}
+
+			template <typename Filter>
+			void InverseRow(typename Filter::Sample* row, uint32_t width, uint32_t lowCount, bool odd,
+				std::vector<typename Filter::Sample>& scratch)
+			{
+				typedef typename Filter::Sample Sample;
+				if (width == 1)
+				{
+					if (odd)
+					{
+						Filter::Single(row, 1);
+					}
+					return;
+				}
+
+				// Low and high halves with one mirrored sample on each side
+				size_t highCount = width - lowCount;
+				size_t shift = odd ? 1 : 0;
+				scratch.resize(width + 4);
+				Sample* low = scratch.data();
+				Sample* high = low + lowCount + 2;
+				std::memcpy(low + 1, row, lowCount * sizeof(Sample));
+				std::memcpy(high + 1, row + lowCount, highCount * sizeof(Sample));
+				Filter::Scale(low + 1, lowCount, high + 1, highCount);
+
+				for (int step = 0; step < Filter::kSteps; ++step)
+				{
+					if (step % 2 == 0)
+					{
+						high[0] = high[1];
+						high[highCount + 1] = high[highCount];
+						Filter::Step(step, low + 1, high + shift, high + shift + 1, lowCount);
+					}
+					else
+					{
+						low[0] = low[1];
+						low[lowCount + 1] = low[lowCount];
+						Filter::Step(step, high + 1, low + 1 - shift, low + 2 - shift, highCount);
+					}
+				}
+
+				// A row starting at an odd position starts with a high-pass sample
+				const Sample* first = odd ? high + 1 : low + 1;
+				const Sample* second = odd ? low + 1 : high + 1;
+				size_t firstCount = odd ? highCount : lowCount;
+				size_t pairs = std::min<size_t>(lowCount, highCount);
+				Interleave(first, second, pairs, row);
+				if (firstCount > pairs)
+				{
+					row[2 * pairs] = first[pairs];
+				}
+			}
+
+			template <typename Filter>
+			void InverseColumns(typename Filter::Sample* data, size_t stride, uint32_t height, uint32_t lowCount, bool odd,
+				uint32_t column, uint32_t count, std::vector<typename Filter::Sample>& scratch)
+			{
+				typedef typename Filter::Sample Sample;
+				Sample* origin = data + column;
+				if (height == 1)
+				{
+					if (odd)
+					{
+						Filter::Single(origin, count);
+					}
+					return;
+				}
+
+				// Rows past either end mirror onto the first or last row of that half
+				int highCount = static_cast<int>(height - lowCount);
+				int lows = static_cast<int>(lowCount);
+				int shift = odd ? 1 : 0;
+				auto lowRow = [&](int j) { return origin + std::max(0, std::min(lows - 1, j)) * stride; };
+				auto highRow = [&](int j) { return origin + (lowCount + std::max(0, std::min(highCount - 1, j))) * stride; };
+
+				for (int j = 0; j < lows; ++j)
+				{
+					Filter::Scale(lowRow(j), count, nullptr, 0);
+				}
+				for (int j = 0; j < highCount; ++j)
+				{
+					Filter::Scale(nullptr, 0, highRow(j), count);
+				}
+
+				for (int step = 0; step < Filter::kSteps; ++step)
+				{
+					if (step % 2 == 0)
+					{
+						for (int j = 0; j < lows; ++j)
+						{
+							Filter::Step(step, lowRow(j), highRow(j - 1 + shift), highRow(j + shift), count);
+						}
+					}
+					else
+					{
+						for (int j = 0; j < highCount; ++j)
+						{
+							Filter::Step(step, highRow(j), lowRow(j - shift), lowRow(j + 1 - shift), count);
+						}
+					}
+				}
+
+				// Reorder the strip's rows from low/high halves to natural order
+				scratch.resize(static_cast<size_t>(count) * height);
+				for (uint32_t i = 0; i < height; ++i)
+				{
+					bool isLow = ((i + shift) & 1) == 0;
+					const Sample* source = isLow ? lowRow((static_cast<int>(i) - shift) / 2) : highRow((static_cast<int>(i) + shift - 1) / 2);
+					std::memcpy(scratch.data() + i * count, source, count * sizeof(Sample));
+				}
+				for (uint32_t i = 0; i < height; ++i)
+				{
+					std::memcpy(origin + i * stride, scratch.data() + i * count, count * sizeof(Sample));
+				}
+			}
+
+			template <typename Filter>
+			void Inverse(typename Filter::Sample* data, size_t stride, uint32_t width, uint32_t height,
+				uint32_t lowWidth, uint32_t lowHeight, bool xOdd, bool yOdd)
+			{
+				typedef typename Filter::Sample Sample;
+				if (width == 0 || height == 0)
+				{
+					return;
+				}
+				bool parallel = static_cast<size_t>(width) * height >= kParallelArea;
+
+				auto rows = [&](size_t task)
+				{
+					static thread_local std::vector<Sample> scratch;
+					uint32_t first = static_cast<uint32_t>(task) * kRowsPerTask;
+					uint32_t last = std::min(height, first + kRowsPerTask);
+					for (uint32_t y = first; y < last; ++y)
+					{
+						InverseRow<Filter>(data + y * stride, width, lowWidth, xOdd, scratch);
+					}
+				};
+				size_t rowTasks = (height + kRowsPerTask - 1) / kRowsPerTask;
+				if (parallel)
+				{
+					ThreadPool::Shared().ParallelFor(rowTasks, rows);
+				}
+				else
+				{
+					for (size_t task = 0; task < rowTasks; ++task)
+					{
+						rows(task);
+					}
+				}
+
+				auto columns = [&](size_t strip)
+				{
+					static thread_local std::vector<Sample> scratch;
+					uint32_t first = static_cast<uint32_t>(strip) * kColumnsPerStrip;
+					uint32_t count = std::min(kColumnsPerStrip, width - first);
+					InverseColumns<Filter>(data, stride, height, lowHeight, yOdd, first, count, scratch);
+				};
+				size_t strips = (width + kColumnsPerStrip - 1) / kColumnsPerStrip;
+				if (parallel)
+				{
+					ThreadPool::Shared().ParallelFor(strips, columns);
+				}
+				else
+				{
+					for (size_t strip = 0; strip < strips; ++strip)
+					{
+						columns(strip);
+					}
+				}
+			}
+		}
+
+		void Jpeg2000Wavelet::Inverse53(int32_t* data, size_t stride, uint32_t width, uint32_t height,
+			uint32_t lowWidth, uint32_t lowHeight, bool xOdd, bool yOdd)
+		{
+			Inverse<Reversible53>(data, stride, width, height, lowWidth, lowHeight, xOdd, yOdd);
+		}
+
+		void Jpeg2000Wavelet::Inverse97(float* data, size_t stride, uint32_t width, uint32_t height,
+			uint32_t lowWidth, uint32_t lowHeight, bool xOdd, bool yOdd)
+		{
+			Inverse<Irreversible97>(data, stride, width, height, lowWidth, lowHeight, xOdd, yOdd);
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,967 @@
+#include "medvision/dicom/JpegBaselineCodec.h"
+#include "medvision/dicom/CpuFeatures.h"
+#include "medvision/dicom/JpegHuffman.h"
+#include "medvision/dicom/SampleInterleave.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifdef MEDVISION_X86
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const uint8_t kSOF0 = 0xC0;
+			const uint8_t kSOF1 = 0xC1;
+			const uint8_t kDHT = 0xC4;
+			const uint8_t kSOI = 0xD8;
+			const uint8_t kEOI = 0xD9;
+			const uint8_t kSOS = 0xDA;
+			const uint8_t kDQT = 0xDB;
+			const uint8_t kDRI = 0xDD;
+			const uint8_t kAPP0 = 0xE0;
+			const uint8_t kAPP14 = 0xEE;
+
+			// Natural (row-major) index of each zigzag position
+			const int kZigzag[64] = {
+				0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+				12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+				35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+				58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+			struct QuantTable
+			{
+				uint16_t values[64];   // Natural order
+				float scaled[64];      // values * AAN row/column factors / 8, for the float IDCT
+				bool valid;
+			};
+
+			struct Component
+			{
+				uint8_t id;
+				int h;
+				int v;
+				int quantTable;
+				size_t blocksX;        // Whole MCUs, including the padding past the image edge
+				size_t blocksY;
+				int blockSize;         // Output samples per block side
+				int upsampleH;         // Remaining replication up to the output size
+				int upsampleV;
+				size_t stride;         // Plane row length in samples
+				uint8_t* plane;
+				int32_t dcPrediction;
+				const JpegHuffmanTable* dcTable;
+				const JpegHuffmanTable* acTable;
+				bool decoded;
+			};
+
+			uint16_t ReadUInt16BE(const uint8_t* data)
+			{
+				return static_cast<uint16_t>((data[0] << 8) | data[1]);
+			}
+
+			uint8_t ClampToByte(float value)
+			{
+				float rounded = std::floor(value + 128.5f);
+				return static_cast<uint8_t>(rounded < 0.0f ? 0.0f : (rounded > 255.0f ? 255.0f : rounded));
+			}
+
+			void ScaleQuantTable(QuantTable& table)
+			{
+				// AAN factors: 1 for k = 0, cos(k * pi / 16) * sqrt(2) otherwise
+				static const double kAan[8] = { 1.0, 1.387039845, 1.306562965, 1.175875602,
+					1.0, 0.785694958, 0.541196100, 0.275899379 };
+				for (int row = 0; row < 8; ++row)
+				{
+					for (int column = 0; column < 8; ++column)
+					{
+						table.scaled[row * 8 + column] =
+							static_cast<float>(table.values[row * 8 + column] * kAan[row] * kAan[column] / 8.0);
+					}
+				}
+			}
+
+			// One AAN inverse DCT pass over 8 values (scalar floats or SIMD vectors)
+			template <typename T>
+			void Idct1D(T* v)
+			{
+				// Even part
+				T tmp10 = v[0] + v[4];
+				T tmp11 = v[0] - v[4];
+				T tmp13 = v[2] + v[6];
+				T tmp12 = (v[2] - v[6]) * 1.414213562f - tmp13;
+
+				T tmp0 = tmp10 + tmp13;
+				T tmp3 = tmp10 - tmp13;
+				T tmp1 = tmp11 + tmp12;
+				T tmp2 = tmp11 - tmp12;
+
+				// Odd part
+				T z13 = v[5] + v[3];
+				T z10 = v[5] - v[3];
+				T z11 = v[1] + v[7];
+				T z12 = v[1] - v[7];
+
+				T tmp7 = z11 + z13;
+				T tmp11o = (z11 - z13) * 1.414213562f;
+				T z5 = (z10 + z12) * 1.847759065f;
+				T tmp10o = z12 * 1.082392200f - z5;
+				T tmp12o = z10 * -2.613125930f + z5;
+
+				T tmp6 = tmp12o - tmp7;
+				T tmp5 = tmp11o - tmp6;
+				T tmp4 = tmp10o + tmp5;
+
+				v[0] = tmp0 + tmp7;
+				v[7] = tmp0 - tmp7;
+				v[1] = tmp1 + tmp6;
+				v[6] = tmp1 - tmp6;
+				v[2] = tmp2 + tmp5;
+				v[5] = tmp2 - tmp5;
+				v[4] = tmp3 + tmp4;
+				v[3] = tmp3 - tmp4;
+			}
+
+#ifdef MEDVISION_X86
+			struct Vec4
+			{
+				__m128 v;
+			};
+
+			inline Vec4 operator+(Vec4 a, Vec4 b) { Vec4 r = { _mm_add_ps(a.v, b.v) }; return r; }
+			inline Vec4 operator-(Vec4 a, Vec4 b) { Vec4 r = { _mm_sub_ps(a.v, b.v) }; return r; }
+			inline Vec4 operator*(Vec4 a, float k) { Vec4 r = { _mm_mul_ps(a.v, _mm_set1_ps(k)) }; return r; }
+
+			// Four columns (or rows) at a time; two transposes turn the column pass into the row pass
+			void IdctBlock(const int16_t* coefficients, const float* scaled, uint8_t* output, size_t stride)
+			{
+				Vec4 c[8][2];
+				for (int i = 0; i < 8; ++i)
+				{
+					__m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + i * 8));
+					__m128i sign = _mm_srai_epi16(row, 15);
+					c[i][0].v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(row, sign)), _mm_loadu_ps(scaled + i * 8));
+					c[i][1].v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(row, sign)), _mm_loadu_ps(scaled + i * 8 + 4));
+				}
+
+				Vec4 t[8][2];
+				for (int h = 0; h < 2; ++h)
+				{
+					Vec4 column[8];
+					for (int i = 0; i < 8; ++i)
+					{
+						column[i] = c[i][h];
+					}
+					Idct1D(column);
+
+					for (int g = 0; g < 2; ++g)
+					{
+						__m128 r0 = column[g * 4].v, r1 = column[g * 4 + 1].v, r2 = column[g * 4 + 2].v, r3 = column[g * 4 + 3].v;
+						_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+						t[h * 4][g].v = r0;
+						t[h * 4 + 1][g].v = r1;
+						t[h * 4 + 2][g].v = r2;
+						t[h * 4 + 3][g].v = r3;
+					}
+				}
+
+				for (int g = 0; g < 2; ++g)
+				{
+					Vec4 row[8];
+					for (int j = 0; j < 8; ++j)
+					{
+						row[j] = t[j][g];
+					}
+					Idct1D(row);
+
+					// row[j] holds column j of output rows 4g..4g+3
+					const __m128 bias = _mm_set1_ps(128.0f);
+					for (int h = 0; h < 2; ++h)
+					{
+						__m128 r0 = row[h * 4].v, r1 = row[h * 4 + 1].v, r2 = row[h * 4 + 2].v, r3 = row[h * 4 + 3].v;
+						_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+						c[g * 4][h].v = _mm_add_ps(r0, bias);
+						c[g * 4 + 1][h].v = _mm_add_ps(r1, bias);
+						c[g * 4 + 2][h].v = _mm_add_ps(r2, bias);
+						c[g * 4 + 3][h].v = _mm_add_ps(r3, bias);
+					}
+				}
+
+				for (int i = 0; i < 8; ++i)
+				{
+					__m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(c[i][0].v), _mm_cvtps_epi32(c[i][1].v));
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(output + i * stride), _mm_packus_epi16(packed, packed));
+				}
+			}
+#else
+			void IdctBlock(const int16_t* coefficients, const float* scaled, uint8_t* output, size_t stride)
+			{
+				float block[64];
+				for (int i = 0; i < 64; ++i)
+				{
+					block[i] = coefficients[i] * scaled[i];
+				}
+
+				float line[8];
+				for (int column = 0; column < 8; ++column)
+				{
+					for (int i = 0; i < 8; ++i)
+					{
+						line[i] = block[i * 8 + column];
+					}
+					Idct1D(line);
+					for (int i = 0; i < 8; ++i)
+					{
+						block[i * 8 + column] = line[i];
+					}
+				}
+				for (int row = 0; row < 8; ++row)
+				{
+					Idct1D(block + row * 8);
+					for (int i = 0; i < 8; ++i)
+					{
+						output[row * stride + i] = ClampToByte(block[row * 8 + i]);
+					}
+				}
+			}
+#endif
+
+			// N-point reduced inverse DCT (N = 2 or 4): each output is the mean of the
+			// 8/N x 8/N full-size samples it covers, so every frequency contributes
+			struct ReducedBasis
+			{
+				float four[4][8];
+				float two[2][8];
+
+				ReducedBasis()
+				{
+					Fill(&four[0][0], 4);
+					Fill(&two[0][0], 2);
+				}
+
+				static void Fill(float* basis, int size)
+				{
+					const double pi = 3.14159265358979323846;
+					int span = 8 / size;
+					for (int x = 0; x < size; ++x)
+					{
+						for (int u = 0; u < 8; ++u)
+						{
+							double sum = 0.0;
+							for (int k = x * span; k < (x + 1) * span; ++k)
+							{
+								sum += std::cos((2 * k + 1) * u * pi / 16.0);
+							}
+							double scale = (u == 0 ? std::sqrt(0.5) : 1.0) / 2.0;
+							basis[x * 8 + u] = static_cast<float>(scale * sum / span);
+						}
+					}
+				}
+			};
+
+			template <int N>
+			void IdctReduced(const int16_t* coefficients, const uint16_t* quant, const float (&basis)[N][8], uint8_t* output, size_t stride)
+			{
+				float rows[8][N];   // Horizontal pass: rows[v][x]
+				for (int v = 0; v < 8; ++v)
+				{
+					float frequencies[8];
+					bool zero = true;
+					for (int u = 0; u < 8; ++u)
+					{
+						frequencies[u] = static_cast<float>(coefficients[v * 8 + u] * quant[v * 8 + u]);
+						zero = zero && coefficients[v * 8 + u] == 0;
+					}
+					for (int x = 0; x < N; ++x)
+					{
+						float sum = 0.0f;
+						for (int u = 0; !zero && u < 8; ++u)
+						{
+							sum += basis[x][u] * frequencies[u];
+						}
+						rows[v][x] = sum;
+					}
+				}
+
+				for (int y = 0; y < N; ++y)
+				{
+					for (int x = 0; x < N; ++x)
+					{
+						float sum = 0.0f;
+						for (int v = 0; v < 8; ++v)
+						{
+							sum += basis[y][v] * rows[v][x];
+						}
+						output[y * stride + x] = ClampToByte(sum);
+					}
+				}
+			}
+
+			void StoreBlock(const int16_t* coefficients, int lastCoefficient, const QuantTable& quant, int blockSize,
+				uint8_t* output, size_t stride)
+			{
+				if (lastCoefficient == 0 || blockSize == 1)
+				{
+					uint8_t value = ClampToByte(coefficients[0] * quant.scaled[0]);
+					for (int y = 0; y < blockSize; ++y)
+					{
+						std::memset(output + y * stride, value, blockSize);
+					}
+					return;
+				}
+
+				static const ReducedBasis basis;
+				switch (blockSize)
+				{
+				case 8: IdctBlock(coefficients, quant.scaled, output, stride); break;
+				case 4: IdctReduced<4>(coefficients, quant.values, basis.four, output, stride); break;
+				default: IdctReduced<2>(coefficients, quant.values, basis.two, output, stride); break;
+				}
+			}
+
+			bool DecodeBlock(JpegBitReader& reader, Component& component, int16_t* coefficients, int& lastCoefficient)
+			{
+				std::memset(coefficients, 0, 64 * sizeof(int16_t));
+
+				int32_t difference;
+				if (!reader.DecodeDifference(*component.dcTable, difference))
+				{
+					return false;
+				}
+				component.dcPrediction += difference;
+				coefficients[0] = static_cast<int16_t>(component.dcPrediction);
+
+				lastCoefficient = 0;
+				for (int k = 1; k < 64;)
+				{
+					int symbol = reader.DecodeSymbol(*component.acTable);
+					if (symbol < 0)
+					{
+						return false;
+					}
+
+					int run = symbol >> 4;
+					int size = symbol & 0x0F;
+					if (size == 0)
+					{
+						if (run != 15)
+						{
+							break;   // End of block
+						}
+						k += 16;
+						continue;
+					}
+
+					k += run;
+					if (k > 63)
+					{
+						return false;
+					}
+					coefficients[kZigzag[k]] = static_cast<int16_t>(JpegBitReader::Extend(reader.GetBits(size), size));
+					lastCoefficient = k++;
+				}
+				return true;
+			}
+
+			// Full-range YCbCr to RGB in 14-bit fixed point (identical in the SIMD and scalar paths)
+			const int kCrToR = 22970;    // 1.402
+			const int kCbToG = -5638;    // -0.344136
+			const int kCrToG = -11700;   // -0.714136
+			const int kCbToB = 29032;    // 1.772
+
+			uint8_t Saturate(int value)
+			{
+				return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+			}
+
+			void YCbCrToRgbRow(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+				uint8_t* red, uint8_t* green, uint8_t* blue, size_t count)
+			{
+				size_t i = 0;
+#ifdef MEDVISION_X86
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i center = _mm_set1_epi16(128);
+				const __m128i round = _mm_set1_epi32(1 << 13);
+				const __m128i toRed = _mm_setr_epi16(0, kCrToR, 0, kCrToR, 0, kCrToR, 0, kCrToR);
+				const __m128i toGreen = _mm_setr_epi16(kCbToG, kCrToG, kCbToG, kCrToG, kCbToG, kCrToG, kCbToG, kCrToG);
+				const __m128i toBlue = _mm_setr_epi16(kCbToB, 0, kCbToB, 0, kCbToB, 0, kCbToB, 0);
+				for (; i + 8 <= count; i += 8)
+				{
+					__m128i luma = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i)), zero);
+					__m128i blueDiff = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cb + i)), zero), center);
+					__m128i redDiff = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cr + i)), zero), center);
+					__m128i pairsLow = _mm_unpacklo_epi16(blueDiff, redDiff);
+					__m128i pairsHigh = _mm_unpackhi_epi16(blueDiff, redDiff);
+
+					__m128i channels[3];
+					const __m128i* weights[3] = { &toRed, &toGreen, &toBlue };
+					for (int channel = 0; channel < 3; ++channel)
+					{
+						__m128i low = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(pairsLow, *weights[channel]), round), 14);
+						__m128i high = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(pairsHigh, *weights[channel]), round), 14);
+						__m128i value = _mm_add_epi16(luma, _mm_packs_epi32(low, high));
+						channels[channel] = _mm_packus_epi16(value, value);
+					}
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(red + i), channels[0]);
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(green + i), channels[1]);
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(blue + i), channels[2]);
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					int blueDiff = cb[i] - 128;
+					int redDiff = cr[i] - 128;
+					red[i] = Saturate(y[i] + ((kCrToR * redDiff + (1 << 13)) >> 14));
+					green[i] = Saturate(y[i] + ((kCbToG * blueDiff + kCrToG * redDiff + (1 << 13)) >> 14));
+					blue[i] = Saturate(y[i] + ((kCbToB * blueDiff + (1 << 13)) >> 14));
+				}
+			}
+
+			// Horizontal box upsampling by an integer factor (2 is vectorized)
+			void UpsampleRow(const uint8_t* source, int factor, uint8_t* output, size_t count)
+			{
+				size_t i = 0;
+#ifdef MEDVISION_X86
+				if (factor == 2)
+				{
+					for (; i + 32 <= count; i += 32)
+					{
+						__m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i / 2));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_unpacklo_epi8(samples, samples));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 16), _mm_unpackhi_epi8(samples, samples));
+					}
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					output[i] = source[i / factor];
+				}
+			}
+
+			// Position of the next marker code byte at or after position (entropy data is skipped)
+			bool FindMarker(const uint8_t* data, size_t length, size_t& position)
+			{
+				while (position + 1 < length)
+				{
+					if (data[position] == 0xFF && data[position + 1] != 0x00 && data[position + 1] != 0xFF &&
+						!(data[position + 1] >= 0xD0 && data[position + 1] <= 0xD7))
+					{
+						++position;
+						return true;
+					}
+					++position;
+				}
+				return false;
+			}
+
+			class BaselineFrameDecoder
+			{
+			public:
+				BaselineFrameDecoder(const FrameInfo& info, uint32_t reduction)
+					: info_(info)
+					, reduction_(reduction)
+					, blockSize_(8 >> reduction)
+					, rows_(0)
+					, columns_(0)
+					, maxH_(1)
+					, maxV_(1)
+					, mcusX_(0)
+					, mcusY_(0)
+					, restartInterval_(0)
+					, jfif_(false)
+					, adobeTransform_(-1)
+				{
+					for (QuantTable& table : quant_)
+					{
+						table.valid = false;
+					}
+				}
+
+				bool Decode(const uint8_t* data, size_t length, uint8_t* output, std::string& error)
+				{
+					if (length < 4 || data[0] != 0xFF || data[1] != kSOI)
+					{
+						error = "Missing JPEG SOI marker";
+						return false;
+					}
+
+					size_t position = 2;
+					while (FindMarker(data, length, position))
+					{
+						uint8_t marker = data[position++];
+						if (marker == kEOI)
+						{
+							break;
+						}
+						if (marker == kSOI || position + 2 > length)
+						{
+							error = "Malformed JPEG marker sequence";
+							return false;
+						}
+
+						size_t segmentLength = ReadUInt16BE(data + position);
+						if (segmentLength < 2 || position + segmentLength > length)
+						{
+							error = "JPEG marker segment is truncated";
+							return false;
+						}
+						const uint8_t* segment = data + position + 2;
+						size_t bodyLength = segmentLength - 2;
+						position += segmentLength;
+
+						bool success = true;
+						if (marker == kSOF0 || marker == kSOF1)
+						{
+							success = ReadFrameHeader(segment, bodyLength, error);
+						}
+						else if (marker >= 0xC2 && marker <= 0xCF && marker != kDHT && marker != 0xC8 && marker != 0xCC)
+						{
+							error = "Not a sequential 8-bit JPEG frame";
+							success = false;
+						}
+						else if (marker == kDHT)
+						{
+							success = ReadHuffmanTables(segment, bodyLength, error);
+						}
+						else if (marker == kDQT)
+						{
+							success = ReadQuantTables(segment, bodyLength, error);
+						}
+						else if (marker == kDRI)
+						{
+							if (bodyLength != 2)
+							{
+								error = "Malformed JPEG DRI segment";
+								return false;
+							}
+							restartInterval_ = ReadUInt16BE(segment);
+						}
+						else if (marker == kAPP0)
+						{
+							jfif_ = jfif_ || (bodyLength >= 5 && std::memcmp(segment, "JFIF\0", 5) == 0);
+						}
+						else if (marker == kAPP14)
+						{
+							if (bodyLength >= 12 && std::memcmp(segment, "Adobe", 5) == 0)
+							{
+								adobeTransform_ = segment[11];
+							}
+						}
+						else if (marker == kSOS)
+						{
+							success = DecodeScan(data, length, segment, bodyLength, position, error);
+						}
+
+						if (!success)
+						{
+							return false;
+						}
+					}
+
+					if (components_.empty())
+					{
+						error = "JPEG data has no frame header";
+						return false;
+					}
+					for (const Component& component : components_)
+					{
+						if (!component.decoded)
+						{
+							error = "JPEG data does not cover every component";
+							return false;
+						}
+					}
+
+					WriteOutput(output);
+					return true;
+				}
+
+			private:
+				bool ReadFrameHeader(const uint8_t* segment, size_t length, std::string& error)
+				{
+					if (length < 6 || length != 6 + 3u * segment[5] || !components_.empty())
+					{
+						error = "Malformed JPEG frame header";
+						return false;
+					}
+					if (segment[0] != 8)
+					{
+						error = "Only 8-bit JPEG is supported";
+						return false;
+					}
+
+					rows_ = ReadUInt16BE(segment + 1);
+					columns_ = ReadUInt16BE(segment + 3);
+					size_t componentCount = segment[5];
+					if (rows_ != info_.rows || columns_ != info_.columns || componentCount != info_.samplesPerPixel ||
+						(componentCount != 1 && componentCount != 3))
+					{
+						error = "JPEG dimensions do not match the image";
+						return false;
+					}
+
+					components_.resize(componentCount);
+					for (size_t i = 0; i < componentCount; ++i)
+					{
+						Component& component = components_[i];
+						component.id = segment[6 + i * 3];
+						component.h = segment[7 + i * 3] >> 4;
+						component.v = segment[7 + i * 3] & 0x0F;
+						component.quantTable = segment[8 + i * 3];
+						component.dcPrediction = 0;
+						component.decoded = false;
+						if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4 || component.quantTable > 3)
+						{
+							error = "Invalid JPEG component parameters";
+							return false;
+						}
+						maxH_ = std::max(maxH_, component.h);
+						maxV_ = std::max(maxV_, component.v);
+					}
+
+					mcusX_ = (columns_ + 8 * maxH_ - 1) / (8 * maxH_);
+					mcusY_ = (rows_ + 8 * maxV_ - 1) / (8 * maxV_);
+
+					// Planes cover whole MCUs at the output block size, plus room for vector over-reads
+					size_t total = 0;
+					for (Component& component : components_)
+					{
+						if (maxH_ % component.h != 0 || maxV_ % component.v != 0)
+						{
+							error = "Unsupported JPEG sampling factors";
+							return false;
+						}
+						component.blocksX = mcusX_ * component.h;
+						component.blocksY = mcusY_ * component.v;
+
+						// Subsampled components decode reduced frames at a larger block size
+						// where possible, as libjpeg does, instead of being replicated
+						int ratioH = maxH_ / component.h;
+						int ratioV = maxV_ / component.v;
+						int scale = 1;
+						while (blockSize_ * scale * 2 <= 8 && ratioH % (scale * 2) == 0 && ratioV % (scale * 2) == 0)
+						{
+							scale *= 2;
+						}
+						component.blockSize = blockSize_ * scale;
+						component.upsampleH = ratioH / scale;
+						component.upsampleV = ratioV / scale;
+						component.stride = component.blocksX * component.blockSize;
+						total += component.stride * component.blocksY * component.blockSize;
+					}
+					// Reused across frames decoded on the same thread
+					static thread_local std::vector<uint8_t> planes;
+					planes.resize(total + 64);
+					total = 0;
+					for (Component& component : components_)
+					{
+						component.plane = planes.data() + total;
+						total += component.stride * component.blocksY * component.blockSize;
+					}
+					return true;
+				}
+
+				bool ReadHuffmanTables(const uint8_t* segment, size_t length, std::string& error)
+				{
+					const uint8_t* table = segment;
+					const uint8_t* end = segment + length;
+					while (table + 17 <= end)
+					{
+						size_t symbolCount = 0;
+						for (int i = 0; i < 16; ++i)
+						{
+							symbolCount += table[1 + i];
+						}
+
+						int tableClass = table[0] >> 4;
+						int index = table[0] & 0x0F;
+						if (tableClass > 1 || index > 3 || table + 17 + symbolCount > end ||
+							!(tableClass == 0 ? dcTables_ : acTables_)[index].Build(table + 1, table + 17, symbolCount))
+						{
+							error = "Malformed JPEG Huffman table";
+							return false;
+						}
+						table += 17 + symbolCount;
+					}
+					return true;
+				}
+
+				bool ReadQuantTables(const uint8_t* segment, size_t length, std::string& error)
+				{
+					size_t position = 0;
+					while (position < length)
+					{
+						int precision = segment[position] >> 4;
+						int index = segment[position] & 0x0F;
+						size_t tableLength = 1 + 64 * (precision + 1);
+						if (precision > 1 || index > 3 || position + tableLength > length)
+						{
+							error = "Malformed JPEG quantization table";
+							return false;
+						}
+
+						QuantTable& table = quant_[index];
+						const uint8_t* values = segment + position + 1;
+						for (int k = 0; k < 64; ++k)
+						{
+							table.values[kZigzag[k]] = precision == 0 ? values[k] : ReadUInt16BE(values + k * 2);
+						}
+						ScaleQuantTable(table);
+						table.valid = true;
+						position += tableLength;
+					}
+					return true;
+				}
+
+				bool DecodeScan(const uint8_t* data, size_t length, const uint8_t* segment, size_t segmentLength,
+					size_t& position, std::string& error)
+				{
+					if (components_.empty())
+					{
+						error = "JPEG scan before the frame header";
+						return false;
+					}
+
+					size_t count = segmentLength > 0 ? segment[0] : 0;
+					if (count == 0 || count > components_.size() || segmentLength != 4 + 2 * count)
+					{
+						error = "Malformed JPEG SOS segment";
+						return false;
+					}
+
+					std::vector<Component*> scan;
+					for (size_t k = 0; k < count; ++k)
+					{
+						uint8_t id = segment[1 + k * 2];
+						int dcIndex = segment[2 + k * 2] >> 4;
+						int acIndex = segment[2 + k * 2] & 0x0F;
+						Component* component = nullptr;
+						for (Component& candidate : components_)
+						{
+							if (candidate.id == id)
+							{
+								component = &candidate;
+							}
+						}
+						if (component == nullptr || dcIndex > 3 || acIndex > 3 ||
+							!dcTables_[dcIndex].IsValid() || !acTables_[acIndex].IsValid() || !quant_[component->quantTable].valid)
+						{
+							error = "JPEG scan references an unknown component or table";
+							return false;
+						}
+						component->dcTable = &dcTables_[dcIndex];
+						component->acTable = &acTables_[acIndex];
+						component->dcPrediction = 0;
+						component->decoded = true;
+						scan.push_back(component);
+					}
+
+					const uint8_t* parameters = segment + 1 + count * 2;
+					if (parameters[0] != 0 || parameters[1] != 63 || parameters[2] != 0)
+					{
+						error = "Progressive JPEG scans are not supported";
+						return false;
+					}
+
+					// A single-component scan walks that component's blocks; otherwise whole MCUs
+					size_t unitsX = mcusX_;
+					size_t unitsY = mcusY_;
+					if (count == 1)
+					{
+						unitsX = (static_cast<size_t>(columns_) * scan[0]->h / maxH_ + 7) / 8;
+						unitsY = (static_cast<size_t>(rows_) * scan[0]->v / maxV_ + 7) / 8;
+					}
+
+					JpegBitReader reader(data, length, position);
+					int16_t coefficients[64];
+					int lastCoefficient = 0;
+					uint32_t unitsToRestart = restartInterval_;
+					for (size_t unitY = 0; unitY < unitsY; ++unitY)
+					{
+						for (size_t unitX = 0; unitX < unitsX; ++unitX)
+						{
+							if (restartInterval_ != 0)
+							{
+								if (unitsToRestart == 0)
+								{
+									if (!reader.Restart())
+									{
+										error = "Missing JPEG restart marker";
+										return false;
+									}
+									for (Component* component : scan)
+									{
+										component->dcPrediction = 0;
+									}
+									unitsToRestart = restartInterval_;
+								}
+								--unitsToRestart;
+							}
+
+							for (Component* component : scan)
+							{
+								int blocksH = count == 1 ? 1 : component->h;
+								int blocksV = count == 1 ? 1 : component->v;
+								for (int v = 0; v < blocksV; ++v)
+								{
+									for (int h = 0; h < blocksH; ++h)
+									{
+										if (!DecodeBlock(reader, *component, coefficients, lastCoefficient))
+										{
+											error = "Invalid JPEG Huffman code";
+											return false;
+										}
+
+										size_t blockX = unitX * blocksH + h;
+										size_t blockY = unitY * blocksV + v;
+										uint8_t* destination = component->plane +
+											blockY * component->blockSize * component->stride + blockX * component->blockSize;
+										StoreBlock(coefficients, lastCoefficient, quant_[component->quantTable], component->blockSize,
+											destination, component->stride);
+									}
+								}
+							}
+						}
+
+						if (reader.IsOverrun())
+						{
+							error = "JPEG data is truncated";
+							return false;
+						}
+					}
+
+					position = reader.GetPosition();
+					return true;
+				}
+
+				bool IsYCbCr() const
+				{
+					// Same inference as the IJG library
+					if (components_.size() != 3)
+					{
+						return false;
+					}
+					if (jfif_)
+					{
+						return true;
+					}
+					if (adobeTransform_ >= 0)
+					{
+						return adobeTransform_ != 0;
+					}
+					return !(components_[0].id == 'R' && components_[1].id == 'G' && components_[2].id == 'B');
+				}
+
+				void WriteOutput(uint8_t* output)
+				{
+					FrameInfo reduced = info_.Reduce(reduction_);
+					size_t rows = reduced.rows;
+					size_t columns = reduced.columns;
+
+					if (components_.size() == 1)
+					{
+						for (size_t y = 0; y < rows; ++y)
+						{
+							std::memcpy(output + y * columns, components_[0].plane + y * components_[0].stride, columns);
+						}
+						return;
+					}
+
+					// Box upsampling fused into the per-row color conversion
+					static thread_local std::vector<uint8_t> scratch;
+					size_t rowLength = columns + 32;
+					scratch.resize(rowLength * 6);
+					uint8_t* upsampled[3] = { scratch.data(), scratch.data() + rowLength, scratch.data() + rowLength * 2 };
+					uint8_t* rgb[3] = { scratch.data() + rowLength * 3, scratch.data() + rowLength * 4, scratch.data() + rowLength * 5 };
+					bool convert = IsYCbCr();
+
+					for (size_t y = 0; y < rows; ++y)
+					{
+						const uint8_t* samples[3];
+						for (int c = 0; c < 3; ++c)
+						{
+							const Component& component = components_[c];
+							const uint8_t* source = component.plane + (y / component.upsampleV) * component.stride;
+							if (component.upsampleH == 1)
+							{
+								samples[c] = source;
+							}
+							else
+							{
+								UpsampleRow(source, component.upsampleH, upsampled[c], columns);
+								samples[c] = upsampled[c];
+							}
+						}
+
+						uint8_t* destination = output + y * columns * 3;
+						if (convert)
+						{
+							YCbCrToRgbRow(samples[0], samples[1], samples[2], rgb[0], rgb[1], rgb[2], columns);
+							SampleInterleave::InterleaveRgb(rgb[0], rgb[1], rgb[2], destination, columns);
+						}
+						else
+						{
+							SampleInterleave::InterleaveRgb(samples[0], samples[1], samples[2], destination, columns);
+						}
+					}
+				}
+
+			private:
+				const FrameInfo& info_;
+				uint32_t reduction_;
+				int blockSize_;
+				uint16_t rows_;
+				uint16_t columns_;
+				int maxH_;
+				int maxV_;
+				size_t mcusX_;
+				size_t mcusY_;
+				uint32_t restartInterval_;
+				bool jfif_;
+				int adobeTransform_;
+				QuantTable quant_[4];
+				JpegHuffmanTable dcTables_[4];
+				JpegHuffmanTable acTables_[4];
+				std::vector<Component> components_;
+			};
+		}
+
+		bool JpegBaselineDecoder::DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+			uint8_t* output, std::string& error) const
+		{
+			return DecodeFrameReduced(data, length, info, 0, output, error);
+		}
+
+		bool JpegBaselineDecoder::DecodeFrameReduced(const uint8_t* data, size_t length, const FrameInfo& info,
+			uint32_t reduction, uint8_t* output, std::string& error) const
+		{
+			if (info.bitsAllocated != 8)
+			{
+				error = "JPEG Baseline output must be 8 bits allocated";
+				return false;
+			}
+			if (reduction > 3)
+			{
+				error = "JPEG Baseline can reduce by at most 1/8";
+				return false;
+			}
+
+			BaselineFrameDecoder decoder(info, reduction);
+			return decoder.Decode(data, length, output, error);
+		}
+
+		std::string JpegBaselineDecoder::GetDecodedPhotometricInterpretation(const FrameInfo& info) const
+		{
+			return info.samplesPerPixel == 3 ? "RGB" : info.photometricInterpretation;
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,91 @@
+#include "medvision/dicom/JpegHuffman.h"
+#include <cstring>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		JpegHuffmanTable::JpegHuffmanTable()
+			: valid_(false)
+		{
+			std::memset(lookup_, 0, sizeof(lookup_));
+			std::memset(diffLength_, 0, sizeof(diffLength_));
+			std::memset(diff_, 0, sizeof(diff_));
+			std::memset(symbols_, 0, sizeof(symbols_));
+			for (int length = 0; length <= 16; ++length)
+			{
+				maxCode_[length] = -1;
+				valueOffset_[length] = 0;
+			}
+		}
+
+		bool JpegHuffmanTable::Build(const uint8_t counts[16], const uint8_t* symbols, size_t symbolCount)
+		{
+			valid_ = false;
+			std::memset(lookup_, 0, sizeof(lookup_));
+			std::memset(diffLength_, 0, sizeof(diffLength_));
+
+			size_t total = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				total += counts[i];
+			}
+			if (total > 256 || total > symbolCount)
+			{
+				return false;
+			}
+			std::memcpy(symbols_, symbols, total);
+
+			// Canonical codes: consecutive within a length, doubled between lengths
+			uint32_t code = 0;
+			int32_t index = 0;
+			for (int length = 1; length <= 16; ++length)
+			{
+				uint8_t count = counts[length - 1];
+				valueOffset_[length] = index - static_cast<int32_t>(code);
+				maxCode_[length] = count > 0 ? static_cast<int32_t>(code + count - 1) : -1;
+				if (code + count > (1u << length))
+				{
+					return false;   // Over-subscribed
+				}
+
+				for (uint8_t i = 0; i < count; ++i, ++code, ++index)
+				{
+					if (length > kLookupBits)
+					{
+						continue;
+					}
+
+					int spare = kLookupBits - length;
+					uint8_t symbol = symbols_[index];
+					uint32_t first = code << spare;
+					for (uint32_t fill = 0; fill < (1u << spare); ++fill)
+					{
+						lookup_[first + fill] = static_cast<uint16_t>((length << 8) | symbol);
+					}
+
+					// Short code plus its extra bits: cache the finished difference
+					if (symbol < 16 && length + symbol <= kLookupBits)
+					{
+						int rest = spare - symbol;
+						for (uint32_t extra = 0; extra < (1u << symbol); ++extra)
+						{
+							uint32_t start = ((code << symbol) | extra) << rest;
+							for (uint32_t fill = 0; fill < (1u << rest); ++fill)
+							{
+								diffLength_[start + fill] = static_cast<uint8_t>(length + symbol);
+								diff_[start + fill] = static_cast<int16_t>(JpegBitReader::Extend(extra, symbol));
+							}
+						}
+					}
+				}
+				code <<= 1;
+			}
+
+			valid_ = true;
+			return true;
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,362 @@
+#include "medvision/dicom/JpegLosslessCodec.h"
+#include "medvision/dicom/JpegHuffman.h"
+#include <cstddef>
+#include <vector>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const uint8_t kSOF3 = 0xC3;
+			const uint8_t kDHT = 0xC4;
+			const uint8_t kSOI = 0xD8;
+			const uint8_t kEOI = 0xD9;
+			const uint8_t kSOS = 0xDA;
+			const uint8_t kDRI = 0xDD;
+
+			struct LosslessFrame
+			{
+				int precision;
+				uint32_t rows;
+				uint32_t columns;
+				std::vector<uint8_t> componentIds;
+			};
+
+			struct LosslessScan
+			{
+				size_t components[4];                  // Frame component indexes
+				const JpegHuffmanTable* tables[4];
+				size_t componentCount;
+				int predictor;
+				int pointTransform;
+				uint32_t restartInterval;
+			};
+
+			uint16_t ReadUInt16BE(const uint8_t* data)
+			{
+				return static_cast<uint16_t>((data[0] << 8) | data[1]);
+			}
+
+			// Decode one scan; Predict(ra, rb, rc) is the scan's predictor
+			template <typename T, typename Predict>
+			bool DecodeRows(JpegBitReader& reader, const LosslessFrame& frame, const LosslessScan& scan,
+				Predict predict, T* output, std::string& error)
+			{
+				const size_t samples = frame.componentIds.size();
+				const size_t stride = frame.columns * samples;
+				const int32_t initial = 1 << (frame.precision - scan.pointTransform - 1);
+				const uint32_t rowsPerInterval = scan.restartInterval / frame.columns;
+
+				bool firstRow = true;
+				for (uint32_t y = 0; y < frame.rows; ++y)
+				{
+					// Restart intervals are whole rows; each restarts prediction
+					if (rowsPerInterval != 0 && y != 0 && y % rowsPerInterval == 0)
+					{
+						if (!reader.Restart())
+						{
+							error = "Missing JPEG restart marker";
+							return false;
+						}
+						firstRow = true;
+					}
+
+					T* row = output + y * stride;
+					for (size_t k = 0; k < scan.componentCount; ++k)
+					{
+						int32_t difference;
+						if (!reader.DecodeDifference(*scan.tables[k], difference))
+						{
+							error = "Invalid JPEG Huffman code";
+							return false;
+						}
+						T* sample = row + scan.components[k];
+						int32_t prediction = firstRow ? initial : sample[-static_cast<ptrdiff_t>(stride)];
+						*sample = static_cast<T>((prediction + difference) & 0xFFFF);
+					}
+
+					for (uint32_t x = 1; x < frame.columns; ++x)
+					{
+						T* pixel = row + x * samples;
+						for (size_t k = 0; k < scan.componentCount; ++k)
+						{
+							int32_t difference;
+							if (!reader.DecodeDifference(*scan.tables[k], difference))
+							{
+								error = "Invalid JPEG Huffman code";
+								return false;
+							}
+							T* sample = pixel + scan.components[k];
+							int32_t prediction = firstRow
+								? static_cast<int32_t>(sample[-static_cast<ptrdiff_t>(samples)])
+								: predict(sample[-static_cast<ptrdiff_t>(samples)],
+									sample[-static_cast<ptrdiff_t>(stride)],
+									sample[-static_cast<ptrdiff_t>(stride + samples)]);
+							*sample = static_cast<T>((prediction + difference) & 0xFFFF);
+						}
+					}
+
+					if (reader.IsOverrun())
+					{
+						error = "JPEG data is truncated";
+						return false;
+					}
+					firstRow = false;
+				}
+				return true;
+			}
+
+			template <typename T>
+			bool DecodeScan(JpegBitReader& reader, const LosslessFrame& frame, const LosslessScan& scan,
+				T* output, std::string& error)
+			{
+				// One instantiation per predictor keeps the selection out of the sample loop
+				bool success = false;
+				switch (scan.predictor)
+				{
+				case 1: success = DecodeRows(reader, frame, scan, [](int32_t a, int32_t, int32_t) { return a; }, output, error); break;
+				case 2: success = DecodeRows(reader, frame, scan, [](int32_t, int32_t b, int32_t) { return b; }, output, error); break;
+				case 3: success = DecodeRows(reader, frame, scan, [](int32_t, int32_t, int32_t c) { return c; }, output, error); break;
+				case 4: success = DecodeRows(reader, frame, scan, [](int32_t a, int32_t b, int32_t c) { return a + b - c; }, output, error); break;
+				case 5: success = DecodeRows(reader, frame, scan, [](int32_t a, int32_t b, int32_t c) { return a + ((b - c) >> 1); }, output, error); break;
+				case 6: success = DecodeRows(reader, frame, scan, [](int32_t a, int32_t b, int32_t c) { return b + ((a - c) >> 1); }, output, error); break;
+				case 7: success = DecodeRows(reader, frame, scan, [](int32_t a, int32_t b, int32_t) { return (a + b) >> 1; }, output, error); break;
+				default:
+					error = "Invalid JPEG lossless predictor";
+					return false;
+				}
+				if (!success)
+				{
+					return false;
+				}
+
+				if (scan.pointTransform > 0)
+				{
+					const size_t samples = frame.componentIds.size();
+					const size_t pixels = static_cast<size_t>(frame.rows) * frame.columns;
+					for (size_t k = 0; k < scan.componentCount; ++k)
+					{
+						for (size_t i = scan.components[k]; i < pixels * samples; i += samples)
+						{
+							output[i] = static_cast<T>(output[i] << scan.pointTransform);
+						}
+					}
+				}
+				return true;
+			}
+
+			// Position of the next marker code byte at or after position (entropy data is skipped)
+			bool FindMarker(const uint8_t* data, size_t length, size_t& position)
+			{
+				while (position + 1 < length)
+				{
+					if (data[position] == 0xFF && data[position + 1] != 0x00 && data[position + 1] != 0xFF &&
+						!(data[position + 1] >= 0xD0 && data[position + 1] <= 0xD7))
+					{
+						++position;
+						return true;
+					}
+					++position;
+				}
+				return false;
+			}
+		}
+
+		bool JpegLosslessDecoder::DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+			uint8_t* output, std::string& error) const
+		{
+			if (info.bitsAllocated != 8 && info.bitsAllocated != 16)
+			{
+				error = "JPEG Lossless output must be 8 or 16 bits allocated";
+				return false;
+			}
+			if (length < 4 || data[0] != 0xFF || data[1] != kSOI)
+			{
+				error = "Missing JPEG SOI marker";
+				return false;
+			}
+
+			LosslessFrame frame;
+			frame.precision = 0;
+			frame.rows = 0;
+			frame.columns = 0;
+
+			JpegHuffmanTable tables[4];
+			uint32_t restartInterval = 0;
+			std::vector<bool> decoded;
+			size_t position = 2;
+
+			while (FindMarker(data, length, position))
+			{
+				uint8_t marker = data[position++];
+				if (marker == kEOI)
+				{
+					break;
+				}
+				if (marker == kSOI || position + 2 > length)
+				{
+					error = "Malformed JPEG marker sequence";
+					return false;
+				}
+
+				size_t segmentLength = ReadUInt16BE(data + position);
+				if (segmentLength < 2 || position + segmentLength > length)
+				{
+					error = "JPEG marker segment is truncated";
+					return false;
+				}
+				const uint8_t* segment = data + position + 2;
+				size_t segmentEnd = position + segmentLength;
+				position = segmentEnd;
+
+				if (marker == kSOF3)
+				{
+					if (segmentLength < 8 || segmentLength != 8 + 3u * segment[5])
+					{
+						error = "Malformed JPEG SOF3 segment";
+						return false;
+					}
+					frame.precision = segment[0];
+					frame.rows = ReadUInt16BE(segment + 1);
+					frame.columns = ReadUInt16BE(segment + 3);
+					frame.componentIds.clear();
+					for (uint8_t i = 0; i < segment[5]; ++i)
+					{
+						if (segment[6 + i * 3 + 1] != 0x11)
+						{
+							error = "Subsampled JPEG Lossless is not supported";
+							return false;
+						}
+						frame.componentIds.push_back(segment[6 + i * 3]);
+					}
+
+					if (frame.precision < 2 || frame.precision > info.bitsAllocated)
+					{
+						error = "JPEG precision " + std::to_string(frame.precision) + " does not fit the frame";
+						return false;
+					}
+					if (frame.rows != info.rows || frame.columns != info.columns ||
+						frame.componentIds.size() != info.samplesPerPixel || frame.componentIds.size() > 4)
+					{
+						error = "JPEG dimensions do not match the image";
+						return false;
+					}
+					decoded.assign(frame.componentIds.size(), false);
+				}
+				else if (marker >= 0xC0 && marker <= 0xCF && marker != kDHT && marker != 0xC8 && marker != 0xCC)
+				{
+					error = "Not a JPEG Lossless (SOF3) frame";
+					return false;
+				}
+				else if (marker == kDHT)
+				{
+					const uint8_t* table = segment;
+					while (table + 17 <= data + segmentEnd)
+					{
+						size_t symbolCount = 0;
+						for (int i = 0; i < 16; ++i)
+						{
+							symbolCount += table[1 + i];
+						}
+						if ((table[0] & 0x0F) > 3 || table + 17 + symbolCount > data + segmentEnd ||
+							!tables[table[0] & 0x0F].Build(table + 1, table + 17, symbolCount))
+						{
+							error = "Malformed JPEG Huffman table";
+							return false;
+						}
+						table += 17 + symbolCount;
+					}
+				}
+				else if (marker == kDRI)
+				{
+					if (segmentLength != 4)
+					{
+						error = "Malformed JPEG DRI segment";
+						return false;
+					}
+					restartInterval = ReadUInt16BE(segment);
+				}
+				else if (marker == kSOS)
+				{
+					if (frame.componentIds.empty())
+					{
+						error = "JPEG scan before the frame header";
+						return false;
+					}
+
+					LosslessScan scan;
+					scan.componentCount = segment[0];
+					if (scan.componentCount == 0 || scan.componentCount > frame.componentIds.size() ||
+						segmentLength != 6 + 2 * scan.componentCount)
+					{
+						error = "Malformed JPEG SOS segment";
+						return false;
+					}
+					for (size_t k = 0; k < scan.componentCount; ++k)
+					{
+						uint8_t id = segment[1 + k * 2];
+						uint8_t tableIndex = segment[2 + k * 2] >> 4;
+						size_t c = 0;
+						while (c < frame.componentIds.size() && frame.componentIds[c] != id)
+						{
+							++c;
+						}
+						if (c == frame.componentIds.size() || tableIndex > 3 || !tables[tableIndex].IsValid())
+						{
+							error = "JPEG scan references an unknown component or table";
+							return false;
+						}
+						scan.components[k] = c;
+						scan.tables[k] = &tables[tableIndex];
+						decoded[c] = true;
+					}
+
+					const uint8_t* parameters = segment + 1 + scan.componentCount * 2;
+					scan.predictor = parameters[0];
+					scan.pointTransform = parameters[2] & 0x0F;
+					scan.restartInterval = restartInterval;
+					if (scan.pointTransform >= frame.precision)
+					{
+						error = "Invalid JPEG point transform";
+						return false;
+					}
+					if (restartInterval % frame.columns != 0)
+					{
+						error = "JPEG restart interval is not a whole number of rows";
+						return false;
+					}
+
+					JpegBitReader reader(data, length, position);
+					bool success = (info.bitsAllocated == 8)
+						? DecodeScan(reader, frame, scan, output, error)
+						: DecodeScan(reader, frame, scan, reinterpret_cast<uint16_t*>(output), error);
+					if (!success)
+					{
+						return false;
+					}
+					position = reader.GetPosition();
+				}
+				// APPn, COM, DNL and other segments are skipped
+			}
+
+			if (decoded.empty())
+			{
+				error = "JPEG data has no frame header";
+				return false;
+			}
+			for (bool componentDecoded : decoded)
+			{
+				if (!componentDecoded)
+				{
+					error = "JPEG data does not cover every component";
+					return false;
+				}
+			}
+			return true;
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,963 @@
+#include "medvision/dicom/JpegLsCodec.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const uint8_t kSOI = 0xD8;
+			const uint8_t kEOI = 0xD9;
+			const uint8_t kSOS = 0xDA;
+			const uint8_t kDRI = 0xDD;
+			const uint8_t kSOF55 = 0xF7;
+			const uint8_t kLSE = 0xF8;
+
+			const int kRegularContexts = 365;
+
+			// Run-length order of each run index (T.87 A.7.1.2)
+			const int kJ[32] = { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+				4, 4, 5, 5, 6, 6, 7, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+			uint16_t ReadUInt16BE(const uint8_t* data)
+			{
+				return static_cast<uint16_t>((data[0] << 8) | data[1]);
+			}
+
+			inline int CountLeadingZeros(uint64_t value)
+			{
+#ifdef _MSC_VER
+				unsigned long index;
+				_BitScanReverse64(&index, value);
+				return 63 - static_cast<int>(index);
+#else
+				return __builtin_clzll(value);
+#endif
+			}
+
+			// Smallest n with 2^n >= value
+			int CeilLog2(int32_t value)
+			{
+				int n = 0;
+				while ((int32_t(1) << n) < value)
+				{
+					++n;
+				}
+				return n;
+			}
+
+			/// MSB-first reader over JPEG-LS entropy-coded data
+			///
+			/// A 0xFF byte is followed by a byte whose top bit is a stuffed zero;
+			/// 0xFF followed by a byte with the top bit set is a marker, where the
+			/// reader stops and feeds zero bits instead.
+			class LsBitReader
+			{
+			public:
+				LsBitReader(const uint8_t* data, size_t length, size_t position)
+					: data_(data), length_(length), position_(position), bits_(0), count_(0),
+					padding_(0), marker_(false), stuffed_(false)
+				{
+				}
+
+				/// Top up the bit buffer to at least 57 bits
+				void Fill()
+				{
+					while (count_ <= 56)
+					{
+						if (!marker_ && position_ < length_)
+						{
+							uint64_t byte = data_[position_];
+							if (byte == 0xFF && (position_ + 1 >= length_ || data_[position_ + 1] >= 0x80))
+							{
+								marker_ = true;
+								continue;
+							}
+							++position_;
+							if (stuffed_)
+							{
+								bits_ |= (byte & 0x7F) << (57 - count_);
+								count_ += 7;
+							}
+							else
+							{
+								bits_ |= byte << (56 - count_);
+								count_ += 8;
+							}
+							stuffed_ = (byte == 0xFF);
+						}
+						else
+						{
+							marker_ = true;
+							padding_ += 8;
+							count_ += 8;
+						}
+					}
+				}
+
+				uint32_t ReadBits(int count)
+				{
+					if (count == 0)
+					{
+						return 0;
+					}
+					if (count_ < count)
+					{
+						Fill();
+					}
+					uint32_t value = static_cast<uint32_t>(bits_ >> (64 - count));
+					bits_ <<= count;
+					count_ -= count;
+					return value;
+				}
+
+				bool ReadBit()
+				{
+					return ReadBits(1) != 0;
+				}
+
+				/// Count zero bits up to and including the next one bit; -1 once more
+				/// than limit zeros were seen
+				int ReadZeros(int limit)
+				{
+					int zeros = 0;
+					if (count_ < 32)
+					{
+						Fill();
+					}
+					while (bits_ == 0)
+					{
+						// Bits past count_ are always zero, so every buffered bit is a zero
+						zeros += count_;
+						count_ = 0;
+						if (zeros > limit)
+						{
+							return -1;
+						}
+						Fill();
+					}
+					int leading = CountLeadingZeros(bits_);
+					bits_ <<= leading + 1;
+					count_ -= leading + 1;
+					zeros += leading;
+					return zeros <= limit ? zeros : -1;
+				}
+
+				/// Skip to and consume the RSTn marker that ends a restart interval
+				bool Restart()
+				{
+					bits_ = 0;
+					count_ = 0;
+					padding_ = 0;
+					marker_ = false;
+					stuffed_ = false;
+					while (position_ + 1 < length_ && !(data_[position_] == 0xFF && data_[position_ + 1] >= 0x80))
+					{
+						++position_;
+					}
+					if (position_ + 1 < length_ && data_[position_ + 1] >= 0xD0 && data_[position_ + 1] <= 0xD7)
+					{
+						position_ += 2;
+						return true;
+					}
+					return false;
+				}
+
+				/// True once zero bits past a marker or the end of data were consumed
+				bool IsOverrun() const { return padding_ > count_; }
+
+				/// Byte position; at a marker once the entropy data ran out
+				size_t GetPosition() const { return position_; }
+
+			private:
+				const uint8_t* data_;
+				size_t length_;
+				size_t position_;
+				uint64_t bits_;       // Left aligned
+				int count_;
+				int padding_;         // Zero bits appended after the data ran out
+				bool marker_;
+				bool stuffed_;        // The last byte read was 0xFF
+			};
+
+			/// Preset coding parameters of an LSE segment; 0 selects the default
+			struct LsPresets
+			{
+				int32_t maxValue = 0;
+				int32_t t1 = 0;
+				int32_t t2 = 0;
+				int32_t t3 = 0;
+				int32_t reset = 0;
+			};
+
+			/// Coding parameters of one scan (T.87 A.2 and C.2.4.1.1)
+			struct LsCoding
+			{
+				int32_t maxValue;
+				int32_t near;
+				int32_t range;
+				int32_t qbpp;
+				int32_t limit;
+				int32_t reset;
+				int32_t t1;
+				int32_t t2;
+				int32_t t3;
+			};
+
+			bool SetUpCoding(const LsPresets& presets, int precision, int32_t near, LsCoding& coding, std::string& error)
+			{
+				const int32_t fullRange = (int32_t(1) << precision) - 1;
+				coding.maxValue = presets.maxValue != 0 ? presets.maxValue : fullRange;
+				if (coding.maxValue > fullRange)
+				{
+					error = "JPEG-LS MAXVAL exceeds the sample precision";
+					return false;
+				}
+				if (near > std::min(255, coding.maxValue / 2))
+				{
+					error = "Invalid JPEG-LS NEAR value";
+					return false;
+				}
+				coding.near = near;
+				coding.range = (coding.maxValue + 2 * near) / (2 * near + 1) + 1;
+				coding.qbpp = CeilLog2(coding.range);
+				int32_t bpp = std::max(2, CeilLog2(coding.maxValue + 1));
+				coding.limit = 2 * (bpp + std::max(8, bpp));
+				coding.reset = presets.reset != 0 ? presets.reset : 64;
+
+				// Default thresholds; CLAMP falls back to the lower bound when out of range
+				auto clamp = [&](int32_t value, int32_t lower) {
+					return (value > coding.maxValue || value < lower) ? lower : value;
+				};
+				int32_t t1;
+				int32_t t2;
+				int32_t t3;
+				if (coding.maxValue >= 128)
+				{
+					int32_t factor = (std::min(coding.maxValue, 4095) + 128) / 256;
+					t1 = clamp(factor * (3 - 2) + 2 + 3 * near, near + 1);
+					t2 = clamp(factor * (7 - 3) + 3 + 5 * near, t1);
+					t3 = clamp(factor * (21 - 4) + 4 + 7 * near, t2);
+				}
+				else
+				{
+					int32_t factor = 256 / (coding.maxValue + 1);
+					t1 = clamp(std::max(2, 3 / factor + 3 * near), near + 1);
+					t2 = clamp(std::max(3, 7 / factor + 5 * near), t1);
+					t3 = clamp(std::max(4, 21 / factor + 7 * near), t2);
+				}
+				coding.t1 = presets.t1 != 0 ? presets.t1 : t1;
+				coding.t2 = presets.t2 != 0 ? presets.t2 : t2;
+				coding.t3 = presets.t3 != 0 ? presets.t3 : t3;
+				if (coding.t1 < near + 1 || coding.t2 < coding.t1 || coding.t3 < coding.t2 || coding.t3 > coding.maxValue)
+				{
+					error = "Invalid JPEG-LS preset thresholds";
+					return false;
+				}
+				return true;
+			}
+
+			/// Context modeling and Golomb decoding of one scan (T.87 Annex A)
+			///
+			/// Components of a line- or sample-interleaved scan share the contexts;
+			/// each component keeps its own run index in line-interleaved scans.
+			class LsScanDecoder
+			{
+			public:
+				LsScanDecoder(const LsCoding& coding, LsBitReader& reader)
+					: coding_(coding), reader_(reader), scale_(2 * coding.near + 1),
+					wrap_(coding.range * (2 * coding.near + 1)), valid_(true)
+				{
+					// Gradient quantization to -4..4 for every difference of two samples
+					quantize_.resize(2 * static_cast<size_t>(coding.maxValue) + 1);
+					for (int32_t d = -coding.maxValue; d <= coding.maxValue; ++d)
+					{
+						int8_t q;
+						if (d <= -coding.t3) q = -4;
+						else if (d <= -coding.t2) q = -3;
+						else if (d <= -coding.t1) q = -2;
+						else if (d < -coding.near) q = -1;
+						else if (d <= coding.near) q = 0;
+						else if (d < coding.t1) q = 1;
+						else if (d < coding.t2) q = 2;
+						else if (d < coding.t3) q = 3;
+						else q = 4;
+						quantize_[d + coding.maxValue] = q;
+					}
+					Reset();
+				}
+
+				/// Initial context state, also restored at every restart marker
+				void Reset()
+				{
+					const int32_t initialA = std::max(2, (coding_.range + 32) / 64);
+					for (RegularContext& context : contexts_)
+					{
+						context.a = initialA;
+						context.b = 0;
+						context.c = 0;
+						context.n = 1;
+					}
+					for (int type = 0; type < 2; ++type)
+					{
+						runContexts_[type].a = initialA;
+						runContexts_[type].n = 1;
+						runContexts_[type].nn = 0;
+						runContexts_[type].type = type;
+					}
+				}
+
+				bool IsValid() const { return valid_; }
+
+				/// Decode one line of one component. current and previous have a
+				/// border sample before the first and after the last column.
+				void DecodeLine(int32_t* current, const int32_t* previous, int32_t width, int& runIndex)
+				{
+					int32_t x = 0;
+					while (x < width)
+					{
+						const int32_t ra = current[x - 1];
+						const int32_t rb = previous[x];
+						const int32_t rc = previous[x - 1];
+						const int32_t context = ContextIndex(previous[x + 1] - rb, rb - rc, rc - ra);
+						if (context != 0)
+						{
+							current[x] = DecodeRegular(context, Predict(ra, rb, rc));
+							++x;
+						}
+						else
+						{
+							x += DecodeRun(current + x, previous + x, width - x, runIndex);
+						}
+					}
+				}
+
+				/// Decode one line of samples interleaved pixel by pixel; a run
+				/// needs every component of the pixel to be flat
+				void DecodeInterleavedLine(int32_t* current, const int32_t* previous, int32_t width,
+					int32_t samples, int& runIndex)
+				{
+					int32_t contexts[4];
+					int32_t x = 0;
+					while (x < width)
+					{
+						int32_t* pixel = current + x * samples;
+						const int32_t* above = previous + x * samples;
+						bool flat = true;
+						for (int32_t k = 0; k < samples; ++k)
+						{
+							const int32_t rb = above[k];
+							const int32_t rc = above[k - samples];
+							contexts[k] = ContextIndex(above[k + samples] - rb, rb - rc, rc - pixel[k - samples]);
+							flat = flat && contexts[k] == 0;
+						}
+						if (!flat)
+						{
+							for (int32_t k = 0; k < samples; ++k)
+							{
+								pixel[k] = DecodeRegular(contexts[k], Predict(pixel[k - samples], above[k], above[k - samples]));
+							}
+							++x;
+						}
+						else
+						{
+							x += DecodeInterleavedRun(pixel, above, width - x, samples, runIndex);
+						}
+					}
+				}
+
+			private:
+				struct RegularContext
+				{
+					int32_t a;   // Accumulated error magnitudes
+					int32_t b;   // Accumulated bias
+					int32_t c;   // Prediction correction, -128..127
+					int32_t n;   // Occurrences
+				};
+
+				struct RunContext
+				{
+					int32_t a;
+					int32_t n;
+					int32_t nn;    // Negative errors
+					int32_t type;  // RItype: 1 when the interruption sample's neighbors agree
+				};
+
+				int32_t ContextIndex(int32_t d1, int32_t d2, int32_t d3) const
+				{
+					const int8_t* q = quantize_.data() + coding_.maxValue;
+					return q[d1] * 81 + q[d2] * 9 + q[d3];
+				}
+
+				// Median edge detector
+				static int32_t Predict(int32_t ra, int32_t rb, int32_t rc)
+				{
+					const int32_t low = std::min(ra, rb);
+					const int32_t high = std::max(ra, rb);
+					if (rc >= high)
+					{
+						return low;
+					}
+					if (rc <= low)
+					{
+						return high;
+					}
+					return ra + rb - rc;
+				}
+
+				int32_t Clamp(int32_t value) const
+				{
+					return value < 0 ? 0 : (value > coding_.maxValue ? coding_.maxValue : value);
+				}
+
+				// Undo the modulo reduction of the error and clamp into 0..MAXVAL
+				int32_t Reconstruct(int32_t value) const
+				{
+					if (value < -coding_.near)
+					{
+						value += wrap_;
+					}
+					else if (value > coding_.maxValue + coding_.near)
+					{
+						value -= wrap_;
+					}
+					return Clamp(value);
+				}
+
+				// Limited-length Golomb code of parameter k
+				int32_t DecodeValue(int k, int32_t limit)
+				{
+					const int escape = limit - coding_.qbpp - 1;
+					int zeros = reader_.ReadZeros(escape);
+					if (zeros < 0)
+					{
+						valid_ = false;
+						return 0;
+					}
+					if (zeros == escape)
+					{
+						return static_cast<int32_t>(reader_.ReadBits(coding_.qbpp)) + 1;
+					}
+					return (zeros << k) + static_cast<int32_t>(reader_.ReadBits(k));
+				}
+
+				int32_t DecodeRegular(int32_t context, int32_t predicted)
+				{
+					const int32_t sign = context < 0 ? -1 : 1;
+					RegularContext& ctx = contexts_[context * sign];
+
+					int k = 0;
+					while ((ctx.n << k) < ctx.a)
+					{
+						++k;
+					}
+					const int32_t prediction = Clamp(predicted + sign * ctx.c);
+
+					const int32_t mapped = DecodeValue(k, coding_.limit);
+					int32_t error = (mapped & 1) ? -((mapped + 1) >> 1) : (mapped >> 1);
+					if (k == 0 && coding_.near == 0 && 2 * ctx.b <= -ctx.n)
+					{
+						error = -error - 1;
+					}
+
+					ctx.a += std::abs(error);
+					ctx.b += error * scale_;
+					if (ctx.n == coding_.reset)
+					{
+						ctx.a >>= 1;
+						ctx.b >>= 1;
+						ctx.n >>= 1;
+					}
+					++ctx.n;
+					if (ctx.b <= -ctx.n)
+					{
+						ctx.b += ctx.n;
+						if (ctx.c > -128)
+						{
+							--ctx.c;
+						}
+						if (ctx.b <= -ctx.n)
+						{
+							ctx.b = -ctx.n + 1;
+						}
+					}
+					else if (ctx.b > 0)
+					{
+						ctx.b -= ctx.n;
+						if (ctx.c < 127)
+						{
+							++ctx.c;
+						}
+						if (ctx.b > 0)
+						{
+							ctx.b = 0;
+						}
+					}
+
+					return Reconstruct(prediction + sign * error * scale_);
+				}
+
+				// Length of a run of samples equal to the one before it, up to remaining
+				int32_t DecodeRunLength(int32_t remaining, int& runIndex)
+				{
+					int32_t length = 0;
+					while (reader_.ReadBit())
+					{
+						const int32_t block = int32_t(1) << kJ[runIndex];
+						const int32_t count = std::min(block, remaining - length);
+						length += count;
+						if (count == block && runIndex < 31)
+						{
+							++runIndex;
+						}
+						if (length == remaining)
+						{
+							return length;
+						}
+					}
+					length += static_cast<int32_t>(reader_.ReadBits(kJ[runIndex]));
+					if (length > remaining)
+					{
+						valid_ = false;
+						length = remaining;
+					}
+					return length;
+				}
+
+				// Error of a run interruption sample (T.87 A.7.2)
+				int32_t DecodeRunError(RunContext& ctx, int runIndex)
+				{
+					const int32_t temp = ctx.a + (ctx.n >> 1) * ctx.type;
+					int k = 0;
+					while ((ctx.n << k) < temp)
+					{
+						++k;
+					}
+
+					const int32_t mapped = DecodeValue(k, coding_.limit - kJ[runIndex] - 1);
+					const int32_t unmapped = mapped + ctx.type;
+					const bool map = (unmapped & 1) != 0;
+					const int32_t magnitude = (unmapped + (map ? 1 : 0)) / 2;
+					const bool negative = (k != 0 || 2 * ctx.nn >= ctx.n) == map;
+					const int32_t error = negative ? -magnitude : magnitude;
+
+					if (error < 0)
+					{
+						++ctx.nn;
+					}
+					ctx.a += (mapped + 1 - ctx.type) >> 1;
+					if (ctx.n == coding_.reset)
+					{
+						ctx.a >>= 1;
+						ctx.n >>= 1;
+						ctx.nn >>= 1;
+					}
+					++ctx.n;
+					return error;
+				}
+
+				// Run at current[0] (current[-1] is the run value); returns the
+				// samples decoded, including a run interruption sample
+				int32_t DecodeRun(int32_t* current, const int32_t* previous, int32_t remaining, int& runIndex)
+				{
+					const int32_t ra = current[-1];
+					const int32_t length = DecodeRunLength(remaining, runIndex);
+					std::fill(current, current + length, ra);
+					if (length == remaining)
+					{
+						return length;
+					}
+
+					const int32_t rb = previous[length];
+					if (std::abs(ra - rb) <= coding_.near)
+					{
+						current[length] = Reconstruct(ra + DecodeRunError(runContexts_[1], runIndex) * scale_);
+					}
+					else
+					{
+						const int32_t sign = rb > ra ? 1 : -1;
+						current[length] = Reconstruct(rb + sign * DecodeRunError(runContexts_[0], runIndex) * scale_);
+					}
+					if (runIndex > 0)
+					{
+						--runIndex;
+					}
+					return length + 1;
+				}
+
+				// Run of whole pixels; every sample of the interruption pixel is
+				// coded against the pixel above it
+				int32_t DecodeInterleavedRun(int32_t* current, const int32_t* previous, int32_t remaining,
+					int32_t samples, int& runIndex)
+				{
+					const int32_t length = DecodeRunLength(remaining, runIndex);
+					for (int32_t i = 0; i < length * samples; ++i)
+					{
+						current[i] = current[i - samples];
+					}
+					if (length == remaining)
+					{
+						return length;
+					}
+
+					int32_t* pixel = current + length * samples;
+					const int32_t* above = previous + length * samples;
+					for (int32_t k = 0; k < samples; ++k)
+					{
+						const int32_t ra = pixel[k - samples];
+						const int32_t rb = above[k];
+						const int32_t sign = rb >= ra ? 1 : -1;
+						pixel[k] = Reconstruct(rb + sign * DecodeRunError(runContexts_[0], runIndex) * scale_);
+					}
+					if (runIndex > 0)
+					{
+						--runIndex;
+					}
+					return length + 1;
+				}
+
+			private:
+				const LsCoding coding_;
+				LsBitReader& reader_;
+				const int32_t scale_;    // 2 * NEAR + 1
+				const int32_t wrap_;     // RANGE * (2 * NEAR + 1)
+				bool valid_;
+				std::vector<int8_t> quantize_;
+				RegularContext contexts_[kRegularContexts];
+				RunContext runContexts_[2];
+			};
+
+			struct LsFrame
+			{
+				int precision;
+				uint32_t rows;
+				uint32_t columns;
+				std::vector<uint8_t> componentIds;
+			};
+
+			struct LsScan
+			{
+				size_t components[4];   // Frame component indexes
+				size_t componentCount;
+				int32_t near;
+				int interleave;         // ILV: 0 none, 1 line, 2 sample
+				uint32_t restartInterval;
+			};
+
+			template <typename T>
+			bool DecodeScan(LsBitReader& reader, const LsFrame& frame, const LsScan& scan, const LsCoding& coding,
+				T* output, std::string& error)
+			{
+				const size_t samples = frame.componentIds.size();
+				const int32_t width = static_cast<int32_t>(frame.columns);
+				const int32_t count = static_cast<int32_t>(scan.componentCount);
+				const bool sampleInterleaved = scan.interleave == 2 && count > 1;
+
+				// Two lines (previous, current) per component, or per scan when the
+				// samples are interleaved; each with a border sample at both ends
+				const int32_t step = sampleInterleaved ? count : 1;
+				const size_t lineLength = static_cast<size_t>(width + 2) * step;
+				const size_t lineSets = sampleInterleaved ? 1 : scan.componentCount;
+				std::vector<int32_t> lines(2 * lineSets * lineLength, 0);
+
+				LsScanDecoder decoder(coding, reader);
+				int runIndex[4] = { 0, 0, 0, 0 };
+
+				for (uint32_t y = 0; y < frame.rows; ++y)
+				{
+					// Restart intervals count lines; each starts over like the first line
+					if (scan.restartInterval != 0 && y != 0 && y % scan.restartInterval == 0)
+					{
+						if (!reader.Restart())
+						{
+							error = "Missing JPEG-LS restart marker";
+							return false;
+						}
+						decoder.Reset();
+						std::fill(lines.begin(), lines.end(), 0);
+						std::fill(runIndex, runIndex + 4, 0);
+					}
+
+					T* row = output + static_cast<size_t>(y) * frame.columns * samples;
+					for (size_t set = 0; set < lineSets; ++set)
+					{
+						int32_t* base = lines.data() + set * 2 * lineLength;
+						int32_t* current = base + ((y & 1) ? lineLength : 0) + step;
+						int32_t* previous = base + ((y & 1) ? 0 : lineLength) + step;
+						for (int32_t k = 0; k < step; ++k)
+						{
+							previous[width * step + k] = previous[(width - 1) * step + k];
+							current[k - step] = previous[k];
+						}
+
+						if (sampleInterleaved)
+						{
+							decoder.DecodeInterleavedLine(current, previous, width, count, runIndex[0]);
+							for (int32_t k = 0; k < count; ++k)
+							{
+								T* sample = row + scan.components[k];
+								for (int32_t x = 0; x < width; ++x)
+								{
+									sample[x * samples] = static_cast<T>(current[x * count + k]);
+								}
+							}
+						}
+						else
+						{
+							decoder.DecodeLine(current, previous, width, runIndex[set]);
+							T* sample = row + scan.components[set];
+							for (int32_t x = 0; x < width; ++x)
+							{
+								sample[x * samples] = static_cast<T>(current[x]);
+							}
+						}
+					}
+
+					if (!decoder.IsValid())
+					{
+						error = "Invalid JPEG-LS code";
+						return false;
+					}
+					if (reader.IsOverrun())
+					{
+						error = "JPEG-LS data is truncated";
+						return false;
+					}
+				}
+				return true;
+			}
+
+			// Position of the next marker code byte at or after position (entropy data is skipped)
+			bool FindMarker(const uint8_t* data, size_t length, size_t& position)
+			{
+				while (position + 1 < length)
+				{
+					uint8_t code = data[position + 1];
+					if (data[position] == 0xFF && code >= 0x80 && code != 0xFF && !(code >= 0xD0 && code <= 0xD7))
+					{
+						++position;
+						return true;
+					}
+					++position;
+				}
+				return false;
+			}
+		}
+
+		bool JpegLsDecoder::DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+			uint8_t* output, std::string& error) const
+		{
+			if (info.bitsAllocated != 8 && info.bitsAllocated != 16)
+			{
+				error = "JPEG-LS output must be 8 or 16 bits allocated";
+				return false;
+			}
+			if (length < 4 || data[0] != 0xFF || data[1] != kSOI)
+			{
+				error = "Missing JPEG SOI marker";
+				return false;
+			}
+
+			LsFrame frame;
+			frame.precision = 0;
+			frame.rows = 0;
+			frame.columns = 0;
+
+			LsPresets presets;
+			uint32_t restartInterval = 0;
+			std::vector<bool> decoded;
+			size_t position = 2;
+
+			while (FindMarker(data, length, position))
+			{
+				uint8_t marker = data[position++];
+				if (marker == kEOI)
+				{
+					break;
+				}
+				if (marker == kSOI || position + 2 > length)
+				{
+					error = "Malformed JPEG marker sequence";
+					return false;
+				}
+
+				size_t segmentLength = ReadUInt16BE(data + position);
+				if (segmentLength < 2 || position + segmentLength > length)
+				{
+					error = "JPEG marker segment is truncated";
+					return false;
+				}
+				const uint8_t* segment = data + position + 2;
+				position += segmentLength;
+
+				if (marker == kSOF55)
+				{
+					if (segmentLength < 8 || segmentLength != 8 + 3u * segment[5])
+					{
+						error = "Malformed JPEG-LS SOF55 segment";
+						return false;
+					}
+					frame.precision = segment[0];
+					frame.rows = ReadUInt16BE(segment + 1);
+					frame.columns = ReadUInt16BE(segment + 3);
+					frame.componentIds.clear();
+					for (uint8_t i = 0; i < segment[5]; ++i)
+					{
+						if (segment[6 + i * 3 + 1] != 0x11)
+						{
+							error = "Subsampled JPEG-LS is not supported";
+							return false;
+						}
+						frame.componentIds.push_back(segment[6 + i * 3]);
+					}
+
+					if (frame.precision < 2 || frame.precision > info.bitsAllocated)
+					{
+						error = "JPEG-LS precision " + std::to_string(frame.precision) + " does not fit the frame";
+						return false;
+					}
+					if (frame.rows != info.rows || frame.columns != info.columns ||
+						frame.componentIds.size() != info.samplesPerPixel || frame.componentIds.size() > 4)
+					{
+						error = "JPEG-LS dimensions do not match the image";
+						return false;
+					}
+					decoded.assign(frame.componentIds.size(), false);
+				}
+				else if ((marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) ||
+					marker == 0xF9)   // SOF57: JPEG-LS Part 2 extensions
+				{
+					error = "Not a JPEG-LS (SOF55) frame";
+					return false;
+				}
+				else if (marker == kLSE)
+				{
+					if (segmentLength < 3)
+					{
+						error = "Malformed JPEG-LS LSE segment";
+						return false;
+					}
+					if (segment[0] == 2 || segment[0] == 3)
+					{
+						error = "JPEG-LS mapping tables are not supported";
+						return false;
+					}
+					if (segment[0] != 1 || segmentLength != 13)
+					{
+						error = "Unsupported JPEG-LS LSE segment";
+						return false;
+					}
+					presets.maxValue = ReadUInt16BE(segment + 1);
+					presets.t1 = ReadUInt16BE(segment + 3);
+					presets.t2 = ReadUInt16BE(segment + 5);
+					presets.t3 = ReadUInt16BE(segment + 7);
+					presets.reset = ReadUInt16BE(segment + 9);
+				}
+				else if (marker == kDRI)
+				{
+					if (segmentLength != 4)
+					{
+						error = "Malformed JPEG DRI segment";
+						return false;
+					}
+					restartInterval = ReadUInt16BE(segment);
+				}
+				else if (marker == kSOS)
+				{
+					if (frame.componentIds.empty())
+					{
+						error = "JPEG scan before the frame header";
+						return false;
+					}
+
+					LsScan scan;
+					scan.componentCount = segment[0];
+					if (scan.componentCount == 0 || scan.componentCount > frame.componentIds.size() ||
+						segmentLength != 6 + 2 * scan.componentCount)
+					{
+						error = "Malformed JPEG SOS segment";
+						return false;
+					}
+					for (size_t k = 0; k < scan.componentCount; ++k)
+					{
+						uint8_t id = segment[1 + k * 2];
+						size_t c = 0;
+						while (c < frame.componentIds.size() && frame.componentIds[c] != id)
+						{
+							++c;
+						}
+						if (c == frame.componentIds.size())
+						{
+							error = "JPEG scan references an unknown component";
+							return false;
+						}
+						if (segment[2 + k * 2] != 0)
+						{
+							error = "JPEG-LS mapping tables are not supported";
+							return false;
+						}
+						scan.components[k] = c;
+						decoded[c] = true;
+					}
+
+					const uint8_t* parameters = segment + 1 + scan.componentCount * 2;
+					scan.near = parameters[0];
+					scan.interleave = parameters[1];
+					scan.restartInterval = restartInterval;
+					if (scan.interleave > 2 || (scan.interleave == 0 && scan.componentCount != 1))
+					{
+						error = "Invalid JPEG-LS interleave mode";
+						return false;
+					}
+					if ((parameters[2] & 0x0F) != 0)
+					{
+						error = "JPEG-LS point transform is not supported";
+						return false;
+					}
+
+					LsCoding coding;
+					if (!SetUpCoding(presets, frame.precision, scan.near, coding, error))
+					{
+						return false;
+					}
+
+					LsBitReader reader(data, length, position);
+					bool success = (info.bitsAllocated == 8)
+						? DecodeScan(reader, frame, scan, coding, output, error)
+						: DecodeScan(reader, frame, scan, coding, reinterpret_cast<uint16_t*>(output), error);
+					if (!success)
+					{
+						return false;
+					}
+					position = reader.GetPosition();
+				}
+				// APPn, COM and other segments are skipped
+			}
+
+			if (decoded.empty())
+			{
+				error = "JPEG data has no frame header";
+				return false;
+			}
+			for (bool componentDecoded : decoded)
+			{
+				if (!componentDecoded)
+				{
+					error = "JPEG data does not cover every component";
+					return false;
+				}
+			}
+			return true;
+		}
+
+	} // namespace dicom
+} // namespace medvision
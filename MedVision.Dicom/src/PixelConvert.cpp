@@ -0,0 +1,1172 @@
+#include "medvision/dicom/PixelConvert.h"
+#include "medvision/dicom/CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#ifdef MEDVISION_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+// GCC fuses the rescale multiply and add into FMA inside the AVX-512 kernels,
+// which rounds differently from the scalar reference for 32-bit samples
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		SampleLayout::SampleLayout()
+			: bitsStored(0)
+			, highBit(0)
+			, isSigned(false)
+			, bigEndian(false)
+			, hasPadding(false)
+			, paddingValue(0)
+			, paddingLimit(0)
+			, paddingOutput(0.0f)
+		{
+		}
+
+		SampleLayout::SampleLayout(uint16_t bitsStoredValue, uint16_t highBitValue, bool isSignedValue)
+			: bitsStored(bitsStoredValue)
+			, highBit(highBitValue)
+			, isSigned(isSignedValue)
+			, bigEndian(false)
+			, hasPadding(false)
+			, paddingValue(0)
+			, paddingLimit(0)
+			, paddingOutput(0.0f)
+		{
+		}
+
+		namespace
+		{
+			/// Largest |intercept| for which value + intercept (values are at
+			/// most 16 bits) stays within the exact integer range of float
+			const double MaxExactOffset = 16777216.0 - 65536.0;
+
+			/// Unsigned 32-bit values are biased by 2^31 to fit the signed
+			/// conversions; adding it back in double precision is exact
+			const double Unsigned32Bias = 2147483648.0;
+
+			/// Stored bits of layout, or the whole container if they do not fit
+			void GetStoredBits(const SampleLayout& layout, int containerBits, int& bitsStored, int& highBit)
+			{
+				bitsStored = layout.bitsStored;
+				highBit = layout.highBit;
+				if (bitsStored == 0 || bitsStored > containerBits || highBit >= containerBits || highBit + 1 < bitsStored)
+				{
+					bitsStored = containerBits;
+					highBit = containerBits - 1;
+				}
+			}
+
+			/// A SampleLayout and rescale resolved once per call. Unpacking is
+			/// branch free: ((sample >> shift) & mask), then (v ^ sign) - sign
+			/// sign extends when sign is the top stored bit and is a no-op at 0.
+			/// Full 32-bit unsigned values convert as v ^ flip (v - 2^31) with
+			/// bias added back in double precision; padding compares the raw bits.
+			/// Big endian samples are byte swapped as 32-bit values first, which
+			/// leaves a 16-bit sample in the top half: shift grows to match.
+			struct Params
+			{
+				bool swap;
+				int32_t shift;
+				int32_t mask;
+				int32_t sign;
+				int32_t flip;
+				double bias;
+
+				double slope;
+				double intercept;
+				bool integral;      // Slope 1 and an integral intercept: add offset
+				int32_t offset;
+
+				bool padding;
+				int32_t paddingLow;
+				int32_t paddingHigh;
+				float paddingOutput;
+
+				Params(const SampleLayout& layout, int containerBits, double slopeValue, double interceptValue)
+					: slope(slopeValue)
+					, intercept(interceptValue)
+					, integral(containerBits <= 16 && slopeValue == 1.0 && std::floor(interceptValue) == interceptValue
+						&& std::fabs(interceptValue) <= MaxExactOffset)
+					, offset(integral ? static_cast<int32_t>(interceptValue) : 0)
+					, padding(layout.hasPadding)
+					, paddingLow(std::min(layout.paddingValue, layout.paddingLimit))
+					, paddingHigh(std::max(layout.paddingValue, layout.paddingLimit))
+					, paddingOutput(layout.paddingOutput)
+				{
+					int bitsStored;
+					int highBit;
+					GetStoredBits(layout, containerBits, bitsStored, highBit);
+					swap = layout.bigEndian && containerBits > 8;
+					shift = highBit + 1 - bitsStored + (swap ? 32 - containerBits : 0);
+					mask = static_cast<int32_t>(static_cast<uint32_t>((static_cast<uint64_t>(1) << bitsStored) - 1));
+					sign = layout.isSigned ? static_cast<int32_t>(1u << (bitsStored - 1)) : 0;
+					bool unsigned32 = !layout.isSigned && bitsStored == 32;
+					flip = unsigned32 ? static_cast<int32_t>(0x80000000u) : 0;
+					bias = unsigned32 ? Unsigned32Bias : 0.0;
+				}
+
+				int32_t Unpack(uint32_t sample) const
+				{
+					if (swap)
+					{
+						sample = (sample << 24) | ((sample << 8) & 0xFF0000) | ((sample >> 8) & 0xFF00) | (sample >> 24);
+					}
+					uint32_t value = (sample >> shift) & static_cast<uint32_t>(mask);
+					return static_cast<int32_t>((value ^ static_cast<uint32_t>(sign)) - static_cast<uint32_t>(sign));
+				}
+
+				double ToDouble(int32_t value) const
+				{
+					return static_cast<double>(value ^ flip) + bias;
+				}
+			};
+
+			/// Scalar loads go through memcpy, so input needs no particular alignment
+			template <typename T>
+			T Load(const T* input)
+			{
+				T value;
+				std::memcpy(&value, input, sizeof(T));
+				return value;
+			}
+
+			template <typename T>
+			bool IsWide()
+			{
+				return std::is_same<T, uint32_t>::value;
+			}
+
+			// The reference every kernel must match bit for bit; in the integral
+			// case the sum is exact, so it equals the double precision result
+			template <bool Padding>
+			float Pad(int32_t value, float result, const Params& params)
+			{
+				return Padding && value >= params.paddingLow && value <= params.paddingHigh ? params.paddingOutput : result;
+			}
+
+			template <typename T, bool Padding>
+			void ConvertScalar(const T* input, size_t count, const Params& params, float* output)
+			{
+				if (params.integral)
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						int32_t value = params.Unpack(Load(input + i));
+						output[i] = Pad<Padding>(value, static_cast<float>(value + params.offset), params);
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						int32_t value = params.Unpack(Load(input + i));
+						double scaled = params.ToDouble(value) * params.slope;
+						output[i] = Pad<Padding>(value, static_cast<float>(scaled + params.intercept), params);
+					}
+				}
+			}
+
+			/// Float and Double Float Pixel Data: rescale only
+			template <typename T>
+			void ConvertRealScalar(const T* input, size_t count, const Params& params, float* output)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					double scaled = static_cast<double>(Load(input + i)) * params.slope;
+					output[i] = static_cast<float>(scaled + params.intercept);
+				}
+			}
+
+			/// A kernel converts a prefix of the input and returns its length;
+			/// ConvertScalar finishes the rest
+			template <typename T>
+			using Kernel = size_t(*)(const T*, size_t, const Params&, float*);
+
+			template <typename T, bool Padding, bool Swap>
+			size_t ConvertNone(const T*, size_t, const Params&, float*)
+			{
+				return 0;
+			}
+
+			template <typename T>
+			size_t ConvertRealNone(const T*, size_t, const Params&, float*)
+			{
+				return 0;
+			}
+
+			/// Integer narrowing: clamp like maxps/minps (NaN takes the lower
+			/// bound), then round to nearest even as cvtps2dq does by default
+			template <typename T>
+			T NarrowInteger(float value)
+			{
+				const float low = static_cast<float>(std::numeric_limits<T>::min());
+				const float high = static_cast<float>(std::numeric_limits<T>::max());
+				value = value > low ? value : low;
+				value = value < high ? value : high;
+				return static_cast<T>(std::nearbyint(value));
+			}
+
+			/// IEEE binary16 with round to nearest even, as vcvtps2ph produces
+			/// it: NaNs stay quiet NaNs keeping their top payload bits
+			Half NarrowHalf(float value)
+			{
+				uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+				uint32_t magnitude = bits & 0x7FFFFFFF;
+				Half half;
+				if (magnitude >= 0x7F800000)
+				{
+					uint32_t payload = magnitude > 0x7F800000 ? 0x200 | ((magnitude >> 13) & 0x3FF) : 0;
+					half.bits = static_cast<uint16_t>(sign | 0x7C00 | payload);
+				}
+				else if (magnitude >= 0x477FF000)
+				{
+					// 65520 and above round past the largest half (65504)
+					half.bits = static_cast<uint16_t>(sign | 0x7C00);
+				}
+				else if (magnitude >= 0x38800000)
+				{
+					// Normal: rebias the exponent from 127 to 15, round off 13 bits
+					uint32_t rebiased = magnitude - 0x38000000;
+					rebiased += 0xFFF + ((rebiased >> 13) & 1);
+					half.bits = static_cast<uint16_t>(sign | (rebiased >> 13));
+				}
+				else if (magnitude > 0x33000000)
+				{
+					// Subnormal: round the value in units of 2^-24
+					uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+					uint32_t shift = 126 - (magnitude >> 23);
+					uint32_t result = mantissa >> shift;
+					uint32_t rest = mantissa & ((1u << shift) - 1);
+					uint32_t halfway = 1u << (shift - 1);
+					if (rest > halfway || (rest == halfway && (result & 1) != 0))
+					{
+						++result;
+					}
+					half.bits = static_cast<uint16_t>(sign | result);
+				}
+				else
+				{
+					// At most 2^-25: rounds to zero
+					half.bits = sign;
+				}
+				return half;
+			}
+
+			/// A narrowing kernel converts a prefix and returns its length
+			template <typename T>
+			using NarrowKernel = size_t(*)(const float*, size_t, T*);
+
+			template <typename T>
+			size_t NarrowNone(const float*, size_t, T*)
+			{
+				return 0;
+			}
+
+			template <typename T>
+			void NarrowScalar(const float* input, size_t count, T* output)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					output[i] = NarrowInteger<T>(input[i]);
+				}
+			}
+
+			void NarrowScalar(const float* input, size_t count, Half* output)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					output[i] = NarrowHalf(input[i]);
+				}
+			}
+
+#ifdef MEDVISION_X86
+			// Multiply and add stay separate instructions throughout: a fused
+			// multiply-add rounds once and would not match the scalar reference.
+
+			// SSE2: 8 samples per step as two vectors of 32-bit integers
+			inline void WidenSse2(const uint8_t* input, __m128i& low, __m128i& high)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				__m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input)), zero);
+				low = _mm_unpacklo_epi16(words, zero);
+				high = _mm_unpackhi_epi16(words, zero);
+			}
+
+			inline void WidenSse2(const uint16_t* input, __m128i& low, __m128i& high)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				__m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+				low = _mm_unpacklo_epi16(words, zero);
+				high = _mm_unpackhi_epi16(words, zero);
+			}
+
+			inline void WidenSse2(const uint32_t* input, __m128i& low, __m128i& high)
+			{
+				low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+				high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 4));
+			}
+
+			struct UnpackSse2
+			{
+				__m128i shift;
+				__m128i mask;
+				__m128i sign;
+				__m128i flip;
+				__m128i paddingLow;
+				__m128i paddingHigh;
+				__m128 paddingOutput;
+
+				explicit UnpackSse2(const Params& params)
+					: shift(_mm_cvtsi32_si128(params.shift))
+					, mask(_mm_set1_epi32(params.mask))
+					, sign(_mm_set1_epi32(params.sign))
+					, flip(_mm_set1_epi32(params.flip))
+					, paddingLow(_mm_set1_epi32(params.paddingLow))
+					, paddingHigh(_mm_set1_epi32(params.paddingHigh))
+					, paddingOutput(_mm_set1_ps(params.paddingOutput))
+				{
+				}
+
+				template <bool Swap>
+				__m128i Unpack(__m128i samples) const
+				{
+					if (Swap)
+					{
+						// Swap the 16-bit halves, then the bytes of each half
+						samples = _mm_shufflehi_epi16(_mm_shufflelo_epi16(samples, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+						samples = _mm_or_si128(_mm_slli_epi16(samples, 8), _mm_srli_epi16(samples, 8));
+					}
+					__m128i value = _mm_and_si128(_mm_srl_epi32(samples, shift), mask);
+					return _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+				}
+
+				__m128i Flip(__m128i values) const
+				{
+					return _mm_xor_si128(values, flip);
+				}
+
+				__m128 Pad(__m128i values, __m128 result) const
+				{
+					__m128 outside = _mm_castsi128_ps(_mm_or_si128(
+						_mm_cmplt_epi32(values, paddingLow), _mm_cmpgt_epi32(values, paddingHigh)));
+					return _mm_or_ps(_mm_and_ps(outside, result), _mm_andnot_ps(outside, paddingOutput));
+				}
+			};
+
+			inline __m128 RescaleSse2(__m128i values, __m128d slope, __m128d intercept)
+			{
+				__m128d low = _mm_cvtepi32_pd(values);
+				__m128d high = _mm_cvtepi32_pd(_mm_shuffle_epi32(values, _MM_SHUFFLE(1, 0, 3, 2)));
+				low = _mm_add_pd(_mm_mul_pd(low, slope), intercept);
+				high = _mm_add_pd(_mm_mul_pd(high, slope), intercept);
+				return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+			}
+
+			// 32-bit samples: flipped values get the bias back before the rescale
+			inline __m128 RescaleSse2(__m128i values, __m128d bias, __m128d slope, __m128d intercept)
+			{
+				__m128d low = _mm_add_pd(_mm_cvtepi32_pd(values), bias);
+				__m128d high = _mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(values, _MM_SHUFFLE(1, 0, 3, 2))), bias);
+				low = _mm_add_pd(_mm_mul_pd(low, slope), intercept);
+				high = _mm_add_pd(_mm_mul_pd(high, slope), intercept);
+				return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+			}
+
+			template <typename T, bool Padding, bool Swap>
+			size_t ConvertSse2(const T* input, size_t count, const Params& params, float* output)
+			{
+				const UnpackSse2 unpack(params);
+				size_t i = 0;
+				__m128i low;
+				__m128i high;
+				if (params.integral)
+				{
+					const __m128i offset = _mm_set1_epi32(params.offset);
+					for (; i + 8 <= count; i += 8)
+					{
+						WidenSse2(input + i, low, high);
+						low = unpack.Unpack<Swap>(low);
+						high = unpack.Unpack<Swap>(high);
+						__m128 lowResult = _mm_cvtepi32_ps(_mm_add_epi32(low, offset));
+						__m128 highResult = _mm_cvtepi32_ps(_mm_add_epi32(high, offset));
+						if (Padding)
+						{
+							lowResult = unpack.Pad(low, lowResult);
+							highResult = unpack.Pad(high, highResult);
+						}
+						_mm_storeu_ps(output + i, lowResult);
+						_mm_storeu_ps(output + i + 4, highResult);
+					}
+				}
+				else
+				{
+					const __m128d bias = _mm_set1_pd(params.bias);
+					const __m128d slope = _mm_set1_pd(params.slope);
+					const __m128d intercept = _mm_set1_pd(params.intercept);
+					for (; i + 8 <= count; i += 8)
+					{
+						WidenSse2(input + i, low, high);
+						low = unpack.Unpack<Swap>(low);
+						high = unpack.Unpack<Swap>(high);
+						__m128 lowResult = IsWide<T>() ? RescaleSse2(unpack.Flip(low), bias, slope, intercept) : RescaleSse2(low, slope, intercept);
+						__m128 highResult = IsWide<T>() ? RescaleSse2(unpack.Flip(high), bias, slope, intercept) : RescaleSse2(high, slope, intercept);
+						if (Padding)
+						{
+							lowResult = unpack.Pad(low, lowResult);
+							highResult = unpack.Pad(high, highResult);
+						}
+						_mm_storeu_ps(output + i, lowResult);
+						_mm_storeu_ps(output + i + 4, highResult);
+					}
+				}
+				return i;
+			}
+
+			// AVX2: 8 samples per step
+			MEDVISION_TARGET("avx2")
+			inline __m256i WidenAvx2(const uint8_t* input)
+			{
+				return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input)));
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline __m256i WidenAvx2(const uint16_t* input)
+			{
+				return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)));
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline __m256i WidenAvx2(const uint32_t* input)
+			{
+				return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline __m256 RescaleAvx2(__m256i values, __m256d slope, __m256d intercept)
+			{
+				__m256d low = _mm256_cvtepi32_pd(_mm256_castsi256_si128(values));
+				__m256d high = _mm256_cvtepi32_pd(_mm256_extracti128_si256(values, 1));
+				low = _mm256_add_pd(_mm256_mul_pd(low, slope), intercept);
+				high = _mm256_add_pd(_mm256_mul_pd(high, slope), intercept);
+				return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline __m256 RescaleAvx2(__m256i values, __m256d bias, __m256d slope, __m256d intercept)
+			{
+				__m256d low = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(values)), bias);
+				__m256d high = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(values, 1)), bias);
+				low = _mm256_add_pd(_mm256_mul_pd(low, slope), intercept);
+				high = _mm256_add_pd(_mm256_mul_pd(high, slope), intercept);
+				return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+			}
+
+			struct UnpackAvx2
+			{
+				__m128i shift;
+				__m256i mask;
+				__m256i sign;
+				__m256i flip;
+				__m256i paddingLow;
+				__m256i paddingHigh;
+				__m256 paddingOutput;
+
+				MEDVISION_TARGET("avx2")
+				explicit UnpackAvx2(const Params& params)
+					: shift(_mm_cvtsi32_si128(params.shift))
+					, mask(_mm256_set1_epi32(params.mask))
+					, sign(_mm256_set1_epi32(params.sign))
+					, flip(_mm256_set1_epi32(params.flip))
+					, paddingLow(_mm256_set1_epi32(params.paddingLow))
+					, paddingHigh(_mm256_set1_epi32(params.paddingHigh))
+					, paddingOutput(_mm256_set1_ps(params.paddingOutput))
+				{
+				}
+
+				template <bool Swap>
+				MEDVISION_TARGET("avx2")
+				__m256i Unpack(__m256i samples) const
+				{
+					if (Swap)
+					{
+						const __m256i reverse = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+							3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+						samples = _mm256_shuffle_epi8(samples, reverse);
+					}
+					__m256i value = _mm256_and_si256(_mm256_srl_epi32(samples, shift), mask);
+					return _mm256_sub_epi32(_mm256_xor_si256(value, sign), sign);
+				}
+
+				MEDVISION_TARGET("avx2")
+				__m256i Flip(__m256i values) const
+				{
+					return _mm256_xor_si256(values, flip);
+				}
+
+				MEDVISION_TARGET("avx2")
+				__m256 Pad(__m256i values, __m256 result) const
+				{
+					__m256i outside = _mm256_or_si256(
+						_mm256_cmpgt_epi32(paddingLow, values), _mm256_cmpgt_epi32(values, paddingHigh));
+					return _mm256_blendv_ps(paddingOutput, result, _mm256_castsi256_ps(outside));
+				}
+			};
+
+			template <typename T, bool Padding, bool Swap>
+			MEDVISION_TARGET("avx2")
+			size_t ConvertAvx2(const T* input, size_t count, const Params& params, float* output)
+			{
+				const UnpackAvx2 unpack(params);
+				size_t i = 0;
+				if (params.integral)
+				{
+					const __m256i offset = _mm256_set1_epi32(params.offset);
+					for (; i + 8 <= count; i += 8)
+					{
+						__m256i values = unpack.Unpack<Swap>(WidenAvx2(input + i));
+						__m256 result = _mm256_cvtepi32_ps(_mm256_add_epi32(values, offset));
+						if (Padding)
+						{
+							result = unpack.Pad(values, result);
+						}
+						_mm256_storeu_ps(output + i, result);
+					}
+				}
+				else
+				{
+					const __m256d bias = _mm256_set1_pd(params.bias);
+					const __m256d slope = _mm256_set1_pd(params.slope);
+					const __m256d intercept = _mm256_set1_pd(params.intercept);
+					for (; i + 8 <= count; i += 8)
+					{
+						__m256i values = unpack.Unpack<Swap>(WidenAvx2(input + i));
+						__m256 result = IsWide<T>() ? RescaleAvx2(unpack.Flip(values), bias, slope, intercept) : RescaleAvx2(values, slope, intercept);
+						if (Padding)
+						{
+							result = unpack.Pad(values, result);
+						}
+						_mm256_storeu_ps(output + i, result);
+					}
+				}
+				return i;
+			}
+
+			// AVX-512: 16 samples per step
+			MEDVISION_TARGET("avx512f")
+			inline __m512i WidenAvx512(const uint8_t* input)
+			{
+				return _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)));
+			}
+
+			MEDVISION_TARGET("avx512f")
+			inline __m512i WidenAvx512(const uint16_t* input)
+			{
+				return _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input)));
+			}
+
+			MEDVISION_TARGET("avx512f")
+			inline __m512i WidenAvx512(const uint32_t* input)
+			{
+				return _mm512_loadu_si512(input);
+			}
+
+			struct UnpackAvx512
+			{
+				__m128i shift;
+				__m512i mask;
+				__m512i sign;
+				__m512i flip;
+				__m512i paddingLow;
+				__m512i paddingHigh;
+				__m512 paddingOutput;
+
+				MEDVISION_TARGET("avx512f")
+				explicit UnpackAvx512(const Params& params)
+					: shift(_mm_cvtsi32_si128(params.shift))
+					, mask(_mm512_set1_epi32(params.mask))
+					, sign(_mm512_set1_epi32(params.sign))
+					, flip(_mm512_set1_epi32(params.flip))
+					, paddingLow(_mm512_set1_epi32(params.paddingLow))
+					, paddingHigh(_mm512_set1_epi32(params.paddingHigh))
+					, paddingOutput(_mm512_set1_ps(params.paddingOutput))
+				{
+				}
+
+				template <bool Swap>
+				MEDVISION_TARGET("avx512f")
+				__m512i Unpack(__m512i samples) const
+				{
+					if (Swap)
+					{
+						// AVX-512F has no byte shuffle: rotate the halves, then swap
+						// the bytes of each half with masked shifts
+						const __m512i high = _mm512_set1_epi32(static_cast<int>(0xFF00FF00u));
+						samples = _mm512_rol_epi32(samples, 16);
+						samples = _mm512_or_si512(_mm512_and_si512(_mm512_slli_epi32(samples, 8), high),
+							_mm512_andnot_si512(high, _mm512_srli_epi32(samples, 8)));
+					}
+					__m512i value = _mm512_and_si512(_mm512_srl_epi32(samples, shift), mask);
+					return _mm512_sub_epi32(_mm512_xor_si512(value, sign), sign);
+				}
+
+				MEDVISION_TARGET("avx512f")
+				__m512i Flip(__m512i values) const
+				{
+					return _mm512_xor_si512(values, flip);
+				}
+
+				MEDVISION_TARGET("avx512f")
+				__m512 Pad(__m512i values, __m512 result) const
+				{
+					__mmask16 inside = _mm512_cmpge_epi32_mask(values, paddingLow) & _mm512_cmple_epi32_mask(values, paddingHigh);
+					return _mm512_mask_mov_ps(result, inside, paddingOutput);
+				}
+			};
+
+			MEDVISION_TARGET("avx512f")
+			inline __m512 RescaleAvx512(__m512i values, __m512d slope, __m512d intercept)
+			{
+				__m512d low = _mm512_cvtepi32_pd(_mm512_castsi512_si256(values));
+				__m512d high = _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(values, 1));
+				low = _mm512_add_pd(_mm512_mul_pd(low, slope), intercept);
+				high = _mm512_add_pd(_mm512_mul_pd(high, slope), intercept);
+				__m256d lowResult = _mm256_castps_pd(_mm512_cvtpd_ps(low));
+				__m256d highResult = _mm256_castps_pd(_mm512_cvtpd_ps(high));
+				return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(lowResult), highResult, 1));
+			}
+
+			MEDVISION_TARGET("avx512f")
+			inline __m512 RescaleAvx512(__m512i values, __m512d bias, __m512d slope, __m512d intercept)
+			{
+				__m512d low = _mm512_add_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(values)), bias);
+				__m512d high = _mm512_add_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(values, 1)), bias);
+				low = _mm512_add_pd(_mm512_mul_pd(low, slope), intercept);
+				high = _mm512_add_pd(_mm512_mul_pd(high, slope), intercept);
+				__m256d lowResult = _mm256_castps_pd(_mm512_cvtpd_ps(low));
+				__m256d highResult = _mm256_castps_pd(_mm512_cvtpd_ps(high));
+				return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(lowResult), highResult, 1));
+			}
+
+			template <typename T, bool Padding, bool Swap>
+			MEDVISION_TARGET("avx512f")
+			size_t ConvertAvx512(const T* input, size_t count, const Params& params, float* output)
+			{
+				const UnpackAvx512 unpack(params);
+				size_t i = 0;
+				if (params.integral)
+				{
+					const __m512i offset = _mm512_set1_epi32(params.offset);
+					for (; i + 16 <= count; i += 16)
+					{
+						__m512i values = unpack.Unpack<Swap>(WidenAvx512(input + i));
+						__m512 result = _mm512_cvtepi32_ps(_mm512_add_epi32(values, offset));
+						if (Padding)
+						{
+							result = unpack.Pad(values, result);
+						}
+						_mm512_storeu_ps(output + i, result);
+					}
+				}
+				else
+				{
+					const __m512d bias = _mm512_set1_pd(params.bias);
+					const __m512d slope = _mm512_set1_pd(params.slope);
+					const __m512d intercept = _mm512_set1_pd(params.intercept);
+					for (; i + 16 <= count; i += 16)
+					{
+						__m512i values = unpack.Unpack<Swap>(WidenAvx512(input + i));
+						__m512 result = IsWide<T>() ? RescaleAvx512(unpack.Flip(values), bias, slope, intercept) : RescaleAvx512(values, slope, intercept);
+						if (Padding)
+						{
+							result = unpack.Pad(values, result);
+						}
+						_mm512_storeu_ps(output + i, result);
+					}
+				}
+				return i;
+			}
+
+			// Float and Double Float Pixel Data: widened to (or loaded as) double,
+			// rescaled and narrowed like the integer kernels
+			inline void LoadSse2(const float* input, __m128d& low, __m128d& high)
+			{
+				__m128 values = _mm_loadu_ps(input);
+				low = _mm_cvtps_pd(values);
+				high = _mm_cvtps_pd(_mm_movehl_ps(values, values));
+			}
+
+			inline void LoadSse2(const double* input, __m128d& low, __m128d& high)
+			{
+				low = _mm_loadu_pd(input);
+				high = _mm_loadu_pd(input + 2);
+			}
+
+			template <typename T>
+			size_t ConvertRealSse2(const T* input, size_t count, const Params& params, float* output)
+			{
+				const __m128d slope = _mm_set1_pd(params.slope);
+				const __m128d intercept = _mm_set1_pd(params.intercept);
+				size_t i = 0;
+				for (; i + 4 <= count; i += 4)
+				{
+					__m128d low;
+					__m128d high;
+					LoadSse2(input + i, low, high);
+					low = _mm_add_pd(_mm_mul_pd(low, slope), intercept);
+					high = _mm_add_pd(_mm_mul_pd(high, slope), intercept);
+					_mm_storeu_ps(output + i, _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)));
+				}
+				return i;
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline void LoadAvx2(const float* input, __m256d& low, __m256d& high)
+			{
+				__m256 values = _mm256_loadu_ps(input);
+				low = _mm256_cvtps_pd(_mm256_castps256_ps128(values));
+				high = _mm256_cvtps_pd(_mm256_extractf128_ps(values, 1));
+			}
+
+			MEDVISION_TARGET("avx2")
+			inline void LoadAvx2(const double* input, __m256d& low, __m256d& high)
+			{
+				low = _mm256_loadu_pd(input);
+				high = _mm256_loadu_pd(input + 4);
+			}
+
+			template <typename T>
+			MEDVISION_TARGET("avx2")
+			size_t ConvertRealAvx2(const T* input, size_t count, const Params& params, float* output)
+			{
+				const __m256d slope = _mm256_set1_pd(params.slope);
+				const __m256d intercept = _mm256_set1_pd(params.intercept);
+				size_t i = 0;
+				for (; i + 8 <= count; i += 8)
+				{
+					__m256d low;
+					__m256d high;
+					LoadAvx2(input + i, low, high);
+					low = _mm256_add_pd(_mm256_mul_pd(low, slope), intercept);
+					high = _mm256_add_pd(_mm256_mul_pd(high, slope), intercept);
+					_mm256_storeu_ps(output + i, _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1));
+				}
+				return i;
+			}
+
+			MEDVISION_TARGET("avx512f")
+			inline void LoadAvx512(const float* input, __m512d& low, __m512d& high)
+			{
+				__m512 values = _mm512_loadu_ps(input);
+				low = _mm512_cvtps_pd(_mm512_castps512_ps256(values));
+				high = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(values), 1)));
+			}
+
+			MEDVISION_TARGET("avx512f")
+			inline void LoadAvx512(const double* input, __m512d& low, __m512d& high)
+			{
+				low = _mm512_loadu_pd(input);
+				high = _mm512_loadu_pd(input + 8);
+			}
+
+			template <typename T>
+			MEDVISION_TARGET("avx512f")
+			size_t ConvertRealAvx512(const T* input, size_t count, const Params& params, float* output)
+			{
+				const __m512d slope = _mm512_set1_pd(params.slope);
+				const __m512d intercept = _mm512_set1_pd(params.intercept);
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					__m512d low;
+					__m512d high;
+					LoadAvx512(input + i, low, high);
+					low = _mm512_add_pd(_mm512_mul_pd(low, slope), intercept);
+					high = _mm512_add_pd(_mm512_mul_pd(high, slope), intercept);
+					__m256d lowResult = _mm256_castps_pd(_mm512_cvtpd_ps(low));
+					__m256d highResult = _mm256_castps_pd(_mm512_cvtpd_ps(high));
+					_mm512_storeu_ps(output + i, _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(lowResult), highResult, 1)));
+				}
+				return i;
+			}
+
+			// Narrowing: clamp to the target range in float (maxps first, so NaN
+			// becomes the lower bound), convert with rounding to nearest even and
+			// pack; the clamp keeps cvtps2dq clear of its out-of-range result
+			size_t NarrowSse2(const float* input, size_t count, int16_t* output)
+			{
+				const __m128 low = _mm_set1_ps(-32768.0f);
+				const __m128 high = _mm_set1_ps(32767.0f);
+				size_t i = 0;
+				for (; i + 8 <= count; i += 8)
+				{
+					__m128i first = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i), low), high));
+					__m128i second = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i + 4), low), high));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(first, second));
+				}
+				return i;
+			}
+
+			size_t NarrowSse2(const float* input, size_t count, uint16_t* output)
+			{
+				// SSE2 has only the signed pack: shift into int16 range and back
+				const __m128 low = _mm_setzero_ps();
+				const __m128 high = _mm_set1_ps(65535.0f);
+				const __m128i offset = _mm_set1_epi32(32768);
+				const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+				size_t i = 0;
+				for (; i + 8 <= count; i += 8)
+				{
+					__m128i first = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i), low), high));
+					__m128i second = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i + 4), low), high));
+					__m128i packed = _mm_packs_epi32(_mm_sub_epi32(first, offset), _mm_sub_epi32(second, offset));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_xor_si128(packed, flip));
+				}
+				return i;
+			}
+
+			MEDVISION_TARGET("avx2")
+			size_t NarrowAvx2(const float* input, size_t count, int16_t* output)
+			{
+				const __m256 low = _mm256_set1_ps(-32768.0f);
+				const __m256 high = _mm256_set1_ps(32767.0f);
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					__m256i first = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input + i), low), high));
+					__m256i second = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input + i + 8), low), high));
+					// The pack works per 128-bit lane; restore the element order
+					__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+				}
+				return i;
+			}
+
+			MEDVISION_TARGET("avx2")
+			size_t NarrowAvx2(const float* input, size_t count, uint16_t* output)
+			{
+				const __m256 low = _mm256_setzero_ps();
+				const __m256 high = _mm256_set1_ps(65535.0f);
+				size_t i = 0;
+				for (; i + 16 <= count; i += 16)
+				{
+					__m256i first = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input + i), low), high));
+					__m256i second = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input + i + 8), low), high));
+					__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+				}
+				return i;
+			}
+
+			// F16C: 8 values per step, rounded to nearest even
+			MEDVISION_TARGET("f16c")
+			size_t NarrowF16c(const float* input, size_t count, Half* output)
+			{
+				size_t i = 0;
+				for (; i + 8 <= count; i += 8)
+				{
+					__m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), halves);
+				}
+				return i;
+			}
+#endif
+
+			/// Kernels per container type, indexed by whether padding is checked
+			struct KernelTable
+			{
+				const char* name;
+				Kernel<uint8_t> unsigned8[2];
+				Kernel<uint16_t> unsigned16[2][2];   // [swap][padding]
+				Kernel<uint32_t> unsigned32[2][2];
+				Kernel<float> real32;
+				Kernel<double> real64;
+				NarrowKernel<int16_t> int16;
+				NarrowKernel<uint16_t> uint16;
+				NarrowKernel<Half> half;
+			};
+
+			KernelTable SelectKernels()
+			{
+#ifdef MEDVISION_X86
+				// Narrowing is load/store bound; AVX2 is as fast as it gets
+				NarrowKernel<Half> half = CpuFeatures::HasF16C() ? &NarrowF16c : &NarrowNone<Half>;
+				if (CpuFeatures::HasAVX512F())
+				{
+					return { "AVX-512",
+						{ &ConvertAvx512<uint8_t, false, false>, &ConvertAvx512<uint8_t, true, false> },
+						{ { &ConvertAvx512<uint16_t, false, false>, &ConvertAvx512<uint16_t, true, false> },
+							{ &ConvertAvx512<uint16_t, false, true>, &ConvertAvx512<uint16_t, true, true> } },
+						{ { &ConvertAvx512<uint32_t, false, false>, &ConvertAvx512<uint32_t, true, false> },
+							{ &ConvertAvx512<uint32_t, false, true>, &ConvertAvx512<uint32_t, true, true> } },
+						&ConvertRealAvx512<float>, &ConvertRealAvx512<double>,
+						&NarrowAvx2, &NarrowAvx2, half };
+				}
+				if (CpuFeatures::HasAVX2())
+				{
+					return { "AVX2",
+						{ &ConvertAvx2<uint8_t, false, false>, &ConvertAvx2<uint8_t, true, false> },
+						{ { &ConvertAvx2<uint16_t, false, false>, &ConvertAvx2<uint16_t, true, false> },
+							{ &ConvertAvx2<uint16_t, false, true>, &ConvertAvx2<uint16_t, true, true> } },
+						{ { &ConvertAvx2<uint32_t, false, false>, &ConvertAvx2<uint32_t, true, false> },
+							{ &ConvertAvx2<uint32_t, false, true>, &ConvertAvx2<uint32_t, true, true> } },
+						&ConvertRealAvx2<float>, &ConvertRealAvx2<double>,
+						&NarrowAvx2, &NarrowAvx2, half };
+				}
+				return { "SSE2",
+					{ &ConvertSse2<uint8_t, false, false>, &ConvertSse2<uint8_t, true, false> },
+					{ { &ConvertSse2<uint16_t, false, false>, &ConvertSse2<uint16_t, true, false> },
+						{ &ConvertSse2<uint16_t, false, true>, &ConvertSse2<uint16_t, true, true> } },
+					{ { &ConvertSse2<uint32_t, false, false>, &ConvertSse2<uint32_t, true, false> },
+						{ &ConvertSse2<uint32_t, false, true>, &ConvertSse2<uint32_t, true, true> } },
+					&ConvertRealSse2<float>, &ConvertRealSse2<double>,
+					&NarrowSse2, &NarrowSse2, half };
+#else
+				return { "Scalar",
+					{ &ConvertNone<uint8_t, false, false>, &ConvertNone<uint8_t, true, false> },
+					{ { &ConvertNone<uint16_t, false, false>, &ConvertNone<uint16_t, true, false> },
+						{ &ConvertNone<uint16_t, false, true>, &ConvertNone<uint16_t, true, true> } },
+					{ { &ConvertNone<uint32_t, false, false>, &ConvertNone<uint32_t, true, false> },
+						{ &ConvertNone<uint32_t, false, true>, &ConvertNone<uint32_t, true, true> } },
+					&ConvertRealNone<float>, &ConvertRealNone<double>,
+					&NarrowNone<int16_t>, &NarrowNone<uint16_t>, &NarrowNone<Half> };
+#endif
+			}
+
+			const KernelTable& GetKernels()
+			{
+				static const KernelTable kernels = SelectKernels();
+				return kernels;
+			}
+
+			template <typename T>
+			void Convert(const Kernel<T> (&kernels)[2], const T* input, size_t count, const Params& params, float* output)
+			{
+				size_t done = kernels[params.padding ? 1 : 0](input, count, params, output);
+				if (params.padding)
+				{
+					ConvertScalar<T, true>(input + done, count - done, params, output + done);
+				}
+				else
+				{
+					ConvertScalar<T, false>(input + done, count - done, params, output + done);
+				}
+			}
+
+			template <typename T>
+			void Convert(const Kernel<T> (&kernels)[2][2], const T* input, size_t count, const Params& params, float* output)
+			{
+				Convert(kernels[params.swap ? 1 : 0], input, count, params, output);
+			}
+
+			template <typename T>
+			void ConvertReal(Kernel<T> kernel, const T* input, size_t count, const Params& params, float* output)
+			{
+				size_t done = kernel(input, count, params, output);
+				ConvertRealScalar(input + done, count - done, params, output + done);
+			}
+
+			/// Samples staged per step when raw bytes are not aligned for T
+			const size_t StagingCount = 1024;
+
+			/// Hands convert(input, count, first) the bytes as T samples: in place when
+			/// they are aligned for T, otherwise copied in chunks to an aligned buffer
+			template <typename T, typename Function>
+			void ForEachAligned(const uint8_t* bytes, size_t count, Function convert)
+			{
+				if (reinterpret_cast<uintptr_t>(bytes) % alignof(T) == 0)
+				{
+					convert(reinterpret_cast<const T*>(bytes), count, static_cast<size_t>(0));
+					return;
+				}
+				T staging[StagingCount];
+				for (size_t first = 0; first < count; first += StagingCount)
+				{
+					size_t chunk = std::min(StagingCount, count - first);
+					std::memcpy(staging, bytes + first * sizeof(T), chunk * sizeof(T));
+					convert(static_cast<const T*>(staging), chunk, first);
+				}
+			}
+
+			template <typename T>
+			void Narrow(NarrowKernel<T> kernel, const float* input, size_t count, T* output)
+			{
+				size_t done = kernel(input, count, output);
+				NarrowScalar(input + done, count - done, output + done);
+			}
+		}
+
+		void PixelConvert::ToFloat(const uint8_t* input, size_t count, const SampleLayout& layout,
+			double slope, double intercept, float* output)
+		{
+			Convert(GetKernels().unsigned8, input, count, Params(layout, 8, slope, intercept), output);
+		}
+
+		void PixelConvert::ToFloat(const uint16_t* input, size_t count, const SampleLayout& layout,
+			double slope, double intercept, float* output)
+		{
+			Convert(GetKernels().unsigned16, input, count, Params(layout, 16, slope, intercept), output);
+		}
+
+		void PixelConvert::ToFloat(const uint32_t* input, size_t count, const SampleLayout& layout,
+			double slope, double intercept, float* output)
+		{
+			Convert(GetKernels().unsigned32, input, count, Params(layout, 32, slope, intercept), output);
+		}
+
+		void PixelConvert::ToFloat(const uint8_t* bytes, size_t count, uint16_t bitsAllocated, const SampleLayout& layout,
+			double slope, double intercept, float* output)
+		{
+			if (bitsAllocated == 8)
+			{
+				ToFloat(bytes, count, layout, slope, intercept, output);
+			}
+			else if (bitsAllocated == 16)
+			{
+				ForEachAligned<uint16_t>(bytes, count, [&](const uint16_t* input, size_t chunk, size_t first)
+				{
+					ToFloat(input, chunk, layout, slope, intercept, output + first);
+				});
+			}
+			else if (bitsAllocated == 32)
+			{
+				ForEachAligned<uint32_t>(bytes, count, [&](const uint32_t* input, size_t chunk, size_t first)
+				{
+					ToFloat(input, chunk, layout, slope, intercept, output + first);
+				});
+			}
+		}
+
+		void PixelConvert::ToFloat(const float* input, size_t count, double slope, double intercept, float* output)
+		{
+			ConvertReal(GetKernels().real32, input, count, Params(SampleLayout(), 32, slope, intercept), output);
+		}
+
+		void PixelConvert::ToFloat(const double* input, size_t count, double slope, double intercept, float* output)
+		{
+			ConvertReal(GetKernels().real64, input, count, Params(SampleLayout(), 32, slope, intercept), output);
+		}
+
+		void PixelConvert::RealToFloat(const uint8_t* bytes, size_t count, uint16_t bitsAllocated,
+			double slope, double intercept, float* output)
+		{
+			if (bitsAllocated == 32)
+			{
+				ForEachAligned<float>(bytes, count, [&](const float* input, size_t chunk, size_t first)
+				{
+					ToFloat(input, chunk, slope, intercept, output + first);
+				});
+			}
+			else if (bitsAllocated == 64)
+			{
+				ForEachAligned<double>(bytes, count, [&](const double* input, size_t chunk, size_t first)
+				{
+					ToFloat(input, chunk, slope, intercept, output + first);
+				});
+			}
+		}
+
+		void PixelConvert::ToFloat(const uint8_t* input, size_t count, double slope, double intercept, float* output)
+		{
+			ToFloat(input, count, SampleLayout(), slope, intercept, output);
+		}
+
+		void PixelConvert::ToFloat(const uint16_t* input, size_t count, double slope, double intercept, float* output)
+		{
+			ToFloat(input, count, SampleLayout(), slope, intercept, output);
+		}
+
+		void PixelConvert::ToFloat(const int16_t* input, size_t count, double slope, double intercept, float* output)
+		{
+			ToFloat(reinterpret_cast<const uint16_t*>(input), count, SampleLayout(16, 15, true), slope, intercept, output);
+		}
+
+		void PixelConvert::ToFloat(const uint32_t* input, size_t count, double slope, double intercept, float* output)
+		{
+			ToFloat(input, count, SampleLayout(), slope, intercept, output);
+		}
+
+		void PixelConvert::ToFloat(const int32_t* input, size_t count, double slope, double intercept, float* output)
+		{
+			ToFloat(reinterpret_cast<const uint32_t*>(input), count, SampleLayout(32, 31, true), slope, intercept, output);
+		}
+
+		void PixelConvert::FromFloat(const float* input, size_t count, int16_t* output)
+		{
+			Narrow(GetKernels().int16, input, count, output);
+		}
+
+		void PixelConvert::FromFloat(const float* input, size_t count, uint16_t* output)
+		{
+			Narrow(GetKernels().uint16, input, count, output);
+		}
+
+		void PixelConvert::FromFloat(const float* input, size_t count, Half* output)
+		{
+			Narrow(GetKernels().half, input, count, output);
+		}
+
+		float PixelConvert::HalfToFloat(Half value)
+		{
+			uint32_t sign = static_cast<uint32_t>(value.bits & 0x8000) << 16;
+			uint32_t exponent = (value.bits >> 10) & 0x1F;
+			uint32_t mantissa = value.bits & 0x3FF;
+			uint32_t bits;
+			if (exponent == 0x1F)
+			{
+				// NaNs come back quiet, as vcvtph2ps returns them
+				bits = sign | 0x7F800000 | (mantissa << 13) | (mantissa != 0 ? 0x400000 : 0);
+			}
+			else if (exponent != 0)
+			{
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			}
+			else
+			{
+				// Zero or subnormal: exact in float
+				float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+				std::memcpy(&bits, &magnitude, sizeof(bits));
+				bits |= sign;
+			}
+			float result;
+			std::memcpy(&result, &bits, sizeof(result));
+			return result;
+		}
+
+		void PixelConvert::GetStoredRange(const SampleLayout& layout, uint16_t bitsAllocated, int64_t& minimum, int64_t& maximum)
+		{
+			int bitsStored;
+			int highBit;
+			GetStoredBits(layout, std::min<int>(bitsAllocated, 32), bitsStored, highBit);
+			if (layout.isSigned)
+			{
+				minimum = -(static_cast<int64_t>(1) << (bitsStored - 1));
+				maximum = (static_cast<int64_t>(1) << (bitsStored - 1)) - 1;
+			}
+			else
+			{
+				minimum = 0;
+				maximum = (static_cast<int64_t>(1) << bitsStored) - 1;
+			}
+		}
+
+		const char* PixelConvert::GetKernelName()
+		{
+			return GetKernels().name;
+		}
+
+	} // namespace dicom
+} // namespace medvision
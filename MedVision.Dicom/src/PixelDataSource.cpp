@@ -0,0 +1,112 @@
+#include "medvision/dicom/PixelDataSource.h"
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		CallbackPixelDataSource::CallbackPixelDataSource(uint32_t frameCount, size_t frameLength, FrameCallback callback, VR vr)
+			: frameCount_(frameCount)
+			, frameLength_(frameLength)
+			, callback_(callback)
+			, vr_(vr)
+		{
+		}
+
+		bool CallbackPixelDataSource::WriteTo(FileHandle& output)
+		{
+			if (!callback_)
+			{
+				lastError_ = "No frame callback";
+				return false;
+			}
+
+			// One frame of memory regardless of the number of frames
+			frameBuffer_.resize(frameLength_);
+
+			for (uint32_t frame = 0; frame < frameCount_; ++frame)
+			{
+				if (!callback_(frame, frameBuffer_.data(), frameLength_))
+				{
+					lastError_ = "Frame callback failed for frame " + std::to_string(frame);
+					return false;
+				}
+				if (!output.Write(frameBuffer_.data(), frameLength_))
+				{
+					lastError_ = "Failed to write frame " + std::to_string(frame);
+					return false;
+				}
+			}
+
+			std::vector<uint8_t>().swap(frameBuffer_);
+			return true;
+		}
+
+		FilePixelDataSource::FilePixelDataSource(const std::string& filePath, uint64_t offset, uint64_t length, VR vr)
+			: descriptor_(-1)
+			, offset_(offset)
+			, length_(length)
+			, vr_(vr)
+		{
+			if (ownedFile_.OpenRead(filePath))
+			{
+				descriptor_ = ownedFile_.GetDescriptor();
+			}
+			else
+			{
+				lastError_ = "Cannot open pixel data source: " + filePath;
+			}
+		}
+
+		FilePixelDataSource::FilePixelDataSource(int descriptor, uint64_t offset, uint64_t length, VR vr)
+			: descriptor_(descriptor)
+			, offset_(offset)
+			, length_(length)
+			, vr_(vr)
+		{
+		}
+
+		bool FilePixelDataSource::WriteTo(FileHandle& output)
+		{
+			if (descriptor_ < 0)
+			{
+				if (lastError_.empty())
+				{
+					lastError_ = "Pixel data source is not open";
+				}
+				return false;
+			}
+
+			if (!output.CopyFrom(descriptor_, offset_, length_))
+			{
+				lastError_ = "Failed to copy pixel data from source file";
+				return false;
+			}
+			return true;
+		}
+
+		MemoryPixelDataSource::MemoryPixelDataSource(const uint8_t* data, uint64_t length, VR vr)
+			: data_(data)
+			, length_(length)
+			, vr_(vr)
+		{
+		}
+
+		bool MemoryPixelDataSource::WriteTo(FileHandle& output)
+		{
+			if (data_ == nullptr && length_ > 0)
+			{
+				lastError_ = "No pixel data region";
+				return false;
+			}
+
+			if (!output.Write(data_, static_cast<size_t>(length_)))
+			{
+				lastError_ = "Failed to write pixel data region";
+				return false;
+			}
+			return true;
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,359 @@
+#include "medvision/dicom/RleCodec.h"
+#include "medvision/dicom/CpuFeatures.h"
+#include "medvision/dicom/SampleInterleave.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef MEDVISION_X86
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			const size_t kHeaderLength = 64;
+			const uint32_t kMaxSegments = 15;
+
+			uint32_t ReadUInt32LE(const uint8_t* data)
+			{
+				return static_cast<uint32_t>(data[0]) |
+					(static_cast<uint32_t>(data[1]) << 8) |
+					(static_cast<uint32_t>(data[2]) << 16) |
+					(static_cast<uint32_t>(data[3]) << 24);
+			}
+
+			void WriteUInt32LE(uint8_t* data, uint32_t value)
+			{
+				data[0] = static_cast<uint8_t>(value);
+				data[1] = static_cast<uint8_t>(value >> 8);
+				data[2] = static_cast<uint8_t>(value >> 16);
+				data[3] = static_cast<uint8_t>(value >> 24);
+			}
+
+			inline uint32_t CountTrailingZeros(uint32_t value)
+			{
+#ifdef _MSC_VER
+				unsigned long index;
+				_BitScanForward(&index, value);
+				return static_cast<uint32_t>(index);
+#else
+				return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+			}
+
+			// Number of leading bytes equal to data[0], up to limit
+			size_t RunLength(const uint8_t* data, size_t limit)
+			{
+				size_t i = 1;
+#ifdef MEDVISION_X86
+				const __m128i value = _mm_set1_epi8(static_cast<char>(data[0]));
+				for (; i + 16 <= limit; i += 16)
+				{
+					__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					uint32_t differ = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, value))) & 0xFFFF;
+					if (differ != 0)
+					{
+						return i + CountTrailingZeros(differ);
+					}
+				}
+#endif
+				while (i < limit && data[i] == data[0])
+				{
+					++i;
+				}
+				return i;
+			}
+
+			// First position where three equal bytes start, or length if there is none
+			size_t FindRun(const uint8_t* data, size_t length)
+			{
+				size_t i = 0;
+#ifdef MEDVISION_X86
+				for (; i + 18 <= length; i += 16)
+				{
+					__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+					__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2));
+					uint32_t equal = static_cast<uint32_t>(_mm_movemask_epi8(
+						_mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(b, c))));
+					if (equal != 0)
+					{
+						return i + CountTrailingZeros(equal);
+					}
+				}
+#endif
+				for (; i + 2 < length; ++i)
+				{
+					if (data[i] == data[i + 1] && data[i + 1] == data[i + 2])
+					{
+						return i;
+					}
+				}
+				return length;
+			}
+
+			// Any other layout: plane (sample, byte from MSB) -> little endian sample bytes
+			void InterleaveGeneric(const uint8_t* planes, uint8_t* output, size_t pixels, uint32_t samples, uint32_t bytesPerSample)
+			{
+				size_t pixelStride = static_cast<size_t>(samples) * bytesPerSample;
+				for (uint32_t sample = 0; sample < samples; ++sample)
+				{
+					for (uint32_t byte = 0; byte < bytesPerSample; ++byte)
+					{
+						const uint8_t* plane = planes + (sample * bytesPerSample + byte) * pixels;
+						uint8_t* destination = output + sample * bytesPerSample + (bytesPerSample - 1 - byte);
+						for (size_t i = 0; i < pixels; ++i)
+						{
+							destination[i * pixelStride] = plane[i];
+						}
+					}
+				}
+			}
+		}
+
+		bool RleDecoder::DecodeSegment(const uint8_t* data, size_t length, uint8_t* output, size_t outputLength)
+		{
+			size_t in = 0;
+			size_t out = 0;
+			while (out < outputLength && in < length)
+			{
+				int header = static_cast<int8_t>(data[in++]);
+				if (header >= 0)
+				{
+					// Literal run of header + 1 bytes
+					size_t count = static_cast<size_t>(header) + 1;
+					if (count > length - in)
+					{
+						return false;
+					}
+					std::memcpy(output + out, data + in, std::min(count, outputLength - out));
+					in += count;
+					out += std::min(count, outputLength - out);
+				}
+				else if (header != -128)
+				{
+					// Replicate the next byte 1 - header times
+					if (in >= length)
+					{
+						return false;
+					}
+					size_t count = std::min(static_cast<size_t>(1 - header), outputLength - out);
+					std::memset(output + out, data[in++], count);
+					out += count;
+				}
+			}
+			return out == outputLength;
+		}
+
+		bool RleDecoder::DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+			uint8_t* output, std::string& error) const
+		{
+			if (info.bitsAllocated == 0 || info.bitsAllocated % 8 != 0)
+			{
+				error = "RLE requires a whole number of bytes per sample";
+				return false;
+			}
+			if (length < kHeaderLength)
+			{
+				error = "RLE header is truncated";
+				return false;
+			}
+
+			uint32_t bytesPerSample = info.bitsAllocated / 8;
+			uint32_t segmentCount = ReadUInt32LE(data);
+			if (segmentCount != static_cast<uint32_t>(info.samplesPerPixel) * bytesPerSample || segmentCount > kMaxSegments)
+			{
+				error = "RLE segment count does not match the image";
+				return false;
+			}
+
+			size_t offsets[kMaxSegments + 1];
+			for (uint32_t i = 0; i < segmentCount; ++i)
+			{
+				offsets[i] = ReadUInt32LE(data + 4 + i * 4);
+				if (offsets[i] < kHeaderLength || offsets[i] > length || (i > 0 && offsets[i] < offsets[i - 1]))
+				{
+					error = "RLE segment offset out of range";
+					return false;
+				}
+			}
+			offsets[segmentCount] = length;
+
+			size_t pixels = static_cast<size_t>(info.rows) * info.columns;
+
+			// A single plane decodes straight into the frame
+			if (segmentCount == 1)
+			{
+				if (!DecodeSegment(data + offsets[0], offsets[1] - offsets[0], output, pixels))
+				{
+					error = "RLE segment is truncated";
+					return false;
+				}
+				return true;
+			}
+
+			// Scratch planes are reused across frames decoded on the same thread
+			static thread_local std::vector<uint8_t> planes;
+			planes.resize(pixels * segmentCount);
+			for (uint32_t i = 0; i < segmentCount; ++i)
+			{
+				if (!DecodeSegment(data + offsets[i], offsets[i + 1] - offsets[i], planes.data() + i * pixels, pixels))
+				{
+					error = "RLE segment is truncated";
+					return false;
+				}
+			}
+
+			if (bytesPerSample == 2 && info.samplesPerPixel == 1)
+			{
+				SampleInterleave::Interleave16(planes.data(), planes.data() + pixels, output, pixels);
+			}
+			else if (bytesPerSample == 1 && info.samplesPerPixel == 3)
+			{
+				SampleInterleave::InterleaveRgb(planes.data(), planes.data() + pixels, planes.data() + pixels * 2, output, pixels);
+			}
+			else
+			{
+				InterleaveGeneric(planes.data(), output, pixels, info.samplesPerPixel, bytesPerSample);
+			}
+			return true;
+		}
+
+		size_t RleEncoder::EncodeRow(const uint8_t* data, size_t length, uint8_t* output)
+		{
+			uint8_t* out = output;
+			size_t position = 0;
+			while (position < length)
+			{
+				// Literal bytes up to the next run of three, in packets of at most 128
+				size_t runStart = position + FindRun(data + position, length - position);
+				while (position < runStart)
+				{
+					size_t count = std::min<size_t>(runStart - position, 128);
+					*out++ = static_cast<uint8_t>(count - 1);
+					std::memcpy(out, data + position, count);
+					out += count;
+					position += count;
+				}
+				if (position == length)
+				{
+					break;
+				}
+
+				size_t count = RunLength(data + position, std::min<size_t>(length - position, 128));
+				*out++ = static_cast<uint8_t>(257 - count);
+				*out++ = data[position];
+				position += count;
+			}
+			return static_cast<size_t>(out - output);
+		}
+
+		bool RleEncoder::EncodeFrame(const uint8_t* pixels, const FrameInfo& info,
+			std::vector<uint8_t>& output, std::string& error) const
+		{
+			if (info.bitsAllocated == 0 || info.bitsAllocated % 8 != 0)
+			{
+				error = "RLE requires a whole number of bytes per sample";
+				return false;
+			}
+
+			uint32_t bytesPerSample = info.bitsAllocated / 8;
+			uint32_t segmentCount = static_cast<uint32_t>(info.samplesPerPixel) * bytesPerSample;
+			if (segmentCount == 0 || segmentCount > kMaxSegments)
+			{
+				error = "RLE supports at most 15 byte planes";
+				return false;
+			}
+
+			size_t rows = info.rows;
+			size_t columns = info.columns;
+			size_t planeLength = rows * columns;
+			bool planar = info.planarConfiguration == 1 && info.samplesPerPixel > 1;
+
+			// Byte planes: taken in place when already contiguous, else split into scratch
+			static thread_local std::vector<uint8_t> scratch;
+			const uint8_t* planes[kMaxSegments];
+			if (bytesPerSample == 1 && (info.samplesPerPixel == 1 || planar))
+			{
+				for (uint32_t i = 0; i < segmentCount; ++i)
+				{
+					planes[i] = pixels + i * planeLength;
+				}
+			}
+			else
+			{
+				scratch.resize(planeLength * segmentCount);
+				for (uint32_t i = 0; i < segmentCount; ++i)
+				{
+					planes[i] = scratch.data() + i * planeLength;
+				}
+
+				if (bytesPerSample == 2 && (info.samplesPerPixel == 1 || planar))
+				{
+					for (uint32_t sample = 0; sample < info.samplesPerPixel; ++sample)
+					{
+						SampleInterleave::Split16(pixels + sample * planeLength * 2, scratch.data() + sample * 2 * planeLength,
+							scratch.data() + (sample * 2 + 1) * planeLength, planeLength);
+					}
+				}
+				else
+				{
+					size_t stride = planar ? bytesPerSample : static_cast<size_t>(segmentCount);
+					for (uint32_t sample = 0; sample < info.samplesPerPixel; ++sample)
+					{
+						const uint8_t* source = pixels + (planar ? sample * planeLength * bytesPerSample : sample * bytesPerSample);
+						for (uint32_t byte = 0; byte < bytesPerSample; ++byte)
+						{
+							const uint8_t* input = source + (bytesPerSample - 1 - byte);
+							uint8_t* plane = scratch.data() + (sample * bytesPerSample + byte) * planeLength;
+							for (size_t i = 0; i < planeLength; ++i)
+							{
+								plane[i] = input[i * stride];
+							}
+						}
+					}
+				}
+			}
+
+			// Worst case: every row all literals, plus the even padding of each segment
+			size_t rowBound = columns + (columns + 127) / 128;
+			output.resize(kHeaderLength + segmentCount * (rows * rowBound + 1));
+			std::memset(output.data(), 0, kHeaderLength);
+			WriteUInt32LE(output.data(), segmentCount);
+
+			size_t position = kHeaderLength;
+			for (uint32_t i = 0; i < segmentCount; ++i)
+			{
+				if (position > 0xFFFFFFFFu)
+				{
+					error = "RLE frame exceeds 4 GiB";
+					return false;
+				}
+				WriteUInt32LE(output.data() + 4 + i * 4, static_cast<uint32_t>(position));
+
+				// Rows are encoded separately; runs never cross a row boundary
+				for (size_t row = 0; row < rows; ++row)
+				{
+					position += EncodeRow(planes[i] + row * columns, columns, output.data() + position);
+				}
+				if (position % 2 != 0)
+				{
+					output[position++] = 0;   // Segments are padded to even length with zero
+				}
+			}
+
+			output.resize(position);
+			return true;
+		}
+
+	} // namespace dicom
+} // namespace medvision
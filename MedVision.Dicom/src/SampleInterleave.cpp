@@ -0,0 +1,111 @@
+#include "medvision/dicom/SampleInterleave.h"
+#include "medvision/dicom/CpuFeatures.h"
+
+#ifdef MEDVISION_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+#ifdef MEDVISION_X86
+			// 8-bit RGB: three planes into 48-byte groups of 16 pixels
+			MEDVISION_TARGET("ssse3")
+			size_t InterleaveRgbSsse3(const uint8_t* red, const uint8_t* green, const uint8_t* blue, uint8_t* output, size_t pixels)
+			{
+				const __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+				const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+				const __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+				const __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+				const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+				const __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+				const __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+				const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+				const __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+				size_t i = 0;
+				for (; i + 16 <= pixels; i += 16)
+				{
+					__m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(red + i));
+					__m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(green + i));
+					__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blue + i));
+
+					__m128i out0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)), _mm_shuffle_epi8(b, b0));
+					__m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)), _mm_shuffle_epi8(b, b1));
+					__m128i out2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)), _mm_shuffle_epi8(b, b2));
+
+					uint8_t* destination = output + i * 3;
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(destination), out0);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 16), out1);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 32), out2);
+				}
+				return i;
+			}
+#endif
+		}
+
+		void SampleInterleave::Interleave16(const uint8_t* high, const uint8_t* low, uint8_t* output, size_t count)
+		{
+			size_t i = 0;
+#ifdef MEDVISION_X86
+			for (; i + 16 <= count; i += 16)
+			{
+				__m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high + i));
+				__m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), _mm_unpacklo_epi8(l, h));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2 + 16), _mm_unpackhi_epi8(l, h));
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				output[i * 2] = low[i];
+				output[i * 2 + 1] = high[i];
+			}
+		}
+
+		void SampleInterleave::Split16(const uint8_t* input, uint8_t* high, uint8_t* low, size_t count)
+		{
+			size_t i = 0;
+#ifdef MEDVISION_X86
+			const __m128i mask = _mm_set1_epi16(0x00FF);
+			for (; i + 16 <= count; i += 16)
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2 + 16));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(low + i),
+					_mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(high + i),
+					_mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				low[i] = input[i * 2];
+				high[i] = input[i * 2 + 1];
+			}
+		}
+
+		void SampleInterleave::InterleaveRgb(const uint8_t* red, const uint8_t* green, const uint8_t* blue, uint8_t* output, size_t count)
+		{
+			size_t i = 0;
+#ifdef MEDVISION_X86
+			if (CpuFeatures::HasSSSE3())
+			{
+				i = InterleaveRgbSsse3(red, green, blue, output, count);
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				output[i * 3] = red[i];
+				output[i * 3 + 1] = green[i];
+				output[i * 3 + 2] = blue[i];
+			}
+		}
+
+	} // namespace dicom
+} // namespace medvision
@@ -0,0 +1,163 @@
+#include "medvision/dicom/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace medvision
+{
+	namespace dicom
+	{
+
+		namespace
+		{
+			// Shared between a ParallelFor caller and its helper tasks; helpers
+			// that start after every index is claimed never touch fn
+			struct ParallelForState
+			{
+				std::atomic<size_t> next;
+				size_t count;
+				const std::function<void(size_t)>* fn;
+
+				std::mutex mutex;
+				std::condition_variable done;
+				size_t completed;
+
+				ParallelForState() : next(0), count(0), fn(nullptr), completed(0) {}
+
+				void Run()
+				{
+					size_t finished = 0;
+					size_t index;
+					while ((index = next.fetch_add(1)) < count)
+					{
+						(*fn)(index);
+						++finished;
+					}
+
+					if (finished > 0)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						completed += finished;
+						if (completed == count)
+						{
+							done.notify_all();
+						}
+					}
+				}
+			};
+		}
+
+		ThreadPool::ThreadPool(size_t threadCount)
+			: activeTasks_(0)
+			, stopping_(false)
+		{
+			if (threadCount == 0)
+			{
+				threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+			}
+
+			workers_.reserve(threadCount);
+			for (size_t i = 0; i < threadCount; ++i)
+			{
+				workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+			}
+		}
+
+		ThreadPool::~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stopping_ = true;
+			}
+			taskAvailable_.notify_all();
+
+			for (std::thread& worker : workers_)
+			{
+				worker.join();
+			}
+		}
+
+		void ThreadPool::Submit(std::function<void()> task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.push_back(std::move(task));
+				++activeTasks_;
+			}
+			taskAvailable_.notify_one();
+		}
+
+		void ThreadPool::Wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			allDone_.wait(lock, [this] { return activeTasks_ == 0; });
+		}
+
+		void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			if (count == 1 || workers_.empty())
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					fn(i);
+				}
+				return;
+			}
+
+			std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+			state->count = count;
+			state->fn = &fn;
+
+			size_t helpers = std::min(workers_.size(), count - 1);
+			for (size_t i = 0; i < helpers; ++i)
+			{
+				Submit([state] { state->Run(); });
+			}
+
+			state->Run();
+
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->done.wait(lock, [&state] { return state->completed == state->count; });
+		}
+
+		ThreadPool& ThreadPool::Shared()
+		{
+			static ThreadPool pool;
+			return pool;
+		}
+
+		void ThreadPool::WorkerLoop()
+		{
+			while (true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					taskAvailable_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+					if (stopping_ && tasks_.empty())
+					{
+						return;
+					}
+					task = std::move(tasks_.front());
+					tasks_.pop_front();
+				}
+
+				task();
+
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					if (--activeTasks_ == 0)
+					{
+						allDone_.notify_all();
+					}
+				}
+			}
+		}
+
+	} // namespace dicom
+} // namespace medvision
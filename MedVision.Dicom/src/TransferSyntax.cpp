@@ -1,4 +1,7 @@
 #include "medvision/dicom/TransferSyntax.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 
 namespace medvision
 {
@@ -8,18 +11,45 @@ namespace medvision
 		const std::string TransferSyntax::ImplicitVRLittleEndian = "1.2.840.10008.1.2";
 		const std::string TransferSyntax::ExplicitVRLittleEndian = "1.2.840.10008.1.2.1";
 		const std::string TransferSyntax::ExplicitVRBigEndian = "1.2.840.10008.1.2.2";
+		const std::string TransferSyntax::DeflatedExplicitVRLittleEndian = "1.2.840.10008.1.2.1.99";
 		const std::string TransferSyntax::JPEGBaseline = "1.2.840.10008.1.2.4.50";
 		const std::string TransferSyntax::JPEGLossless = "1.2.840.10008.1.2.4.57";
+		const std::string TransferSyntax::JPEGLosslessSV1 = "1.2.840.10008.1.2.4.70";
+		const std::string TransferSyntax::JPEGLSLossless = "1.2.840.10008.1.2.4.80";
+		const std::string TransferSyntax::JPEGLSNearLossless = "1.2.840.10008.1.2.4.81";
 		const std::string TransferSyntax::JPEG2000Lossless = "1.2.840.10008.1.2.4.90";
+		const std::string TransferSyntax::JPEG2000 = "1.2.840.10008.1.2.4.91";
 		const std::string TransferSyntax::RLELossless = "1.2.840.10008.1.2.5";
 
+		namespace
+		{
+			struct InternTable
+			{
+				std::mutex mutex;
+				std::unordered_map<std::string, TransferSyntaxId> ids;
+				std::deque<std::string> uids;   // Indexed by id; deque keeps references stable
+
+				InternTable()
+				{
+					uids.push_back(std::string());
+					ids[std::string()] = TransferSyntax::InvalidId;
+				}
+			};
+
+			InternTable& GetInternTable()
+			{
+				static InternTable table;
+				return table;
+			}
+		}
+
 		bool TransferSyntax::IsExplicitVR(const std::string& uid)
 		{
 			if (uid == ImplicitVRLittleEndian)
 			{
 				return false;
 			}
-			if (uid == ExplicitVRLittleEndian || uid == ExplicitVRBigEndian)
+			if (uid == ExplicitVRLittleEndian || uid == ExplicitVRBigEndian || uid == DeflatedExplicitVRLittleEndian)
 			{
 				return true;
 			}
@@ -52,6 +82,11 @@ namespace medvision
 			return false;
 		}
 
+		bool TransferSyntax::IsDeflated(const std::string& uid)
+		{
+			return uid == DeflatedExplicitVRLittleEndian;
+		}
+
 		std::string TransferSyntax::GetName(const std::string& uid)
 		{
 			if (uid == ImplicitVRLittleEndian)
@@ -66,6 +101,10 @@ namespace medvision
 			{
 				return "Explicit VR Big Endian (Retired)";
 			}
+			if (uid == DeflatedExplicitVRLittleEndian)
+			{
+				return "Deflated Explicit VR Little Endian";
+			}
 			if (uid == JPEGBaseline)
 			{
 				return "JPEG Baseline (Process 1)";
@@ -74,10 +113,26 @@ namespace medvision
 			{
 				return "JPEG Lossless";
 			}
+			if (uid == JPEGLosslessSV1)
+			{
+				return "JPEG Lossless SV1";
+			}
+			if (uid == JPEGLSLossless)
+			{
+				return "JPEG-LS Lossless";
+			}
+			if (uid == JPEGLSNearLossless)
+			{
+				return "JPEG-LS Near-Lossless";
+			}
 			if (uid == JPEG2000Lossless)
 			{
 				return "JPEG 2000 Lossless";
 			}
+			if (uid == JPEG2000)
+			{
+				return "JPEG 2000";
+			}
 			if (uid == RLELossless)
 			{
 				return "RLE Lossless";
@@ -85,5 +140,29 @@ namespace medvision
 			return "Unknown Transfer Syntax";
 		}
 
+		TransferSyntaxId TransferSyntax::Intern(const std::string& uid)
+		{
+			InternTable& table = GetInternTable();
+			std::lock_guard<std::mutex> lock(table.mutex);
+
+			auto it = table.ids.find(uid);
+			if (it != table.ids.end())
+			{
+				return it->second;
+			}
+
+			TransferSyntaxId id = static_cast<TransferSyntaxId>(table.uids.size());
+			table.uids.push_back(uid);
+			table.ids[uid] = id;
+			return id;
+		}
+
+		const std::string& TransferSyntax::GetUID(TransferSyntaxId id)
+		{
+			InternTable& table = GetInternTable();
+			std::lock_guard<std::mutex> lock(table.mutex);
+			return id < table.uids.size() ? table.uids[id] : table.uids[InvalidId];
+		}
+
 	} // namespace dicom
 } // namespace medvision
@@ -15,7 +15,7 @@ namespace medvision
 				{VR::FL, "FL"}, {VR::FD, "FD"},
 				{VR::IS, "IS"},
 				{VR::LO, "LO"}, {VR::LT, "LT"},
-				{VR::OB, "OB"}, {VR::OD, "OD"}, {VR::OF, "OF"}, {VR::OL, "OL"}, {VR::OW, "OW"},
+				{VR::OB, "OB"}, {VR::OD, "OD"}, {VR::OF, "OF"}, {VR::OL, "OL"}, {VR::OV, "OV"}, {VR::OW, "OW"},
 				{VR::PN, "PN"},
 				{VR::SH, "SH"}, {VR::SL, "SL"}, {VR::SQ, "SQ"}, {VR::SS, "SS"}, {VR::ST, "ST"}, {VR::SV, "SV"},
 				{VR::TM, "TM"},
@@ -38,7 +38,7 @@ namespace medvision
 				{"FL", VR::FL}, {"FD", VR::FD},
 				{"IS", VR::IS},
 				{"LO", VR::LO}, {"LT", VR::LT},
-				{"OB", VR::OB}, {"OD", VR::OD}, {"OF", VR::OF}, {"OL", VR::OL}, {"OW", VR::OW},
+				{"OB", VR::OB}, {"OD", VR::OD}, {"OF", VR::OF}, {"OL", VR::OL}, {"OV", VR::OV}, {"OW", VR::OW},
 				{"PN", VR::PN},
 				{"SH", VR::SH}, {"SL", VR::SL}, {"SQ", VR::SQ}, {"SS", VR::SS}, {"ST", VR::ST}, {"SV", VR::SV},
 				{"TM", VR::TM},
@@ -71,8 +71,8 @@ namespace medvision
 		{
 			switch (vr)
 			{
-			case VR::OB: case VR::OD: case VR::OF: case VR::OL: case VR::OW:
-			case VR::SQ: case VR::UC: case VR::UR: case VR::UT: case VR::UN:
+			case VR::OB: case VR::OD: case VR::OF: case VR::OL: case VR::OV: case VR::OW:
+			case VR::SQ: case VR::SV: case VR::UC: case VR::UR: case VR::UT: case VR::UN: case VR::UV:
 				return true;
 			default:
 				return false;
@@ -0,0 +1,116 @@
+// Unit tests for ByteSwap class
+// Tests vector kernels, scalar tails and VR-driven value swapping
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/ByteSwap.h"
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	TEST_CLASS(ByteSwapTests)
+	{
+	private:
+		static std::vector<uint8_t> CreateBytes(size_t length)
+		{
+			std::vector<uint8_t> bytes(length);
+			for (size_t i = 0; i < length; ++i)
+			{
+				bytes[i] = static_cast<uint8_t>(i * 7 + 1);
+			}
+			return bytes;
+		}
+
+		// Reference: reverse each unit of the given size
+		static std::vector<uint8_t> Reverse(const std::vector<uint8_t>& bytes, size_t unit)
+		{
+			std::vector<uint8_t> result(bytes);
+			for (size_t offset = 0; offset + unit <= bytes.size(); offset += unit)
+			{
+				for (size_t i = 0; i < unit; ++i)
+				{
+					result[offset + i] = bytes[offset + unit - 1 - i];
+				}
+			}
+			return result;
+		}
+
+	public:
+		TEST_METHOD(ByteSwap_Copy_MatchesReferenceForAllTailLengths)
+		{
+			// Lengths around the 16 and 32 byte vector blocks exercise every tail
+			for (size_t count = 0; count < 40; ++count)
+			{
+				std::vector<uint8_t> source16 = CreateBytes(count * 2);
+				std::vector<uint8_t> source32 = CreateBytes(count * 4);
+				std::vector<uint8_t> source64 = CreateBytes(count * 8);
+				std::vector<uint8_t> result16(source16.size());
+				std::vector<uint8_t> result32(source32.size());
+				std::vector<uint8_t> result64(source64.size());
+
+				ByteSwap::Copy16(result16.data(), source16.data(), count);
+				ByteSwap::Copy32(result32.data(), source32.data(), count);
+				ByteSwap::Copy64(result64.data(), source64.data(), count);
+
+				Assert::IsTrue(result16 == Reverse(source16, 2));
+				Assert::IsTrue(result32 == Reverse(source32, 4));
+				Assert::IsTrue(result64 == Reverse(source64, 8));
+			}
+		}
+
+		TEST_METHOD(ByteSwap_Swap_InPlaceMatchesCopy)
+		{
+			std::vector<uint8_t> source = CreateBytes(1000);
+
+			std::vector<uint8_t> data16(source);
+			std::vector<uint8_t> data32(source);
+			std::vector<uint8_t> data64(source);
+			ByteSwap::Swap16(data16.data(), 500);
+			ByteSwap::Swap32(data32.data(), 250);
+			ByteSwap::Swap64(data64.data(), 125);
+
+			Assert::IsTrue(data16 == Reverse(source, 2));
+			Assert::IsTrue(data32 == Reverse(source, 4));
+			Assert::IsTrue(data64 == Reverse(source, 8));
+		}
+
+		TEST_METHOD(ByteSwap_Copy_HandlesUnalignedBuffers)
+		{
+			std::vector<uint8_t> source = CreateBytes(203);
+			std::vector<uint8_t> destination(203, 0);
+
+			ByteSwap::Copy32(destination.data() + 3, source.data() + 1, 50);
+
+			std::vector<uint8_t> expected = Reverse(std::vector<uint8_t>(source.begin() + 1, source.begin() + 201), 4);
+			Assert::IsTrue(std::vector<uint8_t>(destination.begin() + 3, destination.begin() + 203) == expected);
+			Assert::AreEqual(static_cast<uint8_t>(0), destination[0]);
+		}
+
+		TEST_METHOD(ByteSwap_GetSwapUnit_FollowsVR)
+		{
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::OW) == 2);
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::US) == 2);
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::AT) == 2);
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::UL) == 4);
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::OF) == 4);
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::FD) == 8);
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::OB) == 0);
+			Assert::IsTrue(ByteSwap::GetSwapUnit(VR::LO) == 0);
+		}
+
+		TEST_METHOD(ByteSwap_CopySwappedValue_CopiesByteDataUnchanged)
+		{
+			std::vector<uint8_t> source = CreateBytes(33);
+			std::vector<uint8_t> destination(33);
+
+			ByteSwap::CopySwappedValue(VR::OB, destination.data(), source.data(), source.size());
+			Assert::IsTrue(destination == source);
+
+			// A malformed odd trailing byte is kept as is
+			ByteSwap::CopySwappedValue(VR::OW, destination.data(), source.data(), source.size());
+			Assert::IsTrue(destination == Reverse(source, 2));
+		}
+	};
+}
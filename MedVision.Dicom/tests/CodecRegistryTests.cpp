@@ -0,0 +1,100 @@
+// Unit tests for CodecRegistry class
+// Tests transfer syntax interning and codec registration/lookup
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		// Copies the compressed bytes straight through
+		class PassThroughDecoder : public PixelDecoder
+		{
+		public:
+			const char* GetName() const override { return "PassThrough"; }
+			uint32_t GetCapabilities() const override { return CodecLossless | CodecMultiFrameParallel; }
+
+			bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const override
+			{
+				if (length != info.GetFrameLength())
+				{
+					error = "Length mismatch";
+					return false;
+				}
+				std::memcpy(output, data, length);
+				return true;
+			}
+		};
+	}
+
+	TEST_CLASS(CodecRegistryTests)
+	{
+	public:
+		TEST_METHOD(TransferSyntax_Intern_ReturnsStableIds)
+		{
+			TransferSyntaxId first = TransferSyntax::Intern(TransferSyntax::RLELossless);
+			TransferSyntaxId second = TransferSyntax::Intern(std::string("1.2.840.10008.1.2.5"));
+			TransferSyntaxId other = TransferSyntax::Intern(TransferSyntax::JPEGBaseline);
+
+			Assert::IsTrue(first == second);
+			Assert::IsTrue(first != other);
+			Assert::IsTrue(first != TransferSyntax::InvalidId);
+			Assert::AreEqual(TransferSyntax::RLELossless, TransferSyntax::GetUID(first));
+		}
+
+		TEST_METHOD(TransferSyntax_Intern_EmptyUidIsInvalidId)
+		{
+			Assert::IsTrue(TransferSyntax::Intern("") == TransferSyntax::InvalidId);
+			Assert::IsTrue(TransferSyntax::GetUID(0xFFFFFF).empty());
+		}
+
+		TEST_METHOD(FrameInfo_GetFrameLength_CountsSamplesAndBytes)
+		{
+			FrameInfo info;
+			info.rows = 4;
+			info.columns = 5;
+			info.samplesPerPixel = 3;
+			info.bitsAllocated = 16;
+			Assert::IsTrue(info.GetFrameLength() == 4 * 5 * 3 * 2);
+		}
+
+		TEST_METHOD(CodecRegistry_RegisterDecoder_FoundByUidAndId)
+		{
+			const std::string uid = "1.2.826.0.1.3680043.9999.1.1";
+			CodecRegistry& registry = CodecRegistry::Instance();
+			Assert::IsFalse(registry.CanDecode(TransferSyntax::Intern(uid)));
+
+			registry.RegisterDecoder(uid, std::make_shared<PassThroughDecoder>());
+
+			std::shared_ptr<const PixelDecoder> decoder = registry.FindDecoder(TransferSyntax::Intern(uid));
+			Assert::IsNotNull(decoder.get());
+			Assert::IsTrue(decoder == registry.FindDecoder(uid));
+			Assert::IsTrue((decoder->GetCapabilities() & CodecLossless) != 0);
+			Assert::IsTrue((decoder->GetCapabilities() & CodecPartialDecode) == 0);
+			Assert::IsFalse(registry.CanEncode(TransferSyntax::Intern(uid)));
+
+			FrameInfo info;
+			info.rows = 1;
+			info.columns = 2;
+			info.bitsAllocated = 8;
+			const uint8_t input[] = { 7, 9 };
+			uint8_t output[2] = { 0, 0 };
+			std::string error;
+			Assert::IsTrue(decoder->DecodeFrame(input, 2, info, output, error));
+			Assert::AreEqual(static_cast<uint8_t>(9), output[1]);
+		}
+
+		TEST_METHOD(CodecRegistry_FindDecoder_UnknownSyntaxReturnsNull)
+		{
+			Assert::IsNull(CodecRegistry::Instance().FindDecoder("1.2.826.0.1.3680043.9999.404").get());
+			Assert::IsNull(CodecRegistry::Instance().FindEncoder(TransferSyntax::InvalidId).get());
+		}
+	};
+}
@@ -0,0 +1,282 @@
+// Unit tests for ColorConvert class
+// Tests that the SIMD color kernels match per-pixel references, and segmented LUT expansion
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/ColorConvert.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		std::vector<uint8_t> Pattern(size_t length, uint32_t seed)
+		{
+			std::vector<uint8_t> data(length);
+			for (size_t i = 0; i < length; ++i)
+			{
+				seed = seed * 1103515245u + 12345u;
+				data[i] = static_cast<uint8_t>(seed >> 16);
+			}
+			return data;
+		}
+
+		// Floating point JFIF conversion; the fixed point result may differ by one
+		void YbrReference(int luma, int blue, int red, int (&rgb)[3])
+		{
+			double values[3] = {
+				luma + 1.402 * (red - 128),
+				luma - 0.344136 * (blue - 128) - 0.714136 * (red - 128),
+				luma + 1.772 * (blue - 128),
+			};
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				double rounded = std::floor(values[channel] + 0.5);
+				rgb[channel] = rounded < 0.0 ? 0 : (rounded > 255.0 ? 255 : static_cast<int>(rounded));
+			}
+		}
+
+		bool CloseToYbrReference(const uint8_t* pixel, int luma, int blue, int red)
+		{
+			int rgb[3];
+			YbrReference(luma, blue, red, rgb);
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				if (std::abs(pixel[channel] - rgb[channel]) > 1)
+				{
+					return false;
+				}
+			}
+			return pixel[3] == 255;
+		}
+	}
+
+	TEST_CLASS(ColorConvertTests)
+	{
+	public:
+		TEST_METHOD(ColorConvert_RgbToRgba_AddsOpaqueAlpha)
+		{
+			// Every length up to a few vector widths exercises the scalar tail
+			for (size_t count = 0; count < 70; ++count)
+			{
+				std::vector<uint8_t> rgb = Pattern(count * 3, static_cast<uint32_t>(count));
+				std::vector<uint8_t> rgba(count * 4 + 1, 0xCD);
+				ColorConvert::RgbToRgba(rgb.data(), count, rgba.data());
+				for (size_t i = 0; i < count; ++i)
+				{
+					Assert::AreEqual(rgb[i * 3], rgba[i * 4]);
+					Assert::AreEqual(rgb[i * 3 + 1], rgba[i * 4 + 1]);
+					Assert::AreEqual(rgb[i * 3 + 2], rgba[i * 4 + 2]);
+					Assert::AreEqual(static_cast<uint8_t>(255), rgba[i * 4 + 3]);
+				}
+				Assert::AreEqual(static_cast<uint8_t>(0xCD), rgba[count * 4]);
+			}
+		}
+
+		TEST_METHOD(ColorConvert_PlanarRgbToRgba_MatchesInterleaved)
+		{
+			const size_t count = 1000;
+			std::vector<uint8_t> rgb = Pattern(count * 3, 7);
+			std::vector<uint8_t> planes(count * 3);
+			for (size_t i = 0; i < count; ++i)
+			{
+				planes[i] = rgb[i * 3];
+				planes[count + i] = rgb[i * 3 + 1];
+				planes[count * 2 + i] = rgb[i * 3 + 2];
+			}
+
+			std::vector<uint8_t> expected(count * 4);
+			std::vector<uint8_t> output(count * 4);
+			ColorConvert::RgbToRgba(rgb.data(), count, expected.data());
+			ColorConvert::PlanarRgbToRgba(planes.data(), planes.data() + count, planes.data() + count * 2, count, output.data());
+			Assert::IsTrue(output == expected);
+		}
+
+		TEST_METHOD(ColorConvert_YbrFull_MatchesReferenceForEveryChroma)
+		{
+			// All Cb/Cr pairs at a spread of luma values; lengths are multiples of 16 plus a tail
+			std::vector<uint8_t> ybr;
+			for (int luma = 0; luma < 256; luma += 51)
+			{
+				for (int blue = 0; blue < 256; ++blue)
+				{
+					for (int red = 0; red < 256; ++red)
+					{
+						ybr.push_back(static_cast<uint8_t>(luma));
+						ybr.push_back(static_cast<uint8_t>(blue));
+						ybr.push_back(static_cast<uint8_t>(red));
+					}
+				}
+			}
+			ybr.insert(ybr.end(), { 200, 10, 250, 30, 240, 5, 128, 128, 128 });
+			size_t count = ybr.size() / 3;
+
+			std::vector<uint8_t> rgba(count * 4);
+			ColorConvert::YbrFullToRgba(ybr.data(), count, rgba.data());
+			for (size_t i = 0; i < count; ++i)
+			{
+				Assert::IsTrue(CloseToYbrReference(&rgba[i * 4], ybr[i * 3], ybr[i * 3 + 1], ybr[i * 3 + 2]));
+			}
+
+			// Neutral chroma is exact grey
+			Assert::AreEqual(static_cast<uint8_t>(128), rgba[(count - 1) * 4]);
+			Assert::AreEqual(static_cast<uint8_t>(128), rgba[(count - 1) * 4 + 1]);
+			Assert::AreEqual(static_cast<uint8_t>(128), rgba[(count - 1) * 4 + 2]);
+		}
+
+		TEST_METHOD(ColorConvert_YbrFull_SimdMatchesScalarTail)
+		{
+			// The same pixel converted inside a 32 or 16 pixel step and as the last (scalar) pixel
+			for (size_t count : { 33, 49 })
+			{
+				std::vector<uint8_t> ybr = Pattern(count * 3, static_cast<uint32_t>(count));
+				for (size_t pixel = 0; pixel + 1 < count; ++pixel)
+				{
+					std::vector<uint8_t> shifted(ybr);
+					for (int channel = 0; channel < 3; ++channel)
+					{
+						shifted[(count - 1) * 3 + channel] = ybr[pixel * 3 + channel];
+					}
+					std::vector<uint8_t> rgba(count * 4);
+					ColorConvert::YbrFullToRgba(shifted.data(), count, rgba.data());
+					for (int channel = 0; channel < 4; ++channel)
+					{
+						Assert::AreEqual(rgba[pixel * 4 + channel], rgba[(count - 1) * 4 + channel]);
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(ColorConvert_PlanarYbrFull_MatchesInterleaved)
+		{
+			const size_t count = 999;
+			std::vector<uint8_t> ybr = Pattern(count * 3, 3);
+			std::vector<uint8_t> planes(count * 3);
+			for (size_t i = 0; i < count; ++i)
+			{
+				planes[i] = ybr[i * 3];
+				planes[count + i] = ybr[i * 3 + 1];
+				planes[count * 2 + i] = ybr[i * 3 + 2];
+			}
+
+			std::vector<uint8_t> expected(count * 4);
+			std::vector<uint8_t> output(count * 4);
+			ColorConvert::YbrFullToRgba(ybr.data(), count, expected.data());
+			ColorConvert::PlanarYbrFullToRgba(planes.data(), planes.data() + count, planes.data() + count * 2, count, output.data());
+			Assert::IsTrue(output == expected);
+		}
+
+		TEST_METHOD(ColorConvert_YbrFull422_SharesChromaWithinPairs)
+		{
+			for (size_t count = 1; count < 80; ++count)
+			{
+				size_t pairs = (count + 1) / 2;
+				std::vector<uint8_t> ybr422 = Pattern(pairs * 4, static_cast<uint32_t>(count));
+
+				// Widen to YBR_FULL by hand and convert that instead
+				std::vector<uint8_t> ybr(count * 3);
+				for (size_t i = 0; i < count; ++i)
+				{
+					ybr[i * 3] = ybr422[(i / 2) * 4 + i % 2];
+					ybr[i * 3 + 1] = ybr422[(i / 2) * 4 + 2];
+					ybr[i * 3 + 2] = ybr422[(i / 2) * 4 + 3];
+				}
+
+				std::vector<uint8_t> expected(count * 4);
+				std::vector<uint8_t> output(count * 4);
+				ColorConvert::YbrFullToRgba(ybr.data(), count, expected.data());
+				ColorConvert::YbrFull422ToRgba(ybr422.data(), count, output.data());
+				Assert::IsTrue(output == expected);
+			}
+		}
+
+		TEST_METHOD(ColorConvert_PaletteToRgba_LooksUpEveryIndex)
+		{
+			std::vector<uint32_t> palette(65536);
+			for (size_t i = 0; i < palette.size(); ++i)
+			{
+				palette[i] = ColorConvert::PackRgba(static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i * 7));
+			}
+
+			std::vector<uint16_t> indices16 = { 0, 1, 255, 256, 4095, 65535, 12345 };
+			std::vector<uint8_t> rgba(indices16.size() * 4);
+			ColorConvert::PaletteToRgba(indices16.data(), indices16.size(), palette.data(), rgba.data());
+			for (size_t i = 0; i < indices16.size(); ++i)
+			{
+				Assert::AreEqual(static_cast<uint8_t>(indices16[i]), rgba[i * 4]);
+				Assert::AreEqual(static_cast<uint8_t>(indices16[i] >> 8), rgba[i * 4 + 1]);
+				Assert::AreEqual(static_cast<uint8_t>(indices16[i] * 7), rgba[i * 4 + 2]);
+				Assert::AreEqual(static_cast<uint8_t>(255), rgba[i * 4 + 3]);
+			}
+
+			std::vector<uint8_t> indices8 = { 9, 0, 255, 128, 17 };
+			rgba.assign(indices8.size() * 4, 0);
+			ColorConvert::PaletteToRgba(indices8.data(), indices8.size(), palette.data(), rgba.data());
+			for (size_t i = 0; i < indices8.size(); ++i)
+			{
+				Assert::AreEqual(indices8[i], rgba[i * 4]);
+				Assert::AreEqual(static_cast<uint8_t>(0), rgba[i * 4 + 1]);
+			}
+		}
+
+		TEST_METHOD(ColorConvert_ExpandSegmentedLut_DiscreteAndLinear)
+		{
+			// Discrete 0, 100; linear to 200 over 4 entries; linear down to 0 over 3
+			const uint16_t data[] = { 0, 2, 0, 100, 1, 4, 200, 1, 3, 0 };
+			std::vector<uint16_t> entries;
+			Assert::IsTrue(ColorConvert::ExpandSegmentedLut(data, 10, 256, entries));
+			const uint16_t expected[] = { 0, 100, 125, 150, 175, 200, 133, 67, 0 };
+			Assert::AreEqual(sizeof(expected) / sizeof(expected[0]), entries.size());
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				Assert::AreEqual(expected[i], entries[i]);
+			}
+		}
+
+		TEST_METHOD(ColorConvert_ExpandSegmentedLut_IndirectReplaysSegments)
+		{
+			// Words 0..6: discrete 10, linear to 40 over 3; then indirect copy of both (byte offset 0)
+			const uint16_t data[] = { 0, 1, 10, 1, 3, 40, 2, 2, 0, 0 };
+			std::vector<uint16_t> entries;
+			Assert::IsTrue(ColorConvert::ExpandSegmentedLut(data, 10, 256, entries));
+			const uint16_t expected[] = { 10, 20, 30, 40, 10, 20, 30, 40 };
+			Assert::AreEqual(sizeof(expected) / sizeof(expected[0]), entries.size());
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				Assert::AreEqual(expected[i], entries[i]);
+			}
+		}
+
+		TEST_METHOD(ColorConvert_ExpandSegmentedLut_RejectsMalformedData)
+		{
+			std::vector<uint16_t> entries;
+
+			const uint16_t linearFirst[] = { 1, 4, 200 };
+			Assert::IsFalse(ColorConvert::ExpandSegmentedLut(linearFirst, 3, 256, entries));
+
+			const uint16_t truncated[] = { 0, 5, 1, 2 };
+			Assert::IsFalse(ColorConvert::ExpandSegmentedLut(truncated, 4, 256, entries));
+
+			const uint16_t unknownOpcode[] = { 0, 1, 5, 7, 1 };
+			Assert::IsFalse(ColorConvert::ExpandSegmentedLut(unknownOpcode, 5, 256, entries));
+
+			const uint16_t tooLong[] = { 0, 1, 0, 1, 300, 9 };
+			Assert::IsFalse(ColorConvert::ExpandSegmentedLut(tooLong, 6, 256, entries));
+
+			// An indirect segment may not point at another indirect segment
+			const uint16_t nested[] = { 0, 1, 5, 2, 1, 6, 0 };
+			Assert::IsFalse(ColorConvert::ExpandSegmentedLut(nested, 7, 256, entries));
+			Assert::IsTrue(entries.empty());
+		}
+
+		TEST_METHOD(ColorConvert_GetKernelName_NamesAnInstructionSet)
+		{
+			std::string name = ColorConvert::GetKernelName();
+			Assert::IsTrue(name == "AVX2" || name == "SSSE3" || name == "Scalar");
+		}
+	};
+}
@@ -0,0 +1,247 @@
+// Unit tests for InflateStream and DeflateStream
+// Tests raw DEFLATE round trips, streaming in small pieces and malformed input
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/Deflate.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	TEST_CLASS(DeflateTests)
+	{
+	private:
+		// Source handing out at most chunk compressed bytes per call
+		static InflateStream::Source MemorySource(const std::vector<uint8_t>& data, size_t chunk = 4096)
+		{
+			size_t position = 0;
+			return [&data, chunk, position](uint8_t* buffer, size_t capacity) mutable {
+				size_t count = std::min(std::min(capacity, chunk), data.size() - position);
+				std::memcpy(buffer, data.data() + position, count);
+				position += count;
+				return count;
+			};
+		}
+
+		static std::vector<uint8_t> InflateAll(const std::vector<uint8_t>& compressed, std::string& error, size_t readSize = 1000)
+		{
+			InflateStream inflater(MemorySource(compressed));
+			std::vector<uint8_t> output;
+			std::vector<uint8_t> buffer(readSize);
+			size_t count;
+			while ((count = inflater.Read(buffer.data(), buffer.size())) > 0)
+			{
+				output.insert(output.end(), buffer.begin(), buffer.begin() + count);
+			}
+			error = inflater.GetLastError();
+			return output;
+		}
+
+		static std::vector<uint8_t> RoundTrip(const std::vector<uint8_t>& data)
+		{
+			std::vector<uint8_t> compressed;
+			DeflateStream::Compress(data.data(), data.size(), compressed);
+			std::string error;
+			std::vector<uint8_t> output = InflateAll(compressed, error);
+			Assert::IsTrue(error.empty());
+			return output;
+		}
+
+		// Text-like data with repeats well beyond one 64 KB block
+		static std::vector<uint8_t> MakeReport(size_t lines)
+		{
+			std::string text;
+			for (size_t i = 0; i < lines; ++i)
+			{
+				text += "Finding " + std::to_string(i % 250) + ": lesion " + std::to_string((i * 7919) % 1000) + " mm\n";
+			}
+			return std::vector<uint8_t>(text.begin(), text.end());
+		}
+
+		static std::vector<uint8_t> MakeNoise(size_t length)
+		{
+			std::vector<uint8_t> data(length);
+			uint32_t state = 12345;
+			for (uint8_t& value : data)
+			{
+				state = state * 1664525u + 1013904223u;
+				value = static_cast<uint8_t>(state >> 24);
+			}
+			return data;
+		}
+
+	public:
+		TEST_METHOD(Deflate_RoundTrip_EmptyInput)
+		{
+			std::vector<uint8_t> compressed;
+			DeflateStream::Compress(nullptr, 0, compressed);
+			Assert::IsFalse(compressed.empty(), L"An empty stream still has a final block");
+
+			std::string error;
+			Assert::IsTrue(InflateAll(compressed, error).empty());
+			Assert::IsTrue(error.empty());
+		}
+
+		TEST_METHOD(Deflate_RoundTrip_TextAcrossBlocks)
+		{
+			std::vector<uint8_t> data = MakeReport(20000);
+			Assert::IsTrue(data.size() > 3 * 64 * 1024);
+
+			std::vector<uint8_t> compressed;
+			DeflateStream::Compress(data.data(), data.size(), compressed);
+			Assert::IsTrue(compressed.size() < data.size() / 4, L"Repetitive text should compress well");
+
+			std::string error;
+			Assert::IsTrue(InflateAll(compressed, error) == data);
+			Assert::IsTrue(error.empty());
+		}
+
+		TEST_METHOD(Deflate_RoundTrip_IncompressibleDataIsStored)
+		{
+			std::vector<uint8_t> data = MakeNoise(150000);
+
+			std::vector<uint8_t> compressed;
+			DeflateStream::Compress(data.data(), data.size(), compressed);
+			Assert::IsTrue(compressed.size() < data.size() + 64, L"Stored blocks bound the expansion");
+			Assert::IsTrue(RoundTrip(data) == data);
+		}
+
+		TEST_METHOD(Deflate_RoundTrip_LongRunsAndFarMatches)
+		{
+			// Zero runs (overlapping copies) and a block repeated 30 KB later
+			std::vector<uint8_t> data(100000, 0);
+			std::vector<uint8_t> noise = MakeNoise(2000);
+			std::copy(noise.begin(), noise.end(), data.begin() + 50000);
+			std::copy(noise.begin(), noise.end(), data.begin() + 80000);
+			Assert::IsTrue(RoundTrip(data) == data);
+		}
+
+		TEST_METHOD(DeflateStream_Write_SmallPiecesMatchOneCall)
+		{
+			std::vector<uint8_t> data = MakeReport(5000);
+
+			std::vector<uint8_t> expected;
+			DeflateStream::Compress(data.data(), data.size(), expected);
+
+			std::vector<uint8_t> compressed;
+			DeflateStream deflater([&compressed](const uint8_t* bytes, size_t length) {
+				compressed.insert(compressed.end(), bytes, bytes + length);
+				return true;
+			});
+			for (size_t offset = 0; offset < data.size(); offset += 333)
+			{
+				Assert::IsTrue(deflater.Write(data.data() + offset, std::min<size_t>(333, data.size() - offset)));
+			}
+			Assert::IsTrue(deflater.Finish());
+			Assert::IsTrue(compressed == expected, L"Output does not depend on how input is split");
+			Assert::IsTrue(deflater.GetOutputLength() == compressed.size());
+		}
+
+		TEST_METHOD(InflateStream_Read_OneByteSourceAndReads)
+		{
+			std::vector<uint8_t> data = MakeReport(3000);
+			std::vector<uint8_t> compressed;
+			DeflateStream::Compress(data.data(), data.size(), compressed);
+
+			InflateStream inflater(MemorySource(compressed, 1));
+			std::vector<uint8_t> output;
+			uint8_t value;
+			while (inflater.Read(&value, 1) == 1)
+			{
+				output.push_back(value);
+			}
+			Assert::IsTrue(output == data);
+			Assert::IsTrue(inflater.AtEnd());
+		}
+
+		TEST_METHOD(InflateStream_Skip_DiscardsOutput)
+		{
+			std::vector<uint8_t> data = MakeReport(10000);
+			std::vector<uint8_t> compressed;
+			DeflateStream::Compress(data.data(), data.size(), compressed);
+
+			InflateStream inflater(MemorySource(compressed));
+			Assert::IsTrue(inflater.Skip(200000) == 200000);
+			std::vector<uint8_t> rest(data.size());
+			size_t count = inflater.Read(rest.data(), rest.size());
+			Assert::IsTrue(count == data.size() - 200000);
+			Assert::IsTrue(std::equal(rest.begin(), rest.begin() + count, data.begin() + 200000));
+			Assert::IsTrue(inflater.Skip(1) == 0);
+		}
+
+		TEST_METHOD(InflateStream_Read_DecodesZlibOutput)
+		{
+			// Produced by zlib (level 9, raw deflate) from the text below
+			const uint8_t compressed[] = {
+				0x6D, 0xD3, 0xB9, 0x71, 0xC5, 0x30, 0x0C, 0x45, 0xD1, 0xDC, 0x55, 0xB0, 0x04, 0x11, 0x0B, 0xB7,
+				0x1E, 0x7E, 0x11, 0x0E, 0x14, 0xCA, 0x81, 0x97, 0xFE, 0xFD, 0x14, 0x78, 0xC6, 0xA3, 0xCB, 0xF4,
+				0x0D, 0x05, 0xE2, 0x00, 0xD4, 0xEB, 0x7C, 0xFF, 0xFA, 0xF9, 0x3C, 0xAF, 0xF3, 0xE3, 0xBB, 0x1C,
+				0xAB, 0x1C, 0xE5, 0xBA, 0xDE, 0x5E, 0xFF, 0xB2, 0xBA, 0x4A, 0x7D, 0x66, 0xB6, 0x4A, 0x3C, 0x33,
+				0x5F, 0x65, 0x3E, 0xB3, 0xD0, 0xB7, 0xED, 0x19, 0xE6, 0x2A, 0x96, 0xCF, 0xB0, 0xAD, 0xE2, 0x38,
+				0xD9, 0x75, 0x0D, 0x6A, 0x8E, 0x55, 0x1A, 0x2E, 0x9F, 0xAB, 0x0C, 0x74, 0x59, 0xC5, 0x71, 0x84,
+				0xF2, 0x18, 0xBE, 0xAF, 0xB7, 0xA8, 0x23, 0x95, 0xA9, 0x1B, 0x52, 0xA9, 0x18, 0x4A, 0xE5, 0xEC,
+				0x40, 0xAC, 0xC6, 0xB3, 0x72, 0x4D, 0x4C, 0xA0, 0x0A, 0xE6, 0x6C, 0x57, 0xB2, 0x8E, 0x9D, 0x98,
+				0x64, 0x15, 0x75, 0x4D, 0xB4, 0x44, 0x05, 0x13, 0x6D, 0x62, 0xB4, 0x26, 0x5A, 0x60, 0x0C, 0x26,
+				0xDA, 0xE4, 0xB6, 0x65, 0x0B, 0xD6, 0x95, 0x6D, 0xB2, 0x82, 0x6C, 0xC9, 0x7E, 0x65, 0x1B, 0x08,
+				0x45, 0x6B, 0x18, 0x83, 0x8B, 0x66, 0xD8, 0x84, 0x8B, 0x36, 0x50, 0xC1, 0x45, 0x4B, 0x3E, 0x44,
+				0xD1, 0x0C, 0xC3, 0x71, 0xD1, 0x06, 0x1E, 0x93, 0x8B, 0xD6, 0x00, 0xF6, 0xFB, 0x35, 0xB2, 0x33,
+				0xD1, 0x2A, 0xCF, 0xDE, 0x34, 0x8C, 0xD7, 0x6F, 0x1B, 0xD2, 0x90, 0x2D, 0xA0, 0x08, 0xD9, 0x1C,
+				0xFD, 0x86, 0x6C, 0x95, 0x67, 0x65, 0x63, 0xD9, 0x7B, 0x6B, 0xD8, 0x4F, 0x88, 0x36, 0x80, 0x08,
+				0xD1, 0x3A, 0xFF, 0x53, 0xD1, 0x3A, 0xCF, 0x8A, 0xD6, 0x59, 0x77, 0xEE, 0xD2, 0x3C, 0x76, 0x15,
+				0xB2, 0xEE, 0x6E, 0x4B, 0xDB, 0x75, 0x96, 0xBE, 0x53, 0x64, 0x6C, 0xC0, 0x99, 0xBB, 0xD9, 0x64,
+				0xDB, 0xCD, 0x31, 0xFB, 0x6E, 0xE6, 0x39, 0x76, 0xFB, 0xC9, 0xF9, 0xB7, 0xCB, 0x5F,
+			};
+
+			std::string text;
+			for (int i = 0; i < 60; ++i)
+			{
+				text += "Measurement " + std::to_string(i) + ": " + std::to_string(i * i % 97) + " mm\n";
+			}
+
+			std::string error;
+			std::vector<uint8_t> output = InflateAll(std::vector<uint8_t>(compressed, compressed + sizeof(compressed)), error, 7);
+			Assert::IsTrue(error.empty());
+			Assert::IsTrue(std::string(output.begin(), output.end()) == text);
+		}
+
+		TEST_METHOD(InflateStream_Read_SkipsZlibHeader)
+		{
+			// zlib.compress(b"hello hello hello", 9): header, deflate data, Adler-32
+			const uint8_t wrapped[] = { 0x78, 0xDA, 0xCB, 0x48, 0xCD, 0xC9, 0xC9, 0x57, 0xC8, 0x40, 0x90, 0x00,
+				0x3A, 0x2E, 0x06, 0x7D };
+
+			std::string error;
+			std::vector<uint8_t> output = InflateAll(std::vector<uint8_t>(wrapped, wrapped + sizeof(wrapped)), error);
+			Assert::IsTrue(error.empty());
+			Assert::IsTrue(std::string(output.begin(), output.end()) == "hello hello hello");
+		}
+
+		TEST_METHOD(InflateStream_Read_ReportsTruncatedInput)
+		{
+			std::vector<uint8_t> data = MakeReport(2000);
+			std::vector<uint8_t> compressed;
+			DeflateStream::Compress(data.data(), data.size(), compressed);
+			compressed.resize(compressed.size() / 2);
+
+			std::string error;
+			std::vector<uint8_t> output = InflateAll(compressed, error);
+			Assert::IsFalse(error.empty());
+			Assert::IsTrue(output.size() < data.size());
+			Assert::IsTrue(std::equal(output.begin(), output.end(), data.begin()), L"Output up to the damage is intact");
+		}
+
+		TEST_METHOD(InflateStream_Read_RejectsInvalidBlockType)
+		{
+			const std::vector<uint8_t> invalid = { 0x07, 0x00, 0x00 };   // Final block of reserved type 3
+
+			std::string error;
+			Assert::IsTrue(InflateAll(invalid, error).empty());
+			Assert::IsFalse(error.empty());
+		}
+	};
+}
@@ -0,0 +1,212 @@
+// Unit tests for DicomPatcher class
+// Tests in-place edits, header rewrites and pixel data preservation
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/DicomPatcher.h"
+#include "medvision/dicom/DicomWriter.h"
+#include "medvision/dicom/DicomReader.h"
+#include "medvision/dicom/DicomDataSet.h"
+#include "medvision/dicom/DicomTag.h"
+#include "medvision/dicom/VR.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	TEST_CLASS(DicomPatcherTests)
+	{
+	private:
+		std::string filePath;
+
+		DicomDataSet CreateTestDataSet()
+		{
+			DicomDataSet dataSet;
+			dataSet.SetString(DicomTag::MediaStorageSOPClassUID, VR::UI, "1.2.840.10008.5.1.4.1.1.2");
+			dataSet.SetString(DicomTag::MediaStorageSOPInstanceUID, VR::UI, "1.2.3.4.5.6.7.8.9");
+			dataSet.SetString(DicomTag::TransferSyntaxUID, VR::UI, "1.2.840.10008.1.2.1");
+			dataSet.SetString(DicomTag::ImplementationClassUID, VR::UI, "1.2.840.999999.1");
+
+			dataSet.SetString(DicomTag::PatientName, VR::PN, "PATCH^TEST");
+			dataSet.SetString(DicomTag::PatientID, VR::LO, "PATCH0001");
+			dataSet.SetString(DicomTag::Modality, VR::CS, "CT");
+			dataSet.SetUInt16(DicomTag::Rows, 16);
+			dataSet.SetUInt16(DicomTag::Columns, 16);
+
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			std::vector<uint8_t> pixels(16 * 16 * 2);
+			for (size_t i = 0; i < pixels.size(); ++i)
+			{
+				pixels[i] = static_cast<uint8_t>(i * 31);
+			}
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+			return dataSet;
+		}
+
+		void WriteTestFile(const DicomDataSet& dataSet)
+		{
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteFile(filePath, dataSet));
+		}
+
+		static std::vector<uint8_t> ReadFileBytes(const std::string& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		}
+
+		// Everything from the PixelData header to the end of the file
+		static std::vector<uint8_t> GetPixelTail(const std::vector<uint8_t>& bytes)
+		{
+			const uint8_t header[] = { 0xE0, 0x7F, 0x10, 0x00 };
+			auto it = std::search(bytes.begin(), bytes.end(), header, header + 4);
+			return std::vector<uint8_t>(it, bytes.end());
+		}
+
+	public:
+		TEST_METHOD_CLEANUP(Cleanup)
+		{
+			if (!filePath.empty())
+			{
+				std::remove(filePath.c_str());
+			}
+		}
+
+		TEST_METHOD(DicomPatcher_PatchFile_ShorterValueIsWrittenInPlace)
+		{
+			filePath = "test_patch_inplace.dcm";
+			WriteTestFile(CreateTestDataSet());
+			std::vector<uint8_t> before = ReadFileBytes(filePath);
+
+			DicomDataSet changes;
+			changes.SetString(DicomTag::PatientID, VR::LO, "FIX01");
+
+			DicomPatcher patcher;
+			Assert::IsTrue(patcher.PatchFile(filePath, changes));
+			Assert::IsTrue(patcher.GetLastMode() == PatchMode::InPlace);
+
+			std::vector<uint8_t> after = ReadFileBytes(filePath);
+			Assert::IsTrue(after.size() == before.size());
+			Assert::IsTrue(GetPixelTail(after) == GetPixelTail(before));
+
+			DicomReader reader;
+			DicomDataSet dataSet;
+			Assert::IsTrue(reader.ReadFile(filePath, dataSet));
+			std::string patientId;
+			dataSet.GetString(DicomTag::PatientID, patientId);
+			Assert::AreEqual(std::string("FIX01"), patientId);
+		}
+
+		TEST_METHOD(DicomPatcher_PatchFile_LongerValueRewritesHeaderOnly)
+		{
+			filePath = "test_patch_rewrite.dcm";
+			WriteTestFile(CreateTestDataSet());
+			std::vector<uint8_t> before = ReadFileBytes(filePath);
+
+			DicomDataSet changes;
+			changes.SetString(DicomTag::PatientName, VR::PN, "MUCH^LONGER^PATIENT^NAME");
+			changes.SetString(DicomTag::StudyDate, VR::DA, "20240301");
+
+			DicomPatcher patcher;
+			Assert::IsTrue(patcher.PatchFile(filePath, changes));
+			Assert::IsTrue(patcher.GetLastMode() == PatchMode::Rewrite);
+
+			std::vector<uint8_t> after = ReadFileBytes(filePath);
+			Assert::IsTrue(GetPixelTail(after) == GetPixelTail(before));
+			Assert::IsFalse(std::ifstream(filePath + ".tmp").good(), L"Temporary file is removed");
+
+			DicomReader reader;
+			DicomDataSet dataSet;
+			Assert::IsTrue(reader.ReadFile(filePath, dataSet));
+
+			std::string value;
+			dataSet.GetString(DicomTag::PatientName, value);
+			Assert::AreEqual(std::string("MUCH^LONGER^PATIENT^NAME"), value);
+			dataSet.GetString(DicomTag::StudyDate, value);
+			Assert::AreEqual(std::string("20240301"), value);
+			dataSet.GetString(DicomTag::PatientID, value);
+			Assert::AreEqual(std::string("PATCH0001"), value);
+		}
+
+		TEST_METHOD(DicomPatcher_PatchFile_MetaEditKeepsGroupLengthConsistent)
+		{
+			filePath = "test_patch_meta.dcm";
+			WriteTestFile(CreateTestDataSet());
+
+			DicomDataSet changes;
+			changes.SetString(DicomTag::MediaStorageSOPInstanceUID, VR::UI, "1.2.3.4.5.6.7.8.9.10.11.12");
+
+			DicomPatcher patcher;
+			Assert::IsTrue(patcher.PatchFile(filePath, changes));
+			Assert::IsTrue(patcher.GetLastMode() == PatchMode::Rewrite);
+
+			DicomReader reader;
+			DicomDataSet dataSet;
+			Assert::IsTrue(reader.ReadFile(filePath, dataSet));
+
+			// The group length must cover exactly the rewritten meta elements
+			uint32_t groupLength = 0;
+			Assert::IsTrue(dataSet.GetUInt32(DicomTag::FileMetaInformationGroupLength, groupLength));
+			std::vector<uint8_t> expected;
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteBuffer(expected, dataSet));
+			std::vector<uint8_t> after = ReadFileBytes(filePath);
+			Assert::IsTrue(std::equal(expected.begin(), expected.begin() + 144 + groupLength, after.begin()));
+
+			std::string value;
+			dataSet.GetString(DicomTag::MediaStorageSOPInstanceUID, value);
+			Assert::AreEqual(std::string("1.2.3.4.5.6.7.8.9.10.11.12"), value);
+		}
+
+		TEST_METHOD(DicomPatcher_PatchFile_SkipsUndefinedLengthSequence)
+		{
+			filePath = "test_patch_sequence.dcm";
+			WriteTestFile(CreateTestDataSet());
+			std::vector<uint8_t> bytes = ReadFileBytes(filePath);
+
+			// Splice an undefined-length sequence (0008,1140) in front of PatientName
+			const uint8_t sequence[] = {
+				0x08, 0x00, 0x40, 0x11, 'S', 'Q', 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF,
+				0xFE, 0xFF, 0x00, 0xE0, 0xFF, 0xFF, 0xFF, 0xFF,
+				0x08, 0x00, 0x50, 0x11, 'U', 'I', 0x04, 0x00, '1', '.', '2', 0x00,
+				0xFE, 0xFF, 0x0D, 0xE0, 0x00, 0x00, 0x00, 0x00,
+				0xFE, 0xFF, 0xDD, 0xE0, 0x00, 0x00, 0x00, 0x00 };
+			const uint8_t patientName[] = { 0x10, 0x00, 0x10, 0x00, 'P', 'N' };
+			auto insertAt = std::search(bytes.begin(), bytes.end(), patientName, patientName + 6);
+			bytes.insert(insertAt, sequence, sequence + sizeof(sequence));
+			std::ofstream(filePath, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+			DicomDataSet changes;
+			changes.SetString(DicomTag::PatientID, VR::LO, "A MUCH LONGER PATIENT ID");
+
+			DicomPatcher patcher;
+			Assert::IsTrue(patcher.PatchFile(filePath, changes));
+
+			std::vector<uint8_t> after = ReadFileBytes(filePath);
+			Assert::IsTrue(std::search(after.begin(), after.end(), sequence, sequence + sizeof(sequence)) != after.end());
+			Assert::IsTrue(GetPixelTail(after) == GetPixelTail(bytes));
+		}
+
+		TEST_METHOD(DicomPatcher_PatchFile_RejectsPixelDataAndTransferSyntax)
+		{
+			filePath = "test_patch_reject.dcm";
+			WriteTestFile(CreateTestDataSet());
+
+			DicomPatcher patcher;
+			DicomDataSet pixelChange;
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			pixelChange.AddElement(pixelData);
+			Assert::IsFalse(patcher.PatchFile(filePath, pixelChange));
+			Assert::IsFalse(patcher.GetLastError().empty());
+
+			DicomDataSet syntaxChange;
+			syntaxChange.SetString(DicomTag::TransferSyntaxUID, VR::UI, "1.2.840.10008.1.2");
+			Assert::IsFalse(patcher.PatchFile(filePath, syntaxChange));
+			Assert::IsTrue(patcher.GetLastMode() == PatchMode::None);
+		}
+	};
+}
@@ -6,7 +6,9 @@
 #include "medvision/dicom/DicomWriter.h"
 #include "medvision/dicom/DicomDataSet.h"
 #include "medvision/dicom/DicomTag.h"
+#include "medvision/dicom/TransferSyntax.h"
 #include "medvision/dicom/VR.h"
+#include <algorithm>
 #include <fstream>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -262,5 +264,87 @@ namespace MedVisionDicomTests
 			// This tests that ReadFile properly manages the dataset
 			Assert::IsTrue(dataSet.GetElementCount() > 0);
 		}
+
+		TEST_METHOD(DicomReader_ReadBuffer_KeepsEncapsulatedPixelData)
+		{
+			// Empty offset table, one 4-byte fragment, sequence delimiter
+			const uint8_t items[] = {
+				0xFE, 0xFF, 0x00, 0xE0, 0x00, 0x00, 0x00, 0x00,
+				0xFE, 0xFF, 0x00, 0xE0, 0x04, 0x00, 0x00, 0x00, 0x11, 0x22, 0x33, 0x44,
+				0xFE, 0xFF, 0xDD, 0xE0, 0x00, 0x00, 0x00, 0x00 };
+
+			DicomDataSet dataSet;
+			dataSet.SetString(DicomTag::TransferSyntaxUID, VR::UI, "1.2.840.10008.1.2.5");
+			dataSet.SetString(DicomTag::PatientID, VR::LO, "ENCAPSULATED");
+			DicomElement pixelData(DicomTag::PixelData, VR::OB);
+			pixelData.SetData(items, sizeof(items));
+			pixelData.SetUndefinedLength(true);
+			dataSet.AddElement(pixelData);
+
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+
+			const DicomElement* readPixelData = readDataSet.GetElement(DicomTag::PixelData);
+			Assert::IsNotNull(readPixelData);
+			Assert::IsTrue(readPixelData->IsUndefinedLength());
+			Assert::AreEqual(static_cast<uint32_t>(sizeof(items)), readPixelData->GetLength());
+			Assert::IsTrue(std::equal(items, items + sizeof(items), readPixelData->GetData()));
+
+			// Written back unchanged
+			std::vector<uint8_t> rewritten;
+			Assert::IsTrue(writer.WriteBuffer(rewritten, readDataSet));
+			Assert::IsTrue(rewritten == buffer);
+		}
+
+		TEST_METHOD(DicomReader_ReadFile_InflatesDeflatedDataSet)
+		{
+			DicomDataSet dataSet;
+			dataSet.SetString(DicomTag::TransferSyntaxUID, VR::UI, TransferSyntax::DeflatedExplicitVRLittleEndian);
+			dataSet.SetString(DicomTag::PatientID, VR::LO, "DEFLATED");
+			for (uint16_t i = 0; i < 3000; ++i)
+			{
+				dataSet.SetString(DicomTag(0x0041, static_cast<uint16_t>(0x1000 + i)), VR::LT, "Text value " + std::to_string(i % 40));
+			}
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteFile(testFilePath, dataSet));
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadFile(testFilePath, readDataSet));
+			Assert::AreEqual(TransferSyntax::DeflatedExplicitVRLittleEndian, reader.GetTransferSyntax());
+
+			std::string value;
+			Assert::IsTrue(readDataSet.GetString(DicomTag::PatientID, value));
+			Assert::AreEqual(std::string("DEFLATED"), value);
+			Assert::IsTrue(readDataSet.GetString(DicomTag(0x0041, 0x1BB7), value));
+			Assert::AreEqual(std::string("Text value 39"), value);
+		}
+
+		TEST_METHOD(DicomReader_ReadBuffer_FailsOnTruncatedDeflatedDataSet)
+		{
+			DicomDataSet dataSet;
+			dataSet.SetString(DicomTag::TransferSyntaxUID, VR::UI, TransferSyntax::DeflatedExplicitVRLittleEndian);
+			for (uint16_t i = 0; i < 1000; ++i)
+			{
+				dataSet.SetString(DicomTag(0x0041, static_cast<uint16_t>(0x1000 + i)), VR::LO, "VALUE " + std::to_string(i));
+			}
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+
+			// Cut the deflated body (after the uncompressed meta group) in half
+			const size_t metaEnd = 144 + (buffer[140] | (buffer[141] << 8));
+			buffer.resize(metaEnd + (buffer.size() - metaEnd) / 2);
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsFalse(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+			Assert::IsFalse(reader.GetLastError().empty());
+		}
 	};
 }
@@ -0,0 +1,216 @@
+// Unit tests for DicomSeriesWriter class
+// Tests concurrent batch writes, progress reporting and atomic commit
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/DicomSeriesWriter.h"
+#include "medvision/dicom/DicomReader.h"
+#include "medvision/dicom/DicomWriter.h"
+#include "medvision/dicom/DicomDataSet.h"
+#include "medvision/dicom/DicomTag.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	TEST_CLASS(DicomSeriesWriterTests)
+	{
+	private:
+		std::vector<std::string> outputFiles;
+
+		static DicomDataSet CreateInstance(int instanceNumber)
+		{
+			DicomDataSet dataSet;
+			dataSet.SetString(DicomTag::MediaStorageSOPClassUID, VR::UI, "1.2.840.10008.5.1.4.1.1.7");
+			dataSet.SetString(DicomTag::MediaStorageSOPInstanceUID, VR::UI, "1.2.3.4." + std::to_string(instanceNumber));
+			dataSet.SetString(DicomTag::TransferSyntaxUID, VR::UI, "1.2.840.10008.1.2.1");
+			dataSet.SetString(DicomTag::PatientID, VR::LO, "SERIES" + std::to_string(instanceNumber));
+			dataSet.SetUInt16(DicomTag::Rows, 16);
+			dataSet.SetUInt16(DicomTag::Columns, 16);
+			return dataSet;
+		}
+
+		// Instance with 8-bit pixel data, as read back after writing it with transferSyntax
+		static DicomDataSet CreateEncodedInstance(int instanceNumber, const std::string& transferSyntax)
+		{
+			DicomDataSet dataSet = CreateInstance(instanceNumber);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 8);
+			dataSet.SetUInt16(DicomTag::BitsStored, 8);
+			dataSet.SetUInt16(DicomTag::HighBit, 7);
+			dataSet.SetUInt16(DicomTag::PixelRepresentation, 0);
+			dataSet.SetString(DicomTag::PhotometricInterpretation, VR::CS, "MONOCHROME2");
+			DicomElement pixelData(DicomTag::PixelData, VR::OB);
+			pixelData.SetData(std::vector<uint8_t>(16 * 16, 0x42));
+			dataSet.AddElement(pixelData);
+
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			writer.SetTransferSyntax(transferSyntax);
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+
+			DicomReader reader;
+			DicomDataSet encoded;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), encoded));
+			return encoded;
+		}
+
+		static bool FileExists(const std::string& path)
+		{
+			std::ifstream file(path);
+			return file.good();
+		}
+
+	public:
+		TEST_METHOD_CLEANUP(Cleanup)
+		{
+			for (const std::string& path : outputFiles)
+			{
+				std::remove(path.c_str());
+				std::remove(DicomSeriesWriter::GetTemporaryPath(path).c_str());
+			}
+		}
+
+		TEST_METHOD(DicomSeriesWriter_Write_WritesEveryInstance)
+		{
+			const int count = 40;
+			std::vector<DicomDataSet> dataSets;
+			for (int i = 0; i < count; ++i)
+			{
+				dataSets.push_back(CreateInstance(i));
+			}
+
+			std::vector<SeriesWriteItem> items;
+			for (int i = 0; i < count; ++i)
+			{
+				outputFiles.push_back("test_series_" + std::to_string(i) + ".dcm");
+				items.push_back({ outputFiles.back(), &dataSets[i] });
+			}
+
+			DicomSeriesWriter writer(4);
+			Assert::IsTrue(writer.Write(items));
+			Assert::IsTrue(writer.GetFailureCount() == 0);
+			Assert::IsTrue(writer.GetResults().size() == static_cast<size_t>(count));
+
+			for (int i = 0; i < count; ++i)
+			{
+				Assert::IsFalse(FileExists(DicomSeriesWriter::GetTemporaryPath(outputFiles[i])), L"Temporary file should be renamed");
+
+				DicomReader reader;
+				DicomDataSet readDataSet;
+				Assert::IsTrue(reader.ReadFile(outputFiles[i], readDataSet));
+
+				std::string patientId;
+				readDataSet.GetString(DicomTag::PatientID, patientId);
+				Assert::AreEqual("SERIES" + std::to_string(i), patientId);
+			}
+		}
+
+		TEST_METHOD(DicomSeriesWriter_Write_ReportsProgressForEachInstance)
+		{
+			DicomDataSet dataSet = CreateInstance(1);
+			std::vector<SeriesWriteItem> items;
+			for (int i = 0; i < 10; ++i)
+			{
+				outputFiles.push_back("test_series_progress_" + std::to_string(i) + ".dcm");
+				items.push_back({ outputFiles.back(), &dataSet });
+			}
+
+			size_t calls = 0;
+			size_t lastCompleted = 0;
+			size_t reportedTotal = 0;
+			DicomSeriesWriter writer(3);
+			writer.SetDurable(false);
+			writer.SetProgressCallback([&](size_t completed, size_t total)
+			{
+				++calls;
+				lastCompleted = completed;
+				reportedTotal = total;
+			});
+
+			Assert::IsTrue(writer.Write(items));
+			Assert::IsTrue(calls == 10);
+			Assert::IsTrue(lastCompleted == 10);
+			Assert::IsTrue(reportedTotal == 10);
+		}
+
+		TEST_METHOD(DicomSeriesWriter_Write_ReportsPerFileErrors)
+		{
+			DicomDataSet dataSet = CreateInstance(1);
+			outputFiles.push_back("test_series_ok.dcm");
+
+			std::vector<SeriesWriteItem> items;
+			items.push_back({ outputFiles.back(), &dataSet });
+			items.push_back({ "Z:/invalid/deeply/nested/nonexistent/path/file.dcm", &dataSet });
+			items.push_back({ "test_series_null.dcm", nullptr });
+
+			DicomSeriesWriter writer(2);
+			Assert::IsFalse(writer.Write(items));
+			Assert::IsTrue(writer.GetFailureCount() == 2);
+
+			const std::vector<SeriesWriteResult>& results = writer.GetResults();
+			Assert::IsTrue(results[0].success);
+			Assert::IsFalse(results[1].success);
+			Assert::IsFalse(results[1].error.empty());
+			Assert::IsFalse(results[2].success);
+			Assert::IsTrue(FileExists(outputFiles[0]));
+		}
+
+		TEST_METHOD(DicomSeriesWriter_Write_ReplacesExistingFileAtomically)
+		{
+			outputFiles.push_back("test_series_replace.dcm");
+			{
+				std::ofstream existing(outputFiles.back(), std::ios::binary);
+				existing << "old contents";
+			}
+
+			DicomDataSet dataSet = CreateInstance(7);
+			std::vector<SeriesWriteItem> items;
+			items.push_back({ outputFiles.back(), &dataSet });
+
+			DicomSeriesWriter writer;
+			Assert::IsTrue(writer.Write(items));
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadFile(outputFiles.back(), readDataSet));
+		}
+
+		TEST_METHOD(DicomSeriesWriter_Write_KeepsEachDataSetsTransferSyntaxByDefault)
+		{
+			const std::string syntaxes[] = { TransferSyntax::RLELossless, TransferSyntax::ExplicitVRBigEndian };
+			std::vector<DicomDataSet> dataSets;
+			std::vector<SeriesWriteItem> items;
+			for (int i = 0; i < 2; ++i)
+			{
+				dataSets.push_back(CreateEncodedInstance(i, syntaxes[i]));
+			}
+			for (int i = 0; i < 2; ++i)
+			{
+				outputFiles.push_back("test_series_syntax_" + std::to_string(i) + ".dcm");
+				items.push_back({ outputFiles.back(), &dataSets[i] });
+			}
+
+			DicomSeriesWriter writer;
+			Assert::IsTrue(writer.Write(items));
+			Assert::IsTrue(writer.GetFailureCount() == 0);
+
+			for (int i = 0; i < 2; ++i)
+			{
+				DicomReader reader;
+				DicomDataSet readDataSet;
+				Assert::IsTrue(reader.ReadFile(outputFiles[i], readDataSet));
+
+				std::string transferSyntax;
+				Assert::IsTrue(readDataSet.GetString(DicomTag::TransferSyntaxUID, transferSyntax));
+				Assert::AreEqual(syntaxes[i], transferSyntax);
+				Assert::AreEqual(syntaxes[i], reader.GetTransferSyntax());
+			}
+		}
+	};
+}
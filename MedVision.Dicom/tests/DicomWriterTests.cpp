@@ -5,9 +5,16 @@
 #include "medvision/dicom/DicomWriter.h"
 #include "medvision/dicom/DicomReader.h"
 #include "medvision/dicom/DicomDataSet.h"
+#include "medvision/dicom/PixelDataSource.h"
 #include "medvision/dicom/DicomTag.h"
+#include "medvision/dicom/TransferSyntax.h"
 #include "medvision/dicom/VR.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/EncapsulatedPixelData.h"
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <algorithm>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace medvision::dicom;
@@ -50,6 +57,20 @@ namespace MedVisionDicomTests
 			return dataSet;
 		}
 
+		static std::vector<uint8_t> ReadFileBytes(const std::string& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		}
+
+		// Offset of the PixelData value in an Explicit VR Little Endian file
+		static size_t FindPixelDataValue(const std::vector<uint8_t>& bytes)
+		{
+			const uint8_t header[] = { 0xE0, 0x7F, 0x10, 0x00 };
+			auto it = std::search(bytes.begin(), bytes.end(), header, header + 4);
+			return static_cast<size_t>(it - bytes.begin()) + 12;
+		}
+
 		void DeleteOutputFile()
 		{
 			if (!outputFilePath.empty())
@@ -291,5 +312,646 @@ namespace MedVisionDicomTests
 			std::string error = writer.GetLastError();
 			Assert::IsTrue(true);
 		}
+
+		TEST_METHOD(DicomWriter_WriteFile_MatchesWriteBufferBytes)
+		{
+			outputFilePath = "test_dicom_gather.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+
+			// Large value is written by reference, small ones are staged inline
+			std::vector<uint8_t> payload(300000);
+			for (size_t i = 0; i < payload.size(); ++i)
+			{
+				payload[i] = static_cast<uint8_t>(i * 31);
+			}
+			DicomElement privateData(DicomTag(0x0009, 0x1010), VR::OB);
+			privateData.SetData(payload);
+			dataSet.AddElement(privateData);
+
+			for (uint16_t i = 0; i < 2000; ++i)
+			{
+				dataSet.SetString(DicomTag(0x0011, static_cast<uint16_t>(0x1000 + i)), VR::LO, "VALUE" + std::to_string(i));
+			}
+
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteFile(outputFilePath, dataSet));
+
+			std::vector<uint8_t> buffer;
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+
+			std::vector<uint8_t> fileBytes = ReadFileBytes(outputFilePath);
+
+			Assert::IsTrue(buffer.size() == fileBytes.size(), L"Sizes should match");
+			Assert::IsTrue(buffer == fileBytes, L"File and buffer output should be identical");
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+			const DicomElement* readPrivate = readDataSet.GetElement(DicomTag(0x0009, 0x1010));
+			Assert::IsNotNull(readPrivate);
+			Assert::IsTrue(readPrivate->GetDataVector() == payload);
+		}
+
+		TEST_METHOD(DicomWriter_GetEncodedSize_MatchesWriteBufferSize)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+
+			DicomWriter writer;
+			std::vector<uint8_t> buffer;
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+			Assert::IsTrue(writer.GetEncodedSize(dataSet) == buffer.size(), L"Sizing pass should be exact");
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_CallerSpanMatchesVectorOutput)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+
+			DicomWriter writer;
+			std::vector<uint8_t> expected;
+			writer.WriteBuffer(expected, dataSet);
+
+			std::vector<uint8_t> span(expected.size() + 64, 0xCC);
+			size_t bytesWritten = 0;
+			Assert::IsTrue(writer.WriteBuffer(span.data(), span.size(), dataSet, bytesWritten));
+			Assert::IsTrue(bytesWritten == expected.size());
+			Assert::IsTrue(std::equal(expected.begin(), expected.end(), span.begin()));
+			Assert::AreEqual(static_cast<uint8_t>(0xCC), span[bytesWritten], L"Bytes past the encoding are untouched");
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_CallerSpanTooSmallFails)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+
+			DicomWriter writer;
+			std::vector<uint8_t> span(writer.GetEncodedSize(dataSet) - 1, 0xCC);
+			size_t bytesWritten = 0;
+			Assert::IsFalse(writer.WriteBuffer(span.data(), span.size(), dataSet, bytesWritten));
+			Assert::IsTrue(bytesWritten == 0);
+			Assert::IsFalse(writer.GetLastError().empty());
+			Assert::AreEqual(static_cast<uint8_t>(0xCC), span[0], L"Nothing should be written on failure");
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_ComputesMetaGroupLength)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+			dataSet.SetUInt32(DicomTag::FileMetaInformationGroupLength, 12345);  // Stale value is replaced
+
+			DicomWriter writer;
+			std::vector<uint8_t> buffer;
+			writer.WriteBuffer(buffer, dataSet);
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+
+			uint32_t groupLength = 0;
+			Assert::IsTrue(readDataSet.GetUInt32(DicomTag::FileMetaInformationGroupLength, groupLength));
+
+			// Group 0002 ends where the first dataset element (0008,0020 StudyDate) begins
+			const size_t metaStart = 132 + 12;
+			size_t datasetStart = metaStart;
+			while (datasetStart + 2 <= buffer.size() && !(buffer[datasetStart] == 0x08 && buffer[datasetStart + 1] == 0x00))
+			{
+				uint16_t vrLength = static_cast<uint16_t>(buffer[datasetStart + 6] | (buffer[datasetStart + 7] << 8));
+				datasetStart += 8 + vrLength;
+			}
+			Assert::IsTrue(groupLength == datasetStart - metaStart);
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileStreaming_PullsFramesFromCallback)
+		{
+			outputFilePath = "test_dicom_stream_callback.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+
+			const uint32_t frameCount = 5;
+			const size_t frameLength = 64 * 64 * 2;
+			uint32_t framesRequested = 0;
+			CallbackPixelDataSource source(frameCount, frameLength,
+				[&framesRequested](uint32_t frameIndex, uint8_t* buffer, size_t length)
+				{
+					std::fill(buffer, buffer + length, static_cast<uint8_t>(frameIndex + 1));
+					++framesRequested;
+					return true;
+				});
+
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteFile(outputFilePath, dataSet, source));
+			Assert::AreEqual(frameCount, framesRequested);
+
+			std::vector<uint8_t> bytes = ReadFileBytes(outputFilePath);
+			size_t valueOffset = FindPixelDataValue(bytes);
+			Assert::IsTrue(bytes.size() == valueOffset + frameCount * frameLength);
+			for (uint32_t frame = 0; frame < frameCount; ++frame)
+			{
+				Assert::AreEqual(static_cast<uint8_t>(frame + 1), bytes[valueOffset + frame * frameLength]);
+			}
+
+			// Header elements still read back normally
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadFile(outputFilePath, readDataSet));
+			Assert::AreEqual(std::string("WRITER001"), readDataSet.GetElement(DicomTag::PatientID)->GetStringValue());
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileStreaming_CopiesFromSourceFile)
+		{
+			outputFilePath = "test_dicom_stream_file.dcm";
+			const std::string sourcePath = "test_dicom_stream_source.raw";
+
+			std::vector<uint8_t> raw(3 * 1024 * 1024 + 100);
+			for (size_t i = 0; i < raw.size(); ++i)
+			{
+				raw[i] = static_cast<uint8_t>((i * 7) ^ (i >> 11));
+			}
+			{
+				std::ofstream sourceFile(sourcePath, std::ios::binary);
+				sourceFile.write(reinterpret_cast<const char*>(raw.data()), raw.size());
+			}
+
+			// Skip a 100-byte prefix of the source file
+			const uint64_t length = raw.size() - 100;
+			bool success = false;
+			{
+				FilePixelDataSource source(sourcePath, 100, length);
+				Assert::IsTrue(source.IsOpen());
+
+				DicomWriter writer;
+				success = writer.WriteFile(outputFilePath, CreateTestDataSet(), source);
+			}
+			std::remove(sourcePath.c_str());
+			Assert::IsTrue(success);
+
+			std::vector<uint8_t> bytes = ReadFileBytes(outputFilePath);
+			size_t valueOffset = FindPixelDataValue(bytes);
+			Assert::IsTrue(bytes.size() == valueOffset + length);
+			Assert::IsTrue(std::equal(raw.begin() + 100, raw.end(), bytes.begin() + valueOffset));
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileStreaming_PadsOddLengthRegion)
+		{
+			outputFilePath = "test_dicom_stream_memory.dcm";
+			const uint8_t region[] = { 1, 2, 3, 4, 5 };
+			MemoryPixelDataSource source(region, sizeof(region), VR::OB);
+
+			DicomWriter writer;
+			Assert::IsTrue(writer.WriteFile(outputFilePath, CreateTestDataSet(), source));
+
+			std::vector<uint8_t> bytes = ReadFileBytes(outputFilePath);
+			size_t valueOffset = FindPixelDataValue(bytes);
+			Assert::IsTrue(bytes.size() == valueOffset + 6);
+			Assert::AreEqual(static_cast<uint8_t>('O'), bytes[valueOffset - 8]);
+			Assert::AreEqual(static_cast<uint8_t>('B'), bytes[valueOffset - 7]);
+			Assert::AreEqual(static_cast<uint8_t>(6), bytes[valueOffset - 4], L"Declared length is padded to even");
+			Assert::AreEqual(static_cast<uint8_t>(5), bytes[valueOffset + 4]);
+			Assert::AreEqual(static_cast<uint8_t>(0), bytes[valueOffset + 5]);
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileStreaming_CallbackFailureReportsError)
+		{
+			outputFilePath = "test_dicom_stream_abort.dcm";
+			CallbackPixelDataSource source(3, 16,
+				[](uint32_t frameIndex, uint8_t*, size_t) { return frameIndex < 1; });
+
+			DicomWriter writer;
+			Assert::IsFalse(writer.WriteFile(outputFilePath, CreateTestDataSet(), source));
+			Assert::IsFalse(writer.GetLastError().empty());
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_BigEndianSwapsValuesByVR)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+			DicomElement lut(DicomTag(0x0028, 0x1201), VR::OW);
+			std::vector<uint8_t> words;
+			for (int i = 0; i < 600; ++i)
+			{
+				words.push_back(static_cast<uint8_t>(i));
+				words.push_back(static_cast<uint8_t>(i >> 8));
+			}
+			lut.SetData(words);
+			dataSet.AddElement(lut);
+
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::ExplicitVRBigEndian);
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+			Assert::IsTrue(buffer.size() == writer.GetEncodedSize(dataSet));
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+			Assert::AreEqual(TransferSyntax::ExplicitVRBigEndian, reader.GetTransferSyntax());
+
+			// Values are kept as stored, so big endian bytes are visible raw
+			const DicomElement* rows = readDataSet.GetElement(DicomTag::Rows);
+			Assert::IsNotNull(rows);
+			Assert::AreEqual(static_cast<uint8_t>(0x01), rows->GetData()[0]);
+			Assert::AreEqual(static_cast<uint8_t>(0x00), rows->GetData()[1]);
+
+			const DicomElement* readLut = readDataSet.GetElement(DicomTag(0x0028, 0x1201));
+			Assert::IsNotNull(readLut);
+			Assert::AreEqual(static_cast<uint32_t>(words.size()), readLut->GetLength());
+			for (size_t i = 0; i < words.size(); i += 2)
+			{
+				Assert::AreEqual(words[i], readLut->GetData()[i + 1]);
+				Assert::AreEqual(words[i + 1], readLut->GetData()[i]);
+			}
+
+			std::string patientName;
+			readDataSet.GetString(DicomTag::PatientName, patientName);
+			Assert::AreEqual(std::string("WRITER^TEST"), patientName);
+		}
+
+		TEST_METHOD(DicomWriter_WriteFile_TranscodesBigEndianBackToLittleEndian)
+		{
+			outputFilePath = "test_dicom_transcode.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+			dataSet.SetUInt32(DicomTag(0x0018, 0x9219), 0x11223344u);
+
+			std::vector<uint8_t> bigEndian;
+			DicomWriter bigEndianWriter;
+			bigEndianWriter.SetTransferSyntax(TransferSyntax::ExplicitVRBigEndian);
+			Assert::IsTrue(bigEndianWriter.WriteBuffer(bigEndian, dataSet));
+
+			DicomReader reader;
+			DicomDataSet bigEndianDataSet;
+			Assert::IsTrue(reader.ReadBuffer(bigEndian.data(), bigEndian.size(), bigEndianDataSet));
+
+			// By default the dataset's own transfer syntax is kept byte for byte
+			std::vector<uint8_t> rewritten;
+			DicomWriter keepWriter;
+			Assert::IsTrue(keepWriter.WriteBuffer(rewritten, bigEndianDataSet));
+			Assert::IsTrue(rewritten == bigEndian);
+
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::ExplicitVRLittleEndian);
+			Assert::IsTrue(writer.WriteFile(outputFilePath, bigEndianDataSet));
+
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadFile(outputFilePath, readDataSet));
+			Assert::AreEqual(TransferSyntax::ExplicitVRLittleEndian, reader.GetTransferSyntax());
+
+			uint16_t rows = 0;
+			uint32_t value = 0;
+			Assert::IsTrue(readDataSet.GetUInt16(DicomTag::Rows, rows));
+			Assert::IsTrue(readDataSet.GetUInt32(DicomTag(0x0018, 0x9219), value));
+			Assert::AreEqual(static_cast<uint16_t>(256), rows);
+			Assert::AreEqual(0x11223344u, value);
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_DeflatesDataSetBody)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+			for (uint16_t i = 0; i < 500; ++i)
+			{
+				dataSet.SetString(DicomTag(0x0011, static_cast<uint16_t>(0x1000 + i)), VR::LO, "CONTAINER ITEM " + std::to_string(i % 10));
+			}
+
+			DicomWriter writer;
+			std::vector<uint8_t> plain;
+			Assert::IsTrue(writer.WriteBuffer(plain, dataSet));
+
+			std::vector<uint8_t> deflated;
+			writer.SetTransferSyntax(TransferSyntax::DeflatedExplicitVRLittleEndian);
+			Assert::IsTrue(writer.WriteBuffer(deflated, dataSet));
+			Assert::IsTrue(deflated.size() < plain.size() / 2, L"Repetitive metadata should shrink");
+			Assert::IsTrue(deflated.size() % 2 == 0, L"Deflated stream is padded to even length");
+			Assert::AreEqual(writer.GetEncodedSize(dataSet), deflated.size());
+
+			// Meta information is written uncompressed, with the new syntax
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadBuffer(deflated.data(), deflated.size(), readDataSet));
+			Assert::AreEqual(TransferSyntax::DeflatedExplicitVRLittleEndian, reader.GetTransferSyntax());
+
+			std::string value;
+			Assert::IsTrue(readDataSet.GetString(DicomTag(0x0011, 0x11F3), value));
+			Assert::AreEqual(std::string("CONTAINER ITEM 9"), value);
+			Assert::IsTrue(readDataSet.GetString(DicomTag::PatientName, value));
+			Assert::AreEqual(std::string("WRITER^TEST"), value);
+
+			// Transcoding back to Explicit VR Little Endian restores the original bytes
+			DicomWriter plainWriter;
+			plainWriter.SetTransferSyntax(TransferSyntax::ExplicitVRLittleEndian);
+			std::vector<uint8_t> restored;
+			Assert::IsTrue(plainWriter.WriteBuffer(restored, readDataSet));
+			Assert::IsTrue(restored == plain);
+		}
+
+		TEST_METHOD(DicomWriter_WriteFile_DeflatedMatchesWriteBuffer)
+		{
+			outputFilePath = "test_dicom_deflated.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+			DicomElement privateData(DicomTag(0x0009, 0x1010), VR::OB);
+			privateData.SetData(std::vector<uint8_t>(300000, 0x5A));
+			dataSet.AddElement(privateData);
+
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::DeflatedExplicitVRLittleEndian);
+			Assert::IsTrue(writer.WriteFile(outputFilePath, dataSet));
+
+			std::vector<uint8_t> buffer;
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+			Assert::IsTrue(ReadFileBytes(outputFilePath) == buffer);
+
+			std::vector<uint8_t> span(buffer.size() - 1);
+			size_t bytesWritten = 0;
+			Assert::IsFalse(writer.WriteBuffer(span.data(), span.size(), dataSet, bytesWritten));
+			span.resize(buffer.size());
+			Assert::IsTrue(writer.WriteBuffer(span.data(), span.size(), dataSet, bytesWritten));
+			Assert::IsTrue(bytesWritten == buffer.size() && span == buffer);
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadFile(outputFilePath, readDataSet));
+			const DicomElement* readPrivate = readDataSet.GetElement(DicomTag(0x0009, 0x1010));
+			Assert::IsNotNull(readPrivate);
+			Assert::IsTrue(readPrivate->GetDataVector() == privateData.GetDataVector());
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileStreaming_RejectsDeflatedSyntax)
+		{
+			outputFilePath = "test_dicom_deflated_stream.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+			std::vector<uint8_t> pixels(64, 1);
+			MemoryPixelDataSource source(pixels.data(), pixels.size());
+
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::DeflatedExplicitVRLittleEndian);
+			Assert::IsFalse(writer.WriteFile(outputFilePath, dataSet, source));
+			Assert::IsFalse(writer.GetLastError().empty());
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileStreaming_RejectsByteSwappedWords)
+		{
+			outputFilePath = "test_dicom_swapped_stream.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+			std::vector<uint8_t> pixels(64, 1);
+			MemoryPixelDataSource words(pixels.data(), pixels.size(), VR::OW);
+
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::ExplicitVRBigEndian);
+			Assert::IsFalse(writer.WriteFile(outputFilePath, dataSet, words));
+			Assert::IsFalse(writer.GetLastError().empty());
+			Assert::IsFalse(std::ifstream(outputFilePath).good());
+
+			// Byte data has no byte order, so it streams unchanged
+			MemoryPixelDataSource bytes(pixels.data(), pixels.size(), VR::OB);
+			Assert::IsTrue(writer.WriteFile(outputFilePath, dataSet, bytes));
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadFile(outputFilePath, readDataSet));
+			const DicomElement* readPixels = readDataSet.GetElement(DicomTag::PixelData);
+			Assert::IsNotNull(readPixels);
+			Assert::IsTrue(readPixels->GetDataVector() == pixels);
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileEncapsulated_FillsExtendedOffsetTable)
+		{
+			outputFilePath = "test_dicom_encapsulated.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+			dataSet.SetString(DicomTag::NumberOfFrames, VR::IS, "3");
+
+			// Odd-length frames get padded; the offsets account for it
+			std::vector<std::vector<uint8_t>> frames = { std::vector<uint8_t>(301, 0x11), std::vector<uint8_t>(40, 0x22), std::vector<uint8_t>(7, 0x33) };
+			EncapsulatedFrameSource source(3, [&frames](uint32_t frameIndex, std::vector<uint8_t>& frame) {
+				frame = frames[frameIndex];
+				return true;
+			});
+
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::RLELossless);
+			Assert::IsTrue(writer.WriteFile(outputFilePath, dataSet, source));
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadFile(outputFilePath, readDataSet));
+
+			const DicomElement* offsets = readDataSet.GetElement(DicomTag::ExtendedOffsetTable);
+			const DicomElement* lengths = readDataSet.GetElement(DicomTag::ExtendedOffsetTableLengths);
+			Assert::IsNotNull(offsets);
+			Assert::IsNotNull(lengths);
+			Assert::IsTrue(offsets->GetVR() == VR::OV);
+			Assert::AreEqual(24u, offsets->GetLength());
+
+			const uint64_t expectedOffsets[3] = { 0, 310, 358 };
+			const uint64_t expectedLengths[3] = { 302, 40, 8 };
+			for (size_t i = 0; i < 3; ++i)
+			{
+				uint64_t offset = 0;
+				uint64_t length = 0;
+				std::memcpy(&offset, offsets->GetData() + i * 8, 8);
+				std::memcpy(&length, lengths->GetData() + i * 8, 8);
+				Assert::IsTrue(offset == expectedOffsets[i] && length == expectedLengths[i]);
+			}
+
+			const DicomElement* pixelData = readDataSet.GetElement(DicomTag::PixelData);
+			Assert::IsNotNull(pixelData);
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(pixelData->GetData(), pixelData->GetLength(), 3, offsets->GetData(), offsets->GetLength()));
+			Assert::IsTrue(encapsulated.GetBasicOffsetTable().empty(), L"The Basic Offset Table is empty next to an extended one");
+
+			std::vector<uint8_t> storage;
+			const uint8_t* frame = nullptr;
+			size_t frameLength = 0;
+			Assert::IsTrue(encapsulated.GetFrame(2, storage, frame, frameLength));
+			Assert::IsTrue(frameLength == 8 && frame[0] == 0x33 && frame[7] == 0);
+		}
+
+		TEST_METHOD(DicomWriter_WriteFileEncapsulated_RejectsNativeSyntax)
+		{
+			outputFilePath = "test_dicom_encapsulated_native.dcm";
+			DicomDataSet dataSet = CreateTestDataSet();
+			EncapsulatedFrameSource source(1, [](uint32_t, std::vector<uint8_t>& frame) {
+				frame.assign(4, 0);
+				return true;
+			});
+
+			DicomWriter writer;
+			Assert::IsFalse(writer.WriteFile(outputFilePath, dataSet, source));
+			Assert::IsFalse(writer.GetLastError().empty());
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_RejectsSyntaxWithoutEncoder)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			pixelData.SetData(std::vector<uint8_t>(256 * 256 * 2, 0));
+			dataSet.AddElement(pixelData);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 16);
+
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			writer.SetTransferSyntax("1.2.840.10008.1.2.4.100");  // MPEG2, no encoder
+			Assert::IsFalse(writer.WriteBuffer(buffer, dataSet));
+			Assert::IsFalse(writer.GetLastError().empty());
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_EncodesRleFramesIntoEncapsulatedPixelData)
+		{
+			const uint16_t rows = 64;
+			const uint16_t columns = 48;
+			const size_t frameCount = 3;
+
+			DicomDataSet dataSet = CreateTestDataSet();
+			dataSet.SetUInt16(DicomTag::Rows, rows);
+			dataSet.SetUInt16(DicomTag::Columns, columns);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 16);
+			dataSet.SetUInt16(DicomTag::BitsStored, 12);
+			dataSet.SetString(DicomTag::NumberOfFrames, VR::IS, "3");
+
+			std::vector<uint8_t> pixels(static_cast<size_t>(rows) * columns * 2 * frameCount);
+			for (size_t i = 0; i < pixels.size() / 2; ++i)
+			{
+				uint16_t value = static_cast<uint16_t>((i % 97 < 40) ? 1000 : (i * 7) & 0x0FFF);
+				pixels[i * 2] = static_cast<uint8_t>(value);
+				pixels[i * 2 + 1] = static_cast<uint8_t>(value >> 8);
+			}
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::RLELossless);
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+			Assert::AreEqual(writer.GetEncodedSize(dataSet), buffer.size());
+			Assert::IsTrue(buffer.size() < pixels.size());
+
+			DicomReader reader;
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+			Assert::AreEqual(TransferSyntax::RLELossless, reader.GetTransferSyntax());
+
+			const DicomElement* encoded = readDataSet.GetElement(DicomTag::PixelData);
+			Assert::IsNotNull(encoded);
+			Assert::IsTrue(encoded->IsUndefinedLength());
+
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(encoded->GetData(), encoded->GetLength(), static_cast<uint32_t>(frameCount)));
+			Assert::AreEqual(frameCount, encapsulated.GetFrameCount());
+
+			FrameInfo info;
+			info.rows = rows;
+			info.columns = columns;
+			info.bitsAllocated = 16;
+			info.bitsStored = 12;
+
+			std::shared_ptr<const PixelDecoder> decoder = CodecRegistry::Instance().FindDecoder(TransferSyntax::RLELossless);
+			std::vector<uint8_t> decoded(info.GetFrameLength());
+			for (size_t frame = 0; frame < frameCount; ++frame)
+			{
+				std::vector<uint8_t> storage;
+				const uint8_t* frameData = nullptr;
+				size_t frameLength = 0;
+				std::string error;
+				Assert::IsTrue(encapsulated.GetFrame(frame, storage, frameData, frameLength));
+				Assert::IsTrue(decoder->DecodeFrame(frameData, frameLength, info, decoded.data(), error));
+				Assert::IsTrue(std::equal(decoded.begin(), decoded.end(), pixels.begin() + frame * decoded.size()));
+			}
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_EncodesBigEndianSourceToRle)
+		{
+			const uint16_t rows = 8;
+			const uint16_t columns = 6;
+			DicomDataSet dataSet = CreateTestDataSet();
+			dataSet.SetUInt16(DicomTag::Rows, rows);
+			dataSet.SetUInt16(DicomTag::Columns, columns);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 16);
+			dataSet.SetUInt16(DicomTag::BitsStored, 16);
+			dataSet.SetString(DicomTag::NumberOfFrames, VR::IS, "2 ");
+
+			std::vector<uint8_t> pixels(static_cast<size_t>(rows) * columns * 2 * 2);
+			for (size_t i = 0; i < pixels.size() / 2; ++i)
+			{
+				uint16_t value = static_cast<uint16_t>(i * 1031);
+				pixels[i * 2] = static_cast<uint8_t>(value);
+				pixels[i * 2 + 1] = static_cast<uint8_t>(value >> 8);
+			}
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+
+			std::vector<uint8_t> bigEndian;
+			DicomWriter bigEndianWriter;
+			bigEndianWriter.SetTransferSyntax(TransferSyntax::ExplicitVRBigEndian);
+			Assert::IsTrue(bigEndianWriter.WriteBuffer(bigEndian, dataSet));
+
+			DicomReader reader;
+			DicomDataSet bigEndianDataSet;
+			Assert::IsTrue(reader.ReadBuffer(bigEndian.data(), bigEndian.size(), bigEndianDataSet));
+
+			// Image attributes and samples are both swapped before encoding
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::RLELossless);
+			Assert::IsTrue(writer.WriteBuffer(buffer, bigEndianDataSet), L"Big endian source should encode");
+
+			DicomDataSet readDataSet;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+			Assert::AreEqual(TransferSyntax::RLELossless, reader.GetTransferSyntax());
+
+			uint16_t readRows = 0;
+			Assert::IsTrue(readDataSet.GetUInt16(DicomTag::Rows, readRows));
+			Assert::AreEqual(rows, readRows);
+
+			const DicomElement* encoded = readDataSet.GetElement(DicomTag::PixelData);
+			Assert::IsNotNull(encoded);
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(encoded->GetData(), encoded->GetLength(), 2));
+
+			FrameInfo info;
+			info.rows = rows;
+			info.columns = columns;
+			info.bitsAllocated = 16;
+			info.bitsStored = 16;
+
+			std::shared_ptr<const PixelDecoder> decoder = CodecRegistry::Instance().FindDecoder(TransferSyntax::RLELossless);
+			std::vector<uint8_t> decoded(info.GetFrameLength());
+			for (size_t frame = 0; frame < 2; ++frame)
+			{
+				std::vector<uint8_t> storage;
+				const uint8_t* frameData = nullptr;
+				size_t frameLength = 0;
+				std::string error;
+				Assert::IsTrue(encapsulated.GetFrame(frame, storage, frameData, frameLength));
+				Assert::IsTrue(decoder->DecodeFrame(frameData, frameLength, info, decoded.data(), error));
+				Assert::IsTrue(std::equal(decoded.begin(), decoded.end(), pixels.begin() + frame * decoded.size()));
+			}
+		}
+
+		TEST_METHOD(DicomWriter_WriteBuffer_MalformedNumberOfFramesEncodesOneFrame)
+		{
+			DicomDataSet dataSet = CreateTestDataSet();
+			dataSet.SetUInt16(DicomTag::Rows, 4);
+			dataSet.SetUInt16(DicomTag::Columns, 4);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 8);
+			dataSet.SetUInt16(DicomTag::BitsStored, 8);
+			DicomElement pixelData(DicomTag::PixelData, VR::OB);
+			pixelData.SetData(std::vector<uint8_t>(16, 0x5A));
+			dataSet.AddElement(pixelData);
+
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::RLELossless);
+			for (const char* frames : { "abc", "0", "" })
+			{
+				dataSet.SetString(DicomTag::NumberOfFrames, VR::IS, frames);
+				std::vector<uint8_t> buffer;
+				Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+
+				DicomReader reader;
+				DicomDataSet readDataSet;
+				Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), readDataSet));
+				const DicomElement* encoded = readDataSet.GetElement(DicomTag::PixelData);
+				Assert::IsNotNull(encoded);
+				EncapsulatedPixelData encapsulated;
+				Assert::IsTrue(encapsulated.Parse(encoded->GetData(), encoded->GetLength(), 1));
+				Assert::AreEqual(static_cast<size_t>(1), encapsulated.GetFrameCount());
+			}
+		}
 	};
 }
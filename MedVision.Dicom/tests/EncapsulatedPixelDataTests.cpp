@@ -0,0 +1,155 @@
+// Unit tests for EncapsulatedPixelData class
+// Tests fragment indexing and frame assembly over encapsulated item streams
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/EncapsulatedPixelData.h"
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	TEST_CLASS(EncapsulatedPixelDataTests)
+	{
+	private:
+		static void AddItem(std::vector<uint8_t>& stream, const std::vector<uint8_t>& value)
+		{
+			const uint8_t header[] = { 0xFE, 0xFF, 0x00, 0xE0,
+				static_cast<uint8_t>(value.size()), static_cast<uint8_t>(value.size() >> 8), 0x00, 0x00 };
+			stream.insert(stream.end(), header, header + 8);
+			stream.insert(stream.end(), value.begin(), value.end());
+		}
+
+		static void AddDelimiter(std::vector<uint8_t>& stream)
+		{
+			const uint8_t delimiter[] = { 0xFE, 0xFF, 0xDD, 0xE0, 0x00, 0x00, 0x00, 0x00 };
+			stream.insert(stream.end(), delimiter, delimiter + 8);
+		}
+
+	public:
+		TEST_METHOD(EncapsulatedPixelData_Parse_OneFragmentPerFrame)
+		{
+			std::vector<uint8_t> stream;
+			AddItem(stream, std::vector<uint8_t>());
+			AddItem(stream, std::vector<uint8_t>{ 1, 2 });
+			AddItem(stream, std::vector<uint8_t>{ 3, 4, 5, 6 });
+			AddDelimiter(stream);
+
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(stream.data(), stream.size(), 2));
+			Assert::IsTrue(encapsulated.GetFragmentCount() == 2);
+			Assert::IsTrue(encapsulated.GetFrameCount() == 2);
+
+			std::vector<uint8_t> storage;
+			const uint8_t* frame = nullptr;
+			size_t length = 0;
+			Assert::IsTrue(encapsulated.GetFrame(1, storage, frame, length));
+			Assert::IsTrue(length == 4);
+			Assert::AreEqual(static_cast<uint8_t>(3), frame[0]);
+			Assert::IsTrue(storage.empty(), L"Single fragments are not copied");
+		}
+
+		TEST_METHOD(EncapsulatedPixelData_Parse_SingleFrameJoinsFragments)
+		{
+			std::vector<uint8_t> stream;
+			AddItem(stream, std::vector<uint8_t>());
+			AddItem(stream, std::vector<uint8_t>{ 1, 2 });
+			AddItem(stream, std::vector<uint8_t>{ 3, 4 });
+			AddDelimiter(stream);
+
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(stream.data(), stream.size(), 1));
+			Assert::IsTrue(encapsulated.GetFrameCount() == 1);
+
+			std::vector<uint8_t> storage;
+			const uint8_t* frame = nullptr;
+			size_t length = 0;
+			Assert::IsTrue(encapsulated.GetFrame(0, storage, frame, length));
+			Assert::IsTrue(std::vector<uint8_t>(frame, frame + length) == (std::vector<uint8_t>{ 1, 2, 3, 4 }));
+		}
+
+		TEST_METHOD(EncapsulatedPixelData_Parse_UsesBasicOffsetTable)
+		{
+			// Frame 0 = fragments 0+1, frame 1 = fragment 2 (item headers are 8 bytes)
+			std::vector<uint8_t> stream;
+			AddItem(stream, std::vector<uint8_t>{ 0, 0, 0, 0, 20, 0, 0, 0 });
+			AddItem(stream, std::vector<uint8_t>{ 1, 2 });
+			AddItem(stream, std::vector<uint8_t>{ 3, 4 });
+			AddItem(stream, std::vector<uint8_t>{ 5, 6 });
+			AddDelimiter(stream);
+
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(stream.data(), stream.size(), 2));
+			Assert::IsTrue(encapsulated.GetBasicOffsetTable().size() == 2);
+			Assert::IsTrue(encapsulated.GetFrameCount() == 2);
+
+			std::vector<uint8_t> storage;
+			const uint8_t* frame = nullptr;
+			size_t length = 0;
+			Assert::IsTrue(encapsulated.GetFrame(0, storage, frame, length));
+			Assert::IsTrue(std::vector<uint8_t>(frame, frame + length) == (std::vector<uint8_t>{ 1, 2, 3, 4 }));
+			Assert::IsTrue(encapsulated.GetFrame(1, storage, frame, length));
+			Assert::IsTrue(std::vector<uint8_t>(frame, frame + length) == (std::vector<uint8_t>{ 5, 6 }));
+		}
+
+		TEST_METHOD(EncapsulatedPixelData_Parse_UsesExtendedOffsetTable)
+		{
+			// Empty Basic Offset Table; frame 0 = fragment 0, frame 1 = fragments 1+2
+			std::vector<uint8_t> stream;
+			AddItem(stream, std::vector<uint8_t>());
+			AddItem(stream, std::vector<uint8_t>{ 1, 2 });
+			AddItem(stream, std::vector<uint8_t>{ 3, 4 });
+			AddItem(stream, std::vector<uint8_t>{ 5, 6 });
+			AddDelimiter(stream);
+			const uint8_t extendedOffsets[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 10, 0, 0, 0, 0, 0, 0, 0 };
+
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(stream.data(), stream.size(), 2, extendedOffsets, sizeof(extendedOffsets)));
+			Assert::IsTrue(encapsulated.GetBasicOffsetTable().empty());
+			Assert::IsTrue(encapsulated.GetFrameCount() == 2);
+
+			std::vector<uint8_t> storage;
+			const uint8_t* frame = nullptr;
+			size_t length = 0;
+			Assert::IsTrue(encapsulated.GetFrame(1, storage, frame, length));
+			Assert::IsTrue(std::vector<uint8_t>(frame, frame + length) == (std::vector<uint8_t>{ 3, 4, 5, 6 }));
+
+			const uint8_t misaligned[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 12, 0, 0, 0, 0, 0, 0, 0 };
+			Assert::IsFalse(encapsulated.Parse(stream.data(), stream.size(), 2, misaligned, sizeof(misaligned)));
+		}
+
+		TEST_METHOD(EncapsulatedPixelData_Build_FillsBasicOffsetTable)
+		{
+			std::vector<std::vector<uint8_t>> frames = { { 1, 2, 3 }, { 4, 5 }, { 6 } };
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData::Build(frames, stream);
+
+			EncapsulatedPixelData encapsulated;
+			Assert::IsTrue(encapsulated.Parse(stream.data(), stream.size(), 3));
+			Assert::IsTrue(encapsulated.GetBasicOffsetTable() == (std::vector<uint32_t>{ 0, 12, 22 }));
+
+			std::vector<uint8_t> storage;
+			const uint8_t* frame = nullptr;
+			size_t length = 0;
+			Assert::IsTrue(encapsulated.GetFrame(1, storage, frame, length));
+			Assert::IsTrue(std::vector<uint8_t>(frame, frame + length) == (std::vector<uint8_t>{ 4, 5 }));
+		}
+
+		TEST_METHOD(EncapsulatedPixelData_Parse_RejectsMalformedStreams)
+		{
+			std::vector<uint8_t> stream;
+			AddItem(stream, std::vector<uint8_t>());
+			AddItem(stream, std::vector<uint8_t>{ 1, 2 });
+
+			EncapsulatedPixelData encapsulated;
+			Assert::IsFalse(encapsulated.Parse(stream.data(), stream.size(), 1), L"Missing delimiter");
+			Assert::IsFalse(encapsulated.GetLastError().empty());
+
+			AddItem(stream, std::vector<uint8_t>{ 3, 4 });
+			AddItem(stream, std::vector<uint8_t>{ 5, 6 });
+			AddDelimiter(stream);
+			Assert::IsFalse(encapsulated.Parse(stream.data(), stream.size(), 2), L"Frames cannot be located");
+		}
+	};
+}
@@ -0,0 +1,302 @@
+// Unit tests for FrameDecodeScheduler class
+// Tests concurrent frame decoding into output slots, priorities and failures
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/FrameDecodeScheduler.h"
+#include "medvision/dicom/EncapsulatedPixelData.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		// Fills the frame with its first compressed byte and records the order
+		// of decodes. Frames listed in blocked wait until Release is called;
+		// frames whose byte is 0xFF fail and frames whose byte is 0xFE throw.
+		class RecordingDecoder : public PixelDecoder
+		{
+		public:
+			explicit RecordingDecoder(bool parallel = true) : parallel_(parallel), released_(false) {}
+
+			const char* GetName() const override { return "Recording"; }
+			uint32_t GetCapabilities() const override { return CodecLossless | (parallel_ ? static_cast<uint32_t>(CodecMultiFrameParallel) : 0u); }
+
+			bool DecodeFrame(const uint8_t* data, size_t length, const FrameInfo& info,
+				uint8_t* output, std::string& error) const override
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				order_.push_back(data[0]);
+				if (std::find(blocked_.begin(), blocked_.end(), data[0]) != blocked_.end())
+				{
+					released_changed_.wait(lock, [this] { return released_; });
+				}
+				if (data[0] == 0xFE)
+				{
+					throw std::runtime_error("Decoder threw");
+				}
+				if (data[0] == 0xFF || length == 0)
+				{
+					error = "Corrupt frame";
+					return false;
+				}
+				std::memset(output, data[0], info.GetFrameLength());
+				return true;
+			}
+
+			void Block(uint8_t frame) { blocked_.push_back(frame); }
+
+			void Release()
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				released_ = true;
+				released_changed_.notify_all();
+			}
+
+			std::vector<uint8_t> GetOrder() const
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				return order_;
+			}
+
+		private:
+			bool parallel_;
+			std::vector<uint8_t> blocked_;
+			mutable std::mutex mutex_;
+			mutable std::condition_variable released_changed_;
+			mutable std::vector<uint8_t> order_;
+			bool released_;
+		};
+
+		FrameInfo MakeInfo()
+		{
+			FrameInfo info;
+			info.rows = 4;
+			info.columns = 4;
+			info.bitsAllocated = 8;
+			info.bitsStored = 8;
+			return info;
+		}
+
+		// Frame i is a 2-byte fragment starting with value i (or the given values)
+		void BuildFrames(const std::vector<uint8_t>& values, std::vector<uint8_t>& stream, EncapsulatedPixelData& frames)
+		{
+			std::vector<std::vector<uint8_t>> fragments;
+			for (uint8_t value : values)
+			{
+				fragments.push_back({ value, 0 });
+			}
+			EncapsulatedPixelData::Build(fragments, stream);
+			frames.Parse(stream.data(), stream.size(), static_cast<uint32_t>(values.size()));
+		}
+
+		std::vector<uint8_t> Sequence(size_t count)
+		{
+			std::vector<uint8_t> values(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = static_cast<uint8_t>(i);
+			}
+			return values;
+		}
+	}
+
+	TEST_CLASS(FrameDecodeSchedulerTests)
+	{
+	public:
+		TEST_METHOD(FrameDecodeScheduler_WaitAll_DecodesEveryFrameIntoItsSlot)
+		{
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData frames;
+			BuildFrames(Sequence(200), stream, frames);
+
+			ThreadPool pool(4);
+			auto decoder = std::make_shared<RecordingDecoder>();
+			FrameInfo info = MakeInfo();
+			std::vector<uint8_t> output(200 * info.GetFrameLength());
+
+			FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+			Assert::IsTrue(scheduler.GetFrameCount() == 200);
+			Assert::IsTrue(scheduler.GetFrameLength() == 16);
+			scheduler.Start();
+			Assert::IsTrue(scheduler.WaitAll());
+
+			for (size_t i = 0; i < output.size(); ++i)
+			{
+				Assert::AreEqual(static_cast<uint8_t>(i / 16), output[i]);
+			}
+			Assert::IsTrue(decoder->GetOrder().size() == 200, L"Each frame is decoded once");
+			Assert::IsTrue(scheduler.GetLastError().empty());
+		}
+
+		TEST_METHOD(FrameDecodeScheduler_Prioritize_DecodesFocusThenNeighbors)
+		{
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData frames;
+			BuildFrames(Sequence(12), stream, frames);
+
+			// One worker makes the order deterministic; frame 0 holds it until the focus moved
+			ThreadPool pool(1);
+			auto decoder = std::make_shared<RecordingDecoder>();
+			decoder->Block(0);
+			FrameInfo info = MakeInfo();
+			std::vector<uint8_t> output(12 * info.GetFrameLength());
+
+			FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+			scheduler.Start(0);
+			while (scheduler.GetFrameState(0) != FrameDecodeScheduler::FrameState::Decoding)
+			{
+				std::this_thread::yield();
+			}
+			scheduler.Prioritize(8);
+			decoder->Release();
+			pool.Wait();
+
+			const std::vector<uint8_t> expected = { 0, 8, 9, 7, 10, 6, 11, 5, 4, 3, 2, 1 };
+			Assert::IsTrue(decoder->GetOrder() == expected);
+			Assert::IsTrue(scheduler.WaitAll());
+		}
+
+		TEST_METHOD(FrameDecodeScheduler_WaitForFrame_DecodesUnclaimedFrameOnCaller)
+		{
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData frames;
+			BuildFrames(Sequence(10), stream, frames);
+
+			ThreadPool pool(1);
+			auto decoder = std::make_shared<RecordingDecoder>();
+			decoder->Block(0);
+			FrameInfo info = MakeInfo();
+			std::vector<uint8_t> output(10 * info.GetFrameLength());
+
+			FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+			scheduler.Start(0);
+			while (scheduler.GetFrameState(0) != FrameDecodeScheduler::FrameState::Decoding)
+			{
+				std::this_thread::yield();
+			}
+
+			// The only worker is stuck on frame 0; frame 7 must not wait for it
+			Assert::IsTrue(scheduler.WaitForFrame(7));
+			Assert::AreEqual(static_cast<uint8_t>(7), output[7 * 16]);
+			Assert::IsTrue(scheduler.GetFrameState(0) == FrameDecodeScheduler::FrameState::Decoding);
+
+			decoder->Release();
+			Assert::IsTrue(scheduler.WaitAll());
+			Assert::IsTrue(scheduler.GetFrameState(0) == FrameDecodeScheduler::FrameState::Decoded);
+		}
+
+		TEST_METHOD(FrameDecodeScheduler_WaitAll_ReportsFailedFrame)
+		{
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData frames;
+			BuildFrames({ 1, 2, 3, 0xFF, 5 }, stream, frames);
+
+			ThreadPool pool(2);
+			auto decoder = std::make_shared<RecordingDecoder>();
+			FrameInfo info = MakeInfo();
+			std::vector<uint8_t> output(5 * info.GetFrameLength());
+
+			FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+			scheduler.Start();
+			Assert::IsFalse(scheduler.WaitAll());
+			Assert::IsTrue(scheduler.GetFrameState(3) == FrameDecodeScheduler::FrameState::Failed);
+			Assert::IsTrue(scheduler.GetFrameState(4) == FrameDecodeScheduler::FrameState::Decoded);
+			Assert::IsFalse(scheduler.WaitForFrame(3));
+			Assert::IsTrue(scheduler.GetLastError().find("Frame 3") == 0);
+		}
+
+		TEST_METHOD(FrameDecodeScheduler_ThrowingDecoder_FailsFrame)
+		{
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData frames;
+			BuildFrames({ 1, 0xFE, 3, 0xFE }, stream, frames);
+
+			ThreadPool pool(2);
+			auto decoder = std::make_shared<RecordingDecoder>();
+			FrameInfo info = MakeInfo();
+			std::vector<uint8_t> output(4 * info.GetFrameLength());
+
+			{
+				// Without Start the frame decodes on the calling thread
+				FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+				Assert::IsFalse(scheduler.WaitForFrame(1));
+				Assert::IsTrue(scheduler.GetFrameState(1) == FrameDecodeScheduler::FrameState::Failed);
+				Assert::IsTrue(scheduler.GetLastError() == "Frame 1: Decoder threw");
+			}
+
+			FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+			scheduler.Start();
+			Assert::IsFalse(scheduler.WaitAll());
+			Assert::IsTrue(scheduler.GetFrameState(1) == FrameDecodeScheduler::FrameState::Failed);
+			Assert::IsTrue(scheduler.GetFrameState(3) == FrameDecodeScheduler::FrameState::Failed);
+			Assert::IsTrue(scheduler.GetFrameState(0) == FrameDecodeScheduler::FrameState::Decoded);
+		}
+
+		TEST_METHOD(FrameDecodeScheduler_SerialDecoder_NeverRunsConcurrently)
+		{
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData frames;
+			BuildFrames(Sequence(50), stream, frames);
+
+			// Counts overlapping calls
+			class SerialCheckDecoder : public PixelDecoder
+			{
+			public:
+				mutable std::atomic<int> active{ 0 };
+				mutable std::atomic<int> overlaps{ 0 };
+				const char* GetName() const override { return "SerialCheck"; }
+				uint32_t GetCapabilities() const override { return CodecLossless; }
+				bool DecodeFrame(const uint8_t*, size_t, const FrameInfo&, uint8_t*, std::string&) const override
+				{
+					if (++active > 1)
+					{
+						++overlaps;
+					}
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+					--active;
+					return true;
+				}
+			};
+
+			ThreadPool pool(4);
+			auto decoder = std::make_shared<SerialCheckDecoder>();
+			FrameInfo info = MakeInfo();
+			std::vector<uint8_t> output(50 * info.GetFrameLength());
+
+			FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+			scheduler.Start();
+			Assert::IsTrue(scheduler.WaitAll());
+			Assert::AreEqual(0, decoder->overlaps.load());
+		}
+
+		TEST_METHOD(FrameDecodeScheduler_Destructor_CancelsPendingFrames)
+		{
+			std::vector<uint8_t> stream;
+			EncapsulatedPixelData frames;
+			BuildFrames(Sequence(100), stream, frames);
+
+			ThreadPool pool(2);
+			auto decoder = std::make_shared<RecordingDecoder>();
+			FrameInfo info = MakeInfo();
+			{
+				std::vector<uint8_t> output(100 * info.GetFrameLength());
+				FrameDecodeScheduler scheduler(frames, decoder, info, 0, output.data(), pool);
+				scheduler.Start(50);
+				Assert::IsTrue(scheduler.WaitForFrame(50));
+			}
+			pool.Wait();
+			Assert::IsTrue(decoder->GetOrder().size() <= 100);
+		}
+	};
+}
@@ -0,0 +1,320 @@
+// Unit tests for Jpeg2000Decoder class
+// Tests reversible and irreversible decoding, tiles, precincts, progression orders,
+// code-block styles, reduced-resolution decoding and malformed input
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/Jpeg2000Codec.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		// Codestreams written by OpenJPEG.
+		// kGray16: 16x16 8-bit grayscale (GraySample), reversible, two decomposition levels.
+		// kRgbTiles16: 16x16 RGB (RgbSample), reversible with RCT, four 8x8 tiles,
+		// RPCL order, 4x4 precincts and code blocks, two quality layers.
+		// kGray16Irreversible: kGray16's image through the 9/7 wavelet at 45 dB.
+		// kStyles12x10: 12x10 12-bit (StylesSample) with bypass, context reset,
+		// termination on every pass, vertically causal contexts and segmentation symbols.
+		// kGray16Reduced: OpenJPEG's output for kGray16 at half resolution.
+		const uint8_t kGray16[] = {
+			0xFF, 0x4F, 0xFF, 0x51, 0x00, 0x29, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x07, 0x01, 0x01, 0xFF, 0x52, 0x00,
+			0x0C, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x01, 0x01, 0x00, 0x01, 0xFF, 0x5C, 0x00, 0x0A, 0x40,
+			0x40, 0x48, 0x48, 0x50, 0x48, 0x48, 0x50, 0xFF, 0x64, 0x00, 0x25, 0x00, 0x01, 0x43, 0x72, 0x65,
+			0x61, 0x74, 0x65, 0x64, 0x20, 0x62, 0x79, 0x20, 0x4F, 0x70, 0x65, 0x6E, 0x4A, 0x50, 0x45, 0x47,
+			0x20, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6F, 0x6E, 0x20, 0x32, 0x2E, 0x35, 0x2E, 0x34, 0xFF, 0x90,
+			0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0xEB, 0x00, 0x01, 0xFF, 0x93, 0xDF, 0x80, 0x98, 0x12,
+			0x24, 0x95, 0xA1, 0x60, 0xA1, 0x84, 0x54, 0x5F, 0x8F, 0x4A, 0xAC, 0xEA, 0x5F, 0x35, 0x7F, 0x1F,
+			0x59, 0xDB, 0xC7, 0xDA, 0x23, 0x1F, 0x68, 0x8C, 0x7E, 0x02, 0x20, 0x22, 0xFA, 0x75, 0x61, 0x8D,
+			0xAA, 0x26, 0x71, 0x01, 0x42, 0xB8, 0x08, 0x3F, 0xAB, 0xCC, 0x88, 0x7F, 0x1F, 0x77, 0x53, 0x7C,
+			0x0B, 0x26, 0x62, 0x6A, 0x87, 0x59, 0x57, 0xF8, 0x6E, 0x67, 0x33, 0xE1, 0x7F, 0x1E, 0x09, 0x48,
+			0xEF, 0x65, 0x93, 0xC7, 0x46, 0x81, 0x48, 0x8B, 0x93, 0x7D, 0xE7, 0x3D, 0x9F, 0xEF, 0xCF, 0xC0,
+			0xAE, 0x7E, 0x05, 0xB1, 0xF8, 0x15, 0x00, 0x53, 0xC4, 0x05, 0x8A, 0x7F, 0xC2, 0xCF, 0x8E, 0x08,
+			0xC6, 0xC1, 0x21, 0x99, 0x89, 0xFD, 0x62, 0xF2, 0xB5, 0xEC, 0x29, 0xEB, 0x88, 0x2F, 0xDC, 0xB7,
+			0x68, 0x00, 0xC2, 0x68, 0xCB, 0x10, 0x78, 0x50, 0x76, 0xC4, 0xA1, 0x3C, 0xDA, 0x51, 0x85, 0xB3,
+			0x0B, 0x9B, 0x5B, 0x1D, 0xB3, 0x6D, 0xCC, 0x08, 0x5C, 0x9E, 0x4E, 0x0A, 0xC9, 0xD8, 0xCB, 0x4B,
+			0x69, 0x1F, 0xBE, 0x2F, 0x53, 0xC5, 0x3B, 0x1A, 0x16, 0x45, 0x5E, 0x67, 0x70, 0x24, 0x8C, 0xD3,
+			0x93, 0x5C, 0x54, 0xC5, 0xDA, 0xDF, 0x4F, 0xCF, 0xBB, 0x8E, 0x27, 0x05, 0x6A, 0xA6, 0x20, 0x51,
+			0xE2, 0x25, 0x46, 0x27, 0xD8, 0x5F, 0xE2, 0x60, 0x7E, 0x8D, 0x75, 0xA7, 0x2A, 0x52, 0x5B, 0x4C,
+			0xAA, 0xB5, 0x55, 0x70, 0x40, 0xC8, 0x9B, 0xA3, 0xFE, 0x17, 0x21, 0x00, 0xCB, 0x91, 0xBE, 0xD6,
+			0xA3, 0x66, 0x41, 0x0A, 0x90, 0x53, 0x06, 0x12, 0x11, 0xFF, 0xD9 };
+
+		const uint8_t kRgbTiles16[] = {
+			0xFF, 0x4F, 0xFF, 0x51, 0x00, 0x2F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x08,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x07, 0x01, 0x01, 0x07, 0x01, 0x01,
+			0x07, 0x01, 0x01, 0xFF, 0x52, 0x00, 0x0C, 0x00, 0x02, 0x00, 0x02, 0x00, 0x02, 0x00, 0x00, 0x00,
+			0x01, 0xFF, 0x5C, 0x00, 0x0A, 0x40, 0x40, 0x48, 0x48, 0x50, 0x48, 0x48, 0x50, 0xFF, 0x64, 0x00,
+			0x25, 0x00, 0x01, 0x43, 0x72, 0x65, 0x61, 0x74, 0x65, 0x64, 0x20, 0x62, 0x79, 0x20, 0x4F, 0x70,
+			0x65, 0x6E, 0x4A, 0x50, 0x45, 0x47, 0x20, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6F, 0x6E, 0x20, 0x32,
+			0x2E, 0x35, 0x2E, 0x34, 0xFF, 0x90, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6C, 0x00, 0x01,
+			0xFF, 0x93, 0xDF, 0x30, 0x40, 0x09, 0x43, 0xF6, 0xFB, 0xFC, 0x80, 0x40, 0x59, 0xDF, 0x60, 0x20,
+			0x06, 0x93, 0xEA, 0x55, 0xF4, 0x20, 0xFF, 0x7F, 0xDF, 0x18, 0x40, 0x07, 0x83, 0x59, 0xA4, 0xFC,
+			0xE0, 0x80, 0x55, 0x8F, 0x80, 0xC3, 0xEA, 0x03, 0x00, 0x0D, 0x02, 0x07, 0x80, 0xA1, 0xF5, 0x01,
+			0x80, 0x0B, 0x3D, 0x85, 0x80, 0xC1, 0xF3, 0x84, 0x83, 0xE7, 0x06, 0x0D, 0x01, 0xFF, 0x7F, 0x0B,
+			0x3D, 0x87, 0x80, 0xC1, 0xF3, 0x83, 0x00, 0x22, 0x1A, 0x13, 0x80, 0xA0, 0xF9, 0xC1, 0x80, 0x03,
+			0x7F, 0xEB, 0x80, 0xC0, 0xF9, 0x01, 0xC0, 0xF9, 0x01, 0x80, 0x22, 0x1A, 0x0F, 0x03, 0x7F, 0xE7,
+			0xFF, 0x90, 0x00, 0x0A, 0x00, 0x01, 0x00, 0x00, 0x00, 0x68, 0x00, 0x01, 0xFF, 0x93, 0xCF, 0xA4,
+			0x18, 0x0D, 0x02, 0x05, 0xF4, 0x00, 0xDF, 0x60, 0x20, 0x06, 0x93, 0xEA, 0x55, 0xF4, 0x20, 0xFF,
+			0x7F, 0xCF, 0x80, 0x30, 0x07, 0xCF, 0xF7, 0xFC, 0xE0, 0x80, 0x5E, 0x97, 0x80, 0xC3, 0xEA, 0x03,
+			0x00, 0x0D, 0x02, 0x07, 0x80, 0xA1, 0xF5, 0x01, 0x80, 0x0B, 0x3D, 0x85, 0x80, 0xC1, 0xF3, 0x84,
+			0x83, 0xE7, 0x06, 0x0D, 0x01, 0xFF, 0x7F, 0x0B, 0x3D, 0x87, 0x80, 0xC1, 0xF3, 0x83, 0x00, 0x22,
+			0x1A, 0x13, 0x80, 0xA0, 0xF9, 0xC1, 0x80, 0x03, 0x7F, 0xEB, 0x80, 0xC0, 0xF9, 0x01, 0xC0, 0xF9,
+			0x01, 0x80, 0x22, 0x1A, 0x0F, 0x03, 0x7F, 0xE7, 0xFF, 0x90, 0x00, 0x0A, 0x00, 0x02, 0x00, 0x00,
+			0x00, 0x68, 0x00, 0x01, 0xFF, 0x93, 0xDF, 0x30, 0x40, 0x09, 0x43, 0xF6, 0xFB, 0xFC, 0x80, 0x40,
+			0x59, 0xCF, 0xA4, 0x18, 0x0B, 0x3D, 0x84, 0xF4, 0x00, 0xCF, 0x80, 0x30, 0x07, 0xCF, 0xF7, 0xFC,
+			0xE0, 0x80, 0x5E, 0x97, 0x80, 0xC3, 0xEA, 0x03, 0x00, 0x0D, 0x02, 0x07, 0x80, 0xA1, 0xF5, 0x01,
+			0x80, 0x0B, 0x3D, 0x85, 0x80, 0xC1, 0xF3, 0x84, 0x83, 0xE7, 0x06, 0x0D, 0x01, 0xFF, 0x7F, 0x0B,
+			0x3D, 0x87, 0x80, 0xC1, 0xF3, 0x83, 0x00, 0x22, 0x1A, 0x13, 0x80, 0xA0, 0xF9, 0xC1, 0x80, 0x03,
+			0x7F, 0xEB, 0x80, 0xC0, 0xF9, 0x01, 0xC0, 0xF9, 0x01, 0x80, 0x22, 0x1A, 0x0F, 0x03, 0x7F, 0xE7,
+			0xFF, 0x90, 0x00, 0x0A, 0x00, 0x03, 0x00, 0x00, 0x00, 0x65, 0x00, 0x01, 0xFF, 0x93, 0xCF, 0xA4,
+			0x18, 0x0D, 0x02, 0x05, 0xF4, 0x00, 0xCF, 0xA4, 0x18, 0x0B, 0x3D, 0x84, 0xF4, 0x00, 0xCF, 0x80,
+			0x30, 0x0F, 0x70, 0x01, 0xFC, 0xE0, 0x80, 0xAA, 0x7F, 0xC2, 0x20, 0x0D, 0x02, 0xFD, 0x20, 0x40,
+			0x07, 0xA1, 0x10, 0x0B, 0x3D, 0xBE, 0x90, 0x20, 0x85, 0x80, 0xC1, 0xF3, 0x84, 0x83, 0xE7, 0x06,
+			0x0D, 0x01, 0xFF, 0x7F, 0x0B, 0x3D, 0x87, 0x80, 0xC1, 0xF3, 0x83, 0x00, 0x22, 0x1A, 0x13, 0x80,
+			0xA0, 0xF9, 0xC1, 0x80, 0x03, 0x7F, 0xEB, 0x80, 0xC0, 0xF9, 0x01, 0xC0, 0xF9, 0x01, 0x80, 0x22,
+			0x1A, 0x0F, 0x03, 0x7F, 0xE7, 0xFF, 0xD9 };
+
+		const uint8_t kGray16Irreversible[] = {
+			0xFF, 0x4F, 0xFF, 0x51, 0x00, 0x29, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x07, 0x01, 0x01, 0xFF, 0x52, 0x00,
+			0x0C, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x04, 0x04, 0x00, 0x00, 0xFF, 0x5C, 0x00, 0x11, 0x42,
+			0x5F, 0x52, 0x50, 0x05, 0x50, 0x05, 0x50, 0x47, 0x57, 0xD3, 0x57, 0xD3, 0x57, 0x62, 0xFF, 0x64,
+			0x00, 0x25, 0x00, 0x01, 0x43, 0x72, 0x65, 0x61, 0x74, 0x65, 0x64, 0x20, 0x62, 0x79, 0x20, 0x4F,
+			0x70, 0x65, 0x6E, 0x4A, 0x50, 0x45, 0x47, 0x20, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6F, 0x6E, 0x20,
+			0x32, 0x2E, 0x35, 0x2E, 0x34, 0xFF, 0x90, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0xCC, 0x00,
+			0x01, 0xFF, 0x93, 0xC7, 0xD6, 0x22, 0x11, 0xE7, 0xE3, 0x23, 0xE8, 0xE1, 0x1F, 0x7A, 0x38, 0x7D,
+			0xB4, 0xEB, 0x26, 0x42, 0x86, 0x8F, 0x9E, 0xC3, 0xE6, 0x1D, 0x1F, 0x48, 0xE8, 0xFA, 0xC3, 0x80,
+			0x1C, 0x51, 0x65, 0x92, 0x45, 0x55, 0xBA, 0x85, 0xB3, 0x73, 0x3E, 0xD8, 0x8C, 0xF4, 0x1F, 0xBB,
+			0x13, 0x49, 0xD6, 0x13, 0xAD, 0x53, 0x46, 0x4C, 0x83, 0x62, 0xCE, 0x72, 0x1F, 0xB4, 0x73, 0x23,
+			0x46, 0x07, 0x81, 0x2B, 0x36, 0xF9, 0x40, 0x28, 0xC3, 0xC1, 0xC7, 0xD0, 0x8E, 0x3E, 0xA2, 0x88,
+			0x7C, 0xC8, 0xC0, 0x53, 0xC4, 0x05, 0x8A, 0x7F, 0xBF, 0xA0, 0x53, 0x94, 0x01, 0xCB, 0x35, 0x5E,
+			0x28, 0xE0, 0x94, 0x0E, 0xC3, 0xE5, 0x55, 0x9A, 0x71, 0x7B, 0x62, 0xA9, 0x6F, 0xB9, 0xB7, 0x3A,
+			0x10, 0x54, 0x69, 0x9E, 0x39, 0x81, 0x38, 0xBF, 0x92, 0x6C, 0xED, 0xCC, 0xC7, 0x57, 0x44, 0x3D,
+			0x2D, 0xFA, 0x0B, 0xFD, 0xD6, 0xAF, 0xBB, 0xBC, 0x39, 0xF3, 0x05, 0x34, 0x34, 0x9C, 0x5E, 0x88,
+			0xDC, 0x1E, 0x11, 0x20, 0xBE, 0xD9, 0xBD, 0xB5, 0x43, 0x24, 0x10, 0xE4, 0x8B, 0xD4, 0x51, 0xE1,
+			0xFF, 0x7C, 0xE3, 0x04, 0x27, 0x8F, 0x4D, 0x07, 0xFC, 0xBA, 0xAC, 0x81, 0xDD, 0xF0, 0xCC, 0x07,
+			0x42, 0x17, 0xF3, 0xA2, 0xD8, 0x48, 0x1B, 0x8F, 0xA3, 0x7F, 0x65, 0x34, 0x34, 0x03, 0xBC, 0x86,
+			0x8C, 0xFF, 0xD9 };
+
+		const uint8_t kStyles12x10[] = {
+			0xFF, 0x4F, 0xFF, 0x51, 0x00, 0x29, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x0A,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0x0A,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x0F, 0x01, 0x01, 0xFF, 0x52, 0x00,
+			0x0C, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x00, 0x00, 0x2F, 0x01, 0xFF, 0x5C, 0x00, 0x0A, 0x40,
+			0x80, 0x88, 0x88, 0x90, 0x88, 0x88, 0x90, 0xFF, 0x64, 0x00, 0x25, 0x00, 0x01, 0x43, 0x72, 0x65,
+			0x61, 0x74, 0x65, 0x64, 0x20, 0x62, 0x79, 0x20, 0x4F, 0x70, 0x65, 0x6E, 0x4A, 0x50, 0x45, 0x47,
+			0x20, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6F, 0x6E, 0x20, 0x32, 0x2E, 0x35, 0x2E, 0x34, 0xFF, 0x90,
+			0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x02, 0xB0, 0x00, 0x01, 0xFF, 0x93, 0xCF, 0xFC, 0x31, 0xA4,
+			0x52, 0x29, 0x10, 0x88, 0x44, 0x22, 0x11, 0x08, 0x84, 0x42, 0x21, 0x10, 0x88, 0x44, 0x22, 0x08,
+			0xEC, 0x6F, 0xFF, 0x7F, 0xFF, 0x7F, 0xBF, 0xFF, 0x7F, 0xFF, 0x7F, 0xBF, 0xFF, 0x7F, 0xD8, 0x7F,
+			0xBF, 0xE6, 0x2A, 0xBF, 0xD5, 0xAA, 0xBF, 0x85, 0xAA, 0xBF, 0xAB, 0x2A, 0xBF, 0x95, 0xAA, 0xBF,
+			0xFC, 0x2A, 0xBF, 0xB6, 0x2A, 0xBF, 0xB8, 0x2A, 0xBF, 0x00, 0x2A, 0xBF, 0xC4, 0x2A, 0xBF, 0x6C,
+			0x2A, 0xBF, 0xC0, 0x7F, 0x26, 0x49, 0x24, 0x92, 0x49, 0x24, 0x92, 0x48, 0x44, 0x22, 0x11, 0x08,
+			0xC0, 0x0F, 0xC0, 0x89, 0x24, 0x94, 0x48, 0x24, 0x12, 0x09, 0x04, 0xC0, 0x3F, 0x92, 0x28, 0x92,
+			0x49, 0x44, 0x90, 0x48, 0x24, 0x12, 0x09, 0x04, 0x82, 0x40, 0x15, 0x93, 0x7F, 0x9F, 0x1F, 0x47,
+			0x9F, 0x1F, 0x47, 0x63, 0x1F, 0x7F, 0x51, 0x15, 0x3F, 0xA2, 0x15, 0xBF, 0xD5, 0xD2, 0xBF, 0x49,
+			0x2A, 0xBF, 0x7D, 0xAA, 0xBF, 0x14, 0xAA, 0xBF, 0xE4, 0xAA, 0xBF, 0x11, 0x17, 0xCF, 0x1F, 0x39,
+			0xAF, 0x4F, 0xBF, 0xFF, 0x7F, 0xBB, 0xBF, 0x19, 0xBF, 0x4D, 0xBF, 0xC5, 0xBF, 0x09, 0xBF, 0x13,
+			0x3F, 0x6F, 0xFF, 0x7F, 0x47, 0x7F, 0x7F, 0x47, 0x7F, 0x7F, 0x03, 0x9F, 0xAD, 0x2A, 0xBF, 0xAD,
+			0xBF, 0xC9, 0xBF, 0x4D, 0xBF, 0x65, 0xBF, 0x3D, 0xBF, 0xD1, 0xBF, 0xE0, 0x83, 0xF0, 0x24, 0x52,
+			0x24, 0xA2, 0x51, 0x28, 0x94, 0x4A, 0x3F, 0xFC, 0x01, 0x12, 0x49, 0x24, 0x92, 0x49, 0x24, 0x92,
+			0x49, 0x24, 0x92, 0x49, 0x24, 0x92, 0x4C, 0x0F, 0xB4, 0x8A, 0x44, 0x92, 0x49, 0x24, 0x92, 0x49,
+			0x9F, 0xC9, 0x14, 0x4A, 0x28, 0x90, 0x48, 0x24, 0x12, 0x09, 0x04, 0x82, 0x41, 0x38, 0x08, 0xFC,
+			0x0D, 0x14, 0x89, 0x28, 0x94, 0x4A, 0x25, 0x12, 0x8F, 0xF9, 0x22, 0x51, 0x24, 0x92, 0x49, 0x24,
+			0x92, 0x41, 0x20, 0x90, 0x48, 0x26, 0x3F, 0x02, 0x28, 0x92, 0x49, 0x24, 0x90, 0x48, 0x24, 0x13,
+			0x1F, 0x81, 0x22, 0x51, 0x28, 0x90, 0x48, 0x24, 0x12, 0x09, 0xC0, 0x47, 0xE6, 0x44, 0x94, 0x49,
+			0x24, 0xA2, 0x51, 0x28, 0x94, 0x4A, 0x3F, 0xF0, 0x89, 0x44, 0x92, 0x49, 0x24, 0x92, 0x49, 0x24,
+			0x92, 0x49, 0x24, 0x92, 0x4C, 0x3F, 0x02, 0x24, 0x92, 0x49, 0x24, 0x92, 0x49, 0x24, 0x93, 0x0F,
+			0xC0, 0x8A, 0x25, 0x12, 0x89, 0x24, 0x92, 0x49, 0x24, 0x80, 0x1F, 0xF2, 0x5E, 0x7F, 0x7F, 0x09,
+			0x08, 0x40, 0x97, 0xCB, 0x0F, 0x0D, 0xF7, 0x9F, 0xBF, 0x15, 0x60, 0x1D, 0xBF, 0x15, 0x0B, 0x99,
+			0xBF, 0x15, 0x74, 0xA1, 0xBF, 0x15, 0xF8, 0x75, 0xBF, 0x18, 0x6B, 0x9F, 0x7F, 0x47, 0x9F, 0x7F,
+			0x47, 0x9F, 0x7F, 0x47, 0x1A, 0x15, 0x0F, 0x1A, 0xB5, 0xBF, 0x35, 0x82, 0xBF, 0x4A, 0x49, 0xBF,
+			0x2A, 0x9A, 0xBF, 0x2A, 0x20, 0xBF, 0x2A, 0xEA, 0xBF, 0x2A, 0x62, 0xBF, 0x2A, 0x96, 0xBF, 0x10,
+			0x17, 0x7F, 0xFF, 0x7F, 0x0A, 0xBF, 0xDF, 0x7F, 0xBF, 0x7F, 0x5F, 0xBF, 0x2A, 0x0A, 0xBF, 0x2A,
+			0x4A, 0xBF, 0x2A, 0xEA, 0xBF, 0x03, 0x9F, 0x7F, 0xFF, 0x7F, 0xBF, 0x7F, 0xFF, 0x7F, 0xBF, 0xFF,
+			0x7F, 0x7F, 0xBF, 0x55, 0xBF, 0x15, 0xBF, 0x15, 0xBF, 0x55, 0xBF, 0x15, 0xBF, 0x15, 0xBF, 0x55,
+			0xBF, 0x1A, 0x75, 0x3F, 0x85, 0x7F, 0x7F, 0x65, 0x6B, 0x2D, 0xB1, 0x0F, 0x0F, 0x58, 0x34, 0x6E,
+			0xBF, 0x15, 0x06, 0x65, 0xBF, 0x15, 0x1C, 0xD1, 0xBF, 0x15, 0xC3, 0xA1, 0xBF, 0x15, 0xF6, 0x2D,
+			0xBF, 0x19, 0xBF, 0x9F, 0x7F, 0x10, 0x17, 0x85, 0x7F, 0xBF, 0x9F, 0x7F, 0xBF, 0x02, 0xAA, 0xBF,
+			0x4B, 0xAA, 0xBF, 0xE5, 0x9D, 0xBF, 0x10, 0xBF, 0x43, 0xBF, 0x28, 0xBF, 0xDC, 0xBF, 0x0B, 0x57,
+			0xAF, 0xFF, 0x7F, 0x47, 0x7F, 0xBF, 0x01, 0x7F, 0x0F, 0xBF, 0x95, 0x2A, 0xBF, 0x65, 0xBF, 0x05,
+			0xBF, 0x95, 0xBF, 0x01, 0xCF, 0xFF, 0x7F, 0x7F, 0xBF, 0xFF, 0x7F, 0x7F, 0xBF, 0xFF, 0x7F, 0x1F,
+			0xBF, 0xD5, 0xBF, 0x55, 0xBF, 0x15, 0xBF, 0xD5, 0xBF, 0x15, 0xFD, 0x89, 0x7F, 0x00, 0x41, 0xC7,
+			0x1F, 0xBF, 0x7F, 0x8F, 0xBF, 0x00, 0x1C, 0x2A, 0xBF, 0x00, 0x10, 0xAA, 0xBF, 0x00, 0xE3, 0xAA,
+			0xBF, 0x00, 0xEF, 0x2A, 0xBF, 0x00, 0x00, 0x2A, 0xBF, 0x1A, 0x53, 0x4F, 0x7F, 0x10, 0x17, 0x9F,
+			0x3F, 0xBF, 0x8F, 0x7F, 0xBF, 0x49, 0x45, 0xBF, 0x4A, 0x91, 0xBF, 0x2A, 0x08, 0xBF, 0x2A, 0x84,
+			0xBF, 0x2A, 0x1C, 0xBF, 0x2A, 0x50, 0xBF, 0x2A, 0xC0, 0xBF, 0x2A, 0x00, 0xBF, 0x0B, 0x57, 0x7F,
+			0x7F, 0x47, 0x7F, 0x7F, 0x47, 0x7F, 0x7F, 0x47, 0x15, 0xAA, 0x47, 0x15, 0xAA, 0x47, 0x15, 0x2A,
+			0x47, 0x15, 0x2A, 0x47, 0x0B, 0xCF, 0x7F, 0xFF, 0x7F, 0xBF, 0x7F, 0xFF, 0x7F, 0xBF, 0x7F, 0xFF,
+			0x7F, 0xBF, 0x2A, 0x2A, 0xBF, 0x2A, 0x2A, 0xBF, 0x2A, 0x2A, 0xBF, 0x2A, 0x2A, 0xBF, 0xFF, 0xD9 };
+
+		const uint8_t kGray16Reduced[] = {
+			5, 27, 89, 124, 114, 131, 193, 226, 14, 35, 106, 143, 124, 139, 210, 244,
+			64, 94, 93, 112, 165, 198, 197, 222, 87, 119, 100, 115, 186, 223, 208, 255,
+			65, 88, 141, 174, 173, 196, 193, 29, 70, 91, 162, 199, 180, 243, 2, 52,
+			120, 150, 149, 168, 233, 194, 97, 2, 140, 171, 161, 178, 220, 0, 109, 17 };
+
+		int GraySample(int x, int y)
+		{
+			return (x * 13 + y * 7 + ((x ^ y) & 5) * 9) & 0xFF;
+		}
+
+		int RgbSample(int x, int y, int c)
+		{
+			return c == 0 ? (x * 16) & 0xFF : (c == 1 ? (y * 16) & 0xFF : ((x + y) * 8) & 0xFF);
+		}
+
+		int StylesSample(int x, int y)
+		{
+			return (x * 331 + y * 97 + (x * y) % 7 * 40) & 0xFFF;
+		}
+
+		FrameInfo CreateInfo(uint16_t rows, uint16_t columns, uint16_t samples, uint16_t bits)
+		{
+			FrameInfo info;
+			info.rows = rows;
+			info.columns = columns;
+			info.samplesPerPixel = samples;
+			info.bitsAllocated = bits;
+			info.bitsStored = bits;
+			info.photometricInterpretation = samples == 3 ? "YBR_RCT" : "MONOCHROME2";
+			return info;
+		}
+
+		bool Decode(const uint8_t* data, size_t length, const FrameInfo& info, uint32_t reduction, std::vector<uint8_t>& output)
+		{
+			Jpeg2000Decoder decoder(true);
+			output.assign(info.Reduce(reduction).GetFrameLength(), 0);
+			std::string error;
+			return decoder.DecodeFrameReduced(data, length, info, reduction, output.data(), error);
+		}
+
+		// Largest difference between the decoded 8-bit grayscale and GraySample
+		int GrayError(const std::vector<uint8_t>& output)
+		{
+			int worst = 0;
+			for (int y = 0; y < 16; ++y)
+			{
+				for (int x = 0; x < 16; ++x)
+				{
+					worst = std::max(worst, std::abs(output[y * 16 + x] - GraySample(x, y)));
+				}
+			}
+			return worst;
+		}
+	}
+
+	TEST_CLASS(Jpeg2000CodecTests)
+	{
+	public:
+		TEST_METHOD(Jpeg2000Decoder_DecodeFrame_DecodesReversibleGrayscale)
+		{
+			std::vector<uint8_t> output;
+			Assert::IsTrue(Decode(kGray16, sizeof(kGray16), CreateInfo(16, 16, 1, 8), 0, output));
+			Assert::AreEqual(0, GrayError(output));
+		}
+
+		TEST_METHOD(Jpeg2000Decoder_DecodeFrame_DecodesTiledRgbWithComponentTransform)
+		{
+			FrameInfo info = CreateInfo(16, 16, 3, 8);
+			std::vector<uint8_t> output;
+			Assert::IsTrue(Decode(kRgbTiles16, sizeof(kRgbTiles16), info, 0, output));
+			for (int y = 0; y < 16; ++y)
+			{
+				for (int x = 0; x < 16; ++x)
+				{
+					for (int c = 0; c < 3; ++c)
+					{
+						Assert::AreEqual(RgbSample(x, y, c), static_cast<int>(output[(y * 16 + x) * 3 + c]));
+					}
+				}
+			}
+			Assert::AreEqual(std::string("RGB"), Jpeg2000Decoder(true).GetDecodedPhotometricInterpretation(info));
+		}
+
+		TEST_METHOD(Jpeg2000Decoder_DecodeFrame_DecodesIrreversibleWavelet)
+		{
+			std::vector<uint8_t> output;
+			Assert::IsTrue(Decode(kGray16Irreversible, sizeof(kGray16Irreversible), CreateInfo(16, 16, 1, 8), 0, output));
+			int error = GrayError(output);
+			Assert::IsTrue(error > 0 && error <= 5);
+		}
+
+		TEST_METHOD(Jpeg2000Decoder_DecodeFrame_HandlesCodeBlockStyles)
+		{
+			std::vector<uint8_t> output;
+			Assert::IsTrue(Decode(kStyles12x10, sizeof(kStyles12x10), CreateInfo(10, 12, 1, 16), 0, output));
+			for (int y = 0; y < 10; ++y)
+			{
+				for (int x = 0; x < 12; ++x)
+				{
+					size_t index = (y * 12 + x) * 2;
+					Assert::AreEqual(StylesSample(x, y), output[index] | (output[index + 1] << 8));
+				}
+			}
+		}
+
+		TEST_METHOD(Jpeg2000Decoder_DecodeFrameReduced_DecodesCoarseLevels)
+		{
+			std::vector<uint8_t> output;
+			Assert::IsTrue(Decode(kGray16, sizeof(kGray16), CreateInfo(16, 16, 1, 8), 1, output));
+			Assert::IsTrue(output == std::vector<uint8_t>(kGray16Reduced, kGray16Reduced + sizeof(kGray16Reduced)));
+
+			Assert::IsTrue(Decode(kRgbTiles16, sizeof(kRgbTiles16), CreateInfo(16, 16, 3, 8), 2, output));
+			Assert::AreEqual(static_cast<size_t>(4 * 4 * 3), output.size());
+
+			// Only two decomposition levels
+			Assert::IsFalse(Decode(kGray16, sizeof(kGray16), CreateInfo(16, 16, 1, 8), 3, output));
+		}
+
+		TEST_METHOD(Jpeg2000Decoder_DecodeFrame_RejectsMalformedInput)
+		{
+			Jpeg2000Decoder decoder(true);
+			FrameInfo info = CreateInfo(16, 16, 1, 8);
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+
+			// Packet data cut short
+			std::vector<uint8_t> codestream(kGray16, kGray16 + sizeof(kGray16));
+			std::vector<uint8_t> truncated(codestream.begin(), codestream.end() - 60);
+			Assert::IsFalse(decoder.DecodeFrame(truncated.data(), truncated.size(), info, output.data(), error));
+			Assert::IsFalse(error.empty());
+
+			// Image attributes disagree with SIZ
+			Assert::IsFalse(decoder.DecodeFrame(codestream.data(), codestream.size(), CreateInfo(8, 16, 1, 8), output.data(), error));
+			Assert::IsFalse(decoder.DecodeFrame(codestream.data(), codestream.size(), CreateInfo(16, 16, 3, 8), output.data(), error));
+
+			// HTJ2K capability bit in Rsiz
+			codestream[6] |= 0x40;
+			error.clear();
+			Assert::IsFalse(decoder.DecodeFrame(codestream.data(), codestream.size(), info, output.data(), error));
+			Assert::IsTrue(error.find("HTJ2K") != std::string::npos);
+
+			// Not a codestream
+			Assert::IsFalse(decoder.DecodeFrame(codestream.data() + 2, codestream.size() - 2, info, output.data(), error));
+		}
+
+		TEST_METHOD(Jpeg2000Decoder_IsRegisteredForJpeg2000)
+		{
+			std::shared_ptr<const PixelDecoder> lossless = CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEG2000Lossless);
+			std::shared_ptr<const PixelDecoder> lossy = CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEG2000);
+			Assert::IsTrue(lossless != nullptr && lossy != nullptr);
+			Assert::IsTrue((lossless->GetCapabilities() & CodecLossless) != 0);
+			Assert::IsTrue((lossy->GetCapabilities() & CodecLossy) != 0);
+			Assert::IsTrue((lossy->GetCapabilities() & CodecPartialDecode) != 0);
+			Assert::AreEqual(std::string("JPEG 2000"), TransferSyntax::GetName(TransferSyntax::JPEG2000));
+		}
+	};
+}
@@ -0,0 +1,236 @@
+// Unit tests for JpegBaselineDecoder class
+// Tests grayscale and subsampled color decoding, restart markers, reduced-size decoding and malformed input
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/JpegBaselineCodec.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		// Quality 100 JFIF files written by libjpeg with optimized Huffman tables.
+		// kGradient16: 16x16 grayscale, sample = 8x + 4y + 20.
+		// kQuadrants32: 32x32 RGB, 4:2:0, one flat color per 16x16 quadrant;
+		// the Restart variant has a restart interval of one MCU.
+		const uint8_t kGradient16[] = {
+			0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+			0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x10,
+			0x00, 0x10, 0x01, 0x01, 0x11, 0x00, 0xFF, 0xC4, 0x00, 0x15, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0x09, 0xFF, 0xC4, 0x00,
+			0x1C, 0x10, 0x00, 0x00, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x07, 0x08, 0x24, 0x34, 0x42, 0x53, 0x61, 0x71, 0xFF, 0xDA, 0x00, 0x08, 0x01,
+			0x01, 0x00, 0x00, 0x3F, 0x00, 0x3D, 0xE9, 0xB4, 0xB6, 0x80, 0xDF, 0x15, 0x79, 0xA0, 0x80, 0x13,
+			0x69, 0x6D, 0x01, 0xBE, 0x2A, 0xF3, 0x42, 0x7F, 0xA6, 0xD2, 0xDA, 0x03, 0x7C, 0x55, 0xE6, 0x82,
+			0x00, 0x4D, 0xA5, 0xB4, 0x06, 0xF8, 0xAB, 0xCD, 0x0F, 0xFF, 0xD9 };
+
+		const uint8_t kQuadrants32[] = {
+			0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+			0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xC0,
+			0x00, 0x11, 0x08, 0x00, 0x20, 0x00, 0x20, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+			0x01, 0xFF, 0xC4, 0x00, 0x16, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x0B, 0xFF, 0xC4, 0x00, 0x14, 0x10, 0x01, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF,
+			0xC4, 0x00, 0x18, 0x01, 0x00, 0x02, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x09, 0x0A, 0x07, 0x08, 0x0B, 0xFF, 0xC4, 0x00, 0x14, 0x11, 0x01, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF,
+			0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00, 0x97, 0xE0, 0x29,
+			0x39, 0xA0, 0x14, 0x80, 0x04, 0x6E, 0xCE, 0x7D, 0x0F, 0xC0, 0x3D, 0x00, 0x84, 0x34, 0xC8, 0x00,
+			0xA3, 0xE2, 0x20, 0xFF, 0xD9 };
+
+		const uint8_t kQuadrants32Restart[] = {
+			0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+			0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0xC0,
+			0x00, 0x11, 0x08, 0x00, 0x20, 0x00, 0x20, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+			0x01, 0xFF, 0xC4, 0x00, 0x17, 0x00, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x06, 0x0A, 0xFF, 0xC4, 0x00, 0x14, 0x10, 0x01,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0xFF, 0xC4, 0x00, 0x18, 0x01, 0x00, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x09, 0x0A, 0x06, 0x07, 0xFF, 0xC4, 0x00, 0x14, 0x11, 0x01,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0xFF, 0xDD, 0x00, 0x04, 0x00, 0x01, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03,
+			0x11, 0x00, 0x3F, 0x00, 0x97, 0xE0, 0x02, 0x75, 0x40, 0x3F, 0xFF, 0xD0, 0xCF, 0x80, 0x5B, 0xE4,
+			0x3E, 0xFF, 0xD1, 0x83, 0xE0, 0x2A, 0x00, 0x13, 0xBF, 0xFF, 0xD2, 0xEB, 0xA0, 0x07, 0x1F, 0x6E,
+			0x1F, 0xFF, 0xD9 };
+
+		const uint8_t kQuadrantColors[4][3] = { { 200, 40, 40 }, { 40, 180, 60 }, { 30, 60, 210 }, { 230, 220, 200 } };
+
+		FrameInfo CreateInfo(uint16_t size, uint16_t samples)
+		{
+			FrameInfo info;
+			info.rows = size;
+			info.columns = size;
+			info.samplesPerPixel = samples;
+			info.bitsAllocated = 8;
+			info.bitsStored = 8;
+			info.photometricInterpretation = samples == 3 ? "YBR_FULL_422" : "MONOCHROME2";
+			return info;
+		}
+
+		bool Decode(const uint8_t* data, size_t length, const FrameInfo& info, uint32_t reduction, std::vector<uint8_t>& output)
+		{
+			JpegBaselineDecoder decoder;
+			output.assign(info.Reduce(reduction).GetFrameLength(), 0);
+			std::string error;
+			return decoder.DecodeFrameReduced(data, length, info, reduction, output.data(), error);
+		}
+
+		// Every sample of the reduced 16x16 gradient within tolerance of its box mean
+		bool GradientMatches(const std::vector<uint8_t>& output, uint32_t reduction, int tolerance)
+		{
+			int scale = 1 << reduction;
+			int size = 16 / scale;
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					// Mean of 8x + 4y over the box is the value at its center
+					int expected = 8 * x * scale + 4 * y * scale + 6 * (scale - 1) + 20;
+					if (std::abs(output[y * size + x] - expected) > tolerance)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		bool QuadrantsMatch(const std::vector<uint8_t>& output, uint32_t reduction, int tolerance)
+		{
+			int size = 32 >> reduction;
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					const uint8_t* expected = kQuadrantColors[(y * 2 / size) * 2 + x * 2 / size];
+					for (int c = 0; c < 3; ++c)
+					{
+						if (std::abs(output[(y * size + x) * 3 + c] - expected[c]) > tolerance)
+						{
+							return false;
+						}
+					}
+				}
+			}
+			return true;
+		}
+	}
+
+	TEST_CLASS(JpegBaselineCodecTests)
+	{
+	public:
+		TEST_METHOD(JpegBaselineDecoder_DecodeFrame_DecodesGrayscale)
+		{
+			JpegBaselineDecoder decoder;
+			FrameInfo info = CreateInfo(16, 1);
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+			Assert::IsTrue(decoder.DecodeFrame(kGradient16, sizeof(kGradient16), info, output.data(), error));
+			Assert::IsTrue(GradientMatches(output, 0, 1));
+			Assert::AreEqual(std::string("MONOCHROME2"), decoder.GetDecodedPhotometricInterpretation(info));
+		}
+
+		TEST_METHOD(JpegBaselineDecoder_DecodeFrame_ConvertsSubsampledColorToRgb)
+		{
+			FrameInfo info = CreateInfo(32, 3);
+			std::vector<uint8_t> output;
+			Assert::IsTrue(Decode(kQuadrants32, sizeof(kQuadrants32), info, 0, output));
+			Assert::IsTrue(QuadrantsMatch(output, 0, 2));
+			Assert::AreEqual(std::string("RGB"), JpegBaselineDecoder().GetDecodedPhotometricInterpretation(info));
+		}
+
+		TEST_METHOD(JpegBaselineDecoder_DecodeFrame_HandlesRestartMarkers)
+		{
+			FrameInfo info = CreateInfo(32, 3);
+			std::vector<uint8_t> plain;
+			std::vector<uint8_t> restarted;
+			Assert::IsTrue(Decode(kQuadrants32, sizeof(kQuadrants32), info, 0, plain));
+			Assert::IsTrue(Decode(kQuadrants32Restart, sizeof(kQuadrants32Restart), info, 0, restarted));
+			Assert::IsTrue(plain == restarted);
+		}
+
+		TEST_METHOD(JpegBaselineDecoder_DecodeFrameReduced_ProducesBoxMeans)
+		{
+			for (uint32_t reduction = 1; reduction <= 3; ++reduction)
+			{
+				std::vector<uint8_t> output;
+				Assert::IsTrue(Decode(kGradient16, sizeof(kGradient16), CreateInfo(16, 1), reduction, output));
+				Assert::AreEqual(static_cast<size_t>(256 >> (2 * reduction)), output.size());
+				Assert::IsTrue(GradientMatches(output, reduction, 1));
+
+				Assert::IsTrue(Decode(kQuadrants32Restart, sizeof(kQuadrants32Restart), CreateInfo(32, 3), reduction, output));
+				Assert::IsTrue(QuadrantsMatch(output, reduction, 2));
+			}
+
+			std::vector<uint8_t> output;
+			Assert::IsFalse(Decode(kGradient16, sizeof(kGradient16), CreateInfo(16, 1), 4, output));
+		}
+
+		TEST_METHOD(JpegBaselineDecoder_DecodeFrame_RejectsMalformedInput)
+		{
+			JpegBaselineDecoder decoder;
+			FrameInfo info = CreateInfo(16, 1);
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+
+			// Entropy data cut short
+			std::vector<uint8_t> jpeg(kGradient16, kGradient16 + sizeof(kGradient16));
+			std::vector<uint8_t> truncated(jpeg.begin(), jpeg.end() - 40);
+			Assert::IsFalse(decoder.DecodeFrame(truncated.data(), truncated.size(), info, output.data(), error));
+			Assert::IsFalse(error.empty());
+
+			// Image attributes disagree with the frame header
+			Assert::IsFalse(decoder.DecodeFrame(jpeg.data(), jpeg.size(), CreateInfo(8, 1), output.data(), error));
+
+			// Progressive (SOF2) frame
+			for (size_t i = 0; i + 1 < jpeg.size(); ++i)
+			{
+				if (jpeg[i] == 0xFF && jpeg[i + 1] == 0xC0)
+				{
+					jpeg[i + 1] = 0xC2;
+					break;
+				}
+			}
+			error.clear();
+			Assert::IsFalse(decoder.DecodeFrame(jpeg.data(), jpeg.size(), info, output.data(), error));
+			Assert::IsFalse(error.empty());
+
+			// 16-bit images are not baseline
+			info.bitsAllocated = 16;
+			Assert::IsFalse(decoder.DecodeFrame(kGradient16, sizeof(kGradient16), info, output.data(), error));
+		}
+
+		TEST_METHOD(JpegBaselineDecoder_IsRegisteredForJpegBaseline)
+		{
+			std::shared_ptr<const PixelDecoder> decoder = CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEGBaseline);
+			Assert::IsTrue(decoder != nullptr);
+			Assert::IsTrue((decoder->GetCapabilities() & CodecPartialDecode) != 0);
+		}
+	};
+}
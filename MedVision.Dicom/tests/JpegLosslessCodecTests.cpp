@@ -0,0 +1,356 @@
+// Unit tests for JpegLosslessDecoder class
+// Tests predictors, precisions, scan layouts, restart intervals and malformed input
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/JpegLosslessCodec.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		// Categories 0-2 get 2-bit codes and category n > 2 an n-bit code, so large
+		// differences exercise the decoder's long-code path
+		const uint8_t kCounts[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+
+		class BitWriter
+		{
+		public:
+			explicit BitWriter(std::vector<uint8_t>& output) : output_(output), bits_(0), count_(0) {}
+
+			void Put(uint32_t value, int count)
+			{
+				for (int i = count - 1; i >= 0; --i)
+				{
+					bits_ = (bits_ << 1) | ((value >> i) & 1);
+					if (++count_ == 8)
+					{
+						Emit();
+					}
+				}
+			}
+
+			// Pad the last byte with one bits
+			void Flush()
+			{
+				while (count_ != 0)
+				{
+					Put(1, 1);
+				}
+			}
+
+		private:
+			void Emit()
+			{
+				output_.push_back(static_cast<uint8_t>(bits_));
+				if (bits_ == 0xFF)
+				{
+					output_.push_back(0x00);
+				}
+				bits_ = 0;
+				count_ = 0;
+			}
+
+			std::vector<uint8_t>& output_;
+			uint32_t bits_;
+			int count_;
+		};
+
+		struct EncodeOptions
+		{
+			int precision = 16;
+			int predictor = 1;
+			int pointTransform = 0;
+			int restartRows = 0;
+			bool interleaved = true;
+		};
+
+		void PutSegment(std::vector<uint8_t>& jpeg, uint8_t marker, const std::vector<uint8_t>& body)
+		{
+			jpeg.push_back(0xFF);
+			jpeg.push_back(marker);
+			jpeg.push_back(static_cast<uint8_t>((body.size() + 2) >> 8));
+			jpeg.push_back(static_cast<uint8_t>(body.size() + 2));
+			jpeg.insert(jpeg.end(), body.begin(), body.end());
+		}
+
+		int32_t Predict(int predictor, int32_t a, int32_t b, int32_t c)
+		{
+			switch (predictor)
+			{
+			case 1: return a;
+			case 2: return b;
+			case 3: return c;
+			case 4: return a + b - c;
+			case 5: return a + ((b - c) >> 1);
+			case 6: return b + ((a - c) >> 1);
+			default: return (a + b) >> 1;
+			}
+		}
+
+		// Reference Process 14 encoder (interleaved samples, one sample per pixel per component)
+		std::vector<uint8_t> EncodeLossless(const std::vector<uint16_t>& samples, int rows, int columns, int components, const EncodeOptions& options)
+		{
+			uint32_t codes[17];
+			int lengths[17];
+			uint32_t code = 0;
+			int symbol = 0;
+			for (int length = 1; length <= 16; ++length, code <<= 1)
+			{
+				for (int i = 0; i < kCounts[length - 1]; ++i, ++code, ++symbol)
+				{
+					codes[symbol] = code;
+					lengths[symbol] = length;
+				}
+			}
+
+			std::vector<uint8_t> jpeg = { 0xFF, 0xD8 };
+			std::vector<uint8_t> sof = { static_cast<uint8_t>(options.precision),
+				static_cast<uint8_t>(rows >> 8), static_cast<uint8_t>(rows),
+				static_cast<uint8_t>(columns >> 8), static_cast<uint8_t>(columns), static_cast<uint8_t>(components) };
+			for (int c = 0; c < components; ++c)
+			{
+				sof.push_back(static_cast<uint8_t>(c + 1));
+				sof.push_back(0x11);
+				sof.push_back(0);
+			}
+			PutSegment(jpeg, 0xC3, sof);
+
+			std::vector<uint8_t> dht = { 0x00 };
+			dht.insert(dht.end(), kCounts, kCounts + 16);
+			for (int i = 0; i < 17; ++i)
+			{
+				dht.push_back(static_cast<uint8_t>(i));
+			}
+			PutSegment(jpeg, 0xC4, dht);
+
+			if (options.restartRows > 0)
+			{
+				int interval = options.restartRows * columns;
+				PutSegment(jpeg, 0xDD, { static_cast<uint8_t>(interval >> 8), static_cast<uint8_t>(interval) });
+			}
+
+			int scanCount = options.interleaved ? 1 : components;
+			for (int scanIndex = 0; scanIndex < scanCount; ++scanIndex)
+			{
+				std::vector<int> scanComponents;
+				for (int c = 0; c < components; ++c)
+				{
+					if (options.interleaved || c == scanIndex)
+					{
+						scanComponents.push_back(c);
+					}
+				}
+
+				std::vector<uint8_t> sos = { static_cast<uint8_t>(scanComponents.size()) };
+				for (int c : scanComponents)
+				{
+					sos.push_back(static_cast<uint8_t>(c + 1));
+					sos.push_back(0x00);
+				}
+				sos.push_back(static_cast<uint8_t>(options.predictor));
+				sos.push_back(0);
+				sos.push_back(static_cast<uint8_t>(options.pointTransform));
+				PutSegment(jpeg, 0xDA, sos);
+
+				BitWriter writer(jpeg);
+				bool firstRow = true;
+				int restartIndex = 0;
+				auto value = [&](int x, int y, int c) { return static_cast<int32_t>(samples[(y * columns + x) * components + c] >> options.pointTransform); };
+				for (int y = 0; y < rows; ++y)
+				{
+					if (options.restartRows > 0 && y > 0 && y % options.restartRows == 0)
+					{
+						writer.Flush();
+						jpeg.push_back(0xFF);
+						jpeg.push_back(static_cast<uint8_t>(0xD0 + (restartIndex++ % 8)));
+						firstRow = true;
+					}
+					for (int x = 0; x < columns; ++x)
+					{
+						for (int c : scanComponents)
+						{
+							int32_t prediction;
+							if (x == 0)
+							{
+								prediction = firstRow ? (1 << (options.precision - options.pointTransform - 1)) : value(x, y - 1, c);
+							}
+							else
+							{
+								prediction = firstRow ? value(x - 1, y, c)
+									: Predict(options.predictor, value(x - 1, y, c), value(x, y - 1, c), value(x - 1, y - 1, c));
+							}
+
+							int32_t difference = (value(x, y, c) - prediction) & 0xFFFF;
+							if (difference == 0x8000)
+							{
+								writer.Put(codes[16], lengths[16]);
+								continue;
+							}
+							if (difference > 0x8000)
+							{
+								difference -= 0x10000;
+							}
+							int category = 0;
+							while ((difference < 0 ? -difference : difference) >= (1 << category))
+							{
+								++category;
+							}
+							writer.Put(codes[category], lengths[category]);
+							writer.Put(static_cast<uint32_t>(difference < 0 ? difference + (1 << category) - 1 : difference), category);
+						}
+					}
+					firstRow = false;
+				}
+				writer.Flush();
+			}
+
+			jpeg.push_back(0xFF);
+			jpeg.push_back(0xD9);
+			return jpeg;
+		}
+
+		std::vector<uint16_t> CreateImage(int rows, int columns, int components, int precision)
+		{
+			std::vector<uint16_t> samples(static_cast<size_t>(rows) * columns * components);
+			uint32_t seed = 12345;
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				seed = seed * 1103515245u + 12345u;
+				size_t x = (i / components) % columns;
+				uint32_t smooth = static_cast<uint32_t>(x * 40 + (i / (columns * components)) * 25);
+				uint32_t noise = (seed >> 16) % 64;
+				samples[i] = static_cast<uint16_t>((smooth + noise) & ((1u << precision) - 1));
+			}
+			return samples;
+		}
+
+		FrameInfo CreateInfo(int rows, int columns, int components, int bitsAllocated)
+		{
+			FrameInfo info;
+			info.rows = static_cast<uint16_t>(rows);
+			info.columns = static_cast<uint16_t>(columns);
+			info.samplesPerPixel = static_cast<uint16_t>(components);
+			info.bitsAllocated = static_cast<uint16_t>(bitsAllocated);
+			info.bitsStored = static_cast<uint16_t>(bitsAllocated);
+			return info;
+		}
+
+		bool DecodeAndCompare(const std::vector<uint8_t>& jpeg, const std::vector<uint16_t>& expected, const FrameInfo& info)
+		{
+			JpegLosslessDecoder decoder;
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+			if (!decoder.DecodeFrame(jpeg.data(), jpeg.size(), info, output.data(), error))
+			{
+				return false;
+			}
+			for (size_t i = 0; i < expected.size(); ++i)
+			{
+				uint16_t sample = info.bitsAllocated == 8 ? output[i]
+					: static_cast<uint16_t>(output[i * 2] | (output[i * 2 + 1] << 8));
+				if (sample != expected[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	TEST_CLASS(JpegLosslessCodecTests)
+	{
+	public:
+		TEST_METHOD(JpegLosslessDecoder_DecodeFrame_DecodesEveryPredictor)
+		{
+			std::vector<uint16_t> image = CreateImage(19, 33, 1, 12);
+			for (int predictor = 1; predictor <= 7; ++predictor)
+			{
+				EncodeOptions options;
+				options.precision = 12;
+				options.predictor = predictor;
+				Assert::IsTrue(DecodeAndCompare(EncodeLossless(image, 19, 33, 1, options), image, CreateInfo(19, 33, 1, 16)));
+			}
+		}
+
+		TEST_METHOD(JpegLosslessDecoder_DecodeFrame_Decodes16BitFullRange)
+		{
+			// Alternating 0 / 0x8000 produces the 32768 difference (category 16)
+			std::vector<uint16_t> image = CreateImage(8, 40, 1, 16);
+			for (size_t i = 0; i < 40; ++i)
+			{
+				image[i] = (i % 2 == 0) ? 0 : 0x8000;
+				image[image.size() - 1 - i] = 0xFFFF;
+			}
+
+			EncodeOptions options;
+			options.predictor = 1;
+			Assert::IsTrue(DecodeAndCompare(EncodeLossless(image, 8, 40, 1, options), image, CreateInfo(8, 40, 1, 16)));
+		}
+
+		TEST_METHOD(JpegLosslessDecoder_DecodeFrame_DecodesInterleavedAndSeparateScans)
+		{
+			std::vector<uint16_t> image = CreateImage(11, 17, 3, 8);
+			EncodeOptions options;
+			options.precision = 8;
+			options.predictor = 6;
+			Assert::IsTrue(DecodeAndCompare(EncodeLossless(image, 11, 17, 3, options), image, CreateInfo(11, 17, 3, 8)));
+
+			options.interleaved = false;
+			Assert::IsTrue(DecodeAndCompare(EncodeLossless(image, 11, 17, 3, options), image, CreateInfo(11, 17, 3, 8)));
+		}
+
+		TEST_METHOD(JpegLosslessDecoder_DecodeFrame_HandlesRestartsAndPointTransform)
+		{
+			std::vector<uint16_t> image = CreateImage(20, 24, 1, 12);
+			for (uint16_t& sample : image)
+			{
+				sample = static_cast<uint16_t>(sample & ~3u);
+			}
+
+			EncodeOptions options;
+			options.precision = 12;
+			options.predictor = 7;
+			options.pointTransform = 2;
+			options.restartRows = 3;
+			Assert::IsTrue(DecodeAndCompare(EncodeLossless(image, 20, 24, 1, options), image, CreateInfo(20, 24, 1, 16)));
+		}
+
+		TEST_METHOD(JpegLosslessDecoder_DecodeFrame_RejectsMalformedInput)
+		{
+			std::vector<uint16_t> image = CreateImage(16, 16, 1, 12);
+			EncodeOptions options;
+			options.precision = 12;
+			std::vector<uint8_t> jpeg = EncodeLossless(image, 16, 16, 1, options);
+
+			JpegLosslessDecoder decoder;
+			FrameInfo info = CreateInfo(16, 16, 1, 16);
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+
+			// Entropy data cut short
+			std::vector<uint8_t> truncated(jpeg.begin(), jpeg.begin() + jpeg.size() / 2);
+			Assert::IsFalse(decoder.DecodeFrame(truncated.data(), truncated.size(), info, output.data(), error));
+			Assert::IsFalse(error.empty());
+
+			// Image attributes disagree with the frame header
+			Assert::IsFalse(decoder.DecodeFrame(jpeg.data(), jpeg.size(), CreateInfo(16, 8, 1, 16), output.data(), error));
+
+			// Baseline (SOF0) frame
+			std::vector<uint8_t> baseline = jpeg;
+			baseline[3] = 0xC0;
+			Assert::IsFalse(decoder.DecodeFrame(baseline.data(), baseline.size(), info, output.data(), error));
+		}
+
+		TEST_METHOD(JpegLosslessDecoder_IsRegisteredForLosslessSyntaxes)
+		{
+			Assert::IsNotNull(CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEGLossless).get());
+			Assert::IsNotNull(CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEGLosslessSV1).get());
+		}
+	};
+}
@@ -0,0 +1,827 @@
+// Unit tests for JpegLsDecoder class
+// Tests precisions, interleave modes, near-lossless coding, presets, restarts,
+// malformed input and decode throughput against an uncompressed frame copy
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/JpegLsCodec.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		const int kJ[32] = { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+			4, 4, 5, 5, 6, 6, 7, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+		// A byte following 0xFF carries only 7 bits (its top bit is a stuffed zero)
+		class LsBitWriter
+		{
+		public:
+			explicit LsBitWriter(std::vector<uint8_t>& output) : output_(output), byte_(0), count_(0), capacity_(8) {}
+
+			void Put(uint32_t value, int count)
+			{
+				for (int i = count - 1; i >= 0; --i)
+				{
+					byte_ = (byte_ << 1) | (i < 32 ? (value >> i) & 1 : 0);
+					if (++count_ == capacity_)
+					{
+						output_.push_back(static_cast<uint8_t>(byte_));
+						capacity_ = (byte_ == 0xFF) ? 7 : 8;
+						byte_ = 0;
+						count_ = 0;
+					}
+				}
+			}
+
+			// Pad the last byte with zero bits; a final 0xFF still gets its stuffed byte
+			void Flush()
+			{
+				while (count_ != 0)
+				{
+					Put(0, 1);
+				}
+				if (capacity_ == 7)
+				{
+					output_.push_back(0x00);
+					capacity_ = 8;
+				}
+			}
+
+		private:
+			std::vector<uint8_t>& output_;
+			uint32_t byte_;
+			int count_;
+			int capacity_;
+		};
+
+		struct EncodeOptions
+		{
+			int precision = 12;
+			int near = 0;
+			int interleave = 0;
+			int restartRows = 0;
+			int t1 = 0;        // Preset parameters; an LSE segment is written if any is set
+			int t2 = 0;
+			int t3 = 0;
+			int reset = 0;
+		};
+
+		// Reference T.87 encoder, written from the standard's encoding procedures
+		class ReferenceEncoder
+		{
+		public:
+			ReferenceEncoder(const EncodeOptions& options, LsBitWriter& writer) : writer_(writer)
+			{
+				near_ = options.near;
+				maxValue_ = (1 << options.precision) - 1;
+				range_ = (maxValue_ + 2 * near_) / (2 * near_ + 1) + 1;
+				qbpp_ = 0;
+				while ((1 << qbpp_) < range_)
+				{
+					++qbpp_;
+				}
+				int bpp = std::max(2, options.precision);
+				limit_ = 2 * (bpp + std::max(8, bpp));
+				reset_ = options.reset != 0 ? options.reset : 64;
+
+				if (maxValue_ >= 128)
+				{
+					int factor = (std::min(maxValue_, 4095) + 128) / 256;
+					t1_ = Clamp(factor * 1 + 2 + 3 * near_, near_ + 1);
+					t2_ = Clamp(factor * 4 + 3 + 5 * near_, t1_);
+					t3_ = Clamp(factor * 17 + 4 + 7 * near_, t2_);
+				}
+				else
+				{
+					int factor = 256 / (maxValue_ + 1);
+					t1_ = Clamp(std::max(2, 3 / factor + 3 * near_), near_ + 1);
+					t2_ = Clamp(std::max(3, 7 / factor + 5 * near_), t1_);
+					t3_ = Clamp(std::max(4, 21 / factor + 7 * near_), t2_);
+				}
+				t1_ = options.t1 != 0 ? options.t1 : t1_;
+				t2_ = options.t2 != 0 ? options.t2 : t2_;
+				t3_ = options.t3 != 0 ? options.t3 : t3_;
+				Reset();
+			}
+
+			void Reset()
+			{
+				for (int q = 0; q < 367; ++q)
+				{
+					a_[q] = std::max(2, (range_ + 32) / 64);
+					b_[q] = 0;
+					c_[q] = 0;
+					n_[q] = 1;
+				}
+				nn_[0] = 0;
+				nn_[1] = 0;
+			}
+
+			// Regular mode sample; returns the reconstructed value
+			int Regular(int ix, int ra, int rb, int rc, int rd)
+			{
+				int q1 = Quantize(rd - rb);
+				int q2 = Quantize(rb - rc);
+				int q3 = Quantize(rc - ra);
+				int sign = 1;
+				if (q1 < 0 || (q1 == 0 && q2 < 0) || (q1 == 0 && q2 == 0 && q3 < 0))
+				{
+					q1 = -q1;
+					q2 = -q2;
+					q3 = -q3;
+					sign = -1;
+				}
+				int q = 81 * q1 + 9 * q2 + q3;
+
+				int px;
+				if (rc >= std::max(ra, rb))
+				{
+					px = std::min(ra, rb);
+				}
+				else if (rc <= std::min(ra, rb))
+				{
+					px = std::max(ra, rb);
+				}
+				else
+				{
+					px = ra + rb - rc;
+				}
+				px = std::min(std::max(px + sign * c_[q], 0), maxValue_);
+
+				int errval = sign * (ix - px);
+				int rx;
+				errval = QuantizeError(errval, px, sign, rx);
+
+				int k = 0;
+				while ((n_[q] << k) < a_[q])
+				{
+					++k;
+				}
+				int mapped;
+				if (near_ == 0 && k == 0 && 2 * b_[q] <= -n_[q])
+				{
+					mapped = errval >= 0 ? 2 * errval + 1 : -2 * (errval + 1);
+				}
+				else
+				{
+					mapped = errval >= 0 ? 2 * errval : -2 * errval - 1;
+				}
+				Golomb(mapped, k, limit_);
+
+				b_[q] += errval * (2 * near_ + 1);
+				a_[q] += std::abs(errval);
+				if (n_[q] == reset_)
+				{
+					a_[q] >>= 1;
+					b_[q] >>= 1;
+					n_[q] >>= 1;
+				}
+				++n_[q];
+				if (b_[q] <= -n_[q])
+				{
+					b_[q] += n_[q];
+					if (c_[q] > -128)
+					{
+						--c_[q];
+					}
+					if (b_[q] <= -n_[q])
+					{
+						b_[q] = -n_[q] + 1;
+					}
+				}
+				else if (b_[q] > 0)
+				{
+					b_[q] -= n_[q];
+					if (c_[q] < 127)
+					{
+						++c_[q];
+					}
+					if (b_[q] > 0)
+					{
+						b_[q] = 0;
+					}
+				}
+				return rx;
+			}
+
+			// Run of runCount samples; endOfLine when the run reached the line end
+			void Run(int runCount, bool endOfLine, int& runIndex)
+			{
+				while (runCount >= (1 << kJ[runIndex]))
+				{
+					writer_.Put(1, 1);
+					runCount -= 1 << kJ[runIndex];
+					if (runIndex < 31)
+					{
+						++runIndex;
+					}
+				}
+				if (endOfLine)
+				{
+					if (runCount > 0)
+					{
+						writer_.Put(1, 1);
+					}
+				}
+				else
+				{
+					writer_.Put(0, 1);
+					writer_.Put(static_cast<uint32_t>(runCount), kJ[runIndex]);
+				}
+			}
+
+			// Run interruption sample; interleaved forces RItype 0 with the
+			// prediction taken from the sample above
+			int Interruption(int ix, int ra, int rb, int runIndex, bool interleaved)
+			{
+				int type = (!interleaved && std::abs(ra - rb) <= near_) ? 1 : 0;
+				int px = type == 1 ? ra : rb;
+				int sign = interleaved ? (rb >= ra ? 1 : -1) : (type == 0 && ra > rb ? -1 : 1);
+				int errval = sign * (ix - px);
+				int rx;
+				errval = QuantizeError(errval, px, sign, rx);
+
+				int q = 365 + type;
+				int temp = type == 0 ? a_[q] : a_[q] + (n_[q] >> 1);
+				int k = 0;
+				while ((n_[q] << k) < temp)
+				{
+					++k;
+				}
+				int map = 0;
+				if ((k == 0 && errval > 0 && 2 * nn_[type] < n_[q]) ||
+					(errval < 0 && 2 * nn_[type] >= n_[q]) ||
+					(errval < 0 && k != 0))
+				{
+					map = 1;
+				}
+				int mapped = 2 * std::abs(errval) - type - map;
+				Golomb(mapped, k, limit_ - kJ[runIndex] - 1);
+
+				if (errval < 0)
+				{
+					++nn_[type];
+				}
+				a_[q] += (mapped + 1 - type) >> 1;
+				if (n_[q] == reset_)
+				{
+					a_[q] >>= 1;
+					n_[q] >>= 1;
+					nn_[type] >>= 1;
+				}
+				++n_[q];
+				return rx;
+			}
+
+			int Quantize(int d) const
+			{
+				if (d <= -t3_) return -4;
+				if (d <= -t2_) return -3;
+				if (d <= -t1_) return -2;
+				if (d < -near_) return -1;
+				if (d <= near_) return 0;
+				if (d < t1_) return 1;
+				if (d < t2_) return 2;
+				if (d < t3_) return 3;
+				return 4;
+			}
+
+			int GetNear() const { return near_; }
+
+		private:
+			int Clamp(int value, int lower) const
+			{
+				return (value > maxValue_ || value < lower) ? lower : value;
+			}
+
+			// Quantize errval for NEAR, reconstruct into rx and reduce modulo RANGE
+			int QuantizeError(int errval, int px, int sign, int& rx) const
+			{
+				if (near_ > 0)
+				{
+					errval = errval > 0 ? (near_ + errval) / (2 * near_ + 1) : -(near_ - errval) / (2 * near_ + 1);
+				}
+				rx = std::min(std::max(px + sign * errval * (2 * near_ + 1), 0), maxValue_);
+				if (errval < 0)
+				{
+					errval += range_;
+				}
+				if (errval >= (range_ + 1) / 2)
+				{
+					errval -= range_;
+				}
+				return errval;
+			}
+
+			void Golomb(int value, int k, int limit)
+			{
+				int escape = limit - qbpp_ - 1;
+				if ((value >> k) < escape)
+				{
+					writer_.Put(0, value >> k);
+					writer_.Put(1, 1);
+					writer_.Put(static_cast<uint32_t>(value) & ((1u << k) - 1), k);
+				}
+				else
+				{
+					writer_.Put(0, escape);
+					writer_.Put(1, 1);
+					writer_.Put(static_cast<uint32_t>(value - 1), qbpp_);
+				}
+			}
+
+			LsBitWriter& writer_;
+			int near_;
+			int maxValue_;
+			int range_;
+			int qbpp_;
+			int limit_;
+			int reset_;
+			int t1_;
+			int t2_;
+			int t3_;
+			int a_[367];
+			int b_[367];
+			int c_[367];
+			int n_[367];
+			int nn_[2];
+		};
+
+		void PutSegment(std::vector<uint8_t>& jpeg, uint8_t marker, const std::vector<uint8_t>& body)
+		{
+			jpeg.push_back(0xFF);
+			jpeg.push_back(marker);
+			jpeg.push_back(static_cast<uint8_t>((body.size() + 2) >> 8));
+			jpeg.push_back(static_cast<uint8_t>(body.size() + 2));
+			jpeg.insert(jpeg.end(), body.begin(), body.end());
+		}
+
+		void PutUInt16(std::vector<uint8_t>& body, int value)
+		{
+			body.push_back(static_cast<uint8_t>(value >> 8));
+			body.push_back(static_cast<uint8_t>(value));
+		}
+
+		// Encodes interleaved samples; reconstructed receives the decoder's expected output
+		std::vector<uint8_t> EncodeLs(const std::vector<uint16_t>& samples, int rows, int columns, int components,
+			const EncodeOptions& options, std::vector<uint16_t>* reconstructed = nullptr)
+		{
+			std::vector<uint8_t> jpeg = { 0xFF, 0xD8 };
+			std::vector<uint8_t> sof = { static_cast<uint8_t>(options.precision) };
+			PutUInt16(sof, rows);
+			PutUInt16(sof, columns);
+			sof.push_back(static_cast<uint8_t>(components));
+			for (int c = 0; c < components; ++c)
+			{
+				sof.push_back(static_cast<uint8_t>(c + 1));
+				sof.push_back(0x11);
+				sof.push_back(0);
+			}
+			PutSegment(jpeg, 0xF7, sof);
+
+			if (options.t1 != 0 || options.t2 != 0 || options.t3 != 0 || options.reset != 0)
+			{
+				std::vector<uint8_t> lse = { 1 };
+				PutUInt16(lse, 0);
+				PutUInt16(lse, options.t1);
+				PutUInt16(lse, options.t2);
+				PutUInt16(lse, options.t3);
+				PutUInt16(lse, options.reset);
+				PutSegment(jpeg, 0xF8, lse);
+			}
+			if (options.restartRows > 0)
+			{
+				std::vector<uint8_t> dri;
+				PutUInt16(dri, options.restartRows);
+				PutSegment(jpeg, 0xDD, dri);
+			}
+
+			std::vector<int> recon(samples.size(), 0);
+			int scanCount = options.interleave == 0 ? components : 1;
+			for (int scanIndex = 0; scanIndex < scanCount; ++scanIndex)
+			{
+				std::vector<int> scanComponents;
+				for (int c = 0; c < components; ++c)
+				{
+					if (options.interleave != 0 || c == scanIndex)
+					{
+						scanComponents.push_back(c);
+					}
+				}
+
+				std::vector<uint8_t> sos = { static_cast<uint8_t>(scanComponents.size()) };
+				for (int c : scanComponents)
+				{
+					sos.push_back(static_cast<uint8_t>(c + 1));
+					sos.push_back(0);
+				}
+				sos.push_back(static_cast<uint8_t>(options.near));
+				sos.push_back(static_cast<uint8_t>(options.interleave));
+				sos.push_back(0);
+				PutSegment(jpeg, 0xDA, sos);
+
+				LsBitWriter writer(jpeg);
+				ReferenceEncoder encoder(options, writer);
+				const int near = encoder.GetNear();
+				int runIndex[4] = { 0, 0, 0, 0 };
+				int top = 0;
+				int restartIndex = 0;
+
+				auto value = [&](int x, int y, int c) { return static_cast<int>(samples[(y * columns + x) * components + c]); };
+				auto r = [&](int x, int y, int c) -> int& { return recon[(y * columns + x) * components + c]; };
+				// Neighbors a, b, c, d with the T.87 edge rules (lines above the interval are zero)
+				auto neighbors = [&](int x, int y, int c, int n[4]) {
+					if (y == top)
+					{
+						n[1] = n[2] = n[3] = 0;
+						n[0] = x > 0 ? r(x - 1, y, c) : 0;
+						return;
+					}
+					n[1] = r(x, y - 1, c);
+					n[3] = x + 1 < columns ? r(x + 1, y - 1, c) : n[1];
+					n[2] = x > 0 ? r(x - 1, y - 1, c) : (y - 1 > top ? r(0, y - 2, c) : 0);
+					n[0] = x > 0 ? r(x - 1, y, c) : n[1];
+				};
+				auto flat = [&](const int n[4]) {
+					return std::abs(n[3] - n[1]) <= near && std::abs(n[1] - n[2]) <= near && std::abs(n[2] - n[0]) <= near;
+				};
+
+				for (int y = 0; y < rows; ++y)
+				{
+					if (options.restartRows > 0 && y > 0 && y % options.restartRows == 0)
+					{
+						writer.Flush();
+						jpeg.push_back(0xFF);
+						jpeg.push_back(static_cast<uint8_t>(0xD0 + (restartIndex++ % 8)));
+						encoder.Reset();
+						std::fill(runIndex, runIndex + 4, 0);
+						top = y;
+					}
+
+					if (options.interleave == 2 && scanComponents.size() > 1)
+					{
+						int x = 0;
+						while (x < columns)
+						{
+							int n[4][4];
+							bool allFlat = true;
+							for (size_t k = 0; k < scanComponents.size(); ++k)
+							{
+								neighbors(x, y, scanComponents[k], n[k]);
+								allFlat = allFlat && flat(n[k]);
+							}
+							if (!allFlat)
+							{
+								for (size_t k = 0; k < scanComponents.size(); ++k)
+								{
+									int c = scanComponents[k];
+									r(x, y, c) = encoder.Regular(value(x, y, c), n[k][0], n[k][1], n[k][2], n[k][3]);
+								}
+								++x;
+								continue;
+							}
+
+							int runCount = 0;
+							auto inRun = [&](int xx) {
+								for (size_t k = 0; k < scanComponents.size(); ++k)
+								{
+									if (std::abs(value(xx, y, scanComponents[k]) - n[k][0]) > near)
+									{
+										return false;
+									}
+								}
+								return true;
+							};
+							while (x < columns && inRun(x))
+							{
+								for (size_t k = 0; k < scanComponents.size(); ++k)
+								{
+									r(x, y, scanComponents[k]) = n[k][0];
+								}
+								++runCount;
+								++x;
+							}
+							encoder.Run(runCount, x == columns, runIndex[0]);
+							if (x < columns)
+							{
+								for (size_t k = 0; k < scanComponents.size(); ++k)
+								{
+									int c = scanComponents[k];
+									int m[4];
+									neighbors(x, y, c, m);
+									r(x, y, c) = encoder.Interruption(value(x, y, c), m[0], m[1], runIndex[0], true);
+								}
+								runIndex[0] = std::max(0, runIndex[0] - 1);
+								++x;
+							}
+						}
+						continue;
+					}
+
+					for (size_t k = 0; k < scanComponents.size(); ++k)
+					{
+						int c = scanComponents[k];
+						int x = 0;
+						while (x < columns)
+						{
+							int n[4];
+							neighbors(x, y, c, n);
+							if (!flat(n))
+							{
+								r(x, y, c) = encoder.Regular(value(x, y, c), n[0], n[1], n[2], n[3]);
+								++x;
+								continue;
+							}
+
+							int runValue = n[0];
+							int runCount = 0;
+							while (x < columns && std::abs(value(x, y, c) - runValue) <= near)
+							{
+								r(x, y, c) = runValue;
+								++runCount;
+								++x;
+							}
+							encoder.Run(runCount, x == columns, runIndex[k]);
+							if (x < columns)
+							{
+								neighbors(x, y, c, n);
+								r(x, y, c) = encoder.Interruption(value(x, y, c), n[0], n[1], runIndex[k], false);
+								runIndex[k] = std::max(0, runIndex[k] - 1);
+								++x;
+							}
+						}
+					}
+				}
+				writer.Flush();
+			}
+
+			jpeg.push_back(0xFF);
+			jpeg.push_back(0xD9);
+			if (reconstructed != nullptr)
+			{
+				reconstructed->assign(recon.begin(), recon.end());
+			}
+			return jpeg;
+		}
+
+		// Smooth gradient with noise and flat patches, so both coding modes are used
+		std::vector<uint16_t> CreateImage(int rows, int columns, int components, int precision)
+		{
+			std::vector<uint16_t> samples(static_cast<size_t>(rows) * columns * components);
+			uint32_t seed = 12345;
+			const uint32_t mask = (1u << precision) - 1;
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				seed = seed * 1103515245u + 12345u;
+				size_t x = (i / components) % columns;
+				size_t y = i / (static_cast<size_t>(columns) * components);
+				if ((x / 8 + y / 6) % 3 == 0)
+				{
+					samples[i] = static_cast<uint16_t>(mask / 3);
+					continue;
+				}
+				uint32_t smooth = static_cast<uint32_t>(x * 40 + y * 25 + (i % components) * 300);
+				uint32_t noise = (seed >> 16) % 64;
+				samples[i] = static_cast<uint16_t>((smooth + noise) & mask);
+			}
+			return samples;
+		}
+
+		// 12-bit CT-like slice: air background around a noisy disc
+		std::vector<uint16_t> CreateSlice(int size)
+		{
+			std::vector<uint16_t> samples(static_cast<size_t>(size) * size);
+			uint32_t seed = 4321;
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					seed = seed * 1103515245u + 12345u;
+					int dx = x - size / 2;
+					int dy = y - size / 2;
+					bool inside = dx * dx + dy * dy < (size * size) / 6;
+					samples[static_cast<size_t>(y) * size + x] = inside
+						? static_cast<uint16_t>(1000 + (x + y) % 200 + (seed >> 16) % 24)
+						: 0;
+				}
+			}
+			return samples;
+		}
+
+		FrameInfo CreateInfo(int rows, int columns, int components, int bitsAllocated)
+		{
+			FrameInfo info;
+			info.rows = static_cast<uint16_t>(rows);
+			info.columns = static_cast<uint16_t>(columns);
+			info.samplesPerPixel = static_cast<uint16_t>(components);
+			info.bitsAllocated = static_cast<uint16_t>(bitsAllocated);
+			info.bitsStored = static_cast<uint16_t>(bitsAllocated);
+			return info;
+		}
+
+		bool DecodeAndCompare(const PixelDecoder& decoder, const std::vector<uint8_t>& jpeg,
+			const std::vector<uint16_t>& expected, const FrameInfo& info)
+		{
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+			if (!decoder.DecodeFrame(jpeg.data(), jpeg.size(), info, output.data(), error))
+			{
+				return false;
+			}
+			for (size_t i = 0; i < expected.size(); ++i)
+			{
+				uint16_t sample = info.bitsAllocated == 8 ? output[i]
+					: static_cast<uint16_t>(output[i * 2] | (output[i * 2 + 1] << 8));
+				if (sample != expected[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	TEST_CLASS(JpegLsCodecTests)
+	{
+	public:
+		TEST_METHOD(JpegLsDecoder_DecodeFrame_DecodesEveryPrecision)
+		{
+			JpegLsDecoder decoder(true);
+			const int precisions[] = { 2, 5, 8, 12, 16 };
+			for (int precision : precisions)
+			{
+				std::vector<uint16_t> image = CreateImage(23, 37, 1, precision);
+				EncodeOptions options;
+				options.precision = precision;
+				int bitsAllocated = precision <= 8 ? 8 : 16;
+				Assert::IsTrue(DecodeAndCompare(decoder, EncodeLs(image, 23, 37, 1, options), image, CreateInfo(23, 37, 1, bitsAllocated)));
+			}
+		}
+
+		TEST_METHOD(JpegLsDecoder_DecodeFrame_Decodes16BitFullRange)
+		{
+			// Extreme jumps need the escape code of the length-limited Golomb code
+			std::vector<uint16_t> image = CreateImage(9, 40, 1, 16);
+			for (size_t i = 0; i < 40; ++i)
+			{
+				image[i] = (i % 2 == 0) ? 0 : 0xFFFF;
+				image[image.size() - 1 - i] = 0xFFFF;
+			}
+
+			EncodeOptions options;
+			options.precision = 16;
+			Assert::IsTrue(DecodeAndCompare(JpegLsDecoder(true), EncodeLs(image, 9, 40, 1, options), image, CreateInfo(9, 40, 1, 16)));
+		}
+
+		TEST_METHOD(JpegLsDecoder_DecodeFrame_DecodesEveryInterleaveMode)
+		{
+			std::vector<uint16_t> image = CreateImage(14, 27, 3, 8);
+			JpegLsDecoder decoder(true);
+			for (int interleave = 0; interleave <= 2; ++interleave)
+			{
+				EncodeOptions options;
+				options.precision = 8;
+				options.interleave = interleave;
+				Assert::IsTrue(DecodeAndCompare(decoder, EncodeLs(image, 14, 27, 3, options), image, CreateInfo(14, 27, 3, 8)));
+			}
+		}
+
+		TEST_METHOD(JpegLsDecoder_DecodeFrame_DecodesNearLossless)
+		{
+			std::vector<uint16_t> image = CreateImage(31, 29, 3, 12);
+			std::shared_ptr<const PixelDecoder> decoder = CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEGLSNearLossless);
+			Assert::IsNotNull(decoder.get());
+			for (int interleave = 0; interleave <= 2; ++interleave)
+			{
+				EncodeOptions options;
+				options.near = 3;
+				options.interleave = interleave;
+				std::vector<uint16_t> reconstructed;
+				std::vector<uint8_t> jpeg = EncodeLs(image, 31, 29, 3, options, &reconstructed);
+				Assert::IsTrue(DecodeAndCompare(*decoder, jpeg, reconstructed, CreateInfo(31, 29, 3, 16)));
+
+				for (size_t i = 0; i < image.size(); ++i)
+				{
+					Assert::IsTrue(std::abs(static_cast<int>(reconstructed[i]) - image[i]) <= 3);
+				}
+			}
+		}
+
+		TEST_METHOD(JpegLsDecoder_DecodeFrame_HandlesRestartsAndPresets)
+		{
+			std::vector<uint16_t> image = CreateImage(20, 24, 3, 12);
+			EncodeOptions options;
+			options.interleave = 1;
+			options.restartRows = 3;
+			options.t1 = 5;
+			options.t2 = 40;
+			options.t3 = 300;
+			options.reset = 16;
+			Assert::IsTrue(DecodeAndCompare(JpegLsDecoder(true), EncodeLs(image, 20, 24, 3, options), image, CreateInfo(20, 24, 3, 16)));
+
+			options.interleave = 2;
+			options.near = 2;
+			std::vector<uint16_t> reconstructed;
+			std::vector<uint8_t> jpeg = EncodeLs(image, 20, 24, 3, options, &reconstructed);
+			Assert::IsTrue(DecodeAndCompare(JpegLsDecoder(false), jpeg, reconstructed, CreateInfo(20, 24, 3, 16)));
+		}
+
+		TEST_METHOD(JpegLsDecoder_DecodeFrame_RejectsMalformedInput)
+		{
+			std::vector<uint16_t> image = CreateImage(16, 16, 1, 12);
+			std::vector<uint8_t> jpeg = EncodeLs(image, 16, 16, 1, EncodeOptions());
+
+			JpegLsDecoder decoder(true);
+			FrameInfo info = CreateInfo(16, 16, 1, 16);
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+
+			// Entropy data cut short
+			std::vector<uint8_t> truncated(jpeg.begin(), jpeg.begin() + jpeg.size() / 2);
+			Assert::IsFalse(decoder.DecodeFrame(truncated.data(), truncated.size(), info, output.data(), error));
+			Assert::IsFalse(error.empty());
+
+			// Image attributes disagree with the frame header
+			Assert::IsFalse(decoder.DecodeFrame(jpeg.data(), jpeg.size(), CreateInfo(16, 8, 1, 16), output.data(), error));
+
+			// Scan using a mapping table (byte after the component id in SOS)
+			std::vector<uint8_t> mapped = jpeg;
+			size_t sos = 0;
+			while (!(mapped[sos] == 0xFF && mapped[sos + 1] == 0xDA))
+			{
+				++sos;
+			}
+			mapped[sos + 6] = 1;
+			Assert::IsFalse(decoder.DecodeFrame(mapped.data(), mapped.size(), info, output.data(), error));
+
+			// Lossless JPEG (SOF3) frame
+			std::vector<uint8_t> lossless = jpeg;
+			lossless[3] = 0xC3;
+			Assert::IsFalse(decoder.DecodeFrame(lossless.data(), lossless.size(), info, output.data(), error));
+		}
+
+		TEST_METHOD(JpegLsDecoder_IsRegisteredForJpegLsSyntaxes)
+		{
+			std::shared_ptr<const PixelDecoder> lossless = CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEGLSLossless);
+			std::shared_ptr<const PixelDecoder> nearLossless = CodecRegistry::Instance().FindDecoder(TransferSyntax::JPEGLSNearLossless);
+			Assert::IsNotNull(lossless.get());
+			Assert::IsNotNull(nearLossless.get());
+			Assert::IsTrue((lossless->GetCapabilities() & CodecLossless) != 0);
+			Assert::IsTrue((nearLossless->GetCapabilities() & CodecLossy) != 0);
+			Assert::AreEqual(std::string("JPEG-LS Lossless"), TransferSyntax::GetName(TransferSyntax::JPEGLSLossless));
+			Assert::IsTrue(TransferSyntax::IsCompressed(TransferSyntax::JPEGLSNearLossless));
+		}
+
+		TEST_METHOD(JpegLsDecoder_Benchmark_ThroughputAgainstUncompressed)
+		{
+			// Reports decoded MB/s next to a plain copy of the same frame, which is
+			// all an uncompressed frame costs; only correctness is asserted
+			const int size = 512;
+			const int iterations = 10;
+			std::vector<uint16_t> image = CreateSlice(size);
+			EncodeOptions options;
+			std::vector<uint8_t> jpeg = EncodeLs(image, size, size, 1, options);
+
+			JpegLsDecoder decoder(true);
+			FrameInfo info = CreateInfo(size, size, 1, 16);
+			Assert::IsTrue(DecodeAndCompare(decoder, jpeg, image, info));
+
+			std::vector<uint8_t> native(info.GetFrameLength());
+			std::memcpy(native.data(), image.data(), native.size());
+			std::vector<uint8_t> output(info.GetFrameLength());
+			std::string error;
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; ++i)
+			{
+				Assert::IsTrue(decoder.DecodeFrame(jpeg.data(), jpeg.size(), info, output.data(), error));
+			}
+			double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; ++i)
+			{
+				std::memcpy(output.data(), native.data(), native.size());
+				native[i % native.size()] ^= output[0];
+			}
+			double copySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			double megabytes = static_cast<double>(output.size()) * iterations / (1024.0 * 1024.0);
+			std::string message = "JPEG-LS 512x512x12 (" + std::to_string(jpeg.size()) + " bytes): " +
+				std::to_string(megabytes / decodeSeconds) + " MB/s decoded, " +
+				std::to_string(megabytes / std::max(copySeconds, 1e-9)) + " MB/s uncompressed copy\n";
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
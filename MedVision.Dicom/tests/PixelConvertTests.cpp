@@ -0,0 +1,533 @@
+// Unit tests for PixelConvert class
+// Tests that the SIMD conversion matches the scalar double precision reference bit for bit
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/PixelConvert.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	namespace
+	{
+		template <typename T>
+		float Reference(T sample, double slope, double intercept)
+		{
+			double value = static_cast<double>(sample) * slope;
+			return static_cast<float>(value + intercept);
+		}
+
+		// Compares bit patterns so that -0.0f and 0.0f count as different
+		template <typename T>
+		bool MatchesReference(const std::vector<T>& input, double slope, double intercept)
+		{
+			std::vector<float> output(input.size() + 1, 12345.0f);
+			PixelConvert::ToFloat(input.data(), input.size(), slope, intercept, output.data());
+			for (size_t i = 0; i < input.size(); ++i)
+			{
+				float expected = Reference(input[i], slope, intercept);
+				if (std::memcmp(&expected, &output[i], sizeof(float)) != 0)
+				{
+					return false;
+				}
+			}
+			return output[input.size()] == 12345.0f;
+		}
+
+		template <typename T>
+		std::vector<T> AllValues()
+		{
+			std::vector<T> values;
+			for (int32_t value = std::numeric_limits<T>::min(); value <= std::numeric_limits<T>::max(); ++value)
+			{
+				values.push_back(static_cast<T>(value));
+			}
+			return values;
+		}
+
+		// The bytes of values one byte past the start of the buffer, so no sample is aligned
+		template <typename T>
+		std::vector<uint8_t> MisalignedBytes(const std::vector<T>& values)
+		{
+			const uint8_t* first = reinterpret_cast<const uint8_t*>(values.data());
+			std::vector<uint8_t> bytes(1, 0);
+			bytes.insert(bytes.end(), first, first + values.size() * sizeof(T));
+			return bytes;
+		}
+
+		// Straightforward unpack, independent of the kernels' mask-and-xor trick
+		int64_t UnpackReference(uint32_t sample, const SampleLayout& layout)
+		{
+			int64_t value = (sample >> (layout.highBit + 1 - layout.bitsStored)) & ((1ull << layout.bitsStored) - 1);
+			if (layout.isSigned && (value & (1ll << (layout.bitsStored - 1))) != 0)
+			{
+				value -= 1ll << layout.bitsStored;
+			}
+			return value;
+		}
+
+		template <typename T>
+		bool MatchesLayoutReference(const std::vector<T>& input, const SampleLayout& layout, double slope, double intercept)
+		{
+			std::vector<float> output(input.size());
+			PixelConvert::ToFloat(input.data(), input.size(), layout, slope, intercept, output.data());
+			for (size_t i = 0; i < input.size(); ++i)
+			{
+				int64_t value = UnpackReference(input[i], layout);
+				float expected = Reference(value, slope, intercept);
+				if (layout.hasPadding && value >= std::min(layout.paddingValue, layout.paddingLimit)
+					&& value <= std::max(layout.paddingValue, layout.paddingLimit))
+				{
+					expected = layout.paddingOutput;
+				}
+				if (std::memcmp(&expected, &output[i], sizeof(float)) != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Edge cases first, then enough ordinary values to run the SIMD kernels
+		std::vector<float> NarrowingInputs()
+		{
+			std::vector<float> values = { 0.5f, 1.5f, 2.5f, -0.5f, -2.5f, 32767.4f, 32767.5f, -32768.6f, 65535.5f,
+				1e9f, -1e9f, std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+				-std::numeric_limits<float>::infinity(), 65504.0f, 65520.0f, 5.96046448e-8f, 2.98023224e-8f, -0.0f };
+			for (int i = 0; i < 1000; ++i)
+			{
+				values.push_back(static_cast<float>(i * 97 % 1000) * 91.37f - 40000.0f);
+			}
+			return values;
+		}
+
+		// The kernels must give what the scalar tail (a single value) gives
+		template <typename T>
+		bool NarrowMatchesScalar(const std::vector<float>& input)
+		{
+			std::vector<T> output(input.size());
+			PixelConvert::FromFloat(input.data(), input.size(), output.data());
+			for (size_t i = 0; i < input.size(); ++i)
+			{
+				T expected;
+				PixelConvert::FromFloat(&input[i], 1, &expected);
+				if (std::memcmp(&expected, &output[i], sizeof(T)) != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		const double Rescales[][2] = {
+			{ 1.0, 0.0 },
+			{ 1.0, -1024.0 },
+			{ 1.0, 0.5 },
+			{ 2.0, -1024.0 },
+			{ 0.000244140625, 0.0 },
+			{ 0.3, -7.1 },
+			{ -1.7, 1e6 },
+			{ 1e-30, 1e30 },
+			{ 1.0, 1e9 },
+		};
+	}
+
+	TEST_CLASS(PixelConvertTests)
+	{
+	public:
+		TEST_METHOD(PixelConvert_Unsigned8_MatchesScalarReference)
+		{
+			std::vector<uint8_t> values = AllValues<uint8_t>();
+			for (const auto& rescale : Rescales)
+			{
+				Assert::IsTrue(MatchesReference(values, rescale[0], rescale[1]));
+			}
+		}
+
+		TEST_METHOD(PixelConvert_Unsigned16_MatchesScalarReference)
+		{
+			std::vector<uint16_t> values = AllValues<uint16_t>();
+			for (const auto& rescale : Rescales)
+			{
+				Assert::IsTrue(MatchesReference(values, rescale[0], rescale[1]));
+			}
+		}
+
+		TEST_METHOD(PixelConvert_Signed16_MatchesScalarReference)
+		{
+			std::vector<int16_t> values = AllValues<int16_t>();
+			for (const auto& rescale : Rescales)
+			{
+				Assert::IsTrue(MatchesReference(values, rescale[0], rescale[1]));
+			}
+		}
+
+		TEST_METHOD(PixelConvert_OddLengths_ConvertTailWithoutOverrun)
+		{
+			// Every length up to a few vector widths exercises the scalar tail
+			for (size_t length = 0; length < 70; ++length)
+			{
+				std::vector<int16_t> values(length);
+				for (size_t i = 0; i < length; ++i)
+				{
+					values[i] = static_cast<int16_t>(i * 977 - 30000);
+				}
+				Assert::IsTrue(MatchesReference(values, 1.0, -1024.0));
+				Assert::IsTrue(MatchesReference(values, 0.75, 3.25));
+			}
+		}
+
+		TEST_METHOD(PixelConvert_Layout_MasksShiftsAndSignExtends)
+		{
+			std::vector<uint16_t> values16 = AllValues<uint16_t>();
+			const SampleLayout layouts16[] = {
+				SampleLayout(12, 11, true),
+				SampleLayout(12, 11, false),
+				SampleLayout(16, 15, true),
+				SampleLayout(10, 9, false),
+				SampleLayout(12, 13, true),
+				SampleLayout(1, 15, false),
+			};
+			for (const SampleLayout& layout : layouts16)
+			{
+				Assert::IsTrue(MatchesLayoutReference(values16, layout, 1.0, -1024.0));
+				Assert::IsTrue(MatchesLayoutReference(values16, layout, 0.3, -7.1));
+			}
+
+			std::vector<uint8_t> values8 = AllValues<uint8_t>();
+			Assert::IsTrue(MatchesLayoutReference(values8, SampleLayout(8, 7, true), 1.0, 0.0));
+			Assert::IsTrue(MatchesLayoutReference(values8, SampleLayout(6, 6, false), 2.5, 1.0));
+		}
+
+		TEST_METHOD(PixelConvert_Layout_DropsOverlayBitsOfSigned12Bit)
+		{
+			// -1000 in 12 bits with overlay bits set in the high nibble
+			const uint16_t stored = static_cast<uint16_t>(0xA000 | (-1000 & 0x0FFF));
+			std::vector<uint16_t> input(37, stored);
+			std::vector<float> output(input.size());
+			PixelConvert::ToFloat(input.data(), input.size(), SampleLayout(12, 11, true), 1.0, -1024.0, output.data());
+			for (float value : output)
+			{
+				Assert::AreEqual(-2024.0f, value);
+			}
+		}
+
+		TEST_METHOD(PixelConvert_Layout_InvalidBitsUseWholeContainer)
+		{
+			std::vector<uint16_t> values = AllValues<uint16_t>();
+			Assert::IsTrue(MatchesReference(values, 1.0, 5.0));
+
+			std::vector<float> expected(values.size());
+			std::vector<float> output(values.size());
+			PixelConvert::ToFloat(values.data(), values.size(), 1.0, 5.0, expected.data());
+			PixelConvert::ToFloat(values.data(), values.size(), SampleLayout(0, 0, false), 1.0, 5.0, output.data());
+			Assert::IsTrue(output == expected);
+			PixelConvert::ToFloat(values.data(), values.size(), SampleLayout(12, 20, false), 1.0, 5.0, output.data());
+			Assert::IsTrue(output == expected);
+			PixelConvert::ToFloat(values.data(), values.size(), SampleLayout(12, 4, false), 1.0, 5.0, output.data());
+			Assert::IsTrue(output == expected);
+		}
+
+		TEST_METHOD(PixelConvert_Padding_ReplacesValuesInRange)
+		{
+			std::vector<uint16_t> values = AllValues<uint16_t>();
+
+			SampleLayout single(16, 15, true);
+			single.hasPadding = true;
+			single.paddingValue = -2000;
+			single.paddingLimit = -2000;
+			single.paddingOutput = -3024.0f;
+			Assert::IsTrue(MatchesLayoutReference(values, single, 1.0, -1024.0));
+			Assert::IsTrue(MatchesLayoutReference(values, single, 0.5, 3.0));
+
+			// The range limit may be on either side of the padding value
+			SampleLayout range(12, 11, false);
+			range.hasPadding = true;
+			range.paddingValue = 4000;
+			range.paddingLimit = 10;
+			range.paddingOutput = -1.0f;
+			Assert::IsTrue(MatchesLayoutReference(values, range, 1.0, 0.0));
+			Assert::IsTrue(MatchesLayoutReference(values, range, 1.5, 0.25));
+
+			std::vector<uint8_t> values8 = AllValues<uint8_t>();
+			SampleLayout range8(8, 7, false);
+			range8.hasPadding = true;
+			range8.paddingValue = 0;
+			range8.paddingLimit = 3;
+			range8.paddingOutput = 99.0f;
+			Assert::IsTrue(MatchesLayoutReference(values8, range8, 1.0, 0.0));
+		}
+
+		TEST_METHOD(PixelConvert_GetStoredRange_FollowsLayout)
+		{
+			int64_t minimum;
+			int64_t maximum;
+			PixelConvert::GetStoredRange(SampleLayout(12, 11, true), 16, minimum, maximum);
+			Assert::AreEqual<int64_t>(-2048, minimum);
+			Assert::AreEqual<int64_t>(2047, maximum);
+			PixelConvert::GetStoredRange(SampleLayout(10, 9, false), 16, minimum, maximum);
+			Assert::AreEqual<int64_t>(0, minimum);
+			Assert::AreEqual<int64_t>(1023, maximum);
+			PixelConvert::GetStoredRange(SampleLayout(), 8, minimum, maximum);
+			Assert::AreEqual<int64_t>(0, minimum);
+			Assert::AreEqual<int64_t>(255, maximum);
+			PixelConvert::GetStoredRange(SampleLayout(), 32, minimum, maximum);
+			Assert::AreEqual<int64_t>(0, minimum);
+			Assert::AreEqual<int64_t>(4294967295LL, maximum);
+			PixelConvert::GetStoredRange(SampleLayout(32, 31, true), 32, minimum, maximum);
+			Assert::AreEqual<int64_t>(-2147483648LL, minimum);
+			Assert::AreEqual<int64_t>(2147483647LL, maximum);
+		}
+
+		TEST_METHOD(PixelConvert_Unsigned32_MatchesScalarReference)
+		{
+			// Values spread over the whole range, including those above 2^31
+			std::vector<uint32_t> values;
+			for (uint64_t value = 0; value <= 0xFFFFFFFFull; value += 65521)
+			{
+				values.push_back(static_cast<uint32_t>(value));
+			}
+			values.push_back(0xFFFFFFFFu);
+			values.push_back(0x80000000u);
+			values.push_back(0x7FFFFFFFu);
+			for (const auto& rescale : Rescales)
+			{
+				Assert::IsTrue(MatchesReference(values, rescale[0], rescale[1]));
+			}
+		}
+
+		TEST_METHOD(PixelConvert_Signed32_MatchesScalarReference)
+		{
+			std::vector<uint32_t> values;
+			for (uint64_t value = 0; value <= 0xFFFFFFFFull; value += 65521)
+			{
+				values.push_back(static_cast<uint32_t>(value));
+			}
+			std::vector<float> output(values.size());
+			for (const auto& rescale : Rescales)
+			{
+				PixelConvert::ToFloat(values.data(), values.size(), SampleLayout(32, 31, true), rescale[0], rescale[1], output.data());
+				for (size_t i = 0; i < values.size(); ++i)
+				{
+					float expected = Reference(static_cast<int32_t>(values[i]), rescale[0], rescale[1]);
+					Assert::IsTrue(std::memcmp(&expected, &output[i], sizeof(float)) == 0);
+				}
+			}
+		}
+
+		TEST_METHOD(PixelConvert_Layout32_MasksShiftsAndSignExtends)
+		{
+			std::vector<uint32_t> values;
+			for (uint32_t i = 0; i < 5000; ++i)
+			{
+				values.push_back(i * 2654435761u);
+			}
+			const SampleLayout layouts[] = {
+				SampleLayout(24, 23, true),
+				SampleLayout(24, 27, false),
+				SampleLayout(31, 30, false),
+				SampleLayout(20, 31, true),
+			};
+			for (const SampleLayout& layout : layouts)
+			{
+				Assert::IsTrue(MatchesLayoutReference(values, layout, 1.0, -1024.0));
+				Assert::IsTrue(MatchesLayoutReference(values, layout, 0.001, 0.0));
+			}
+
+			SampleLayout padded(32, 31, false);
+			padded.hasPadding = true;
+			padded.paddingValue = 0;
+			padded.paddingLimit = 100;
+			padded.paddingOutput = -1.0f;
+			values.insert(values.begin(), { 0, 50, 100, 101, 0xFFFFFFFFu });
+			Assert::IsTrue(MatchesLayoutReference(values, padded, 2.5e-5, 0.0));
+		}
+
+		TEST_METHOD(PixelConvert_RealSamples_MatchScalarReference)
+		{
+			std::vector<float> floats = { 0.0f, -0.0f, 1.5f, -3.25e7f, 1e-30f, 3.4e38f, -1.17549435e-38f,
+				std::numeric_limits<float>::infinity(), 123.456f };
+			std::vector<double> doubles = { 0.0, -0.0, 1.5, -3.25e7, 1e-300, 1e300, 0.1, 2.0e-45,
+				-std::numeric_limits<double>::infinity(), 16777217.0 };
+			for (size_t i = 0; i < 70; ++i)
+			{
+				floats.push_back(static_cast<float>(i) * 0.37f - 11.0f);
+				doubles.push_back(static_cast<double>(i) * 1234.5678 - 40000.0);
+			}
+			for (const auto& rescale : Rescales)
+			{
+				Assert::IsTrue(MatchesReference(floats, rescale[0], rescale[1]));
+				Assert::IsTrue(MatchesReference(doubles, rescale[0], rescale[1]));
+			}
+		}
+
+		TEST_METHOD(PixelConvert_BigEndian16_MatchesLittleEndian)
+		{
+			std::vector<uint16_t> values = AllValues<uint16_t>();
+			std::vector<uint16_t> swapped(values.size());
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				swapped[i] = static_cast<uint16_t>((values[i] << 8) | (values[i] >> 8));
+			}
+			const SampleLayout layouts[] = {
+				SampleLayout(16, 15, false),
+				SampleLayout(16, 15, true),
+				SampleLayout(12, 11, true),
+				SampleLayout(10, 13, false),
+			};
+			std::vector<float> expected(values.size());
+			std::vector<float> output(values.size());
+			for (SampleLayout layout : layouts)
+			{
+				layout.hasPadding = true;
+				layout.paddingValue = 100;
+				layout.paddingLimit = 200;
+				for (const auto& rescale : Rescales)
+				{
+					layout.bigEndian = false;
+					PixelConvert::ToFloat(values.data(), values.size(), layout, rescale[0], rescale[1], expected.data());
+					layout.bigEndian = true;
+					PixelConvert::ToFloat(swapped.data(), swapped.size(), layout, rescale[0], rescale[1], output.data());
+					Assert::IsTrue(std::memcmp(expected.data(), output.data(), output.size() * sizeof(float)) == 0);
+				}
+			}
+		}
+
+		TEST_METHOD(PixelConvert_BigEndian32_MatchesLittleEndian)
+		{
+			std::vector<uint32_t> values;
+			std::vector<uint32_t> swapped;
+			for (uint32_t i = 0; i < 5000; ++i)
+			{
+				uint32_t value = i * 2654435761u;
+				values.push_back(value);
+				swapped.push_back((value << 24) | ((value << 8) & 0xFF0000) | ((value >> 8) & 0xFF00) | (value >> 24));
+			}
+			const SampleLayout layouts[] = {
+				SampleLayout(32, 31, false),
+				SampleLayout(32, 31, true),
+				SampleLayout(24, 27, false),
+			};
+			std::vector<float> expected(values.size());
+			std::vector<float> output(values.size());
+			for (SampleLayout layout : layouts)
+			{
+				layout.bigEndian = false;
+				PixelConvert::ToFloat(values.data(), values.size(), layout, 0.3, -7.1, expected.data());
+				layout.bigEndian = true;
+				PixelConvert::ToFloat(swapped.data(), swapped.size(), layout, 0.3, -7.1, output.data());
+				Assert::IsTrue(std::memcmp(expected.data(), output.data(), output.size() * sizeof(float)) == 0);
+			}
+		}
+
+		TEST_METHOD(PixelConvert_UnalignedInput_MatchesAligned)
+		{
+			std::vector<uint16_t> values = AllValues<uint16_t>();
+			std::vector<uint8_t> bytes = MisalignedBytes(values);
+			std::vector<float> expected(values.size());
+			std::vector<float> output(values.size());
+			SampleLayout layout(12, 11, true);
+			PixelConvert::ToFloat(values.data(), values.size(), layout, 0.5, -1024.0, expected.data());
+			PixelConvert::ToFloat(bytes.data() + 1, values.size(), 16, layout, 0.5, -1024.0, output.data());
+			Assert::IsTrue(std::memcmp(expected.data(), output.data(), output.size() * sizeof(float)) == 0);
+
+			std::vector<uint32_t> wide;
+			for (uint32_t i = 0; i < 5000; ++i)
+			{
+				wide.push_back(i * 2654435761u);
+			}
+			bytes = MisalignedBytes(wide);
+			expected.assign(wide.size(), 0.0f);
+			output.assign(wide.size(), 0.0f);
+			SampleLayout wideLayout(32, 31, true);
+			PixelConvert::ToFloat(wide.data(), wide.size(), wideLayout, 0.3, -7.1, expected.data());
+			PixelConvert::ToFloat(bytes.data() + 1, wide.size(), 32, wideLayout, 0.3, -7.1, output.data());
+			Assert::IsTrue(std::memcmp(expected.data(), output.data(), output.size() * sizeof(float)) == 0);
+
+			std::vector<double> reals;
+			for (size_t i = 0; i < 5000; ++i)
+			{
+				reals.push_back(static_cast<double>(i) * 0.37 - 900.0);
+			}
+			bytes = MisalignedBytes(reals);
+			expected.assign(reals.size(), 0.0f);
+			output.assign(reals.size(), 0.0f);
+			PixelConvert::ToFloat(reals.data(), reals.size(), 2.0, 1.5, expected.data());
+			PixelConvert::RealToFloat(bytes.data() + 1, reals.size(), 64, 2.0, 1.5, output.data());
+			Assert::IsTrue(std::memcmp(expected.data(), output.data(), output.size() * sizeof(float)) == 0);
+		}
+
+		TEST_METHOD(PixelConvert_FromFloat_Int16_RoundsToEvenAndSaturates)
+		{
+			std::vector<float> input = NarrowingInputs();
+			std::vector<int16_t> output(input.size());
+			PixelConvert::FromFloat(input.data(), input.size(), output.data());
+			const int16_t expected[] = { 0, 2, 2, 0, -2, 32767, 32767, -32768, 32767, 32767, -32768, -32768, 32767, -32768 };
+			for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+			{
+				Assert::AreEqual<int>(expected[i], output[i]);
+			}
+			Assert::IsTrue(NarrowMatchesScalar<int16_t>(input));
+		}
+
+		TEST_METHOD(PixelConvert_FromFloat_UInt16_RoundsToEvenAndSaturates)
+		{
+			std::vector<float> input = NarrowingInputs();
+			std::vector<uint16_t> output(input.size());
+			PixelConvert::FromFloat(input.data(), input.size(), output.data());
+			const uint16_t expected[] = { 0, 2, 2, 0, 0, 32767, 32768, 0, 65535, 65535, 0, 0, 65535, 0 };
+			for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+			{
+				Assert::AreEqual<int>(expected[i], output[i]);
+			}
+			Assert::IsTrue(NarrowMatchesScalar<uint16_t>(input));
+		}
+
+		TEST_METHOD(PixelConvert_FromFloat_Half_RoundsToEven)
+		{
+			std::vector<float> input = NarrowingInputs();
+			std::vector<Half> output(input.size());
+			PixelConvert::FromFloat(input.data(), input.size(), output.data());
+			Assert::AreEqual<int>(0x3800, output[0].bits);       // 0.5
+			Assert::AreEqual<int>(0x7E00, output[11].bits & 0x7E00); // NaN stays NaN
+			Assert::AreEqual<int>(0x7C00, output[12].bits);      // Infinity
+			Assert::AreEqual<int>(0xFC00, output[13].bits);
+			Assert::AreEqual<int>(0x7BFF, output[14].bits);      // Largest half
+			Assert::AreEqual<int>(0x7C00, output[15].bits);      // Rounds up to infinity
+			Assert::AreEqual<int>(0x0001, output[16].bits);      // Smallest subnormal
+			Assert::AreEqual<int>(0x0000, output[17].bits);      // Half of it ties to zero
+			Assert::AreEqual<int>(0x8000, output[18].bits);
+			Assert::IsTrue(NarrowMatchesScalar<Half>(input));
+		}
+
+		TEST_METHOD(PixelConvert_Half_RoundTripsEveryValue)
+		{
+			std::vector<float> values;
+			for (uint32_t bits = 0; bits < 65536; ++bits)
+			{
+				Half half = { static_cast<uint16_t>(bits) };
+				values.push_back(PixelConvert::HalfToFloat(half));
+			}
+			std::vector<Half> output(values.size());
+			PixelConvert::FromFloat(values.data(), values.size(), output.data());
+			for (uint32_t bits = 0; bits < 65536; ++bits)
+			{
+				// Signaling NaNs come back quiet
+				bool nan = (bits & 0x7C00) == 0x7C00 && (bits & 0x3FF) != 0;
+				Assert::AreEqual<int>(nan ? bits | 0x200 : bits, output[bits].bits);
+			}
+		}
+
+		TEST_METHOD(PixelConvert_GetKernelName_NamesAnInstructionSet)
+		{
+			std::string name = PixelConvert::GetKernelName();
+			Assert::IsTrue(name == "AVX-512" || name == "AVX2" || name == "SSE2" || name == "Scalar");
+		}
+	};
+}
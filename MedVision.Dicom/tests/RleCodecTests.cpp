@@ -0,0 +1,270 @@
+// Unit tests for RleDecoder and RleEncoder classes
+// Tests PackBits expansion, byte-plane interleaving, malformed input and encoder round trips
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/RleCodec.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	TEST_CLASS(RleCodecTests)
+	{
+	private:
+		// Minimal PackBits: replicate runs of 3+ equal bytes, literals otherwise
+		static std::vector<uint8_t> PackBits(const std::vector<uint8_t>& plane)
+		{
+			std::vector<uint8_t> packed;
+			size_t i = 0;
+			while (i < plane.size())
+			{
+				size_t run = 1;
+				while (i + run < plane.size() && run < 128 && plane[i + run] == plane[i])
+				{
+					++run;
+				}
+				if (run >= 3)
+				{
+					packed.push_back(static_cast<uint8_t>(1 - static_cast<int>(run)));
+					packed.push_back(plane[i]);
+					i += run;
+					continue;
+				}
+
+				size_t literal = 0;
+				while (i + literal < plane.size() && literal < 128 &&
+					!(i + literal + 2 < plane.size() && plane[i + literal] == plane[i + literal + 1] && plane[i + literal] == plane[i + literal + 2]))
+				{
+					++literal;
+				}
+				packed.push_back(static_cast<uint8_t>(literal - 1));
+				packed.insert(packed.end(), plane.begin() + i, plane.begin() + i + literal);
+				i += literal;
+			}
+			if (packed.size() % 2 != 0)
+			{
+				packed.push_back(0x80);  // No-op header pads segments to even length
+			}
+			return packed;
+		}
+
+		static std::vector<uint8_t> BuildFrame(const std::vector<std::vector<uint8_t>>& planes)
+		{
+			std::vector<uint8_t> frame(64, 0);
+			frame[0] = static_cast<uint8_t>(planes.size());
+			for (size_t i = 0; i < planes.size(); ++i)
+			{
+				uint32_t offset = static_cast<uint32_t>(frame.size());
+				for (int b = 0; b < 4; ++b)
+				{
+					frame[4 + i * 4 + b] = static_cast<uint8_t>(offset >> (8 * b));
+				}
+				std::vector<uint8_t> packed = PackBits(planes[i]);
+				frame.insert(frame.end(), packed.begin(), packed.end());
+			}
+			return frame;
+		}
+
+		static FrameInfo CreateInfo(uint16_t rows, uint16_t columns, uint16_t samples, uint16_t bits)
+		{
+			FrameInfo info;
+			info.rows = rows;
+			info.columns = columns;
+			info.samplesPerPixel = samples;
+			info.bitsAllocated = bits;
+			info.bitsStored = bits;
+			return info;
+		}
+
+	public:
+		TEST_METHOD(RleDecoder_DecodeFrame_Decodes8BitGrayscale)
+		{
+			std::vector<uint8_t> plane(37 * 5);
+			for (size_t i = 0; i < plane.size(); ++i)
+			{
+				plane[i] = static_cast<uint8_t>(i < 60 ? 7 : i * 3);
+			}
+
+			std::vector<uint8_t> frame = BuildFrame({ plane });
+			std::vector<uint8_t> output(plane.size());
+			std::string error;
+			RleDecoder decoder;
+			Assert::IsTrue(decoder.DecodeFrame(frame.data(), frame.size(), CreateInfo(5, 37, 1, 8), output.data(), error));
+			Assert::IsTrue(output == plane);
+		}
+
+		TEST_METHOD(RleDecoder_DecodeFrame_Interleaves16BitSamples)
+		{
+			// 41 pixels: vector blocks plus a scalar tail
+			std::vector<uint16_t> samples(41);
+			std::vector<uint8_t> high(samples.size());
+			std::vector<uint8_t> low(samples.size());
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				samples[i] = static_cast<uint16_t>(i * 1031 + 5);
+				high[i] = static_cast<uint8_t>(samples[i] >> 8);
+				low[i] = static_cast<uint8_t>(samples[i]);
+			}
+
+			std::vector<uint8_t> frame = BuildFrame({ high, low });
+			std::vector<uint8_t> output(samples.size() * 2);
+			std::string error;
+			RleDecoder decoder;
+			Assert::IsTrue(decoder.DecodeFrame(frame.data(), frame.size(), CreateInfo(1, 41, 1, 16), output.data(), error));
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				Assert::AreEqual(samples[i], static_cast<uint16_t>(output[i * 2] | (output[i * 2 + 1] << 8)));
+			}
+		}
+
+		TEST_METHOD(RleDecoder_DecodeFrame_InterleavesRgbPlanes)
+		{
+			const size_t pixels = 7 * 9;
+			std::vector<uint8_t> red(pixels), green(pixels), blue(pixels);
+			for (size_t i = 0; i < pixels; ++i)
+			{
+				red[i] = static_cast<uint8_t>(i);
+				green[i] = static_cast<uint8_t>(100 + i);
+				blue[i] = static_cast<uint8_t>(200 - i);
+			}
+
+			std::vector<uint8_t> frame = BuildFrame({ red, green, blue });
+			std::vector<uint8_t> output(pixels * 3);
+			std::string error;
+			RleDecoder decoder;
+			Assert::IsTrue(decoder.DecodeFrame(frame.data(), frame.size(), CreateInfo(7, 9, 3, 8), output.data(), error));
+			for (size_t i = 0; i < pixels; ++i)
+			{
+				Assert::AreEqual(red[i], output[i * 3]);
+				Assert::AreEqual(green[i], output[i * 3 + 1]);
+				Assert::AreEqual(blue[i], output[i * 3 + 2]);
+			}
+		}
+
+		TEST_METHOD(RleDecoder_DecodeFrame_Interleaves16BitRgb)
+		{
+			const size_t pixels = 6;
+			std::vector<std::vector<uint8_t>> planes(6, std::vector<uint8_t>(pixels));
+			for (size_t plane = 0; plane < 6; ++plane)
+			{
+				for (size_t i = 0; i < pixels; ++i)
+				{
+					planes[plane][i] = static_cast<uint8_t>(plane * 16 + i);
+				}
+			}
+
+			std::vector<uint8_t> frame = BuildFrame(planes);
+			std::vector<uint8_t> output(pixels * 6);
+			std::string error;
+			RleDecoder decoder;
+			Assert::IsTrue(decoder.DecodeFrame(frame.data(), frame.size(), CreateInfo(2, 3, 3, 16), output.data(), error));
+
+			// Pixel 2, green sample: high byte from plane 2, low byte from plane 3
+			Assert::AreEqual(planes[3][2], output[2 * 6 + 2]);
+			Assert::AreEqual(planes[2][2], output[2 * 6 + 3]);
+		}
+
+		TEST_METHOD(RleDecoder_DecodeFrame_RejectsMalformedInput)
+		{
+			RleDecoder decoder;
+			std::string error;
+			std::vector<uint8_t> output(16);
+
+			std::vector<uint8_t> shortHeader(10, 0);
+			Assert::IsFalse(decoder.DecodeFrame(shortHeader.data(), shortHeader.size(), CreateInfo(4, 4, 1, 8), output.data(), error));
+			Assert::IsFalse(error.empty());
+
+			// Two segments declared for an 8-bit image
+			std::vector<uint8_t> frame = BuildFrame({ std::vector<uint8_t>(16, 1), std::vector<uint8_t>(16, 2) });
+			Assert::IsFalse(decoder.DecodeFrame(frame.data(), frame.size(), CreateInfo(4, 4, 1, 8), output.data(), error));
+
+			// Segment decodes to fewer bytes than the frame needs
+			std::vector<uint8_t> truncated = BuildFrame({ std::vector<uint8_t>(8, 1) });
+			Assert::IsFalse(decoder.DecodeFrame(truncated.data(), truncated.size(), CreateInfo(4, 4, 1, 8), output.data(), error));
+		}
+
+		TEST_METHOD(RleEncoder_EncodeRow_SplitsLongRunsAndLiterals)
+		{
+			// 300 equal bytes then 200 distinct ones: runs and literals are capped at 128
+			std::vector<uint8_t> row(300, 9);
+			for (int i = 0; i < 200; ++i)
+			{
+				row.push_back(static_cast<uint8_t>(i));
+			}
+
+			std::vector<uint8_t> packed(row.size() + (row.size() + 127) / 128);
+			size_t length = RleEncoder::EncodeRow(row.data(), row.size(), packed.data());
+			Assert::AreEqual(static_cast<uint8_t>(257 - 128), packed[0]);
+			Assert::AreEqual(static_cast<size_t>(3 * 2 + 1 + 128 + 1 + 72), length);
+
+			std::vector<uint8_t> output(row.size());
+			Assert::IsTrue(RleDecoder::DecodeSegment(packed.data(), length, output.data(), output.size()));
+			Assert::IsTrue(output == row);
+		}
+
+		TEST_METHOD(RleEncoder_EncodeFrame_RoundTripsLayouts)
+		{
+			RleEncoder encoder;
+			RleDecoder decoder;
+			const uint16_t layouts[][3] = { { 1, 8, 0 }, { 1, 16, 0 }, { 3, 8, 0 }, { 3, 8, 1 }, { 3, 16, 0 }, { 1, 32, 0 } };
+			for (const uint16_t* layout : layouts)
+			{
+				// Odd width so rows do not line up with the SIMD blocks
+				FrameInfo info = CreateInfo(9, 37, layout[0], layout[1]);
+				info.planarConfiguration = layout[2];
+
+				std::vector<uint8_t> pixels(info.GetFrameLength());
+				for (size_t i = 0; i < pixels.size(); ++i)
+				{
+					pixels[i] = static_cast<uint8_t>((i / 50) % 2 == 0 ? 0x42 : (i * 13) ^ (i >> 3));
+				}
+
+				std::vector<uint8_t> encoded;
+				std::string error;
+				Assert::IsTrue(encoder.EncodeFrame(pixels.data(), info, encoded, error));
+				Assert::AreEqual(static_cast<uint8_t>(layout[0] * layout[1] / 8), encoded[0]);
+				Assert::AreEqual(static_cast<size_t>(0), encoded.size() % 2);
+
+				// Decoders always produce interleaved samples
+				std::vector<uint8_t> expected = pixels;
+				if (info.planarConfiguration == 1)
+				{
+					size_t plane = static_cast<size_t>(info.rows) * info.columns;
+					for (size_t i = 0; i < plane; ++i)
+					{
+						for (size_t sample = 0; sample < 3; ++sample)
+						{
+							expected[i * 3 + sample] = pixels[sample * plane + i];
+						}
+					}
+				}
+
+				std::vector<uint8_t> decoded(pixels.size());
+				Assert::IsTrue(decoder.DecodeFrame(encoded.data(), encoded.size(), info, decoded.data(), error));
+				Assert::IsTrue(decoded == expected);
+			}
+		}
+
+		TEST_METHOD(RleEncoder_EncodeFrame_RejectsTooManyPlanes)
+		{
+			std::vector<uint8_t> pixels(4 * 4 * 4 * 4);
+			std::vector<uint8_t> encoded;
+			std::string error;
+			RleEncoder encoder;
+			Assert::IsFalse(encoder.EncodeFrame(pixels.data(), CreateInfo(4, 4, 4, 32), encoded, error));
+			Assert::IsFalse(error.empty());
+		}
+
+		TEST_METHOD(RleDecoder_IsRegisteredForRleLossless)
+		{
+			std::shared_ptr<const PixelDecoder> decoder = CodecRegistry::Instance().FindDecoder(TransferSyntax::RLELossless);
+			Assert::IsNotNull(decoder.get());
+			Assert::IsTrue((decoder->GetCapabilities() & CodecMultiFrameParallel) != 0);
+			Assert::IsNotNull(CodecRegistry::Instance().FindEncoder(TransferSyntax::RLELossless).get());
+		}
+	};
+}
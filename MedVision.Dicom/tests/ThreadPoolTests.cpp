@@ -0,0 +1,67 @@
+// Unit tests for ThreadPool class
+// Tests task submission, waiting and ParallelFor
+
+#include "CppUnitTest.h"
+#include "medvision/dicom/ThreadPool.h"
+#include <atomic>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+
+namespace MedVisionDicomTests
+{
+	TEST_CLASS(ThreadPoolTests)
+	{
+	public:
+		TEST_METHOD(ThreadPool_Constructor_CreatesRequestedThreads)
+		{
+			ThreadPool pool(3);
+			Assert::IsTrue(pool.GetThreadCount() == 3);
+		}
+
+		TEST_METHOD(ThreadPool_Submit_RunsAllTasksBeforeWaitReturns)
+		{
+			ThreadPool pool(4);
+			std::atomic<int> counter(0);
+
+			for (int i = 0; i < 100; ++i)
+			{
+				pool.Submit([&counter] { ++counter; });
+			}
+			pool.Wait();
+
+			Assert::AreEqual(100, counter.load());
+		}
+
+		TEST_METHOD(ThreadPool_ParallelFor_VisitsEveryIndexOnce)
+		{
+			ThreadPool pool(4);
+			std::vector<std::atomic<int>> visits(1000);
+			for (auto& visit : visits)
+			{
+				visit = 0;
+			}
+
+			pool.ParallelFor(visits.size(), [&visits](size_t i) { ++visits[i]; });
+
+			for (auto& visit : visits)
+			{
+				Assert::AreEqual(1, visit.load());
+			}
+		}
+
+		TEST_METHOD(ThreadPool_ParallelFor_NestedCallsComplete)
+		{
+			ThreadPool pool(2);
+			std::atomic<int> counter(0);
+
+			pool.ParallelFor(8, [&](size_t)
+			{
+				pool.ParallelFor(8, [&counter](size_t) { ++counter; });
+			});
+
+			Assert::AreEqual(64, counter.load());
+		}
+	};
+}
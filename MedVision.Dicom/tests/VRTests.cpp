@@ -192,6 +192,15 @@ namespace MedVisionDicomTests
 			Assert::IsTrue(VRUtils::HasExplicitLength(VR::UN));
 		}
 
+		TEST_METHOD(VRUtils_OV_RoundTripsWithExplicitLength)
+		{
+			Assert::AreEqual(std::string("OV"), VRUtils::ToString(VR::OV));
+			Assert::IsTrue(VRUtils::FromString("OV") == VR::OV);
+			Assert::IsTrue(VRUtils::HasExplicitLength(VR::OV));
+			Assert::IsTrue(VRUtils::HasExplicitLength(VR::SV));
+			Assert::IsTrue(VRUtils::HasExplicitLength(VR::UV));
+		}
+
 		TEST_METHOD(VRUtils_HasExplicitLength_US_ReturnsFalse)
 		{
 			Assert::IsFalse(VRUtils::HasExplicitLength(VR::US));
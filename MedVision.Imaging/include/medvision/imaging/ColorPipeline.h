@@ -0,0 +1,58 @@
+#pragma once
+
+#include "DicomImage.h"
+#include <vector>
+#include <cstdint>
+
+namespace medvision
+{
+	namespace imaging
+	{
+		/// Renders color images to packed RGBA (R, G, B, A bytes, alpha 255)
+		///
+		/// RGB (interleaved or planar, following PlanarConfiguration), YBR_FULL
+		/// and YBR_FULL_422 with 8-bit samples go through the SIMD kernels of
+		/// dicom::ColorConvert. PALETTE COLOR indices (8 or 16 bits) are mapped
+		/// through one RGBA table indexed by the raw sample, compiled by Build
+		/// from the red, green and blue palette LUTs (plain or segmented), so
+		/// each frame of a cine loop is a single lookup pass.
+		class ColorPipeline
+		{
+		public:
+			ColorPipeline();
+
+			// Prepare for image's photometric interpretation; false if it is not
+			// a supported color image
+			bool Build(const DicomImage& image);
+
+			bool IsValid() const { return source_ != Source::None; }
+
+			// Render the first frame of image
+			bool Apply(const DicomImage& image, std::vector<uint8_t>& rgba) const;
+
+			// Render one frame into a caller buffer of GetWidth() * GetHeight() * 4 bytes
+			bool ApplyFrame(const DicomImage& image, uint32_t frame, uint8_t* rgba) const;
+
+		private:
+			enum class Source
+			{
+				None,
+				Rgb,
+				PlanarRgb,
+				YbrFull,
+				PlanarYbrFull,
+				YbrFull422,
+				Palette,
+			};
+
+			static Source GetSource(const DicomImage& image);
+			bool BuildPalette(const DicomImage& image);
+
+		private:
+			Source source_;
+			uint16_t bitsAllocated_;
+			std::vector<uint32_t> palette_;   // RGBA of every raw index value
+		};
+
+	} // namespace imaging
+} // namespace medvision
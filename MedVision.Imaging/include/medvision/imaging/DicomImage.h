@@ -1,6 +1,7 @@
 #pragma once
 
 #include "medvision/dicom/DicomDataSet.h"
+#include "medvision/dicom/TransferSyntax.h"
 #include <vector>
 #include <string>
 #include <cstdint>
@@ -13,6 +14,15 @@ namespace medvision
 		class DicomImage
 		{
 		public:
+			/// Encoding of the stored samples: integers from Pixel Data, or IEEE
+			/// floats from Float (32-bit) or Double Float (64-bit) Pixel Data
+			enum class SampleFormat
+			{
+				Integer,
+				Float32,
+				Float64,
+			};
+
 			DicomImage();
 			explicit DicomImage(const medvision::dicom::DicomDataSet& dataset);
 			~DicomImage();
@@ -20,6 +30,11 @@ namespace medvision
 			// Load from dataset
 			bool LoadFromDataSet(const medvision::dicom::DicomDataSet& dataset);
 
+			/// Load at 1/2^reduction of the stored size (rounded up) for thumbnails and
+			/// previews. Codecs with CodecPartialDecode decode straight to the reduced
+			/// size; other images are decoded in full and then subsampled.
+			bool LoadPreview(const medvision::dicom::DicomDataSet& dataset, uint32_t reduction);
+
 			// Image dimensions
 			uint16_t GetWidth() const { return width_; }
 			uint16_t GetHeight() const { return height_; }
@@ -27,14 +42,23 @@ namespace medvision
 			uint16_t GetBitsStored() const { return bitsStored_; }
 			uint16_t GetHighBit() const { return highBit_; }
 
-			// Pixel data access
+			// Pixel data access (compressed pixel data is decoded through the CodecRegistry)
 			bool HasPixelData() const { return !rawPixelData_.empty(); }
 			const uint8_t* GetRawPixelData() const { return rawPixelData_.data(); }
 			size_t GetPixelDataSize() const { return rawPixelData_.size(); }
 
+			// Multi-frame access: frames are stored back to back, GetFrameLength() bytes
+			// apart. The frame count is NumberOfFrames, limited to the frames present.
+			uint32_t GetNumberOfFrames() const;
+			size_t GetFrameLength() const;
+			const uint8_t* GetFramePixelData(uint32_t frame) const;
+
+			SampleFormat GetSampleFormat() const { return sampleFormat_; }
+
 			// Image attributes
 			std::string GetPhotometricInterpretation() const { return photometricInterpretation_; }
 			uint16_t GetSamplesPerPixel() const { return samplesPerPixel_; }
+			uint16_t GetPlanarConfiguration() const { return planarConfiguration_; }
 			uint16_t GetPixelRepresentation() const { return pixelRepresentation_; }
 			bool IsSigned() const { return pixelRepresentation_ == 1; }
 			bool IsColor() const { return samplesPerPixel_ > 1; }
@@ -47,18 +71,47 @@ namespace medvision
 			bool GetRescaleSlope(double& slope) const;
 			bool GetRescaleIntercept(double& intercept) const;
 
+			/// RT Dose scaling of stored values to Gy (1 when absent)
+			bool GetDoseGridScaling(double& scaling) const;
+
+			/// Pixel padding in stored units (signed when PixelRepresentation is 1);
+			/// the range limit defaults to the padding value itself
+			bool GetPixelPaddingValue(int32_t& value) const;
+			bool GetPixelPaddingRangeLimit(int32_t& limit) const;
+
+			/// PALETTE COLOR lookup table of channel 0 (red), 1 (green) or 2 (blue),
+			/// from the plain or the segmented LUT data. entries[0] is the color of
+			/// stored value firstMapped; bitsPerEntry (8 or 16) is the entry range.
+			bool GetPaletteColorLut(int channel, std::vector<uint16_t>& entries, int32_t& firstMapped, uint16_t& bitsPerEntry) const;
+
 			// Patient/Study info (convenience methods)
 			std::string GetPatientName() const;
 			std::string GetPatientID() const;
 			std::string GetStudyDescription() const;
 			std::string GetModality() const;
 
+			// Transfer syntax of the source dataset (interned once per load)
+			medvision::dicom::TransferSyntaxId GetTransferSyntaxId() const { return transferSyntaxId_; }
+			bool IsCompressed() const { return isCompressed_; }
+
+			// True for Explicit VR Big Endian sources; attributes and pixel data are
+			// still returned in native (little endian) order
+			bool IsBigEndian() const { return isBigEndian_; }
+
 			// Validation
 			bool IsValid() const { return width_ > 0 && height_ > 0 && HasPixelData(); }
 
+			// Why pixel data could not be loaded (e.g. no decoder registered)
+			const std::string& GetLastError() const { return lastError_; }
+
 		private:
 			void ExtractImageAttributes();
 			void ExtractPixelData();
+			void SubsamplePixelData();
+			bool IsChromaSubsampled() const;
+			bool GetUInt16(const medvision::dicom::DicomTag& tag, uint16_t& value) const;
+			void CopyPixelData(const uint8_t* data, size_t length, size_t swapUnit);
+			bool DecodePixelData(const medvision::dicom::DicomElement& pixelDataElement);
 
 		private:
 			const medvision::dicom::DicomDataSet* dataset_;
@@ -74,9 +127,19 @@ namespace medvision
 
 			// Image attributes
 			std::string photometricInterpretation_;
+			uint16_t planarConfiguration_;
+			uint32_t numberOfFrames_;
+			uint32_t reduction_;
+
+			// Transfer syntax
+			medvision::dicom::TransferSyntaxId transferSyntaxId_;
+			bool isBigEndian_;
+			bool isCompressed_;
+			std::string lastError_;
 
 			// Pixel data
 			std::vector<uint8_t> rawPixelData_;
+			SampleFormat sampleFormat_;
 
 			// Window/Level defaults
 			bool hasWindowCenter_;
@@ -89,6 +152,14 @@ namespace medvision
 			double rescaleSlope_;
 			bool hasRescaleIntercept_;
 			double rescaleIntercept_;
+			bool hasDoseGridScaling_;
+			double doseGridScaling_;
+
+			// Pixel padding
+			bool hasPixelPaddingValue_;
+			int32_t pixelPaddingValue_;
+			bool hasPixelPaddingRangeLimit_;
+			int32_t pixelPaddingRangeLimit_;
 		};
 
 	} // namespace imaging
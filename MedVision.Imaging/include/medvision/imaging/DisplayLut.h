@@ -0,0 +1,58 @@
+#pragma once
+
+#include "DicomImage.h"
+#include "WindowLevel.h"
+#include <vector>
+#include <cstdint>
+
+namespace medvision
+{
+	namespace imaging
+	{
+		/// Maps stored pixel values straight to 8-bit display values
+		///
+		/// Unpacking (BitsStored/HighBit, sign, padding), the modality rescale,
+		/// the VOI window and the presentation (MONOCHROME1 inversion) are
+		/// compiled into one table indexed by the raw sample: 64K entries for
+		/// 16-bit samples, 256 for 8-bit. Display is then one lookup pass with
+		/// no float intermediate, and moving the window only rebuilds the table.
+		/// Output matches PixelDataProcessor followed by WindowLevel::Apply.
+		class DisplayLut
+		{
+		public:
+			DisplayLut();
+
+			// Compile the table for image's samples; false for color images or
+			// samples that are not 8 or 16 bits
+			bool Build(const DicomImage& image, const WindowLevel& window);
+
+			// Recompile for a new window, reusing the rescaled values of Build
+			void SetWindow(const WindowLevel& window);
+
+			bool IsValid() const { return !table_.empty(); }
+			const WindowLevel& GetWindow() const { return window_; }
+			const std::vector<uint8_t>& GetTable() const { return table_; }
+
+			// Map the first frame of image to display values
+			bool Apply(const DicomImage& image, std::vector<uint8_t>& output) const;
+
+			// Map one frame into a caller buffer of GetWidth() * GetHeight() bytes
+			bool ApplyFrame(const DicomImage& image, uint32_t frame, uint8_t* output) const;
+
+			// Map raw samples; false if the table was built for another sample size
+			bool Apply(const uint8_t* input, size_t count, uint8_t* output) const;
+			bool Apply(const uint16_t* input, size_t count, uint8_t* output) const;
+
+		private:
+			void Compile();
+
+		private:
+			std::vector<float> modality_;   // Rescaled value of every raw sample
+			std::vector<uint8_t> table_;
+			WindowLevel window_;
+			bool invert_;
+			uint16_t bitsAllocated_;
+		};
+
+	} // namespace imaging
+} // namespace medvision
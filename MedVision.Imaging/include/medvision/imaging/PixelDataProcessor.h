@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DicomImage.h"
+#include "medvision/dicom/PixelConvert.h"
 #include <vector>
 
 namespace medvision
@@ -8,19 +9,76 @@ namespace medvision
 	namespace imaging
 	{
 		/// Process DICOM pixel data into usable format
+		///
+		/// Single-sample images only; color images render through ColorPipeline.
 		class PixelDataProcessor
 		{
 		public:
-			// Process pixel data to float values (with rescale applied)
+			// Process the first frame to float values (with rescale applied) in a
+			// single SIMD pass; results match the scalar conversion bit for bit.
+			// Frames larger than a tile (see TileScheduler) are converted in tiles
+			// on the shared thread pool with the same output.
+			// Integer samples (8, 16 or 32 bits) are unpacked by BitsStored/HighBit
+			// (dropping overlay bits) and sign extended; PixelPaddingValue maps to the
+			// lowest representable value. Float and Double Float Pixel Data are
+			// rescaled and narrowed to float.
 			static bool ProcessPixelData(const DicomImage& image, std::vector<float>& outputBuffer);
 
+			// The first frame into a caller buffer (any alignment) of capacity
+			// values; false if it holds fewer than GetWidth() * GetHeight().
+			// The compact types take the float result through
+			// PixelConvert::FromFloat in small chunks, with no full-size float
+			// intermediate: int16_t suits CT Hounsfield units, uint16_t unsigned
+			// data and Half fractional values such as PET or dose, each at half
+			// the memory of float.
+			static bool ProcessPixelData(const DicomImage& image, float* output, size_t capacity);
+			static bool ProcessPixelData(const DicomImage& image, int16_t* output, size_t capacity);
+			static bool ProcessPixelData(const DicomImage& image, uint16_t* output, size_t capacity);
+			static bool ProcessPixelData(const DicomImage& image, medvision::dicom::Half* output, size_t capacity);
+
+			// One frame into a caller buffer of GetWidth() * GetHeight() values
+			static bool ProcessFrame(const DicomImage& image, uint32_t frame, float* output);
+			static bool ProcessFrame(const DicomImage& image, uint32_t frame, int16_t* output);
+			static bool ProcessFrame(const DicomImage& image, uint32_t frame, uint16_t* output);
+			static bool ProcessFrame(const DicomImage& image, uint32_t frame, medvision::dicom::Half* output);
+
+			// frameCount frames from firstFrame, converted in parallel, one after
+			// another into a caller buffer of frameCount * GetWidth() * GetHeight() values
+			static bool ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, float* output);
+			static bool ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, int16_t* output);
+			static bool ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, uint16_t* output);
+			static bool ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount,
+				medvision::dicom::Half* output);
+
+			// Stored sample layout of image (BitsStored, HighBit, sign and padding)
+			static medvision::dicom::SampleLayout GetSampleLayout(const DicomImage& image);
+
+			// Modality scaling of stored values: the rescale, with DoseGridScaling
+			// folded into the slope for RT Dose
+			static void GetRescale(const DicomImage& image, double& slope, double& intercept);
+
 			// Apply rescale slope/intercept
 			static void ApplyRescale(std::vector<float>& buffer, double slope, double intercept);
 
 		private:
-			static bool Process8Bit(const uint8_t* data, size_t pixels, std::vector<float>& output);
-			static bool Process16BitUnsigned(const uint8_t* data, size_t pixels, std::vector<float>& output);
-			static bool Process16BitSigned(const uint8_t* data, size_t pixels, std::vector<float>& output);
+			static bool IsSupported(const DicomImage& image);
+			template <typename T>
+			static bool ProcessPixelDataAs(const DicomImage& image, T* output, size_t capacity);
+			template <typename T>
+			static bool ProcessFrameAs(const DicomImage& image, uint32_t frame, T* output);
+			template <typename T>
+			static bool ProcessFramesAs(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, T* output);
+			static void ProcessTile(DicomImage::SampleFormat format, size_t sampleBytes, const uint8_t* data,
+				size_t pixels, const medvision::dicom::SampleLayout& layout, double slope, double intercept, float* output);
+			template <typename T>
+			static void ProcessTile(DicomImage::SampleFormat format, size_t sampleBytes, const uint8_t* data,
+				size_t pixels, const medvision::dicom::SampleLayout& layout, double slope, double intercept, T* output);
+			static bool Process8Bit(const uint8_t* data, size_t pixels, const medvision::dicom::SampleLayout& layout,
+				double slope, double intercept, float* output);
+			static bool Process16Bit(const uint8_t* data, size_t pixels, const medvision::dicom::SampleLayout& layout,
+				double slope, double intercept, float* output);
+			static bool Process32Bit(const uint8_t* data, size_t pixels, const medvision::dicom::SampleLayout& layout,
+				double slope, double intercept, float* output);
 		};
 
 	} // namespace imaging
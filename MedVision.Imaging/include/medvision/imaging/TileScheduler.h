@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace medvision
+{
+	namespace imaging
+	{
+		/// Splits per-pixel work into cache-sized tiles on the shared thread pool
+		///
+		/// A tile is a run of consecutive pixels, so every pixel is computed by
+		/// the same code whatever the tile size or thread count and the output
+		/// is deterministic. The default tile keeps a 16-bit input and its float
+		/// output (6 bytes per pixel) within a 256 KB L2 cache.
+		class TileScheduler
+		{
+		public:
+			static const size_t DefaultTilePixels = 32768;
+
+			// Tile size in pixels, rounded up to a multiple of 64 so tiles start
+			// on cache line boundaries; 0 restores the default
+			static void SetTilePixels(size_t pixels);
+			static size_t GetTilePixels();
+
+			// Call fn(first, count) for every tile of [0, total); a single tile
+			// runs on the calling thread
+			static void ForEachTile(size_t total, const std::function<void(size_t, size_t)>& fn);
+		};
+
+	} // namespace imaging
+} // namespace medvision
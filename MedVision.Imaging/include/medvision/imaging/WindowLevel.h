@@ -23,7 +23,8 @@ namespace medvision
 			double GetWidth() const { return width_; }
 
 			// Apply window/level transformation
-			// Converts float pixel values to 8-bit display values
+			// Converts float pixel values to 8-bit display values, in tiles on the
+			// shared thread pool for large images
 			void Apply(const std::vector<float>& input, std::vector<uint8_t>& output) const;
 
 			// Apply in-place (float to float, normalized 0-1)
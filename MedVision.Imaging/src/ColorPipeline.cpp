@@ -0,0 +1,169 @@
+#include "medvision/imaging/ColorPipeline.h"
+#include "medvision/dicom/ColorConvert.h"
+#include "medvision/dicom/PixelConvert.h"
+#include <algorithm>
+
+namespace medvision
+{
+	namespace imaging
+	{
+		ColorPipeline::ColorPipeline()
+			: source_(Source::None)
+			, bitsAllocated_(0)
+		{
+		}
+
+		ColorPipeline::Source ColorPipeline::GetSource(const DicomImage& image)
+		{
+			const std::string photometric = image.GetPhotometricInterpretation();
+			if (image.GetSamplesPerPixel() == 1)
+			{
+				bool indices = image.GetBitsAllocated() == 8 || image.GetBitsAllocated() == 16;
+				return photometric == "PALETTE COLOR" && indices ? Source::Palette : Source::None;
+			}
+			if (image.GetSamplesPerPixel() != 3 || image.GetBitsAllocated() != 8)
+			{
+				return Source::None;
+			}
+
+			bool planar = image.GetPlanarConfiguration() == 1;
+			if (photometric == "RGB")
+			{
+				return planar ? Source::PlanarRgb : Source::Rgb;
+			}
+			if (photometric == "YBR_FULL")
+			{
+				return planar ? Source::PlanarYbrFull : Source::YbrFull;
+			}
+			if (photometric == "YBR_FULL_422")
+			{
+				return Source::YbrFull422;
+			}
+			return Source::None;
+		}
+
+		bool ColorPipeline::Build(const DicomImage& image)
+		{
+			palette_.clear();
+			bitsAllocated_ = image.GetBitsAllocated();
+			source_ = GetSource(image);
+			if (source_ == Source::Palette && !BuildPalette(image))
+			{
+				source_ = Source::None;
+			}
+			return source_ != Source::None;
+		}
+
+		bool ColorPipeline::BuildPalette(const DicomImage& image)
+		{
+			// Indices are unpacked like grayscale samples (BitsStored, HighBit, sign),
+			// once for every raw value
+			size_t size = static_cast<size_t>(1) << bitsAllocated_;
+			std::vector<float> indices(size);
+			dicom::SampleLayout layout(image.GetBitsStored(), image.GetHighBit(), image.IsSigned());
+			if (bitsAllocated_ == 8)
+			{
+				std::vector<uint8_t> samples(size);
+				for (size_t i = 0; i < size; ++i)
+				{
+					samples[i] = static_cast<uint8_t>(i);
+				}
+				dicom::PixelConvert::ToFloat(samples.data(), size, layout, 1.0, 0.0, indices.data());
+			}
+			else
+			{
+				std::vector<uint16_t> samples(size);
+				for (size_t i = 0; i < size; ++i)
+				{
+					samples[i] = static_cast<uint16_t>(i);
+				}
+				dicom::PixelConvert::ToFloat(samples.data(), size, layout, 1.0, 0.0, indices.data());
+			}
+
+			std::vector<uint8_t> channels[3];
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				std::vector<uint16_t> entries;
+				int32_t firstMapped;
+				uint16_t bitsPerEntry;
+				if (!image.GetPaletteColorLut(channel, entries, firstMapped, bitsPerEntry) || entries.empty())
+				{
+					return false;
+				}
+
+				// 8-bit entries are sometimes written in the high byte of each word
+				int shift = bitsPerEntry == 16 || *std::max_element(entries.begin(), entries.end()) > 255 ? 8 : 0;
+
+				// Indices below the first mapped value take the first entry, those past the end the last
+				channels[channel].resize(size);
+				int32_t last = static_cast<int32_t>(entries.size()) - 1;
+				for (size_t i = 0; i < size; ++i)
+				{
+					int32_t entry = std::min(std::max(static_cast<int32_t>(indices[i]) - firstMapped, 0), last);
+					channels[channel][i] = static_cast<uint8_t>(entries[entry] >> shift);
+				}
+			}
+
+			palette_.resize(size);
+			for (size_t i = 0; i < size; ++i)
+			{
+				palette_[i] = dicom::ColorConvert::PackRgba(channels[0][i], channels[1][i], channels[2][i]);
+			}
+			return true;
+		}
+
+		bool ColorPipeline::Apply(const DicomImage& image, std::vector<uint8_t>& rgba) const
+		{
+			if (image.GetNumberOfFrames() == 0)
+			{
+				return false;
+			}
+			rgba.resize(static_cast<size_t>(image.GetWidth()) * image.GetHeight() * 4);
+			return ApplyFrame(image, 0, rgba.data());
+		}
+
+		bool ColorPipeline::ApplyFrame(const DicomImage& image, uint32_t frame, uint8_t* rgba) const
+		{
+			if (source_ == Source::None || GetSource(image) != source_ || image.GetBitsAllocated() != bitsAllocated_
+				|| frame >= image.GetNumberOfFrames())
+			{
+				return false;
+			}
+
+			size_t numPixels = static_cast<size_t>(image.GetWidth()) * image.GetHeight();
+			const uint8_t* data = image.GetFramePixelData(frame);
+			switch (source_)
+			{
+			case Source::Rgb:
+				dicom::ColorConvert::RgbToRgba(data, numPixels, rgba);
+				break;
+			case Source::PlanarRgb:
+				dicom::ColorConvert::PlanarRgbToRgba(data, data + numPixels, data + numPixels * 2, numPixels, rgba);
+				break;
+			case Source::YbrFull:
+				dicom::ColorConvert::YbrFullToRgba(data, numPixels, rgba);
+				break;
+			case Source::PlanarYbrFull:
+				dicom::ColorConvert::PlanarYbrFullToRgba(data, data + numPixels, data + numPixels * 2, numPixels, rgba);
+				break;
+			case Source::YbrFull422:
+				dicom::ColorConvert::YbrFull422ToRgba(data, numPixels, rgba);
+				break;
+			case Source::Palette:
+				if (bitsAllocated_ == 8)
+				{
+					dicom::ColorConvert::PaletteToRgba(data, numPixels, palette_.data(), rgba);
+				}
+				else
+				{
+					dicom::ColorConvert::PaletteToRgba(reinterpret_cast<const uint16_t*>(data), numPixels, palette_.data(), rgba);
+				}
+				break;
+			default:
+				return false;
+			}
+			return true;
+		}
+
+	} // namespace imaging
+} // namespace medvision
@@ -1,10 +1,46 @@
 #include "medvision/imaging/DicomImage.h"
+#include "medvision/dicom/ByteSwap.h"
+#include "medvision/dicom/CodecRegistry.h"
+#include "medvision/dicom/ColorConvert.h"
 #include "medvision/dicom/DicomTag.h"
+#include "medvision/dicom/EncapsulatedPixelData.h"
+#include "medvision/dicom/FrameDecodeScheduler.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 namespace medvision
 {
 	namespace imaging
 	{
+		namespace
+		{
+			// First value of a DS attribute; fails on empty, malformed or non-finite text
+			bool ParseDecimal(const std::string& text, double& value)
+			{
+				if (text.empty())
+				{
+					return false;
+				}
+				char* end = nullptr;
+				double parsed = std::strtod(text.c_str(), &end);
+				if (end == nullptr || end == text.c_str())
+				{
+					return false;
+				}
+				while (*end == ' ')
+				{
+					++end;
+				}
+				if ((*end != '\0' && *end != '\\') || !std::isfinite(parsed))
+				{
+					return false;
+				}
+				value = parsed;
+				return true;
+			}
+		}
+
 		DicomImage::DicomImage()
 			: dataset_(nullptr)
 			, width_(0)
@@ -14,6 +50,13 @@ namespace medvision
 			, highBit_(0)
 			, samplesPerPixel_(1)
 			, pixelRepresentation_(0)
+			, planarConfiguration_(0)
+			, numberOfFrames_(1)
+			, reduction_(0)
+			, transferSyntaxId_(medvision::dicom::TransferSyntax::InvalidId)
+			, isBigEndian_(false)
+			, isCompressed_(false)
+			, sampleFormat_(SampleFormat::Integer)
 			, hasWindowCenter_(false)
 			, windowCenter_(0.0)
 			, hasWindowWidth_(false)
@@ -22,6 +65,12 @@ namespace medvision
 			, rescaleSlope_(1.0)
 			, hasRescaleIntercept_(false)
 			, rescaleIntercept_(0.0)
+			, hasDoseGridScaling_(false)
+			, doseGridScaling_(1.0)
+			, hasPixelPaddingValue_(false)
+			, pixelPaddingValue_(0)
+			, hasPixelPaddingRangeLimit_(false)
+			, pixelPaddingRangeLimit_(0)
 		{
 		}
 
@@ -36,8 +85,37 @@ namespace medvision
 		}
 
 		bool DicomImage::LoadFromDataSet(const medvision::dicom::DicomDataSet& dataset)
+		{
+			return LoadPreview(dataset, 0);
+		}
+
+		bool DicomImage::LoadPreview(const medvision::dicom::DicomDataSet& dataset, uint32_t reduction)
 		{
 			dataset_ = &dataset;
+			reduction_ = reduction > 15 ? 15 : reduction;
+			rawPixelData_.clear();
+			isCompressed_ = false;
+			sampleFormat_ = SampleFormat::Integer;
+			lastError_.clear();
+
+			// Attributes are only set when present, so none may carry over from a previous load
+			width_ = 0;
+			height_ = 0;
+			bitsAllocated_ = 0;
+			bitsStored_ = 0;
+			highBit_ = 0;
+			samplesPerPixel_ = 1;
+			pixelRepresentation_ = 0;
+			planarConfiguration_ = 0;
+			photometricInterpretation_.clear();
+			hasWindowCenter_ = false;
+			windowCenter_ = 0.0;
+			hasWindowWidth_ = false;
+			windowWidth_ = 0.0;
+			hasRescaleSlope_ = false;
+			rescaleSlope_ = 1.0;
+			hasRescaleIntercept_ = false;
+			rescaleIntercept_ = 0.0;
 			ExtractImageAttributes();
 			ExtractPixelData();
 			return IsValid();
@@ -47,43 +125,80 @@ namespace medvision
 		{
 			using namespace medvision::dicom;
 
+			// Intern once so codec lookups compare integers, not UID strings.
+			// Values stay in the source byte order in the dataset.
+			std::string transferSyntax;
+			dataset_->GetString(DicomTag::TransferSyntaxUID, transferSyntax);
+			transferSyntaxId_ = TransferSyntax::Intern(transferSyntax);
+			isBigEndian_ = TransferSyntax::IsBigEndian(transferSyntax);
+
 			// Image dimensions
-			dataset_->GetUInt16(DicomTag::Rows, height_);
-			dataset_->GetUInt16(DicomTag::Columns, width_);
-			dataset_->GetUInt16(DicomTag::BitsAllocated, bitsAllocated_);
-			dataset_->GetUInt16(DicomTag::BitsStored, bitsStored_);
-			dataset_->GetUInt16(DicomTag::HighBit, highBit_);
-			dataset_->GetUInt16(DicomTag::SamplesPerPixel, samplesPerPixel_);
-			dataset_->GetUInt16(DicomTag::PixelRepresentation, pixelRepresentation_);
+			GetUInt16(DicomTag::Rows, height_);
+			GetUInt16(DicomTag::Columns, width_);
+			GetUInt16(DicomTag::BitsAllocated, bitsAllocated_);
+			GetUInt16(DicomTag::BitsStored, bitsStored_);
+			GetUInt16(DicomTag::HighBit, highBit_);
+			GetUInt16(DicomTag::SamplesPerPixel, samplesPerPixel_);
+			GetUInt16(DicomTag::PixelRepresentation, pixelRepresentation_);
 
 			// Photometric interpretation
 			dataset_->GetString(DicomTag::PhotometricInterpretation, photometricInterpretation_);
+			GetUInt16(DicomTag::PlanarConfiguration, planarConfiguration_);
+
+			// A missing, malformed or zero NumberOfFrames means a single frame
+			std::string framesStr;
+			numberOfFrames_ = 1;
+			if (dataset_->GetString(DicomTag::NumberOfFrames, framesStr) && !framesStr.empty())
+			{
+				char* end = nullptr;
+				unsigned long frames = std::strtoul(framesStr.c_str(), &end, 10);
+				while (end != nullptr && *end == ' ')
+				{
+					++end;
+				}
+				if (end != framesStr.c_str() && end != nullptr && *end == '\0' && frames > 0 && frames <= 0xFFFFFFFFul)
+				{
+					numberOfFrames_ = static_cast<uint32_t>(frames);
+				}
+			}
 
-			// Window/Level defaults
+			// Window/Level defaults; a malformed value leaves the attribute unset
 			std::string wlStr;
 			if (dataset_->GetString(DicomTag::WindowCenter, wlStr))
 			{
-				windowCenter_ = std::stod(wlStr);
-				hasWindowCenter_ = true;
+				hasWindowCenter_ = ParseDecimal(wlStr, windowCenter_);
 			}
 			if (dataset_->GetString(DicomTag::WindowWidth, wlStr))
 			{
-				windowWidth_ = std::stod(wlStr);
-				hasWindowWidth_ = true;
+				hasWindowWidth_ = ParseDecimal(wlStr, windowWidth_);
 			}
 
 			// Rescale parameters
 			std::string rescaleStr;
 			if (dataset_->GetString(DicomTag::RescaleSlope, rescaleStr))
 			{
-				rescaleSlope_ = std::stod(rescaleStr);
-				hasRescaleSlope_ = true;
+				hasRescaleSlope_ = ParseDecimal(rescaleStr, rescaleSlope_);
 			}
 			if (dataset_->GetString(DicomTag::RescaleIntercept, rescaleStr))
 			{
-				rescaleIntercept_ = std::stod(rescaleStr);
-				hasRescaleIntercept_ = true;
+				hasRescaleIntercept_ = ParseDecimal(rescaleStr, rescaleIntercept_);
+			}
+
+			// A missing, malformed or non-finite DoseGridScaling leaves values unscaled
+			std::string scalingStr;
+			hasDoseGridScaling_ = false;
+			doseGridScaling_ = 1.0;
+			if (dataset_->GetString(DicomTag::DoseGridScaling, scalingStr))
+			{
+				hasDoseGridScaling_ = ParseDecimal(scalingStr, doseGridScaling_);
 			}
+
+			// Pixel padding is US or SS, following PixelRepresentation
+			uint16_t padding = 0;
+			hasPixelPaddingValue_ = GetUInt16(DicomTag::PixelPaddingValue, padding);
+			pixelPaddingValue_ = IsSigned() ? static_cast<int16_t>(padding) : padding;
+			hasPixelPaddingRangeLimit_ = GetUInt16(DicomTag::PixelPaddingRangeLimit, padding);
+			pixelPaddingRangeLimit_ = IsSigned() ? static_cast<int16_t>(padding) : padding;
 		}
 
 		void DicomImage::ExtractPixelData()
@@ -93,11 +208,246 @@ namespace medvision
 			const DicomElement* pixelDataElement = dataset_->GetElement(DicomTag::PixelData);
 			if (pixelDataElement && !pixelDataElement->IsEmpty())
 			{
-				const uint8_t* data = pixelDataElement->GetData();
-				uint32_t length = pixelDataElement->GetLength();
+				if (pixelDataElement->IsUndefinedLength())
+				{
+					isCompressed_ = true;
+					DecodePixelData(*pixelDataElement);
+					return;
+				}
+
+				// OW swaps by word even for 8-bit samples; wider samples by their size
+				size_t swapUnit = bitsAllocated_ > 16 ? bitsAllocated_ / 8 : ByteSwap::GetSwapUnit(pixelDataElement->GetVR());
+				CopyPixelData(pixelDataElement->GetData(), pixelDataElement->GetLength(), swapUnit);
+				SubsamplePixelData();
+				return;
+			}
+
+			// Float Pixel Data and Double Float Pixel Data: one sample per pixel
+			const DicomElement* floatElement = dataset_->GetElement(DicomTag::FloatPixelData);
+			sampleFormat_ = SampleFormat::Float32;
+			if (!floatElement || floatElement->IsEmpty())
+			{
+				floatElement = dataset_->GetElement(DicomTag::DoubleFloatPixelData);
+				sampleFormat_ = SampleFormat::Float64;
+			}
+			if (!floatElement || floatElement->IsEmpty())
+			{
+				sampleFormat_ = SampleFormat::Integer;
+				return;
+			}
+
+			bitsAllocated_ = sampleFormat_ == SampleFormat::Float32 ? 32 : 64;
+			bitsStored_ = bitsAllocated_;
+			highBit_ = static_cast<uint16_t>(bitsAllocated_ - 1);
+			samplesPerPixel_ = 1;
+			CopyPixelData(floatElement->GetData(), floatElement->GetLength(), bitsAllocated_ / 8);
+			SubsamplePixelData();
+		}
+
+		bool DicomImage::GetUInt16(const medvision::dicom::DicomTag& tag, uint16_t& value) const
+		{
+			if (!dataset_->GetUInt16(tag, value))
+			{
+				return false;
+			}
+			if (isBigEndian_)
+			{
+				value = static_cast<uint16_t>((value << 8) | (value >> 8));
+			}
+			return true;
+		}
 
+		void DicomImage::CopyPixelData(const uint8_t* data, size_t length, size_t swapUnit)
+		{
+			using namespace medvision::dicom;
+
+			// Big endian samples are brought to native order in the copy itself
+			// (SIMD byte swap), so every consumer of rawPixelData_ sees native samples
+			if (!isBigEndian_ || swapUnit < 2)
+			{
 				rawPixelData_.assign(data, data + length);
+				return;
 			}
+
+			rawPixelData_.resize(length);
+			size_t count = length / swapUnit;
+			switch (swapUnit)
+			{
+			case 2:
+				ByteSwap::Copy16(rawPixelData_.data(), data, count);
+				break;
+			case 4:
+				ByteSwap::Copy32(rawPixelData_.data(), data, count);
+				break;
+			default:
+				ByteSwap::Copy64(rawPixelData_.data(), data, count);
+				break;
+			}
+			std::memcpy(rawPixelData_.data() + count * swapUnit, data + count * swapUnit, length - count * swapUnit);
+		}
+
+		void DicomImage::SubsamplePixelData()
+		{
+			if (reduction_ == 0 || rawPixelData_.empty())
+			{
+				return;
+			}
+
+			// YBR_FULL_422 pairs share chroma; widen to YBR_FULL so pixels can be picked one by one
+			if (IsChromaSubsampled())
+			{
+				size_t pixels = rawPixelData_.size() / 4 * 2;
+				std::vector<uint8_t> full(pixels * 3);
+				for (size_t i = 0; i < pixels; ++i)
+				{
+					const uint8_t* pair = rawPixelData_.data() + (i / 2) * 4;
+					full[i * 3] = pair[i % 2];
+					full[i * 3 + 1] = pair[2];
+					full[i * 3 + 2] = pair[3];
+				}
+				rawPixelData_.swap(full);
+				photometricInterpretation_ = "YBR_FULL";
+			}
+
+			// Nearest neighbour: the top-left sample of each 2^reduction square
+			size_t bytesPerSample = (bitsAllocated_ + 7) / 8;
+			size_t pixelLength = bytesPerSample * (planarConfiguration_ == 1 ? 1 : samplesPerPixel_);
+			size_t planes = planarConfiguration_ == 1 ? samplesPerPixel_ : 1;
+			size_t frameLength = static_cast<size_t>(width_) * height_ * samplesPerPixel_ * bytesPerSample;
+			if (bitsAllocated_ % 8 != 0 || frameLength == 0)
+			{
+				return;
+			}
+			size_t frames = rawPixelData_.size() / frameLength;
+
+			uint32_t scale = 1u << reduction_;
+			size_t columns = (width_ + scale - 1) >> reduction_;
+			size_t rows = (height_ + scale - 1) >> reduction_;
+			uint8_t* output = rawPixelData_.data();
+			for (size_t plane = 0; plane < frames * planes; ++plane)
+			{
+				const uint8_t* source = rawPixelData_.data() + plane * frameLength / planes;
+				for (size_t y = 0; y < rows; ++y)
+				{
+					const uint8_t* sourceRow = source + (y << reduction_) * width_ * pixelLength;
+					for (size_t x = 0; x < columns; ++x)
+					{
+						// Output never overtakes the input, so compaction can run in place
+						std::memmove(output, sourceRow + (x << reduction_) * pixelLength, pixelLength);
+						output += pixelLength;
+					}
+				}
+			}
+
+			rawPixelData_.resize(output - rawPixelData_.data());
+			width_ = static_cast<uint16_t>(columns);
+			height_ = static_cast<uint16_t>(rows);
+		}
+
+		bool DicomImage::DecodePixelData(const medvision::dicom::DicomElement& pixelDataElement)
+		{
+			using namespace medvision::dicom;
+
+			std::shared_ptr<const PixelDecoder> decoder = CodecRegistry::Instance().FindDecoder(transferSyntaxId_);
+			if (!decoder)
+			{
+				lastError_ = "No decoder registered for " + TransferSyntax::GetUID(transferSyntaxId_);
+				return false;
+			}
+
+			// The Extended Offset Table locates frames when the Basic Offset Table is empty
+			const DicomElement* extendedOffsetTable = dataset_->GetElement(DicomTag::ExtendedOffsetTable);
+			EncapsulatedPixelData encapsulated;
+			if (!encapsulated.Parse(pixelDataElement.GetData(), pixelDataElement.GetLength(), numberOfFrames_,
+				extendedOffsetTable ? extendedOffsetTable->GetData() : nullptr,
+				extendedOffsetTable ? extendedOffsetTable->GetLength() : 0))
+			{
+				lastError_ = encapsulated.GetLastError();
+				return false;
+			}
+
+			FrameInfo info;
+			info.rows = height_;
+			info.columns = width_;
+			info.samplesPerPixel = samplesPerPixel_;
+			info.bitsAllocated = bitsAllocated_;
+			info.bitsStored = bitsStored_;
+			info.pixelRepresentation = pixelRepresentation_;
+			info.planarConfiguration = planarConfiguration_;
+			info.photometricInterpretation = photometricInterpretation_;
+
+			// Reduced-resolution decoders write the preview size directly
+			bool decodeReduced = reduction_ != 0 && (decoder->GetCapabilities() & CodecPartialDecode);
+			size_t frameLength = decodeReduced ? info.Reduce(reduction_).GetFrameLength() : info.GetFrameLength();
+			size_t frameCount = encapsulated.GetFrameCount();
+			if (info.GetFrameLength() == 0)
+			{
+				lastError_ = "Invalid image dimensions";
+				return false;
+			}
+			rawPixelData_.resize(frameLength * frameCount);
+
+			// Frames decode concurrently straight into their slots of rawPixelData_
+			FrameDecodeScheduler scheduler(encapsulated, decoder, info, decodeReduced ? reduction_ : 0, rawPixelData_.data());
+			scheduler.Start();
+			if (!scheduler.WaitAll())
+			{
+				lastError_ = scheduler.GetLastError();
+				rawPixelData_.clear();
+				return false;
+			}
+
+			// Decoders always deliver interleaved samples, possibly color converted
+			planarConfiguration_ = 0;
+			photometricInterpretation_ = decoder->GetDecodedPhotometricInterpretation(info);
+			if (decodeReduced)
+			{
+				FrameInfo reduced = info.Reduce(reduction_);
+				width_ = reduced.columns;
+				height_ = reduced.rows;
+			}
+			else
+			{
+				SubsamplePixelData();
+			}
+			return true;
+		}
+
+		uint32_t DicomImage::GetNumberOfFrames() const
+		{
+			size_t frameLength = GetFrameLength();
+			if (frameLength == 0)
+			{
+				return 0;
+			}
+			size_t available = rawPixelData_.size() / frameLength;
+			return available < numberOfFrames_ ? static_cast<uint32_t>(available) : numberOfFrames_;
+		}
+
+		size_t DicomImage::GetFrameLength() const
+		{
+			size_t pixels = static_cast<size_t>(width_) * height_;
+			if (IsChromaSubsampled())
+			{
+				// Y0 Y1 Cb Cr for every two pixels
+				return (pixels + 1) / 2 * 4;
+			}
+			size_t bytesPerSample = (bitsAllocated_ + 7) / 8;
+			return pixels * samplesPerPixel_ * bytesPerSample;
+		}
+
+		bool DicomImage::IsChromaSubsampled() const
+		{
+			return photometricInterpretation_ == "YBR_FULL_422" && samplesPerPixel_ == 3 && bitsAllocated_ == 8;
+		}
+
+		const uint8_t* DicomImage::GetFramePixelData(uint32_t frame) const
+		{
+			if (frame >= GetNumberOfFrames())
+			{
+				return nullptr;
+			}
+			return rawPixelData_.data() + frame * GetFrameLength();
 		}
 
 		bool DicomImage::GetWindowCenter(double& center) const
@@ -142,6 +492,112 @@ namespace medvision
 			return false;
 		}
 
+		bool DicomImage::GetDoseGridScaling(double& scaling) const
+		{
+			scaling = doseGridScaling_;
+			return hasDoseGridScaling_;
+		}
+
+		bool DicomImage::GetPixelPaddingValue(int32_t& value) const
+		{
+			value = pixelPaddingValue_;
+			return hasPixelPaddingValue_;
+		}
+
+		bool DicomImage::GetPixelPaddingRangeLimit(int32_t& limit) const
+		{
+			if (hasPixelPaddingRangeLimit_)
+			{
+				limit = pixelPaddingRangeLimit_;
+				return true;
+			}
+			limit = pixelPaddingValue_;
+			return false;
+		}
+
+		bool DicomImage::GetPaletteColorLut(int channel, std::vector<uint16_t>& entries, int32_t& firstMapped, uint16_t& bitsPerEntry) const
+		{
+			using namespace medvision::dicom;
+
+			static const DicomTag* const descriptors[3] = { &DicomTag::RedPaletteColorLookupTableDescriptor,
+				&DicomTag::GreenPaletteColorLookupTableDescriptor, &DicomTag::BluePaletteColorLookupTableDescriptor };
+			static const DicomTag* const data[3] = { &DicomTag::RedPaletteColorLookupTableData,
+				&DicomTag::GreenPaletteColorLookupTableData, &DicomTag::BluePaletteColorLookupTableData };
+			static const DicomTag* const segmented[3] = { &DicomTag::SegmentedRedPaletteColorLookupTableData,
+				&DicomTag::SegmentedGreenPaletteColorLookupTableData, &DicomTag::SegmentedBluePaletteColorLookupTableData };
+
+			entries.clear();
+			if (dataset_ == nullptr || channel < 0 || channel > 2)
+			{
+				return false;
+			}
+
+			// Descriptor: entry count (0 means 65536), first mapped value (US or SS), bits per entry
+			const DicomElement* descriptorElement = dataset_->GetElement(*descriptors[channel]);
+			if (descriptorElement == nullptr || descriptorElement->GetLength() < 6)
+			{
+				return false;
+			}
+			uint16_t descriptor[3];
+			std::memcpy(descriptor, descriptorElement->GetData(), sizeof(descriptor));
+			if (isBigEndian_)
+			{
+				ByteSwap::Swap16(reinterpret_cast<uint8_t*>(descriptor), 3);
+			}
+			size_t count = descriptor[0] == 0 ? 65536 : descriptor[0];
+			firstMapped = IsSigned() ? static_cast<int16_t>(descriptor[1]) : descriptor[1];
+			bitsPerEntry = descriptor[2];
+			if (bitsPerEntry != 8 && bitsPerEntry != 16)
+			{
+				return false;
+			}
+
+			const DicomElement* dataElement = dataset_->GetElement(*data[channel]);
+			if (dataElement != nullptr && !dataElement->IsEmpty())
+			{
+				size_t length = dataElement->GetLength();
+				const uint8_t* bytes = dataElement->GetData();
+				std::vector<uint8_t> native;
+				if (isBigEndian_)
+				{
+					// OW data: restore the word order before reading entries or packed bytes
+					native.resize(length);
+					ByteSwap::CopySwappedValue(dataElement->GetVR(), native.data(), bytes, length);
+					bytes = native.data();
+				}
+				if (bitsPerEntry == 8 && length < count * 2)
+				{
+					// 8-bit entries packed two to a word
+					if (length < count)
+					{
+						return false;
+					}
+					entries.assign(bytes, bytes + count);
+					return true;
+				}
+				if (length < count * 2)
+				{
+					return false;
+				}
+				entries.resize(count);
+				std::memcpy(entries.data(), bytes, count * 2);
+				return true;
+			}
+
+			const DicomElement* segmentedElement = dataset_->GetElement(*segmented[channel]);
+			if (segmentedElement == nullptr || segmentedElement->GetLength() < 2)
+			{
+				return false;
+			}
+			std::vector<uint16_t> words(segmentedElement->GetLength() / 2);
+			std::memcpy(words.data(), segmentedElement->GetData(), words.size() * 2);
+			if (isBigEndian_)
+			{
+				ByteSwap::Swap16(reinterpret_cast<uint8_t*>(words.data()), words.size());
+			}
+			return ColorConvert::ExpandSegmentedLut(words.data(), words.size(), count, entries);
+		}
+
 		std::string DicomImage::GetPatientName() const
 		{
 			std::string value;
@@ -0,0 +1,157 @@
+#include "medvision/imaging/DisplayLut.h"
+#include "medvision/imaging/PixelDataProcessor.h"
+#include "medvision/imaging/TileScheduler.h"
+#include "medvision/dicom/PixelConvert.h"
+
+namespace medvision
+{
+	namespace imaging
+	{
+		namespace
+		{
+			template <typename T>
+			void Lookup(const uint8_t* table, const T* input, size_t count, uint8_t* output)
+			{
+				size_t i = 0;
+				for (; i + 4 <= count; i += 4)
+				{
+					output[i] = table[input[i]];
+					output[i + 1] = table[input[i + 1]];
+					output[i + 2] = table[input[i + 2]];
+					output[i + 3] = table[input[i + 3]];
+				}
+				for (; i < count; ++i)
+				{
+					output[i] = table[input[i]];
+				}
+			}
+		}
+
+		DisplayLut::DisplayLut()
+			: invert_(false)
+			, bitsAllocated_(0)
+		{
+		}
+
+		bool DisplayLut::Build(const DicomImage& image, const WindowLevel& window)
+		{
+			modality_.clear();
+			table_.clear();
+			bitsAllocated_ = image.GetBitsAllocated();
+			if (image.IsColor() || image.GetSampleFormat() != DicomImage::SampleFormat::Integer
+				|| (bitsAllocated_ != 8 && bitsAllocated_ != 16))
+			{
+				return false;
+			}
+
+			double slope, intercept;
+			PixelDataProcessor::GetRescale(image, slope, intercept);
+			dicom::SampleLayout layout = PixelDataProcessor::GetSampleLayout(image);
+
+			// The same conversion as PixelDataProcessor, run once over every raw sample
+			modality_.resize(static_cast<size_t>(1) << bitsAllocated_);
+			if (bitsAllocated_ == 8)
+			{
+				std::vector<uint8_t> samples(modality_.size());
+				for (size_t i = 0; i < samples.size(); ++i)
+				{
+					samples[i] = static_cast<uint8_t>(i);
+				}
+				dicom::PixelConvert::ToFloat(samples.data(), samples.size(), layout, slope, intercept, modality_.data());
+			}
+			else
+			{
+				std::vector<uint16_t> samples(modality_.size());
+				for (size_t i = 0; i < samples.size(); ++i)
+				{
+					samples[i] = static_cast<uint16_t>(i);
+				}
+				dicom::PixelConvert::ToFloat(samples.data(), samples.size(), layout, slope, intercept, modality_.data());
+			}
+
+			// MONOCHROME1 shows the minimum as white
+			invert_ = image.GetPhotometricInterpretation() == "MONOCHROME1";
+			window_ = window;
+			Compile();
+			return true;
+		}
+
+		void DisplayLut::SetWindow(const WindowLevel& window)
+		{
+			window_ = window;
+			if (!modality_.empty())
+			{
+				Compile();
+			}
+		}
+
+		void DisplayLut::Compile()
+		{
+			window_.Apply(modality_, table_);
+			if (invert_)
+			{
+				for (uint8_t& value : table_)
+				{
+					value = static_cast<uint8_t>(255 - value);
+				}
+			}
+		}
+
+		bool DisplayLut::Apply(const DicomImage& image, std::vector<uint8_t>& output) const
+		{
+			if (image.GetNumberOfFrames() == 0)
+			{
+				return false;
+			}
+			output.resize(static_cast<size_t>(image.GetWidth()) * image.GetHeight());
+			return ApplyFrame(image, 0, output.data());
+		}
+
+		bool DisplayLut::ApplyFrame(const DicomImage& image, uint32_t frame, uint8_t* output) const
+		{
+			if (image.GetBitsAllocated() != bitsAllocated_ || image.IsColor() || frame >= image.GetNumberOfFrames())
+			{
+				return false;
+			}
+
+			size_t numPixels = static_cast<size_t>(image.GetWidth()) * image.GetHeight();
+			const uint8_t* data = image.GetFramePixelData(frame);
+			if (table_.empty())
+			{
+				return false;
+			}
+			TileScheduler::ForEachTile(numPixels, [&](size_t first, size_t count) {
+				if (bitsAllocated_ == 8)
+				{
+					Lookup(table_.data(), data + first, count, output + first);
+				}
+				else
+				{
+					Lookup(table_.data(), reinterpret_cast<const uint16_t*>(data) + first, count, output + first);
+				}
+			});
+			return true;
+		}
+
+		bool DisplayLut::Apply(const uint8_t* input, size_t count, uint8_t* output) const
+		{
+			if (bitsAllocated_ != 8 || table_.empty())
+			{
+				return false;
+			}
+			Lookup(table_.data(), input, count, output);
+			return true;
+		}
+
+		bool DisplayLut::Apply(const uint16_t* input, size_t count, uint8_t* output) const
+		{
+			if (bitsAllocated_ != 16 || table_.empty())
+			{
+				return false;
+			}
+			Lookup(table_.data(), input, count, output);
+			return true;
+		}
+
+	} // namespace imaging
+} // namespace medvision
@@ -1,57 +1,234 @@
 #include "medvision/imaging/PixelDataProcessor.h"
+#include "medvision/imaging/TileScheduler.h"
+#include "medvision/dicom/ThreadPool.h"
+#include <algorithm>
 #include <cstring>
 
 namespace medvision
 {
 	namespace imaging
 	{
+		namespace
+		{
+			/// Values converted to float before narrowing to a compact type;
+			/// the float staging buffer stays within L1
+			const size_t NarrowChunk = 1024;
+		}
+
 		bool PixelDataProcessor::ProcessPixelData(const DicomImage& image, std::vector<float>& outputBuffer)
 		{
-			if (!image.HasPixelData())
+			if (!IsSupported(image))
+			{
+				return false;
+			}
+
+			outputBuffer.resize(static_cast<size_t>(image.GetWidth()) * image.GetHeight());
+			return ProcessFrame(image, 0, outputBuffer.data());
+		}
+
+		bool PixelDataProcessor::ProcessPixelData(const DicomImage& image, float* output, size_t capacity)
+		{
+			return ProcessPixelDataAs(image, output, capacity);
+		}
+
+		bool PixelDataProcessor::ProcessPixelData(const DicomImage& image, int16_t* output, size_t capacity)
+		{
+			return ProcessPixelDataAs(image, output, capacity);
+		}
+
+		bool PixelDataProcessor::ProcessPixelData(const DicomImage& image, uint16_t* output, size_t capacity)
+		{
+			return ProcessPixelDataAs(image, output, capacity);
+		}
+
+		bool PixelDataProcessor::ProcessPixelData(const DicomImage& image, dicom::Half* output, size_t capacity)
+		{
+			return ProcessPixelDataAs(image, output, capacity);
+		}
+
+		bool PixelDataProcessor::ProcessFrame(const DicomImage& image, uint32_t frame, float* output)
+		{
+			return ProcessFrameAs(image, frame, output);
+		}
+
+		bool PixelDataProcessor::ProcessFrame(const DicomImage& image, uint32_t frame, int16_t* output)
+		{
+			return ProcessFrameAs(image, frame, output);
+		}
+
+		bool PixelDataProcessor::ProcessFrame(const DicomImage& image, uint32_t frame, uint16_t* output)
+		{
+			return ProcessFrameAs(image, frame, output);
+		}
+
+		bool PixelDataProcessor::ProcessFrame(const DicomImage& image, uint32_t frame, dicom::Half* output)
+		{
+			return ProcessFrameAs(image, frame, output);
+		}
+
+		bool PixelDataProcessor::ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, float* output)
+		{
+			return ProcessFramesAs(image, firstFrame, frameCount, output);
+		}
+
+		bool PixelDataProcessor::ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, int16_t* output)
+		{
+			return ProcessFramesAs(image, firstFrame, frameCount, output);
+		}
+
+		bool PixelDataProcessor::ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, uint16_t* output)
+		{
+			return ProcessFramesAs(image, firstFrame, frameCount, output);
+		}
+
+		bool PixelDataProcessor::ProcessFrames(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount,
+			dicom::Half* output)
+		{
+			return ProcessFramesAs(image, firstFrame, frameCount, output);
+		}
+
+		template <typename T>
+		bool PixelDataProcessor::ProcessPixelDataAs(const DicomImage& image, T* output, size_t capacity)
+		{
+			if (output == nullptr || capacity < static_cast<size_t>(image.GetWidth()) * image.GetHeight())
+			{
+				return false;
+			}
+			return ProcessFrameAs(image, 0, output);
+		}
+
+		template <typename T>
+		bool PixelDataProcessor::ProcessFrameAs(const DicomImage& image, uint32_t frame, T* output)
+		{
+			if (!IsSupported(image) || frame >= image.GetNumberOfFrames())
+			{
+				return false;
+			}
+
+			size_t numPixels = static_cast<size_t>(image.GetWidth()) * image.GetHeight();
+			const uint8_t* data = image.GetFramePixelData(frame);
+
+			// Rescale slope/intercept (identity when absent) is applied in the same pass
+			double slope, intercept;
+			GetRescale(image, slope, intercept);
+			dicom::SampleLayout layout = GetSampleLayout(image);
+			DicomImage::SampleFormat format = image.GetSampleFormat();
+			size_t sampleBytes = image.GetBitsAllocated() / 8;
+
+			// Large frames are converted in tiles across the shared thread pool
+			TileScheduler::ForEachTile(numPixels, [&](size_t first, size_t count) {
+				ProcessTile(format, sampleBytes, data + first * sampleBytes, count, layout, slope, intercept, output + first);
+			});
+			return true;
+		}
+
+		template <typename T>
+		bool PixelDataProcessor::ProcessFramesAs(const DicomImage& image, uint32_t firstFrame, uint32_t frameCount, T* output)
+		{
+			uint32_t frames = image.GetNumberOfFrames();
+			if (!IsSupported(image) || firstFrame > frames || frameCount > frames - firstFrame)
 			{
 				return false;
 			}
 
+			// Frames are independent; each worker converts whole frames, and a
+			// frame larger than a tile is split further on the same pool
 			size_t numPixels = static_cast<size_t>(image.GetWidth()) * image.GetHeight();
-			const uint8_t* data = image.GetRawPixelData();
+			dicom::ThreadPool::Shared().ParallelFor(frameCount, [&](size_t i) {
+				ProcessFrameAs(image, firstFrame + static_cast<uint32_t>(i), output + i * numPixels);
+			});
+			return true;
+		}
 
-			bool success = false;
+		bool PixelDataProcessor::IsSupported(const DicomImage& image)
+		{
+			if (!image.HasPixelData() || image.GetNumberOfFrames() == 0 || image.GetSamplesPerPixel() != 1)
+			{
+				return false;
+			}
 
-			if (image.GetBitsAllocated() == 8)
+			uint16_t bitsAllocated = image.GetBitsAllocated();
+			switch (image.GetSampleFormat())
 			{
-				success = Process8Bit(data, numPixels, outputBuffer);
+			case DicomImage::SampleFormat::Float32:
+				return bitsAllocated == 32;
+			case DicomImage::SampleFormat::Float64:
+				return bitsAllocated == 64;
+			default:
+				return bitsAllocated == 8 || bitsAllocated == 16 || bitsAllocated == 32;
 			}
-			else if (image.GetBitsAllocated() == 16)
+		}
+
+		void PixelDataProcessor::ProcessTile(DicomImage::SampleFormat format, size_t sampleBytes, const uint8_t* data,
+			size_t pixels, const dicom::SampleLayout& layout, double slope, double intercept, float* output)
+		{
+			switch (format)
 			{
-				if (image.IsSigned())
+			case DicomImage::SampleFormat::Float32:
+				dicom::PixelConvert::RealToFloat(data, pixels, 32, slope, intercept, output);
+				break;
+			case DicomImage::SampleFormat::Float64:
+				dicom::PixelConvert::RealToFloat(data, pixels, 64, slope, intercept, output);
+				break;
+			default:
+				if (sampleBytes == 1)
 				{
-					success = Process16BitSigned(data, numPixels, outputBuffer);
+					Process8Bit(data, pixels, layout, slope, intercept, output);
+				}
+				else if (sampleBytes == 2)
+				{
+					Process16Bit(data, pixels, layout, slope, intercept, output);
 				}
 				else
 				{
-					success = Process16BitUnsigned(data, numPixels, outputBuffer);
+					Process32Bit(data, pixels, layout, slope, intercept, output);
 				}
+				break;
+			}
+		}
+
+		template <typename T>
+		void PixelDataProcessor::ProcessTile(DicomImage::SampleFormat format, size_t sampleBytes, const uint8_t* data,
+			size_t pixels, const dicom::SampleLayout& layout, double slope, double intercept, T* output)
+		{
+			float buffer[NarrowChunk];
+			for (size_t done = 0; done < pixels; done += NarrowChunk)
+			{
+				size_t count = std::min(NarrowChunk, pixels - done);
+				ProcessTile(format, sampleBytes, data + done * sampleBytes, count, layout, slope, intercept, buffer);
+				dicom::PixelConvert::FromFloat(buffer, count, output + done);
 			}
+		}
 
-			if (success)
+		dicom::SampleLayout PixelDataProcessor::GetSampleLayout(const DicomImage& image)
+		{
+			dicom::SampleLayout layout(image.GetBitsStored(), image.GetHighBit(), image.IsSigned());
+			if (image.GetPixelPaddingValue(layout.paddingValue))
 			{
-				// Apply rescale slope/intercept if present
+				layout.hasPadding = true;
+				image.GetPixelPaddingRangeLimit(layout.paddingLimit);
+
+				// Padding shows as the lowest value the stored bits can represent
 				double slope, intercept;
-				if (image.GetRescaleSlope(slope) || image.GetRescaleIntercept(intercept))
-				{
-					if (!image.GetRescaleSlope(slope))
-					{
-						slope = 1.0;
-					}
-					if (!image.GetRescaleIntercept(intercept))
-					{
-						intercept = 0.0;
-					}
-					ApplyRescale(outputBuffer, slope, intercept);
-				}
+				GetRescale(image, slope, intercept);
+				int64_t minimum, maximum;
+				dicom::PixelConvert::GetStoredRange(layout, image.GetBitsAllocated(), minimum, maximum);
+				float low = static_cast<float>(minimum * slope + intercept);
+				float high = static_cast<float>(maximum * slope + intercept);
+				layout.paddingOutput = low < high ? low : high;
 			}
+			return layout;
+		}
 
-			return success;
+		void PixelDataProcessor::GetRescale(const DicomImage& image, double& slope, double& intercept)
+		{
+			double scaling;
+			image.GetRescaleSlope(slope);
+			image.GetRescaleIntercept(intercept);
+			if (image.GetDoseGridScaling(scaling))
+			{
+				slope *= scaling;
+			}
 		}
 
 		void PixelDataProcessor::ApplyRescale(std::vector<float>& buffer, double slope, double intercept)
@@ -62,37 +239,24 @@ namespace medvision
 			}
 		}
 
-		bool PixelDataProcessor::Process8Bit(const uint8_t* data, size_t pixels, std::vector<float>& output)
+		bool PixelDataProcessor::Process8Bit(const uint8_t* data, size_t pixels, const dicom::SampleLayout& layout,
+			double slope, double intercept, float* output)
 		{
-			output.resize(pixels);
-			for (size_t i = 0; i < pixels; ++i)
-			{
-				output[i] = static_cast<float>(data[i]);
-			}
+			dicom::PixelConvert::ToFloat(data, pixels, layout, slope, intercept, output);
 			return true;
 		}
 
-		bool PixelDataProcessor::Process16BitUnsigned(const uint8_t* data, size_t pixels, std::vector<float>& output)
+		bool PixelDataProcessor::Process16Bit(const uint8_t* data, size_t pixels, const dicom::SampleLayout& layout,
+			double slope, double intercept, float* output)
 		{
-			output.resize(pixels);
-			const uint16_t* data16 = reinterpret_cast<const uint16_t*>(data);
-
-			for (size_t i = 0; i < pixels; ++i)
-			{
-				output[i] = static_cast<float>(data16[i]);
-			}
+			dicom::PixelConvert::ToFloat(data, pixels, 16, layout, slope, intercept, output);
 			return true;
 		}
 
-		bool PixelDataProcessor::Process16BitSigned(const uint8_t* data, size_t pixels, std::vector<float>& output)
+		bool PixelDataProcessor::Process32Bit(const uint8_t* data, size_t pixels, const dicom::SampleLayout& layout,
+			double slope, double intercept, float* output)
 		{
-			output.resize(pixels);
-			const int16_t* data16 = reinterpret_cast<const int16_t*>(data);
-
-			for (size_t i = 0; i < pixels; ++i)
-			{
-				output[i] = static_cast<float>(data16[i]);
-			}
+			dicom::PixelConvert::ToFloat(data, pixels, 32, layout, slope, intercept, output);
 			return true;
 		}
 
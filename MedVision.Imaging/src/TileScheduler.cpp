@@ -0,0 +1,56 @@
+#include "medvision/imaging/TileScheduler.h"
+#include "medvision/dicom/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace medvision
+{
+	namespace imaging
+	{
+		namespace
+		{
+			const size_t TileAlignment = 64;
+
+			std::atomic<size_t> tilePixels(TileScheduler::DefaultTilePixels);
+		}
+
+		const size_t TileScheduler::DefaultTilePixels;
+
+		void TileScheduler::SetTilePixels(size_t pixels)
+		{
+			if (pixels == 0)
+			{
+				pixels = DefaultTilePixels;
+			}
+			// Clamp first so rounding up cannot wrap to 0
+			pixels = std::min(pixels, std::numeric_limits<size_t>::max() / 2);
+			tilePixels = (pixels + TileAlignment - 1) / TileAlignment * TileAlignment;
+		}
+
+		size_t TileScheduler::GetTilePixels()
+		{
+			return tilePixels;
+		}
+
+		void TileScheduler::ForEachTile(size_t total, const std::function<void(size_t, size_t)>& fn)
+		{
+			size_t tile = tilePixels;
+			size_t tiles = total / tile + (total % tile != 0 ? 1 : 0);
+			if (tiles <= 1)
+			{
+				if (total > 0)
+				{
+					fn(0, total);
+				}
+				return;
+			}
+
+			dicom::ThreadPool::Shared().ParallelFor(tiles, [&](size_t i) {
+				size_t first = i * tile;
+				fn(first, std::min(tile, total - first));
+			});
+		}
+
+	} // namespace imaging
+} // namespace medvision
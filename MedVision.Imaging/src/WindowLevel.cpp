@@ -1,4 +1,5 @@
 #include "medvision/imaging/WindowLevel.h"
+#include "medvision/imaging/TileScheduler.h"
 #include <algorithm>
 #include <cmath>
 
@@ -38,24 +39,26 @@ namespace medvision
 			double minValue = center_ - width_ / 2.0;
 			double maxValue = center_ + width_ / 2.0;
 
-			for (size_t i = 0; i < input.size(); ++i)
-			{
-				double value = input[i];
-
-				if (value <= minValue)
-				{
-					output[i] = 0;
-				}
-				else if (value >= maxValue)
+			TileScheduler::ForEachTile(input.size(), [&](size_t first, size_t count) {
+				for (size_t i = first; i < first + count; ++i)
 				{
-					output[i] = 255;
+					double value = input[i];
+
+					if (value <= minValue)
+					{
+						output[i] = 0;
+					}
+					else if (value >= maxValue)
+					{
+						output[i] = 255;
+					}
+					else
+					{
+						double normalized = (value - minValue) / width_;
+						output[i] = static_cast<uint8_t>(normalized * 255.0);
+					}
 				}
-				else
-				{
-					double normalized = (value - minValue) / width_;
-					output[i] = static_cast<uint8_t>(normalized * 255.0);
-				}
-			}
+			});
 		}
 
 		void WindowLevel::ApplyNormalized(std::vector<float>& pixels) const
@@ -63,23 +66,25 @@ namespace medvision
 			double minValue = center_ - width_ / 2.0;
 			double maxValue = center_ + width_ / 2.0;
 
-			for (size_t i = 0; i < pixels.size(); ++i)
-			{
-				double value = pixels[i];
-
-				if (value <= minValue)
-				{
-					pixels[i] = 0.0f;
-				}
-				else if (value >= maxValue)
+			TileScheduler::ForEachTile(pixels.size(), [&](size_t first, size_t count) {
+				for (size_t i = first; i < first + count; ++i)
 				{
-					pixels[i] = 1.0f;
+					double value = pixels[i];
+
+					if (value <= minValue)
+					{
+						pixels[i] = 0.0f;
+					}
+					else if (value >= maxValue)
+					{
+						pixels[i] = 1.0f;
+					}
+					else
+					{
+						pixels[i] = static_cast<float>((value - minValue) / width_);
+					}
 				}
-				else
-				{
-					pixels[i] = static_cast<float>((value - minValue) / width_);
-				}
-			}
+			});
 		}
 
 		WindowLevel WindowLevel::FromPercentiles(const std::vector<float>& pixels, double lowPct, double highPct)
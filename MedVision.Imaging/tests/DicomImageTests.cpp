@@ -0,0 +1,430 @@
+// Unit tests for DicomImage class
+// Tests image attribute extraction, multi-frame pixel data access and big endian sources
+
+#include "CppUnitTest.h"
+#include "medvision/imaging/ColorPipeline.h"
+#include "medvision/imaging/DicomImage.h"
+#include "medvision/imaging/PixelDataProcessor.h"
+#include "medvision/dicom/DicomDataSet.h"
+#include "medvision/dicom/DicomReader.h"
+#include "medvision/dicom/DicomWriter.h"
+#include "medvision/dicom/TransferSyntax.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+using namespace medvision::imaging;
+
+namespace MedVisionImagingTests
+{
+	namespace
+	{
+		const uint16_t kRows = 6;
+		const uint16_t kColumns = 5;
+	}
+
+	TEST_CLASS(DicomImageTests)
+	{
+	private:
+		// 16-bit grayscale frames; sample i of the PixelData holds i
+		static DicomDataSet CreateMultiFrameImage(const std::string& numberOfFrames, size_t framesPresent)
+		{
+			DicomDataSet dataSet;
+			dataSet.SetUInt16(DicomTag::Rows, kRows);
+			dataSet.SetUInt16(DicomTag::Columns, kColumns);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 16);
+			dataSet.SetUInt16(DicomTag::BitsStored, 16);
+			dataSet.SetUInt16(DicomTag::HighBit, 15);
+			dataSet.SetUInt16(DicomTag::PixelRepresentation, 0);
+			dataSet.SetString(DicomTag::PhotometricInterpretation, VR::CS, "MONOCHROME2");
+			if (!numberOfFrames.empty())
+			{
+				dataSet.SetString(DicomTag::NumberOfFrames, VR::IS, numberOfFrames);
+			}
+
+			std::vector<uint8_t> pixels(static_cast<size_t>(kRows) * kColumns * 2 * framesPresent);
+			for (size_t i = 0; i < pixels.size() / 2; ++i)
+			{
+				pixels[i * 2] = static_cast<uint8_t>(i);
+				pixels[i * 2 + 1] = static_cast<uint8_t>(i >> 8);
+			}
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+			return dataSet;
+		}
+
+		// Grayscale or palette image with the file meta information DicomWriter needs
+		static DicomDataSet CreateImage(uint16_t bitsAllocated, uint16_t pixelRepresentation, const std::string& photometric,
+			const DicomTag& pixelTag, VR vr, const std::vector<uint8_t>& pixels)
+		{
+			DicomDataSet dataSet;
+			dataSet.SetString(DicomTag::FileMetaInformationVersion, VR::OB, std::string("\x00\x01", 2));
+			dataSet.SetString(DicomTag::MediaStorageSOPClassUID, VR::UI, "1.2.840.10008.5.1.4.1.1.2");
+			dataSet.SetString(DicomTag::MediaStorageSOPInstanceUID, VR::UI, "1.2.3.4.5.6.7.8.9");
+			dataSet.SetString(DicomTag::TransferSyntaxUID, VR::UI, TransferSyntax::ExplicitVRLittleEndian);
+			dataSet.SetString(DicomTag::ImplementationClassUID, VR::UI, "1.2.840.999999.1");
+
+			dataSet.SetUInt16(DicomTag::Rows, kRows);
+			dataSet.SetUInt16(DicomTag::Columns, kColumns);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, bitsAllocated);
+			dataSet.SetUInt16(DicomTag::BitsStored, bitsAllocated == 16 ? 12 : bitsAllocated);
+			dataSet.SetUInt16(DicomTag::HighBit, bitsAllocated == 16 ? 11 : static_cast<uint16_t>(bitsAllocated - 1));
+			dataSet.SetUInt16(DicomTag::PixelRepresentation, pixelRepresentation);
+			dataSet.SetString(DicomTag::PhotometricInterpretation, VR::CS, photometric);
+
+			DicomElement pixelData(pixelTag, vr);
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+			return dataSet;
+		}
+
+		// Round trip through Explicit VR Big Endian; the reader keeps the values as stored
+		static DicomDataSet ToBigEndian(const DicomDataSet& dataSet)
+		{
+			std::vector<uint8_t> buffer;
+			DicomWriter writer;
+			writer.SetTransferSyntax(TransferSyntax::ExplicitVRBigEndian);
+			Assert::IsTrue(writer.WriteBuffer(buffer, dataSet));
+
+			DicomReader reader;
+			DicomDataSet bigEndian;
+			Assert::IsTrue(reader.ReadBuffer(buffer.data(), buffer.size(), bigEndian));
+			return bigEndian;
+		}
+
+		static void AddWords(DicomDataSet& dataSet, const DicomTag& tag, VR vr, const std::vector<uint16_t>& words)
+		{
+			DicomElement element(tag, vr);
+			std::vector<uint8_t> bytes;
+			for (uint16_t word : words)
+			{
+				bytes.push_back(static_cast<uint8_t>(word));
+				bytes.push_back(static_cast<uint8_t>(word >> 8));
+			}
+			element.SetData(bytes);
+			dataSet.AddElement(element);
+		}
+
+	public:
+		TEST_METHOD(DicomImage_GetNumberOfFrames_ReadsNumberOfFrames)
+		{
+			DicomDataSet dataSet = CreateMultiFrameImage("4", 4);
+			DicomImage image(dataSet);
+
+			Assert::IsTrue(image.IsValid());
+			Assert::AreEqual(4u, image.GetNumberOfFrames());
+			Assert::AreEqual(static_cast<size_t>(kRows) * kColumns * 2, image.GetFrameLength());
+		}
+
+		TEST_METHOD(DicomImage_GetNumberOfFrames_ClampsToAvailableData)
+		{
+			// Only two and a half frames are present
+			DicomDataSet dataSet = CreateMultiFrameImage("5", 3);
+			DicomElement* pixelData = dataSet.GetElement(DicomTag::PixelData);
+			std::vector<uint8_t> truncated = pixelData->GetDataVector();
+			truncated.resize(truncated.size() - kRows * kColumns);
+			pixelData->SetData(truncated);
+
+			DicomImage image(dataSet);
+			Assert::AreEqual(2u, image.GetNumberOfFrames());
+			Assert::IsNotNull(image.GetFramePixelData(1));
+			Assert::IsNull(image.GetFramePixelData(2));
+		}
+
+		TEST_METHOD(DicomImage_GetNumberOfFrames_MalformedValueMeansOneFrame)
+		{
+			const char* values[] = { "abc", "0", "3x", "-", "" };
+			for (const char* value : values)
+			{
+				DicomDataSet dataSet = CreateMultiFrameImage(value, 3);
+				DicomImage image(dataSet);
+				Assert::AreEqual(1u, image.GetNumberOfFrames());
+			}
+
+			// IS values may carry padding
+			DicomDataSet padded = CreateMultiFrameImage(" 3 ", 3);
+			DicomImage image(padded);
+			Assert::AreEqual(3u, image.GetNumberOfFrames());
+		}
+
+		TEST_METHOD(DicomImage_GetFramePixelData_StepsByFrameLength)
+		{
+			DicomDataSet dataSet = CreateMultiFrameImage("3", 3);
+			DicomImage image(dataSet);
+
+			const uint8_t* first = image.GetFramePixelData(0);
+			Assert::IsTrue(first == image.GetRawPixelData());
+			for (uint32_t frame = 0; frame < 3; ++frame)
+			{
+				const uint8_t* data = image.GetFramePixelData(frame);
+				Assert::IsTrue(data == first + frame * image.GetFrameLength());
+
+				// The first sample of each frame is its index in the PixelData
+				uint16_t sample = static_cast<uint16_t>(data[0] | (data[1] << 8));
+				Assert::AreEqual(static_cast<uint16_t>(frame * kRows * kColumns), sample);
+			}
+			Assert::IsNull(image.GetFramePixelData(3));
+		}
+
+		TEST_METHOD(DicomImage_BigEndian_SwapsSignedSamplesAndAttributes)
+		{
+			std::vector<uint8_t> pixels;
+			for (size_t i = 0; i < static_cast<size_t>(kRows) * kColumns; ++i)
+			{
+				uint16_t value = static_cast<uint16_t>((i * 345 - 2000) & 0x0FFF);
+				pixels.push_back(static_cast<uint8_t>(value));
+				pixels.push_back(static_cast<uint8_t>(value >> 8));
+			}
+			DicomDataSet littleEndian = CreateImage(16, 1, "MONOCHROME2", DicomTag::PixelData, VR::OW, pixels);
+			littleEndian.SetUInt16(DicomTag::PixelPaddingValue, static_cast<uint16_t>(-2000));
+			DicomDataSet bigEndian = ToBigEndian(littleEndian);
+
+			DicomImage image(bigEndian);
+			Assert::IsTrue(image.IsBigEndian());
+			Assert::IsTrue(image.IsValid());
+			Assert::AreEqual(kRows, image.GetHeight());
+			Assert::AreEqual(kColumns, image.GetWidth());
+			Assert::AreEqual(static_cast<uint16_t>(11), image.GetHighBit());
+
+			// Samples come back in native order, byte for byte
+			Assert::AreEqual(pixels.size(), image.GetPixelDataSize());
+			Assert::IsTrue(std::memcmp(pixels.data(), image.GetRawPixelData(), pixels.size()) == 0);
+
+			int32_t padding = 0;
+			Assert::IsTrue(image.GetPixelPaddingValue(padding));
+			Assert::AreEqual(-2000, padding);
+
+			DicomImage reference(littleEndian);
+			std::vector<float> expected;
+			std::vector<float> output;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(reference, expected));
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output));
+			Assert::IsTrue(output == expected);
+		}
+
+		TEST_METHOD(DicomImage_BigEndian_SwapsFloatPixelData)
+		{
+			std::vector<uint8_t> pixels(static_cast<size_t>(kRows) * kColumns * 4);
+			for (size_t i = 0; i < pixels.size() / 4; ++i)
+			{
+				float value = static_cast<float>(i) * 0.75f - 3.5f;
+				std::memcpy(&pixels[i * 4], &value, sizeof(value));
+			}
+			DicomDataSet littleEndian = CreateImage(32, 0, "MONOCHROME2", DicomTag::FloatPixelData, VR::OF, pixels);
+			DicomDataSet bigEndian = ToBigEndian(littleEndian);
+
+			DicomImage image(bigEndian);
+			Assert::IsTrue(image.IsBigEndian());
+			Assert::IsTrue(image.GetSampleFormat() == DicomImage::SampleFormat::Float32);
+			Assert::IsTrue(std::memcmp(pixels.data(), image.GetRawPixelData(), pixels.size()) == 0);
+		}
+
+		TEST_METHOD(DicomImage_BigEndian_SwapsPaletteDescriptorsAndLuts)
+		{
+			std::vector<uint8_t> indices(static_cast<size_t>(kRows) * kColumns);
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				indices[i] = static_cast<uint8_t>(4 + i % 16);
+			}
+			DicomDataSet littleEndian = CreateImage(8, 0, "PALETTE COLOR", DicomTag::PixelData, VR::OB, indices);
+
+			// Red: 16-bit entries from 4; green: 8-bit entries packed two to a word;
+			// blue: a segmented ramp
+			std::vector<uint16_t> red(16);
+			std::vector<uint16_t> green(8);
+			for (uint16_t i = 0; i < 16; ++i)
+			{
+				red[i] = static_cast<uint16_t>(i * 4000 + 7);
+			}
+			for (uint16_t i = 0; i < 8; ++i)
+			{
+				green[i] = static_cast<uint16_t>(((i * 2 + 1) * 16) << 8 | (i * 2) * 16);
+			}
+			AddWords(littleEndian, DicomTag::RedPaletteColorLookupTableDescriptor, VR::US, { 16, 4, 16 });
+			AddWords(littleEndian, DicomTag::GreenPaletteColorLookupTableDescriptor, VR::US, { 16, 4, 8 });
+			AddWords(littleEndian, DicomTag::BluePaletteColorLookupTableDescriptor, VR::US, { 16, 4, 16 });
+			AddWords(littleEndian, DicomTag::RedPaletteColorLookupTableData, VR::OW, red);
+			AddWords(littleEndian, DicomTag::GreenPaletteColorLookupTableData, VR::OW, green);
+			AddWords(littleEndian, DicomTag::SegmentedBluePaletteColorLookupTableData, VR::OW, { 0, 1, 0, 1, 15, 60000 });
+			DicomDataSet bigEndian = ToBigEndian(littleEndian);
+
+			DicomImage reference(littleEndian);
+			DicomImage image(bigEndian);
+			Assert::IsTrue(image.IsBigEndian());
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				std::vector<uint16_t> expected;
+				std::vector<uint16_t> entries;
+				int32_t firstMapped = 0;
+				uint16_t bitsPerEntry = 0;
+				Assert::IsTrue(reference.GetPaletteColorLut(channel, expected, firstMapped, bitsPerEntry));
+				Assert::IsTrue(image.GetPaletteColorLut(channel, entries, firstMapped, bitsPerEntry));
+				Assert::AreEqual(static_cast<size_t>(16), entries.size());
+				Assert::AreEqual(4, firstMapped);
+				Assert::AreEqual(static_cast<uint16_t>(channel == 1 ? 8 : 16), bitsPerEntry);
+				Assert::IsTrue(entries == expected);
+			}
+
+			std::vector<uint16_t> entries;
+			int32_t firstMapped = 0;
+			uint16_t bitsPerEntry = 0;
+			Assert::IsTrue(image.GetPaletteColorLut(0, entries, firstMapped, bitsPerEntry));
+			Assert::IsTrue(entries == red);
+			Assert::IsTrue(image.GetPaletteColorLut(1, entries, firstMapped, bitsPerEntry));
+			Assert::AreEqual(static_cast<uint16_t>(16 * 15), entries[15]);
+			Assert::IsTrue(image.GetPaletteColorLut(2, entries, firstMapped, bitsPerEntry));
+			Assert::AreEqual(static_cast<uint16_t>(60000), entries[15]);
+		}
+
+		TEST_METHOD(DicomImage_LoadFromDataSet_ResetsLayoutOfPreviousImage)
+		{
+			std::vector<uint8_t> pixels(static_cast<size_t>(kRows) * kColumns * 3);
+			for (size_t i = 0; i < pixels.size(); ++i)
+			{
+				pixels[i] = static_cast<uint8_t>(i * 7);
+			}
+			DicomDataSet planar = CreateImage(8, 0, "RGB", DicomTag::PixelData, VR::OB, pixels);
+			planar.SetUInt16(DicomTag::SamplesPerPixel, 3);
+			planar.SetUInt16(DicomTag::PlanarConfiguration, 1);
+
+			// Interleaved RGB that leaves out the optional PlanarConfiguration
+			DicomDataSet interleaved = CreateImage(8, 0, "RGB", DicomTag::PixelData, VR::OB, pixels);
+			interleaved.SetUInt16(DicomTag::SamplesPerPixel, 3);
+
+			DicomImage image(planar);
+			Assert::AreEqual(static_cast<uint16_t>(1), image.GetPlanarConfiguration());
+
+			Assert::IsTrue(image.LoadFromDataSet(interleaved));
+			Assert::AreEqual(static_cast<uint16_t>(0), image.GetPlanarConfiguration());
+			Assert::AreEqual(static_cast<uint16_t>(3), image.GetSamplesPerPixel());
+
+			DicomImage fresh(interleaved);
+			ColorPipeline pipeline;
+			ColorPipeline freshPipeline;
+			std::vector<uint8_t> rgba;
+			std::vector<uint8_t> freshRgba;
+			Assert::IsTrue(pipeline.Build(image) && pipeline.Apply(image, rgba));
+			Assert::IsTrue(freshPipeline.Build(fresh) && freshPipeline.Apply(fresh, freshRgba));
+			Assert::IsTrue(rgba == freshRgba);
+
+			// Grayscale without SamplesPerPixel or PhotometricInterpretation
+			DicomDataSet grayscale = CreateImage(8, 0, "", DicomTag::PixelData, VR::OB, pixels);
+			grayscale.RemoveElement(DicomTag::SamplesPerPixel);
+			grayscale.RemoveElement(DicomTag::PhotometricInterpretation);
+			image.LoadFromDataSet(grayscale);
+			Assert::AreEqual(static_cast<uint16_t>(1), image.GetSamplesPerPixel());
+			Assert::IsTrue(image.GetPhotometricInterpretation().empty());
+			Assert::AreEqual(static_cast<size_t>(kRows) * kColumns, image.GetFrameLength());
+		}
+
+		TEST_METHOD(DicomImage_LoadFromDataSet_ResetsRescaleAndWindowOfPreviousImage)
+		{
+			DicomDataSet rescaled = CreateMultiFrameImage("1", 1);
+			rescaled.SetUInt16(DicomTag::BitsStored, 12);
+			rescaled.SetUInt16(DicomTag::HighBit, 11);
+			rescaled.SetString(DicomTag::RescaleSlope, VR::DS, "2");
+			rescaled.SetString(DicomTag::RescaleIntercept, VR::DS, "-5");
+			rescaled.SetString(DicomTag::WindowCenter, VR::DS, "40");
+			rescaled.SetString(DicomTag::WindowWidth, VR::DS, "400");
+
+			// Same samples without BitsStored, HighBit, rescale or window
+			DicomDataSet plain = CreateMultiFrameImage("1", 1);
+			plain.RemoveElement(DicomTag::BitsStored);
+			plain.RemoveElement(DicomTag::HighBit);
+
+			DicomImage image(rescaled);
+			std::vector<float> output;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output));
+			Assert::AreEqual(15.0f, output[10]);
+
+			Assert::IsTrue(image.LoadFromDataSet(plain));
+			double value = 0.0;
+			Assert::IsFalse(image.GetRescaleSlope(value));
+			Assert::AreEqual(1.0, value);
+			Assert::IsFalse(image.GetRescaleIntercept(value));
+			Assert::AreEqual(0.0, value);
+			Assert::IsFalse(image.GetWindowCenter(value));
+			Assert::IsFalse(image.GetWindowWidth(value));
+
+			DicomImage fresh(plain);
+			std::vector<float> freshOutput;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output));
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(fresh, freshOutput));
+			Assert::AreEqual(10.0f, output[10]);
+			Assert::AreEqual(20.0f, output[20]);
+			Assert::IsTrue(output == freshOutput);
+		}
+
+		TEST_METHOD(DicomImage_WindowAndRescale_MalformedValueLeavesAttributeUnset)
+		{
+			const char* values[] = { "", "   ", "abc", "2x", "1e999" };
+			for (const char* value : values)
+			{
+				DicomDataSet dataSet = CreateMultiFrameImage("1", 1);
+				dataSet.SetString(DicomTag::WindowCenter, VR::DS, value);
+				dataSet.SetString(DicomTag::WindowWidth, VR::DS, value);
+				dataSet.SetString(DicomTag::RescaleSlope, VR::DS, value);
+				dataSet.SetString(DicomTag::RescaleIntercept, VR::DS, value);
+				DicomImage image(dataSet);
+
+				double parsed = 0.0;
+				Assert::IsFalse(image.GetWindowCenter(parsed));
+				Assert::IsFalse(image.GetWindowWidth(parsed));
+				Assert::IsFalse(image.GetRescaleSlope(parsed));
+				Assert::AreEqual(1.0, parsed);
+				Assert::IsFalse(image.GetRescaleIntercept(parsed));
+				Assert::AreEqual(0.0, parsed);
+
+				std::vector<float> output;
+				Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output));
+				Assert::AreEqual(1.0f, output[1]);
+			}
+
+			// Padded and multi-valued DS use the first value
+			DicomDataSet dataSet = CreateMultiFrameImage("1", 1);
+			dataSet.SetString(DicomTag::WindowCenter, VR::DS, " 40 \\60");
+			dataSet.SetString(DicomTag::RescaleSlope, VR::DS, "2 ");
+			DicomImage image(dataSet);
+			double parsed = 0.0;
+			Assert::IsTrue(image.GetWindowCenter(parsed));
+			Assert::AreEqual(40.0, parsed);
+			Assert::IsTrue(image.GetRescaleSlope(parsed));
+			Assert::AreEqual(2.0, parsed);
+		}
+
+		TEST_METHOD(DicomImage_GetDoseGridScaling_MalformedValueLeavesValuesUnscaled)
+		{
+			const char* values[] = { "   ", "abc", "0.5x", "1e999", "nan" };
+			for (const char* value : values)
+			{
+				DicomDataSet dataSet = CreateMultiFrameImage("1", 1);
+				dataSet.SetString(DicomTag::DoseGridScaling, VR::DS, value);
+				DicomImage image(dataSet);
+
+				double scaling = 0.0;
+				Assert::IsFalse(image.GetDoseGridScaling(scaling));
+				Assert::AreEqual(1.0, scaling);
+
+				std::vector<float> output;
+				Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output));
+				Assert::AreEqual(1.0f, output[1]);
+			}
+
+			DicomDataSet dataSet = CreateMultiFrameImage("1", 1);
+			dataSet.SetString(DicomTag::DoseGridScaling, VR::DS, "2.5 ");
+			DicomImage image(dataSet);
+			double scaling = 0.0;
+			Assert::IsTrue(image.GetDoseGridScaling(scaling));
+			Assert::AreEqual(2.5, scaling);
+
+			std::vector<float> output;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output));
+			Assert::AreEqual(2.5f, output[1]);
+		}
+	};
+}
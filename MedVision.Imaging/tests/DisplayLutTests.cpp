@@ -0,0 +1,168 @@
+// Unit tests for DisplayLut class
+// Tests that the fused table matches PixelDataProcessor followed by WindowLevel::Apply
+
+#include "CppUnitTest.h"
+#include "medvision/imaging/DisplayLut.h"
+#include "medvision/imaging/PixelDataProcessor.h"
+#include "medvision/imaging/WindowLevel.h"
+#include "medvision/dicom/DicomDataSet.h"
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+using namespace medvision::imaging;
+
+namespace MedVisionImagingTests
+{
+	namespace
+	{
+		// Single frame grayscale image with every stored value of a 12-bit ramp
+		DicomDataSet CreateImage(uint16_t bitsAllocated, uint16_t bitsStored, uint16_t pixelRepresentation,
+			const std::string& photometric)
+		{
+			const uint16_t columns = 64;
+			const uint16_t rows = 80;
+			DicomDataSet dataSet;
+			dataSet.SetUInt16(DicomTag::Rows, rows);
+			dataSet.SetUInt16(DicomTag::Columns, columns);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, bitsAllocated);
+			dataSet.SetUInt16(DicomTag::BitsStored, bitsStored);
+			dataSet.SetUInt16(DicomTag::HighBit, static_cast<uint16_t>(bitsStored - 1));
+			dataSet.SetUInt16(DicomTag::PixelRepresentation, pixelRepresentation);
+			dataSet.SetString(DicomTag::PhotometricInterpretation, VR::CS, photometric);
+			dataSet.SetString(DicomTag::RescaleSlope, VR::DS, "2");
+			dataSet.SetString(DicomTag::RescaleIntercept, VR::DS, "-1024");
+
+			size_t bytes = bitsAllocated / 8;
+			std::vector<uint8_t> pixels(static_cast<size_t>(rows) * columns * bytes);
+			for (size_t i = 0; i < pixels.size() / bytes; ++i)
+			{
+				uint16_t value = static_cast<uint16_t>(i * 37);
+				pixels[i * bytes] = static_cast<uint8_t>(value);
+				if (bytes == 2)
+				{
+					pixels[i * bytes + 1] = static_cast<uint8_t>(value >> 8);
+				}
+			}
+			DicomElement pixelData(DicomTag::PixelData, bytes == 2 ? VR::OW : VR::OB);
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+			return dataSet;
+		}
+
+		std::vector<uint8_t> Reference(const DicomImage& image, const WindowLevel& window, bool invert)
+		{
+			std::vector<float> values;
+			std::vector<uint8_t> display;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, values));
+			window.Apply(values, display);
+			if (invert)
+			{
+				for (uint8_t& value : display)
+				{
+					value = static_cast<uint8_t>(255 - value);
+				}
+			}
+			return display;
+		}
+	}
+
+	TEST_CLASS(DisplayLutTests)
+	{
+	public:
+		TEST_METHOD(DisplayLut_Apply_MatchesRescaleAndWindow16Bit)
+		{
+			// Signed 12 bit samples exercise the unpacking and sign extension too
+			DicomDataSet dataSet = CreateImage(16, 12, 1, "MONOCHROME2");
+			DicomImage image(dataSet);
+			WindowLevel window(40, 400);
+
+			DisplayLut lut;
+			Assert::IsTrue(lut.Build(image, window));
+			Assert::AreEqual(static_cast<size_t>(65536), lut.GetTable().size());
+
+			std::vector<uint8_t> display;
+			Assert::IsTrue(lut.Apply(image, display));
+			Assert::IsTrue(display == Reference(image, window, false));
+		}
+
+		TEST_METHOD(DisplayLut_Apply_MatchesRescaleAndWindow8Bit)
+		{
+			DicomDataSet dataSet = CreateImage(8, 8, 0, "MONOCHROME2");
+			DicomImage image(dataSet);
+			WindowLevel window(-900, 300);
+
+			DisplayLut lut;
+			Assert::IsTrue(lut.Build(image, window));
+			Assert::AreEqual(static_cast<size_t>(256), lut.GetTable().size());
+
+			std::vector<uint8_t> display;
+			Assert::IsTrue(lut.Apply(image, display));
+			Assert::IsTrue(display == Reference(image, window, false));
+		}
+
+		TEST_METHOD(DisplayLut_Apply_InvertsMonochrome1)
+		{
+			DicomDataSet dataSet = CreateImage(16, 12, 0, "MONOCHROME1");
+			DicomImage image(dataSet);
+			WindowLevel window(2000, 3000);
+
+			DisplayLut lut;
+			Assert::IsTrue(lut.Build(image, window));
+
+			std::vector<uint8_t> display;
+			Assert::IsTrue(lut.Apply(image, display));
+			Assert::IsTrue(display == Reference(image, window, true));
+			Assert::AreEqual(static_cast<uint8_t>(255), lut.GetTable()[0], L"The minimum shows as white");
+		}
+
+		TEST_METHOD(DisplayLut_SetWindow_MatchesFreshBuild)
+		{
+			DicomDataSet dataSet = CreateImage(16, 12, 1, "MONOCHROME1");
+			DicomImage image(dataSet);
+
+			DisplayLut lut;
+			Assert::IsTrue(lut.Build(image, WindowLevel(40, 400)));
+			lut.SetWindow(WindowLevel(300, 1500));
+
+			DisplayLut fresh;
+			Assert::IsTrue(fresh.Build(image, WindowLevel(300, 1500)));
+			Assert::IsTrue(lut.GetTable() == fresh.GetTable());
+
+			std::vector<uint8_t> display;
+			Assert::IsTrue(lut.Apply(image, display));
+			Assert::IsTrue(display == Reference(image, WindowLevel(300, 1500), true));
+		}
+
+		TEST_METHOD(DisplayLut_Apply_RejectsOtherSampleSize)
+		{
+			DicomDataSet dataSet = CreateImage(16, 16, 0, "MONOCHROME2");
+			DicomImage image(dataSet);
+
+			DisplayLut lut;
+			Assert::IsTrue(lut.Build(image, WindowLevel(40, 400)));
+
+			const uint8_t bytes[4] = { 1, 2, 3, 4 };
+			uint8_t output[4] = {};
+			Assert::IsFalse(lut.Apply(bytes, 4, output));
+
+			DicomDataSet smallDataSet = CreateImage(8, 8, 0, "MONOCHROME2");
+			DicomImage smallImage(smallDataSet);
+			std::vector<uint8_t> display;
+			Assert::IsFalse(lut.Apply(smallImage, display));
+		}
+
+		TEST_METHOD(DisplayLut_Build_RejectsColorImages)
+		{
+			DicomDataSet dataSet = CreateImage(8, 8, 0, "RGB");
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 3);
+
+			DicomImage image(dataSet);
+			DisplayLut lut;
+			Assert::IsFalse(lut.Build(image, WindowLevel(40, 400)));
+			Assert::IsFalse(lut.IsValid());
+		}
+	};
+}
@@ -0,0 +1,177 @@
+// Unit tests for PixelDataProcessor class
+// Tests caller buffer checks, frame selection and the parallel multi-frame conversions
+
+#include "CppUnitTest.h"
+#include "medvision/imaging/PixelDataProcessor.h"
+#include "medvision/dicom/DicomDataSet.h"
+#include "medvision/dicom/PixelConvert.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+using namespace medvision::imaging;
+
+namespace MedVisionImagingTests
+{
+	namespace
+	{
+		// Signed 16-bit CT frames; sample i of the PixelData holds (i * 13) % 4000 - 1000
+		DicomDataSet CreateCtImage(uint16_t rows, uint16_t columns, uint32_t frames)
+		{
+			DicomDataSet dataSet;
+			dataSet.SetUInt16(DicomTag::Rows, rows);
+			dataSet.SetUInt16(DicomTag::Columns, columns);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 16);
+			dataSet.SetUInt16(DicomTag::BitsStored, 16);
+			dataSet.SetUInt16(DicomTag::HighBit, 15);
+			dataSet.SetUInt16(DicomTag::PixelRepresentation, 1);
+			dataSet.SetString(DicomTag::PhotometricInterpretation, VR::CS, "MONOCHROME2");
+			dataSet.SetString(DicomTag::NumberOfFrames, VR::IS, std::to_string(frames));
+			dataSet.SetString(DicomTag::RescaleSlope, VR::DS, "1");
+			dataSet.SetString(DicomTag::RescaleIntercept, VR::DS, "-24");
+
+			std::vector<uint8_t> pixels(static_cast<size_t>(rows) * columns * 2 * frames);
+			for (size_t i = 0; i < pixels.size() / 2; ++i)
+			{
+				int16_t value = static_cast<int16_t>(static_cast<int>((i * 13) % 4000) - 1000);
+				pixels[i * 2] = static_cast<uint8_t>(value);
+				pixels[i * 2 + 1] = static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8);
+			}
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+			return dataSet;
+		}
+
+		float Expected(size_t sample)
+		{
+			return static_cast<float>(static_cast<int>((sample * 13) % 4000) - 1000 - 24);
+		}
+
+		// A buffer one value short is rejected without being written
+		template <typename T>
+		void CheckCapacity(const DicomImage& image, T fill)
+		{
+			const size_t pixels = static_cast<size_t>(image.GetWidth()) * image.GetHeight();
+			std::vector<T> output(pixels, fill);
+			Assert::IsFalse(PixelDataProcessor::ProcessPixelData(image, output.data(), pixels - 1));
+			Assert::IsFalse(PixelDataProcessor::ProcessPixelData(image, output.data(), 0));
+			Assert::IsFalse(PixelDataProcessor::ProcessPixelData(image, static_cast<T*>(nullptr), pixels));
+			Assert::IsTrue(std::memcmp(&output.back(), &fill, sizeof(T)) == 0);
+			Assert::IsTrue(std::memcmp(&output.front(), &fill, sizeof(T)) == 0);
+
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output.data(), pixels));
+		}
+
+		// The compact overloads narrow the float result with PixelConvert::FromFloat
+		template <typename T>
+		void CheckNarrowing(const DicomImage& image, const std::vector<float>& values)
+		{
+			std::vector<T> expected(values.size());
+			std::vector<T> output(values.size());
+			PixelConvert::FromFloat(values.data(), values.size(), expected.data());
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output.data(), output.size()));
+			Assert::IsTrue(std::memcmp(expected.data(), output.data(), output.size() * sizeof(T)) == 0);
+		}
+	}
+
+	TEST_CLASS(PixelDataProcessorTests)
+	{
+	public:
+		TEST_METHOD(PixelDataProcessor_ProcessPixelData_RejectsSmallCallerBuffers)
+		{
+			DicomDataSet dataSet = CreateCtImage(16, 12, 1);
+			DicomImage image(dataSet);
+
+			CheckCapacity<float>(image, 7.0f);
+			CheckCapacity<int16_t>(image, static_cast<int16_t>(7));
+			CheckCapacity<uint16_t>(image, static_cast<uint16_t>(7));
+			CheckCapacity<Half>(image, Half{ 0x4700 });
+		}
+
+		TEST_METHOD(PixelDataProcessor_ProcessPixelData_CompactTypesMatchFloat)
+		{
+			// Larger than one tile, so the chunked narrowing runs across tiles
+			DicomDataSet dataSet = CreateCtImage(200, 190, 1);
+			DicomImage image(dataSet);
+
+			std::vector<float> values;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, values));
+			std::vector<float> output(values.size());
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, output.data(), output.size()));
+			Assert::IsTrue(output == values);
+
+			CheckNarrowing<int16_t>(image, values);
+			CheckNarrowing<uint16_t>(image, values);
+			CheckNarrowing<Half>(image, values);
+		}
+
+		TEST_METHOD(PixelDataProcessor_ProcessFrame_ConvertsSelectedFrame)
+		{
+			DicomDataSet dataSet = CreateCtImage(16, 12, 3);
+			DicomImage image(dataSet);
+			const size_t pixels = 16 * 12;
+
+			std::vector<float> output(pixels);
+			for (uint32_t frame = 0; frame < 3; ++frame)
+			{
+				Assert::IsTrue(PixelDataProcessor::ProcessFrame(image, frame, output.data()));
+				for (size_t i = 0; i < pixels; ++i)
+				{
+					Assert::AreEqual(Expected(frame * pixels + i), output[i]);
+				}
+			}
+		}
+
+		TEST_METHOD(PixelDataProcessor_ProcessFrame_RejectsFrameOutOfRange)
+		{
+			DicomDataSet dataSet = CreateCtImage(16, 12, 3);
+			DicomImage image(dataSet);
+
+			std::vector<float> output(16 * 12, 7.0f);
+			Assert::IsFalse(PixelDataProcessor::ProcessFrame(image, 3, output.data()));
+			Assert::IsFalse(PixelDataProcessor::ProcessFrame(image, 0xFFFFFFFFu, output.data()));
+			Assert::AreEqual(7.0f, output[0], L"Output is untouched on failure");
+		}
+
+		TEST_METHOD(PixelDataProcessor_ProcessFrames_RejectsRangeOutsideImage)
+		{
+			DicomDataSet dataSet = CreateCtImage(16, 12, 3);
+			DicomImage image(dataSet);
+
+			std::vector<float> output(16 * 12 * 4);
+			Assert::IsFalse(PixelDataProcessor::ProcessFrames(image, 0, 4, output.data()));
+			Assert::IsFalse(PixelDataProcessor::ProcessFrames(image, 2, 2, output.data()));
+			Assert::IsFalse(PixelDataProcessor::ProcessFrames(image, 4, 0, output.data()));
+			Assert::IsFalse(PixelDataProcessor::ProcessFrames(image, 1, 0xFFFFFFFFu, output.data()));
+			Assert::IsTrue(PixelDataProcessor::ProcessFrames(image, 3, 0, output.data()));
+			Assert::IsTrue(PixelDataProcessor::ProcessFrames(image, 1, 2, output.data()));
+		}
+
+		TEST_METHOD(PixelDataProcessor_ProcessFrames_MatchesFrameByFrame)
+		{
+			// Enough frames to spread across the pool, each larger than one tile
+			const uint16_t rows = 200;
+			const uint16_t columns = 180;
+			const uint32_t frames = 9;
+			DicomDataSet dataSet = CreateCtImage(rows, columns, frames);
+			DicomImage image(dataSet);
+			const size_t pixels = static_cast<size_t>(rows) * columns;
+
+			std::vector<float> parallel(pixels * (frames - 2), -1.0f);
+			Assert::IsTrue(PixelDataProcessor::ProcessFrames(image, 2, frames - 2, parallel.data()));
+
+			std::vector<float> single(pixels);
+			for (uint32_t frame = 2; frame < frames; ++frame)
+			{
+				Assert::IsTrue(PixelDataProcessor::ProcessFrame(image, frame, single.data()));
+				Assert::IsTrue(std::equal(single.begin(), single.end(), parallel.begin() + (frame - 2) * pixels));
+				Assert::AreEqual(Expected(frame * pixels + pixels - 1), single[pixels - 1]);
+			}
+		}
+	};
+}
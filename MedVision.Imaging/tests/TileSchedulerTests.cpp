@@ -0,0 +1,181 @@
+// Unit tests for TileScheduler class
+// Tests tile coverage and that tiled conversions do not depend on the tile size
+
+#include "CppUnitTest.h"
+#include "medvision/imaging/DisplayLut.h"
+#include "medvision/imaging/PixelDataProcessor.h"
+#include "medvision/imaging/TileScheduler.h"
+#include "medvision/imaging/WindowLevel.h"
+#include "medvision/dicom/DicomDataSet.h"
+#include <atomic>
+#include <limits>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace medvision::dicom;
+using namespace medvision::imaging;
+
+namespace MedVisionImagingTests
+{
+	namespace
+	{
+		// Tile sizes from one cache line up to one tile for the whole frame
+		const size_t kTileSizes[] = { 1, 64, 1000, 4096, TileScheduler::DefaultTilePixels, 1 << 24 };
+
+		// 12-bit signed frame with padding, larger than the default tile
+		DicomDataSet CreateLargeImage(uint16_t rows, uint16_t columns)
+		{
+			DicomDataSet dataSet;
+			dataSet.SetUInt16(DicomTag::Rows, rows);
+			dataSet.SetUInt16(DicomTag::Columns, columns);
+			dataSet.SetUInt16(DicomTag::SamplesPerPixel, 1);
+			dataSet.SetUInt16(DicomTag::BitsAllocated, 16);
+			dataSet.SetUInt16(DicomTag::BitsStored, 12);
+			dataSet.SetUInt16(DicomTag::HighBit, 11);
+			dataSet.SetUInt16(DicomTag::PixelRepresentation, 1);
+			dataSet.SetUInt16(DicomTag::PixelPaddingValue, static_cast<uint16_t>(-2000));
+			dataSet.SetString(DicomTag::PhotometricInterpretation, VR::CS, "MONOCHROME2");
+			dataSet.SetString(DicomTag::RescaleSlope, VR::DS, "0.5");
+			dataSet.SetString(DicomTag::RescaleIntercept, VR::DS, "-100.25");
+
+			std::vector<uint8_t> pixels(static_cast<size_t>(rows) * columns * 2);
+			for (size_t i = 0; i < pixels.size() / 2; ++i)
+			{
+				// Overlay bits above BitsStored must be dropped whatever the tile
+				uint16_t value = static_cast<uint16_t>((i * 2654435761u) >> 16);
+				pixels[i * 2] = static_cast<uint8_t>(value);
+				pixels[i * 2 + 1] = static_cast<uint8_t>(value >> 8);
+			}
+			DicomElement pixelData(DicomTag::PixelData, VR::OW);
+			pixelData.SetData(pixels);
+			dataSet.AddElement(pixelData);
+			return dataSet;
+		}
+	}
+
+	TEST_CLASS(TileSchedulerTests)
+	{
+	public:
+		TEST_METHOD_CLEANUP(Cleanup)
+		{
+			TileScheduler::SetTilePixels(0);
+		}
+
+		TEST_METHOD(TileScheduler_SetTilePixels_RoundsToCacheLines)
+		{
+			TileScheduler::SetTilePixels(1);
+			Assert::AreEqual(static_cast<size_t>(64), TileScheduler::GetTilePixels());
+			TileScheduler::SetTilePixels(1000);
+			Assert::AreEqual(static_cast<size_t>(1024), TileScheduler::GetTilePixels());
+			TileScheduler::SetTilePixels(0);
+			Assert::AreEqual(TileScheduler::DefaultTilePixels, TileScheduler::GetTilePixels());
+		}
+
+		TEST_METHOD(TileScheduler_SetTilePixels_HugeSizeRunsOneTile)
+		{
+			TileScheduler::SetTilePixels(std::numeric_limits<size_t>::max());
+			size_t tile = TileScheduler::GetTilePixels();
+			Assert::IsTrue(tile >= std::numeric_limits<size_t>::max() / 2);
+			Assert::AreEqual(static_cast<size_t>(0), tile % 64);
+
+			size_t calls = 0;
+			size_t covered = 0;
+			TileScheduler::ForEachTile(100003, [&](size_t first, size_t count) {
+				++calls;
+				covered += first + count;
+			});
+			Assert::AreEqual(static_cast<size_t>(1), calls);
+			Assert::AreEqual(static_cast<size_t>(100003), covered);
+		}
+
+		TEST_METHOD(TileScheduler_ForEachTile_CoversEveryPixelOnce)
+		{
+			const size_t total = 100003;
+			for (size_t tileSize : kTileSizes)
+			{
+				TileScheduler::SetTilePixels(tileSize);
+				std::vector<std::atomic<int>> visits(total);
+				for (std::atomic<int>& count : visits)
+				{
+					count = 0;
+				}
+
+				// Tiles run on pool threads, so misplaced tiles are only counted there
+				std::atomic<int> misplaced(0);
+				TileScheduler::ForEachTile(total, [&](size_t first, size_t count) {
+					if (count == 0 || count > TileScheduler::GetTilePixels() || first % TileScheduler::GetTilePixels() != 0)
+					{
+						++misplaced;
+					}
+					for (size_t i = first; i < first + count; ++i)
+					{
+						++visits[i];
+					}
+				});
+
+				Assert::AreEqual(0, misplaced.load());
+				for (const std::atomic<int>& count : visits)
+				{
+					Assert::AreEqual(1, count.load());
+				}
+			}
+
+			int calls = 0;
+			TileScheduler::ForEachTile(0, [&](size_t, size_t) { ++calls; });
+			Assert::AreEqual(0, calls);
+		}
+
+		TEST_METHOD(TileScheduler_ProcessPixelData_SameOutputForEveryTileSize)
+		{
+			DicomDataSet dataSet = CreateLargeImage(300, 257);
+			DicomImage image(dataSet);
+
+			TileScheduler::SetTilePixels(1 << 24);
+			std::vector<float> reference;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, reference));
+
+			for (size_t tileSize : kTileSizes)
+			{
+				TileScheduler::SetTilePixels(tileSize);
+				std::vector<float> tiled;
+				Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, tiled));
+				Assert::IsTrue(tiled == reference);
+
+				std::vector<int16_t> compact(tiled.size());
+				std::vector<int16_t> compactReference(tiled.size());
+				Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, compact.data(), compact.size()));
+				TileScheduler::SetTilePixels(1 << 24);
+				Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, compactReference.data(), compactReference.size()));
+				Assert::IsTrue(compact == compactReference);
+			}
+		}
+
+		TEST_METHOD(TileScheduler_Display_SameOutputForEveryTileSize)
+		{
+			DicomDataSet dataSet = CreateLargeImage(300, 257);
+			DicomImage image(dataSet);
+			WindowLevel window(100, 700);
+
+			TileScheduler::SetTilePixels(1 << 24);
+			std::vector<float> values;
+			std::vector<uint8_t> windowReference;
+			std::vector<uint8_t> lutReference;
+			DisplayLut lut;
+			Assert::IsTrue(PixelDataProcessor::ProcessPixelData(image, values));
+			window.Apply(values, windowReference);
+			Assert::IsTrue(lut.Build(image, window));
+			Assert::IsTrue(lut.Apply(image, lutReference));
+
+			for (size_t tileSize : kTileSizes)
+			{
+				TileScheduler::SetTilePixels(tileSize);
+				std::vector<uint8_t> windowed;
+				std::vector<uint8_t> mapped;
+				window.Apply(values, windowed);
+				Assert::IsTrue(lut.Apply(image, mapped));
+				Assert::IsTrue(windowed == windowReference);
+				Assert::IsTrue(mapped == lutReference);
+			}
+		}
+	};
+}
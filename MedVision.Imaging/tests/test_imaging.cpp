@@ -3,6 +3,7 @@
 
 #include "medvision/dicom/DicomReader.h"
 #include "medvision/imaging/DicomImage.h"
+#include "medvision/imaging/DisplayLut.h"
 #include "medvision/imaging/PixelDataProcessor.h"
 #include "medvision/imaging/WindowLevel.h"
 #include <iostream>
@@ -131,6 +132,7 @@ int main(int argc, char* argv[])
 		std::cout << "  3. Process pixel data" << std::endl;
 		std::cout << "  4. Apply window/level transformations" << std::endl;
 		std::cout << "  5. Show CT presets" << std::endl;
+		std::cout << "  6. Compare with the fused display LUT" << std::endl;
 		return 0;
 	}
 
@@ -201,6 +203,15 @@ int main(int argc, char* argv[])
 
 	std::cout << "Display buffer created: " << displayBuffer.size() << " bytes (8-bit)" << std::endl;
 
+	// The same display values straight from the stored samples through one table
+	DisplayLut lut;
+	std::vector<uint8_t> lutBuffer;
+	if (lut.Build(image, wl) && lut.Apply(image, lutBuffer))
+	{
+		std::cout << "Display LUT (" << lut.GetTable().size() << " entries) "
+			<< (lutBuffer == displayBuffer ? "matches" : "differs from") << " the float pipeline" << std::endl;
+	}
+
 	// Show sample pixel values
 	std::cout << "\n=== Sample Pixels (first 10) ===" << std::endl;
 	std::cout << "Index | Float Value | Display Value (0-255)" << std::endl;